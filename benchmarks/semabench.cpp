@@ -0,0 +1,711 @@
+/*
+// Copyright (c) 2025 Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+*/
+
+// Measures producer/consumer throughput between two in-order command queues.
+// Each iteration, a producer kernel writes a buffer that a consumer kernel on
+// the other queue reads.  The queues are synchronized with cl_khr_semaphore
+// semaphores, and, for reference, with events.  The host never waits during
+// the timed loop, so the throughput reflects how well the signals and waits
+// on the two queues overlap.  The semaphores are measured twice: once with
+// each signal enqueued before its wait, and once with each wait enqueued
+// before its signal.
+//
+// Run with the device's native cl_khr_semaphore, if available, and then with
+// the Intercept Layer for OpenCL Applications' Emulate_cl_khr_semaphore to
+// compare the two implementations.
+//
+// semabench loads the OpenCL ICD loader at runtime, like clireplay, so it
+// does not need to be linked against any particular OpenCL implementation.
+
+#define CL_USE_DEPRECATED_OPENCL_1_2_APIS
+#define CL_TARGET_OPENCL_VERSION 300
+#include "CL/cl.h"
+#include "CL/cl_gl.h"
+#include "src/cli_ext.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#define OPENCL_LIBRARY_NAME "OpenCL.dll"
+#elif defined(__APPLE__)
+#include <dlfcn.h>
+#define OPENCL_LIBRARY_NAME "/System/Library/Frameworks/OpenCL.framework/OpenCL"
+#else
+#include <dlfcn.h>
+#define OPENCL_LIBRARY_NAME "libOpenCL.so.1"
+#endif
+
+static std::string  openclLibrary = OPENCL_LIBRARY_NAME;
+static cl_uint      platformIndex = 0;
+static cl_uint      deviceIndex = 0;
+static cl_uint      warmupIterations = 100;
+static cl_uint      iterations = 10000;
+
+struct SOpenCLFunctions
+{
+    decltype(&::clGetPlatformIDs)           clGetPlatformIDs;
+    decltype(&::clGetPlatformInfo)          clGetPlatformInfo;
+    decltype(&::clGetDeviceIDs)             clGetDeviceIDs;
+    decltype(&::clGetDeviceInfo)            clGetDeviceInfo;
+    decltype(&::clCreateContext)            clCreateContext;
+    decltype(&::clReleaseContext)           clReleaseContext;
+    decltype(&::clCreateCommandQueue)       clCreateCommandQueue;
+    decltype(&::clReleaseCommandQueue)      clReleaseCommandQueue;
+    decltype(&::clCreateBuffer)             clCreateBuffer;
+    decltype(&::clReleaseMemObject)         clReleaseMemObject;
+    decltype(&::clCreateProgramWithSource)  clCreateProgramWithSource;
+    decltype(&::clBuildProgram)             clBuildProgram;
+    decltype(&::clReleaseProgram)           clReleaseProgram;
+    decltype(&::clCreateKernel)             clCreateKernel;
+    decltype(&::clSetKernelArg)             clSetKernelArg;
+    decltype(&::clReleaseKernel)            clReleaseKernel;
+    decltype(&::clEnqueueNDRangeKernel)     clEnqueueNDRangeKernel;
+    decltype(&::clEnqueueReadBuffer)        clEnqueueReadBuffer;
+    decltype(&::clEnqueueFillBuffer)        clEnqueueFillBuffer;
+    decltype(&::clReleaseEvent)             clReleaseEvent;
+    decltype(&::clFlush)                    clFlush;
+    decltype(&::clFinish)                   clFinish;
+    decltype(&::clGetExtensionFunctionAddressForPlatform)   clGetExtensionFunctionAddressForPlatform;
+};
+
+static SOpenCLFunctions cl;
+
+static void* getLibraryFunction(void* library, const char* name)
+{
+#if defined(_WIN32)
+    return (void*)GetProcAddress((HMODULE)library, name);
+#else
+    return dlsym(library, name);
+#endif
+}
+
+static bool loadOpenCL()
+{
+#if defined(_WIN32)
+    void* library = (void*)LoadLibraryA(openclLibrary.c_str());
+#else
+    void* library = dlopen(openclLibrary.c_str(), RTLD_NOW | RTLD_LOCAL);
+#endif
+    if( library == NULL )
+    {
+        fprintf(stderr, "semabench Error: couldn't load OpenCL library: %s\n",
+            openclLibrary.c_str());
+        return false;
+    }
+
+    bool success = true;
+
+#define GET_FUNCTION(_name)                                                 \
+    cl._name = (decltype(cl._name))getLibraryFunction(library, #_name);     \
+    if( cl._name == NULL )                                                  \
+    {                                                                       \
+        fprintf(stderr, "semabench Error: couldn't get function %s\n",      \
+            #_name);                                                        \
+        success = false;                                                    \
+    }
+
+    GET_FUNCTION(clGetPlatformIDs);
+    GET_FUNCTION(clGetPlatformInfo);
+    GET_FUNCTION(clGetDeviceIDs);
+    GET_FUNCTION(clGetDeviceInfo);
+    GET_FUNCTION(clCreateContext);
+    GET_FUNCTION(clReleaseContext);
+    GET_FUNCTION(clCreateCommandQueue);
+    GET_FUNCTION(clReleaseCommandQueue);
+    GET_FUNCTION(clCreateBuffer);
+    GET_FUNCTION(clReleaseMemObject);
+    GET_FUNCTION(clCreateProgramWithSource);
+    GET_FUNCTION(clBuildProgram);
+    GET_FUNCTION(clReleaseProgram);
+    GET_FUNCTION(clCreateKernel);
+    GET_FUNCTION(clSetKernelArg);
+    GET_FUNCTION(clReleaseKernel);
+    GET_FUNCTION(clEnqueueNDRangeKernel);
+    GET_FUNCTION(clEnqueueReadBuffer);
+    GET_FUNCTION(clEnqueueFillBuffer);
+    GET_FUNCTION(clReleaseEvent);
+    GET_FUNCTION(clFlush);
+    GET_FUNCTION(clFinish);
+    GET_FUNCTION(clGetExtensionFunctionAddressForPlatform);
+
+#undef GET_FUNCTION
+
+    return success;
+}
+
+static std::string getPlatformString(cl_platform_id platform, cl_platform_info param)
+{
+    size_t size = 0;
+    cl.clGetPlatformInfo(platform, param, 0, NULL, &size);
+    std::string str(size, '\0');
+    cl.clGetPlatformInfo(platform, param, size, &str[0], NULL);
+    return str.c_str();
+}
+
+static std::string getDeviceString(cl_device_id device, cl_device_info param)
+{
+    size_t size = 0;
+    cl.clGetDeviceInfo(device, param, 0, NULL, &size);
+    std::string str(size, '\0');
+    cl.clGetDeviceInfo(device, param, size, &str[0], NULL);
+    return str.c_str();
+}
+
+static bool getPlatformAndDevice(cl_platform_id& platform, cl_device_id& device)
+{
+    cl_uint numPlatforms = 0;
+    cl.clGetPlatformIDs(0, NULL, &numPlatforms);
+    if( platformIndex >= numPlatforms )
+    {
+        fprintf(stderr, "semabench Error: platform index %u is out of range, %u platforms were found.\n",
+            platformIndex, numPlatforms);
+        return false;
+    }
+    std::vector<cl_platform_id> platforms(numPlatforms);
+    cl.clGetPlatformIDs(numPlatforms, platforms.data(), NULL);
+    platform = platforms[platformIndex];
+
+    cl_uint numDevices = 0;
+    cl.clGetDeviceIDs(platform, CL_DEVICE_TYPE_ALL, 0, NULL, &numDevices);
+    if( deviceIndex >= numDevices )
+    {
+        fprintf(stderr, "semabench Error: device index %u is out of range, %u devices were found.\n",
+            deviceIndex, numDevices);
+        return false;
+    }
+    std::vector<cl_device_id> devices(numDevices);
+    cl.clGetDeviceIDs(platform, CL_DEVICE_TYPE_ALL, numDevices, devices.data(), NULL);
+    device = devices[deviceIndex];
+
+    printf("Running on platform: %s\n", getPlatformString(platform, CL_PLATFORM_NAME).c_str());
+    printf("Running on device: %s\n", getDeviceString(device, CL_DEVICE_NAME).c_str());
+    return true;
+}
+
+struct SSemaphoreFunctions
+{
+    decltype(&::clCreateSemaphoreWithPropertiesKHR) clCreateSemaphoreWithPropertiesKHR;
+    decltype(&::clEnqueueWaitSemaphoresKHR)         clEnqueueWaitSemaphoresKHR;
+    decltype(&::clEnqueueSignalSemaphoresKHR)       clEnqueueSignalSemaphoresKHR;
+    decltype(&::clReleaseSemaphoreKHR)              clReleaseSemaphoreKHR;
+};
+
+static const char* sc_BenchmarkSource = R"CLC(
+kernel void produce(global uint* data, uint value)
+{
+    data[get_global_id(0)] = value;
+}
+kernel void consume(global const uint* data, global uint* sum)
+{
+    sum[get_global_id(0)] += data[get_global_id(0)];
+}
+)CLC";
+
+static const size_t cBenchmarkElements = 1024;
+
+struct SBenchmark
+{
+    cl_context          Context = NULL;
+    cl_command_queue    Producer = NULL;
+    cl_command_queue    Consumer = NULL;
+    cl_program          Program = NULL;
+    cl_kernel           Produce = NULL;
+    cl_kernel           Consume = NULL;
+    cl_mem              Data = NULL;
+    cl_mem              Sum = NULL;
+};
+
+static void releaseBenchmark(SBenchmark& b)
+{
+    if( b.Sum )         cl.clReleaseMemObject(b.Sum);
+    if( b.Data )        cl.clReleaseMemObject(b.Data);
+    if( b.Consume )     cl.clReleaseKernel(b.Consume);
+    if( b.Produce )     cl.clReleaseKernel(b.Produce);
+    if( b.Program )     cl.clReleaseProgram(b.Program);
+    if( b.Consumer )    cl.clReleaseCommandQueue(b.Consumer);
+    if( b.Producer )    cl.clReleaseCommandQueue(b.Producer);
+    if( b.Context )     cl.clReleaseContext(b.Context);
+}
+
+static bool createBenchmark(cl_device_id device, SBenchmark& b)
+{
+    cl_int errorCode = CL_SUCCESS;
+
+    b.Context = cl.clCreateContext(NULL, 1, &device, NULL, NULL, &errorCode);
+    if( b.Context )
+    {
+        b.Producer = cl.clCreateCommandQueue(b.Context, device, 0, &errorCode);
+    }
+    if( b.Producer )
+    {
+        b.Consumer = cl.clCreateCommandQueue(b.Context, device, 0, &errorCode);
+    }
+    if( b.Consumer )
+    {
+        b.Program = cl.clCreateProgramWithSource(
+            b.Context, 1, &sc_BenchmarkSource, NULL, &errorCode);
+    }
+    if( b.Program )
+    {
+        errorCode = cl.clBuildProgram(b.Program, 1, &device, NULL, NULL, NULL);
+    }
+    if( errorCode == CL_SUCCESS )
+    {
+        b.Produce = cl.clCreateKernel(b.Program, "produce", &errorCode);
+    }
+    if( b.Produce )
+    {
+        b.Consume = cl.clCreateKernel(b.Program, "consume", &errorCode);
+    }
+    if( b.Consume )
+    {
+        b.Data = cl.clCreateBuffer(b.Context, CL_MEM_READ_WRITE,
+            cBenchmarkElements * sizeof(cl_uint), NULL, &errorCode);
+    }
+    if( b.Data )
+    {
+        b.Sum = cl.clCreateBuffer(b.Context, CL_MEM_READ_WRITE,
+            cBenchmarkElements * sizeof(cl_uint), NULL, &errorCode);
+    }
+    if( b.Sum )
+    {
+        errorCode |= cl.clSetKernelArg(b.Produce, 0, sizeof(cl_mem), &b.Data);
+        errorCode |= cl.clSetKernelArg(b.Consume, 0, sizeof(cl_mem), &b.Data);
+        errorCode |= cl.clSetKernelArg(b.Consume, 1, sizeof(cl_mem), &b.Sum);
+    }
+    if( errorCode != CL_SUCCESS || b.Sum == NULL )
+    {
+        fprintf(stderr, "clireplay Error: couldn't create the benchmark (%d)\n",
+            errorCode);
+        return false;
+    }
+    return true;
+}
+
+static cl_int clearSum(SBenchmark& b)
+{
+    cl_uint zero = 0;
+    cl_int errorCode = cl.clEnqueueFillBuffer(b.Consumer, b.Sum, &zero,
+        sizeof(zero), 0, cBenchmarkElements * sizeof(cl_uint), 0, NULL, NULL);
+    if( errorCode == CL_SUCCESS )
+    {
+        errorCode = cl.clFinish(b.Consumer);
+    }
+    return errorCode;
+}
+
+static cl_int enqueueProduce(SBenchmark& b, cl_uint value,
+    cl_uint numEvents, const cl_event* eventWaitList, cl_event* event)
+{
+    cl.clSetKernelArg(b.Produce, 1, sizeof(value), &value);
+    return cl.clEnqueueNDRangeKernel(b.Producer, b.Produce, 1, NULL,
+        &cBenchmarkElements, NULL, numEvents, eventWaitList, event);
+}
+
+static cl_int enqueueConsume(SBenchmark& b,
+    cl_uint numEvents, const cl_event* eventWaitList, cl_event* event)
+{
+    return cl.clEnqueueNDRangeKernel(b.Consumer, b.Consume, 1, NULL,
+        &cBenchmarkElements, NULL, numEvents, eventWaitList, event);
+}
+
+// Checks that every consumer iteration read the value from its producer
+// iteration, that is, that the sum is 1 + 2 + ... + iterations.
+static bool checkSum(SBenchmark& b, cl_uint iterations)
+{
+    std::vector<cl_uint> sum(cBenchmarkElements);
+    cl.clEnqueueReadBuffer(b.Consumer, b.Sum, CL_TRUE, 0,
+        cBenchmarkElements * sizeof(cl_uint), sum.data(), 0, NULL, NULL);
+
+    cl_uint expected = 0;
+    for( cl_uint i = 1; i <= iterations; i++ )
+    {
+        expected += i;
+    }
+    for( size_t i = 0; i < cBenchmarkElements; i++ )
+    {
+        if( sum[i] != expected )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static cl_int runEvents(SBenchmark& b, cl_uint iterations)
+{
+    cl_int errorCode = CL_SUCCESS;
+    cl_event consumed = NULL;
+
+    for( cl_uint i = 0; i < iterations && errorCode == CL_SUCCESS; i++ )
+    {
+        cl_event produced = NULL;
+        errorCode = enqueueProduce(b, i + 1,
+            consumed ? 1 : 0, consumed ? &consumed : NULL, &produced);
+        if( consumed )
+        {
+            cl.clReleaseEvent(consumed);
+            consumed = NULL;
+        }
+        if( errorCode == CL_SUCCESS )
+        {
+            cl.clFlush(b.Producer);
+            errorCode = enqueueConsume(b, 1, &produced, &consumed);
+            cl.clFlush(b.Consumer);
+        }
+        if( produced )
+        {
+            cl.clReleaseEvent(produced);
+        }
+    }
+
+    if( consumed )
+    {
+        cl.clReleaseEvent(consumed);
+    }
+    cl.clFinish(b.Producer);
+    cl.clFinish(b.Consumer);
+    return errorCode;
+}
+
+static cl_int enqueueProducerIteration(SBenchmark& b, const SSemaphoreFunctions& sema,
+    cl_semaphore_khr produced, cl_semaphore_khr consumed, cl_uint i)
+{
+    cl_int errorCode = CL_SUCCESS;
+    if( i > 0 )
+    {
+        errorCode = sema.clEnqueueWaitSemaphoresKHR(b.Producer,
+            1, &consumed, NULL, 0, NULL, NULL);
+    }
+    if( errorCode == CL_SUCCESS )
+    {
+        errorCode = enqueueProduce(b, i + 1, 0, NULL, NULL);
+    }
+    if( errorCode == CL_SUCCESS )
+    {
+        errorCode = sema.clEnqueueSignalSemaphoresKHR(b.Producer,
+            1, &produced, NULL, 0, NULL, NULL);
+        cl.clFlush(b.Producer);
+    }
+    return errorCode;
+}
+
+static cl_int enqueueConsumerIteration(SBenchmark& b, const SSemaphoreFunctions& sema,
+    cl_semaphore_khr produced, cl_semaphore_khr consumed)
+{
+    cl_int errorCode = sema.clEnqueueWaitSemaphoresKHR(b.Consumer,
+        1, &produced, NULL, 0, NULL, NULL);
+    if( errorCode == CL_SUCCESS )
+    {
+        errorCode = enqueueConsume(b, 0, NULL, NULL);
+    }
+    if( errorCode == CL_SUCCESS )
+    {
+        errorCode = sema.clEnqueueSignalSemaphoresKHR(b.Consumer,
+            1, &consumed, NULL, 0, NULL, NULL);
+        cl.clFlush(b.Consumer);
+    }
+    return errorCode;
+}
+
+// If waitFirst is set, each iteration's consumer wait is enqueued before the
+// producer signal it waits for, so the implementation must handle waits on
+// semaphores that have not been signaled yet.
+static cl_int runSemaphores(SBenchmark& b, const SSemaphoreFunctions& sema,
+    cl_semaphore_khr produced, cl_semaphore_khr consumed, cl_uint iterations,
+    bool waitFirst)
+{
+    cl_int errorCode = CL_SUCCESS;
+
+    for( cl_uint i = 0; i < iterations && errorCode == CL_SUCCESS; i++ )
+    {
+        if( waitFirst )
+        {
+            errorCode = enqueueConsumerIteration(b, sema, produced, consumed);
+            if( errorCode == CL_SUCCESS )
+            {
+                errorCode = enqueueProducerIteration(b, sema, produced, consumed, i);
+            }
+        }
+        else
+        {
+            errorCode = enqueueProducerIteration(b, sema, produced, consumed, i);
+            if( errorCode == CL_SUCCESS )
+            {
+                errorCode = enqueueConsumerIteration(b, sema, produced, consumed);
+            }
+        }
+    }
+
+    // Consume the last signal, so the semaphore is unsignaled for the next
+    // run.
+    if( errorCode == CL_SUCCESS && iterations > 0 )
+    {
+        errorCode = sema.clEnqueueWaitSemaphoresKHR(b.Producer,
+            1, &consumed, NULL, 0, NULL, NULL);
+    }
+    cl.clFinish(b.Producer);
+    cl.clFinish(b.Consumer);
+    return errorCode;
+}
+
+static void printResult(const char* name, cl_int errorCode, bool correct,
+    cl_uint iterations, std::chrono::steady_clock::duration elapsed)
+{
+    if( errorCode != CL_SUCCESS )
+    {
+        printf("%12s: failed (%d)\n", name, errorCode);
+        return;
+    }
+
+    double seconds = std::chrono::duration<double>(elapsed).count();
+    printf("%12s: %12.1f iterations/s, %10.3f us/iteration%s\n",
+        name,
+        seconds > 0 ? iterations / seconds : 0.0,
+        iterations > 0 ? seconds * 1e6 / iterations : 0.0,
+        correct ? "" : "  INCORRECT RESULTS");
+}
+
+static int runSemaphoreBenchmark()
+{
+    if( !loadOpenCL() )
+    {
+        return 1;
+    }
+
+    cl_platform_id platform = NULL;
+    cl_device_id device = NULL;
+    if( !getPlatformAndDevice(platform, device) )
+    {
+        return 1;
+    }
+
+    size_t size = 0;
+    cl.clGetDeviceInfo(device, CL_DEVICE_EXTENSIONS, 0, NULL, &size);
+    std::string extensions(size, '\0');
+    cl.clGetDeviceInfo(device, CL_DEVICE_EXTENSIONS, size, &extensions[0], NULL);
+    printf("Device reports cl_khr_semaphore: %s\n",
+        extensions.find("cl_khr_semaphore") != std::string::npos ? "yes" : "no");
+
+    SSemaphoreFunctions sema;
+#define GET_EXTENSION_FUNCTION(_name)                                       \
+    sema._name = (decltype(sema._name))                                     \
+        cl.clGetExtensionFunctionAddressForPlatform(platform, #_name);
+
+    GET_EXTENSION_FUNCTION(clCreateSemaphoreWithPropertiesKHR);
+    GET_EXTENSION_FUNCTION(clEnqueueWaitSemaphoresKHR);
+    GET_EXTENSION_FUNCTION(clEnqueueSignalSemaphoresKHR);
+    GET_EXTENSION_FUNCTION(clReleaseSemaphoreKHR);
+
+#undef GET_EXTENSION_FUNCTION
+
+    bool hasSemaphores =
+        sema.clCreateSemaphoreWithPropertiesKHR &&
+        sema.clEnqueueWaitSemaphoresKHR &&
+        sema.clEnqueueSignalSemaphoresKHR &&
+        sema.clReleaseSemaphoreKHR;
+    if( !hasSemaphores )
+    {
+        printf("cl_khr_semaphore functions are not available: only events will be measured.\n");
+    }
+
+    SBenchmark b;
+    if( !createBenchmark(device, b) )
+    {
+        releaseBenchmark(b);
+        return 1;
+    }
+
+    printf("Producer/consumer iterations: %u (%u warmup)\n",
+        iterations, warmupIterations);
+
+    bool success = true;
+
+    // Events:
+    {
+        cl_int errorCode = clearSum(b);
+        if( errorCode == CL_SUCCESS )
+        {
+            errorCode = runEvents(b, warmupIterations);
+        }
+        if( errorCode == CL_SUCCESS )
+        {
+            errorCode = clearSum(b);
+        }
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        if( errorCode == CL_SUCCESS )
+        {
+            errorCode = runEvents(b, iterations);
+        }
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+        bool correct = errorCode == CL_SUCCESS && checkSum(b, iterations);
+        printResult("Events", errorCode, correct, iterations, end - start);
+        success &= correct;
+    }
+
+    // Semaphores:
+    if( hasSemaphores )
+    {
+        const cl_semaphore_properties_khr props[] = {
+            CL_SEMAPHORE_TYPE_KHR, CL_SEMAPHORE_TYPE_BINARY_KHR,
+            0,
+        };
+
+        cl_int errorCode = CL_SUCCESS;
+        cl_semaphore_khr produced =
+            sema.clCreateSemaphoreWithPropertiesKHR(b.Context, props, &errorCode);
+        cl_semaphore_khr consumed = NULL;
+        if( produced )
+        {
+            consumed = sema.clCreateSemaphoreWithPropertiesKHR(
+                b.Context, props, &errorCode);
+        }
+
+        // Signals enqueued before their waits, then waits enqueued before
+        // their signals:
+        for( bool waitFirst : { false, true } )
+        {
+            cl_int runErrorCode = errorCode;
+            if( runErrorCode == CL_SUCCESS )
+            {
+                runErrorCode = clearSum(b);
+            }
+            if( runErrorCode == CL_SUCCESS )
+            {
+                runErrorCode = runSemaphores(b, sema, produced, consumed,
+                    warmupIterations, waitFirst);
+            }
+            if( runErrorCode == CL_SUCCESS )
+            {
+                runErrorCode = clearSum(b);
+            }
+
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            if( runErrorCode == CL_SUCCESS )
+            {
+                runErrorCode = runSemaphores(b, sema, produced, consumed,
+                    iterations, waitFirst);
+            }
+            std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+            bool correct = runErrorCode == CL_SUCCESS && checkSum(b, iterations);
+            printResult(waitFirst ? "Wait First" : "Semaphores",
+                runErrorCode, correct, iterations, end - start);
+            success &= correct;
+        }
+
+        if( consumed )
+        {
+            sema.clReleaseSemaphoreKHR(consumed);
+        }
+        if( produced )
+        {
+            sema.clReleaseSemaphoreKHR(produced);
+        }
+    }
+
+    releaseBenchmark(b);
+    return success ? 0 : 1;
+}
+
+static bool parseUInt(int& i, int argc, char* argv[], cl_uint& value)
+{
+    if( ++i < argc )
+    {
+        value = (cl_uint)strtoul(argv[i], NULL, 0);
+        return true;
+    }
+    return false;
+}
+
+static bool parseArguments(int argc, char *argv[])
+{
+    bool printUsage = false;
+
+    for( int i = 1; i < argc; i++ )
+    {
+        if( !strcmp(argv[i], "--help") )
+        {
+            printUsage = true;
+        }
+        else if( !strcmp(argv[i], "-p") || !strcmp(argv[i], "--platform") )
+        {
+            printUsage |= !parseUInt(i, argc, argv, platformIndex);
+        }
+        else if( !strcmp(argv[i], "-d") || !strcmp(argv[i], "--device") )
+        {
+            printUsage |= !parseUInt(i, argc, argv, deviceIndex);
+        }
+        else if( !strcmp(argv[i], "-i") || !strcmp(argv[i], "--iterations") )
+        {
+            printUsage |= !parseUInt(i, argc, argv, iterations);
+        }
+        else if( !strcmp(argv[i], "-w") || !strcmp(argv[i], "--warmup") )
+        {
+            printUsage |= !parseUInt(i, argc, argv, warmupIterations);
+        }
+        else if( !strcmp(argv[i], "--opencl") )
+        {
+            if( ++i < argc )
+            {
+                openclLibrary = argv[i];
+            }
+            else
+            {
+                printUsage = true;
+            }
+        }
+        else
+        {
+            printUsage = true;
+        }
+    }
+
+    if( printUsage )
+    {
+        printf(
+            "semabench - Measure Producer/Consumer Queue Throughput with Events and\n"
+            "            cl_khr_semaphore Semaphores\n"
+            "\n"
+            "Usage: semabench [OPTIONS]\n"
+            "\n"
+            "Options:\n"
+            "  --help                           Print this Message and Exit\n"
+            "  --platform [-p] <INDEX>          Choose the Platform to Run On, default: %u\n"
+            "  --device [-d] <INDEX>            Choose the Device to Run On, default: %u\n"
+            "  --iterations [-i] <NUMBER>       Number of Timed Iterations, default: %u\n"
+            "  --warmup [-w] <NUMBER>           Number of Untimed Warmup Iterations, default: %u\n"
+            "  --opencl <LIBRARY>               OpenCL Library to Load, default: %s\n"
+            "\n",
+            platformIndex,
+            deviceIndex,
+            iterations,
+            warmupIterations,
+            OPENCL_LIBRARY_NAME );
+        return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    if( !parseArguments(argc, argv) )
+    {
+        return 1;
+    }
+
+    return runSemaphoreBenchmark();
+}
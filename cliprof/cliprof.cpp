@@ -234,6 +234,10 @@ static bool parseArguments(int argc, char *argv[])
         {
             SETENV("CLI_HostPerformanceTiming", "1");
         }
+        else if( !strcmp(argv[i], "--build-timing") )
+        {
+            SETENV("CLI_ProgramBuildTiming", "1");
+        }
         else if( !strcmp(argv[i], "-l") || !strcmp(argv[i], "--leak-checking") )
         {
             SETENV("CLI_LeakChecking", "1");
@@ -291,6 +295,7 @@ static bool parseArguments(int argc, char *argv[])
             "Options:\n"
             "  --debug                      Enable cliprof Debug Messages\n"
             "  --host-timing [-h]           Report Host API Execution Time\n"
+            "  --build-timing               Report Program Build Time and Rebuilds\n"
             "  --leak-checking [-l]         Track and Report OpenCL Leaks\n"
             "  --verbose [-v]               Verbose Output (No Log Suppression)\n"
             "\n"
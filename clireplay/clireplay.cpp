@@ -0,0 +1,1482 @@
+/*
+// Copyright (c) 2025 Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+*/
+
+// clireplay runs a single kernel that was captured by the CaptureReplay
+// controls.  It loads a Replay/Enqueue_* directory, recreates the kernel's
+// buffers, images, samplers, and arguments, executes the kernel repeatedly,
+// and reports the device execution time from profiling events.  Optionally,
+// the kernel's outputs can be validated against the captured Post buffers.
+//
+// clireplay loads the OpenCL ICD loader at runtime, so it does not need to
+// be linked against any particular OpenCL implementation.
+
+#include "clireplay.h"
+#include "git_version.h"
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <direct.h>
+#define OPENCL_LIBRARY_NAME "OpenCL.dll"
+#elif defined(__APPLE__)
+#include <dirent.h>
+#include <dlfcn.h>
+#include <sys/stat.h>
+#define OPENCL_LIBRARY_NAME "/System/Library/Frameworks/OpenCL.framework/OpenCL"
+#else
+#include <dirent.h>
+#include <dlfcn.h>
+#include <sys/stat.h>
+#define OPENCL_LIBRARY_NAME "libOpenCL.so.1"
+#endif
+
+static bool debug = false;
+
+#define DEBUG(_s, ...) if(debug) fprintf(stderr, "[clireplay debug] " _s, ##__VA_ARGS__ );
+
+static std::string  directory = ".";
+static std::string  openclLibrary = OPENCL_LIBRARY_NAME;
+static cl_uint      platformIndex = 0;
+static cl_uint      deviceIndex = 0;
+static cl_uint      warmupIterations = 1;
+static cl_uint      iterations = 10;
+static bool         validate = false;
+static bool         writeOutput = false;
+static std::string  jsonFileName;
+static std::string  streamFileName;
+static double       streamSpeed = 1.0;
+
+SOpenCLFunctions cl;
+
+static void* getLibraryFunction(void* library, const char* name)
+{
+#if defined(_WIN32)
+    return (void*)GetProcAddress((HMODULE)library, name);
+#else
+    return dlsym(library, name);
+#endif
+}
+
+bool loadOpenCL()
+{
+#if defined(_WIN32)
+    void* library = (void*)LoadLibraryA(openclLibrary.c_str());
+#else
+    void* library = dlopen(openclLibrary.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if( library == NULL && openclLibrary == OPENCL_LIBRARY_NAME )
+    {
+        // Fall back to the unversioned name, which may only be available
+        // when development packages are installed.
+        library = dlopen("libOpenCL.so", RTLD_NOW | RTLD_LOCAL);
+    }
+#endif
+    if( library == NULL )
+    {
+        fprintf(stderr, "clireplay Error: couldn't load OpenCL library: %s\n",
+            openclLibrary.c_str());
+        return false;
+    }
+    DEBUG("loaded OpenCL library %s\n", openclLibrary.c_str());
+
+    bool success = true;
+
+#define GET_FUNCTION(_name)                                                 \
+    cl._name = (decltype(cl._name))getLibraryFunction(library, #_name);     \
+    if( cl._name == NULL )                                                  \
+    {                                                                       \
+        fprintf(stderr, "clireplay Error: couldn't get function %s\n",      \
+            #_name);                                                        \
+        success = false;                                                    \
+    }
+
+    GET_FUNCTION(clGetPlatformIDs);
+    GET_FUNCTION(clGetPlatformInfo);
+    GET_FUNCTION(clGetDeviceIDs);
+    GET_FUNCTION(clGetDeviceInfo);
+    GET_FUNCTION(clCreateContext);
+    GET_FUNCTION(clReleaseContext);
+    GET_FUNCTION(clCreateCommandQueue);
+    GET_FUNCTION(clReleaseCommandQueue);
+    GET_FUNCTION(clCreateBuffer);
+    GET_FUNCTION(clCreateImage);
+    GET_FUNCTION(clReleaseMemObject);
+    GET_FUNCTION(clCreateSampler);
+    GET_FUNCTION(clReleaseSampler);
+    GET_FUNCTION(clCreateProgramWithSource);
+    GET_FUNCTION(clCreateProgramWithBinary);
+    GET_FUNCTION(clBuildProgram);
+    GET_FUNCTION(clGetProgramBuildInfo);
+    GET_FUNCTION(clReleaseProgram);
+    GET_FUNCTION(clCreateKernel);
+    GET_FUNCTION(clSetKernelArg);
+    GET_FUNCTION(clReleaseKernel);
+    GET_FUNCTION(clEnqueueNDRangeKernel);
+    GET_FUNCTION(clEnqueueReadBuffer);
+    GET_FUNCTION(clEnqueueReadImage);
+    GET_FUNCTION(clGetEventProfilingInfo);
+    GET_FUNCTION(clReleaseEvent);
+    GET_FUNCTION(clFinish);
+    GET_FUNCTION(clEnqueueWriteBuffer);
+    GET_FUNCTION(clEnqueueCopyBuffer);
+    GET_FUNCTION(clEnqueueFillBuffer);
+    GET_FUNCTION(clEnqueueMapBuffer);
+    GET_FUNCTION(clEnqueueUnmapMemObject);
+    GET_FUNCTION(clEnqueueMarkerWithWaitList);
+    GET_FUNCTION(clEnqueueBarrierWithWaitList);
+    GET_FUNCTION(clFlush);
+    GET_FUNCTION(clWaitForEvents);
+    GET_FUNCTION(clRetainContext);
+    GET_FUNCTION(clRetainCommandQueue);
+    GET_FUNCTION(clRetainMemObject);
+    GET_FUNCTION(clRetainProgram);
+    GET_FUNCTION(clRetainKernel);
+    GET_FUNCTION(clRetainEvent);
+
+#undef GET_FUNCTION
+
+    // clCreateProgramWithIL is an OpenCL 2.1 API and may not be exported by
+    // older ICD loaders.  It is only needed to replay kernels from IL.
+    cl.clCreateProgramWithIL = (decltype(cl.clCreateProgramWithIL))
+        getLibraryFunction(library, "clCreateProgramWithIL");
+
+    return success;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// File helpers.
+
+static bool readFile(const std::string& name, std::vector<char>& data)
+{
+    std::ifstream is(name, std::ios::in | std::ios::binary);
+    if( !is.good() )
+    {
+        return false;
+    }
+    is.seekg(0, std::ios::end);
+    data.resize((size_t)is.tellg());
+    is.seekg(0, std::ios::beg);
+    is.read(data.data(), data.size());
+    return is.good() || data.empty();
+}
+
+static bool readTextFile(const std::string& name, std::string& text)
+{
+    std::vector<char> data;
+    if( !readFile(name, data) )
+    {
+        return false;
+    }
+    text.assign(data.begin(), data.end());
+    return true;
+}
+
+static bool writeFile(const std::string& name, const std::vector<char>& data)
+{
+    std::ofstream os(name, std::ios::out | std::ios::binary);
+    os.write(data.data(), data.size());
+    return os.good();
+}
+
+static bool fileExists(const std::string& name)
+{
+    std::ifstream is(name);
+    return is.good();
+}
+
+static void makeDirectory(const std::string& name)
+{
+#if defined(_WIN32)
+    _mkdir(name.c_str());
+#else
+    mkdir(name.c_str(), 0777);
+#endif
+}
+
+static void listDirectory(const std::string& name, std::vector<std::string>& files)
+{
+    files.clear();
+#if defined(_WIN32)
+    WIN32_FIND_DATAA findData;
+    HANDLE find = FindFirstFileA((name + "\\*").c_str(), &findData);
+    if( find != INVALID_HANDLE_VALUE )
+    {
+        do
+        {
+            files.push_back(findData.cFileName);
+        }
+        while( FindNextFileA(find, &findData) );
+        FindClose(find);
+    }
+#else
+    DIR* dir = opendir(name.c_str());
+    if( dir )
+    {
+        while( struct dirent* entry = readdir(dir) )
+        {
+            files.push_back(entry->d_name);
+        }
+        closedir(dir);
+    }
+#endif
+    std::sort(files.begin(), files.end());
+}
+
+// Checks whether a file name is of the form <prefix><number><suffix>, and if
+// so returns the number.
+static bool matchIndexedFile(
+    const std::string& fileName,
+    const std::string& prefix,
+    const std::string& suffix,
+    cl_uint& index )
+{
+    if( fileName.size() <= prefix.size() + suffix.size() ||
+        fileName.compare(0, prefix.size(), prefix) != 0 ||
+        fileName.compare(fileName.size() - suffix.size(), suffix.size(), suffix) != 0 )
+    {
+        return false;
+    }
+    std::string number = fileName.substr(
+        prefix.size(),
+        fileName.size() - prefix.size() - suffix.size());
+    if( number.find_first_not_of("0123456789") != std::string::npos )
+    {
+        return false;
+    }
+    index = (cl_uint)strtoul(number.c_str(), NULL, 10);
+    return true;
+}
+
+// Gets the argument index from a dumped buffer or image file name, which
+// contains "_Arg_<index>_".
+static bool getDumpFileArgIndex(const std::string& fileName, cl_uint& index)
+{
+    size_t pos = fileName.find("_Arg_");
+    if( pos == std::string::npos )
+    {
+        return false;
+    }
+    char* end = NULL;
+    const char* start = fileName.c_str() + pos + strlen("_Arg_");
+    index = (cl_uint)strtoul(start, &end, 10);
+    return end != start;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// The captured kernel.
+
+enum EArgKind
+{
+    ARG_VALUE,
+    ARG_LOCAL,
+    ARG_BUFFER,
+    ARG_IMAGE,
+    ARG_SAMPLER,
+};
+
+struct SArgument
+{
+    SArgument() :
+        Kind(ARG_VALUE),
+        HasData(false),
+        LocalSize(0),
+        MemObj(NULL),
+        Sampler(NULL)
+    {
+        memset(&ImageFormat, 0, sizeof(ImageFormat));
+        memset(&ImageDesc, 0, sizeof(ImageDesc));
+        memset(ImageRegion, 0, sizeof(ImageRegion));
+    }
+
+    EArgKind    Kind;
+
+    bool        HasData;
+    std::vector<char>   Data;
+
+    size_t      LocalSize;
+
+    std::string PreFileName;
+    std::string PostFileName;
+    std::vector<char>   PreData;
+
+    cl_image_format ImageFormat;
+    cl_image_desc   ImageDesc;
+    size_t          ImageRegion[3];
+
+    std::string SamplerString;
+
+    std::string TypeName;
+
+    cl_mem      MemObj;
+    cl_sampler  Sampler;
+};
+
+struct SCapture
+{
+    std::string EnqueueNumber;
+    std::string KernelName;
+    std::string BuildOptions;
+
+    cl_uint     WorkDim;
+    size_t      GWS[3];
+    size_t      LWS[3];
+    size_t      GWO[3];
+    bool        NullLWS;
+
+    std::vector<SArgument>  Args;
+};
+
+static bool parseWorkSizes(const std::string& line, cl_uint& workDim, size_t* sizes)
+{
+    std::istringstream is(line);
+    workDim = 0;
+    size_t value = 0;
+    while( is >> value )
+    {
+        if( workDim >= 3 )
+        {
+            return false;
+        }
+        sizes[workDim++] = value;
+    }
+    return workDim > 0;
+}
+
+static bool parseImageMetaData(const std::string& fileName, SArgument& arg)
+{
+    std::ifstream is(fileName);
+    size_t region[3] = { 0, 0, 0 };
+    size_t elementSize = 0;
+    size_t rowPitch = 0;
+    size_t slicePitch = 0;
+    cl_uint channelDataType = 0;
+    cl_uint channelOrder = 0;
+    cl_uint imageType = 0;
+    if( !( is >> region[0] >> region[1] >> region[2]
+              >> elementSize >> rowPitch >> slicePitch
+              >> channelDataType >> channelOrder >> imageType ) )
+    {
+        return false;
+    }
+
+    arg.ImageFormat.image_channel_data_type = channelDataType;
+    arg.ImageFormat.image_channel_order = channelOrder;
+
+    // The image data is dumped tightly packed, so the pitches are not used
+    // to create the image.
+    arg.ImageDesc.image_type = imageType;
+    arg.ImageDesc.image_width = region[0];
+    switch( imageType )
+    {
+    case CL_MEM_OBJECT_IMAGE1D:
+        break;
+    case CL_MEM_OBJECT_IMAGE1D_ARRAY:
+        arg.ImageDesc.image_array_size = region[1];
+        break;
+    case CL_MEM_OBJECT_IMAGE2D:
+        arg.ImageDesc.image_height = region[1];
+        break;
+    case CL_MEM_OBJECT_IMAGE2D_ARRAY:
+        arg.ImageDesc.image_height = region[1];
+        arg.ImageDesc.image_array_size = region[2];
+        break;
+    case CL_MEM_OBJECT_IMAGE3D:
+        arg.ImageDesc.image_height = region[1];
+        arg.ImageDesc.image_depth = region[2];
+        break;
+    default:
+        fprintf(stderr, "clireplay Error: unsupported image type %04X for replay.\n",
+            imageType);
+        return false;
+    }
+
+    arg.ImageRegion[0] = region[0];
+    arg.ImageRegion[1] = std::max<size_t>(region[1], 1);
+    arg.ImageRegion[2] = std::max<size_t>(region[2], 1);
+    return true;
+}
+
+static bool loadCapture(SCapture& capture)
+{
+    const std::string prefix = directory + "/";
+
+    if( readTextFile(prefix + "enqueueNumber.txt", capture.EnqueueNumber) )
+    {
+        capture.EnqueueNumber.erase(
+            capture.EnqueueNumber.find_last_not_of(" \r\n") + 1);
+    }
+
+    if( !readTextFile(prefix + "kernelName.txt", capture.KernelName) )
+    {
+        fprintf(stderr, "clireplay Error: couldn't read %skernelName.txt.  Is this a capture directory?\n",
+            prefix.c_str());
+        return false;
+    }
+
+    if( readTextFile(prefix + "buildOptions.txt", capture.BuildOptions) )
+    {
+        capture.BuildOptions.erase(
+            capture.BuildOptions.find_last_not_of(" \r\n") + 1);
+    }
+
+    {
+        std::ifstream is(prefix + "worksizes.txt");
+        std::string gwsLine, lwsLine, gwoLine;
+        std::getline(is, gwsLine);
+        std::getline(is, lwsLine);
+        std::getline(is, gwoLine);
+
+        cl_uint gwsDim = 0, lwsDim = 0, gwoDim = 0;
+        if( !parseWorkSizes(gwsLine, gwsDim, capture.GWS) ||
+            !parseWorkSizes(lwsLine, lwsDim, capture.LWS) ||
+            !parseWorkSizes(gwoLine, gwoDim, capture.GWO) ||
+            gwsDim != lwsDim || gwsDim != gwoDim )
+        {
+            fprintf(stderr, "clireplay Error: couldn't parse %sworksizes.txt.\n",
+                prefix.c_str());
+            return false;
+        }
+        capture.WorkDim = gwsDim;
+
+        // A local work size of all zeros means the application passed NULL.
+        capture.NullLWS = true;
+        for( cl_uint i = 0; i < capture.WorkDim; i++ )
+        {
+            if( capture.LWS[i] != 0 )
+            {
+                capture.NullLWS = false;
+            }
+        }
+    }
+
+    // Gather the per-argument files.  The number of arguments is the highest
+    // argument index found in any of the files.
+
+    std::vector<std::string> files;
+    listDirectory(directory, files);
+
+    std::string paddedEnqueueNumber = capture.EnqueueNumber;
+    if( paddedEnqueueNumber.size() < 4 )
+    {
+        paddedEnqueueNumber.insert(0, 4 - paddedEnqueueNumber.size(), '0');
+    }
+    const std::string dumpPrefix = "Enqueue_" + paddedEnqueueNumber + "_";
+
+    std::map<cl_uint, SArgument>    args;
+    for( const std::string& fileName : files )
+    {
+        cl_uint index = 0;
+        if( matchIndexedFile(fileName, "Argument", ".bin", index) )
+        {
+            SArgument& arg = args[index];
+            arg.HasData = readFile(prefix + fileName, arg.Data);
+        }
+        else if( matchIndexedFile(fileName, "Local", ".txt", index) )
+        {
+            SArgument& arg = args[index];
+            std::string size;
+            readTextFile(prefix + fileName, size);
+            arg.Kind = ARG_LOCAL;
+            arg.LocalSize = (size_t)strtoull(size.c_str(), NULL, 10);
+        }
+        else if( matchIndexedFile(fileName, "Sampler", ".txt", index) )
+        {
+            SArgument& arg = args[index];
+            arg.Kind = ARG_SAMPLER;
+            readTextFile(prefix + fileName, arg.SamplerString);
+        }
+    }
+
+    for( const char* subdir : { "Pre", "Post" } )
+    {
+        // Dump files are either stored in the subdirectory, or, when buffers
+        // were deduplicated, listed in a manifest that names the blob in the
+        // shared blob store holding their contents.
+        std::vector<std::string> dumpFiles;
+        std::vector<std::string> dumpPaths;
+        listDirectory(prefix + subdir, dumpFiles);
+        for( const std::string& fileName : dumpFiles )
+        {
+            dumpPaths.push_back(prefix + subdir + "/" + fileName);
+        }
+        {
+            std::ifstream is(prefix + subdir + "/Blobs.txt");
+            std::string fileName, blobName;
+            while( is >> fileName >> blobName )
+            {
+                dumpFiles.push_back(fileName);
+                dumpPaths.push_back(prefix + "../Blobs/" + blobName);
+            }
+        }
+        for( size_t f = 0; f < dumpFiles.size(); f++ )
+        {
+            const std::string& fileName = dumpFiles[f];
+            cl_uint index = 0;
+            if( ( capture.EnqueueNumber.empty() ||
+                  fileName.compare(0, dumpPrefix.size(), dumpPrefix) == 0 ) &&
+                getDumpFileArgIndex(fileName, index) )
+            {
+                const bool isImage =
+                    fileName.size() > 4 &&
+                    fileName.compare(fileName.size() - 4, 4, ".raw") == 0;
+                SArgument& arg = args[index];
+                arg.Kind = isImage ? ARG_IMAGE : ARG_BUFFER;
+                if( !strcmp(subdir, "Pre") )
+                {
+                    arg.PreFileName = dumpPaths[f];
+                }
+                else
+                {
+                    arg.PostFileName = dumpPaths[f];
+                }
+            }
+        }
+    }
+
+    if( !args.empty() )
+    {
+        capture.Args.resize(args.rbegin()->first + 1);
+        for( auto& it : args )
+        {
+            capture.Args[it.first] = it.second;
+        }
+    }
+
+    {
+        std::ifstream is(prefix + "ArgumentDataTypes.txt");
+        std::string typeName;
+        for( size_t i = 0; std::getline(is, typeName); i++ )
+        {
+            if( i >= capture.Args.size() )
+            {
+                capture.Args.resize(i + 1);
+            }
+            capture.Args[i].TypeName = typeName;
+        }
+    }
+
+    for( size_t i = 0; i < capture.Args.size(); i++ )
+    {
+        SArgument& arg = capture.Args[i];
+        switch( arg.Kind )
+        {
+        case ARG_VALUE:
+            if( !arg.HasData )
+            {
+                fprintf(stderr, "clireplay Error: no data was captured for argument %zu.\n", i);
+                return false;
+            }
+            break;
+        case ARG_BUFFER:
+        case ARG_IMAGE:
+            if( arg.PreFileName.empty() || !readFile(arg.PreFileName, arg.PreData) )
+            {
+                fprintf(stderr, "clireplay Error: couldn't read the initial contents for argument %zu.\n", i);
+                return false;
+            }
+            if( arg.Kind == ARG_IMAGE &&
+                !parseImageMetaData(prefix + "Image_MetaData_" + std::to_string(i) + ".txt", arg) )
+            {
+                fprintf(stderr, "clireplay Error: couldn't read the image metadata for argument %zu.\n", i);
+                return false;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Replay.
+
+static bool createSampler(cl_context context, SArgument& arg)
+{
+    // The sampler string is written by the intercept layer as a list of
+    // property names and values, for example:
+    //  CL_SAMPLER_NORMALIZED_COORDS = CL_TRUE, CL_SAMPLER_ADDRESSING_MODE = ...
+    const std::string& s = arg.SamplerString;
+
+    cl_bool normalized =
+        s.find("CL_SAMPLER_NORMALIZED_COORDS = CL_TRUE") != std::string::npos ?
+        CL_TRUE : CL_FALSE;
+
+    cl_addressing_mode addressingMode =
+        s.find("CL_ADDRESS_CLAMP_TO_EDGE") != std::string::npos ? CL_ADDRESS_CLAMP_TO_EDGE :
+        s.find("CL_ADDRESS_CLAMP") != std::string::npos ? CL_ADDRESS_CLAMP :
+        s.find("CL_ADDRESS_MIRRORED_REPEAT") != std::string::npos ? CL_ADDRESS_MIRRORED_REPEAT :
+        s.find("CL_ADDRESS_REPEAT") != std::string::npos ? CL_ADDRESS_REPEAT :
+        CL_ADDRESS_NONE;
+
+    cl_filter_mode filterMode =
+        s.find("CL_FILTER_LINEAR") != std::string::npos ? CL_FILTER_LINEAR :
+        CL_FILTER_NEAREST;
+
+    cl_int errorCode = CL_SUCCESS;
+    arg.Sampler = cl.clCreateSampler(
+        context,
+        normalized,
+        addressingMode,
+        filterMode,
+        &errorCode);
+    return errorCode == CL_SUCCESS;
+}
+
+static cl_program createProgram(
+    cl_context context,
+    cl_device_id device,
+    const SCapture& capture )
+{
+    const std::string prefix = directory + "/";
+    const char* options = capture.BuildOptions.c_str();
+
+    cl_program program = NULL;
+    cl_int errorCode = CL_SUCCESS;
+
+    std::vector<char> data;
+    if( readFile(prefix + "kernel.cl", data) )
+    {
+        printf("Using kernel source.\n");
+        const char* source = data.data();
+        size_t length = data.size();
+        program = cl.clCreateProgramWithSource(
+            context,
+            1,
+            &source,
+            &length,
+            &errorCode);
+    }
+    else if( cl.clCreateProgramWithIL && readFile(prefix + "kernel.spv", data) )
+    {
+        printf("Using kernel IL.\n");
+        program = cl.clCreateProgramWithIL(
+            context,
+            data.data(),
+            data.size(),
+            &errorCode);
+    }
+    else
+    {
+        // Try each of the captured device binaries until one builds and
+        // contains the kernel.
+        for( cl_uint i = 0; fileExists(prefix + "DeviceBinary" + std::to_string(i) + ".bin"); i++ )
+        {
+            const std::string fileName = prefix + "DeviceBinary" + std::to_string(i) + ".bin";
+            readFile(fileName, data);
+
+            const unsigned char* binary = (const unsigned char*)data.data();
+            size_t length = data.size();
+            program = cl.clCreateProgramWithBinary(
+                context,
+                1,
+                &device,
+                &length,
+                &binary,
+                NULL,
+                &errorCode);
+            if( errorCode == CL_SUCCESS &&
+                cl.clBuildProgram(program, 1, &device, options, NULL, NULL) == CL_SUCCESS )
+            {
+                cl_kernel kernel = cl.clCreateKernel(
+                    program,
+                    capture.KernelName.c_str(),
+                    &errorCode);
+                if( errorCode == CL_SUCCESS )
+                {
+                    printf("Using kernel device binary: %s\n", fileName.c_str());
+                    cl.clReleaseKernel(kernel);
+                    return program;
+                }
+            }
+            DEBUG("couldn't use kernel device binary %s\n", fileName.c_str());
+            if( program )
+            {
+                cl.clReleaseProgram(program);
+                program = NULL;
+            }
+        }
+        fprintf(stderr, "clireplay Error: couldn't create a program from any of the captured device binaries.\n");
+        return NULL;
+    }
+
+    if( errorCode != CL_SUCCESS )
+    {
+        fprintf(stderr, "clireplay Error: couldn't create program (%d).\n", errorCode);
+        return NULL;
+    }
+
+    printf("Using build options: %s\n", options);
+    errorCode = cl.clBuildProgram(program, 1, &device, options, NULL, NULL);
+    if( errorCode != CL_SUCCESS )
+    {
+        fprintf(stderr, "clireplay Error: couldn't build program (%d).\n", errorCode);
+
+        size_t logSize = 0;
+        cl.clGetProgramBuildInfo(program, device, CL_PROGRAM_BUILD_LOG, 0, NULL, &logSize);
+        std::string log(logSize, '\0');
+        cl.clGetProgramBuildInfo(program, device, CL_PROGRAM_BUILD_LOG, logSize, &log[0], NULL);
+        fprintf(stderr, "Build Log:\n%s\n", log.c_str());
+
+        cl.clReleaseProgram(program);
+        return NULL;
+    }
+
+    return program;
+}
+
+static bool setKernelArgs(
+    cl_context context,
+    cl_kernel kernel,
+    SCapture& capture )
+{
+    // Buffer arguments that were set to the same allocation share one buffer
+    // in the replay, to replicate any aliasing in the application.
+    std::map<std::vector<char>, cl_mem> aliasMap;
+
+    for( cl_uint i = 0; i < capture.Args.size(); i++ )
+    {
+        SArgument& arg = capture.Args[i];
+        cl_int errorCode = CL_SUCCESS;
+
+        switch( arg.Kind )
+        {
+        case ARG_VALUE:
+            errorCode = cl.clSetKernelArg(kernel, i, arg.Data.size(), arg.Data.data());
+            break;
+        case ARG_LOCAL:
+            errorCode = cl.clSetKernelArg(kernel, i, arg.LocalSize, NULL);
+            break;
+        case ARG_BUFFER:
+            {
+                auto it = arg.HasData ? aliasMap.find(arg.Data) : aliasMap.end();
+                if( it != aliasMap.end() )
+                {
+                    DEBUG("argument %u aliases another buffer argument\n", i);
+                    arg.MemObj = it->second;
+                }
+                else
+                {
+                    arg.MemObj = cl.clCreateBuffer(
+                        context,
+                        CL_MEM_COPY_HOST_PTR,
+                        arg.PreData.size(),
+                        arg.PreData.data(),
+                        &errorCode);
+                    if( arg.HasData && errorCode == CL_SUCCESS )
+                    {
+                        aliasMap[arg.Data] = arg.MemObj;
+                    }
+                }
+                if( errorCode == CL_SUCCESS )
+                {
+                    errorCode = cl.clSetKernelArg(kernel, i, sizeof(cl_mem), &arg.MemObj);
+                }
+            }
+            break;
+        case ARG_IMAGE:
+            arg.MemObj = cl.clCreateImage(
+                context,
+                CL_MEM_COPY_HOST_PTR,
+                &arg.ImageFormat,
+                &arg.ImageDesc,
+                arg.PreData.data(),
+                &errorCode);
+            if( errorCode == CL_SUCCESS )
+            {
+                errorCode = cl.clSetKernelArg(kernel, i, sizeof(cl_mem), &arg.MemObj);
+            }
+            break;
+        case ARG_SAMPLER:
+            if( !createSampler(context, arg) )
+            {
+                errorCode = CL_INVALID_SAMPLER;
+            }
+            else
+            {
+                errorCode = cl.clSetKernelArg(kernel, i, sizeof(cl_sampler), &arg.Sampler);
+            }
+            break;
+        }
+
+        if( errorCode != CL_SUCCESS )
+        {
+            fprintf(stderr, "clireplay Error: couldn't set argument %u (%d).\n", i, errorCode);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool readArg(
+    cl_command_queue queue,
+    const SArgument& arg,
+    std::vector<char>& data )
+{
+    data.resize(arg.PreData.size());
+
+    cl_int errorCode = CL_SUCCESS;
+    if( arg.Kind == ARG_IMAGE )
+    {
+        const size_t origin[3] = { 0, 0, 0 };
+        errorCode = cl.clEnqueueReadImage(
+            queue,
+            arg.MemObj,
+            CL_TRUE,
+            origin,
+            arg.ImageRegion,
+            0,
+            0,
+            data.data(),
+            0,
+            NULL,
+            NULL);
+    }
+    else
+    {
+        errorCode = cl.clEnqueueReadBuffer(
+            queue,
+            arg.MemObj,
+            CL_TRUE,
+            0,
+            data.size(),
+            data.data(),
+            0,
+            NULL,
+            NULL);
+    }
+    return errorCode == CL_SUCCESS;
+}
+
+// Reads back the results of a single kernel execution and optionally
+// compares them against the captured Post buffers and images.  Returns
+// false if any output does not match.
+static bool checkOutputs(
+    cl_command_queue queue,
+    const SCapture& capture )
+{
+    const std::string testDirectory = directory + "/Test/";
+    if( writeOutput )
+    {
+        makeDirectory(testDirectory);
+    }
+
+    std::string paddedEnqueueNumber = capture.EnqueueNumber;
+    if( paddedEnqueueNumber.size() < 4 )
+    {
+        paddedEnqueueNumber.insert(0, 4 - paddedEnqueueNumber.size(), '0');
+    }
+
+    bool allEqual = true;
+    for( cl_uint i = 0; i < capture.Args.size(); i++ )
+    {
+        const SArgument& arg = capture.Args[i];
+        if( arg.Kind != ARG_BUFFER && arg.Kind != ARG_IMAGE )
+        {
+            continue;
+        }
+
+        std::vector<char> result;
+        if( !readArg(queue, arg, result) )
+        {
+            fprintf(stderr, "clireplay Error: couldn't read back argument %u.\n", i);
+            allEqual = false;
+            continue;
+        }
+
+        if( writeOutput )
+        {
+            const std::string fileName =
+                testDirectory + "Enqueue_" + paddedEnqueueNumber +
+                "_Kernel_" + capture.KernelName +
+                "_Arg_" + std::to_string(i) +
+                ( arg.Kind == ARG_IMAGE ? "_Image.raw" : "_Buffer.bin" );
+            printf("Writing output to file: %s\n", fileName.c_str());
+            writeFile(fileName, result);
+        }
+
+        if( validate )
+        {
+            std::vector<char> expected;
+            if( arg.PostFileName.empty() || !readFile(arg.PostFileName, expected) )
+            {
+                printf("Check: Argument %u has no captured output, skipping.\n", i);
+                continue;
+            }
+
+            size_t numDiffs = 0;
+            size_t firstDiff = 0;
+            const size_t size = std::min(result.size(), expected.size());
+            for( size_t b = 0; b < size; b++ )
+            {
+                if( result[b] != expected[b] )
+                {
+                    if( numDiffs == 0 )
+                    {
+                        firstDiff = b;
+                    }
+                    numDiffs++;
+                }
+            }
+
+            if( numDiffs == 0 && result.size() == expected.size() )
+            {
+                printf("Check: Argument %u is equal.\n", i);
+            }
+            else
+            {
+                printf("Check: Argument %u is not equal, data type=%s: %zu of %zu bytes differ, first difference at byte offset %zu!\n",
+                    i,
+                    arg.TypeName.empty() ? "unknown" : arg.TypeName.c_str(),
+                    numDiffs,
+                    expected.size(),
+                    firstDiff);
+                allEqual = false;
+            }
+        }
+    }
+
+    if( validate )
+    {
+        printf("\n");
+        if( allEqual )
+        {
+            printf("Replayed standalone kernel produces correct results.\n");
+        }
+        else
+        {
+            printf("Replayed standalone kernel differs from the application's results.\n"
+                "This may be due to a different order of floating point operations.\n"
+                "Please check manually whether the differences are significant.\n");
+        }
+    }
+
+    return allEqual;
+}
+
+static bool runKernel(
+    cl_command_queue queue,
+    cl_kernel kernel,
+    const SCapture& capture,
+    cl_ulong* deviceTimeNS )
+{
+    cl_event event = NULL;
+    cl_int errorCode = cl.clEnqueueNDRangeKernel(
+        queue,
+        kernel,
+        capture.WorkDim,
+        capture.GWO,
+        capture.GWS,
+        capture.NullLWS ? NULL : capture.LWS,
+        0,
+        NULL,
+        deviceTimeNS ? &event : NULL);
+    if( errorCode == CL_SUCCESS )
+    {
+        errorCode = cl.clFinish(queue);
+    }
+    if( errorCode == CL_SUCCESS && event )
+    {
+        cl_ulong start = 0;
+        cl_ulong end = 0;
+        errorCode = cl.clGetEventProfilingInfo(
+            event,
+            CL_PROFILING_COMMAND_START,
+            sizeof(start),
+            &start,
+            NULL);
+        if( errorCode == CL_SUCCESS )
+        {
+            errorCode = cl.clGetEventProfilingInfo(
+                event,
+                CL_PROFILING_COMMAND_END,
+                sizeof(end),
+                &end,
+                NULL);
+        }
+        *deviceTimeNS = end - start;
+    }
+    if( event )
+    {
+        cl.clReleaseEvent(event);
+    }
+    if( errorCode != CL_SUCCESS )
+    {
+        fprintf(stderr, "clireplay Error: kernel execution failed (%d).\n", errorCode);
+        return false;
+    }
+    return true;
+}
+
+static std::string getPlatformString(cl_platform_id platform, cl_platform_info param)
+{
+    size_t size = 0;
+    cl.clGetPlatformInfo(platform, param, 0, NULL, &size);
+    std::string str(size, '\0');
+    cl.clGetPlatformInfo(platform, param, size, &str[0], NULL);
+    return str.c_str();
+}
+
+static std::string getDeviceString(cl_device_id device, cl_device_info param)
+{
+    size_t size = 0;
+    cl.clGetDeviceInfo(device, param, 0, NULL, &size);
+    std::string str(size, '\0');
+    cl.clGetDeviceInfo(device, param, size, &str[0], NULL);
+    return str.c_str();
+}
+
+static std::string formatSizes(cl_uint workDim, const size_t* sizes)
+{
+    std::string str;
+    for( cl_uint i = 0; i < workDim; i++ )
+    {
+        str += ( i ? " x " : "" ) + std::to_string(sizes[i]);
+    }
+    return str;
+}
+
+static std::string formatJSONString(const std::string& str)
+{
+    std::string json = "\"";
+    for( char c : str )
+    {
+        if( c == '"' || c == '\\' )
+        {
+            json += '\\';
+            json += c;
+        }
+        else if( (unsigned char)c < 0x20 )
+        {
+            char tmp[8];
+            snprintf(tmp, sizeof(tmp), "\\u%04x", (unsigned int)c);
+            json += tmp;
+        }
+        else
+        {
+            json += c;
+        }
+    }
+    return json + "\"";
+}
+
+static std::string formatJSONSizes(cl_uint workDim, const size_t* sizes)
+{
+    std::string json = "[";
+    for( cl_uint i = 0; i < workDim; i++ )
+    {
+        json += ( i ? ", " : "" ) + std::to_string(sizes[i]);
+    }
+    return json + "]";
+}
+
+// Writes the replay results as a JSON object, for scripts such as the
+// replay performance regression suite.
+static bool writeJSONResults(
+    const std::string& fileName,
+    cl_platform_id platform,
+    cl_device_id device,
+    const SCapture& capture,
+    int result,
+    const std::vector<cl_ulong>& times,
+    double median )
+{
+    FILE* fp = fopen(fileName.c_str(), "w");
+    if( fp == NULL )
+    {
+        fprintf(stderr, "clireplay Error: couldn't open %s for writing.\n",
+            fileName.c_str());
+        return false;
+    }
+
+    fprintf(fp, "{\n");
+    fprintf(fp, "  \"platform\": %s,\n",
+        formatJSONString(getPlatformString(platform, CL_PLATFORM_NAME)).c_str());
+    fprintf(fp, "  \"device\": %s,\n",
+        formatJSONString(getDeviceString(device, CL_DEVICE_NAME)).c_str());
+    fprintf(fp, "  \"driver_version\": %s,\n",
+        formatJSONString(getDeviceString(device, CL_DRIVER_VERSION)).c_str());
+    fprintf(fp, "  \"kernel\": %s,\n",
+        formatJSONString(capture.KernelName).c_str());
+    fprintf(fp, "  \"gws\": %s,\n",
+        formatJSONSizes(capture.WorkDim, capture.GWS).c_str());
+    fprintf(fp, "  \"lws\": %s,\n",
+        capture.NullLWS ? "null" : formatJSONSizes(capture.WorkDim, capture.LWS).c_str());
+    fprintf(fp, "  \"gwo\": %s,\n",
+        formatJSONSizes(capture.WorkDim, capture.GWO).c_str());
+    fprintf(fp, "  \"result\": %d,\n", result);
+    fprintf(fp, "  \"iterations\": %zu", times.size());
+    if( !times.empty() )
+    {
+        fprintf(fp, ",\n");
+        fprintf(fp, "  \"min_us\": %.3f,\n", times.front() / 1000.0);
+        fprintf(fp, "  \"median_us\": %.3f,\n", median / 1000.0);
+        fprintf(fp, "  \"max_us\": %.3f", times.back() / 1000.0);
+    }
+    fprintf(fp, "\n}\n");
+
+    fclose(fp);
+    return true;
+}
+
+bool getPlatformAndDevice(cl_platform_id& platform, cl_device_id& device)
+{
+    cl_uint numPlatforms = 0;
+    cl.clGetPlatformIDs(0, NULL, &numPlatforms);
+    if( platformIndex >= numPlatforms )
+    {
+        fprintf(stderr, "clireplay Error: platform index %u is out of range, %u platforms were found.\n",
+            platformIndex, numPlatforms);
+        return false;
+    }
+    std::vector<cl_platform_id> platforms(numPlatforms);
+    cl.clGetPlatformIDs(numPlatforms, platforms.data(), NULL);
+    platform = platforms[platformIndex];
+
+    cl_uint numDevices = 0;
+    cl.clGetDeviceIDs(platform, CL_DEVICE_TYPE_ALL, 0, NULL, &numDevices);
+    if( deviceIndex >= numDevices )
+    {
+        fprintf(stderr, "clireplay Error: device index %u is out of range, %u devices were found.\n",
+            deviceIndex, numDevices);
+        return false;
+    }
+    std::vector<cl_device_id> devices(numDevices);
+    cl.clGetDeviceIDs(platform, CL_DEVICE_TYPE_ALL, numDevices, devices.data(), NULL);
+    device = devices[deviceIndex];
+
+    printf("Running on platform: %s\n", getPlatformString(platform, CL_PLATFORM_NAME).c_str());
+    printf("Running on device: %s\n", getDeviceString(device, CL_DEVICE_NAME).c_str());
+    return true;
+}
+
+static int replay()
+{
+    SCapture capture;
+    if( !loadCapture(capture) )
+    {
+        return 1;
+    }
+
+    cl_platform_id platform = NULL;
+    cl_device_id device = NULL;
+    if( !loadOpenCL() || !getPlatformAndDevice(platform, device) )
+    {
+        return 1;
+    }
+
+    printf("Kernel: %s\n", capture.KernelName.c_str());
+    printf("Global Work Size: %s\n", formatSizes(capture.WorkDim, capture.GWS).c_str());
+    printf("Local Work Size: %s\n", capture.NullLWS ? "NULL" : formatSizes(capture.WorkDim, capture.LWS).c_str());
+    printf("Global Work Offset: %s\n", formatSizes(capture.WorkDim, capture.GWO).c_str());
+
+    cl_int errorCode = CL_SUCCESS;
+    const cl_context_properties properties[] = {
+        CL_CONTEXT_PLATFORM, (cl_context_properties)platform,
+        0
+    };
+    cl_context context = cl.clCreateContext(properties, 1, &device, NULL, NULL, &errorCode);
+    if( errorCode != CL_SUCCESS )
+    {
+        fprintf(stderr, "clireplay Error: couldn't create context (%d).\n", errorCode);
+        return 1;
+    }
+
+    cl_command_queue queue = cl.clCreateCommandQueue(
+        context,
+        device,
+        CL_QUEUE_PROFILING_ENABLE,
+        &errorCode);
+    if( errorCode != CL_SUCCESS )
+    {
+        fprintf(stderr, "clireplay Error: couldn't create command queue (%d).\n", errorCode);
+        cl.clReleaseContext(context);
+        return 1;
+    }
+
+    int result = 1;
+    std::vector<cl_ulong> times;
+    double median = 0.0;
+    cl_kernel kernel = NULL;
+    cl_program program = createProgram(context, device, capture);
+    if( program )
+    {
+        kernel = cl.clCreateKernel(program, capture.KernelName.c_str(), &errorCode);
+        if( errorCode != CL_SUCCESS )
+        {
+            fprintf(stderr, "clireplay Error: couldn't create kernel %s (%d).\n",
+                capture.KernelName.c_str(), errorCode);
+        }
+    }
+
+    if( kernel && setKernelArgs(context, kernel, capture) )
+    {
+        result = 0;
+
+        // The first execution uses the captured inputs, so its results can
+        // be checked.  Subsequent executions are only for timing and may
+        // modify their own inputs.
+        if( validate || writeOutput )
+        {
+            if( !runKernel(queue, kernel, capture, NULL) )
+            {
+                result = 1;
+            }
+            else if( !checkOutputs(queue, capture) && validate )
+            {
+                result = 2;
+            }
+            printf("\n");
+        }
+
+        for( cl_uint i = 0; result != 1 && i < warmupIterations; i++ )
+        {
+            if( !runKernel(queue, kernel, capture, NULL) )
+            {
+                result = 1;
+            }
+        }
+
+        for( cl_uint i = 0; result != 1 && i < iterations; i++ )
+        {
+            cl_ulong ns = 0;
+            if( !runKernel(queue, kernel, capture, &ns) )
+            {
+                result = 1;
+            }
+            else
+            {
+                times.push_back(ns);
+            }
+        }
+
+        if( !times.empty() )
+        {
+            std::sort(times.begin(), times.end());
+            const size_t mid = times.size() / 2;
+            median = ( times.size() % 2 ) ?
+                times[mid] :
+                ( times[mid - 1] + times[mid] ) / 2.0;
+            printf("Device Execution Time over %zu iterations (us): min %.3f, median %.3f, max %.3f\n",
+                times.size(),
+                times.front() / 1000.0,
+                median / 1000.0,
+                times.back() / 1000.0);
+        }
+    }
+
+    if( !jsonFileName.empty() &&
+        !writeJSONResults(jsonFileName, platform, device, capture, result, times, median) )
+    {
+        result = 1;
+    }
+
+    std::map<cl_mem, bool> released;
+    for( SArgument& arg : capture.Args )
+    {
+        if( arg.MemObj && !released[arg.MemObj] )
+        {
+            cl.clReleaseMemObject(arg.MemObj);
+            released[arg.MemObj] = true;
+        }
+        if( arg.Sampler )
+        {
+            cl.clReleaseSampler(arg.Sampler);
+        }
+    }
+    if( kernel )
+    {
+        cl.clReleaseKernel(kernel);
+    }
+    if( program )
+    {
+        cl.clReleaseProgram(program);
+    }
+    cl.clReleaseCommandQueue(queue);
+    cl.clReleaseContext(context);
+
+    return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+
+static bool parseUInt(int& i, int argc, char* argv[], cl_uint& value)
+{
+    if( ++i < argc )
+    {
+        value = (cl_uint)strtoul(argv[i], NULL, 0);
+        return true;
+    }
+    return false;
+}
+
+static bool parseArguments(int argc, char *argv[])
+{
+    bool printUsage = false;
+    bool foundDirectory = false;
+
+    for( int i = 1; i < argc; i++ )
+    {
+        if( !strcmp(argv[i], "--debug") )
+        {
+            debug = true;
+        }
+        else if( !strcmp(argv[i], "--help") )
+        {
+            printUsage = true;
+        }
+        else if( !strcmp(argv[i], "-p") || !strcmp(argv[i], "--platform") )
+        {
+            printUsage |= !parseUInt(i, argc, argv, platformIndex);
+        }
+        else if( !strcmp(argv[i], "-d") || !strcmp(argv[i], "--device") )
+        {
+            printUsage |= !parseUInt(i, argc, argv, deviceIndex);
+        }
+        else if( !strcmp(argv[i], "-r") || !strcmp(argv[i], "--repetitions") )
+        {
+            printUsage |= !parseUInt(i, argc, argv, iterations);
+        }
+        else if( !strcmp(argv[i], "-w") || !strcmp(argv[i], "--warmup") )
+        {
+            printUsage |= !parseUInt(i, argc, argv, warmupIterations);
+        }
+        else if( !strcmp(argv[i], "-v") || !strcmp(argv[i], "--validate") )
+        {
+            validate = true;
+        }
+        else if( !strcmp(argv[i], "-o") || !strcmp(argv[i], "--output") )
+        {
+            writeOutput = true;
+        }
+        else if( !strcmp(argv[i], "--json") )
+        {
+            if( ++i < argc )
+            {
+                jsonFileName = argv[i];
+            }
+            else
+            {
+                printUsage = true;
+            }
+        }
+        else if( !strcmp(argv[i], "--stream") )
+        {
+            if( ++i < argc )
+            {
+                streamFileName = argv[i];
+            }
+            else
+            {
+                printUsage = true;
+            }
+        }
+        else if( !strcmp(argv[i], "--speed") )
+        {
+            if( ++i < argc )
+            {
+                streamSpeed = strtod(argv[i], NULL);
+            }
+            else
+            {
+                printUsage = true;
+            }
+        }
+        else if( !strcmp(argv[i], "--opencl") )
+        {
+            if( ++i < argc )
+            {
+                openclLibrary = argv[i];
+            }
+            else
+            {
+                printUsage = true;
+            }
+        }
+        else if( argv[i][0] == '-' || foundDirectory )
+        {
+            printUsage = true;
+        }
+        else
+        {
+            directory = argv[i];
+            foundDirectory = true;
+        }
+    }
+
+    if( printUsage )
+    {
+        printf(
+            "clireplay - Replay a Kernel Captured by the Intercept Layer for OpenCL Applications\n"
+            "  Version: %s%s%s\n"
+            "\n"
+            "Usage: clireplay [OPTIONS] [DIRECTORY]\n"
+            "       clireplay [OPTIONS] --stream FILE\n"
+            "\n"
+            "DIRECTORY is a Replay/Enqueue_* capture directory, default: the current directory\n"
+            "FILE is a stream capture file recorded with the CaptureStream control\n"
+            "\n"
+            "Options:\n"
+            "  --help                           Print this Message and Exit\n"
+            "  --debug                          Enable clireplay Debug Messages\n"
+            "  --platform [-p] <INDEX>          Choose the Platform to Replay On, default: %u\n"
+            "  --device [-d] <INDEX>            Choose the Device to Replay On, default: %u\n"
+            "  --repetitions [-r] <NUMBER>      Number of Timed Kernel Executions, default: %u\n"
+            "  --warmup [-w] <NUMBER>           Number of Untimed Warmup Executions, default: %u\n"
+            "  --validate [-v]                  Validate Outputs Against the Captured Post Buffers\n"
+            "  --output [-o]                    Write Outputs to the Test Subdirectory\n"
+            "  --json <FILE>                    Write the Kernel Replay Results to a JSON File\n"
+            "  --stream <FILE>                  Replay a Stream Capture Instead of a Single Kernel\n"
+            "  --speed <FACTOR>                 Stream Replay Speed Relative to the Original Timing,\n"
+            "                                    or 0 to Replay as Fast as Possible, default: %.1f\n"
+            "  --opencl <LIBRARY>               OpenCL Library to Load, default: %s\n"
+            "\n"
+            "For more information, please visit the Intercept Layer for OpenCL Applications page:\n"
+            "    %s\n"
+            "\n",
+            g_scGitDescribe,
+            strlen(g_scGitRefSpec) > 0 ? ", from " : "",
+            strlen(g_scGitRefSpec) > 0 ? g_scGitRefSpec : "",
+            platformIndex,
+            deviceIndex,
+            iterations,
+            warmupIterations,
+            streamSpeed,
+            OPENCL_LIBRARY_NAME,
+            g_scURL );
+        return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    if( !parseArguments(argc, argv) )
+    {
+        return 1;
+    }
+
+    if( !streamFileName.empty() )
+    {
+        return replayStream(streamFileName, streamSpeed);
+    }
+
+    return replay();
+}
@@ -0,0 +1,77 @@
+/*
+// Copyright (c) 2025 Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+*/
+#pragma once
+
+#define CL_USE_DEPRECATED_OPENCL_1_0_APIS
+#define CL_USE_DEPRECATED_OPENCL_1_1_APIS
+#define CL_USE_DEPRECATED_OPENCL_1_2_APIS
+#define CL_USE_DEPRECATED_OPENCL_2_0_APIS
+#define CL_TARGET_OPENCL_VERSION 300
+#include "CL/cl.h"
+
+#include <string>
+
+// OpenCL entry points, resolved at runtime from the ICD loader.
+
+struct SOpenCLFunctions
+{
+    decltype(&::clGetPlatformIDs)           clGetPlatformIDs;
+    decltype(&::clGetPlatformInfo)          clGetPlatformInfo;
+    decltype(&::clGetDeviceIDs)             clGetDeviceIDs;
+    decltype(&::clGetDeviceInfo)            clGetDeviceInfo;
+    decltype(&::clCreateContext)            clCreateContext;
+    decltype(&::clRetainContext)            clRetainContext;
+    decltype(&::clReleaseContext)           clReleaseContext;
+    decltype(&::clCreateCommandQueue)       clCreateCommandQueue;
+    decltype(&::clRetainCommandQueue)       clRetainCommandQueue;
+    decltype(&::clReleaseCommandQueue)      clReleaseCommandQueue;
+    decltype(&::clCreateBuffer)             clCreateBuffer;
+    decltype(&::clCreateImage)              clCreateImage;
+    decltype(&::clRetainMemObject)          clRetainMemObject;
+    decltype(&::clReleaseMemObject)         clReleaseMemObject;
+    decltype(&::clCreateSampler)            clCreateSampler;
+    decltype(&::clReleaseSampler)           clReleaseSampler;
+    decltype(&::clCreateProgramWithSource)  clCreateProgramWithSource;
+    decltype(&::clCreateProgramWithBinary)  clCreateProgramWithBinary;
+    decltype(&::clCreateProgramWithIL)      clCreateProgramWithIL;
+    decltype(&::clBuildProgram)             clBuildProgram;
+    decltype(&::clGetProgramBuildInfo)      clGetProgramBuildInfo;
+    decltype(&::clRetainProgram)            clRetainProgram;
+    decltype(&::clReleaseProgram)           clReleaseProgram;
+    decltype(&::clCreateKernel)             clCreateKernel;
+    decltype(&::clSetKernelArg)             clSetKernelArg;
+    decltype(&::clRetainKernel)             clRetainKernel;
+    decltype(&::clReleaseKernel)            clReleaseKernel;
+    decltype(&::clEnqueueNDRangeKernel)     clEnqueueNDRangeKernel;
+    decltype(&::clEnqueueReadBuffer)        clEnqueueReadBuffer;
+    decltype(&::clEnqueueWriteBuffer)       clEnqueueWriteBuffer;
+    decltype(&::clEnqueueCopyBuffer)        clEnqueueCopyBuffer;
+    decltype(&::clEnqueueFillBuffer)        clEnqueueFillBuffer;
+    decltype(&::clEnqueueMapBuffer)         clEnqueueMapBuffer;
+    decltype(&::clEnqueueUnmapMemObject)    clEnqueueUnmapMemObject;
+    decltype(&::clEnqueueReadImage)         clEnqueueReadImage;
+    decltype(&::clEnqueueMarkerWithWaitList)    clEnqueueMarkerWithWaitList;
+    decltype(&::clEnqueueBarrierWithWaitList)   clEnqueueBarrierWithWaitList;
+    decltype(&::clGetEventProfilingInfo)    clGetEventProfilingInfo;
+    decltype(&::clWaitForEvents)            clWaitForEvents;
+    decltype(&::clRetainEvent)              clRetainEvent;
+    decltype(&::clReleaseEvent)             clReleaseEvent;
+    decltype(&::clFlush)                    clFlush;
+    decltype(&::clFinish)                   clFinish;
+};
+
+extern SOpenCLFunctions cl;
+
+// Loads the OpenCL library and resolves the entry points in cl.
+bool loadOpenCL();
+
+// Gets the platform and device chosen on the command line.
+bool getPlatformAndDevice(cl_platform_id& platform, cl_device_id& device);
+
+// Replays a stream capture recorded with the CaptureStream control.  If
+// speed is zero, calls are replayed as quickly as possible, otherwise calls
+// are paced to the original timing divided by speed.
+int replayStream(const std::string& fileName, double speed);
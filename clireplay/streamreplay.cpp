@@ -0,0 +1,691 @@
+/*
+// Copyright (c) 2025 Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+*/
+
+// Replays a stream capture recorded with the CaptureStream control.  Every
+// recorded call is re-issued in order on the chosen device, optionally paced
+// to the original timing, and the replay time is reported.
+
+#include "clireplay.h"
+#include "src/streamformat.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char* getRecordName(uint32_t type)
+{
+    switch( type )
+    {
+    case STREAM_RECORD_CREATE_CONTEXT:              return "clCreateContext";
+    case STREAM_RECORD_CREATE_COMMAND_QUEUE:        return "clCreateCommandQueue";
+    case STREAM_RECORD_CREATE_BUFFER:               return "clCreateBuffer";
+    case STREAM_RECORD_CREATE_PROGRAM_WITH_SOURCE:  return "clCreateProgramWithSource";
+    case STREAM_RECORD_CREATE_PROGRAM_WITH_IL:      return "clCreateProgramWithIL";
+    case STREAM_RECORD_CREATE_PROGRAM_WITH_BINARY:  return "clCreateProgramWithBinary";
+    case STREAM_RECORD_BUILD_PROGRAM:               return "clBuildProgram";
+    case STREAM_RECORD_CREATE_KERNEL:               return "clCreateKernel";
+    case STREAM_RECORD_SET_KERNEL_ARG:              return "clSetKernelArg";
+    case STREAM_RECORD_ENQUEUE_NDRANGE_KERNEL:      return "clEnqueueNDRangeKernel";
+    case STREAM_RECORD_ENQUEUE_WRITE_BUFFER:        return "clEnqueueWriteBuffer";
+    case STREAM_RECORD_ENQUEUE_READ_BUFFER:         return "clEnqueueReadBuffer";
+    case STREAM_RECORD_ENQUEUE_COPY_BUFFER:         return "clEnqueueCopyBuffer";
+    case STREAM_RECORD_ENQUEUE_FILL_BUFFER:         return "clEnqueueFillBuffer";
+    case STREAM_RECORD_ENQUEUE_MAP_BUFFER:          return "clEnqueueMapBuffer";
+    case STREAM_RECORD_ENQUEUE_UNMAP_MEM_OBJECT:    return "clEnqueueUnmapMemObject";
+    case STREAM_RECORD_ENQUEUE_MARKER:              return "clEnqueueMarkerWithWaitList";
+    case STREAM_RECORD_ENQUEUE_BARRIER:             return "clEnqueueBarrierWithWaitList";
+    case STREAM_RECORD_FLUSH:                       return "clFlush";
+    case STREAM_RECORD_FINISH:                      return "clFinish";
+    case STREAM_RECORD_WAIT_FOR_EVENTS:             return "clWaitForEvents";
+    case STREAM_RECORD_RETAIN:                      return "clRetain*";
+    case STREAM_RECORD_RELEASE:                     return "clRelease*";
+    default:                                        return "unknown";
+    }
+}
+
+enum EObjectKind
+{
+    OBJECT_CONTEXT,
+    OBJECT_QUEUE,
+    OBJECT_MEM,
+    OBJECT_PROGRAM,
+    OBJECT_KERNEL,
+    OBJECT_EVENT,
+};
+
+struct SObject
+{
+    EObjectKind Kind;
+    void*       Handle;
+};
+
+struct SMapping
+{
+    void*       Ptr;
+    cl_event    LocalEvent;
+};
+
+class CStreamReplayer
+{
+public:
+    CStreamReplayer(cl_platform_id platform, cl_device_id device) :
+        m_Platform(platform),
+        m_Device(device) {}
+
+    // Replays one record.  Returns the OpenCL error for the replayed call.
+    cl_int  replay(uint32_t type, CStreamCaptureReader& reader);
+
+    void    finishAll();
+
+    std::vector<char>   ReadScratch;
+
+private:
+    cl_platform_id  m_Platform;
+    cl_device_id    m_Device;
+
+    std::map<uint32_t, SObject>     m_Objects;
+    std::map<uint32_t, SMapping>    m_Mappings;
+
+    template<class T>
+    T       get(uint32_t id) const
+    {
+        std::map<uint32_t, SObject>::const_iterator iter = m_Objects.find(id);
+        return iter != m_Objects.end() ? (T)iter->second.Handle : NULL;
+    }
+
+    void    add(uint32_t id, EObjectKind kind, void* handle)
+    {
+        if( id != 0 && handle != NULL )
+        {
+            SObject& object = m_Objects[id];
+            object.Kind = kind;
+            object.Handle = handle;
+        }
+    }
+
+    void    getWaitList(CStreamCaptureReader& reader, std::vector<cl_event>& events) const
+    {
+        uint32_t count = reader.get32();
+        events.clear();
+        for( uint32_t i = 0; i < count && reader.ok(); i++ )
+        {
+            cl_event event = get<cl_event>(reader.get32());
+            if( event )
+            {
+                events.push_back(event);
+            }
+        }
+    }
+};
+
+cl_int CStreamReplayer::replay(uint32_t type, CStreamCaptureReader& reader)
+{
+    cl_int errorCode = CL_SUCCESS;
+    std::vector<cl_event> waitList;
+
+    // Enqueues return an event if the application asked for one.
+    cl_event event = NULL;
+
+    switch( type )
+    {
+    case STREAM_RECORD_CREATE_CONTEXT:
+        {
+            uint32_t id = reader.get32();
+            const cl_context_properties properties[] = {
+                CL_CONTEXT_PLATFORM, (cl_context_properties)m_Platform,
+                0
+            };
+            cl_context context = cl.clCreateContext(
+                properties, 1, &m_Device, NULL, NULL, &errorCode);
+            add(id, OBJECT_CONTEXT, context);
+        }
+        break;
+    case STREAM_RECORD_CREATE_COMMAND_QUEUE:
+        {
+            uint32_t id = reader.get32();
+            cl_context context = get<cl_context>(reader.get32());
+            cl_command_queue_properties properties =
+                reader.get64() &
+                ( CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE | CL_QUEUE_PROFILING_ENABLE );
+            cl_command_queue queue = cl.clCreateCommandQueue(
+                context, m_Device, properties, &errorCode);
+            add(id, OBJECT_QUEUE, queue);
+        }
+        break;
+    case STREAM_RECORD_CREATE_BUFFER:
+        {
+            uint32_t id = reader.get32();
+            cl_context context = get<cl_context>(reader.get32());
+            cl_mem_flags flags = reader.get64();
+            size_t size = (size_t)reader.get64();
+            size_t dataSize = 0;
+            const char* data = reader.getBlob(dataSize);
+            if( dataSize )
+            {
+                flags |= CL_MEM_COPY_HOST_PTR;
+            }
+            cl_mem mem = cl.clCreateBuffer(
+                context, flags, size, dataSize ? (void*)data : NULL, &errorCode);
+            add(id, OBJECT_MEM, mem);
+        }
+        break;
+    case STREAM_RECORD_CREATE_PROGRAM_WITH_SOURCE:
+    case STREAM_RECORD_CREATE_PROGRAM_WITH_IL:
+    case STREAM_RECORD_CREATE_PROGRAM_WITH_BINARY:
+        {
+            uint32_t id = reader.get32();
+            cl_context context = get<cl_context>(reader.get32());
+            size_t size = 0;
+            const char* data = reader.getBlob(size);
+            cl_program program = NULL;
+            if( type == STREAM_RECORD_CREATE_PROGRAM_WITH_SOURCE )
+            {
+                program = cl.clCreateProgramWithSource(
+                    context, 1, &data, &size, &errorCode);
+            }
+            else if( type == STREAM_RECORD_CREATE_PROGRAM_WITH_IL )
+            {
+                errorCode = CL_INVALID_OPERATION;
+                if( cl.clCreateProgramWithIL )
+                {
+                    program = cl.clCreateProgramWithIL(
+                        context, data, size, &errorCode);
+                }
+            }
+            else
+            {
+                const unsigned char* binary = (const unsigned char*)data;
+                program = cl.clCreateProgramWithBinary(
+                    context, 1, &m_Device, &size, &binary, NULL, &errorCode);
+            }
+            add(id, OBJECT_PROGRAM, program);
+        }
+        break;
+    case STREAM_RECORD_BUILD_PROGRAM:
+        {
+            cl_program program = get<cl_program>(reader.get32());
+            size_t size = 0;
+            const char* data = reader.getBlob(size);
+            std::string options(data ? data : "", size);
+            errorCode = cl.clBuildProgram(
+                program, 1, &m_Device, options.c_str(), NULL, NULL);
+            if( errorCode != CL_SUCCESS && program )
+            {
+                size_t logSize = 0;
+                cl.clGetProgramBuildInfo(program, m_Device, CL_PROGRAM_BUILD_LOG, 0, NULL, &logSize);
+                std::string log(logSize, '\0');
+                cl.clGetProgramBuildInfo(program, m_Device, CL_PROGRAM_BUILD_LOG, logSize, &log[0], NULL);
+                fprintf(stderr, "Build Log:\n%s\n", log.c_str());
+            }
+        }
+        break;
+    case STREAM_RECORD_CREATE_KERNEL:
+        {
+            uint32_t id = reader.get32();
+            cl_program program = get<cl_program>(reader.get32());
+            size_t size = 0;
+            const char* data = reader.getBlob(size);
+            std::string name(data ? data : "", size);
+            cl_kernel kernel = cl.clCreateKernel(program, name.c_str(), &errorCode);
+            add(id, OBJECT_KERNEL, kernel);
+        }
+        break;
+    case STREAM_RECORD_SET_KERNEL_ARG:
+        {
+            cl_kernel kernel = get<cl_kernel>(reader.get32());
+            cl_uint index = reader.get32();
+            uint32_t kind = reader.get32();
+            size_t argSize = (size_t)reader.get64();
+            if( kind == STREAM_ARG_LOCAL )
+            {
+                errorCode = cl.clSetKernelArg(kernel, index, argSize, NULL);
+            }
+            else if( kind == STREAM_ARG_MEM_OBJECT )
+            {
+                cl_mem mem = get<cl_mem>(reader.get32());
+                errorCode = cl.clSetKernelArg(kernel, index, sizeof(mem), &mem);
+            }
+            else
+            {
+                size_t size = 0;
+                const char* data = reader.getBlob(size);
+                errorCode = cl.clSetKernelArg(kernel, index, size, data);
+            }
+        }
+        break;
+    case STREAM_RECORD_ENQUEUE_NDRANGE_KERNEL:
+        {
+            cl_command_queue queue = get<cl_command_queue>(reader.get32());
+            cl_kernel kernel = get<cl_kernel>(reader.get32());
+            cl_uint workDim = std::min<cl_uint>(reader.get32(), 3);
+            bool hasLWS = reader.get32() != 0;
+            size_t gwo[3], gws[3], lws[3];
+            for( cl_uint i = 0; i < workDim; i++ ) gwo[i] = (size_t)reader.get64();
+            for( cl_uint i = 0; i < workDim; i++ ) gws[i] = (size_t)reader.get64();
+            for( cl_uint i = 0; i < workDim; i++ ) lws[i] = (size_t)reader.get64();
+            getWaitList(reader, waitList);
+            uint32_t eventID = reader.get32();
+            errorCode = cl.clEnqueueNDRangeKernel(
+                queue,
+                kernel,
+                workDim,
+                gwo,
+                gws,
+                hasLWS ? lws : NULL,
+                (cl_uint)waitList.size(),
+                waitList.empty() ? NULL : waitList.data(),
+                eventID ? &event : NULL);
+            add(eventID, OBJECT_EVENT, event);
+        }
+        break;
+    case STREAM_RECORD_ENQUEUE_WRITE_BUFFER:
+        {
+            cl_command_queue queue = get<cl_command_queue>(reader.get32());
+            cl_mem mem = get<cl_mem>(reader.get32());
+            cl_bool blocking = reader.get32();
+            size_t offset = (size_t)reader.get64();
+            size_t size = 0;
+            const char* data = reader.getBlob(size);
+            getWaitList(reader, waitList);
+            uint32_t eventID = reader.get32();
+
+            // The record data is only valid until the next record is read,
+            // so writes are always blocking.
+            (void)blocking;
+            errorCode = cl.clEnqueueWriteBuffer(
+                queue,
+                mem,
+                CL_TRUE,
+                offset,
+                size,
+                data,
+                (cl_uint)waitList.size(),
+                waitList.empty() ? NULL : waitList.data(),
+                eventID ? &event : NULL);
+            add(eventID, OBJECT_EVENT, event);
+        }
+        break;
+    case STREAM_RECORD_ENQUEUE_READ_BUFFER:
+        {
+            cl_command_queue queue = get<cl_command_queue>(reader.get32());
+            cl_mem mem = get<cl_mem>(reader.get32());
+            cl_bool blocking = reader.get32();
+            size_t offset = (size_t)reader.get64();
+            size_t size = (size_t)reader.get64();
+            getWaitList(reader, waitList);
+            uint32_t eventID = reader.get32();
+            errorCode = cl.clEnqueueReadBuffer(
+                queue,
+                mem,
+                blocking,
+                offset,
+                size,
+                ReadScratch.data(),
+                (cl_uint)waitList.size(),
+                waitList.empty() ? NULL : waitList.data(),
+                eventID ? &event : NULL);
+            add(eventID, OBJECT_EVENT, event);
+        }
+        break;
+    case STREAM_RECORD_ENQUEUE_COPY_BUFFER:
+        {
+            cl_command_queue queue = get<cl_command_queue>(reader.get32());
+            cl_mem src = get<cl_mem>(reader.get32());
+            cl_mem dst = get<cl_mem>(reader.get32());
+            size_t srcOffset = (size_t)reader.get64();
+            size_t dstOffset = (size_t)reader.get64();
+            size_t size = (size_t)reader.get64();
+            getWaitList(reader, waitList);
+            uint32_t eventID = reader.get32();
+            errorCode = cl.clEnqueueCopyBuffer(
+                queue,
+                src,
+                dst,
+                srcOffset,
+                dstOffset,
+                size,
+                (cl_uint)waitList.size(),
+                waitList.empty() ? NULL : waitList.data(),
+                eventID ? &event : NULL);
+            add(eventID, OBJECT_EVENT, event);
+        }
+        break;
+    case STREAM_RECORD_ENQUEUE_FILL_BUFFER:
+        {
+            cl_command_queue queue = get<cl_command_queue>(reader.get32());
+            cl_mem mem = get<cl_mem>(reader.get32());
+            size_t patternSize = 0;
+            const char* pattern = reader.getBlob(patternSize);
+            size_t offset = (size_t)reader.get64();
+            size_t size = (size_t)reader.get64();
+            getWaitList(reader, waitList);
+            uint32_t eventID = reader.get32();
+            errorCode = cl.clEnqueueFillBuffer(
+                queue,
+                mem,
+                pattern,
+                patternSize,
+                offset,
+                size,
+                (cl_uint)waitList.size(),
+                waitList.empty() ? NULL : waitList.data(),
+                eventID ? &event : NULL);
+            add(eventID, OBJECT_EVENT, event);
+        }
+        break;
+    case STREAM_RECORD_ENQUEUE_MAP_BUFFER:
+        {
+            cl_command_queue queue = get<cl_command_queue>(reader.get32());
+            cl_mem mem = get<cl_mem>(reader.get32());
+            cl_bool blocking = reader.get32();
+            cl_map_flags flags = reader.get64();
+            size_t offset = (size_t)reader.get64();
+            size_t size = (size_t)reader.get64();
+            uint32_t mapID = reader.get32();
+            getWaitList(reader, waitList);
+            uint32_t eventID = reader.get32();
+
+            // A non-blocking map must complete before the host data can be
+            // copied into the mapping at unmap time, so keep an event for it.
+            cl_event localEvent = NULL;
+            void* ptr = cl.clEnqueueMapBuffer(
+                queue,
+                mem,
+                blocking,
+                flags,
+                offset,
+                size,
+                (cl_uint)waitList.size(),
+                waitList.empty() ? NULL : waitList.data(),
+                ( eventID || !blocking ) ? &localEvent : NULL,
+                &errorCode);
+            if( ptr )
+            {
+                SMapping& mapping = m_Mappings[mapID];
+                mapping.Ptr = ptr;
+                mapping.LocalEvent = localEvent;
+                if( eventID && localEvent )
+                {
+                    cl.clRetainEvent(localEvent);
+                    add(eventID, OBJECT_EVENT, localEvent);
+                }
+            }
+            else if( localEvent )
+            {
+                cl.clReleaseEvent(localEvent);
+            }
+        }
+        break;
+    case STREAM_RECORD_ENQUEUE_UNMAP_MEM_OBJECT:
+        {
+            cl_command_queue queue = get<cl_command_queue>(reader.get32());
+            cl_mem mem = get<cl_mem>(reader.get32());
+            uint32_t mapID = reader.get32();
+            size_t size = 0;
+            const char* data = reader.getBlob(size);
+            getWaitList(reader, waitList);
+            uint32_t eventID = reader.get32();
+
+            std::map<uint32_t, SMapping>::iterator iter = m_Mappings.find(mapID);
+            if( iter == m_Mappings.end() )
+            {
+                errorCode = CL_INVALID_VALUE;
+                break;
+            }
+            SMapping& mapping = iter->second;
+            if( mapping.LocalEvent )
+            {
+                if( size )
+                {
+                    cl.clWaitForEvents(1, &mapping.LocalEvent);
+                }
+                cl.clReleaseEvent(mapping.LocalEvent);
+            }
+            if( size )
+            {
+                memcpy(mapping.Ptr, data, size);
+            }
+            errorCode = cl.clEnqueueUnmapMemObject(
+                queue,
+                mem,
+                mapping.Ptr,
+                (cl_uint)waitList.size(),
+                waitList.empty() ? NULL : waitList.data(),
+                eventID ? &event : NULL);
+            add(eventID, OBJECT_EVENT, event);
+            m_Mappings.erase(iter);
+        }
+        break;
+    case STREAM_RECORD_ENQUEUE_MARKER:
+    case STREAM_RECORD_ENQUEUE_BARRIER:
+        {
+            cl_command_queue queue = get<cl_command_queue>(reader.get32());
+            getWaitList(reader, waitList);
+            uint32_t eventID = reader.get32();
+            errorCode = ( type == STREAM_RECORD_ENQUEUE_MARKER ?
+                cl.clEnqueueMarkerWithWaitList :
+                cl.clEnqueueBarrierWithWaitList )(
+                    queue,
+                    (cl_uint)waitList.size(),
+                    waitList.empty() ? NULL : waitList.data(),
+                    eventID ? &event : NULL);
+            add(eventID, OBJECT_EVENT, event);
+        }
+        break;
+    case STREAM_RECORD_FLUSH:
+        errorCode = cl.clFlush(get<cl_command_queue>(reader.get32()));
+        break;
+    case STREAM_RECORD_FINISH:
+        errorCode = cl.clFinish(get<cl_command_queue>(reader.get32()));
+        break;
+    case STREAM_RECORD_WAIT_FOR_EVENTS:
+        getWaitList(reader, waitList);
+        if( !waitList.empty() )
+        {
+            errorCode = cl.clWaitForEvents((cl_uint)waitList.size(), waitList.data());
+        }
+        break;
+    case STREAM_RECORD_RETAIN:
+    case STREAM_RECORD_RELEASE:
+        {
+            std::map<uint32_t, SObject>::iterator iter = m_Objects.find(reader.get32());
+            if( iter == m_Objects.end() )
+            {
+                errorCode = CL_INVALID_VALUE;
+                break;
+            }
+            const bool retain = type == STREAM_RECORD_RETAIN;
+            void* handle = iter->second.Handle;
+            switch( iter->second.Kind )
+            {
+            case OBJECT_CONTEXT:
+                errorCode = retain ?
+                    cl.clRetainContext((cl_context)handle) :
+                    cl.clReleaseContext((cl_context)handle);
+                break;
+            case OBJECT_QUEUE:
+                errorCode = retain ?
+                    cl.clRetainCommandQueue((cl_command_queue)handle) :
+                    cl.clReleaseCommandQueue((cl_command_queue)handle);
+                break;
+            case OBJECT_MEM:
+                errorCode = retain ?
+                    cl.clRetainMemObject((cl_mem)handle) :
+                    cl.clReleaseMemObject((cl_mem)handle);
+                break;
+            case OBJECT_PROGRAM:
+                errorCode = retain ?
+                    cl.clRetainProgram((cl_program)handle) :
+                    cl.clReleaseProgram((cl_program)handle);
+                break;
+            case OBJECT_KERNEL:
+                errorCode = retain ?
+                    cl.clRetainKernel((cl_kernel)handle) :
+                    cl.clReleaseKernel((cl_kernel)handle);
+                break;
+            case OBJECT_EVENT:
+                errorCode = retain ?
+                    cl.clRetainEvent((cl_event)handle) :
+                    cl.clReleaseEvent((cl_event)handle);
+                break;
+            }
+        }
+        break;
+    default:
+        errorCode = CL_INVALID_OPERATION;
+        break;
+    }
+
+    if( !reader.ok() )
+    {
+        errorCode = CL_INVALID_VALUE;
+    }
+    return errorCode;
+}
+
+void CStreamReplayer::finishAll()
+{
+    for( const auto& it : m_Objects )
+    {
+        if( it.second.Kind == OBJECT_QUEUE )
+        {
+            cl.clFinish((cl_command_queue)it.second.Handle);
+        }
+    }
+}
+
+static bool readRecord(
+    std::ifstream& is,
+    SStreamCaptureRecordHeader& header,
+    std::vector<char>& payload )
+{
+    if( !is.read((char*)&header, sizeof(header)) )
+    {
+        return false;
+    }
+    payload.resize((size_t)header.Size);
+    return (bool)is.read(payload.data(), payload.size());
+}
+
+int replayStream(const std::string& fileName, double speed)
+{
+    std::ifstream is(fileName, std::ios::in | std::ios::binary);
+    SStreamCaptureFileHeader fileHeader;
+    if( !is.read((char*)&fileHeader, sizeof(fileHeader)) ||
+        memcmp(fileHeader.Magic, sc_StreamCaptureMagic, sizeof(fileHeader.Magic)) != 0 )
+    {
+        fprintf(stderr, "clireplay Error: %s is not a stream capture file.\n",
+            fileName.c_str());
+        return 1;
+    }
+    if( fileHeader.Version != sc_StreamCaptureVersion ||
+        fileHeader.PointerSize != sizeof(void*) )
+    {
+        fprintf(stderr, "clireplay Error: unsupported stream capture version %u (%u-bit).\n",
+            fileHeader.Version, fileHeader.PointerSize * 8);
+        return 1;
+    }
+    const std::streampos firstRecord = is.tellg();
+
+    // Scan the stream once to find the largest buffer read, so a single
+    // scratch allocation can receive the data for all reads.
+    size_t maxReadSize = 0;
+    uint64_t numRecords = 0;
+    {
+        SStreamCaptureRecordHeader header;
+        std::vector<char> payload;
+        while( readRecord(is, header, payload) )
+        {
+            if( header.Type == STREAM_RECORD_ENQUEUE_READ_BUFFER )
+            {
+                CStreamCaptureReader reader(payload.data(), payload.size());
+                reader.get32();     // queue
+                reader.get32();     // mem
+                reader.get32();     // blocking
+                reader.get64();     // offset
+                maxReadSize = std::max(maxReadSize, (size_t)reader.get64());
+            }
+            numRecords++;
+        }
+        is.clear();
+        is.seekg(firstRecord);
+    }
+
+    cl_platform_id platform = NULL;
+    cl_device_id device = NULL;
+    if( !loadOpenCL() || !getPlatformAndDevice(platform, device) )
+    {
+        return 1;
+    }
+    printf("Replaying %llu calls from: %s\n",
+        (unsigned long long)numRecords, fileName.c_str());
+
+    CStreamReplayer replayer(platform, device);
+    replayer.ReadScratch.resize(maxReadSize);
+
+    std::vector<uint64_t> callCounts(STREAM_RECORD_MAX, 0);
+    std::vector<uint64_t> errorCounts(STREAM_RECORD_MAX, 0);
+    uint64_t lastTimeNS = 0;
+
+    using clock = std::chrono::steady_clock;
+    const clock::time_point start = clock::now();
+
+    SStreamCaptureRecordHeader header;
+    std::vector<char> payload;
+    while( readRecord(is, header, payload) )
+    {
+        if( speed > 0 )
+        {
+            std::this_thread::sleep_until(
+                start + std::chrono::nanoseconds((uint64_t)(header.TimeNS / speed)));
+        }
+        lastTimeNS = header.TimeNS;
+
+        CStreamCaptureReader reader(payload.data(), payload.size());
+        cl_int errorCode = replayer.replay(header.Type, reader);
+
+        const uint32_t type = header.Type < STREAM_RECORD_MAX ? header.Type : 0;
+        callCounts[type]++;
+        if( errorCode != CL_SUCCESS )
+        {
+            if( errorCounts[type]++ == 0 )
+            {
+                fprintf(stderr, "clireplay Warning: %s failed (%d).\n",
+                    getRecordName(header.Type), errorCode);
+            }
+        }
+    }
+    replayer.finishAll();
+
+    const double replayMS =
+        std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+    printf("\n");
+    printf("%30s, %10s, %10s\n", "Function Name", "Calls", "Errors");
+    for( uint32_t type = 0; type < STREAM_RECORD_MAX; type++ )
+    {
+        if( callCounts[type] )
+        {
+            printf("%30s, %10llu, %10llu\n",
+                getRecordName(type),
+                (unsigned long long)callCounts[type],
+                (unsigned long long)errorCounts[type]);
+        }
+    }
+    printf("\n");
+    printf("Captured Time (ms): %.3f\n", lastTimeNS / 1000000.0);
+    printf("Replay Time (ms): %.3f\n", replayMS);
+
+    return 0;
+}
@@ -5,12 +5,16 @@
 */
 #pragma once
 
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/time.h>
+#include <dirent.h>
 #include <dlfcn.h>
+#include <fcntl.h>
 #include <libproc.h>
 #include <pthread.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <string.h>
 #include <syslog.h>
 #include <unistd.h>
@@ -19,6 +23,7 @@
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <vector>
 
 void CLIntercept_Load(void);
 
@@ -69,6 +74,29 @@ public:
     void    MakeDumpDirectories(
                 const std::string& fileName ) const;
 
+    void*   MapFileForWriting(
+                const std::string& fileName,
+                size_t size ) const;
+    const void* MapFileForReading(
+                const std::string& fileName,
+                size_t& size ) const;
+    void    UnmapFile(
+                const void* ptr,
+                size_t size ) const;
+
+    bool    GetDirectoryFiles(
+                const std::string& directoryName,
+                std::vector<std::string>& fileNames ) const;
+    bool    GetFileInfo(
+                const std::string& fileName,
+                uint64_t& size,
+                uint64_t& modifiedTime ) const;
+    bool    TouchFile(
+                const std::string& fileName ) const;
+    bool    RenameFile(
+                const std::string& oldFileName,
+                const std::string& newFileName ) const;
+
     bool    GetCLInterceptName(
                 std::string& name ) const;
 
@@ -231,6 +259,140 @@ inline void Services::MakeDumpDirectories(
     }
 }
 
+inline void* Services::MapFileForWriting(
+    const std::string& fileName,
+    size_t size ) const
+{
+    void*   ptr = NULL;
+
+    // Zero-sized files cannot be mapped.
+    if( size == 0 )
+    {
+        return NULL;
+    }
+
+    // The blocks for the file are reserved before it is mapped, so running
+    // out of disk space fails here, and the caller can fall back to writing
+    // the file, rather than raising SIGBUS when the mapping is written.
+    int fd = open( fileName.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0666 );
+    if( fd >= 0 )
+    {
+        fstore_t    store = { F_ALLOCATEALL, F_PEOFPOSMODE, 0, (off_t)size, 0 };
+        if( fcntl( fd, F_PREALLOCATE, &store ) != -1 &&
+            ftruncate( fd, (off_t)size ) == 0 )
+        {
+            ptr = mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+            if( ptr == MAP_FAILED )
+            {
+                ptr = NULL;
+            }
+        }
+        close( fd );
+    }
+
+    return ptr;
+}
+
+inline const void* Services::MapFileForReading(
+    const std::string& fileName,
+    size_t& size ) const
+{
+    void*   ptr = NULL;
+
+    size = 0;
+
+    int fd = open( fileName.c_str(), O_RDONLY );
+    if( fd >= 0 )
+    {
+        struct stat st;
+        if( fstat( fd, &st ) == 0 && st.st_size > 0 )
+        {
+            ptr = mmap( NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+            if( ptr == MAP_FAILED )
+            {
+                ptr = NULL;
+            }
+            else
+            {
+                size = (size_t)st.st_size;
+            }
+        }
+        close( fd );
+    }
+
+    return ptr;
+}
+
+inline void Services::UnmapFile(
+    const void* ptr,
+    size_t size ) const
+{
+    if( ptr )
+    {
+        munmap( (void*)ptr, size );
+    }
+}
+
+inline bool Services::GetDirectoryFiles(
+    const std::string& directoryName,
+    std::vector<std::string>& fileNames ) const
+{
+    fileNames.clear();
+
+    DIR*    dir = opendir( directoryName.c_str() );
+    if( dir == NULL )
+    {
+        return false;
+    }
+
+    struct dirent*  entry = NULL;
+    while( ( entry = readdir( dir ) ) != NULL )
+    {
+        std::string fileName = directoryName + "/" + entry->d_name;
+
+        struct stat st;
+        if( stat( fileName.c_str(), &st ) == 0 && S_ISREG( st.st_mode ) )
+        {
+            fileNames.push_back( entry->d_name );
+        }
+    }
+
+    closedir( dir );
+    return true;
+}
+
+inline bool Services::GetFileInfo(
+    const std::string& fileName,
+    uint64_t& size,
+    uint64_t& modifiedTime ) const
+{
+    struct stat st;
+    if( stat( fileName.c_str(), &st ) != 0 )
+    {
+        return false;
+    }
+
+    size = (uint64_t)st.st_size;
+    modifiedTime =
+        (uint64_t)st.st_mtimespec.tv_sec * 1000000000ULL +
+        (uint64_t)st.st_mtimespec.tv_nsec;
+    return true;
+}
+
+inline bool Services::TouchFile(
+    const std::string& fileName ) const
+{
+    return utimes( fileName.c_str(), NULL ) == 0;
+}
+
+inline bool Services::RenameFile(
+    const std::string& oldFileName,
+    const std::string& newFileName ) const
+{
+    // Note: rename atomically replaces newFileName if it exists.
+    return rename( oldFileName.c_str(), newFileName.c_str() ) == 0;
+}
+
 inline bool Services::GetCLInterceptName(
     std::string& name ) const
 {
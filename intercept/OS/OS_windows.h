@@ -8,6 +8,7 @@
 
 #include <Windows.h>
 #include <string>
+#include <vector>
 #include <stdint.h>
 
 #include "resource/clIntercept_resource.h"
@@ -58,6 +59,29 @@ public:
     void    MakeDumpDirectories(
                 const std::string& fileName ) const;
 
+    void*   MapFileForWriting(
+                const std::string& fileName,
+                size_t size ) const;
+    const void* MapFileForReading(
+                const std::string& fileName,
+                size_t& size ) const;
+    void    UnmapFile(
+                const void* ptr,
+                size_t size ) const;
+
+    bool    GetDirectoryFiles(
+                const std::string& directoryName,
+                std::vector<std::string>& fileNames ) const;
+    bool    GetFileInfo(
+                const std::string& fileName,
+                uint64_t& size,
+                uint64_t& modifiedTime ) const;
+    bool    TouchFile(
+                const std::string& fileName ) const;
+    bool    RenameFile(
+                const std::string& oldFileName,
+                const std::string& newFileName ) const;
+
     bool    GetCLInterceptName(
                 std::string& name ) const;
 
@@ -308,6 +332,189 @@ inline void Services::MakeDumpDirectories(
         pos = fileName.find( "/", ++pos );
     }
 }
+
+inline void* Services::MapFileForWriting(
+    const std::string& fileName,
+    size_t size ) const
+{
+    void*   ptr = NULL;
+
+    // Zero-sized files cannot be mapped.
+    if( size == 0 )
+    {
+        return NULL;
+    }
+
+    HANDLE  hFile = CreateFileA(
+        fileName.c_str(),
+        GENERIC_READ | GENERIC_WRITE,
+        FILE_SHARE_READ,
+        NULL,
+        CREATE_ALWAYS,
+        FILE_ATTRIBUTE_NORMAL,
+        NULL );
+    if( hFile != INVALID_HANDLE_VALUE )
+    {
+        ULARGE_INTEGER  fileSize;
+        fileSize.QuadPart = size;
+
+        HANDLE  hMapping = CreateFileMappingA(
+            hFile,
+            NULL,
+            PAGE_READWRITE,
+            fileSize.HighPart,
+            fileSize.LowPart,
+            NULL );
+        if( hMapping != NULL )
+        {
+            // The view holds a reference to the mapping and the file, so
+            // both handles can be closed immediately.
+            ptr = MapViewOfFile( hMapping, FILE_MAP_WRITE, 0, 0, size );
+            CloseHandle( hMapping );
+        }
+        CloseHandle( hFile );
+    }
+
+    return ptr;
+}
+
+inline const void* Services::MapFileForReading(
+    const std::string& fileName,
+    size_t& size ) const
+{
+    void*   ptr = NULL;
+
+    size = 0;
+
+    HANDLE  hFile = CreateFileA(
+        fileName.c_str(),
+        GENERIC_READ,
+        FILE_SHARE_READ | FILE_SHARE_WRITE,
+        NULL,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL,
+        NULL );
+    if( hFile != INVALID_HANDLE_VALUE )
+    {
+        LARGE_INTEGER   fileSize;
+        if( GetFileSizeEx( hFile, &fileSize ) && fileSize.QuadPart > 0 )
+        {
+            HANDLE  hMapping = CreateFileMappingA(
+                hFile,
+                NULL,
+                PAGE_READONLY,
+                0,
+                0,
+                NULL );
+            if( hMapping != NULL )
+            {
+                ptr = MapViewOfFile( hMapping, FILE_MAP_READ, 0, 0, 0 );
+                if( ptr != NULL )
+                {
+                    size = (size_t)fileSize.QuadPart;
+                }
+                CloseHandle( hMapping );
+            }
+        }
+        CloseHandle( hFile );
+    }
+
+    return ptr;
+}
+
+inline void Services::UnmapFile(
+    const void* ptr,
+    size_t size ) const
+{
+    if( ptr )
+    {
+        UnmapViewOfFile( ptr );
+    }
+}
+
+inline bool Services::GetDirectoryFiles(
+    const std::string& directoryName,
+    std::vector<std::string>& fileNames ) const
+{
+    fileNames.clear();
+
+    std::string pattern = directoryName + "/*";
+
+    WIN32_FIND_DATAA    findData;
+    HANDLE  hFind = FindFirstFileA( pattern.c_str(), &findData );
+    if( hFind == INVALID_HANDLE_VALUE )
+    {
+        return false;
+    }
+
+    do
+    {
+        if( !( findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY ) )
+        {
+            fileNames.push_back( findData.cFileName );
+        }
+    }
+    while( FindNextFileA( hFind, &findData ) );
+
+    FindClose( hFind );
+    return true;
+}
+
+inline bool Services::GetFileInfo(
+    const std::string& fileName,
+    uint64_t& size,
+    uint64_t& modifiedTime ) const
+{
+    WIN32_FILE_ATTRIBUTE_DATA   data;
+    if( !GetFileAttributesExA( fileName.c_str(), GetFileExInfoStandard, &data ) )
+    {
+        return false;
+    }
+
+    size =
+        ( (uint64_t)data.nFileSizeHigh << 32 ) |
+        data.nFileSizeLow;
+    modifiedTime =
+        ( (uint64_t)data.ftLastWriteTime.dwHighDateTime << 32 ) |
+        data.ftLastWriteTime.dwLowDateTime;
+    return true;
+}
+
+inline bool Services::TouchFile(
+    const std::string& fileName ) const
+{
+    HANDLE  hFile = CreateFileA(
+        fileName.c_str(),
+        FILE_WRITE_ATTRIBUTES,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        NULL,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL,
+        NULL );
+    if( hFile == INVALID_HANDLE_VALUE )
+    {
+        return false;
+    }
+
+    FILETIME    now;
+    GetSystemTimeAsFileTime( &now );
+
+    BOOL    success = SetFileTime( hFile, NULL, NULL, &now );
+    CloseHandle( hFile );
+
+    return success != FALSE;
+}
+
+inline bool Services::RenameFile(
+    const std::string& oldFileName,
+    const std::string& newFileName ) const
+{
+    return MoveFileExA(
+        oldFileName.c_str(),
+        newFileName.c_str(),
+        MOVEFILE_REPLACE_EXISTING ) != FALSE;
+}
+
 inline bool Services::GetCLInterceptName(
     std::string& name ) const
 {
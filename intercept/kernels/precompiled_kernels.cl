@@ -31,136 +31,162 @@ __kernel void CopyBufferBytes(
     }
 }
 
-// This is a faster kernel but it only works when the source
-// offset and dst offset are multiples of sizeof(uint).
-//
-// This kernel can work with any local work size.
-// The global work size should be at least ceil( bytesToRead / sizeof(uint) ).
+// Copies the bytes before the first aligned element and after the last
+// aligned element.  There are always fewer than sizeof(element) of each.
 
-__kernel void CopyBufferUInts(
-    const __global uint* pSrc,
-    __global uint* pDst,
-    uint srcOffsetInUInts,
-    uint dstOffsetInUInts,
-    uint bytesToRead )
+void CopyHeadAndTailBytes(
+    const __global uchar* pSrc,
+    __global uchar* pDst,
+    uint headBytes,
+    uint bodyBytes,
+    uint tailBytes )
 {
-    uint    index = get_global_id(0);
-
-    pSrc += srcOffsetInUInts + index;
-    pDst += dstOffsetInUInts + index;
-
-    uint    lastIndex = bytesToRead / sizeof(uint);
-
-    if( index < lastIndex )
+    for( uint i = 0; i < headBytes; i++ )
     {
-        pDst[ 0 ] = pSrc[ 0 ];
+        pDst[ i ] = pSrc[ i ];
     }
-    else
-    {
-        if( index == lastIndex )
-        {
-            const __global uchar*   pByteSrc = pSrc;
-            __global uchar*         pByteDst = pDst;
 
-            uint    bytesRemaining = bytesToRead % sizeof(uint);
+    pSrc += headBytes + bodyBytes;
+    pDst += headBytes + bodyBytes;
 
-            while( bytesRemaining )
-            {
-                pByteDst[ 0 ] = pByteSrc[ 0 ];
-
-                bytesRemaining--;
-                pByteSrc++;
-                pByteDst++;
-            }
-        }
+    for( uint i = 0; i < tailBytes; i++ )
+    {
+        pDst[ i ] = pSrc[ i ];
     }
 }
 
-// This is a faster kernel but it only works when the source
-// offset and dst offset are multiples of sizeof(uint4).
+// These kernels are faster, but they only work when the source and
+// destination have the same alignment relative to sizeof(element).  The
+// bytes up to the first aligned element and after the last aligned element
+// are copied by the first work-item.
 //
-// This kernel can work with any local work size.
-// The global work size should be at least ceil( bytesToRead / sizeof(uint4) ).
+// Each work-item copies multiple elements, spaced by the global work size
+// so adjacent work-items copy adjacent elements.
+//
+// These kernels can work with any local work size and any global work size.
+
+#define DEFINE_COPY_BUFFER_ALIGNED_KERNEL( _name, _type )                   \
+__kernel void _name(                                                        \
+    const __global uchar* pSrc,                                             \
+    __global uchar* pDst,                                                   \
+    uint srcOffsetInBytes,                                                  \
+    uint dstOffsetInBytes,                                                  \
+    uint headBytes,                                                         \
+    uint numElements,                                                       \
+    uint tailBytes )                                                        \
+{                                                                           \
+    pSrc += srcOffsetInBytes;                                               \
+    pDst += dstOffsetInBytes;                                               \
+                                                                            \
+    if( get_global_id(0) == 0 )                                             \
+    {                                                                       \
+        CopyHeadAndTailBytes(                                               \
+            pSrc,                                                           \
+            pDst,                                                           \
+            headBytes,                                                      \
+            numElements * (uint)sizeof(_type),                              \
+            tailBytes );                                                    \
+    }                                                                       \
+                                                                            \
+    const __global _type*   pElementSrc =                                   \
+        (const __global _type*)( pSrc + headBytes );                        \
+    __global _type*         pElementDst =                                   \
+        (__global _type*)( pDst + headBytes );                              \
+                                                                            \
+    for( uint index = get_global_id(0);                                     \
+         index < numElements;                                               \
+         index += get_global_size(0) )                                      \
+    {                                                                       \
+        pElementDst[ index ] = pElementSrc[ index ];                        \
+    }                                                                       \
+}
 
-__kernel void CopyBufferUInt4s(
-    const __global uint4* pSrc,
-    __global uint4* pDst,
-    uint srcOffsetInUInt4s,
-    uint dstOffsetInUInt4s,
-    uint bytesToRead )
-{
-    uint    index = get_global_id(0);
+DEFINE_COPY_BUFFER_ALIGNED_KERNEL( CopyBufferAlignedUInts, uint )
+DEFINE_COPY_BUFFER_ALIGNED_KERNEL( CopyBufferAlignedUInt4s, uint4 )
 
-    pSrc += srcOffsetInUInt4s + index;
-    pDst += dstOffsetInUInt4s + index;
+// This kernel works for any source and destination alignment.  It copies
+// sixteen bytes at a time with vload16 and vstore16, which only require
+// byte alignment.  There is no head, and the tail bytes are copied by the
+// first work-item.
+//
+// This kernel can work with any local work size and any global work size.
 
-    uint    lastIndex = bytesToRead / sizeof(uint4);
+__kernel void CopyBufferUnalignedUChar16s(
+    const __global uchar* pSrc,
+    __global uchar* pDst,
+    uint srcOffsetInBytes,
+    uint dstOffsetInBytes,
+    uint headBytes,
+    uint numElements,
+    uint tailBytes )
+{
+    pSrc += srcOffsetInBytes;
+    pDst += dstOffsetInBytes;
 
-    if( index < lastIndex )
+    if( get_global_id(0) == 0 )
     {
-        pDst[ 0 ] = pSrc[ 0 ];
+        CopyHeadAndTailBytes(
+            pSrc,
+            pDst,
+            headBytes,
+            numElements * 16,
+            tailBytes );
     }
-    else
-    {
-        if( index == lastIndex )
-        {
-            const __global uchar*   pByteSrc = pSrc;
-            __global uchar*         pByteDst = pDst;
 
-            uint    bytesRemaining = bytesToRead % sizeof(uint4);
+    pSrc += headBytes;
+    pDst += headBytes;
 
-            while( bytesRemaining )
-            {
-                pByteDst[ 0 ] = pByteSrc[ 0 ];
-
-                bytesRemaining--;
-                pByteSrc++;
-                pByteDst++;
-            }
-        }
+    for( uint index = get_global_id(0);
+         index < numElements;
+         index += get_global_size(0) )
+    {
+        vstore16( vload16( index, pSrc ), index, pDst );
     }
 }
 
-// This is an experimental kernel.  It only works when the source
-// offset and dst offset are multiples of sizeof(uint16).
+// This kernel copies a rectangular region between two buffers.  Each
+// work-item copies up to sixteen bytes of one row, so get_global_id(0) is a
+// sixteen byte chunk of a row, get_global_id(1) is the row, and
+// get_global_id(2) is the slice.
 //
 // This kernel can work with any local work size.
-// The global work size should be at least ceil( bytesToRead / sizeof(uint16) ).
+// The global work size should be at least
+// { ceil( regionX / 16 ), regionY, regionZ }.
 
-__kernel void CopyBufferUInt16s(
-    const __global uint16* pSrc,
-    __global uint16* pDst,
-    uint srcOffsetInUInt16s,
-    uint dstOffsetInUInt16s,
-    uint bytesToRead )
+__kernel void CopyBufferRect(
+    const __global uchar* pSrc,
+    __global uchar* pDst,
+    uint srcOffsetInBytes,
+    uint srcRowPitch,
+    uint srcSlicePitch,
+    uint dstOffsetInBytes,
+    uint dstRowPitch,
+    uint dstSlicePitch,
+    uint regionX,
+    uint regionY,
+    uint regionZ )
 {
-    uint    index = get_global_id(0);
-
-    pSrc += srcOffsetInUInt16s + index;
-    pDst += dstOffsetInUInt16s + index;
+    uint    chunk = get_global_id(0);
+    uint    y = get_global_id(1);
+    uint    z = get_global_id(2);
 
-    uint    lastIndex = bytesToRead / sizeof(uint16);
+    uint    x = chunk * 16;
 
-    if( index < lastIndex )
+    if( x < regionX && y < regionY && z < regionZ )
     {
-        pDst[ 0 ] = pSrc[ 0 ];
-    }
-    else
-    {
-        if( index == lastIndex )
-        {
-            const __global uchar*   pByteSrc = pSrc;
-            __global uchar*         pByteDst = pDst;
-
-            uint    bytesRemaining = bytesToRead % sizeof(uint16);
+        pSrc += srcOffsetInBytes + z * srcSlicePitch + y * srcRowPitch + x;
+        pDst += dstOffsetInBytes + z * dstSlicePitch + y * dstRowPitch + x;
 
-            while( bytesRemaining )
+        uint    bytesRemaining = regionX - x;
+        if( bytesRemaining >= 16 )
+        {
+            vstore16( vload16( 0, pSrc ), 0, pDst );
+        }
+        else
+        {
+            for( uint i = 0; i < bytesRemaining; i++ )
             {
-                pByteDst[ 0 ] = pByteSrc[ 0 ];
-
-                bytesRemaining--;
-                pByteSrc++;
-                pByteDst++;
+                pDst[ i ] = pSrc[ i ];
             }
         }
     }
@@ -278,4 +304,65 @@ __kernel void CopyImage2Dto2DUInt(
     }
 }
 
+// These kernels copy between 2D and 3D images.  When copying between a 2D
+// image and a 3D image the region depth is one, and the 2D image is copied
+// to or from the slice at the 3D image origin.
+
+#define SRC_COORD_2D    (int2)( x + srcOriginX, y + srcOriginY )
+#define SRC_COORD_3D    (int4)( x + srcOriginX, y + srcOriginY, z + srcOriginZ, 0 )
+#define DST_COORD_2D    (int2)( x + dstOriginX, y + dstOriginY )
+#define DST_COORD_3D    (int4)( x + dstOriginX, y + dstOriginY, z + dstOriginZ, 0 )
+
+#define CHECK_IMAGE_REGION_BOUNDS() if( x < regionX && y < regionY && z < regionZ )
+
+#define DEFINE_COPY_IMAGE_KERNEL( _name, _srcImageType, _dstImageType, _srcCoord, _dstCoord, _colorType, _read, _write ) \
+__kernel void _name(                                                        \
+    __read_only _srcImageType srcImage,                                     \
+    __write_only _dstImageType dstImage,                                    \
+    uint srcOriginX,                                                        \
+    uint srcOriginY,                                                        \
+    uint srcOriginZ,                                                        \
+    uint dstOriginX,                                                        \
+    uint dstOriginY,                                                        \
+    uint dstOriginZ,                                                        \
+    uint regionX,                                                           \
+    uint regionY,                                                           \
+    uint regionZ )                                                          \
+{                                                                           \
+    const sampler_t samplerInline =                                         \
+        CLK_NORMALIZED_COORDS_FALSE |                                       \
+        CLK_ADDRESS_CLAMP_TO_EDGE |                                         \
+        CLK_FILTER_NEAREST;                                                 \
+                                                                            \
+    uint x = get_global_id(0);                                              \
+    uint y = get_global_id(1);                                              \
+    uint z = get_global_id(2);                                              \
+                                                                            \
+    CHECK_IMAGE_REGION_BOUNDS()                                             \
+    {                                                                       \
+        _colorType color = _read( srcImage, samplerInline, _srcCoord );     \
+                                                                            \
+        _write( dstImage, _dstCoord, color );                               \
+    }                                                                       \
+}
+
+#define DEFINE_COPY_IMAGE_KERNELS( _suffix, _srcImageType, _dstImageType, _srcCoord, _dstCoord ) \
+    DEFINE_COPY_IMAGE_KERNEL( CopyImage##_suffix##Float, _srcImageType, _dstImageType, _srcCoord, _dstCoord, float4, read_imagef, write_imagef ) \
+    DEFINE_COPY_IMAGE_KERNEL( CopyImage##_suffix##Int, _srcImageType, _dstImageType, _srcCoord, _dstCoord, int4, read_imagei, write_imagei ) \
+    DEFINE_COPY_IMAGE_KERNEL( CopyImage##_suffix##UInt, _srcImageType, _dstImageType, _srcCoord, _dstCoord, uint4, read_imageui, write_imageui )
+
+DEFINE_COPY_IMAGE_KERNELS( 3Dto2D, image3d_t, image2d_t, SRC_COORD_3D, DST_COORD_2D )
+
+// Writing to a 3D image requires an extension.  If the extension is not
+// supported then these kernels will not exist, and copies to 3D images will
+// not be overridden.
+
+#ifdef cl_khr_3d_image_writes
+#pragma OPENCL EXTENSION cl_khr_3d_image_writes : enable
+
+DEFINE_COPY_IMAGE_KERNELS( 2Dto3D, image2d_t, image3d_t, SRC_COORD_2D, DST_COORD_3D )
+DEFINE_COPY_IMAGE_KERNELS( 3Dto3D, image3d_t, image3d_t, SRC_COORD_3D, DST_COORD_3D )
+
+#endif // cl_khr_3d_image_writes
+
 #endif // __IMAGE_SUPPORT__
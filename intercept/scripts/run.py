@@ -12,6 +12,7 @@ import hashlib
 import struct
 import os
 import argparse
+import fnmatch
 from collections import defaultdict
 
 def get_image_metadata(idx: int):
@@ -33,6 +34,20 @@ def get_image_metadata(idx: int):
     format = cl.ImageFormat(int(lines[7]), int(lines[6]))
     return format, shape
 
+def get_dump_files(subdir, pattern):
+    # Dump files are either stored in the subdirectory, or, when buffers were
+    # deduplicated, listed in a manifest that names the blob holding their
+    # contents in the shared blob store.  Returns (file name, path) pairs.
+    files = {os.path.basename(path): path for path in gl.glob(f"./{subdir}/{pattern}")}
+    manifest = f"./{subdir}/Blobs.txt"
+    if os.path.isfile(manifest):
+        with open(manifest) as file:
+            for line in file:
+                name, blob = line.split()
+                if fnmatch.fnmatch(name, pattern):
+                    files[name] = "../Blobs/" + blob
+    return sorted(files.items())
+
 def sampler_from_string(ctx, sampler_descr):
     normalized = True if "TRUE" in sampler_descr else False
     addressing_mode = cl.addressing_mode.CLAMP_TO_EDGE   if "CLAMP_TO_EDGE" in sampler_descr   else \
@@ -61,11 +76,11 @@ def replay(repetitions):
     buffer_idx = []
     input_buffers = {}
     output_buffers = {}
-    buffer_files = gl.glob("./Pre/Enqueue_" + padded_enqueue_num + "*.bin")
+    buffer_files = get_dump_files("Pre", "Enqueue_" + padded_enqueue_num + "*.bin")
     input_buffer_ptrs = defaultdict(list)
-    for buffer in buffer_files:
-        start = buffer.find("_Arg_")
-        idx = int(re.findall(r'\d+', buffer[start:])[0])
+    for name, buffer in buffer_files:
+        start = name.find("_Arg_")
+        idx = int(re.findall(r'\d+', name[start:])[0])
         buffer_idx.append(idx)
         input_buffers[idx] = np.fromfile(buffer, dtype='uint8').tobytes()
         input_buffer_ptrs[arguments[idx]].append(idx)
@@ -259,11 +274,11 @@ def validate():
     except:
         print("Information about argument data types not available!")
 
-    dumped_buffers = gl.glob("./Post/Enqueue_" + padded_enqueue_num + "_Kernel_*.bin")
+    dumped_buffers = get_dump_files("Post", "Enqueue_" + padded_enqueue_num + "_Kernel_*.bin")
     dumped_hashes = {}
-    for dumped_buffer in dumped_buffers:
-        start = dumped_buffer.find("_Arg_")
-        idx = int(re.findall(r'\d+', dumped_buffer[start:])[0])
+    for name, dumped_buffer in dumped_buffers:
+        start = name.find("_Arg_")
+        idx = int(re.findall(r'\d+', name[start:])[0])
         dumped_hashes[idx] = hashlib.md5(np.fromfile(dumped_buffer)).hexdigest()
 
     dumped_images = gl.glob("./Post/Enqueue_" + padded_enqueue_num + "_Kernel_*.raw")
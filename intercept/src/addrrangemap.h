@@ -0,0 +1,212 @@
+/*
+// Copyright (c) 2025 Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+*/
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include <stddef.h>
+
+// CAddressRangeMap tracks a set of non-overlapping address ranges, such as
+// SVM or USM allocations, and resolves pointers that may point anywhere
+// inside of a range back to the start of the range.
+//
+// Ranges are stored in a flat array sorted by base address so lookups are a
+// binary search over contiguous memory rather than a walk over the nodes of
+// a std::map.  Insertions and removals shift the tail of the array, which is
+// cheap compared to the allocation calls that cause them.  The most recent
+// lookup is cached and validated against a generation counter that changes
+// whenever the set of ranges changes, so repeated lookups of the same range
+// (the common case when setting kernel arguments) skip the search entirely.
+//
+// This class is not thread safe; callers are expected to hold the intercept
+// mutex, the same as for the other allocation tracking maps.  Only the
+// non-const lookups update the cache, so concurrent const lookups are safe
+// if nothing modifies the map.
+
+struct SAddressRangeNoValue
+{
+};
+
+template<class T = SAddressRangeNoValue>
+class CAddressRangeMap
+{
+public:
+    struct SEntry
+    {
+        const void* Base;
+        size_t      Size;
+        T           Value;
+    };
+
+    CAddressRangeMap() :
+        m_Generation(0),
+        m_CachedGeneration(~(size_t)0),
+        m_CachedIndex(0) {}
+
+    bool    empty() const
+    {
+        return m_Entries.empty();
+    }
+
+    size_t  size() const
+    {
+        return m_Entries.size();
+    }
+
+    size_t  generation() const
+    {
+        return m_Generation;
+    }
+
+    // Adds a range starting at base, or replaces the range if there is
+    // already a range starting at base.  Returns the value for the range.
+    T&  insert(
+            const void* base,
+            size_t size )
+    {
+        typename CEntryVector::iterator iter = lowerBound( base );
+        if( iter == m_Entries.end() || iter->Base != base )
+        {
+            SEntry  entry = { base, size, T() };
+            iter = m_Entries.insert( iter, entry );
+        }
+        else
+        {
+            iter->Size = size;
+        }
+        m_Generation++;
+        return iter->Value;
+    }
+
+    // Removes the range starting at base.  Returns true if a range was
+    // removed.
+    bool    erase(
+                const void* base )
+    {
+        typename CEntryVector::iterator iter = lowerBound( base );
+        if( iter != m_Entries.end() && iter->Base == base )
+        {
+            m_Entries.erase( iter );
+            m_Generation++;
+            return true;
+        }
+        return false;
+    }
+
+    // Returns the range starting exactly at base, or NULL if there is no
+    // range starting at base.
+    SEntry* findBase(
+                const void* base )
+    {
+        SEntry* entry = findContaining( base );
+        return ( entry != NULL && entry->Base == base ) ? entry : NULL;
+    }
+
+    const SEntry*   findBase(
+                        const void* base ) const
+    {
+        const SEntry*   entry = findContaining( base );
+        return ( entry != NULL && entry->Base == base ) ? entry : NULL;
+    }
+
+    // Returns the range that contains ptr, or NULL if ptr is not inside of
+    // any range.  This updates the lookup cache.
+    SEntry* findContaining(
+                const void* ptr )
+    {
+        if( m_CachedGeneration == m_Generation &&
+            contains( m_Entries[ m_CachedIndex ], ptr ) )
+        {
+            return &m_Entries[ m_CachedIndex ];
+        }
+
+        size_t  index = search( ptr );
+        if( index == m_Entries.size() )
+        {
+            return NULL;
+        }
+
+        m_CachedGeneration = m_Generation;
+        m_CachedIndex = index;
+        return &m_Entries[ index ];
+    }
+
+    // Returns the range that contains ptr, or NULL if ptr is not inside of
+    // any range.  This does not use or update the lookup cache, so const
+    // lookups do not modify the map.
+    const SEntry*   findContaining(
+                        const void* ptr ) const
+    {
+        size_t  index = search( ptr );
+        return ( index == m_Entries.size() ) ? NULL : &m_Entries[ index ];
+    }
+
+    typedef std::vector<SEntry> CEntryVector;
+    typedef typename CEntryVector::const_iterator const_iterator;
+
+    const_iterator  begin() const
+    {
+        return m_Entries.begin();
+    }
+
+    const_iterator  end() const
+    {
+        return m_Entries.end();
+    }
+
+private:
+    CEntryVector    m_Entries;
+
+    size_t  m_Generation;
+    size_t  m_CachedGeneration;
+    size_t  m_CachedIndex;
+
+    static bool contains(
+                    const SEntry& entry,
+                    const void* ptr )
+    {
+        // A zero-sized range still contains its base address.
+        return ptr == entry.Base ||
+            ( ptr > entry.Base && ptr < (const char*)entry.Base + entry.Size );
+    }
+
+    // Returns the index of the range that contains ptr, or the number of
+    // ranges if ptr is not inside of any range.
+    size_t  search(
+                const void* ptr ) const
+    {
+        // Find the first range that starts after ptr.  The range before it,
+        // if any, is the only range that could contain ptr.
+        const_iterator  iter = std::upper_bound(
+            m_Entries.begin(),
+            m_Entries.end(),
+            ptr,
+            []( const void* p, const SEntry& e ) { return p < e.Base; } );
+        if( iter == m_Entries.begin() )
+        {
+            return m_Entries.size();
+        }
+        --iter;
+
+        if( !contains( *iter, ptr ) )
+        {
+            return m_Entries.size();
+        }
+
+        return iter - m_Entries.begin();
+    }
+
+    typename CEntryVector::iterator lowerBound(
+                                        const void* base )
+    {
+        return std::lower_bound(
+            m_Entries.begin(),
+            m_Entries.end(),
+            base,
+            []( const SEntry& e, const void* p ) { return e.Base < p; } );
+    }
+};
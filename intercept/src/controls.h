@@ -66,6 +66,8 @@ CLI_CONTROL( bool,          DevicePerformanceTimeSuggestedLWSTracking, false, "I
 CLI_CONTROL( bool,          DevicePerformanceTimeTransferTracking,  false, "If set to a nonzero value, the Intercept Layer for OpenCL Applications will distinguish between transfer operations of different sizes for the purpose of device performance timing." )
 CLI_CONTROL( bool,          DevicePerformanceTimingKernelsOnly,     false, "If set to a nonzero value, the Intercept Layer for OpenCL Applications will collect device performance timing for kernel commands only" )
 CLI_CONTROL( bool,          DevicePerformanceTimingSkipUnmap,       false, "If set to a nonzero value, the Intercept Layer for OpenCL Applications will skip device performance timing for unmap operations.  This is a workaround for a bug in some OpenCL implementations, where querying events created from unmap operations results in driver crashes." )
+CLI_CONTROL( bool,          ProgramBuildTiming,                     false, "If set to a nonzero value, the Intercept Layer for OpenCL Applications will track the host time spent in the OpenCL implementation for each call to clBuildProgram(), clCompileProgram(), and clLinkProgram(), for each unique program hash, build options hash, and set of devices.  A call that builds a program for multiple devices is counted once.  When the process exits, this information will be included in the file \"clIntercept_report.txt\", along with the program source size, the number of kernels in the program, and the number of times the same program was rebuilt with the same build options.  Rebuilds are candidates for the program binary cache." )
+CLI_CONTROL( bool,          RedundantWorkChecking,                  false, "If set to a nonzero value, the Intercept Layer for OpenCL Applications will detect redundant work, such as creating the same program, building the same program with the same build options, or creating the same kernel, after an identical object was released.  Objects that are created multiple times because they are alive at the same time are not counted as redundant.  When the process exits, the redundant work will be included in the file \"clIntercept_report.txt\", ranked by the estimated wasted host time.  The wasted host time is only estimated if HostPerformanceTiming is also enabled." )
 CLI_CONTROL( cl_uint,       HostPerformanceTimingMinEnqueue,        0,     "The Intercept Layer for OpenCL Applications will only collect host performance timing metrics when the enqueue counter is greater than this value, inclusive." )
 CLI_CONTROL( cl_uint,       HostPerformanceTimingMaxEnqueue,        UINT_MAX, "The Intercept Layer for OpenCL Applications will only collect host performance timing metrics when the enqueue counter is less than this value, inclusive." )
 CLI_CONTROL( cl_uint,       DevicePerformanceTimingMinEnqueue,      0,     "The Intercept Layer for OpenCL Applications will only collect device performance timing metrics when the enqueue counter is greater than this value, inclusive." )
@@ -103,18 +105,31 @@ CLI_CONTROL( bool,          InjectProgramBinaries,                  false, "If s
 CLI_CONTROL( bool,          RejectProgramBinaries,                  false, "If set to a nonzero value, the Intercept Layer for OpenCL Applications will reject kernel binaries passed via clCreateProgramWithBinary() and return CL_INVALID_BINARY.  This can be used to force an application to re-compile program binaries from source." )
 CLI_CONTROL( bool,          InjectProgramSPIRV,                     false, "If set to a nonzero value, the Intercept Layer for OpenCL Applications will look to inject potentially modified kernel SPIR-V binaries via clCreateProgramWithIL() in place of program text for each call to clCreateProgramWithSource()." )
 CLI_CONTROL( bool,          PrependProgramSource,                   false, "If set to a nonzero value, the Intercept Layer for OpenCL Applications will look to prepend kernel code from a file to the application provided kernel source passed to clCreateProgramWithSource().  The Intercept Layer for OpenCL Applications will look for kernel source to prepend in the dump and log directory.  The files that are searched for are (in order) \"CLI_<Program Number>_<Unique Program Hash Code>_prepend.cl\", \"CLI_<Unique Program Hash Code>_prepend.cl\", and \"CLI_prepend.cl\"." )
+CLI_CONTROL( cl_uint,       InjectionFileIndexRefreshMS,            0,     "The Intercept Layer for OpenCL Applications builds an index of the files in the Inject directory the first time it looks for a program source, SPIR-V, binary, or options file to inject, and then uses the index to check if injection files exist.  If set to a nonzero value, the index will be rebuilt if it is older than this many milliseconds, so injection files that are added while the application is running will be found.  If set to zero, the index is never rebuilt." )
+CLI_CONTROL( bool,          InjectProgramHotReload,                 false, "If set to a nonzero value, the Intercept Layer for OpenCL Applications will watch the Inject directory for program source files that are added or modified after a program is built with clBuildProgram().  The files that are searched for are \"CLI_<Program Number>_<Unique Program Hash Code>_source.cl\" and \"CLI_<Unique Program Hash Code>_source.cl\".  When a file changes, the program is rebuilt from the file in the background with the same build options, and subsequent calls to clEnqueueNDRangeKernel() for kernels from the original program enqueue the kernel with the same name from the rebuilt program instead, with the kernel arguments and kernel exec info most recently set for the original kernel.  If the rebuilt program fails to build, does not contain the kernel, or the kernel arguments or kernel exec info cannot be set, the original kernel is enqueued.  Kernel exec info that is emulated, such as indirect USM access when emulating cl_intel_unified_shared_memory, cannot be set for the rebuilt kernel.  This can be used to tune kernels in a long-running application without restarting it." )
+CLI_CONTROL( cl_uint,       InjectProgramHotReloadIntervalMS,       1000,  "If InjectProgramHotReload is enabled, the Intercept Layer for OpenCL Applications will check for modified program source files at most this often, in milliseconds.  Checks are made from a background thread and are triggered by calls to clEnqueueNDRangeKernel()." )
 CLI_CONTROL( std::string,   AppendBuildOptions,                     "",    "If set, the Intercept Layer for OpenCL Applications will add these build options to the end of any application provided or injected build options for each call to clCompileProgram or clBuildProgram()." )
 CLI_CONTROL( std::string,   AppendLinkOptions,                      "",    "If set, the Intercept Layer for OpenCL Applications will add these build options to the end of any application provided or injected build options for each call to clLinkProgram()." )
 CLI_CONTROL( bool,          DumpProgramBuildLogs,                   false, "If set to a nonzero value, the Intercept Layer for OpenCL Applications will dump build logs for every device a program is built for to a separate file.  The file name will have the form \"CLI_<Program Number>_<Unique Program Hash Code>_<Compile Count>_<Unique Build Options Hash Code>_<Device Type>_build_log.txt\"." )
-CLI_CONTROL( bool,          DumpKernelISABinaries,                  false, "If set to a nonzero value, the Intercept Layer for OpenCL Applications will dump kernel ISA binaries for every kernel, if supported.  Currently, kernel ISA binaries are only supported for Intel GPU devices.  Kernel ISA binaries can be decoded into ISA text with a disassembler.  The file name will have the form \"CLI_<Program Number>_<Unique Program Hash Code>_<Compile Count>_<Unique Build Options Hash Code>_<Device Type>_<Kernel Name>.isabin\"." )
+CLI_CONTROL( bool,          DumpKernelISABinaries,                  false, "If set to a nonzero value, the Intercept Layer for OpenCL Applications will dump kernel ISA binaries for every kernel, if supported.  Currently, kernel ISA binaries are only supported for Intel GPU devices.  Kernel ISA binaries can be decoded into ISA text with a disassembler.  The file name will have the form \"CLI_<Program Number>_<Unique Program Hash Code>_<Compile Count>_<Unique Build Options Hash Code>_<Device Type>_<Kernel Name>.isabin\".  Each unique kernel ISA binary is only written once, and kernel ISA binaries are not queried again when the same program is rebuilt with the same build options for the same device.  The file \"CLI_kernel_isa_manifest.txt\" maps each program build and kernel to its kernel ISA binary file." )
+CLI_CONTROL( bool,          AsyncProgramDumping,                    false, "If set to a nonzero value, the Intercept Layer for OpenCL Applications will write dumped program source, program binaries, kernel ISA binaries, and program build logs from a background thread, rather than from the application thread that created or built the program.  The program binaries, kernel ISA binaries, and build logs are still retrieved from the program by the calling thread, and only the files are written from the background thread, so this only reduces the time spent writing the dump files in program creation and build calls.  Dumps that are still queued when the application exits are written before the Intercept Layer for OpenCL Applications is unloaded, except on Windows, where they are not written.  Program source is still dumped synchronously when AutoCreateSPIRV is enabled, since it is needed to create the SPIR-V module." )
+CLI_CONTROL( bool,          ProgramBinaryCache,                     false, "If set to a nonzero value, the Intercept Layer for OpenCL Applications will cache device binaries for programs created with clCreateProgramWithSource() and successfully built with clBuildProgram().  When a program with the same source is built with the same build options for the same devices and driver versions, a program is created from the cached binaries via clCreateProgramWithBinary() and built instead, which can significantly reduce build time.  Cached binaries are identified by the hash of the program source passed to the driver, including any injected or prepended program source, the build options hash, and the names and versions of the devices.  Programs created from injected program binaries or SPIR-V are not cached.  The application's program is still created from source, so it may be queried for its source as usual, but kernels, build queries, and program binary and kernel ISA dumps for the application's program use the program created from the cached binaries, and CL_KERNEL_PROGRAM returns the application's program.  If the application's program is compiled with clCompileProgram(), the program created from the cached binaries is no longer used.  The cache may be shared by multiple processes." )
+CLI_CONTROL( std::string,   ProgramBinaryCacheDir,                  "",    "If set, the Intercept Layer for OpenCL Applications will store cached program binaries in this directory.  By default, cached program binaries are stored in the directory \"ProgramBinaryCache\" in the dump directory, without the process ID if AppendPid is set.  This control is ignored unless ProgramBinaryCache or CacheKernelOverrideBinaries is enabled." )
+CLI_CONTROL( cl_uint,       ProgramBinaryCacheMaxSizeMB,            1024,  "The maximum size of the program binary cache, in megabytes.  When the cache grows larger than this size, the least recently used cached program binaries are removed.  If set to zero, the size of the cache is unlimited.  This control is ignored unless ProgramBinaryCache or CacheKernelOverrideBinaries is enabled." )
 
 CLI_CONTROL_SEPARATOR( Controls for Emulating Features: )
 CLI_CONTROL( bool,          Emulate_cl_khr_extended_versioning,     false, "If set to a nonzero value, the Intercept Layer for OpenCL Applications will emulate support for the cl_khr_extended_versioning extension." )
-CLI_CONTROL( bool,          Emulate_cl_khr_semaphore,               false, "If set to a nonzero value, the Intercept Layer for OpenCL Applications will emulate support for the cl_khr_semaphore extension." )
-CLI_CONTROL( bool,          Emulate_cl_intel_unified_shared_memory, false, "If set to a nonzero value, the Intercept Layer for OpenCL Applications will emulate support for the cl_intel_unified_shared_memory extension USM APIs using SVM APIs.  This can be useful to test USM applications on an implementation that supports SVM, but not USM." )
+CLI_CONTROL( bool,          Emulate_cl_khr_semaphore,               false, "If set to a nonzero value, the Intercept Layer for OpenCL Applications will emulate support for the cl_khr_semaphore extension.  Binary semaphores are emulated with markers, events, and user events: a wait that is enqueued after its signal waits for the signal's event, and a wait that is enqueued before its signal waits for a user event that is completed by an event callback when the signal completes, so the host thread never blocks.  The semabench benchmark, which is built when ENABLE_BENCHMARKS is set, can be used to compare the emulated extension with a native implementation." )
+CLI_CONTROL( bool,          Emulate_cl_intel_unified_shared_memory, false, "If set to a nonzero value, the Intercept Layer for OpenCL Applications will emulate support for the cl_intel_unified_shared_memory extension USM APIs using SVM APIs.  This can be useful to test USM applications on an implementation that supports SVM, but not USM.  Migrations requested with clEnqueueMigrateMemINTEL() are passed to clEnqueueSVMMigrateMem() on OpenCL 2.1 and newer devices.  Memory advice has no SVM equivalent.  Migrations and memory advice are summarized in the report." )
+CLI_CONTROL( bool,          EmulatedUSMPool,                        false, "If set to a nonzero value, the Intercept Layer for OpenCL Applications will suballocate small emulated USM allocations from large SVM slabs, rather than calling clSVMAlloc() and clSVMFree() for each allocation.  Allocations are rounded up to a power of two size class, and freed allocations are reused by later allocations of the same size class.  This can significantly improve the performance of applications that frequently allocate and free small USM allocations.  Pool statistics are included in the report.  Slabs are freed when the application releases its last reference to their context, if none of the pooled allocations from the context are still in use.  This control is ignored unless Emulate_cl_intel_unified_shared_memory is enabled." )
+CLI_CONTROL( cl_uint,       EmulatedUSMPoolSlabSizeMB,              16,    "The size, in megabytes, of each SVM slab allocated for the emulated USM pool.  This control is ignored unless EmulatedUSMPool is enabled." )
+CLI_CONTROL( cl_uint,       EmulatedUSMPoolMaxAllocSizeKB,          1024,  "Emulated USM allocations larger than this size, in kilobytes, or larger than EmulatedUSMPoolSlabSizeMB, are not suballocated from the emulated USM pool.  This control is ignored unless EmulatedUSMPool is enabled." )
 
 CLI_CONTROL_SEPARATOR( Controls for Automatically Creating SPIR-V Modules: )
 CLI_CONTROL( bool,          AutoCreateSPIRV,                        false,       "If set to a nonzero value, the Intercept Layer for OpenCL Applications will automatically create SPIR-V modules by invoking CLANG each time a program is built.  The file name will have the form \"CLI_<Program Number>_<Unique Program Hash Code>_<Compile Count>_<Unique Build Options Hash Code>.spv\".  Because invoking CLANG requires a file containing the OpenCL C source, setting this option implicitly sets DumpProgramSource as well.  Additionally, this feature is not available for injected program source." )
+CLI_CONTROL( cl_uint,       AutoCreateSPIRVJobs,                    0,           "The maximum number of SPIR-V modules the Intercept Layer for OpenCL Applications will create concurrently when AutoCreateSPIRV is enabled.  If set to a nonzero value, SPIR-V modules are created by a pool of background threads, so program builds do not wait for CLANG.  If set to zero, SPIR-V modules are created synchronously, when each program is built.  Regardless of this setting, a SPIR-V module is created only once for each unique combination of program source and compile options; additional programs with the same source and options receive a copy of the module.  SPIR-V modules that are still queued when the application exits are not created." )
+CLI_CONTROL( bool,          AutoCreateSPIRVCache,                   false,       "If set to a nonzero value, the Intercept Layer for OpenCL Applications will save SPIR-V modules created by AutoCreateSPIRV to a cache directory, keyed by a hash of the program source and a hash of the compile options.  Subsequent runs, or other processes, copy modules from the cache instead of invoking CLANG again." )
+CLI_CONTROL( std::string,   AutoCreateSPIRVCacheDir,                "",          "If set, the Intercept Layer for OpenCL Applications will store cached SPIR-V modules in this directory.  If not set, SPIR-V modules are cached in a \"SPIRVCache\" subdirectory of the dump directory.  The dump directory name does not include the process ID, so the cache is shared between processes." )
 CLI_CONTROL( std::string,   SPIRVClang,                             "clang",     "The clang executable used to compile an OpenCL C program to a SPIR-V module.  This can be an executable in the system path, a relative path, or a full absolute path." )
 CLI_CONTROL( std::string,   SPIRVCLHeader,                          "opencl.h",  "The OpenCL header file used to compile an OpenCL C program to a SPIR-V module.  This must be a relative path or a full absolute path." )
 CLI_CONTROL( std::string,   SPIRVDis,                               "spirv-dis", "The spirv-dis executable used to optionally disassemble the compiled SPIR-V module to a SPIR-V text representation.  This can be an executable in the system path, a relative path, or a full absolute path." )
@@ -159,9 +174,17 @@ CLI_CONTROL( bool,          CaptureReplay,                          false, "This
 CLI_CONTROL( cl_uint,       CaptureReplayMinEnqueue,                0,     "The Intercept Layer for OpenCL Applications will only enable kernel capture and replay when the enqueue counter is greater than this value, inclusive." )
 CLI_CONTROL( cl_uint,       CaptureReplayMaxEnqueue,                UINT_MAX, "The Intercept Layer for OpenCL Applications will stop kernel capture and replay when the encounter is greater than this value, meaning that only enqueues less than this value, inclusive, will be captured." )
 CLI_CONTROL( std::string,   CaptureReplayKernelName,                "",     "If set, the Intercept Layer for OpenCL Applications will only enable kernel capture and replay when the kernel name equals this name.")
+CLI_CONTROL( std::string,   CaptureReplayProgramHash,               "",     "If set, the Intercept Layer for OpenCL Applications will only enable kernel capture and replay when the hash of the kernel's program equals this value.  The hash should be eight hexadecimal digits, as it appears in dumped program file names and in kernel names when KernelNameHashTracking is set." )
+CLI_CONTROL( std::string,   CaptureReplayKernelGWS,                 "",     "If set, the Intercept Layer for OpenCL Applications will only enable kernel capture and replay when the NDRange global work size matches this string.  The string should have the form \"XxYxZ\".  The wildcard \"*\" matches all global work sizes." )
+CLI_CONTROL( std::string,   CaptureReplayKernelLWS,                 "",     "If set, the Intercept Layer for OpenCL Applications will only enable kernel capture and replay when the NDRange local work size matches this string.  The string should have the form \"XxYxZ\".  The wildcard \"*\" matches all local work sizes, and the string \"NULL\" matches a NULL local work size." )
+CLI_CONTROL( cl_uint,       CaptureReplayStartTime,                 0,      "The Intercept Layer for OpenCL Applications will only enable kernel capture and replay when at least this many seconds have elapsed since it was loaded." )
+CLI_CONTROL( cl_uint,       CaptureReplayEndTime,                   UINT_MAX, "The Intercept Layer for OpenCL Applications will stop kernel capture and replay when more than this many seconds have elapsed since it was loaded." )
+CLI_CONTROL( cl_uint,       CaptureReplayMinDeviceTimeUS,           0,      "If set to a nonzero value, the Intercept Layer for OpenCL Applications will measure the device execution time of kernel enqueues that match the other kernel capture and replay controls, and will only capture a kernel enqueue after a matching kernel enqueue takes at least this many microseconds.  The next matching kernel enqueue is then captured.  This is useful to capture rare slow kernel executions in long-running applications.  Device execution times are measured using profiling events, so profiling is enabled for all command queues when this control is set." )
 CLI_CONTROL( bool,          CaptureReplayUniqueKernels,             false,  "If set, the Intercept Layer for OpenCL Applications will only enable kernel capture and replay if the kernel signature (i.e. hash + kernelname) has not been seen already." )
 CLI_CONTROL( cl_uint,       CaptureReplayNumKernelEnqueuesSkip,     0,      "The Intercept Layer for OpenCL Applications will skip this many kernel enqueues before enabling kernel capture and replay.")
 CLI_CONTROL( cl_uint,       CaptureReplayNumKernelEnqueuesCapture,  UINT_MAX, "The Intercept Layer for OpenCL Applications will only capture this many kernel enqueues.")
+CLI_CONTROL( bool,          CaptureReplayDeduplicateBuffers,        false,  "If set to a nonzero value, the Intercept Layer for OpenCL Applications will write the contents of buffer, SVM, and USM kernel arguments for kernel capture and replay to a shared content-addressed store in the \"Blobs\" subdirectory of the \"Replay\" directory, so identical contents captured by different kernel enqueues are only written once.  Instead of a full copy of each buffer, the \"Pre\" and \"Post\" directories for each captured enqueue contain a \"Blobs.txt\" manifest that maps each dump file name to its blob.  clireplay and the generated replay script read these manifests." )
+CLI_CONTROL( bool,          CaptureStream,                          false, "If set to a nonzero value, the Intercept Layer for OpenCL Applications will record the OpenCL call stream, including context, command queue, buffer, program, and kernel creation, kernel arguments, kernel enqueues, buffer transfers and maps, synchronization, and object retains and releases, to the binary file \"CLI_stream_capture.bin\" in the \"Replay\" subdirectory of the dump directory.  Buffer contents are recorded when buffers are created from host memory and whenever the host writes to a buffer.  The stream capture can be replayed without the application using clireplay.  Images, samplers, SVM, USM, and sub-buffers are not recorded, nor are clCompileProgram, clLinkProgram, clCloneKernel, and the rectangular buffer enqueues." )
 
 CLI_CONTROL_SEPARATOR( AubCapture Controls: )
 CLI_CONTROL( bool,          AubCapture,                             false, "This is the top-level control for aub capture.  The Intercept Layer for OpenCL Applications doesn't implement aub capture itself, but can be used to selectively enable and disable aub capture via other methods." )
@@ -193,7 +216,15 @@ CLI_CONTROL( bool,          NullLocalWorkSize,                      false, "If s
 CLI_CONTROL( size_t,        NullLocalWorkSizeX,                     0,     "If set to a nonzero value, the Intercept Layer for OpenCL Applications will set the local work size that will be used if an application passes NULL as the local work size to clEnqueueNDRangeKernel().  1D dispatches will only look at NullLocalWorkSizeX, 2D dispatches will only look at NullLocalWorkSizeX and NullLocalWorkSizeY, while 3D dispatches will look at NullLocalWorkSizeX, NullLocalWorkSizeY, and NullLocalWorkSizeZ.  If the specified values for NullLocalWorkSize do not evenly divide the global work size then the specified values of NullLocalWorkSize will not take effect." )
 CLI_CONTROL( size_t,        NullLocalWorkSizeY,                     0,     "If set to a nonzero value, the Intercept Layer for OpenCL Applications will set the local work size that will be used if an application passes NULL as the local work size to clEnqueueNDRangeKernel().  1D dispatches will only look at NullLocalWorkSizeX, 2D dispatches will only look at NullLocalWorkSizeX and NullLocalWorkSizeY, while 3D dispatches will look at NullLocalWorkSizeX, NullLocalWorkSizeY, and NullLocalWorkSizeZ.  If the specified values for NullLocalWorkSize do not evenly divide the global work size then the specified values of NullLocalWorkSize will not take effect." )
 CLI_CONTROL( size_t,        NullLocalWorkSizeZ,                     0,     "If set to a nonzero value, the Intercept Layer for OpenCL Applications will set the local work size that will be used if an application passes NULL as the local work size to clEnqueueNDRangeKernel().  1D dispatches will only look at NullLocalWorkSizeX, 2D dispatches will only look at NullLocalWorkSizeX and NullLocalWorkSizeY, while 3D dispatches will look at NullLocalWorkSizeX, NullLocalWorkSizeY, and NullLocalWorkSizeZ.  If the specified values for NullLocalWorkSize do not evenly divide the global work size then the specified values of NullLocalWorkSize will not take effect." )
+CLI_CONTROL( bool,          LocalWorkSizeAutotuning,                false, "If set to a nonzero value, the Intercept Layer for OpenCL Applications will automatically tune the local work size for calls to clEnqueueNDRangeKernel() that pass a NULL local work size.  For each device, kernel, and global work size, the first enqueues try a set of candidate local work sizes that evenly divide the global work size, including the local work size chosen by the OpenCL implementation, and time them using device profiling events.  The fastest local work size is then used for all subsequent enqueues, and is saved to a tuning database file so it is used automatically in later runs.  Command queues are created with profiling enabled when this control is set.  Kernels with a required work group size are not tuned.  Note that this control takes effect after NullLocalWorkSize and NullLocalWorkSizeX / NullLocalWorkSizeY / NullLocalWorkSizeZ." )
+CLI_CONTROL( cl_uint,       LocalWorkSizeAutotuningIterations,      3,     "The number of times each candidate local work size is timed when LocalWorkSizeAutotuning is enabled.  The minimum time for each candidate is compared." )
+CLI_CONTROL( cl_uint,       LocalWorkSizeAutotuningMaxCandidates,   16,    "The maximum number of candidate local work sizes that are tried for each device, kernel, and global work size when LocalWorkSizeAutotuning is enabled." )
+CLI_CONTROL( bool,          LocalWorkSizeAutotuningOverrideApp,     false, "If set to a nonzero value and LocalWorkSizeAutotuning is enabled, local work sizes specified by the application are tuned also, instead of only NULL local work sizes.  The application's local work size is one of the candidates.  This may produce incorrect results for kernels that assume a specific local work size, for example to size local memory arrays." )
+CLI_CONTROL( std::string,   LocalWorkSizeAutotuningFile,            "",    "If set, the Intercept Layer for OpenCL Applications will read and write local work size tuning results to this file when LocalWorkSizeAutotuning is enabled.  By default, tuning results are stored in the file \"CLI_lws_tuning.txt\" in the dump directory, without the process ID if AppendPid is set.  Each line of the file contains the device name, kernel name, program hash, build options hash, work dimension, global work size, and tuned local work size, separated by tabs, and may be edited by hand." )
 CLI_CONTROL( bool,          InitializeBuffers,                      false, "If set to a nonzero value, the Intercept Layer for OpenCL Applications will initialize the contents of allocated buffers with zero.  Only valid for non-COPY_HOST_PTR and non-USE_HOST_PTR allocations." )
+CLI_CONTROL( cl_uint,       InitializeBuffersPattern,               0,     "Selects the pattern used to initialize buffers when InitializeBuffers is enabled.  0 initializes buffers with zero.  1 sets every bit, which is a NaN for floating-point data and can help to find reads of uninitialized memory.  2 stores incrementing 32-bit values, which identify the offset of each value in the buffer.  3 stores pseudo-random values generated from InitializeBuffersSeed and the order that buffers are created, so results are reproducible between runs." )
+CLI_CONTROL( cl_uint,       InitializeBuffersSeed,                  0,     "The seed used to generate pseudo-random buffer contents when InitializeBuffersPattern is 3." )
+CLI_CONTROL( cl_uint,       InitializeBuffersThreadThresholdMB,     16,    "Buffers at least this many megabytes will be initialized using multiple host threads when InitializeBuffers is enabled and InitializeBuffersPattern is nonzero.  The default zero pattern uses zero pages from the OS and never starts any threads.  If set to zero, buffers will always be initialized by the thread that creates the buffer." )
 CLI_CONTROL( cl_uint,       DefaultQueuePriorityHint,               0,     "If set to a nonzero value, and if no other priority hint is specified by the application, the Intercept Layer for OpencL Applications will attempt to create a command queue with this priority hint value.  Note: HIGH priority is 1, MED priority is 2, and LOW priority is 4." )
 CLI_CONTROL( cl_uint,       DefaultQueueThrottleHint,               0,     "If set to a nonzero value, and if no other throttle hint is specified by the application, the Intercept Layer for OpencL Applications will attempt to create a command queue with this throttle hint value.  Note: HIGH throttle is 1, MED throttle is 2, and LOW throttle is 4." )
 CLI_CONTROL( bool,          RelaxAllocationLimits,                  false, "If set to a nonzero value, the Intercept Layer for OpenCL Applications will attempt to relax allocation limits to enable allocations larger than CL_DEVICE_MAX_MEM_ALLOC_SIZE." )
@@ -229,7 +260,10 @@ CLI_CONTROL( bool,          ForceByteBufferOverrides,               false, "If s
 CLI_CONTROL( bool,          OverrideReadBuffer,                     false, "If set to a nonzero value, the Intercept Layer for OpenCL Applications will use a kernel to implement clEnqueueReadBuffer() instead of the implementation's clEnqueueReadBuffer().  Note: Requires OpenCL 1.1 or the \"byte addressable store\" extension." )
 CLI_CONTROL( bool,          OverrideWriteBuffer,                    false, "If set to a nonzero value, the Intercept Layer for OpenCL Applications will use a kernel to implement clEnqueueWriteBuffer() instead of the implementation's clEnqueueWriteBuffer().  Note: Requires OpenCL 1.1 or the \"byte addressable store\" extension." )
 CLI_CONTROL( bool,          OverrideCopyBuffer,                     false, "If set to a nonzero value, the Intercept Layer for OpenCL Applications will use a kernel to implement clEnqueueCopyBuffer() instead of the implementation's clEnqueueCopyBuffer().  Note: Requires OpenCL 1.1 or the \"byte addressable store\" extension." )
-CLI_CONTROL( bool,          OverrideReadImage,                      false, "If set to a nonzero value, the Intercept Layer for OpenCL Applications will use a kernel to implement clEnqueueReadImage() instead of the implementation's clEnqueueReadImage().  Only 2D images are currently supported." )
-CLI_CONTROL( bool,          OverrideWriteImage,                     false, "If set to a nonzero value, the Intercept Layer for OpenCL Applications will use a kernel to implement clEnqueueWriteImage() instead of the implementation's clEnqueueWriteImage().  Only 2D images are currently supported." )
-CLI_CONTROL( bool,          OverrideCopyImage,                      false, "If set to a nonzero value, the Intercept Layer for OpenCL Applications will use a kernel to implement clEnqueueCopyImage() instead of the implementation's clEnqueueCopyImage().  Only 2D images are currently supported." )
+CLI_CONTROL( bool,          OverrideCopyBufferRect,                 false, "If set to a nonzero value, the Intercept Layer for OpenCL Applications will use a kernel to implement clEnqueueCopyBufferRect() instead of the implementation's clEnqueueCopyBufferRect().  Note: Requires OpenCL 1.1 or the \"byte addressable store\" extension." )
+CLI_CONTROL( bool,          OverrideBufferBenchmark,                false, "If set to a nonzero value and any of the buffer override controls are set, the Intercept Layer for OpenCL Applications will time its copy buffer kernels against the implementation's clEnqueueCopyBuffer() for several copy sizes when the override kernels are built.  The results will be logged, and the implementation's clEnqueueCopyBuffer() will be used instead of the override kernels for copy sizes where it was faster.  The override kernels are built, and the benchmark is run, before the first overridden enqueue for each context and device, and are not included in that enqueue's host or device timing, but other threads calling into the Intercept Layer for OpenCL Applications will wait for them." )
+CLI_CONTROL( bool,          OverrideReadImage,                      false, "If set to a nonzero value, the Intercept Layer for OpenCL Applications will use a kernel to implement clEnqueueReadImage() instead of the implementation's clEnqueueReadImage().  2D and 3D images are supported.  Note: Reading a region with a depth greater than one requires the \"3D image writes\" extension." )
+CLI_CONTROL( bool,          OverrideWriteImage,                     false, "If set to a nonzero value, the Intercept Layer for OpenCL Applications will use a kernel to implement clEnqueueWriteImage() instead of the implementation's clEnqueueWriteImage().  2D and 3D images are supported.  Note: Writing to 3D images requires the \"3D image writes\" extension." )
+CLI_CONTROL( bool,          OverrideCopyImage,                      false, "If set to a nonzero value, the Intercept Layer for OpenCL Applications will use a kernel to implement clEnqueueCopyImage() instead of the implementation's clEnqueueCopyImage().  2D and 3D images are supported.  Note: Copying to 3D images requires the \"3D image writes\" extension." )
 CLI_CONTROL( bool,          OverrideBuiltinKernels,                 false, "If set to a nonzero value, the Intercept Layer for OpenCL Applications will use its own version of the built-in OpenCL kernels that may be accessed via clCreateProgramWithBuiltInKernels(). At present, only the VME block_motion_estimate_intel kernel is implemented." )
+CLI_CONTROL( bool,          CacheKernelOverrideBinaries,            true,  "If set to a nonzero value, the device binaries for the precompiled and builtin kernel override programs will be cached, so subsequent runs can create the override programs from the cached binaries instead of compiling them.  The override programs are compiled the first time they are needed for each device, not when a context is created.  Cached binaries are stored in the program binary cache directory; see ProgramBinaryCacheDir." )
@@ -482,15 +482,19 @@ CL_API_ENTRY cl_context CL_API_CALL CLIRN(clCreateContext)(
 
         ITT_ADD_PARAM_AS_METADATA( retVal );
 
-        INIT_PRECOMPILED_KERNEL_OVERRIDES( retVal );
-        INIT_BUILTIN_KERNEL_OVERRIDES( retVal );
-
         HOST_PERFORMANCE_TIMING_END();
         CREATE_CONTEXT_OVERRIDE_CLEANUP( retVal, newProperties );
         CHECK_ERROR( errcode_ret[0] );
         ADD_OBJECT_ALLOCATION( retVal );
+        STREAM_CAPTURE_CREATE_CONTEXT( retVal );
         CALL_LOGGING_EXIT( errcode_ret[0], "returned %p", retVal );
 
+        if( pIntercept->config().Emulate_cl_intel_unified_shared_memory &&
+            retVal != NULL )
+        {
+            pIntercept->emulatedInitUSMContext( retVal );
+        }
+
 #ifdef __ANDROID__
         mContextCount.lock();
         contextCount ++;
@@ -558,15 +562,19 @@ CL_API_ENTRY cl_context CL_API_CALL CLIRN(clCreateContextFromType)(
 
         ITT_ADD_PARAM_AS_METADATA( retVal );
 
-        INIT_PRECOMPILED_KERNEL_OVERRIDES( retVal );
-        INIT_BUILTIN_KERNEL_OVERRIDES( retVal );
-
         HOST_PERFORMANCE_TIMING_END();
         CREATE_CONTEXT_OVERRIDE_CLEANUP( retVal, newProperties );
         CHECK_ERROR( errcode_ret[0] );
         ADD_OBJECT_ALLOCATION( retVal );
+        STREAM_CAPTURE_CREATE_CONTEXT( retVal );
         CALL_LOGGING_EXIT( errcode_ret[0], "returned %p", retVal );
 
+        if( pIntercept->config().Emulate_cl_intel_unified_shared_memory &&
+            retVal != NULL )
+        {
+            pIntercept->emulatedInitUSMContext( retVal );
+        }
+
 #ifdef __ANDROID__
         mContextCount.lock();
         contextCount ++;
@@ -603,6 +611,7 @@ CL_API_ENTRY cl_int CL_API_CALL CLIRN(clRetainContext)(
         HOST_PERFORMANCE_TIMING_END();
         CHECK_ERROR( retVal );
         ADD_OBJECT_RETAIN( context );
+        STREAM_CAPTURE_RETAIN( context, retVal );
         ref_count =
             pIntercept->config().CallLogging ?
             pIntercept->getRefCount( context ) : 0;
@@ -631,6 +640,14 @@ CL_API_ENTRY cl_int CL_API_CALL CLIRN(clReleaseContext)(
         CALL_LOGGING_ENTER( "[ ref count = %d ] context = %p",
             ref_count,
             context );
+
+        if( pIntercept->config().Emulate_cl_intel_unified_shared_memory &&
+            pIntercept->config().EmulatedUSMPool &&
+            ref_count == 1 )
+        {
+            pIntercept->emulatedReleaseUSMContext( context );
+        }
+
         HOST_PERFORMANCE_TIMING_START();
 
         cl_int retVal = pIntercept->dispatch().clReleaseContext(
@@ -639,6 +656,7 @@ CL_API_ENTRY cl_int CL_API_CALL CLIRN(clReleaseContext)(
         HOST_PERFORMANCE_TIMING_END();
         CHECK_ERROR( retVal );
         ADD_OBJECT_RELEASE( context );
+        STREAM_CAPTURE_RELEASE( context, retVal );
         --ref_count;
         CALL_LOGGING_EXIT( retVal, "[ ref count = %d ]", ref_count );
         DEVICE_PERFORMANCE_TIMING_CHECK_CONDITIONAL( ref_count == 0 );
@@ -812,6 +830,7 @@ CL_API_ENTRY cl_command_queue CL_API_CALL CLIRN(clCreateCommandQueue)(
         CHECK_ERROR( errcode_ret[0] );
         ITT_REGISTER_COMMAND_QUEUE( retVal, false );
         ADD_OBJECT_ALLOCATION( retVal );
+        STREAM_CAPTURE_CREATE_COMMAND_QUEUE( retVal, context, properties );
         CALL_LOGGING_EXIT( errcode_ret[0], "returned %p", retVal );
         ADD_QUEUE( context, retVal );
         QUEUE_INFO_LOGGING( device, retVal );
@@ -847,6 +866,7 @@ CL_API_ENTRY cl_int CL_API_CALL CLIRN(clRetainCommandQueue)(
         HOST_PERFORMANCE_TIMING_END();
         CHECK_ERROR( retVal );
         ADD_OBJECT_RETAIN( command_queue );
+        STREAM_CAPTURE_RETAIN( command_queue, retVal );
         ref_count =
             pIntercept->config().CallLogging ?
             pIntercept->getRefCount( command_queue ) : 0;
@@ -869,6 +889,7 @@ CL_API_ENTRY cl_int CL_API_CALL CLIRN(clReleaseCommandQueue)(
     {
         GET_ENQUEUE_COUNTER();
         REMOVE_QUEUE( command_queue );
+        LWS_AUTOTUNING_REMOVE_QUEUE( command_queue );
 
         cl_uint ref_count =
             pIntercept->config().CallLogging ?
@@ -885,6 +906,7 @@ CL_API_ENTRY cl_int CL_API_CALL CLIRN(clReleaseCommandQueue)(
         CHECK_ERROR( retVal );
         ITT_RELEASE_COMMAND_QUEUE( command_queue );
         ADD_OBJECT_RELEASE( command_queue );
+        STREAM_CAPTURE_RELEASE( command_queue, retVal );
         CALL_LOGGING_EXIT( retVal, "[ ref count = %d ]", --ref_count );
 
         return retVal;
@@ -1011,6 +1033,7 @@ CL_API_ENTRY cl_mem CL_API_CALL CLIRN(clCreateBuffer)(
         DUMP_BUFFER_AFTER_CREATE( retVal, flags, host_ptr, size );
         CHECK_ERROR( errcode_ret[0] );
         ADD_OBJECT_ALLOCATION( retVal );
+        STREAM_CAPTURE_CREATE_BUFFER( retVal, context, flags, size, host_ptr );
         CALL_LOGGING_EXIT( errcode_ret[0], "returned %p", retVal );
 
         return retVal;
@@ -1068,6 +1091,7 @@ CL_API_ENTRY cl_mem CL_API_CALL CLIRN(clCreateBufferWithProperties)(
         DUMP_BUFFER_AFTER_CREATE( retVal, flags, host_ptr, size );
         CHECK_ERROR( errcode_ret[0] );
         ADD_OBJECT_ALLOCATION( retVal );
+        STREAM_CAPTURE_CREATE_BUFFER( retVal, context, flags, size, host_ptr );
         CALL_LOGGING_EXIT( errcode_ret[0], "returned %p", retVal );
 
         return retVal;
@@ -1585,6 +1609,7 @@ CL_API_ENTRY cl_int CL_API_CALL CLIRN(clRetainMemObject)(
         HOST_PERFORMANCE_TIMING_END();
         CHECK_ERROR( retVal );
         ADD_OBJECT_RETAIN( memobj );
+        STREAM_CAPTURE_RETAIN( memobj, retVal );
         ref_count =
             pIntercept->config().CallLogging ?
             pIntercept->getRefCount( memobj ) : 0;
@@ -1622,6 +1647,7 @@ CL_API_ENTRY cl_int CL_API_CALL CLIRN(clReleaseMemObject)(
         HOST_PERFORMANCE_TIMING_END();
         CHECK_ERROR( retVal );
         ADD_OBJECT_RELEASE( memobj );
+        STREAM_CAPTURE_RELEASE( memobj, retVal );
         CALL_LOGGING_EXIT( retVal, "[ ref count = %d ]", --ref_count );
 
         return retVal;
@@ -1967,6 +1993,10 @@ CL_API_ENTRY cl_program CL_API_CALL CLIRN(clCreateProgramWithSource)(
 
         cl_program  retVal = NULL;
 
+        // Programs created from injected binaries or SPIR-V are not built
+        // from the program source, so they are not cached.
+        bool    createdFromSource = false;
+
         if( ( retVal == NULL ) &&
             pIntercept->config().InjectProgramBinaries )
         {
@@ -1993,17 +2023,21 @@ CL_API_ENTRY cl_program CL_API_CALL CLIRN(clCreateProgramWithSource)(
                 strings,
                 lengths,
                 errcode_ret );
+            createdFromSource = true;
         }
 
         HOST_PERFORMANCE_TIMING_END();
         CHECK_ERROR( errcode_ret[0] );
         ADD_OBJECT_ALLOCATION( retVal );
+        STREAM_CAPTURE_CREATE_PROGRAM_WITH_SOURCE( retVal, context, count, strings, lengths );
         CALL_LOGGING_EXIT( errcode_ret[0], "returned %p, program number = %04d",
             retVal,
             pIntercept->getProgramNumber() );
 
         DUMP_PROGRAM_SOURCE( retVal, singleString, hash );
         SAVE_PROGRAM_HASH( retVal, hash );
+        CHECK_REDUNDANT_PROGRAM_CREATE( retVal );
+        INIT_PROGRAM_BINARY_CACHE( retVal, createdFromSource, singleString, hash );
         DELETE_COMBINED_PROGRAM_STRING( singleString );
 
         return retVal;
@@ -2062,6 +2096,7 @@ CL_API_ENTRY cl_program CL_API_CALL CLIRN(clCreateProgramWithBinary)(
         HOST_PERFORMANCE_TIMING_END();
         CHECK_ERROR( errcode_ret[0] );
         ADD_OBJECT_ALLOCATION( retVal );
+        STREAM_CAPTURE_CREATE_PROGRAM_WITH_BINARY( retVal, context, num_devices, lengths, binaries );
         CALL_LOGGING_EXIT( errcode_ret[0], "returned %p", retVal );
 
         DUMP_INPUT_PROGRAM_BINARIES(
@@ -2072,6 +2107,7 @@ CL_API_ENTRY cl_program CL_API_CALL CLIRN(clCreateProgramWithBinary)(
             binaries,
             hash );
         SAVE_PROGRAM_HASH( retVal, hash );
+        CHECK_REDUNDANT_PROGRAM_CREATE( retVal );
 
         return retVal;
     }
@@ -2107,7 +2143,9 @@ CL_API_ENTRY cl_program CL_API_CALL CLIRN(clCreateProgramWithBuiltInKernels)(
             pIntercept->config().OverrideBuiltinKernels )
         {
             retVal = pIntercept->createProgramWithBuiltinKernels(
-                context );
+                context,
+                num_devices,
+                device_list );
         }
 
         if( retVal == NULL )
@@ -2156,6 +2194,7 @@ CL_API_ENTRY cl_int CL_API_CALL CLIRN(clRetainProgram)(
         HOST_PERFORMANCE_TIMING_END();
         CHECK_ERROR( retVal );
         ADD_OBJECT_RETAIN( program );
+        STREAM_CAPTURE_RETAIN( program, retVal );
         ref_count =
             pIntercept->config().CallLogging ?
             pIntercept->getRefCount( program ) : 0;
@@ -2184,6 +2223,9 @@ CL_API_ENTRY cl_int CL_API_CALL CLIRN(clReleaseProgram)(
         CALL_LOGGING_ENTER( "[ ref count = %d ] program = %p",
             ref_count,
             program );
+        CHECK_REDUNDANT_WORK_RELEASE( program );
+        CHECK_REMOVE_HOT_RELOAD_PROGRAM( program );
+        CHECK_REMOVE_BINARY_CACHE_PROGRAM( program );
         HOST_PERFORMANCE_TIMING_START();
 
         cl_int  retVal = pIntercept->dispatch().clReleaseProgram(
@@ -2192,6 +2234,7 @@ CL_API_ENTRY cl_int CL_API_CALL CLIRN(clReleaseProgram)(
         HOST_PERFORMANCE_TIMING_END();
         CHECK_ERROR( retVal );
         ADD_OBJECT_RELEASE( program );
+        STREAM_CAPTURE_RELEASE( program, retVal );
         CALL_LOGGING_EXIT( retVal, "[ ref count = %d ]", --ref_count );
 
         return retVal;
@@ -2225,12 +2268,23 @@ CL_API_ENTRY cl_int CL_API_CALL CLIRN(clBuildProgram)(
         DUMP_PROGRAM_OPTIONS( program, newOptions ? newOptions : options, isCompile, isLink );
 
         CALL_LOGGING_ENTER( "program = %p, pfn_notify = %p", program, pfn_notify );
-        BUILD_LOGGING_INIT();
         HOST_PERFORMANCE_TIMING_START();
+        BUILD_LOGGING_INIT();
 
         cl_int  retVal = CL_INVALID_OPERATION;
 
-        if( newOptions != NULL )
+        if( pIntercept->config().ProgramBinaryCache )
+        {
+            retVal = pIntercept->buildProgramWithCachedBinaries(
+                program,
+                num_devices,
+                device_list,
+                newOptions ? newOptions : options,
+                pfn_notify,
+                user_data );
+        }
+
+        if( ( retVal != CL_SUCCESS ) && ( newOptions != NULL ) )
         {
             retVal = pIntercept->dispatch().clBuildProgram(
                 program,
@@ -2252,13 +2306,19 @@ CL_API_ENTRY cl_int CL_API_CALL CLIRN(clBuildProgram)(
                 user_data );
         }
 
+        BUILD_LOGGING_END();
         HOST_PERFORMANCE_TIMING_END();
         CHECK_ERROR( retVal );
+        STREAM_CAPTURE_BUILD_PROGRAM( program, options, retVal );
         BUILD_LOGGING( program, num_devices, device_list );
+        PROGRAM_BUILD_TIMING( program, num_devices, device_list, newOptions ? newOptions : options, "Build" );
+        CHECK_REDUNDANT_PROGRAM_BUILD( program, retVal );
+        ADD_HOT_RELOAD_PROGRAM( program, num_devices, device_list, newOptions ? newOptions : options, retVal );
         CALL_LOGGING_EXIT( retVal );
 
         DUMP_OUTPUT_PROGRAM_BINARIES( program );
         DUMP_KERNEL_ISA_BINARIES( program );
+        UPDATE_PROGRAM_BINARY_CACHE( program, num_devices, device_list, newOptions ? newOptions : options, retVal );
         // Note: this uses the original program options!
         AUTO_CREATE_SPIRV( program, options );
         INCREMENT_PROGRAM_COMPILE_COUNT( program );
@@ -2298,9 +2358,11 @@ CL_API_ENTRY cl_int CL_API_CALL CLIRN(clCompileProgram)(
         PROGRAM_OPTIONS_OVERRIDE_INIT( program, options, newOptions, isCompile );
         DUMP_PROGRAM_OPTIONS( program, newOptions ? newOptions : options, isCompile, isLink );
 
+        REMOVE_BINARY_CACHE_PROGRAM( program );
+
         CALL_LOGGING_ENTER( "program = %p, pfn_notify = %p", program, pfn_notify );
-        BUILD_LOGGING_INIT();
         HOST_PERFORMANCE_TIMING_START();
+        BUILD_LOGGING_INIT();
 
         cl_int  retVal = CL_INVALID_OPERATION;
 
@@ -2332,9 +2394,12 @@ CL_API_ENTRY cl_int CL_API_CALL CLIRN(clCompileProgram)(
                 user_data );
         }
 
+        BUILD_LOGGING_END();
         HOST_PERFORMANCE_TIMING_END();
         CHECK_ERROR( retVal );
         BUILD_LOGGING( program, num_devices, device_list );
+        PROGRAM_BUILD_TIMING( program, num_devices, device_list, newOptions ? newOptions : options, "Compile" );
+        CHECK_REDUNDANT_PROGRAM_BUILD( program, retVal );
         CALL_LOGGING_EXIT( retVal );
 
         DUMP_OUTPUT_PROGRAM_BINARIES( program );
@@ -2373,13 +2438,16 @@ CL_API_ENTRY cl_program CL_API_CALL CLIRN(clLinkProgram)(
 
         PROGRAM_LINK_OPTIONS_OVERRIDE_INIT( num_devices, device_list, options, newOptions );
 
+        std::vector<cl_program> cacheInputPrograms;
+        GET_BINARY_CACHE_PROGRAMS( num_input_programs, input_programs, cacheInputPrograms );
+
         CALL_LOGGING_ENTER( "context = %p, num_input_programs = %u, pfn_notify = %p",
             context,
             num_input_programs,
             pfn_notify );
         CHECK_ERROR_INIT( errcode_ret );
-        BUILD_LOGGING_INIT();
         HOST_PERFORMANCE_TIMING_START();
+        BUILD_LOGGING_INIT();
 
         cl_program  retVal = NULL;
 
@@ -2411,6 +2479,7 @@ CL_API_ENTRY cl_program CL_API_CALL CLIRN(clLinkProgram)(
                 errcode_ret );
         }
 
+        BUILD_LOGGING_END();
         HOST_PERFORMANCE_TIMING_END();
         CHECK_ERROR( errcode_ret[0] );
         BUILD_LOGGING( retVal, num_devices, device_list );
@@ -2421,6 +2490,8 @@ CL_API_ENTRY cl_program CL_API_CALL CLIRN(clLinkProgram)(
         // This is a new program object, so we don't currently have a hash for it.
         SAVE_PROGRAM_NUMBER( retVal );
         SAVE_PROGRAM_OPTIONS_HASH( retVal, options );
+        PROGRAM_BUILD_TIMING( retVal, num_devices, device_list, newOptions ? newOptions : options, "Link" );
+        CHECK_REDUNDANT_PROGRAM_BUILD( retVal, errcode_ret[0] );
         DUMP_PROGRAM_OPTIONS( retVal, newOptions ? newOptions : options, isCompile, isLink );
         DUMP_OUTPUT_PROGRAM_BINARIES( retVal );
         DUMP_KERNEL_ISA_BINARIES( retVal );
@@ -2571,8 +2642,20 @@ CL_API_ENTRY cl_int CL_API_CALL CLIRN(clGetProgramInfo)(
             param_name );
         HOST_PERFORMANCE_TIMING_START();
 
+        // Queries for a program built from the program binary cache are
+        // redirected to the cached program, except for queries about the
+        // application's program object itself.
+        cl_program  queryProgram = program;
+        if( param_name != CL_PROGRAM_REFERENCE_COUNT &&
+            param_name != CL_PROGRAM_CONTEXT &&
+            param_name != CL_PROGRAM_SOURCE &&
+            param_name != CL_PROGRAM_IL )
+        {
+            queryProgram = GET_BINARY_CACHE_PROGRAM( program );
+        }
+
         cl_int  retVal = pIntercept->dispatch().clGetProgramInfo(
-            program,
+            queryProgram,
             param_name,
             param_value_size,
             param_value,
@@ -2610,7 +2693,7 @@ CL_API_ENTRY cl_int CL_API_CALL CLIRN(clGetProgramBuildInfo)(
         HOST_PERFORMANCE_TIMING_START();
 
         cl_int  retVal = pIntercept->dispatch().clGetProgramBuildInfo(
-            program,
+            GET_BINARY_CACHE_PROGRAM( program ),
             device,
             param_name,
             param_value_size,
@@ -2660,7 +2743,7 @@ CL_API_ENTRY cl_kernel CL_API_CALL CLIRN(clCreateKernel)(
         if( retVal == NULL )
         {
             retVal = pIntercept->dispatch().clCreateKernel(
-                program,
+                GET_BINARY_CACHE_PROGRAM( program ),
                 kernel_name,
                 errcode_ret );
         }
@@ -2668,6 +2751,7 @@ CL_API_ENTRY cl_kernel CL_API_CALL CLIRN(clCreateKernel)(
         HOST_PERFORMANCE_TIMING_END();
         CHECK_ERROR( errcode_ret[0] );
         ADD_OBJECT_ALLOCATION( retVal );
+        STREAM_CAPTURE_CREATE_KERNEL( retVal, program, kernel_name );
         CALL_LOGGING_EXIT( errcode_ret[0], "returned %p", retVal );
 
         if( retVal != NULL )
@@ -2676,6 +2760,8 @@ CL_API_ENTRY cl_kernel CL_API_CALL CLIRN(clCreateKernel)(
                 retVal,
                 program,
                 kernel_name );
+            ADD_BINARY_CACHE_KERNELS( program, &retVal, 1 );
+            CHECK_REDUNDANT_KERNEL_CREATE( &retVal, 1 );
             if( pIntercept->config().KernelInfoLogging ||
                 pIntercept->config().PreferredWorkGroupSizeMultipleLogging )
             {
@@ -2715,7 +2801,7 @@ CL_API_ENTRY cl_int CL_API_CALL CLIRN(clCreateKernelsInProgram)(
         HOST_PERFORMANCE_TIMING_START();
 
         cl_int  retVal = pIntercept->dispatch().clCreateKernelsInProgram(
-            program,
+            GET_BINARY_CACHE_PROGRAM( program ),
             num_kernels,
             kernels,
             num_kernels_ret );
@@ -2751,6 +2837,8 @@ CL_API_ENTRY cl_int CL_API_CALL CLIRN(clCreateKernelsInProgram)(
                 kernels,
                 program,
                 num_kernels_ret[0] );
+            ADD_BINARY_CACHE_KERNELS( program, kernels, num_kernels_ret[0] );
+            CHECK_REDUNDANT_KERNEL_CREATE( kernels, num_kernels_ret[0] );
             if( pIntercept->config().KernelInfoLogging ||
                 pIntercept->config().PreferredWorkGroupSizeMultipleLogging )
             {
@@ -2791,6 +2879,7 @@ CL_API_ENTRY cl_int CL_API_CALL CLIRN(clRetainKernel)(
         HOST_PERFORMANCE_TIMING_END();
         CHECK_ERROR( retVal );
         ADD_OBJECT_RETAIN( kernel );
+        STREAM_CAPTURE_RETAIN( kernel, retVal );
         ref_count =
             pIntercept->config().CallLogging ?
             pIntercept->getRefCount( kernel ) : 0;
@@ -2819,7 +2908,9 @@ CL_API_ENTRY cl_int CL_API_CALL CLIRN(clReleaseKernel)(
         CALL_LOGGING_ENTER( "[ ref count = %d ] kernel = %p",
             ref_count,
             kernel );
+        CHECK_REDUNDANT_WORK_RELEASE( kernel );
         pIntercept->checkRemoveKernelInfo( kernel );
+        CHECK_REMOVE_BINARY_CACHE_KERNEL( kernel );
         HOST_PERFORMANCE_TIMING_START();
 
         cl_int  retVal = pIntercept->dispatch().clReleaseKernel(
@@ -2828,6 +2919,7 @@ CL_API_ENTRY cl_int CL_API_CALL CLIRN(clReleaseKernel)(
         HOST_PERFORMANCE_TIMING_END();
         CHECK_ERROR( retVal );
         ADD_OBJECT_RELEASE( kernel );
+        STREAM_CAPTURE_RELEASE( kernel, retVal );
         CALL_LOGGING_EXIT( retVal, "[ ref count = %d ]", --ref_count );
 
         return retVal;
@@ -2876,6 +2968,7 @@ CL_API_ENTRY cl_int CL_API_CALL CLIRN(clSetKernelArg)(
 
         HOST_PERFORMANCE_TIMING_END();
         CHECK_ERROR( retVal );
+        STREAM_CAPTURE_SET_KERNEL_ARG( kernel, arg_index, arg_size, arg_value, retVal );
         CALL_LOGGING_EXIT( retVal );
 
         return retVal;
@@ -2912,6 +3005,20 @@ CL_API_ENTRY cl_int CL_API_CALL CLIRN(clGetKernelInfo)(
 
         HOST_PERFORMANCE_TIMING_END();
         CHECK_ERROR( retVal );
+
+        // Kernels created from a program built from the program binary cache
+        // return the application's program.
+        if( ( retVal == CL_SUCCESS ) &&
+            ( param_name == CL_KERNEL_PROGRAM ) &&
+            ( param_value != NULL ) &&
+            pIntercept->config().ProgramBinaryCache )
+        {
+            cl_program* pProgram = (cl_program*)param_value;
+            pProgram[0] = pIntercept->getBinaryCacheKernelProgram(
+                kernel,
+                pProgram[0] );
+        }
+
         CALL_LOGGING_EXIT( retVal );
 
         return retVal;
@@ -3038,8 +3145,10 @@ CL_API_ENTRY cl_int CL_API_CALL CLIRN(clWaitForEvents)(
 
         HOST_PERFORMANCE_TIMING_END();
         CHECK_ERROR( retVal );
+        STREAM_CAPTURE_WAIT_FOR_EVENTS( num_events, event_list, retVal );
         CALL_LOGGING_EXIT( retVal );
         DEVICE_PERFORMANCE_TIMING_CHECK();
+        LWS_AUTOTUNING_CHECK();
         FLUSH_CHROME_TRACE_BUFFERING();
 
         return retVal;
@@ -3142,6 +3251,7 @@ CL_API_ENTRY cl_int CL_API_CALL CLIRN(clRetainEvent)(
         HOST_PERFORMANCE_TIMING_END();
         CHECK_ERROR( retVal );
         ADD_OBJECT_RETAIN( event );
+        STREAM_CAPTURE_RETAIN( event, retVal );
         ref_count =
             pIntercept->config().CallLogging ?
             pIntercept->getRefCount( event ) : 0;
@@ -3179,6 +3289,7 @@ CL_API_ENTRY cl_int CL_API_CALL CLIRN(clReleaseEvent)(
         HOST_PERFORMANCE_TIMING_END();
         CHECK_ERROR( retVal );
         ADD_OBJECT_RELEASE( event );
+        STREAM_CAPTURE_RELEASE( event, retVal );
         CALL_LOGGING_EXIT( retVal, "[ ref count = %d ]", --ref_count );
 
         return retVal;
@@ -3312,6 +3423,7 @@ CL_API_ENTRY cl_int CL_API_CALL CLIRN(clFlush)(
 
         HOST_PERFORMANCE_TIMING_END();
         CHECK_ERROR( retVal );
+        STREAM_CAPTURE_QUEUE_OPERATION( STREAM_RECORD_FLUSH, command_queue, retVal );
         CALL_LOGGING_EXIT( retVal );
 
         return retVal;
@@ -3338,8 +3450,10 @@ CL_API_ENTRY cl_int CL_API_CALL CLIRN(clFinish)(
 
         HOST_PERFORMANCE_TIMING_END();
         CHECK_ERROR( retVal );
+        STREAM_CAPTURE_QUEUE_OPERATION( STREAM_RECORD_FINISH, command_queue, retVal );
         CALL_LOGGING_EXIT( retVal );
         DEVICE_PERFORMANCE_TIMING_CHECK();
+        LWS_AUTOTUNING_CHECK();
         FLUSH_CHROME_TRACE_BUFFERING();
 
         return retVal;
@@ -3388,6 +3502,7 @@ CL_API_ENTRY cl_int CL_API_CALL CLIRN(clEnqueueReadBuffer)(
                 eventWaitListString.c_str() );
             CHECK_EVENT_LIST( num_events_in_wait_list, event_wait_list, event );
             GET_TIMING_TAGS_BLOCKING( blocking_read, cb );
+            PREPARE_PRECOMPILED_KERNEL_OVERRIDES( OverrideReadBuffer, command_queue );
             DEVICE_PERFORMANCE_TIMING_START( event );
             HOST_PERFORMANCE_TIMING_START();
 
@@ -3424,6 +3539,16 @@ CL_API_ENTRY cl_int CL_API_CALL CLIRN(clEnqueueReadBuffer)(
             DEVICE_PERFORMANCE_TIMING_END_WITH_TAG( command_queue, event );
             CHECK_ERROR( retVal );
             ADD_OBJECT_ALLOCATION( event ? event[0] : NULL );
+            STREAM_CAPTURE_ENQUEUE_READ_BUFFER(
+                command_queue,
+                buffer,
+                blocking_read,
+                offset,
+                cb,
+                num_events_in_wait_list,
+                event_wait_list,
+                event,
+                retVal );
             CALL_LOGGING_EXIT_EVENT_WITH_TAG( retVal, event );
             DEVICE_PERFORMANCE_TIMING_CHECK_CONDITIONAL( blocking_read );
             FLUSH_CHROME_TRACE_BUFFERING_CONDITIONAL( blocking_read );
@@ -3578,6 +3703,7 @@ CL_API_ENTRY cl_int CL_API_CALL CLIRN(clEnqueueWriteBuffer)(
                 eventWaitListString.c_str() );
             CHECK_EVENT_LIST( num_events_in_wait_list, event_wait_list, event );
             GET_TIMING_TAGS_BLOCKING( blocking_write, cb );
+            PREPARE_PRECOMPILED_KERNEL_OVERRIDES( OverrideWriteBuffer, command_queue );
             DEVICE_PERFORMANCE_TIMING_START( event );
             HOST_PERFORMANCE_TIMING_START();
 
@@ -3614,6 +3740,17 @@ CL_API_ENTRY cl_int CL_API_CALL CLIRN(clEnqueueWriteBuffer)(
             DEVICE_PERFORMANCE_TIMING_END_WITH_TAG( command_queue, event );
             CHECK_ERROR( retVal );
             ADD_OBJECT_ALLOCATION( event ? event[0] : NULL );
+            STREAM_CAPTURE_ENQUEUE_WRITE_BUFFER(
+                command_queue,
+                buffer,
+                blocking_write,
+                offset,
+                cb,
+                ptr,
+                num_events_in_wait_list,
+                event_wait_list,
+                event,
+                retVal );
             CALL_LOGGING_EXIT_EVENT_WITH_TAG( retVal, event );
             DEVICE_PERFORMANCE_TIMING_CHECK_CONDITIONAL( blocking_write );
             FLUSH_CHROME_TRACE_BUFFERING_CONDITIONAL( blocking_write );
@@ -3785,6 +3922,17 @@ CL_API_ENTRY cl_int CL_API_CALL CLIRN(clEnqueueFillBuffer)(
             DEVICE_PERFORMANCE_TIMING_END_WITH_TAG( command_queue, event );
             CHECK_ERROR( retVal );
             ADD_OBJECT_ALLOCATION( event ? event[0] : NULL );
+            STREAM_CAPTURE_ENQUEUE_FILL_BUFFER(
+                command_queue,
+                buffer,
+                pattern,
+                pattern_size,
+                offset,
+                size,
+                num_events_in_wait_list,
+                event_wait_list,
+                event,
+                retVal );
             CALL_LOGGING_EXIT_EVENT_WITH_TAG( retVal, event );
             ADD_EVENT( event ? event[0] : NULL );
         }
@@ -3837,6 +3985,7 @@ CL_API_ENTRY cl_int CL_API_CALL CLIRN(clEnqueueCopyBuffer)(
                 eventWaitListString.c_str() );
             CHECK_EVENT_LIST( num_events_in_wait_list, event_wait_list, event );
             GET_TIMING_TAGS_BLOCKING( CL_FALSE, cb );
+            PREPARE_PRECOMPILED_KERNEL_OVERRIDES( OverrideCopyBuffer, command_queue );
             DEVICE_PERFORMANCE_TIMING_START( event );
             HOST_PERFORMANCE_TIMING_START();
 
@@ -3871,6 +4020,17 @@ CL_API_ENTRY cl_int CL_API_CALL CLIRN(clEnqueueCopyBuffer)(
             DEVICE_PERFORMANCE_TIMING_END_WITH_TAG( command_queue, event );
             CHECK_ERROR( retVal );
             ADD_OBJECT_ALLOCATION( event ? event[0] : NULL );
+            STREAM_CAPTURE_ENQUEUE_COPY_BUFFER(
+                command_queue,
+                src_buffer,
+                dst_buffer,
+                src_offset,
+                dst_offset,
+                cb,
+                num_events_in_wait_list,
+                event_wait_list,
+                event,
+                retVal );
             CALL_LOGGING_EXIT_EVENT_WITH_TAG( retVal, event );
             ADD_EVENT( event ? event[0] : NULL );
         }
@@ -3940,23 +4100,44 @@ CL_API_ENTRY cl_int CL_API_CALL CLIRN(clEnqueueCopyBufferRect)(
             }
             CHECK_EVENT_LIST( num_events_in_wait_list, event_wait_list, event );
             GET_TIMING_TAGS_BLOCKING( CL_FALSE, region ? region[0] * region[1] * region[2] : 0 );
+            PREPARE_PRECOMPILED_KERNEL_OVERRIDES( OverrideCopyBufferRect, command_queue );
             DEVICE_PERFORMANCE_TIMING_START( event );
             HOST_PERFORMANCE_TIMING_START();
 
-            retVal = pIntercept->dispatch().clEnqueueCopyBufferRect(
-                command_queue,
-                src_buffer,
-                dst_buffer,
-                src_origin,
-                dst_origin,
-                region,
-                src_row_pitch,
-                src_slice_pitch,
-                dst_row_pitch,
-                dst_slice_pitch,
-                num_events_in_wait_list,
-                event_wait_list,
-                event );
+            if( pIntercept->config().OverrideCopyBufferRect )
+            {
+                retVal = pIntercept->CopyBufferRect(
+                    command_queue,
+                    src_buffer,
+                    dst_buffer,
+                    src_origin,
+                    dst_origin,
+                    region,
+                    src_row_pitch,
+                    src_slice_pitch,
+                    dst_row_pitch,
+                    dst_slice_pitch,
+                    num_events_in_wait_list,
+                    event_wait_list,
+                    event );
+            }
+            else
+            {
+                retVal = pIntercept->dispatch().clEnqueueCopyBufferRect(
+                    command_queue,
+                    src_buffer,
+                    dst_buffer,
+                    src_origin,
+                    dst_origin,
+                    region,
+                    src_row_pitch,
+                    src_slice_pitch,
+                    dst_row_pitch,
+                    dst_slice_pitch,
+                    num_events_in_wait_list,
+                    event_wait_list,
+                    event );
+            }
 
             HOST_PERFORMANCE_TIMING_END_WITH_TAG();
             DEVICE_PERFORMANCE_TIMING_END_WITH_TAG( command_queue, event );
@@ -4031,6 +4212,7 @@ CL_API_ENTRY cl_int CL_API_CALL CLIRN(clEnqueueReadImage)(
             }
             CHECK_EVENT_LIST( num_events_in_wait_list, event_wait_list, event );
             GET_TIMING_TAGS_BLOCKING( blocking_read, 0 );
+            PREPARE_PRECOMPILED_KERNEL_OVERRIDES( OverrideReadImage, command_queue );
             DEVICE_PERFORMANCE_TIMING_START( event );
             HOST_PERFORMANCE_TIMING_START();
 
@@ -4126,6 +4308,7 @@ CL_API_ENTRY cl_int CL_API_CALL CLIRN(clEnqueueWriteImage)(
                 eventWaitListString.c_str() );
             CHECK_EVENT_LIST( num_events_in_wait_list, event_wait_list, event );
             GET_TIMING_TAGS_BLOCKING( blocking_write, 0 );
+            PREPARE_PRECOMPILED_KERNEL_OVERRIDES( OverrideWriteImage, command_queue );
             DEVICE_PERFORMANCE_TIMING_START( event );
             HOST_PERFORMANCE_TIMING_START();
 
@@ -4280,6 +4463,7 @@ CL_API_ENTRY cl_int CL_API_CALL CLIRN(clEnqueueCopyImage)(
                 dst_image,
                 eventWaitListString.c_str() );
             CHECK_EVENT_LIST( num_events_in_wait_list, event_wait_list, event );
+            PREPARE_PRECOMPILED_KERNEL_OVERRIDES( OverrideCopyImage, command_queue );
             DEVICE_PERFORMANCE_TIMING_START( event );
             HOST_PERFORMANCE_TIMING_START();
 
@@ -4537,6 +4721,17 @@ CL_API_ENTRY void* CL_API_CALL CLIRN(clEnqueueMapBuffer)(
             CHECK_ERROR( errcode_ret[0] );
             ADD_MAP_POINTER( retVal, map_flags, cb );
             ADD_OBJECT_ALLOCATION( event ? event[0] : NULL );
+            STREAM_CAPTURE_ENQUEUE_MAP_BUFFER(
+                command_queue,
+                buffer,
+                blocking_map,
+                map_flags,
+                offset,
+                cb,
+                retVal,
+                num_events_in_wait_list,
+                event_wait_list,
+                event );
             if( pIntercept->config().CallLogging )
             {
                 map_count = 0;
@@ -4736,6 +4931,7 @@ CL_API_ENTRY cl_int CL_API_CALL CLIRN(clEnqueueUnmapMemObject)(
                 eventWaitListString.c_str() );
             CHECK_EVENT_LIST( num_events_in_wait_list, event_wait_list, event );
             GET_TIMING_TAGS_UNMAP( mapped_ptr );
+            STREAM_CAPTURE_ENQUEUE_UNMAP_INIT( memobj, mapped_ptr );
             DEVICE_PERFORMANCE_TIMING_START( event );
             HOST_PERFORMANCE_TIMING_START();
 
@@ -4752,6 +4948,14 @@ CL_API_ENTRY cl_int CL_API_CALL CLIRN(clEnqueueUnmapMemObject)(
             CHECK_ERROR( retVal );
             REMOVE_MAP_PTR( mapped_ptr );
             ADD_OBJECT_ALLOCATION( event ? event[0] : NULL );
+            STREAM_CAPTURE_ENQUEUE_UNMAP_MEM_OBJECT(
+                command_queue,
+                memobj,
+                mapped_ptr,
+                num_events_in_wait_list,
+                event_wait_list,
+                event,
+                retVal );
             if( pIntercept->config().CallLogging )
             {
                 map_count = 0;
@@ -4884,6 +5088,14 @@ CL_API_ENTRY cl_int CL_API_CALL CLIRN(clEnqueueNDRangeKernel)(
                 work_dim,
                 global_work_size,
                 local_work_size );
+            LWS_AUTOTUNING_INIT(
+                command_queue,
+                kernel,
+                work_dim,
+                global_work_size,
+                local_work_size,
+                event );
+            CAPTURE_REPLAY_TRIGGER_INIT( event );
 
             std::string argsString;
             if( pIntercept->config().CallLogging )
@@ -4934,6 +5146,21 @@ CL_API_ENTRY cl_int CL_API_CALL CLIRN(clEnqueueNDRangeKernel)(
 
             retVal = CL_INVALID_OPERATION;
 
+            if( ( retVal != CL_SUCCESS ) &&
+                pIntercept->config().InjectProgramHotReload )
+            {
+                retVal = pIntercept->NDRangeHotReloadKernel(
+                    command_queue,
+                    kernel,
+                    work_dim,
+                    global_work_offset,
+                    global_work_size,
+                    local_work_size,
+                    num_events_in_wait_list,
+                    event_wait_list,
+                    event );
+            }
+
             if( ( retVal != CL_SUCCESS ) &&
                 pIntercept->config().OverrideBuiltinKernels )
             {
@@ -4966,8 +5193,21 @@ CL_API_ENTRY cl_int CL_API_CALL CLIRN(clEnqueueNDRangeKernel)(
 
             HOST_PERFORMANCE_TIMING_END_WITH_TAG();
             DEVICE_PERFORMANCE_TIMING_END_KERNEL( command_queue, event );
+            CAPTURE_REPLAY_TRIGGER_END( retVal, event );
+            LWS_AUTOTUNING_END( command_queue, retVal, event );
             CHECK_ERROR( retVal );
             ADD_OBJECT_ALLOCATION( event ? event[0] : NULL );
+            STREAM_CAPTURE_ENQUEUE_NDRANGE_KERNEL(
+                command_queue,
+                kernel,
+                work_dim,
+                global_work_offset,
+                global_work_size,
+                local_work_size,
+                num_events_in_wait_list,
+                event_wait_list,
+                event,
+                retVal );
             CALL_LOGGING_EXIT_EVENT_WITH_TAG( retVal, event );
             ADD_EVENT( event ? event[0] : NULL );
         }
@@ -5278,6 +5518,13 @@ CL_API_ENTRY cl_int CL_API_CALL CLIRN(clEnqueueMarkerWithWaitList)(
             HOST_PERFORMANCE_TIMING_END();
             CHECK_ERROR( retVal );
             ADD_OBJECT_ALLOCATION( event ? event[0] : NULL );
+            STREAM_CAPTURE_ENQUEUE_MARKER_OR_BARRIER(
+                STREAM_RECORD_ENQUEUE_MARKER,
+                command_queue,
+                num_events_in_wait_list,
+                event_wait_list,
+                event,
+                retVal );
             CALL_LOGGING_EXIT_EVENT( retVal, event );
             ADD_EVENT( event ? event[0] : NULL );
         }
@@ -5331,6 +5578,13 @@ CL_API_ENTRY cl_int CL_API_CALL CLIRN(clEnqueueBarrierWithWaitList)(
             HOST_PERFORMANCE_TIMING_END();
             CHECK_ERROR( retVal );
             ADD_OBJECT_ALLOCATION( event ? event[0] : NULL );
+            STREAM_CAPTURE_ENQUEUE_MARKER_OR_BARRIER(
+                STREAM_RECORD_ENQUEUE_BARRIER,
+                command_queue,
+                num_events_in_wait_list,
+                event_wait_list,
+                event,
+                retVal );
             CALL_LOGGING_EXIT_EVENT( retVal, event );
             ADD_EVENT( event ? event[0] : NULL );
         }
@@ -6809,6 +7063,7 @@ CL_API_ENTRY cl_int CL_API_CALL CLIRN(clSetKernelExecInfo) (
 
         HOST_PERFORMANCE_TIMING_END();
         CHECK_ERROR( retVal );
+        SET_KERNEL_EXEC_INFO( kernel, param_name, param_value_size, param_value, retVal );
         CALL_LOGGING_EXIT( retVal );
 
         return retVal;
@@ -6981,6 +7236,7 @@ CL_API_ENTRY cl_command_queue CL_API_CALL CLIRN(clCreateCommandQueueWithProperti
         COMMAND_QUEUE_PROPERTIES_CLEANUP( newProperties );
         CHECK_ERROR( errcode_ret[0] );
         ADD_OBJECT_ALLOCATION( retVal );
+        STREAM_CAPTURE_CREATE_COMMAND_QUEUE_WITH_PROPERTIES( retVal, context, properties );
         CALL_LOGGING_EXIT( errcode_ret[0], "returned %p", retVal );
         ADD_QUEUE( context, retVal );
         QUEUE_INFO_LOGGING( device, retVal );
@@ -7260,10 +7516,12 @@ CL_API_ENTRY cl_program CL_API_CALL CLIRN(clCreateProgramWithIL) (
         HOST_PERFORMANCE_TIMING_END();
         CHECK_ERROR( errcode_ret[0] );
         ADD_OBJECT_ALLOCATION( retVal );
+        STREAM_CAPTURE_CREATE_PROGRAM_WITH_IL( retVal, context, il, length );
         CALL_LOGGING_EXIT( errcode_ret[0], "returned %p", retVal );
 
         DUMP_PROGRAM_SPIRV( retVal, length, il, hash );
         SAVE_PROGRAM_HASH( retVal, hash );
+        CHECK_REDUNDANT_PROGRAM_CREATE( retVal );
         DELETE_INJECTED_SPIRV( injectedSPIRV );
 
         return retVal;
@@ -7316,6 +7574,7 @@ CL_API_ENTRY cl_program CL_API_CALL clCreateProgramWithILKHR(
 
             DUMP_PROGRAM_SPIRV( retVal, length, il, hash );
             SAVE_PROGRAM_HASH( retVal, hash );
+            CHECK_REDUNDANT_PROGRAM_CREATE( retVal );
             DELETE_INJECTED_SPIRV( injectedSPIRV );
 
             return retVal;
@@ -7353,6 +7612,7 @@ CL_API_ENTRY cl_kernel CL_API_CALL CLIRN(clCloneKernel) (
         if( retVal != NULL )
         {
             pIntercept->addKernelInfo( retVal, source_kernel );
+            ADD_BINARY_CACHE_KERNEL_CLONE( retVal, source_kernel );
         }
 
         return retVal;
@@ -8805,7 +9065,9 @@ CL_API_ENTRY cl_command_queue CL_API_CALL clCreatePerfCountersCommandQueueINTEL(
             if( pIntercept->config().DevicePerformanceTiming ||
                 pIntercept->config().ITTPerformanceTiming ||
                 pIntercept->config().ChromePerformanceTiming ||
-                pIntercept->config().DevicePerfCounterEventBasedSampling )
+                pIntercept->config().DevicePerfCounterEventBasedSampling ||
+                pIntercept->config().LocalWorkSizeAutotuning ||
+                pIntercept->config().CaptureReplayMinDeviceTimeUS )
             {
                 properties |= (cl_command_queue_properties)CL_QUEUE_PROFILING_ENABLE;
             }
@@ -4,6 +4,10 @@
 // SPDX-License-Identifier: MIT
 */
 
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <mutex>
 #include <string>
 
 #include "intercept.h"
@@ -288,25 +292,14 @@ cl_int CL_API_CALL clEnqueueMigrateMemINTEL_EMU(
 
     if( pIntercept && pIntercept->config().Emulate_cl_intel_unified_shared_memory )
     {
-        // We could check for OpenCL 2.1 and call the SVM migrate
-        // functions, but for now we'll just enqueue a marker.
-#if 0
-        return pIntercept->dispatch().clEnqueueSVMMigrateMem(
+        return pIntercept->emulatedEnqueueMigrateMem(
             queue,
-            1,
-            &ptr,
-            &size,
+            ptr,
+            size,
             flags,
             num_events_in_wait_list,
             event_wait_list,
             event );
-#else
-        return pIntercept->dispatch().clEnqueueMarkerWithWaitList(
-            queue,
-            num_events_in_wait_list,
-            event_wait_list,
-            event );
-#endif
     }
 
     return CL_INVALID_OPERATION;
@@ -328,9 +321,11 @@ cl_int CL_API_CALL clEnqueueMemAdviseINTEL_EMU(
 
     if( pIntercept && pIntercept->config().Emulate_cl_intel_unified_shared_memory )
     {
-        // TODO: What should we do here?
-        return pIntercept->dispatch().clEnqueueMarkerWithWaitList(
+        return pIntercept->emulatedEnqueueMemAdvise(
             queue,
+            ptr,
+            size,
+            advice,
             num_events_in_wait_list,
             event_wait_list,
             event );
@@ -366,8 +361,20 @@ typedef struct _cl_semaphore_khr
     const cl_context Context;
     const cl_semaphore_type_khr Type;
 
-    cl_uint RefCount;
-    cl_event Event;
+    std::atomic<cl_uint> RefCount;
+
+    // Protects the events below, since a semaphore is typically signaled
+    // from one thread and waited on from another.
+    std::mutex Mutex;
+
+    // The event for a pending signal that has not been waited on yet.
+    cl_event SignalEvent;
+
+    // User events for pending waits that were enqueued before their
+    // signals, oldest first.  Each signal completes the oldest pending wait
+    // by an event callback when the signal completes, so the host never
+    // needs to wait for either command.
+    std::deque<cl_event> WaitEvents;
 
 private:
     static constexpr cl_uint cMagic = 0x53454d41;   // "SEMA"
@@ -377,9 +384,32 @@ private:
         Context(context),
         Type(CL_SEMAPHORE_TYPE_BINARY_KHR),
         RefCount(1),
-        Event(NULL) {}
+        SignalEvent(NULL) {}
 } cli_semaphore;
 
+///////////////////////////////////////////////////////////////////////////////
+//
+// cl_khr_semaphore
+static void CL_CALLBACK semaphoreSignalCallback(
+    cl_event event,
+    cl_int event_command_status,
+    void* user_data )
+{
+    // Completes the user event for waits that were enqueued before the
+    // signal.  An error status is propagated to the waits.
+    CLIntercept*    pIntercept = GetIntercept();
+    cl_event        waitEvent = (cl_event)user_data;
+
+    if( pIntercept )
+    {
+        pIntercept->dispatch().clSetUserEventStatus(
+            waitEvent,
+            event_command_status < 0 ? event_command_status : CL_COMPLETE );
+        pIntercept->dispatch().clReleaseEvent(
+            waitEvent );
+    }
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 // cl_khr_semaphore
@@ -426,39 +456,105 @@ cl_int CL_API_CALL clEnqueueWaitSemaphoresKHR_EMU(
         return CL_INVALID_VALUE;
     }
 
+    for( cl_uint i = 0; i < num_semaphores; i++ )
+    {
+        if( !cli_semaphore::isValid(semaphores[i]) )
+        {
+            return CL_INVALID_SEMAPHORE_KHR;
+        }
+    }
+
+    // Hold the locks for all of the semaphores until the wait is enqueued,
+    // so the semaphore states can be restored if it fails.  The locks are
+    // taken in address order to avoid deadlocks.
+    std::vector<cli_semaphore*> lockOrder(
+        semaphores,
+        semaphores + num_semaphores);
+    std::sort(lockOrder.begin(), lockOrder.end());
+    lockOrder.erase(
+        std::unique(lockOrder.begin(), lockOrder.end()),
+        lockOrder.end());
+
+    std::vector<std::unique_lock<std::mutex>> locks;
+    for( auto semaphore : lockOrder )
+    {
+        locks.emplace_back(semaphore->Mutex);
+    }
+
     std::vector<cl_event> combinedWaitList;
     combinedWaitList.insert(
         combinedWaitList.end(),
         event_wait_list,
         event_wait_list + num_events_in_wait_list);
 
-    for( cl_uint i = 0; i < num_semaphores; i++ )
+    // Signal events that were taken from signaled semaphores, and user
+    // events that were added for waits that were enqueued before their
+    // signals, so they can be restored or released if the wait fails.
+    std::vector<std::pair<cli_semaphore*, cl_event>> takenSignalEvents;
+    std::vector<std::pair<cli_semaphore*, cl_event>> addedWaitEvents;
+
+    cl_int  retVal = CL_SUCCESS;
+    for( cl_uint i = 0; i < num_semaphores && retVal == CL_SUCCESS; i++ )
     {
-        if( !cli_semaphore::isValid(semaphores[i]) )
+        cli_semaphore*  semaphore = semaphores[i];
+
+        if( semaphore->SignalEvent != NULL )
         {
-            return CL_INVALID_SEMAPHORE_KHR;
+            // The signal has already been enqueued, so wait for it directly
+            // and consume it.
+            combinedWaitList.push_back(semaphore->SignalEvent);
+            takenSignalEvents.push_back(
+                std::make_pair(semaphore, semaphore->SignalEvent));
+            semaphore->SignalEvent = NULL;
         }
-        if( semaphores[i]->Event == NULL )
+        else
         {
-            // This is a semaphore that is not in a pending signal
-            // or signaled state.  What should happen here?
-            return CL_INVALID_OPERATION;
+            // The signal has not been enqueued yet, so wait for a user event
+            // that will be completed when a later signal completes.  Each
+            // wait needs its own signal, so each wait gets its own user
+            // event.
+            cl_event waitEvent = pIntercept->dispatch().clCreateUserEvent(
+                semaphore->Context,
+                &retVal );
+            if( waitEvent != NULL )
+            {
+                combinedWaitList.push_back(waitEvent);
+                addedWaitEvents.push_back(
+                    std::make_pair(semaphore, waitEvent));
+                semaphore->WaitEvents.push_back(waitEvent);
+            }
         }
-        combinedWaitList.push_back(
-            semaphores[i]->Event);
     }
 
-    cl_int retVal = pIntercept->dispatch().clEnqueueMarkerWithWaitList(
-        command_queue,
-        (cl_uint)combinedWaitList.size(),
-        combinedWaitList.data(),
-        event );
+    if( retVal == CL_SUCCESS )
+    {
+        retVal = pIntercept->dispatch().clEnqueueMarkerWithWaitList(
+            command_queue,
+            (cl_uint)combinedWaitList.size(),
+            combinedWaitList.data(),
+            event );
+    }
 
-    for( cl_uint i = 0; i < num_semaphores; i++ )
+    if( retVal == CL_SUCCESS )
     {
-        pIntercept->dispatch().clReleaseEvent(
-            semaphores[i]->Event);
-        semaphores[i]->Event = NULL;
+        for( auto& taken : takenSignalEvents )
+        {
+            pIntercept->dispatch().clReleaseEvent(taken.second);
+        }
+    }
+    else
+    {
+        // Nothing was enqueued, so put the semaphores back the way they
+        // were, newest first.
+        for( auto iter = addedWaitEvents.rbegin(); iter != addedWaitEvents.rend(); ++iter )
+        {
+            iter->first->WaitEvents.pop_back();
+            pIntercept->dispatch().clReleaseEvent(iter->second);
+        }
+        for( auto iter = takenSignalEvents.rbegin(); iter != takenSignalEvents.rend(); ++iter )
+        {
+            iter->first->SignalEvent = iter->second;
+        }
     }
 
     return retVal;
@@ -492,7 +588,36 @@ cl_int CL_API_CALL clEnqueueSignalSemaphoresKHR_EMU(
         {
             return CL_INVALID_SEMAPHORE_KHR;
         }
-        if( semaphores[i]->Event != NULL )
+    }
+
+    // Hold the locks for all of the semaphores from the state check until
+    // the signal is recorded, so a concurrent signal cannot also see an
+    // unsignaled semaphore.  The locks are taken in address order to avoid
+    // deadlocks.
+    std::vector<cli_semaphore*> lockOrder(
+        semaphores,
+        semaphores + num_semaphores);
+    std::sort(lockOrder.begin(), lockOrder.end());
+    lockOrder.erase(
+        std::unique(lockOrder.begin(), lockOrder.end()),
+        lockOrder.end());
+
+    std::vector<std::unique_lock<std::mutex>> locks;
+    for( auto semaphore : lockOrder )
+    {
+        locks.emplace_back(semaphore->Mutex);
+    }
+
+    for( auto semaphore : lockOrder )
+    {
+        // Each signal completes one pending wait, and at most one signal
+        // may be left without a wait.
+        size_t  numSignals = std::count(
+            semaphores,
+            semaphores + num_semaphores,
+            semaphore);
+        if( semaphore->SignalEvent != NULL ||
+            numSignals > semaphore->WaitEvents.size() + 1 )
         {
             // This is a semaphore that is in a pending signal or signaled
             // state.  What should happen here?
@@ -512,11 +637,46 @@ cl_int CL_API_CALL clEnqueueSignalSemaphoresKHR_EMU(
         event_wait_list,
         event );
 
-    for( cl_uint i = 0; i < num_semaphores; i++ )
+    if( retVal == CL_SUCCESS )
     {
-        semaphores[i]->Event = *event;
-        pIntercept->dispatch().clRetainEvent(
-            semaphores[i]->Event );
+        for( cl_uint i = 0; i < num_semaphores; i++ )
+        {
+            cli_semaphore*  semaphore = semaphores[i];
+
+            if( !semaphore->WaitEvents.empty() )
+            {
+                // A wait was already enqueued for this signal.  Complete the
+                // oldest pending wait's user event from a callback, rather
+                // than blocking until the signal completes.  The callback
+                // takes ownership of the user event.
+                cl_event    waitEvent = semaphore->WaitEvents.front();
+                semaphore->WaitEvents.pop_front();
+
+                cl_int  errorCode = pIntercept->dispatch().clSetEventCallback(
+                    *event,
+                    CL_COMPLETE,
+                    semaphoreSignalCallback,
+                    waitEvent );
+                if( errorCode != CL_SUCCESS )
+                {
+                    // The signal has already been enqueued, so it is still
+                    // reported as successful, and its event is still
+                    // returned.  The wait is failed instead, which
+                    // propagates the error to the commands waiting on it.
+                    pIntercept->dispatch().clSetUserEventStatus(
+                        waitEvent,
+                        errorCode );
+                    pIntercept->dispatch().clReleaseEvent(
+                        waitEvent );
+                }
+            }
+            else
+            {
+                semaphore->SignalEvent = *event;
+                pIntercept->dispatch().clRetainEvent(
+                    semaphore->SignalEvent );
+            }
+        }
     }
 
     if( local_event != NULL )
@@ -565,7 +725,7 @@ cl_int CL_API_CALL clGetSemaphoreInfoKHR_EMU(
             auto*   ptr = (cl_uint*)param_value;
             return pIntercept->writeParamToMemory(
                 param_value_size,
-                semaphore->RefCount,
+                semaphore->RefCount.load(),
                 param_value_size_ret,
                 ptr );
         }
@@ -588,11 +748,12 @@ cl_int CL_API_CALL clGetSemaphoreInfoKHR_EMU(
             // semaphore is in the unsignaled state and one if it is in
             // the signaled state.
             cl_semaphore_payload_khr payload = 0;
-            if( semaphore->Event != NULL )
+            std::lock_guard<std::mutex> lock(semaphore->Mutex);
+            if( semaphore->SignalEvent != NULL )
             {
                 cl_int  eventStatus = 0;
                 pIntercept->dispatch().clGetEventInfo(
-                    semaphore->Event,
+                    semaphore->SignalEvent,
                     CL_EVENT_COMMAND_EXECUTION_STATUS,
                     sizeof( eventStatus ),
                     &eventStatus,
@@ -654,9 +815,23 @@ cl_int CL_API_CALL clReleaseSemaphoreKHR_EMU(
         return CL_INVALID_SEMAPHORE_KHR;
     }
 
-    semaphore->RefCount--;
-    if( semaphore->RefCount == 0 )
+    if( --semaphore->RefCount == 0 )
     {
+        if( semaphore->SignalEvent != NULL )
+        {
+            pIntercept->dispatch().clReleaseEvent(
+                semaphore->SignalEvent );
+        }
+        for( auto waitEvent : semaphore->WaitEvents )
+        {
+            // Waits that were enqueued without a signal would otherwise
+            // never complete.
+            pIntercept->dispatch().clSetUserEventStatus(
+                waitEvent,
+                CL_INVALID_SEMAPHORE_KHR );
+            pIntercept->dispatch().clReleaseEvent(
+                waitEvent );
+        }
         delete semaphore;
     }
     return CL_SUCCESS;
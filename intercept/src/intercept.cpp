@@ -85,14 +85,86 @@ static inline uint64_t Hash(
 
     return (((uint64_t)hi)<<32)|lo;
 }
+
+// Computes the same hash as Hash(), but incrementally, for data that is
+// produced in pieces.  The pieces may be any size.
+struct SHashContext
+{
+    SHashContext() :
+        a(0x428a2f98), hi(0x71374491), lo(0xb5c0fbcf),
+        pendingCount(0) {}
+
+    void    update(
+                const void* ptr,
+                size_t count )
+    {
+        const uint8_t*  data = reinterpret_cast<const uint8_t*>(ptr);
+
+        // Complete a partial value from the previous piece, if any.
+        while( pendingCount != 0 && pendingCount < sizeof(pending) &&
+               count != 0 )
+        {
+            pending[ pendingCount++ ] = *(data++);
+            count--;
+            if( pendingCount == sizeof(uint32_t) )
+            {
+                uint32_t    value = 0;
+                memcpy( &value, pending, sizeof(value) );
+                a ^= value;
+                HASH_JENKINS_MIX( a, hi, lo );
+                pendingCount = 0;
+            }
+        }
+
+        while( count >= sizeof(uint32_t) )
+        {
+            uint32_t    value = 0;
+            memcpy( &value, data, sizeof(value) );
+            a ^= value;
+            HASH_JENKINS_MIX( a, hi, lo );
+            data += sizeof(uint32_t);
+            count -= sizeof(uint32_t);
+        }
+
+        while( count != 0 && pendingCount < sizeof(pending) )
+        {
+            pending[ pendingCount++ ] = *(data++);
+            count--;
+        }
+    }
+
+    uint64_t    final()
+    {
+        if( pendingCount != 0 )
+        {
+            uint32_t extraValue = 0;
+            for( size_t i = 0; i < pendingCount; i++) {
+                extraValue += pending[i] << (i * 8);
+            }
+
+            a ^= extraValue;
+            HASH_JENKINS_MIX( a, hi, lo );
+            pendingCount = 0;
+        }
+
+        return (((uint64_t)hi)<<32)|lo;
+    }
+
+    unsigned int    a, hi, lo;
+    uint8_t         pending[ sizeof(uint32_t) ];
+    size_t          pendingCount;
+};
 #undef HASH_JENKINS_MIX
 
 const char* CLIntercept::sc_URL = "https://github.com/intel/opencl-intercept-layer";
 const char* CLIntercept::sc_DumpDirectoryName = "CLIntercept_Dump";
 const char* CLIntercept::sc_ReportFileName = "clintercept_report.txt";
+const char* CLIntercept::sc_KernelISAManifestFileName = "CLI_kernel_isa_manifest.txt";
+const char* CLIntercept::sc_LWSTuningFileName = "CLI_lws_tuning.txt";
 const char* CLIntercept::sc_LogFileName = "clintercept_log.txt";
 const char* CLIntercept::sc_PerfCountersFileNamePrefix = "clintercept_perfcounter";
 const char* CLIntercept::sc_TraceFileName = "clintercept_trace.json";
+const char* CLIntercept::sc_StreamCaptureFileName = "CLI_stream_capture.bin";
 
 ///////////////////////////////////////////////////////////////////////////////
 //
@@ -137,6 +209,18 @@ CLIntercept::CLIntercept( void* pGlobalData )
     m_LoggedCLInfo = false;
 
     m_EnqueueCounter.store(0, std::memory_order::memory_order_relaxed);
+    m_InitializeBuffersCounter.store(0, std::memory_order::memory_order_relaxed);
+
+    m_InjectionFileSetValid = false;
+
+    m_KernelISAManifestStarted = false;
+
+    m_ThreadPoolShutdown = false;
+    m_ProgramDumpsDropped = 0;
+
+    m_HotReloadCheckPending = false;
+
+    m_LWSTuningDatabaseLoaded = false;
 
     m_EventsChromeTraced = 0;
     m_ProgramNumber = 0;
@@ -151,6 +235,7 @@ CLIntercept::CLIntercept( void* pGlobalData )
 
     m_CaptureReplayKernelEnqueueSkipCounter = 0;
     m_CaptureReplayKernelEnqueueCaptureCounter = 0;
+    m_CaptureReplayTriggerArmed = false;
 
     m_AubCaptureStarted = false;
     m_AubCaptureKernelEnqueueSkipCounter = 0;
@@ -179,11 +264,48 @@ CLIntercept::CLIntercept( void* pGlobalData )
 //
 CLIntercept::~CLIntercept()
 {
+    // Any hot reload checks that are still queued are dropped, since it is
+    // not safe to call into OpenCL while the process is terminating, and any
+    // program dumps that are queued from now on are dropped.
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_ThreadPoolShutdown = true;
+    }
+
+    // SPIR-V jobs that have not started yet are dropped rather than waiting
+    // for CLANG to compile each of them.  Jobs that are already running are
+    // waited for, except on Windows.
+    size_t  spirvJobsDropped = m_SPIRVJobPool.cancel();
+
+#if defined(_WIN32)
+    // On Windows we get here from DllMain while holding the loader lock, and
+    // joining the worker threads from DllMain can deadlock, because exiting
+    // threads need the loader lock, so detach them instead.  Tasks that are
+    // already running use this object, so detaching waits for them to
+    // finish first.  They check the shutdown flag set above and return
+    // early where they can.
+    m_ThreadPool.detach();
+    m_SPIRVJobPool.detach();
+#else
+    m_ThreadPool.stop();
+    m_SPIRVJobPool.stop();
+#endif
     stopAubCapture( NULL );
     report();
 
     std::lock_guard<std::mutex> lock(m_Mutex);
 
+    if( m_ProgramDumpsDropped )
+    {
+        logf( "Dropped %u queued program dump(s) at shutdown.\n",
+            m_ProgramDumpsDropped );
+    }
+    if( spirvJobsDropped )
+    {
+        logf( "Dropped %zu queued SPIR-V job(s) at shutdown.\n",
+            spirvJobsDropped );
+    }
+
     log( "CLIntercept is shutting down...\n" );
 
     // Set the dispatch to the dummy dispatch.  The destructor is called
@@ -268,6 +390,7 @@ CLIntercept::~CLIntercept()
     }
 
     m_ChromeTrace.flush();
+    m_StreamCapture.flush();
 
     log( "... shutdown complete.\n" );
     m_InterceptLog.close();
@@ -332,6 +455,26 @@ static std::string GetNonDefaultString(
     return ss.str();
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//
+static void formatLocalWorkSize(
+    const cl_uint work_dim,
+    const size_t* lws,
+    std::string& str )
+{
+    if( lws == NULL || lws[0] == 0 )
+    {
+        str = "NULL";
+        return;
+    }
+
+    str = std::to_string( lws[0] );
+    for( cl_uint d = 1; d < work_dim; d++ )
+    {
+        str += "x" + std::to_string( lws[d] );
+    }
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 bool CLIntercept::init()
@@ -450,6 +593,27 @@ bool CLIntercept::init()
         m_ChromeTrace.addProcessMetadata( processName );
     }
 
+    if( m_Config.CaptureStream )
+    {
+        std::string fileName = "";
+
+        OS().GetDumpDirectoryName( sc_DumpDirectoryName, fileName );
+        fileName += "/Replay/";
+        fileName += sc_StreamCaptureFileName;
+
+        OS().MakeDumpDirectories( fileName );
+        if( m_Config.UniqueFiles )
+        {
+            fileName = Utils::GetUniqueFileName(fileName);
+        }
+
+        m_StreamCapture.init( fileName );
+        if( !m_StreamCapture.enabled() )
+        {
+            log( "Couldn't open stream capture file: " + fileName + "\n" );
+        }
+    }
+
     std::string name = "";
     OS().GetCLInterceptName( name );
 
@@ -794,6 +958,20 @@ void CLIntercept::report()
     }
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//
+static const char* getUSMTypeName(
+    cl_unified_shared_memory_type_intel type )
+{
+    switch( type )
+    {
+    case CL_MEM_TYPE_HOST_INTEL:    return "Host";
+    case CL_MEM_TYPE_DEVICE_INTEL:  return "Device";
+    case CL_MEM_TYPE_SHARED_INTEL:  return "Shared";
+    default:                        return "Unknown";
+    }
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 void CLIntercept::writeReport(
@@ -957,6 +1135,286 @@ void CLIntercept::writeReport(
         }
     }
 
+    if( config().ProgramBuildTiming &&
+        !m_ProgramBuildTimingStatsMap.empty() )
+    {
+        os << std::endl << "Program Build Timing Results:" << std::endl;
+
+        uint64_t    totalTotalNS = 0;
+        uint64_t    totalRebuilds = 0;
+        uint64_t    totalRebuildNS = 0;
+        size_t      longestName = 32;
+
+        // Programs built for multiple devices list all of the devices.
+        std::map< std::vector< cl_device_id >, std::string >   deviceNames;
+        for( const auto& i : m_ProgramBuildTimingStatsMap )
+        {
+            const SProgramBuildTimingStats& stats = i.second;
+
+            std::string&    deviceName = deviceNames[i.first.Devices];
+            if( deviceName.empty() )
+            {
+                for( const auto& device : i.first.Devices )
+                {
+                    if( !deviceName.empty() )
+                    {
+                        deviceName += " + ";
+                    }
+                    deviceName += m_DeviceInfoMap[device].NameForReport;
+                }
+            }
+
+            totalTotalNS += stats.TotalNS;
+            totalRebuilds += stats.NumberOfCalls - 1;
+            totalRebuildNS += stats.TotalNS - stats.FirstNS;
+            longestName = std::max< size_t >( deviceName.length(), longestName );
+        }
+
+        os << std::endl << "Total Time (ns): " << totalTotalNS << std::endl;
+        os << "Total Rebuilds: " << totalRebuilds << std::endl;
+        os << "Total Rebuild Time (ns): " << totalRebuildNS << std::endl;
+
+        os << std::endl
+            << std::right << std::setw(16) << "Program Hash" << ", "
+            << std::right << std::setw(16) << "Options Hash" << ", "
+            << std::right << std::setw( 7) << "Type" << ", "
+            << std::right << std::setw(longestName) << "Device" << ", "
+            << std::right << std::setw( 6) << "Calls" << ", "
+            << std::right << std::setw( 8) << "Rebuilds" << ", "
+            << std::right << std::setw(13) << "Time (ns)" << ", "
+            << std::right << std::setw(13) << "Min (ns)" << ", "
+            << std::right << std::setw(13) << "Max (ns)" << ", "
+            << std::right << std::setw(11) << "Source Size" << ", "
+            << std::right << std::setw( 7) << "Kernels" << ", "
+            << "Options" << std::endl;
+
+        for( const auto& i : m_ProgramBuildTimingStatsMap )
+        {
+            const SProgramBuildTimingKey&   key = i.first;
+            const SProgramBuildTimingStats& stats = i.second;
+            const std::string&  deviceName = deviceNames[key.Devices];
+
+            char    programHash[32] = "";
+            char    optionsHash[32] = "";
+            CLI_SPRINTF( programHash, 32, "%016" PRIX64, key.ProgramHash );
+            CLI_SPRINTF( optionsHash, 32, "%016" PRIX64, key.OptionsHash );
+
+            os << std::right << std::setw(16) << programHash << ", "
+                << std::right << std::setw(16) << optionsHash << ", "
+                << std::right << std::setw( 7) << key.Operation << ", "
+                << std::right << std::setw(longestName) << deviceName << ", "
+                << std::right << std::setw( 6) << stats.NumberOfCalls << ", "
+                << std::right << std::setw( 8) << stats.NumberOfCalls - 1 << ", "
+                << std::right << std::setw(13) << stats.TotalNS << ", "
+                << std::right << std::setw(13) << stats.MinNS << ", "
+                << std::right << std::setw(13) << stats.MaxNS << ", "
+                << std::right << std::setw(11) << stats.SourceSize << ", "
+                << std::right << std::setw( 7) << stats.NumKernels << ", "
+                << stats.Options << std::endl;
+        }
+    }
+
+    if( config().RedundantWorkChecking &&
+        !m_RedundantWorkStatsMap.empty() )
+    {
+        os << std::endl << "Redundant Work:" << std::endl;
+
+        // Estimate the wasted time as the average time for the work times
+        // the number of times the work was redundant, and rank by it.
+        std::vector< std::pair<uint64_t, std::string> > ranked;
+        uint64_t    totalWastedNS = 0;
+
+        for( const auto& i : m_RedundantWorkStatsMap )
+        {
+            const SRedundantWorkStats&  stats = i.second;
+            if( stats.Count > stats.MaxLive )
+            {
+                uint64_t    wastedNS =
+                    stats.TotalNS / stats.Count * ( stats.Count - stats.MaxLive );
+                ranked.push_back( std::make_pair( wastedNS, i.first ) );
+                totalWastedNS += wastedNS;
+            }
+        }
+
+        std::stable_sort( ranked.begin(), ranked.end(),
+            []( const std::pair<uint64_t, std::string>& a,
+                const std::pair<uint64_t, std::string>& b ) {
+                return a.first > b.first;
+            } );
+
+        if( ranked.empty() )
+        {
+            os << std::endl << "No redundant work detected." << std::endl;
+        }
+        else
+        {
+            if( config().HostPerformanceTiming )
+            {
+                os << std::endl << "Total Estimated Wasted Time (ns): " << totalWastedNS << std::endl;
+            }
+            else
+            {
+                os << std::endl << "Enable HostPerformanceTiming to estimate wasted time." << std::endl;
+            }
+
+            os << std::endl
+                << std::right << std::setw( 6) << "Calls" << ", "
+                << std::right << std::setw( 9) << "Redundant" << ", "
+                << std::right << std::setw(13) << "Wasted (ns)" << ", "
+                << "Work" << std::endl;
+
+            for( const auto& r : ranked )
+            {
+                const SRedundantWorkStats&  stats = m_RedundantWorkStatsMap.at( r.second );
+
+                os << std::right << std::setw( 6) << stats.Count << ", "
+                    << std::right << std::setw( 9) << stats.Count - stats.MaxLive << ", "
+                    << std::right << std::setw(13) << r.first << ", "
+                    << r.second << std::endl;
+            }
+        }
+    }
+
+    if( config().AutoCreateSPIRV &&
+        !m_SPIRVJobTimings.empty() )
+    {
+        os << std::endl << "AutoCreateSPIRV Timing Results:" << std::endl;
+
+        uint64_t    totalNS = 0;
+        size_t      longestName = 32;
+
+        for( const auto& timing : m_SPIRVJobTimings )
+        {
+            totalNS += timing.NS;
+            longestName = std::max< size_t >( timing.Name.length(), longestName );
+        }
+
+        os << std::endl << "Total Time (ns): " << totalNS << std::endl;
+
+        os << std::endl
+            << std::right << std::setw(longestName) << "SPIR-V Module" << ", "
+            << std::right << std::setw( 8) << "Result" << ", "
+            << std::right << std::setw(13) << "Time (ns)" << std::endl;
+
+        for( const auto& timing : m_SPIRVJobTimings )
+        {
+            os << std::right << std::setw(longestName) << timing.Name << ", "
+                << std::right << std::setw( 8) << timing.Result << ", "
+                << std::right << std::setw(13) << timing.NS << std::endl;
+        }
+    }
+
+    if( config().Emulate_cl_intel_unified_shared_memory &&
+        config().EmulatedUSMPool &&
+        !m_USMPoolStatsMap.empty() )
+    {
+        os << std::endl << "Emulated USM Pool:" << std::endl;
+
+        os << std::endl
+            << std::right << std::setw( 6) << "Type" << ", "
+            << std::right << std::setw( 6) << "Slabs" << ", "
+            << std::right << std::setw(12) << "Slab Bytes" << ", "
+            << std::right << std::setw(10) << "Pooled" << ", "
+            << std::right << std::setw(10) << "Reused" << ", "
+            << std::right << std::setw(10) << "Freed" << ", "
+            << std::right << std::setw(10) << "Unpooled" << ", "
+            << std::right << std::setw(12) << "Bytes In Use" << ", "
+            << std::right << std::setw(12) << "Peak Bytes" << std::endl;
+
+        for( const auto& i : m_USMPoolStatsMap )
+        {
+            const SUSMPoolStats&    stats = i.second;
+
+            os << std::right << std::setw( 6) << getUSMTypeName(i.first) << ", "
+                << std::right << std::setw( 6) << stats.NumSlabs << ", "
+                << std::right << std::setw(12) << stats.SlabBytes << ", "
+                << std::right << std::setw(10) << stats.NumPooledAllocs << ", "
+                << std::right << std::setw(10) << stats.NumReusedAllocs << ", "
+                << std::right << std::setw(10) << stats.NumPooledFrees << ", "
+                << std::right << std::setw(10) << stats.NumUnpooledAllocs << ", "
+                << std::right << std::setw(12) << stats.BytesInUse << ", "
+                << std::right << std::setw(12) << stats.PeakBytesInUse << std::endl;
+        }
+    }
+
+    if( config().Emulate_cl_intel_unified_shared_memory &&
+        !m_USMHintStatsMap.empty() )
+    {
+        os << std::endl << "Emulated USM Migrations and Advice:" << std::endl;
+
+        os << std::endl
+            << std::right << std::setw( 7) << "Type" << ", "
+            << std::right << std::setw(10) << "Migrations" << ", "
+            << std::right << std::setw( 8) << "To Host" << ", "
+            << std::right << std::setw( 8) << "Markers" << ", "
+            << std::right << std::setw(14) << "Migrated Bytes" << ", "
+            << "Advice" << std::endl;
+
+        for( const auto& i : m_USMHintStatsMap )
+        {
+            const SUSMHintStats&    stats = i.second;
+
+            std::string advice;
+            for( const auto& a : stats.AdviceCounts )
+            {
+                if( !advice.empty() )
+                {
+                    advice += ", ";
+                }
+                advice += enumName().name( a.first );
+                advice += " x ";
+                advice += std::to_string( a.second );
+            }
+
+            os << std::right << std::setw( 7) << getUSMTypeName(i.first) << ", "
+                << std::right << std::setw(10) << stats.NumMigrations << ", "
+                << std::right << std::setw( 8) << stats.NumMigrationsToHost << ", "
+                << std::right << std::setw( 8) << stats.NumMigrationMarkers << ", "
+                << std::right << std::setw(14) << stats.MigratedBytes << ", "
+                << advice << std::endl;
+        }
+    }
+
+    if( config().LocalWorkSizeAutotuning )
+    {
+        os << std::endl << "Local Work Size Autotuning Results:" << std::endl;
+
+        size_t  numTuned = 0;
+        for( const auto& i : m_LWSTuningInfoMap )
+        {
+            const SLWSTuningInfo&   info = i.second;
+            if( info.Done && info.Candidates.size() > 1 )
+            {
+                if( numTuned++ == 0 )
+                {
+                    os << std::endl
+                        << std::right << std::setw(10) << "Candidates" << ", "
+                        << std::right << std::setw(13) << "Original (ns)" << ", "
+                        << std::right << std::setw(13) << "Tuned (ns)" << ", "
+                        << std::right << std::setw(11) << "Tuned LWS" << ", "
+                        << "Device, Kernel, Program Hash, Options Hash, Work Dim, GWS" << std::endl;
+                }
+
+                std::string lws;
+                formatLocalWorkSize( info.WorkDim, info.Best, lws );
+
+                std::string key = i.first;
+                std::replace( key.begin(), key.end(), '\t', ',' );
+
+                os << std::right << std::setw(10) << info.Candidates.size() << ", "
+                    << std::right << std::setw(13) << info.BaselineNS << ", "
+                    << std::right << std::setw(13) << info.BestNS << ", "
+                    << std::right << std::setw(11) << lws << ", "
+                    << key << std::endl;
+            }
+        }
+
+        if( numTuned == 0 )
+        {
+            os << std::endl << "No local work sizes were tuned." << std::endl;
+        }
+    }
+
 #if defined(USE_MDAPI)
     if( config().DevicePerfCounterEventBasedSampling )
     {
@@ -970,7 +1428,8 @@ void CLIntercept::writeReport(
 void CLIntercept::addShortKernelName(
     const std::string& kernelName )
 {
-    if( kernelName.length() > m_Config.LongKernelNameCutoff )
+    if( kernelName.length() > m_Config.LongKernelNameCutoff &&
+        m_LongKernelNameMap.find( kernelName ) == m_LongKernelNameMap.end() )
     {
         std::string shortKernelName("k_");
         shortKernelName += std::to_string(m_KernelID);
@@ -984,6 +1443,54 @@ void CLIntercept::addShortKernelName(
     }
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::setShortKernelNames(
+    SKernelInfo& kernelInfo )
+{
+    // We're already in a critical section when we get here, so we don't need to
+    // grab the critical section again.
+
+    addShortKernelName( kernelInfo.KernelName );
+
+    CLongKernelNameMap::const_iterator i =
+        m_LongKernelNameMap.find( kernelInfo.KernelName );
+
+    const std::string& shortKernelName =
+        ( i != m_LongKernelNameMap.end() ) ?
+        i->second :
+        kernelInfo.KernelName;
+
+    CLI_ASSERT( shortKernelName.length() <= m_Config.LongKernelNameCutoff );
+
+    kernelInfo.ShortKernelName =
+        &*m_KernelNameSet.insert( shortKernelName ).first;
+    kernelInfo.ShortKernelNameWithHash = kernelInfo.ShortKernelName;
+
+    if( config().KernelNameHashTracking )
+    {
+        char    hashString[256] = "";
+        if( config().OmitProgramNumber )
+        {
+            CLI_SPRINTF( hashString, 256, "$%08X_%04u_%08X",
+                (unsigned int)kernelInfo.ProgramHash,
+                kernelInfo.CompileCount,
+                (unsigned int)kernelInfo.OptionsHash );
+        }
+        else
+        {
+            CLI_SPRINTF( hashString, 256, "$%04u_%08X_%04u_%08X",
+                kernelInfo.ProgramNumber,
+                (unsigned int)kernelInfo.ProgramHash,
+                kernelInfo.CompileCount,
+                (unsigned int)kernelInfo.OptionsHash );
+        }
+
+        kernelInfo.ShortKernelNameWithHash =
+            &*m_KernelNameSet.insert( shortKernelName + hashString ).first;
+    }
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 void CLIntercept::getCallLoggingPrefix(
@@ -3153,6 +3660,10 @@ void CLIntercept::logBuild(
 
     std::lock_guard<std::mutex> lock(m_Mutex);
 
+    // If the program was built from the program binary cache, query the
+    // program created from the cached binaries instead.
+    const cl_program    queryProgram = findBinaryCacheProgram( program );
+
     cl_device_id*   localDeviceList = NULL;
 
     cl_int  errorCode = CL_SUCCESS;
@@ -3166,7 +3677,7 @@ void CLIntercept::logBuild(
         ( deviceList == NULL ) )
     {
         errorCode = allocateAndGetProgramDeviceList(
-            program,
+            queryProgram,
             numDevices,
             localDeviceList );
         if( errorCode == CL_SUCCESS )
@@ -3214,7 +3725,7 @@ void CLIntercept::logBuild(
             {
                 cl_build_status buildStatus = CL_BUILD_NONE;
                 errorCode = dispatch().clGetProgramBuildInfo(
-                    program,
+                    queryProgram,
                     deviceList[ i ],
                     CL_PROGRAM_BUILD_STATUS,
                     sizeof( buildStatus ),
@@ -3263,7 +3774,7 @@ void CLIntercept::logBuild(
 
             size_t  buildLogSize = 0;
             errorCode = dispatch().clGetProgramBuildInfo(
-                program,
+                queryProgram,
                 deviceList[ i ],
                 CL_PROGRAM_BUILD_LOG,
                 0,
@@ -3276,7 +3787,7 @@ void CLIntercept::logBuild(
                 if( buildLog )
                 {
                     dispatch().clGetProgramBuildInfo(
-                        program,
+                        queryProgram,
                         deviceList[ i ],
                         CL_PROGRAM_BUILD_LOG,
                         buildLogSize,
@@ -3320,46 +3831,146 @@ void CLIntercept::logBuild(
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::logError(
-    const char* functionName,
-    cl_int errorCode )
+void CLIntercept::addProgramBuildTiming(
+    clock::time_point buildTimeStart,
+    clock::time_point buildTimeEnd,
+    const cl_program program,
+    cl_uint numDevices,
+    const cl_device_id* deviceList,
+    const char* options,
+    const char* operation )
 {
-    std::lock_guard<std::mutex> lock(m_Mutex);
-    logf( "ERROR! %s returned %s (%d)\n", functionName, enumName().name(errorCode).c_str(), errorCode );
-}
+    uint64_t    buildNS =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            buildTimeEnd - buildTimeStart ).count();
 
-///////////////////////////////////////////////////////////////////////////////
-//
-void CLIntercept::logFlushOrFinishAfterEnqueueStart(
-    const char* flushOrFinish,
-    const char* functionName )
-{
     std::lock_guard<std::mutex> lock(m_Mutex);
-    logf( "Calling %s after %s...\n", flushOrFinish, functionName );
-}
 
-///////////////////////////////////////////////////////////////////////////////
-//
-void CLIntercept::logFlushOrFinishAfterEnqueueEnd(
-    const char* flushOrFinish,
-    const char* functionName,
-    cl_int errorCode )
-{
-    std::lock_guard<std::mutex> lock(m_Mutex);
-    logf( "...%s after %s returned %s (%d)\n", flushOrFinish, functionName, enumName().name( errorCode ).c_str(), errorCode );
-}
+    // If the program was built from the program binary cache, query the
+    // program created from the cached binaries instead.
+    const cl_program    queryProgram = findBinaryCacheProgram( program );
 
-///////////////////////////////////////////////////////////////////////////////
-//
-void CLIntercept::logKernelInfo(
-    const cl_kernel* kernels,
-    cl_uint numKernels )
-{
-    if( numKernels > 0 )
-    {
-        std::lock_guard<std::mutex> lock(m_Mutex);
+    cl_device_id*   localDeviceList = NULL;
 
-        cl_int  errorCode = CL_SUCCESS;
+    cl_int  errorCode = CL_SUCCESS;
+
+    if( deviceList == NULL )
+    {
+        errorCode = allocateAndGetProgramDeviceList(
+            queryProgram,
+            numDevices,
+            localDeviceList );
+        if( errorCode == CL_SUCCESS )
+        {
+            deviceList = localDeviceList;
+        }
+    }
+
+    if( errorCode == CL_SUCCESS )
+    {
+        const SProgramInfo& programInfo = m_ProgramInfoMap[ program ];
+
+        // The source size is the size of the program source, if the program
+        // was created from source, or the size of the program IL otherwise.
+        // It's OK if these queries fail.
+        size_t  sourceSize = 0;
+        dispatch().clGetProgramInfo(
+            program,
+            CL_PROGRAM_SOURCE,
+            0,
+            NULL,
+            &sourceSize );
+        if( sourceSize <= 1 )
+        {
+            sourceSize = 0;
+            dispatch().clGetProgramInfo(
+                program,
+                CL_PROGRAM_IL,
+                0,
+                NULL,
+                &sourceSize );
+        }
+
+        // Compiled programs do not have any kernels yet.
+        size_t  numKernels = 0;
+        dispatch().clGetProgramInfo(
+            queryProgram,
+            CL_PROGRAM_NUM_KERNELS,
+            sizeof( numKernels ),
+            &numKernels,
+            NULL );
+
+        SProgramBuildTimingKey  key;
+        key.ProgramHash = programInfo.ProgramHash;
+        key.OptionsHash = programInfo.OptionsHash;
+        key.Operation = operation;
+        key.Devices.assign( deviceList, deviceList + numDevices );
+
+        for( cl_uint i = 0; i < numDevices; i++ )
+        {
+            cacheDeviceInfo( deviceList[i] );
+        }
+
+        SProgramBuildTimingStats&   stats = m_ProgramBuildTimingStatsMap[ key ];
+        if( stats.NumberOfCalls == 0 )
+        {
+            stats.Options = options ? options : "";
+            stats.FirstNS = buildNS;
+        }
+        stats.SourceSize = sourceSize;
+        stats.NumKernels = numKernels;
+
+        stats.NumberOfCalls++;
+        stats.TotalNS += buildNS;
+        stats.MinNS = std::min( stats.MinNS, buildNS );
+        stats.MaxNS = std::max( stats.MaxNS, buildNS );
+    }
+
+    delete [] localDeviceList;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::logError(
+    const char* functionName,
+    cl_int errorCode )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    logf( "ERROR! %s returned %s (%d)\n", functionName, enumName().name(errorCode).c_str(), errorCode );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::logFlushOrFinishAfterEnqueueStart(
+    const char* flushOrFinish,
+    const char* functionName )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    logf( "Calling %s after %s...\n", flushOrFinish, functionName );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::logFlushOrFinishAfterEnqueueEnd(
+    const char* flushOrFinish,
+    const char* functionName,
+    cl_int errorCode )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    logf( "...%s after %s returned %s (%d)\n", flushOrFinish, functionName, enumName().name( errorCode ).c_str(), errorCode );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::logKernelInfo(
+    const cl_kernel* kernels,
+    cl_uint numKernels )
+{
+    if( numKernels > 0 )
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        cl_int  errorCode = CL_SUCCESS;
 
         // We can share the program and device list for all kernels.
 
@@ -4042,2349 +4653,3817 @@ void CLIntercept::overrideNullLocalWorkSize(
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::combineProgramStrings(
-    cl_uint& count,
-    const char**& strings,
-    const size_t*& lengths,
-    char*& singleString ) const
+bool CLIntercept::autotuneLocalWorkSize(
+    const cl_command_queue queue,
+    const cl_kernel kernel,
+    const cl_uint work_dim,
+    const size_t* global_work_size,
+    const size_t*& local_work_size,
+    size_t* tunedLocalWorkSize,
+    std::string& key,
+    size_t& candidate )
 {
-    size_t  allocSize = 0;
-    cl_uint i = 0;
-
-    for( i = 0; i < count; i++ )
+    if( local_work_size != NULL &&
+        !config().LocalWorkSizeAutotuningOverrideApp )
     {
-        size_t  length = 0;
-        if( ( lengths == NULL ) ||
-            ( lengths[i] == 0 ) )
-        {
-            if( strings != NULL && strings[i] != NULL )
-            {
-                length = strlen( strings[i] );
-            }
-        }
-        else
-        {
-            length = lengths[i];
-        }
-        allocSize += length;
+        return false;
     }
 
-    // Allocate some extra to make sure we're null terminated.
-    allocSize++;
+    // If tuning is already done for this kernel, queue, and global work
+    // size, use the local work size that was chosen.
+    SLWSTuningDecisionKey   decisionKey;
+    decisionKey.Kernel = kernel;
+    decisionKey.Queue = queue;
+    decisionKey.WorkDim = work_dim;
+    for( cl_uint d = 0; d < 3; d++ )
+    {
+        decisionKey.GWS[d] = d < work_dim ? global_work_size[d] : 1;
+    }
 
-    singleString = new char[ allocSize ];
-    if( singleString )
     {
-        memset( singleString, 0, allocSize );
+        std::lock_guard<std::mutex> decisionLock(m_LWSTuningDecisionMutex);
 
-        char*   pDst = singleString;
-        size_t  remaining = allocSize;
-        for( i = 0; i < count; i++ )
+        CLWSTuningDecisionMap::const_iterator iter =
+            m_LWSTuningDecisionMap.find( decisionKey );
+        if( iter != m_LWSTuningDecisionMap.end() )
         {
-            size_t  length = 0;
-            if( ( lengths == NULL ) ||
-                ( lengths[i] == 0 ) )
-            {
-                if( strings != NULL && strings[i] != NULL )
-                {
-                    length = strlen( strings[i] );
-                }
-            }
-            else
+            const SLWSTuningDecision&   decision = iter->second;
+            if( decision.UseOriginal )
             {
-                length = lengths[i];
+                // Nothing to do.
             }
-            if( length != 0 )
+            else if( decision.LWS[0] == 0 )
             {
-                if( strings != NULL && strings[i] != NULL )
-                {
-                    CLI_MEMCPY(
-                        pDst,
-                        remaining,
-                        strings[i],
-                        length );
-                }
-                pDst += length;
-                remaining -= length;
+                local_work_size = NULL;
             }
-        }
-
-        // Replace any NULL chars between kernels with spaces.
-        if( count > 1 )
-        {
-            for( char* pStr = singleString; pStr < pDst - 1; pStr++ )
+            else
             {
-                if( *pStr == 0x0 )
-                {
-                    *pStr = 0x20;
-                }
+                CLI_MEMCPY( tunedLocalWorkSize, 3 * sizeof(size_t),
+                    decision.LWS, 3 * sizeof(size_t) );
+                local_work_size = tunedLocalWorkSize;
             }
+            return false;
         }
-
-        count = 1;
-        strings = ( const char** )&singleString;
-        lengths = NULL;
     }
-}
 
-///////////////////////////////////////////////////////////////////////////////
-//
-void CLIntercept::incrementProgramCompileCount(
-    const cl_program program )
-{
     std::lock_guard<std::mutex> lock(m_Mutex);
-    m_ProgramInfoMap[ program ].CompileCount++;
-}
-
-///////////////////////////////////////////////////////////////////////////////
-//
-uint64_t CLIntercept::computeHash(
-    const void* ptr,
-    size_t length )
-{
-    uint64_t    hash = 0;
 
-    if( ptr != NULL )
+    if( !m_LWSTuningEventList.empty() )
     {
-        hash = Hash( ptr, length );
+        updateLWSTuningEvents();
+    }
+    if( !m_LWSTuningDatabaseLoaded )
+    {
+        loadLWSTuningDatabase();
     }
 
-    return hash;
-}
-
-///////////////////////////////////////////////////////////////////////////////
-//
-void CLIntercept::saveProgramHash(
-    const cl_program program,
-    uint64_t hash )
-{
-    std::lock_guard<std::mutex> lock(m_Mutex);
-    if( program != NULL )
+    CKernelInfoMap::const_iterator kernelIter = m_KernelInfoMap.find( kernel );
+    if( kernelIter == m_KernelInfoMap.end() )
     {
-        m_ProgramInfoMap[ program ].ProgramHash = hash;
+        return false;
     }
-}
 
-///////////////////////////////////////////////////////////////////////////////
-//
-void CLIntercept::saveProgramOptionsHash(
-    const cl_program program,
-    const char* options )
-{
-    std::lock_guard<std::mutex> lock(m_Mutex);
+    cl_device_id    device = NULL;
+    dispatch().clGetCommandQueueInfo(
+        queue,
+        CL_QUEUE_DEVICE,
+        sizeof( device ),
+        &device,
+        NULL );
 
-    if( program != NULL && options != NULL )
-    {
-        uint64_t hash = computeHash(
-            options,
-            strlen( options ) );
+    cacheDeviceInfo( device );
 
-        m_ProgramInfoMap[ program ].OptionsHash = hash;
-    }
-}
+    // The key is also the first part of each line in the tuning database,
+    // so it must not depend on any handles.
+    {
+        const SKernelInfo&  kernelInfo = kernelIter->second;
 
-///////////////////////////////////////////////////////////////////////////////
-//
-bool CLIntercept::injectProgramSource(
-    const uint64_t hash,
-    cl_uint& count,
-    const char**& strings,
-    const size_t*& lengths,
-    char*& singleString )
-{
-    // We don't expect to get here unless we've combined the app's string(s)
-    // into a single string and computed a hash from it.
-    CLI_ASSERT( singleString );
+        char    hashes[64] = "";
+        CLI_SPRINTF( hashes, 64, "%016" PRIX64 "\t%016" PRIX64,
+            kernelInfo.ProgramHash,
+            kernelInfo.OptionsHash );
 
-    std::lock_guard<std::mutex> lock(m_Mutex);
+        std::string gws = std::to_string( global_work_size[0] );
+        for( cl_uint d = 1; d < work_dim; d++ )
+        {
+            gws += "x" + std::to_string( global_work_size[d] );
+        }
 
-    bool    injected = false;
+        key = m_DeviceInfoMap[ device ].Name + "\t" +
+            kernelInfo.KernelName + "\t" +
+            hashes + "\t" +
+            std::to_string( work_dim ) + "\t" +
+            gws;
+    }
 
-    std::string fileName;
+    SLWSTuningInfo& info = m_LWSTuningInfoMap[ key ];
 
-    // Get the dump directory name.
+    if( !info.Done && info.Candidates.empty() )
     {
-        OS().GetDumpDirectoryNameWithoutPid( sc_DumpDirectoryName, fileName );
-        fileName += "/Inject";
+        info.WorkDim = work_dim;
+        getLWSTuningCandidates(
+            device,
+            kernel,
+            work_dim,
+            global_work_size,
+            local_work_size,
+            info.Candidates );
+        if( info.Candidates.size() <= 1 )
+        {
+            // There is nothing to tune, so keep using the original local
+            // work size.  This is not saved to the tuning database.
+            info.Done = true;
+            CLI_MEMCPY( info.Best, sizeof(info.Best),
+                info.Candidates[0].LWS, sizeof(info.Best) );
+        }
+        else
+        {
+            logf( "Autotuning local work size for %s: %zu candidates\n",
+                key.c_str(),
+                info.Candidates.size() );
+        }
     }
 
-    // Make two candidate file names.  They will have the form:
-    //   CLI_<program number>_<hash>_source.cl, or
-    //   CLI_<hash>_source.cl
+    const size_t*   lws = NULL;
+    bool    isTuningEnqueue = false;
+
+    if( info.Done )
     {
-        char    numberString1[256] = "";
-        CLI_SPRINTF( numberString1, 256, "%04u_%08X",
-            m_ProgramNumber,
-            (unsigned int)hash );
+        // Results loaded from the tuning database may have been tuned for a
+        // different build of this kernel, so check that the local work size
+        // is still valid before using it.
+        SLWSTuningDecision  decision;
+        decision.UseOriginal = !checkLWSTuningResult(
+            device,
+            kernel,
+            work_dim,
+            global_work_size,
+            info.Best );
+        CLI_MEMCPY( decision.LWS, sizeof(decision.LWS),
+            info.Best, sizeof(info.Best) );
+        if( decision.UseOriginal )
+        {
+            logf( "Tuned local work size for %s is not valid for this kernel, using the original local work size.\n",
+                key.c_str() );
+        }
 
-        char    numberString2[256] = "";
-        CLI_SPRINTF( numberString2, 256, "%08X",
-            (unsigned int)hash );
+        std::lock_guard<std::mutex> decisionLock(m_LWSTuningDecisionMutex);
+        m_LWSTuningDecisionMap[ decisionKey ] = decision;
 
-        std::string fileName1;
-        fileName1 = fileName;
-        fileName1 += "/CLI_";
-        fileName1 += numberString1;
-        fileName1 += "_source.cl";
-
-        std::string fileName2;
-        fileName2 = fileName;
-        fileName2 += "/CLI_";
-        fileName2 += numberString2;
-        fileName2 += "_source.cl";
-
-        std::ifstream is;
-
-        is.open(
-            fileName1.c_str(),
-            std::ios::in | std::ios::binary );
-        if( is.good() )
+        if( decision.UseOriginal )
         {
-            log( "Injecting source file: " + fileName1 + "\n" );
+            return false;
         }
-        else
+        lws = info.Best;
+    }
+    else
+    {
+        // Candidates are tried round-robin so any drift in device
+        // performance while tuning affects all candidates equally.  Once
+        // every candidate has been enqueued enough times, the original local
+        // work size is used until all of the results are available.
+        const size_t    numCandidates = info.Candidates.size();
+        const size_t    iterations =
+            std::max< size_t >( config().LocalWorkSizeAutotuningIterations, 1 );
+        if( info.NumEnqueued < numCandidates * iterations )
         {
-            log( "Injection source file doesn't exist: " + fileName1 + "\n" );
-
-            is.clear();
-            is.open(
-                fileName2.c_str(),
-                std::ios::in | std::ios::binary );
-            if( is.good() )
-            {
-                log( "Injecting source file: " + fileName2 + "\n" );
-            }
-            else
-            {
-                log( "Injection source file doesn't exist: " + fileName2 + "\n" );
-            }
+            candidate = info.NumEnqueued % numCandidates;
+            info.NumEnqueued++;
+            info.NumPending++;
+            isTuningEnqueue = true;
         }
-
-        if( is.good() )
+        else
         {
-            // The file exists.  Figure out how big it is.
-            size_t  filesize = 0;
-
-            is.seekg(0, std::ios::end);
-            filesize = (size_t)is.tellg();
-            is.seekg(0, std::ios::beg);
-
-            char*   newSingleString = new char[ filesize + 1 ];
-            if( newSingleString )
-            {
-                memset( newSingleString, 0, filesize + 1 );
-
-                is.read( newSingleString, filesize );
-
-                delete [] singleString;
-
-                singleString = newSingleString;
-                count = 1;
-                strings = ( const char** )&singleString;
-                lengths = NULL;
-
-                injected = true;
-            }
-
-            is.close();
+            candidate = 0;
         }
+        lws = info.Candidates[ candidate ].LWS;
     }
 
-    return injected;
+    if( lws[0] == 0 )
+    {
+        local_work_size = NULL;
+    }
+    else
+    {
+        CLI_MEMCPY( tunedLocalWorkSize, 3 * sizeof(size_t), lws, 3 * sizeof(size_t) );
+        local_work_size = tunedLocalWorkSize;
+    }
+
+    return isTuningEnqueue;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-bool CLIntercept::prependProgramSource(
-    const uint64_t hash,
-    cl_uint& count,
-    const char**& strings,
-    const size_t*& lengths,
-    char*& singleString )
+void CLIntercept::getLWSTuningCandidates(
+    const cl_device_id device,
+    const cl_kernel kernel,
+    const cl_uint work_dim,
+    const size_t* global_work_size,
+    const size_t* local_work_size,
+    std::vector< SLWSTuningCandidate >& candidates )
 {
-    // We don't expect to get here unless we've combined the app's string(s)
-    // into a single string and computed a hash from it.
-    CLI_ASSERT( singleString );
-
-    std::lock_guard<std::mutex> lock(m_Mutex);
-
-    bool    injected = false;
-
-    std::string fileName;
+    // We're already in a critical section when we get here, so we don't need to
+    // grab the critical section again.
 
-    // Get the dump directory name.
+    SLWSTuningCandidate baseline = { { 0, 0, 0 }, 0, CL_ULONG_MAX };
+    if( local_work_size )
     {
-        OS().GetDumpDirectoryNameWithoutPid( sc_DumpDirectoryName, fileName );
-        fileName += "/Inject";
+        for( cl_uint d = 0; d < work_dim; d++ )
+        {
+            baseline.LWS[d] = local_work_size[d];
+        }
     }
+    candidates.push_back( baseline );
 
-    // Make three candidate file names.  They will have the form:
-    //   CLI_<program number>_<hash>_prepend.cl, or
-    //   CLI_<hash>_prepend.cl, or
-    //   CLI_prepend.cl
+    // Kernels with a required work group size can only use that work group
+    // size, so there is nothing to tune.
+    size_t  requiredWorkGroupSize[3] = { 0, 0, 0 };
+    dispatch().clGetKernelWorkGroupInfo(
+        kernel,
+        device,
+        CL_KERNEL_COMPILE_WORK_GROUP_SIZE,
+        sizeof( requiredWorkGroupSize ),
+        requiredWorkGroupSize,
+        NULL );
+    if( requiredWorkGroupSize[0] != 0 )
     {
-        char    numberString1[256] = "";
-        CLI_SPRINTF( numberString1, 256, "%04u_%08X",
-            m_ProgramNumber,
-            (unsigned int)hash );
-
-        char    numberString2[256] = "";
-        CLI_SPRINTF( numberString2, 256, "%08X",
-            (unsigned int)hash );
+        return;
+    }
 
-        std::string fileName1;
-        fileName1 = fileName;
-        fileName1 += "/CLI_";
-        fileName1 += numberString1;
-        fileName1 += "_prepend.cl";
+    size_t  maxWorkGroupSize = 0;
+    dispatch().clGetKernelWorkGroupInfo(
+        kernel,
+        device,
+        CL_KERNEL_WORK_GROUP_SIZE,
+        sizeof( maxWorkGroupSize ),
+        &maxWorkGroupSize,
+        NULL );
 
-        std::string fileName2;
-        fileName2 = fileName;
-        fileName2 += "/CLI_";
-        fileName2 += numberString2;
-        fileName2 += "_prepend.cl";
+    size_t  preferredMultiple = 1;
+    dispatch().clGetKernelWorkGroupInfo(
+        kernel,
+        device,
+        CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE,
+        sizeof( preferredMultiple ),
+        &preferredMultiple,
+        NULL );
+    preferredMultiple = std::max< size_t >( preferredMultiple, 1 );
 
-        std::string fileName3;
-        fileName3 = fileName;
-        fileName3 += "/CLI_prepend.cl";
+    size_t  maxWorkItemSizes[3] = { maxWorkGroupSize, maxWorkGroupSize, maxWorkGroupSize };
+    dispatch().clGetDeviceInfo(
+        device,
+        CL_DEVICE_MAX_WORK_ITEM_SIZES,
+        sizeof( maxWorkItemSizes ),
+        maxWorkItemSizes,
+        NULL );
 
-        std::ifstream is;
+    const size_t    maxCandidates =
+        std::max< size_t >( config().LocalWorkSizeAutotuningMaxCandidates, 2 );
 
-        is.open(
-            fileName1.c_str(),
-            std::ios::in | std::ios::binary );
-        if( is.good() )
+    auto addCandidate = [&]( const size_t* lws ) {
+        for( const auto& c : candidates )
         {
-            log( "Prepending source file: " + fileName1 + "\n" );
+            if( std::equal( lws, lws + 3, c.LWS ) )
+            {
+                return;
+            }
         }
-        else
-        {
-            log( "Prepend source file doesn't exist: " + fileName1 + "\n" );
+        SLWSTuningCandidate newCandidate = { { lws[0], lws[1], lws[2] }, 0, CL_ULONG_MAX };
+        candidates.push_back( newCandidate );
+    };
 
-            is.clear();
-            is.open(
-                fileName2.c_str(),
-                std::ios::in | std::ios::binary );
-            if( is.good() )
+    // If the application specified a local work size, also try letting the
+    // implementation choose.
+    if( local_work_size )
+    {
+        const size_t    nullLWS[3] = { 0, 0, 0 };
+        addCandidate( nullLWS );
+    }
+
+    // Try work group sizes that are multiples of the preferred work group
+    // size multiple, from smallest to largest.  For 2D and 3D dispatches,
+    // try different shapes with the same total size, from widest to
+    // tallest.  The Z dimension is not tuned.
+    for( size_t total = preferredMultiple;
+         total <= maxWorkGroupSize && candidates.size() < maxCandidates;
+         total *= 2 )
+    {
+        for( size_t x = total;
+             x > 0 && candidates.size() < maxCandidates;
+             x /= 2 )
+        {
+            if( total % x != 0 )
             {
-                log( "Prepending source file: " + fileName2 + "\n" );
+                continue;
             }
-            else
+
+            size_t  lws[3] = { x, total / x, 1 };
+            if( work_dim == 1 && lws[1] != 1 )
             {
-                log( "Prepend source file doesn't exist: " + fileName2 + "\n" );
+                continue;
+            }
 
-                is.clear();
-                is.open(
-                    fileName3.c_str(),
-                    std::ios::in | std::ios::binary );
-                if( is.good() )
-                {
-                    log( "Prepending source file: " + fileName3 + "\n" );
-                }
-                else
+            bool    valid = true;
+            for( cl_uint d = 0; d < work_dim; d++ )
+            {
+                if( lws[d] > maxWorkItemSizes[d] ||
+                    global_work_size[d] % lws[d] != 0 )
                 {
-                    log( "Prepend source file doesn't exist: " + fileName3 + "\n" );
+                    valid = false;
                 }
             }
+            if( valid )
+            {
+                addCandidate( lws );
+            }
         }
+    }
+}
 
-        if( is.good() )
-        {
-            // The file exists.  Figure out how big it is.
-            size_t  filesize = 0;
+///////////////////////////////////////////////////////////////////////////////
+//
+// Returns true if this local work size can be used to enqueue this kernel on
+// this device with this global work size.  A NULL local work size, with all
+// zeros, is always valid.
+bool CLIntercept::checkLWSTuningResult(
+    const cl_device_id device,
+    const cl_kernel kernel,
+    const cl_uint work_dim,
+    const size_t* global_work_size,
+    const size_t* local_work_size )
+{
+    // We're already in a critical section when we get here, so we don't need to
+    // grab the critical section again.
 
-            is.seekg(0, std::ios::end);
-            filesize = (size_t)is.tellg();
-            is.seekg(0, std::ios::beg);
+    if( local_work_size[0] == 0 )
+    {
+        return true;
+    }
 
-            size_t  newSize =
-                filesize +
-                strlen(singleString) +
-                1;  // for the null terminator
+    size_t  requiredWorkGroupSize[3] = { 0, 0, 0 };
+    dispatch().clGetKernelWorkGroupInfo(
+        kernel,
+        device,
+        CL_KERNEL_COMPILE_WORK_GROUP_SIZE,
+        sizeof( requiredWorkGroupSize ),
+        requiredWorkGroupSize,
+        NULL );
 
-            char*   newSingleString = new char[ newSize ];
-            if( newSingleString )
-            {
-                memset( newSingleString, 0, newSize );
+    size_t  maxWorkGroupSize = 0;
+    dispatch().clGetKernelWorkGroupInfo(
+        kernel,
+        device,
+        CL_KERNEL_WORK_GROUP_SIZE,
+        sizeof( maxWorkGroupSize ),
+        &maxWorkGroupSize,
+        NULL );
 
-                is.read( newSingleString, filesize );
+    size_t  maxWorkItemSizes[3] = { maxWorkGroupSize, maxWorkGroupSize, maxWorkGroupSize };
+    dispatch().clGetDeviceInfo(
+        device,
+        CL_DEVICE_MAX_WORK_ITEM_SIZES,
+        sizeof( maxWorkItemSizes ),
+        maxWorkItemSizes,
+        NULL );
 
-                CLI_STRCAT( newSingleString, newSize, singleString );
+    size_t  total = 1;
+    for( cl_uint d = 0; d < work_dim; d++ )
+    {
+        if( local_work_size[d] == 0 ||
+            local_work_size[d] > maxWorkItemSizes[d] ||
+            global_work_size[d] % local_work_size[d] != 0 )
+        {
+            return false;
+        }
+        if( requiredWorkGroupSize[0] != 0 &&
+            local_work_size[d] != requiredWorkGroupSize[d] )
+        {
+            return false;
+        }
+        total *= local_work_size[d];
+    }
 
-                delete [] singleString;
+    return total <= maxWorkGroupSize;
+}
 
-                singleString = newSingleString;
-                count = 1;
-                strings = ( const char** )&singleString;
-                lengths = NULL;
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::addLWSTuningEvent(
+    const cl_command_queue queue,
+    const std::string& key,
+    size_t candidate,
+    cl_event event )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
 
-                injected = true;
-            }
+    SLWSTuningInfo& info = m_LWSTuningInfoMap[ key ];
 
-            is.close();
+    if( event == NULL )
+    {
+        // The enqueue failed, so there is no result for this candidate.
+        info.NumPending--;
+        if( !info.Done &&
+            info.NumPending == 0 &&
+            info.NumEnqueued >=
+                info.Candidates.size() *
+                std::max< size_t >( config().LocalWorkSizeAutotuningIterations, 1 ) )
+        {
+            finishLWSTuning( key, info );
         }
+        return;
     }
 
-    return injected;
+    dispatch().clRetainEvent( event );
+
+    m_LWSTuningEventList.emplace_back();
+
+    SLWSTuningEvent&    node = m_LWSTuningEventList.back();
+    node.Queue = queue;
+    node.Key = key;
+    node.Candidate = candidate;
+    node.Event = event;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-bool CLIntercept::injectProgramSPIRV(
-    const uint64_t hash,
-    size_t& length,
-    const void*& il,
-    char*& injectedIL )
+void CLIntercept::checkLWSTuningEvents()
 {
     std::lock_guard<std::mutex> lock(m_Mutex);
+    updateLWSTuningEvents();
+}
 
-    bool    injected = false;
-
-    std::string fileName;
+///////////////////////////////////////////////////////////////////////////////
+//
+// Releases the tuning events and tuning decisions for a command queue that
+// is about to be destroyed.  Events that have not completed are released
+// without a result, since nothing checks them after the queue is gone.
+void CLIntercept::checkRemoveLWSTuningQueue(
+    const cl_command_queue queue )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
 
-    // Get the dump directory name.
+    if( getRefCount( queue ) != 1 )
     {
-        OS().GetDumpDirectoryNameWithoutPid( sc_DumpDirectoryName, fileName );
-        fileName += "/Inject";
+        return;
     }
 
-    // Make two candidate file names.  They will have the form:
-    //   CLI_<program number>_<hash>_0000.spv, or
-    //   CLI_<hash>_0000.spv
+    updateLWSTuningEvents();
+
+    CLWSTuningEventList::iterator   current = m_LWSTuningEventList.begin();
+    while( current != m_LWSTuningEventList.end() )
     {
-        char    numberString1[256] = "";
-        CLI_SPRINTF( numberString1, 256, "%04u_%08X_0000",
-            m_ProgramNumber,
-            (unsigned int)hash );
+        const SLWSTuningEvent&  node = *current;
+        if( node.Queue != queue )
+        {
+            ++current;
+            continue;
+        }
 
-        char    numberString2[256] = "";
-        CLI_SPRINTF( numberString2, 256, "%08X_0000",
-            (unsigned int)hash );
+        dispatch().clReleaseEvent( node.Event );
 
-        std::string fileName1;
-        fileName1 = fileName;
-        fileName1 += "/CLI_";
-        fileName1 += numberString1;
-        fileName1 += ".spv";
+        SLWSTuningInfo& info = m_LWSTuningInfoMap[ node.Key ];
+        info.NumPending--;
+        if( !info.Done &&
+            info.NumPending == 0 &&
+            info.NumEnqueued >=
+                info.Candidates.size() *
+                std::max< size_t >( config().LocalWorkSizeAutotuningIterations, 1 ) )
+        {
+            finishLWSTuning( node.Key, info );
+        }
 
-        std::string fileName2;
-        fileName2 = fileName;
-        fileName2 += "/CLI_";
-        fileName2 += numberString2;
-        fileName2 += ".spv";
+        current = m_LWSTuningEventList.erase( current );
+    }
 
-        std::ifstream is;
+    std::lock_guard<std::mutex> decisionLock(m_LWSTuningDecisionMutex);
 
-        is.open(
-            fileName1.c_str(),
-            std::ios::in | std::ios::binary );
-        if( is.good() )
+    CLWSTuningDecisionMap::iterator iter = m_LWSTuningDecisionMap.begin();
+    while( iter != m_LWSTuningDecisionMap.end() )
+    {
+        if( iter->first.Queue == queue )
         {
-            log( "Injecting SPIR-V file: " + fileName1 + "\n" );
+            iter = m_LWSTuningDecisionMap.erase( iter );
         }
         else
         {
-            log( "Injection SPIR-V file doesn't exist: " + fileName1 + "\n" );
-
-            is.clear();
-            is.open(
-                fileName2.c_str(),
-                std::ios::in | std::ios::binary );
-            if( is.good() )
-            {
-                log( "Injecting SPIR-V file: " + fileName2 + "\n" );
-            }
-            else
-            {
-                log( "Injection SPIR-V file doesn't exist: " + fileName2 + "\n" );
-            }
+            ++iter;
         }
+    }
+}
 
-        if( is.good() )
-        {
-            // The file exists.  Figure out how big it is.
-            size_t  filesize = 0;
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::updateLWSTuningEvents()
+{
+    // We're already in a critical section when we get here, so we don't need to
+    // grab the critical section again.
 
-            is.seekg(0, std::ios::end);
-            filesize = (size_t)is.tellg();
-            is.seekg(0, std::ios::beg);
+    CLWSTuningEventList::iterator   current = m_LWSTuningEventList.begin();
+    while( current != m_LWSTuningEventList.end() )
+    {
+        const SLWSTuningEvent&  node = *current;
 
-            injectedIL = new char[ filesize ];
-            if( injectedIL )
-            {
-                is.read( injectedIL, filesize );
+        cl_int  eventStatus = 0;
+        cl_int  errorCode = dispatch().clGetEventInfo(
+            node.Event,
+            CL_EVENT_COMMAND_EXECUTION_STATUS,
+            sizeof( eventStatus ),
+            &eventStatus,
+            NULL );
+        if( errorCode == CL_SUCCESS && eventStatus > CL_COMPLETE )
+        {
+            ++current;
+            continue;
+        }
 
-                il = injectedIL;
-                length = filesize;
+        SLWSTuningInfo& info = m_LWSTuningInfoMap[ node.Key ];
 
-                injected = true;
+        if( errorCode == CL_SUCCESS && eventStatus == CL_COMPLETE )
+        {
+            cl_ulong    commandStart = 0;
+            cl_ulong    commandEnd = 0;
+
+            errorCode |= dispatch().clGetEventProfilingInfo(
+                node.Event,
+                CL_PROFILING_COMMAND_START,
+                sizeof( commandStart ),
+                &commandStart,
+                NULL );
+            errorCode |= dispatch().clGetEventProfilingInfo(
+                node.Event,
+                CL_PROFILING_COMMAND_END,
+                sizeof( commandEnd ),
+                &commandEnd,
+                NULL );
+            if( errorCode == CL_SUCCESS )
+            {
+                SLWSTuningCandidate&    candidate = info.Candidates[ node.Candidate ];
+                candidate.Samples++;
+                candidate.MinNS = std::min< cl_ulong >(
+                    candidate.MinNS,
+                    commandEnd - commandStart );
             }
+            else if( !info.Done )
+            {
+                logf( "Couldn't get profiling info while autotuning local work size for %s!  Is profiling enabled for the queue?\n",
+                    node.Key.c_str() );
+                info.Done = true;
+                CLI_MEMCPY( info.Best, sizeof(info.Best),
+                    info.Candidates[0].LWS, sizeof(info.Best) );
+            }
+        }
 
-            is.close();
+        dispatch().clReleaseEvent( node.Event );
+
+        info.NumPending--;
+        if( !info.Done &&
+            info.NumPending == 0 &&
+            info.NumEnqueued >=
+                info.Candidates.size() *
+                std::max< size_t >( config().LocalWorkSizeAutotuningIterations, 1 ) )
+        {
+            finishLWSTuning( node.Key, info );
         }
-    }
 
-    return injected;
+        current = m_LWSTuningEventList.erase( current );
+    }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-bool CLIntercept::injectProgramOptions(
-    const cl_program program,
-    cl_bool isCompile,
-    cl_bool isLink,
-    char*& newOptions )
+void CLIntercept::finishLWSTuning(
+    const std::string& key,
+    SLWSTuningInfo& info )
 {
-    std::lock_guard<std::mutex> lock(m_Mutex);
+    // We're already in a critical section when we get here, so we don't need to
+    // grab the critical section again.
 
-    CLI_ASSERT( newOptions == NULL );
+    const SLWSTuningCandidate&  baseline = info.Candidates[0];
 
-    bool    injected = false;
+    size_t  best = 0;
+    for( size_t c = 1; c < info.Candidates.size(); c++ )
+    {
+        const SLWSTuningCandidate&  candidate = info.Candidates[c];
+        if( candidate.Samples != 0 &&
+            candidate.MinNS < info.Candidates[best].MinNS )
+        {
+            best = c;
+        }
+    }
 
-    const SProgramInfo& programInfo = m_ProgramInfoMap[ program ];
+    info.Done = true;
+    CLI_MEMCPY( info.Best, sizeof(info.Best),
+        info.Candidates[best].LWS, sizeof(info.Best) );
+    info.BaselineNS = baseline.MinNS;
+    info.BestNS = info.Candidates[best].MinNS;
+
+    std::string bestString;
+    formatLocalWorkSize( info.WorkDim, info.Best, bestString );
+
+    logf( "Autotuned local work size for %s: %s (%" PRIu64 " ns, original %" PRIu64 " ns)\n",
+        key.c_str(),
+        bestString.c_str(),
+        (uint64_t)info.BestNS,
+        (uint64_t)info.BaselineNS );
 
     std::string fileName;
+    getLWSTuningFileName( fileName );
 
-    // Get the dump directory name.
+    OS().MakeDumpDirectories( fileName );
+
+    std::ofstream   os;
+    os.open(
+        fileName.c_str(),
+        std::ios::out | std::ios::app );
+    if( os.good() )
     {
-        OS().GetDumpDirectoryNameWithoutPid( sc_DumpDirectoryName, fileName );
-        fileName += "/Inject";
+        os << key << "\t" << bestString << std::endl;
+        os.close();
     }
-    // Make four candidate file names.  They will have the form:
-    //   CLI_<program number>_<program hash>_<compile count>_<options hash>_options.txt, or
-    //   CLI_<program hash>_<compile count>_<options hash>_options.txt, or
-    //   CLI_<program hash>_options.txt, or
-    //   CLI_options.txt
+    else
     {
-        char    numberString1[256] = "";
-        CLI_SPRINTF( numberString1, 256, "%04u_%08X_%04u_%08X",
-            programInfo.ProgramNumber,
-            (unsigned int)programInfo.ProgramHash,
-            programInfo.CompileCount,
-            (unsigned int)programInfo.OptionsHash );
-
-        char    numberString2[256] = "";
-        CLI_SPRINTF( numberString2, 256, "%08X_%04u_%08X",
-            (unsigned int)programInfo.ProgramHash,
-            programInfo.CompileCount,
-            (unsigned int)programInfo.OptionsHash );
-
-        char    numberString3[256] = "";
-        CLI_SPRINTF( numberString3, 256, "%08X",
-            (unsigned int)programInfo.ProgramHash );
-
-        const std::string suffix =
-            isCompile ? "_compile_options.txt" :
-            isLink ? "_link_options.txt" :
-            "_options.txt";
+        logf( "Failed to open local work size tuning file: %s\n",
+            fileName.c_str() );
+    }
+}
 
-        std::string fileName1;
-        fileName1 = fileName;
-        fileName1 += "/CLI_";
-        fileName1 += numberString1;
-        fileName1 += suffix;
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::getLWSTuningFileName(
+    std::string& fileName ) const
+{
+    if( config().LocalWorkSizeAutotuningFile.empty() )
+    {
+        OS().GetDumpDirectoryNameWithoutPid( sc_DumpDirectoryName, fileName );
+        fileName += "/";
+        fileName += sc_LWSTuningFileName;
+    }
+    else
+    {
+        fileName = config().LocalWorkSizeAutotuningFile;
+    }
+}
 
-        std::string fileName2;
-        fileName2 = fileName;
-        fileName2 += "/CLI_";
-        fileName2 += numberString2;
-        fileName2 += suffix;
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::loadLWSTuningDatabase()
+{
+    // We're already in a critical section when we get here, so we don't need to
+    // grab the critical section again.
 
-        std::string fileName3;
-        fileName3 = fileName;
-        fileName3 += "/CLI_";
-        fileName3 += numberString3;
-        fileName3 += suffix;
+    m_LWSTuningDatabaseLoaded = true;
 
-        std::string fileName4;
-        fileName4 = fileName;
-        fileName4 += suffix;
+    std::string fileName;
+    getLWSTuningFileName( fileName );
 
-        std::ifstream is;
+    std::ifstream   is;
+    is.open(
+        fileName.c_str(),
+        std::ios::in );
+    if( !is.good() )
+    {
+        return;
+    }
 
-        is.open(
-            fileName1.c_str(),
-            std::ios::in | std::ios::binary );
-        if( is.good() )
+    // Later lines replace earlier lines with the same key, so results can be
+    // appended to the file without rewriting it.
+    size_t  numEntries = 0;
+    std::string line;
+    while( std::getline( is, line ) )
+    {
+        if( !line.empty() && line.back() == '\r' )
         {
-            log( "Injecting options file: " + fileName1 + "\n" );
+            line.pop_back();
         }
-        else
+        if( line.empty() || line[0] == '#' )
         {
-            log( "Injection options file doesn't exist: " + fileName1 + "\n" );
-
-            is.clear();
-            is.open(
-                fileName2.c_str(),
-                std::ios::in | std::ios::binary );
-            if( is.good() )
-            {
-                log( "Injecting options file: " + fileName2 + "\n" );
-            }
-            else
-            {
-                log( "Injection options file doesn't exist: " + fileName2 + "\n" );
-
-                is.clear();
-                is.open(
-                    fileName3.c_str(),
-                    std::ios::in | std::ios::binary );
-                if( is.good() )
-                {
-                    log( "Injecting options file: " + fileName3 + "\n" );
-                }
-                else
-                {
-                    log( "Injection options file doesn't exist: " + fileName3 + "\n" );
-
-                    is.clear();
-                    is.open(
-                        fileName4.c_str(),
-                        std::ios::in | std::ios::binary );
-                    if( is.good() )
-                    {
-                        log( "Injecting options file: " + fileName4 + "\n" );
-                    }
-                    else
-                    {
-                        log( "Injection options file doesn't exist: " + fileName4 + "\n" );
-                    }
-                }
-            }
+            continue;
         }
 
-        if( is.good() )
+        size_t  pos = line.rfind( '\t' );
+        if( pos == std::string::npos )
         {
-            // The file exists.  Figure out how big it is.
-            size_t  filesize = 0;
+            continue;
+        }
 
-            is.seekg(0, std::ios::end);
-            filesize = (size_t)is.tellg();
-            is.seekg(0, std::ios::beg);
+        SLWSTuningInfo& info = m_LWSTuningInfoMap[ line.substr( 0, pos ) ];
+        info.Done = true;
+        info.Best[0] = info.Best[1] = info.Best[2] = 0;
 
-            newOptions = new char[ filesize + 1 ];
-            if( newOptions )
+        const std::string   lws = line.substr( pos + 1 );
+        if( lws != "NULL" )
+        {
+            const char* str = lws.c_str();
+            for( int d = 0; d < 3 && *str; d++ )
             {
-                memset( newOptions, 0, filesize + 1 );
-
-                is.read( newOptions, filesize );
-
-                // Replace any newline characters with spaces.
-                // Some editors insert newline characters, especially at the
-                // end of the file, which can cause build options to become
-                // invalid.
-                for( size_t i = 0; i < filesize; i++ )
+                char*   end = NULL;
+                info.Best[d] = strtoull( str, &end, 10 );
+                str = ( *end == 'x' ) ? end + 1 : end;
+            }
+            for( int d = 1; d < 3; d++ )
+            {
+                if( info.Best[d] == 0 )
                 {
-                    if( newOptions[i] == '\n' )
-                    {
-                        newOptions[i] = ' ';
-                    }
+                    info.Best[d] = 1;
                 }
-
-                injected = true;
             }
-
-            is.close();
         }
+        numEntries++;
     }
 
-    return injected;
+    logf( "Loaded %zu local work size tuning results from %s\n",
+        numEntries,
+        fileName.c_str() );
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-bool CLIntercept::appendBuildOptions(
-    const char* append,
-    const char* options,
-    char*& newOptions ) const
+void CLIntercept::combineProgramStrings(
+    cl_uint& count,
+    const char**& strings,
+    const size_t*& lengths,
+    char*& singleString ) const
 {
-    bool    modified = false;
+    size_t  allocSize = 0;
+    cl_uint i = 0;
 
-    size_t  newSize = strlen(append) + 1;    // for the null terminator
-
-    const char* oldOptions = newOptions ? newOptions : options;
-    if( oldOptions )
+    for( i = 0; i < count; i++ )
     {
-        newSize += strlen(oldOptions) + 1;  // for a space
+        size_t  length = 0;
+        if( ( lengths == NULL ) ||
+            ( lengths[i] == 0 ) )
+        {
+            if( strings != NULL && strings[i] != NULL )
+            {
+                length = strlen( strings[i] );
+            }
+        }
+        else
+        {
+            length = lengths[i];
+        }
+        allocSize += length;
     }
 
-    char* newNewOptions = new char[ newSize ];
-    if( newNewOptions )
+    // Allocate some extra to make sure we're null terminated.
+    allocSize++;
+
+    singleString = new char[ allocSize ];
+    if( singleString )
     {
-        memset( newNewOptions, 0, newSize );
+        memset( singleString, 0, allocSize );
 
-        if( oldOptions )
+        char*   pDst = singleString;
+        size_t  remaining = allocSize;
+        for( i = 0; i < count; i++ )
         {
-            CLI_STRCAT( newNewOptions, newSize, oldOptions );
-            CLI_STRCAT( newNewOptions, newSize, " " );
+            size_t  length = 0;
+            if( ( lengths == NULL ) ||
+                ( lengths[i] == 0 ) )
+            {
+                if( strings != NULL && strings[i] != NULL )
+                {
+                    length = strlen( strings[i] );
+                }
+            }
+            else
+            {
+                length = lengths[i];
+            }
+            if( length != 0 )
+            {
+                if( strings != NULL && strings[i] != NULL )
+                {
+                    CLI_MEMCPY(
+                        pDst,
+                        remaining,
+                        strings[i],
+                        length );
+                }
+                pDst += length;
+                remaining -= length;
+            }
         }
-        CLI_STRCAT( newNewOptions, newSize, append );
 
-        delete [] newOptions;
-        newOptions = newNewOptions;
+        // Replace any NULL chars between kernels with spaces.
+        if( count > 1 )
+        {
+            for( char* pStr = singleString; pStr < pDst - 1; pStr++ )
+            {
+                if( *pStr == 0x0 )
+                {
+                    *pStr = 0x20;
+                }
+            }
+        }
 
-        modified = true;
+        count = 1;
+        strings = ( const char** )&singleString;
+        lengths = NULL;
     }
-
-    return modified;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::dumpProgramSourceScript(
-    cl_program program,
-    const char* singleString )
+void CLIntercept::incrementProgramCompileCount(
+    const cl_program program )
 {
-#if defined(_WIN32)
-
     std::lock_guard<std::mutex> lock(m_Mutex);
+    m_ProgramInfoMap[ program ].CompileCount++;
+}
 
-    CLI_ASSERT( config().DumpProgramSourceScript || config().SimpleDumpProgramSource );
-
-    char    dirName[MAX_PATH] = "";
-    char    fileName[MAX_PATH] = "";
-    char    filePath[MAX_PATH] = "";
+///////////////////////////////////////////////////////////////////////////////
+//
+uint64_t CLIntercept::computeHash(
+    const void* ptr,
+    size_t length )
+{
+    uint64_t    hash = 0;
 
-    if( config().DumpProgramSourceScript )
+    if( ptr != NULL )
     {
-        size_t  remaining = MAX_PATH;
-
-        char    date[9] = "";
-        char    time[9] = "";
-        char*   curPos = NULL;
-        char*   nextToken = NULL;
-        char*   pch = NULL;
-
-        // Directory:
+        hash = Hash( ptr, length );
+    }
 
-        curPos = dirName;
-        remaining = MAX_PATH;
-        memset( curPos, 0, MAX_PATH );
+    return hash;
+}
 
-        _strdate_s( date, 9 );
-        _strtime_s( time, 9 );
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::saveProgramHash(
+    const cl_program program,
+    uint64_t hash )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if( program != NULL )
+    {
+        m_ProgramInfoMap[ program ].ProgramHash = hash;
+    }
+}
 
-        memcpy_s( curPos, remaining, "CLShaderDump_", 14 );
-        curPos += 13;
-        remaining -= 13;
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::saveProgramOptionsHash(
+    const cl_program program,
+    const char* options )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
 
-        memcpy_s( curPos, remaining, strtok_s( date, "/", &nextToken ), 2 );
-        curPos += 2;
-        remaining -= 2;
+    if( program != NULL && options != NULL )
+    {
+        uint64_t hash = computeHash(
+            options,
+            strlen( options ) );
 
-        memcpy_s( curPos, remaining, strtok_s( NULL, "/", &nextToken ), 2 );
-        curPos += 2;
-        remaining -= 2;
+        m_ProgramInfoMap[ program ].OptionsHash = hash;
+    }
+}
 
-        memcpy_s( curPos, remaining, strtok_s( NULL, "/", &nextToken ), 2 );
-        curPos += 2;
-        remaining -= 2;
+///////////////////////////////////////////////////////////////////////////////
+//
+// This function assumes that CLIntercept already has entered its
+// critical section.
+//
+// Opens a file for injection.  Files in the Inject directory are looked up
+// in an index of the directory, which is built the first time it is needed,
+// so checking for files that do not exist does not touch the filesystem.
+bool CLIntercept::openInjectionFile(
+    const std::string& fileName,
+    std::ifstream& is )
+{
+    if( m_InjectionDirectoryName.empty() )
+    {
+        OS().GetDumpDirectoryNameWithoutPid( sc_DumpDirectoryName, m_InjectionDirectoryName );
+        m_InjectionDirectoryName += "/Inject";
+    }
 
-        ::CreateDirectoryA( dirName, NULL );
+    std::string::size_type  pos = fileName.find_last_of( '/' );
+    if( pos != std::string::npos &&
+        fileName.compare( 0, pos, m_InjectionDirectoryName ) == 0 &&
+        pos == m_InjectionDirectoryName.length() )
+    {
+        const cl_uint   refreshMS = config().InjectionFileIndexRefreshMS;
+        clock::time_point   now = clock::now();
 
-        // File:
+        if( !m_InjectionFileSetValid ||
+            ( refreshMS != 0 &&
+              now - m_InjectionFileSetTime > std::chrono::milliseconds(refreshMS) ) )
+        {
+            std::vector<std::string>    fileNames;
+            OS().GetDirectoryFiles( m_InjectionDirectoryName, fileNames );
 
-        curPos = fileName;
-        remaining = MAX_PATH;
-        memset( curPos, 0, MAX_PATH );
+            m_InjectionFileSet.clear();
+            m_InjectionFileSet.insert( fileNames.begin(), fileNames.end() );
+            m_InjectionFileSetValid = true;
+            m_InjectionFileSetTime = now;
+        }
 
-        if( GetModuleFileNameA( NULL, fileName, MAX_PATH-1 ) == 0 )
+        if( m_InjectionFileSet.find( fileName.substr( pos + 1 ) ) ==
+            m_InjectionFileSet.end() )
         {
-            CLI_ASSERT( 0 );
-            strcpy_s( curPos, remaining, "process.exe" );
+            is.setstate( std::ios::failbit );
+            return false;
         }
-
-        pch = strrchr( fileName, '\\' );
-        pch++;
-        memcpy_s( curPos, remaining, pch, strlen( pch ) );
-        curPos += strlen( pch ) - 4;    // -4 to cut off ".exe"
-        remaining -= strlen( pch ) - 4;
-
-        memcpy_s( curPos, remaining, "_", 2 );
-        curPos += 1;
-        remaining -= 1;
-
-        memcpy_s( curPos, remaining, strtok_s( time, ":", &nextToken ), 2 );
-        curPos += 2;
-        remaining -= 2;
-
-        memcpy_s( curPos, remaining, strtok_s( NULL, ":", &nextToken ), 2 );
-        curPos += 2;
-        remaining -= 2;
-
-        memcpy_s( curPos, remaining, strtok_s( NULL, ":", &nextToken ), 2 );
-        curPos += 2;
-        remaining -= 2;
-
-        CLI_SPRINTF( curPos, remaining, "_%8.8x", m_ProgramNumber );
-        curPos += 9;
-        remaining -= 9;
-    }
-    else
-    {
-        CLI_SPRINTF( dirName, MAX_PATH, "." );
-        CLI_SPRINTF( fileName, MAX_PATH, "kernel" );
-    }
-
-    CLI_SPRINTF( filePath, MAX_PATH, "%s/%s.%s", dirName, fileName, "cl" );
-
-    if( singleString )
-    {
-        dumpMemoryToFile(
-            filePath,
-            false,
-            singleString,
-            strlen(singleString) );
     }
 
-    SProgramInfo&   programInfo = m_ProgramInfoMap[ program ];
-    programInfo.ProgramNumber = m_ProgramNumber;
-    programInfo.CompileCount = 0;
-
-    m_ProgramNumber++;
-
-#else
-    CLI_ASSERT( 0 );
-#endif
+    is.open(
+        fileName.c_str(),
+        std::ios::in | std::ios::binary );
+    return is.good();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::dumpProgramSource(
-    cl_program program,
-    uint64_t hash,
-    bool modified,
-    const char* singleString )
+bool CLIntercept::injectProgramSource(
+    const uint64_t hash,
+    cl_uint& count,
+    const char**& strings,
+    const size_t*& lengths,
+    char*& singleString )
 {
+    // We don't expect to get here unless we've combined the app's string(s)
+    // into a single string and computed a hash from it.
+    CLI_ASSERT( singleString );
+
     std::lock_guard<std::mutex> lock(m_Mutex);
 
-    CLI_ASSERT( config().DumpProgramSource || config().AutoCreateSPIRV );
+    bool    injected = false;
 
     std::string fileName;
 
     // Get the dump directory name.
     {
-        OS().GetDumpDirectoryName( sc_DumpDirectoryName, fileName );
-    }
-    if( modified )
-    {
-        fileName += "/Modified";
+        OS().GetDumpDirectoryNameWithoutPid( sc_DumpDirectoryName, fileName );
+        fileName += "/Inject";
     }
 
-    // Make the file name.  It will have the form:
-    //   CLI_<program number>_<hash>_source.cl
-    {
-        char    numberString[256] = "";
-
-        if( config().OmitProgramNumber )
-        {
-            CLI_SPRINTF( numberString, 256, "%08X",
-                (unsigned int)hash );
-        }
-        else
-        {
-            CLI_SPRINTF( numberString, 256, "%04u_%08X",
-                m_ProgramNumber,
-                (unsigned int)hash );
-        }
-
-        fileName += "/CLI_";
-        fileName += numberString;
-        fileName += "_source.cl";
-    }
-    // Now make directories as appropriate.
-    {
-        OS().MakeDumpDirectories( fileName );
-    }
-    // Dump the program source to a .cl file.
-    if( singleString )
+    // Make two candidate file names.  They will have the form:
+    //   CLI_<program number>_<hash>_source.cl, or
+    //   CLI_<hash>_source.cl
     {
-        log( "Dumping program to file (inject): " + fileName + "\n" );
-        dumpMemoryToFile(
-            fileName,
-            false,
-            singleString,
-            strlen(singleString) );
-    }
-
-    SProgramInfo&   programInfo = m_ProgramInfoMap[ program ];
-    programInfo.ProgramNumber = m_ProgramNumber;
-    programInfo.CompileCount = 0;
-
-    m_ProgramNumber++;
-}
-
-///////////////////////////////////////////////////////////////////////////////
-//
-void CLIntercept::dumpInputProgramBinaries(
-    const cl_program program,
-    uint64_t hash,
-    bool modified,
-    cl_uint num_devices,
-    const cl_device_id* device_list,
-    const size_t* lengths,
-    const unsigned char** binaries )
-{
-    std::lock_guard<std::mutex> lock(m_Mutex);
+        char    numberString1[256] = "";
+        CLI_SPRINTF( numberString1, 256, "%04u_%08X",
+            m_ProgramNumber,
+            (unsigned int)hash );
 
-    CLI_ASSERT( config().DumpInputProgramBinaries );
+        char    numberString2[256] = "";
+        CLI_SPRINTF( numberString2, 256, "%08X",
+            (unsigned int)hash );
 
-    std::string fileName;
+        std::string fileName1;
+        fileName1 = fileName;
+        fileName1 += "/CLI_";
+        fileName1 += numberString1;
+        fileName1 += "_source.cl";
 
-    // Get the dump directory name.
-    {
-        OS().GetDumpDirectoryName( sc_DumpDirectoryName, fileName );
-    }
-    if( modified )
-    {
-        fileName += "/Modified";
-    }
+        std::string fileName2;
+        fileName2 = fileName;
+        fileName2 += "/CLI_";
+        fileName2 += numberString2;
+        fileName2 += "_source.cl";
 
-    // Make the file name.  It will have the form:
-    //   CLI_<program number>_<hash>
-    // Leave off the extension for now.
-    {
-        char    numberString[256] = "";
+        std::ifstream is;
 
-        if( config().OmitProgramNumber )
+        openInjectionFile(
+            fileName1,
+            is );
+        if( is.good() )
         {
-            CLI_SPRINTF( numberString, 256, "%08X",
-                (unsigned int)hash );
+            log( "Injecting source file: " + fileName1 + "\n" );
         }
         else
         {
-            CLI_SPRINTF( numberString, 256, "%04u_%08X",
-                m_ProgramNumber,
-                (unsigned int)hash );
+            log( "Injection source file doesn't exist: " + fileName1 + "\n" );
+
+            is.clear();
+            openInjectionFile(
+                fileName2,
+                is );
+            if( is.good() )
+            {
+                log( "Injecting source file: " + fileName2 + "\n" );
+            }
+            else
+            {
+                log( "Injection source file doesn't exist: " + fileName2 + "\n" );
+            }
         }
 
-        fileName += "/CLI_";
-        fileName += numberString;
-    }
-    // Now make directories as appropriate.
-    {
-        OS().MakeDumpDirectories( fileName );
-    }
+        if( is.good() )
+        {
+            // The file exists.  Figure out how big it is.
+            size_t  filesize = 0;
 
-    for( size_t i = 0; i < num_devices; i++ )
-    {
-        cl_device_type  deviceType = CL_DEVICE_TYPE_DEFAULT;
+            is.seekg(0, std::ios::end);
+            filesize = (size_t)is.tellg();
+            is.seekg(0, std::ios::beg);
 
-        // It's OK if this fails.  If it does, it just
-        // means that our output file won't have a device
-        // type.
-        dispatch().clGetDeviceInfo(
-            device_list[ i ],
-            CL_DEVICE_TYPE,
-            sizeof( deviceType ),
-            &deviceType,
-            NULL );
+            char*   newSingleString = new char[ filesize + 1 ];
+            if( newSingleString )
+            {
+                memset( newSingleString, 0, filesize + 1 );
 
-        std::string outputFileName = fileName;
+                is.read( newSingleString, filesize );
 
-        if( deviceType & CL_DEVICE_TYPE_CPU )
-        {
-            outputFileName += "_CPU";
-        }
-        if( deviceType & CL_DEVICE_TYPE_GPU )
-        {
-            outputFileName += "_GPU";
-        }
-        if( deviceType & CL_DEVICE_TYPE_ACCELERATOR )
-        {
-            outputFileName += "_ACC";
-        }
-        if( deviceType & CL_DEVICE_TYPE_CUSTOM )
-        {
-            outputFileName += "_CUSTOM";
-        }
+                delete [] singleString;
 
-        outputFileName += ".bin";
+                singleString = newSingleString;
+                count = 1;
+                strings = ( const char** )&singleString;
+                lengths = NULL;
 
-        log( "Dumping input program binary to file: " + outputFileName + "\n" );
-        dumpMemoryToFile(
-            outputFileName,
-            false,
-            binaries[ i ],
-            lengths[ i ] );
-    }
+                injected = true;
+            }
 
-    SProgramInfo&   programInfo = m_ProgramInfoMap[ program ];
-    programInfo.ProgramNumber = m_ProgramNumber;
-    programInfo.CompileCount = 0;
+            is.close();
+        }
+    }
 
-    m_ProgramNumber++;
+    return injected;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::dumpProgramSPIRV(
-    cl_program program,
-    uint64_t hash,
-    bool modified,
-    const size_t length,
-    const void* il )
+bool CLIntercept::prependProgramSource(
+    const uint64_t hash,
+    cl_uint& count,
+    const char**& strings,
+    const size_t*& lengths,
+    char*& singleString )
 {
+    // We don't expect to get here unless we've combined the app's string(s)
+    // into a single string and computed a hash from it.
+    CLI_ASSERT( singleString );
+
     std::lock_guard<std::mutex> lock(m_Mutex);
 
-    CLI_ASSERT( config().DumpProgramSPIRV );
+    bool    injected = false;
 
     std::string fileName;
 
     // Get the dump directory name.
     {
-        OS().GetDumpDirectoryName( sc_DumpDirectoryName, fileName );
-    }
-    if( modified )
-    {
-        fileName += "/Modified";
+        OS().GetDumpDirectoryNameWithoutPid( sc_DumpDirectoryName, fileName );
+        fileName += "/Inject";
     }
 
-    // Make the file name.  It will have the form:
-    //   CLI_<program number>_<hash>_0000.spv
+    // Make three candidate file names.  They will have the form:
+    //   CLI_<program number>_<hash>_prepend.cl, or
+    //   CLI_<hash>_prepend.cl, or
+    //   CLI_prepend.cl
     {
-        char    numberString[256] = "";
+        char    numberString1[256] = "";
+        CLI_SPRINTF( numberString1, 256, "%04u_%08X",
+            m_ProgramNumber,
+            (unsigned int)hash );
 
-        if( config().OmitProgramNumber )
+        char    numberString2[256] = "";
+        CLI_SPRINTF( numberString2, 256, "%08X",
+            (unsigned int)hash );
+
+        std::string fileName1;
+        fileName1 = fileName;
+        fileName1 += "/CLI_";
+        fileName1 += numberString1;
+        fileName1 += "_prepend.cl";
+
+        std::string fileName2;
+        fileName2 = fileName;
+        fileName2 += "/CLI_";
+        fileName2 += numberString2;
+        fileName2 += "_prepend.cl";
+
+        std::string fileName3;
+        fileName3 = fileName;
+        fileName3 += "/CLI_prepend.cl";
+
+        std::ifstream is;
+
+        openInjectionFile(
+            fileName1,
+            is );
+        if( is.good() )
         {
-            CLI_SPRINTF( numberString, 256, "%08X_0000",
-                (unsigned int)hash );
+            log( "Prepending source file: " + fileName1 + "\n" );
         }
         else
         {
-            CLI_SPRINTF( numberString, 256, "%04u_%08X_0000",
-                m_ProgramNumber,
-                (unsigned int)hash );
-        }
-
-        fileName += "/CLI_";
-        fileName += numberString;
-        fileName += ".spv";
-    }
+            log( "Prepend source file doesn't exist: " + fileName1 + "\n" );
 
-    // Now make directories as appropriate.
-    {
-        OS().MakeDumpDirectories( fileName );
-    }
+            is.clear();
+            openInjectionFile(
+                fileName2,
+                is );
+            if( is.good() )
+            {
+                log( "Prepending source file: " + fileName2 + "\n" );
+            }
+            else
+            {
+                log( "Prepend source file doesn't exist: " + fileName2 + "\n" );
 
-    // Dump the program source to a .spv file.
-    {
-        log( "Dumping program to file (inject): " + fileName + "\n" );
-        dumpMemoryToFile(
-            fileName,
-            false,
-            il,
-            length );
+                is.clear();
+                openInjectionFile(
+                    fileName3,
+                    is );
+                if( is.good() )
+                {
+                    log( "Prepending source file: " + fileName3 + "\n" );
+                }
+                else
+                {
+                    log( "Prepend source file doesn't exist: " + fileName3 + "\n" );
+                }
+            }
+        }
 
-        // Optionally, run spirv-dis to disassemble the dumped file.
-        if( !config().SPIRVDis.empty() )
+        if( is.good() )
         {
-            std::string command =
-                config().SPIRVDis +
-                " -o " + fileName + "asm" +
-                " " + fileName;
+            // The file exists.  Figure out how big it is.
+            size_t  filesize = 0;
 
-            logf( "Running: %s\n", command.c_str() );
-            OS().ExecuteCommand( command );
-        }
-    }
+            is.seekg(0, std::ios::end);
+            filesize = (size_t)is.tellg();
+            is.seekg(0, std::ios::beg);
 
-    SProgramInfo&   programInfo = m_ProgramInfoMap[ program ];
-    programInfo.ProgramNumber = m_ProgramNumber;
-    programInfo.CompileCount = 0;
+            size_t  newSize =
+                filesize +
+                strlen(singleString) +
+                1;  // for the null terminator
 
-    m_ProgramNumber++;
-}
+            char*   newSingleString = new char[ newSize ];
+            if( newSingleString )
+            {
+                memset( newSingleString, 0, newSize );
 
-///////////////////////////////////////////////////////////////////////////////
-//
-void CLIntercept::dumpProgramOptionsScript(
-    const cl_program program,
-    const char* options )
-{
-#if defined(_WIN32)
+                is.read( newSingleString, filesize );
 
-    std::lock_guard<std::mutex> lock(m_Mutex);
+                CLI_STRCAT( newSingleString, newSize, singleString );
 
-    CLI_ASSERT( config().DumpProgramSource || config().SimpleDumpProgramSource );
+                delete [] singleString;
 
-    const SProgramInfo& programInfo = m_ProgramInfoMap[ program ];
+                singleString = newSingleString;
+                count = 1;
+                strings = ( const char** )&singleString;
+                lengths = NULL;
 
-    if( options )
-    {
-        char    dirName[MAX_PATH] = "";
-        char    fileName[MAX_PATH] = "";
-        char    filePath[MAX_PATH] = "";
+                injected = true;
+            }
 
-        if( config().DumpProgramSourceScript )
-        {
-            size_t  remaining = MAX_PATH;
+            is.close();
+        }
+    }
 
-            char    date[9] = "";
-            char    time[9] = "";
-            char*   curPos = NULL;
-            char*   nextToken = NULL;
-            char*   pch = NULL;
+    return injected;
+}
 
-            // Directory:
+///////////////////////////////////////////////////////////////////////////////
+//
+bool CLIntercept::injectProgramSPIRV(
+    const uint64_t hash,
+    size_t& length,
+    const void*& il,
+    char*& injectedIL )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
 
-            curPos = dirName;
-            remaining = MAX_PATH;
-            memset( curPos, 0, MAX_PATH );
+    bool    injected = false;
 
-            _strdate_s( date, 9 );
-            _strtime_s( time, 9 );
+    std::string fileName;
 
-            memcpy_s( curPos, remaining, "CLShaderDump_", 14 );
-            curPos += 13;
-            remaining -= 13;
+    // Get the dump directory name.
+    {
+        OS().GetDumpDirectoryNameWithoutPid( sc_DumpDirectoryName, fileName );
+        fileName += "/Inject";
+    }
 
-            memcpy_s( curPos, remaining, strtok_s( date, "/", &nextToken ), 2 );
-            curPos += 2;
-            remaining -= 2;
+    // Make two candidate file names.  They will have the form:
+    //   CLI_<program number>_<hash>_0000.spv, or
+    //   CLI_<hash>_0000.spv
+    {
+        char    numberString1[256] = "";
+        CLI_SPRINTF( numberString1, 256, "%04u_%08X_0000",
+            m_ProgramNumber,
+            (unsigned int)hash );
 
-            memcpy_s( curPos, remaining, strtok_s( NULL, "/", &nextToken ), 2 );
-            curPos += 2;
-            remaining -= 2;
+        char    numberString2[256] = "";
+        CLI_SPRINTF( numberString2, 256, "%08X_0000",
+            (unsigned int)hash );
 
-            memcpy_s( curPos, remaining, strtok_s( NULL, "/", &nextToken ), 2 );
-            curPos += 2;
-            remaining -= 2;
+        std::string fileName1;
+        fileName1 = fileName;
+        fileName1 += "/CLI_";
+        fileName1 += numberString1;
+        fileName1 += ".spv";
 
-            ::CreateDirectoryA( dirName, NULL );
+        std::string fileName2;
+        fileName2 = fileName;
+        fileName2 += "/CLI_";
+        fileName2 += numberString2;
+        fileName2 += ".spv";
 
-            // File:
+        std::ifstream is;
 
-            curPos = fileName;
-            remaining = MAX_PATH;
-            memset( curPos, 0, MAX_PATH );
+        openInjectionFile(
+            fileName1,
+            is );
+        if( is.good() )
+        {
+            log( "Injecting SPIR-V file: " + fileName1 + "\n" );
+        }
+        else
+        {
+            log( "Injection SPIR-V file doesn't exist: " + fileName1 + "\n" );
 
-            if( GetModuleFileNameA( NULL, fileName, MAX_PATH-1 ) == 0 )
+            is.clear();
+            openInjectionFile(
+                fileName2,
+                is );
+            if( is.good() )
             {
-                CLI_ASSERT( 0 );
-                strcpy_s( curPos, remaining, "process.exe" );
+                log( "Injecting SPIR-V file: " + fileName2 + "\n" );
+            }
+            else
+            {
+                log( "Injection SPIR-V file doesn't exist: " + fileName2 + "\n" );
             }
+        }
 
-            pch = strrchr( fileName, '\\' );
-            pch++;
-            memcpy_s( curPos, remaining, pch, strlen( pch ) );
-            curPos += strlen( pch ) - 4;    // -4 to cut off ".exe"
-            remaining -= strlen( pch ) - 4;
+        if( is.good() )
+        {
+            // The file exists.  Figure out how big it is.
+            size_t  filesize = 0;
 
-            memcpy_s( curPos, remaining, "_", 2 );
-            curPos += 1;
-            remaining -= 1;
+            is.seekg(0, std::ios::end);
+            filesize = (size_t)is.tellg();
+            is.seekg(0, std::ios::beg);
 
-            memcpy_s( curPos, remaining, strtok_s( time, ":", &nextToken ), 2 );
-            curPos += 2;
-            remaining -= 2;
+            injectedIL = new char[ filesize ];
+            if( injectedIL )
+            {
+                is.read( injectedIL, filesize );
 
-            memcpy_s( curPos, remaining, strtok_s( NULL, ":", &nextToken ), 2 );
-            curPos += 2;
-            remaining -= 2;
+                il = injectedIL;
+                length = filesize;
 
-            memcpy_s( curPos, remaining, strtok_s( NULL, ":", &nextToken ), 2 );
-            curPos += 2;
-            remaining -= 2;
+                injected = true;
+            }
 
-            CLI_SPRINTF( curPos, remaining, "_%8.8x", programInfo.ProgramNumber );
-            curPos += 9;
-            remaining -= 9;
-        }
-        else
-        {
-            CLI_SPRINTF( dirName, MAX_PATH, "." );
-            CLI_SPRINTF( fileName, MAX_PATH, "kernel" );
+            is.close();
         }
-
-        CLI_SPRINTF( filePath, MAX_PATH, "%s/%s.%s", dirName, fileName, "txt" );
-
-        dumpMemoryToFile(
-            filePath,
-            false,
-            options,
-            strlen(options) );
     }
 
-#else
-    CLI_ASSERT( 0 );
-#endif
+    return injected;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::dumpProgramOptions(
+bool CLIntercept::injectProgramOptions(
     const cl_program program,
-    bool modified,
     cl_bool isCompile,
     cl_bool isLink,
-    const char* options )
+    char*& newOptions )
 {
     std::lock_guard<std::mutex> lock(m_Mutex);
 
-    CLI_ASSERT(
-        config().DumpProgramSource ||
-        config().DumpInputProgramBinaries ||
-        config().DumpProgramBinaries ||
-        config().DumpProgramSPIRV );
+    CLI_ASSERT( newOptions == NULL );
 
-    const SProgramInfo& programInfo = m_ProgramInfoMap[ program ];
+    bool    injected = false;
 
-    if( options )
-    {
-        std::string fileName;
+    const SProgramInfo& programInfo = m_ProgramInfoMap[ program ];
 
-        // Get the dump directory name.
-        {
-            OS().GetDumpDirectoryName( sc_DumpDirectoryName, fileName );
-        }
-        if( modified )
-        {
-            fileName += "/Modified";
-        }
+    std::string fileName;
 
-        // Make the file name.  It will have the form:
-        //   CLI_<program number>_<program hash>_<compile count>_<options hash>
-        // Leave off the extension for now.
-        {
-            char    numberString[256] = "";
+    // Get the dump directory name.
+    {
+        OS().GetDumpDirectoryNameWithoutPid( sc_DumpDirectoryName, fileName );
+        fileName += "/Inject";
+    }
+    // Make four candidate file names.  They will have the form:
+    //   CLI_<program number>_<program hash>_<compile count>_<options hash>_options.txt, or
+    //   CLI_<program hash>_<compile count>_<options hash>_options.txt, or
+    //   CLI_<program hash>_options.txt, or
+    //   CLI_options.txt
+    {
+        char    numberString1[256] = "";
+        CLI_SPRINTF( numberString1, 256, "%04u_%08X_%04u_%08X",
+            programInfo.ProgramNumber,
+            (unsigned int)programInfo.ProgramHash,
+            programInfo.CompileCount,
+            (unsigned int)programInfo.OptionsHash );
 
-            if( config().OmitProgramNumber )
+        char    numberString2[256] = "";
+        CLI_SPRINTF( numberString2, 256, "%08X_%04u_%08X",
+            (unsigned int)programInfo.ProgramHash,
+            programInfo.CompileCount,
+            (unsigned int)programInfo.OptionsHash );
+
+        char    numberString3[256] = "";
+        CLI_SPRINTF( numberString3, 256, "%08X",
+            (unsigned int)programInfo.ProgramHash );
+
+        const std::string suffix =
+            isCompile ? "_compile_options.txt" :
+            isLink ? "_link_options.txt" :
+            "_options.txt";
+
+        std::string fileName1;
+        fileName1 = fileName;
+        fileName1 += "/CLI_";
+        fileName1 += numberString1;
+        fileName1 += suffix;
+
+        std::string fileName2;
+        fileName2 = fileName;
+        fileName2 += "/CLI_";
+        fileName2 += numberString2;
+        fileName2 += suffix;
+
+        std::string fileName3;
+        fileName3 = fileName;
+        fileName3 += "/CLI_";
+        fileName3 += numberString3;
+        fileName3 += suffix;
+
+        std::string fileName4;
+        fileName4 = fileName;
+        fileName4 += suffix;
+
+        std::ifstream is;
+
+        openInjectionFile(
+            fileName1,
+            is );
+        if( is.good() )
+        {
+            log( "Injecting options file: " + fileName1 + "\n" );
+        }
+        else
+        {
+            log( "Injection options file doesn't exist: " + fileName1 + "\n" );
+
+            is.clear();
+            openInjectionFile(
+                fileName2,
+                is );
+            if( is.good() )
             {
-                CLI_SPRINTF( numberString, 256, "%08X_%04u_%08X",
-                    (unsigned int)programInfo.ProgramHash,
-                    programInfo.CompileCount,
-                    (unsigned int)programInfo.OptionsHash );
+                log( "Injecting options file: " + fileName2 + "\n" );
             }
             else
             {
-                CLI_SPRINTF( numberString, 256, "%04u_%08X_%04u_%08X",
-                    programInfo.ProgramNumber,
-                    (unsigned int)programInfo.ProgramHash,
-                    programInfo.CompileCount,
-                    (unsigned int)programInfo.OptionsHash );
-            }
+                log( "Injection options file doesn't exist: " + fileName2 + "\n" );
 
-            fileName += "/CLI_";
-            fileName += numberString;
-        }
+                is.clear();
+                openInjectionFile(
+                    fileName3,
+                    is );
+                if( is.good() )
+                {
+                    log( "Injecting options file: " + fileName3 + "\n" );
+                }
+                else
+                {
+                    log( "Injection options file doesn't exist: " + fileName3 + "\n" );
 
-        // Now make directories as appropriate.
-        {
-            OS().MakeDumpDirectories( fileName );
+                    is.clear();
+                    openInjectionFile(
+                        fileName4,
+                        is );
+                    if( is.good() )
+                    {
+                        log( "Injecting options file: " + fileName4 + "\n" );
+                    }
+                    else
+                    {
+                        log( "Injection options file doesn't exist: " + fileName4 + "\n" );
+                    }
+                }
+            }
         }
 
-        // Dump the program options to a .txt file.
+        if( is.good() )
         {
-            fileName +=
-                isCompile ? "_compile_options.txt" :
-                isLink ? "_link_options.txt" :
-                "_options.txt";
-            log( "Dumping program options to file (inject): " + fileName + "\n" );
-            dumpMemoryToFile(
-                fileName,
-                false,
-                options,
-                strlen(options) );
+            // The file exists.  Figure out how big it is.
+            size_t  filesize = 0;
+
+            is.seekg(0, std::ios::end);
+            filesize = (size_t)is.tellg();
+            is.seekg(0, std::ios::beg);
+
+            newOptions = new char[ filesize + 1 ];
+            if( newOptions )
+            {
+                memset( newOptions, 0, filesize + 1 );
+
+                is.read( newOptions, filesize );
+
+                // Replace any newline characters with spaces.
+                // Some editors insert newline characters, especially at the
+                // end of the file, which can cause build options to become
+                // invalid.
+                for( size_t i = 0; i < filesize; i++ )
+                {
+                    if( newOptions[i] == '\n' )
+                    {
+                        newOptions[i] = ' ';
+                    }
+                }
+
+                injected = true;
+            }
+
+            is.close();
         }
     }
+
+    return injected;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::dumpProgramBuildLog(
-    const cl_program program,
-    const cl_device_id device,
-    const char* buildLog,
-    const size_t buildLogSize )
+bool CLIntercept::appendBuildOptions(
+    const char* append,
+    const char* options,
+    char*& newOptions ) const
 {
-    // We're already in a critical section when we get here, so we don't need to
-    // grab the critical section again.
-
-    CLI_ASSERT( config().DumpProgramBuildLogs );
-    CLI_ASSERT( buildLog );
-
-    const SProgramInfo& programInfo = m_ProgramInfoMap[ program ];
+    bool    modified = false;
 
-    std::string fileName;
+    size_t  newSize = strlen(append) + 1;    // for the null terminator
 
-    // Get the dump directory name.
+    const char* oldOptions = newOptions ? newOptions : options;
+    if( oldOptions )
     {
-        OS().GetDumpDirectoryName( sc_DumpDirectoryName, fileName );
+        newSize += strlen(oldOptions) + 1;  // for a space
     }
-    // Make the file name.  It will have the form:
-    //   CLI_<program number>_<program hash>_<compile count>_<options hash>
-    // Leave off the extension for now.
+
+    char* newNewOptions = new char[ newSize ];
+    if( newNewOptions )
     {
-        char    numberString[256] = "";
+        memset( newNewOptions, 0, newSize );
 
-        if( config().OmitProgramNumber )
-        {
-            CLI_SPRINTF( numberString, 256, "%08X_%04u_%08X",
-                (unsigned int)programInfo.ProgramHash,
-                programInfo.CompileCount,
-                (unsigned int)programInfo.OptionsHash );
-        }
-        else
+        if( oldOptions )
         {
-            CLI_SPRINTF( numberString, 256, "%04u_%08X_%04u_%08X",
-                programInfo.ProgramNumber,
-                (unsigned int)programInfo.ProgramHash,
-                programInfo.CompileCount,
-                (unsigned int)programInfo.OptionsHash );
+            CLI_STRCAT( newNewOptions, newSize, oldOptions );
+            CLI_STRCAT( newNewOptions, newSize, " " );
         }
+        CLI_STRCAT( newNewOptions, newSize, append );
 
-        fileName += "/CLI_";
-        fileName += numberString;
-    }
-    // Now make directories as appropriate.
-    {
-        OS().MakeDumpDirectories( fileName );
+        delete [] newOptions;
+        newOptions = newNewOptions;
+
+        modified = true;
     }
 
-    cl_device_type  deviceType = CL_DEVICE_TYPE_DEFAULT;
+    return modified;
+}
 
-    // It's OK if this fails.  If it does, it just
-    // means that our output file won't have a device
-    // type.
-    dispatch().clGetDeviceInfo(
-        device,
-        CL_DEVICE_TYPE,
-        sizeof( deviceType ),
-        &deviceType,
-        NULL );
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::addHotReloadProgram(
+    const cl_program program,
+    cl_uint numDevices,
+    const cl_device_id* deviceList,
+    const char* options )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
 
-    if( deviceType & CL_DEVICE_TYPE_CPU )
+    CProgramInfoMap::const_iterator iter = m_ProgramInfoMap.find( program );
+    if( iter == m_ProgramInfoMap.end() || iter->second.ProgramHash == 0 )
     {
-        fileName += "_CPU";
+        return;
     }
-    if( deviceType & CL_DEVICE_TYPE_GPU )
+
+    const SProgramInfo& programInfo = iter->second;
+    SHotReloadProgramInfo&  reloadInfo = m_HotReloadProgramInfoMap[ program ];
+
+    // Rebuilt programs use the options and devices from the most recent
+    // build of the application's program.
+    reloadInfo.Devices.assign( deviceList, deviceList + ( deviceList ? numDevices : 0 ) );
+    reloadInfo.Options = options ? options : "";
+
+    if( reloadInfo.Context != NULL )
     {
-        fileName += "_GPU";
+        return;
     }
-    if( deviceType & CL_DEVICE_TYPE_ACCELERATOR )
+
+    dispatch().clGetProgramInfo(
+        program,
+        CL_PROGRAM_CONTEXT,
+        sizeof( reloadInfo.Context ),
+        &reloadInfo.Context,
+        NULL );
+
+    // These are the same file names that are checked by injectProgramSource.
+    std::string fileName;
+    OS().GetDumpDirectoryNameWithoutPid( sc_DumpDirectoryName, fileName );
+    fileName += "/Inject";
+
+    char    numberString1[256] = "";
+    CLI_SPRINTF( numberString1, 256, "%04u_%08X",
+        programInfo.ProgramNumber,
+        (unsigned int)programInfo.ProgramHash );
+
+    char    numberString2[256] = "";
+    CLI_SPRINTF( numberString2, 256, "%08X",
+        (unsigned int)programInfo.ProgramHash );
+
+    reloadInfo.FileName1 = fileName + "/CLI_" + numberString1 + "_source.cl";
+    reloadInfo.FileName2 = fileName + "/CLI_" + numberString2 + "_source.cl";
+
+    // Record the injection file that exists now, if any, so the program is
+    // only rebuilt when the file is added or modified after this point.
+    uint64_t    fileSize = 0;
+    if( OS().GetFileInfo( reloadInfo.FileName1, fileSize, reloadInfo.ModifiedTime ) )
     {
-        fileName += "_ACC";
+        reloadInfo.FileName = reloadInfo.FileName1;
     }
-    if( deviceType & CL_DEVICE_TYPE_CUSTOM )
+    else if( OS().GetFileInfo( reloadInfo.FileName2, fileSize, reloadInfo.ModifiedTime ) )
     {
-        fileName += "_CUSTOM";
+        reloadInfo.FileName = reloadInfo.FileName2;
     }
 
-    fileName += "_build_log.txt";
-
-    log( "Dumping build log to file: " + fileName + "\n" );
-    dumpMemoryToFile(
-        fileName,
-        false,
-        buildLog,
-        buildLogSize );
+    log( "Watching for hot reload source files: " + reloadInfo.FileName1 +
+        ", " + reloadInfo.FileName2 + "\n" );
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::getTimingTagBlocking(
-    const char* functionName,
-    const cl_bool blocking,
-    const size_t size,
-    std::string& hostTag,
-    std::string& deviceTag )
+void CLIntercept::checkRemoveHotReloadProgram(
+    const cl_program program )
 {
-    deviceTag.reserve(128);
-    deviceTag = functionName;
-
-    if( size && config().DevicePerformanceTimeTransferTracking )
-    {
-        char    s[256];
-        CLI_SPRINTF( s, 256, "( %zu bytes )", size );
-        deviceTag += s;
-    }
+    std::lock_guard<std::mutex> lock(m_Mutex);
 
-    if( blocking == CL_TRUE )
+    CHotReloadProgramInfoMap::iterator iter =
+        m_HotReloadProgramInfoMap.find( program );
+    if( iter != m_HotReloadProgramInfoMap.end() &&
+        getRefCount( program ) == 1 )
     {
-        hostTag += "blocking";
+        // Every kernel from the application's program has been released,
+        // so there are no kernels from the rebuilt program either.
+        if( iter->second.Program )
+        {
+            dispatch().clReleaseProgram( iter->second.Program );
+        }
+        m_HotReloadProgramInfoMap.erase( iter );
     }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::getTimingTagsMap(
-    const char* functionName,
-    const cl_map_flags flags,
-    const cl_bool blocking,
-    const size_t size,
-    std::string& hostTag,
-    std::string& deviceTag )
+void CLIntercept::dumpProgramSourceScript(
+    cl_program program,
+    const char* singleString )
 {
-    // Note: we do not currently need a lock for this function.
+#if defined(_WIN32)
 
-    if( flags & CL_MAP_WRITE_INVALIDATE_REGION )
-    {
-        hostTag += "WI";
-    }
-    else if( flags & CL_MAP_WRITE )
-    {
-        hostTag += "RW";
-    }
-    else if( flags & CL_MAP_READ )
-    {
-        hostTag += "R";
-    }
+    std::lock_guard<std::mutex> lock(m_Mutex);
 
-    if( flags & ~(CL_MAP_READ | CL_MAP_WRITE | CL_MAP_WRITE_INVALIDATE_REGION) )
-    {
-        hostTag += "?";
-    }
+    CLI_ASSERT( config().DumpProgramSourceScript || config().SimpleDumpProgramSource );
 
-    deviceTag.reserve(128);
-    deviceTag = functionName;
-    deviceTag += "( ";
-    deviceTag += hostTag;
-    if( size && config().DevicePerformanceTimeTransferTracking )
-    {
-        char    s[256];
-        CLI_SPRINTF( s, 256, "; %zu bytes", size );
-        deviceTag += s;
-    }
-    deviceTag += " )";
+    char    dirName[MAX_PATH] = "";
+    char    fileName[MAX_PATH] = "";
+    char    filePath[MAX_PATH] = "";
 
-    if( blocking == CL_TRUE )
+    if( config().DumpProgramSourceScript )
     {
-        hostTag += "; blocking";
-    }
-}
+        size_t  remaining = MAX_PATH;
 
-///////////////////////////////////////////////////////////////////////////////
-//
-void CLIntercept::getTimingTagsUnmap(
-    const char* functionName,
-    const void* ptr,
-    std::string& hostTag,
-    std::string& deviceTag )
-{
-    if( ptr )
-    {
-        std::lock_guard<std::mutex> lock(m_Mutex);
+        char    date[9] = "";
+        char    time[9] = "";
+        char*   curPos = NULL;
+        char*   nextToken = NULL;
+        char*   pch = NULL;
 
-        CMapPointerInfoMap::iterator iter = m_MapPointerInfoMap.find( ptr );
-        if( iter != m_MapPointerInfoMap.end() )
-        {
-            const cl_map_flags flags = iter->second.Flags;
-            const size_t size = iter->second.Size;
+        // Directory:
 
-            if( flags & CL_MAP_WRITE_INVALIDATE_REGION )
-            {
-                hostTag += "WI";
-            }
-            else if( flags & CL_MAP_WRITE )
-            {
-                hostTag += "RW";
-            }
-            else if( flags & CL_MAP_READ )
-            {
-                hostTag += "R";
-            }
+        curPos = dirName;
+        remaining = MAX_PATH;
+        memset( curPos, 0, MAX_PATH );
 
-            if( flags & ~(CL_MAP_READ | CL_MAP_WRITE | CL_MAP_WRITE_INVALIDATE_REGION) )
-            {
-                hostTag += "?";
-            }
+        _strdate_s( date, 9 );
+        _strtime_s( time, 9 );
 
-            deviceTag.reserve(128);
-            deviceTag = functionName;
-            deviceTag += "( ";
-            deviceTag += hostTag;
-            if( size && config().DevicePerformanceTimeTransferTracking )
-            {
-                char    s[256];
-                CLI_SPRINTF( s, 256, "; %zu bytes", size );
-                deviceTag += s;
-            }
-            deviceTag += " )";
+        memcpy_s( curPos, remaining, "CLShaderDump_", 14 );
+        curPos += 13;
+        remaining -= 13;
+
+        memcpy_s( curPos, remaining, strtok_s( date, "/", &nextToken ), 2 );
+        curPos += 2;
+        remaining -= 2;
+
+        memcpy_s( curPos, remaining, strtok_s( NULL, "/", &nextToken ), 2 );
+        curPos += 2;
+        remaining -= 2;
+
+        memcpy_s( curPos, remaining, strtok_s( NULL, "/", &nextToken ), 2 );
+        curPos += 2;
+        remaining -= 2;
+
+        ::CreateDirectoryA( dirName, NULL );
+
+        // File:
+
+        curPos = fileName;
+        remaining = MAX_PATH;
+        memset( curPos, 0, MAX_PATH );
+
+        if( GetModuleFileNameA( NULL, fileName, MAX_PATH-1 ) == 0 )
+        {
+            CLI_ASSERT( 0 );
+            strcpy_s( curPos, remaining, "process.exe" );
         }
+
+        pch = strrchr( fileName, '\\' );
+        pch++;
+        memcpy_s( curPos, remaining, pch, strlen( pch ) );
+        curPos += strlen( pch ) - 4;    // -4 to cut off ".exe"
+        remaining -= strlen( pch ) - 4;
+
+        memcpy_s( curPos, remaining, "_", 2 );
+        curPos += 1;
+        remaining -= 1;
+
+        memcpy_s( curPos, remaining, strtok_s( time, ":", &nextToken ), 2 );
+        curPos += 2;
+        remaining -= 2;
+
+        memcpy_s( curPos, remaining, strtok_s( NULL, ":", &nextToken ), 2 );
+        curPos += 2;
+        remaining -= 2;
+
+        memcpy_s( curPos, remaining, strtok_s( NULL, ":", &nextToken ), 2 );
+        curPos += 2;
+        remaining -= 2;
+
+        CLI_SPRINTF( curPos, remaining, "_%8.8x", m_ProgramNumber );
+        curPos += 9;
+        remaining -= 9;
+    }
+    else
+    {
+        CLI_SPRINTF( dirName, MAX_PATH, "." );
+        CLI_SPRINTF( fileName, MAX_PATH, "kernel" );
+    }
+
+    CLI_SPRINTF( filePath, MAX_PATH, "%s/%s.%s", dirName, fileName, "cl" );
+
+    if( singleString )
+    {
+        dumpMemoryToFile(
+            filePath,
+            false,
+            singleString,
+            strlen(singleString) );
     }
+
+    SProgramInfo&   programInfo = m_ProgramInfoMap[ program ];
+    programInfo.ProgramNumber = m_ProgramNumber;
+    programInfo.CompileCount = 0;
+
+    m_ProgramNumber++;
+
+#else
+    CLI_ASSERT( 0 );
+#endif
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::getTimingTagsMemfill(
-    const char* functionName,
-    const cl_command_queue queue,
-    const void* dst,
-    const size_t size,
-    std::string& hostTag,
-    std::string& deviceTag )
+void CLIntercept::dumpProgramSource(
+    cl_program program,
+    uint64_t hash,
+    bool modified,
+    const char* singleString )
 {
     std::lock_guard<std::mutex> lock(m_Mutex);
 
-    cl_platform_id  platform = getPlatform(queue);
+    CLI_ASSERT( config().DumpProgramSource || config().AutoCreateSPIRV );
 
-    // If we don't have a function pointer for clGetMemAllocINFO, try to
-    // get one.  It's possible that the function pointer exists but
-    // the application hasn't queried for it yet, in which case it won't
-    // be installed into the dispatch table.
-    if( dispatchX(platform).clGetMemAllocInfoINTEL == NULL )
+    std::string fileName;
+
+    // Get the dump directory name.
     {
-        getExtensionFunctionAddress(
-            platform,
-            "clGetMemAllocInfoINTEL" );
+        OS().GetDumpDirectoryName( sc_DumpDirectoryName, fileName );
+    }
+    if( modified )
+    {
+        fileName += "/Modified";
     }
 
-    const auto& dispatchX = this->dispatchX(platform);
-    if( dispatchX.clGetMemAllocInfoINTEL != NULL )
+    // Make the file name.  It will have the form:
+    //   CLI_<program number>_<hash>_source.cl
     {
-        cl_context  context = NULL;
-        dispatch().clGetCommandQueueInfo(
-            queue,
-            CL_QUEUE_CONTEXT,
-            sizeof( context ),
-            &context,
-            NULL );
+        char    numberString[256] = "";
 
-        if( context )
+        if( config().OmitProgramNumber )
         {
-            cl_unified_shared_memory_type_intel dstType = CL_MEM_TYPE_UNKNOWN_INTEL;
-            dispatchX.clGetMemAllocInfoINTEL(
-                context,
-                dst,
-                CL_MEM_ALLOC_TYPE_INTEL,
-                sizeof(dstType),
-                &dstType,
-                NULL );
-            switch( dstType )
-            {
-            case CL_MEM_TYPE_DEVICE_INTEL:  hostTag += "D"; break;
-            case CL_MEM_TYPE_HOST_INTEL:    hostTag += "H"; break;
-            case CL_MEM_TYPE_SHARED_INTEL:  hostTag += "S"; break;
-            default:                        hostTag += "M"; break;
-            }
-
-            deviceTag.reserve(128);
-            deviceTag = functionName;
-            deviceTag += "( ";
-            deviceTag += hostTag;
-            if( size && config().DevicePerformanceTimeTransferTracking )
-            {
-                char    s[256];
-                CLI_SPRINTF( s, 256, "; %zu bytes", size );
-                deviceTag += s;
-            }
-            deviceTag += " )";
+            CLI_SPRINTF( numberString, 256, "%08X",
+                (unsigned int)hash );
+        }
+        else
+        {
+            CLI_SPRINTF( numberString, 256, "%04u_%08X",
+                m_ProgramNumber,
+                (unsigned int)hash );
         }
+
+        fileName += "/CLI_";
+        fileName += numberString;
+        fileName += "_source.cl";
+    }
+    // Now make directories as appropriate.
+    {
+        OS().MakeDumpDirectories( fileName );
+    }
+    // Dump the program source to a .cl file.  The source file is needed to
+    // automatically create SPIR-V, so it must be written synchronously in
+    // this case.
+    if( singleString )
+    {
+        CProgramDumpFiles   files;
+        log( "Dumping program to file (inject): " + fileName + "\n" );
+        dumpProgramFile(
+            config().AsyncProgramDumping && config().AutoCreateSPIRV == false ?
+                &files : NULL,
+            fileName,
+            singleString,
+            strlen(singleString) );
+        queueProgramDump( files );
     }
+
+    SProgramInfo&   programInfo = m_ProgramInfoMap[ program ];
+    programInfo.ProgramNumber = m_ProgramNumber;
+    programInfo.CompileCount = 0;
+
+    m_ProgramNumber++;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::getTimingTagsMemcpy(
-    const char* functionName,
-    const cl_command_queue queue,
-    const cl_bool blocking,
-    const void* dst,
-    const void* src,
-    const size_t size,
-    std::string& hostTag,
-    std::string& deviceTag )
+void CLIntercept::dumpInputProgramBinaries(
+    const cl_program program,
+    uint64_t hash,
+    bool modified,
+    cl_uint num_devices,
+    const cl_device_id* device_list,
+    const size_t* lengths,
+    const unsigned char** binaries )
 {
     std::lock_guard<std::mutex> lock(m_Mutex);
 
-    cl_platform_id  platform = getPlatform(queue);
+    CLI_ASSERT( config().DumpInputProgramBinaries );
 
-    // If we don't have a function pointer for clGetMemAllocINFO, try to
-    // get one.  It's possible that the function pointer exists but
-    // the application hasn't queried for it yet, in which case it won't
-    // be installed into the dispatch table.
-    if( dispatchX(platform).clGetMemAllocInfoINTEL == NULL )
+    std::string fileName;
+
+    // Get the dump directory name.
     {
-        getExtensionFunctionAddress(
-            platform,
-            "clGetMemAllocInfoINTEL" );
+        OS().GetDumpDirectoryName( sc_DumpDirectoryName, fileName );
+    }
+    if( modified )
+    {
+        fileName += "/Modified";
     }
 
-    const auto& dispatchX = this->dispatchX(platform);
-    if( dispatchX.clGetMemAllocInfoINTEL != NULL )
+    // Make the file name.  It will have the form:
+    //   CLI_<program number>_<hash>
+    // Leave off the extension for now.
     {
-        cl_context  context = NULL;
-        dispatch().clGetCommandQueueInfo(
-            queue,
-            CL_QUEUE_CONTEXT,
-            sizeof( context ),
-            &context,
-            NULL );
+        char    numberString[256] = "";
 
-        if( context )
+        if( config().OmitProgramNumber )
         {
-            cl_unified_shared_memory_type_intel dstType = CL_MEM_TYPE_UNKNOWN_INTEL;
-            dispatchX.clGetMemAllocInfoINTEL(
-                context,
-                dst,
-                CL_MEM_ALLOC_TYPE_INTEL,
-                sizeof(dstType),
-                &dstType,
-                NULL );
-            cl_unified_shared_memory_type_intel srcType = CL_MEM_TYPE_UNKNOWN_INTEL;
-            dispatchX.clGetMemAllocInfoINTEL(
-                context,
-                src,
-                CL_MEM_ALLOC_TYPE_INTEL,
-                sizeof(srcType),
-                &srcType,
-                NULL );
-            switch( srcType )
-            {
-            case CL_MEM_TYPE_DEVICE_INTEL:  hostTag += "Dto"; break;
-            case CL_MEM_TYPE_HOST_INTEL:    hostTag += "Hto"; break;
-            case CL_MEM_TYPE_SHARED_INTEL:  hostTag += "Sto"; break;
-            default:                        hostTag += "Mto"; break;
-            }
-            switch( dstType )
-            {
-            case CL_MEM_TYPE_DEVICE_INTEL:  hostTag += "D"; break;
-            case CL_MEM_TYPE_HOST_INTEL:    hostTag += "H"; break;
-            case CL_MEM_TYPE_SHARED_INTEL:  hostTag += "S"; break;
-            default:                        hostTag += "M"; break;
-            }
-
-            deviceTag.reserve(128);
-            deviceTag = functionName;
-            deviceTag += "( ";
-            deviceTag += hostTag;
-            if( size && config().DevicePerformanceTimeTransferTracking )
-            {
-                char    s[256];
-                CLI_SPRINTF( s, 256, "; %zu bytes", size );
-                deviceTag += s;
-            }
-            deviceTag += " )";
+            CLI_SPRINTF( numberString, 256, "%08X",
+                (unsigned int)hash );
+        }
+        else
+        {
+            CLI_SPRINTF( numberString, 256, "%04u_%08X",
+                m_ProgramNumber,
+                (unsigned int)hash );
         }
+
+        fileName += "/CLI_";
+        fileName += numberString;
+    }
+    // Now make directories as appropriate.
+    {
+        OS().MakeDumpDirectories( fileName );
     }
 
-    if( blocking == CL_TRUE )
+    for( size_t i = 0; i < num_devices; i++ )
     {
-        hostTag += "; blocking";
+        cl_device_type  deviceType = CL_DEVICE_TYPE_DEFAULT;
+
+        // It's OK if this fails.  If it does, it just
+        // means that our output file won't have a device
+        // type.
+        dispatch().clGetDeviceInfo(
+            device_list[ i ],
+            CL_DEVICE_TYPE,
+            sizeof( deviceType ),
+            &deviceType,
+            NULL );
+
+        std::string outputFileName = fileName;
+
+        if( deviceType & CL_DEVICE_TYPE_CPU )
+        {
+            outputFileName += "_CPU";
+        }
+        if( deviceType & CL_DEVICE_TYPE_GPU )
+        {
+            outputFileName += "_GPU";
+        }
+        if( deviceType & CL_DEVICE_TYPE_ACCELERATOR )
+        {
+            outputFileName += "_ACC";
+        }
+        if( deviceType & CL_DEVICE_TYPE_CUSTOM )
+        {
+            outputFileName += "_CUSTOM";
+        }
+
+        outputFileName += ".bin";
+
+        log( "Dumping input program binary to file: " + outputFileName + "\n" );
+        dumpMemoryToFile(
+            outputFileName,
+            false,
+            binaries[ i ],
+            lengths[ i ] );
     }
+
+    SProgramInfo&   programInfo = m_ProgramInfoMap[ program ];
+    programInfo.ProgramNumber = m_ProgramNumber;
+    programInfo.CompileCount = 0;
+
+    m_ProgramNumber++;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::getTimingTagsKernel(
-    const cl_command_queue queue,
-    const cl_kernel kernel,
-    const cl_uint workDim,
-    const size_t* gwo,
-    const size_t* gws,
-    const size_t* lws,
-    std::string& hostTag,
-    std::string& deviceTag )
+void CLIntercept::dumpProgramSPIRV(
+    cl_program program,
+    uint64_t hash,
+    bool modified,
+    const size_t length,
+    const void* il )
 {
     std::lock_guard<std::mutex> lock(m_Mutex);
 
-    cl_device_id device = NULL;
-    dispatch().clGetCommandQueueInfo(
-        queue,
-        CL_QUEUE_DEVICE,
-        sizeof(device),
-        &device,
-        NULL );
+    CLI_ASSERT( config().DumpProgramSPIRV );
 
-    // Cache the device info if it's not cached already, since we'll print
-    // the device name and other device properties as part of the report.
-    cacheDeviceInfo( device );
+    std::string fileName;
 
-    if( kernel )
+    // Get the dump directory name.
     {
-        hostTag += getShortKernelNameWithHash(kernel);
+        OS().GetDumpDirectoryName( sc_DumpDirectoryName, fileName );
+    }
+    if( modified )
+    {
+        fileName += "/Modified";
+    }
 
-        deviceTag += hostTag;
+    // Make the file name.  It will have the form:
+    //   CLI_<program number>_<hash>_0000.spv
+    {
+        char    numberString[256] = "";
 
-        if( config().DevicePerformanceTimeKernelInfoTracking && device )
+        if( config().OmitProgramNumber )
         {
-            const SDeviceInfo& deviceInfo = m_DeviceInfoMap[device];
+            CLI_SPRINTF( numberString, 256, "%08X_0000",
+                (unsigned int)hash );
+        }
+        else
+        {
+            CLI_SPRINTF( numberString, 256, "%04u_%08X_0000",
+                m_ProgramNumber,
+                (unsigned int)hash );
+        }
+
+        fileName += "/CLI_";
+        fileName += numberString;
+        fileName += ".spv";
+    }
+
+    // Now make directories as appropriate.
+    {
+        OS().MakeDumpDirectories( fileName );
+    }
+
+    // Dump the program source to a .spv file.
+    {
+        log( "Dumping program to file (inject): " + fileName + "\n" );
+        dumpMemoryToFile(
+            fileName,
+            false,
+            il,
+            length );
+
+        // Optionally, run spirv-dis to disassemble the dumped file.
+        if( !config().SPIRVDis.empty() )
+        {
+            std::string command =
+                config().SPIRVDis +
+                " -o " + fileName + "asm" +
+                " " + fileName;
+
+            logf( "Running: %s\n", command.c_str() );
+            OS().ExecuteCommand( command );
+        }
+    }
+
+    SProgramInfo&   programInfo = m_ProgramInfoMap[ program ];
+    programInfo.ProgramNumber = m_ProgramNumber;
+    programInfo.CompileCount = 0;
+
+    m_ProgramNumber++;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::dumpProgramOptionsScript(
+    const cl_program program,
+    const char* options )
+{
+#if defined(_WIN32)
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    CLI_ASSERT( config().DumpProgramSource || config().SimpleDumpProgramSource );
+
+    const SProgramInfo& programInfo = m_ProgramInfoMap[ program ];
+
+    if( options )
+    {
+        char    dirName[MAX_PATH] = "";
+        char    fileName[MAX_PATH] = "";
+        char    filePath[MAX_PATH] = "";
+
+        if( config().DumpProgramSourceScript )
+        {
+            size_t  remaining = MAX_PATH;
+
+            char    date[9] = "";
+            char    time[9] = "";
+            char*   curPos = NULL;
+            char*   nextToken = NULL;
+            char*   pch = NULL;
+
+            // Directory:
+
+            curPos = dirName;
+            remaining = MAX_PATH;
+            memset( curPos, 0, MAX_PATH );
+
+            _strdate_s( date, 9 );
+            _strtime_s( time, 9 );
+
+            memcpy_s( curPos, remaining, "CLShaderDump_", 14 );
+            curPos += 13;
+            remaining -= 13;
+
+            memcpy_s( curPos, remaining, strtok_s( date, "/", &nextToken ), 2 );
+            curPos += 2;
+            remaining -= 2;
+
+            memcpy_s( curPos, remaining, strtok_s( NULL, "/", &nextToken ), 2 );
+            curPos += 2;
+            remaining -= 2;
+
+            memcpy_s( curPos, remaining, strtok_s( NULL, "/", &nextToken ), 2 );
+            curPos += 2;
+            remaining -= 2;
+
+            ::CreateDirectoryA( dirName, NULL );
+
+            // File:
+
+            curPos = fileName;
+            remaining = MAX_PATH;
+            memset( curPos, 0, MAX_PATH );
+
+            if( GetModuleFileNameA( NULL, fileName, MAX_PATH-1 ) == 0 )
+            {
+                CLI_ASSERT( 0 );
+                strcpy_s( curPos, remaining, "process.exe" );
+            }
+
+            pch = strrchr( fileName, '\\' );
+            pch++;
+            memcpy_s( curPos, remaining, pch, strlen( pch ) );
+            curPos += strlen( pch ) - 4;    // -4 to cut off ".exe"
+            remaining -= strlen( pch ) - 4;
+
+            memcpy_s( curPos, remaining, "_", 2 );
+            curPos += 1;
+            remaining -= 1;
+
+            memcpy_s( curPos, remaining, strtok_s( time, ":", &nextToken ), 2 );
+            curPos += 2;
+            remaining -= 2;
+
+            memcpy_s( curPos, remaining, strtok_s( NULL, ":", &nextToken ), 2 );
+            curPos += 2;
+            remaining -= 2;
+
+            memcpy_s( curPos, remaining, strtok_s( NULL, ":", &nextToken ), 2 );
+            curPos += 2;
+            remaining -= 2;
+
+            CLI_SPRINTF( curPos, remaining, "_%8.8x", programInfo.ProgramNumber );
+            curPos += 9;
+            remaining -= 9;
+        }
+        else
+        {
+            CLI_SPRINTF( dirName, MAX_PATH, "." );
+            CLI_SPRINTF( fileName, MAX_PATH, "kernel" );
+        }
+
+        CLI_SPRINTF( filePath, MAX_PATH, "%s/%s.%s", dirName, fileName, "txt" );
+
+        dumpMemoryToFile(
+            filePath,
+            false,
+            options,
+            strlen(options) );
+    }
+
+#else
+    CLI_ASSERT( 0 );
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::dumpProgramOptions(
+    const cl_program program,
+    bool modified,
+    cl_bool isCompile,
+    cl_bool isLink,
+    const char* options )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    CLI_ASSERT(
+        config().DumpProgramSource ||
+        config().DumpInputProgramBinaries ||
+        config().DumpProgramBinaries ||
+        config().DumpProgramSPIRV );
+
+    const SProgramInfo& programInfo = m_ProgramInfoMap[ program ];
+
+    if( options )
+    {
+        std::string fileName;
+
+        // Get the dump directory name.
+        {
+            OS().GetDumpDirectoryName( sc_DumpDirectoryName, fileName );
+        }
+        if( modified )
+        {
+            fileName += "/Modified";
+        }
+
+        // Make the file name.  It will have the form:
+        //   CLI_<program number>_<program hash>_<compile count>_<options hash>
+        // Leave off the extension for now.
+        {
+            char    numberString[256] = "";
+
+            if( config().OmitProgramNumber )
+            {
+                CLI_SPRINTF( numberString, 256, "%08X_%04u_%08X",
+                    (unsigned int)programInfo.ProgramHash,
+                    programInfo.CompileCount,
+                    (unsigned int)programInfo.OptionsHash );
+            }
+            else
+            {
+                CLI_SPRINTF( numberString, 256, "%04u_%08X_%04u_%08X",
+                    programInfo.ProgramNumber,
+                    (unsigned int)programInfo.ProgramHash,
+                    programInfo.CompileCount,
+                    (unsigned int)programInfo.OptionsHash );
+            }
+
+            fileName += "/CLI_";
+            fileName += numberString;
+        }
+
+        // Now make directories as appropriate.
+        {
+            OS().MakeDumpDirectories( fileName );
+        }
+
+        // Dump the program options to a .txt file.
+        {
+            fileName +=
+                isCompile ? "_compile_options.txt" :
+                isLink ? "_link_options.txt" :
+                "_options.txt";
+            log( "Dumping program options to file (inject): " + fileName + "\n" );
+            dumpMemoryToFile(
+                fileName,
+                false,
+                options,
+                strlen(options) );
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::dumpProgramBuildLog(
+    const cl_program program,
+    const cl_device_id device,
+    const char* buildLog,
+    const size_t buildLogSize )
+{
+    // We're already in a critical section when we get here, so we don't need to
+    // grab the critical section again.
+
+    CLI_ASSERT( config().DumpProgramBuildLogs );
+    CLI_ASSERT( buildLog );
+
+    const SProgramInfo& programInfo = m_ProgramInfoMap[ program ];
+
+    std::string fileName;
+
+    // Get the dump directory name.
+    {
+        OS().GetDumpDirectoryName( sc_DumpDirectoryName, fileName );
+    }
+    // Make the file name.  It will have the form:
+    //   CLI_<program number>_<program hash>_<compile count>_<options hash>
+    // Leave off the extension for now.
+    {
+        char    numberString[256] = "";
+
+        if( config().OmitProgramNumber )
+        {
+            CLI_SPRINTF( numberString, 256, "%08X_%04u_%08X",
+                (unsigned int)programInfo.ProgramHash,
+                programInfo.CompileCount,
+                (unsigned int)programInfo.OptionsHash );
+        }
+        else
+        {
+            CLI_SPRINTF( numberString, 256, "%04u_%08X_%04u_%08X",
+                programInfo.ProgramNumber,
+                (unsigned int)programInfo.ProgramHash,
+                programInfo.CompileCount,
+                (unsigned int)programInfo.OptionsHash );
+        }
+
+        fileName += "/CLI_";
+        fileName += numberString;
+    }
+    // Now make directories as appropriate.
+    {
+        OS().MakeDumpDirectories( fileName );
+    }
+
+    CProgramDumpFiles   files;
+    writeProgramBuildLog(
+        fileName,
+        device,
+        buildLog,
+        buildLogSize,
+        config().AsyncProgramDumping ? &files : NULL );
+    queueProgramDump( files );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::writeProgramBuildLog(
+    const std::string& fileNamePrefix,
+    const cl_device_id device,
+    const char* buildLog,
+    const size_t buildLogSize,
+    CProgramDumpFiles* pFiles )
+{
+    // We're already in a critical section when we get here, so we don't need to
+    // grab the critical section again.
+
+    std::string fileName( fileNamePrefix );
+
+    cl_device_type  deviceType = CL_DEVICE_TYPE_DEFAULT;
+
+    // It's OK if this fails.  If it does, it just
+    // means that our output file won't have a device
+    // type.
+    dispatch().clGetDeviceInfo(
+        device,
+        CL_DEVICE_TYPE,
+        sizeof( deviceType ),
+        &deviceType,
+        NULL );
+
+    if( deviceType & CL_DEVICE_TYPE_CPU )
+    {
+        fileName += "_CPU";
+    }
+    if( deviceType & CL_DEVICE_TYPE_GPU )
+    {
+        fileName += "_GPU";
+    }
+    if( deviceType & CL_DEVICE_TYPE_ACCELERATOR )
+    {
+        fileName += "_ACC";
+    }
+    if( deviceType & CL_DEVICE_TYPE_CUSTOM )
+    {
+        fileName += "_CUSTOM";
+    }
+
+    fileName += "_build_log.txt";
+
+    log( "Dumping build log to file: " + fileName + "\n" );
+    dumpProgramFile(
+        pFiles,
+        fileName,
+        buildLog,
+        buildLogSize );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::getTimingTagBlocking(
+    const char* functionName,
+    const cl_bool blocking,
+    const size_t size,
+    std::string& hostTag,
+    std::string& deviceTag )
+{
+    deviceTag.reserve(128);
+    deviceTag = functionName;
+
+    if( size && config().DevicePerformanceTimeTransferTracking )
+    {
+        char    s[256];
+        CLI_SPRINTF( s, 256, "( %zu bytes )", size );
+        deviceTag += s;
+    }
+
+    if( blocking == CL_TRUE )
+    {
+        hostTag += "blocking";
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::getTimingTagsMap(
+    const char* functionName,
+    const cl_map_flags flags,
+    const cl_bool blocking,
+    const size_t size,
+    std::string& hostTag,
+    std::string& deviceTag )
+{
+    // Note: we do not currently need a lock for this function.
+
+    if( flags & CL_MAP_WRITE_INVALIDATE_REGION )
+    {
+        hostTag += "WI";
+    }
+    else if( flags & CL_MAP_WRITE )
+    {
+        hostTag += "RW";
+    }
+    else if( flags & CL_MAP_READ )
+    {
+        hostTag += "R";
+    }
+
+    if( flags & ~(CL_MAP_READ | CL_MAP_WRITE | CL_MAP_WRITE_INVALIDATE_REGION) )
+    {
+        hostTag += "?";
+    }
+
+    deviceTag.reserve(128);
+    deviceTag = functionName;
+    deviceTag += "( ";
+    deviceTag += hostTag;
+    if( size && config().DevicePerformanceTimeTransferTracking )
+    {
+        char    s[256];
+        CLI_SPRINTF( s, 256, "; %zu bytes", size );
+        deviceTag += s;
+    }
+    deviceTag += " )";
+
+    if( blocking == CL_TRUE )
+    {
+        hostTag += "; blocking";
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::getTimingTagsUnmap(
+    const char* functionName,
+    const void* ptr,
+    std::string& hostTag,
+    std::string& deviceTag )
+{
+    if( ptr )
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        CMapPointerInfoMap::iterator iter = m_MapPointerInfoMap.find( ptr );
+        if( iter != m_MapPointerInfoMap.end() )
+        {
+            const cl_map_flags flags = iter->second.Flags;
+            const size_t size = iter->second.Size;
+
+            if( flags & CL_MAP_WRITE_INVALIDATE_REGION )
+            {
+                hostTag += "WI";
+            }
+            else if( flags & CL_MAP_WRITE )
+            {
+                hostTag += "RW";
+            }
+            else if( flags & CL_MAP_READ )
+            {
+                hostTag += "R";
+            }
+
+            if( flags & ~(CL_MAP_READ | CL_MAP_WRITE | CL_MAP_WRITE_INVALIDATE_REGION) )
+            {
+                hostTag += "?";
+            }
+
+            deviceTag.reserve(128);
+            deviceTag = functionName;
+            deviceTag += "( ";
+            deviceTag += hostTag;
+            if( size && config().DevicePerformanceTimeTransferTracking )
+            {
+                char    s[256];
+                CLI_SPRINTF( s, 256, "; %zu bytes", size );
+                deviceTag += s;
+            }
+            deviceTag += " )";
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::getTimingTagsMemfill(
+    const char* functionName,
+    const cl_command_queue queue,
+    const void* dst,
+    const size_t size,
+    std::string& hostTag,
+    std::string& deviceTag )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    cl_platform_id  platform = getPlatform(queue);
+
+    // If we don't have a function pointer for clGetMemAllocINFO, try to
+    // get one.  It's possible that the function pointer exists but
+    // the application hasn't queried for it yet, in which case it won't
+    // be installed into the dispatch table.
+    if( dispatchX(platform).clGetMemAllocInfoINTEL == NULL )
+    {
+        getExtensionFunctionAddress(
+            platform,
+            "clGetMemAllocInfoINTEL" );
+    }
+
+    const auto& dispatchX = this->dispatchX(platform);
+    if( dispatchX.clGetMemAllocInfoINTEL != NULL )
+    {
+        cl_context  context = NULL;
+        dispatch().clGetCommandQueueInfo(
+            queue,
+            CL_QUEUE_CONTEXT,
+            sizeof( context ),
+            &context,
+            NULL );
+
+        if( context )
+        {
+            cl_unified_shared_memory_type_intel dstType = CL_MEM_TYPE_UNKNOWN_INTEL;
+            dispatchX.clGetMemAllocInfoINTEL(
+                context,
+                dst,
+                CL_MEM_ALLOC_TYPE_INTEL,
+                sizeof(dstType),
+                &dstType,
+                NULL );
+            switch( dstType )
+            {
+            case CL_MEM_TYPE_DEVICE_INTEL:  hostTag += "D"; break;
+            case CL_MEM_TYPE_HOST_INTEL:    hostTag += "H"; break;
+            case CL_MEM_TYPE_SHARED_INTEL:  hostTag += "S"; break;
+            default:                        hostTag += "M"; break;
+            }
+
+            deviceTag.reserve(128);
+            deviceTag = functionName;
+            deviceTag += "( ";
+            deviceTag += hostTag;
+            if( size && config().DevicePerformanceTimeTransferTracking )
+            {
+                char    s[256];
+                CLI_SPRINTF( s, 256, "; %zu bytes", size );
+                deviceTag += s;
+            }
+            deviceTag += " )";
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::getTimingTagsMemcpy(
+    const char* functionName,
+    const cl_command_queue queue,
+    const cl_bool blocking,
+    const void* dst,
+    const void* src,
+    const size_t size,
+    std::string& hostTag,
+    std::string& deviceTag )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    cl_platform_id  platform = getPlatform(queue);
+
+    // If we don't have a function pointer for clGetMemAllocINFO, try to
+    // get one.  It's possible that the function pointer exists but
+    // the application hasn't queried for it yet, in which case it won't
+    // be installed into the dispatch table.
+    if( dispatchX(platform).clGetMemAllocInfoINTEL == NULL )
+    {
+        getExtensionFunctionAddress(
+            platform,
+            "clGetMemAllocInfoINTEL" );
+    }
+
+    const auto& dispatchX = this->dispatchX(platform);
+    if( dispatchX.clGetMemAllocInfoINTEL != NULL )
+    {
+        cl_context  context = NULL;
+        dispatch().clGetCommandQueueInfo(
+            queue,
+            CL_QUEUE_CONTEXT,
+            sizeof( context ),
+            &context,
+            NULL );
+
+        if( context )
+        {
+            cl_unified_shared_memory_type_intel dstType = CL_MEM_TYPE_UNKNOWN_INTEL;
+            dispatchX.clGetMemAllocInfoINTEL(
+                context,
+                dst,
+                CL_MEM_ALLOC_TYPE_INTEL,
+                sizeof(dstType),
+                &dstType,
+                NULL );
+            cl_unified_shared_memory_type_intel srcType = CL_MEM_TYPE_UNKNOWN_INTEL;
+            dispatchX.clGetMemAllocInfoINTEL(
+                context,
+                src,
+                CL_MEM_ALLOC_TYPE_INTEL,
+                sizeof(srcType),
+                &srcType,
+                NULL );
+            switch( srcType )
+            {
+            case CL_MEM_TYPE_DEVICE_INTEL:  hostTag += "Dto"; break;
+            case CL_MEM_TYPE_HOST_INTEL:    hostTag += "Hto"; break;
+            case CL_MEM_TYPE_SHARED_INTEL:  hostTag += "Sto"; break;
+            default:                        hostTag += "Mto"; break;
+            }
+            switch( dstType )
+            {
+            case CL_MEM_TYPE_DEVICE_INTEL:  hostTag += "D"; break;
+            case CL_MEM_TYPE_HOST_INTEL:    hostTag += "H"; break;
+            case CL_MEM_TYPE_SHARED_INTEL:  hostTag += "S"; break;
+            default:                        hostTag += "M"; break;
+            }
+
+            deviceTag.reserve(128);
+            deviceTag = functionName;
+            deviceTag += "( ";
+            deviceTag += hostTag;
+            if( size && config().DevicePerformanceTimeTransferTracking )
+            {
+                char    s[256];
+                CLI_SPRINTF( s, 256, "; %zu bytes", size );
+                deviceTag += s;
+            }
+            deviceTag += " )";
+        }
+    }
+
+    if( blocking == CL_TRUE )
+    {
+        hostTag += "; blocking";
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::getTimingTagsKernel(
+    const cl_command_queue queue,
+    const cl_kernel kernel,
+    const cl_uint workDim,
+    const size_t* gwo,
+    const size_t* gws,
+    const size_t* lws,
+    std::string& hostTag,
+    std::string& deviceTag )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    cl_device_id device = NULL;
+    dispatch().clGetCommandQueueInfo(
+        queue,
+        CL_QUEUE_DEVICE,
+        sizeof(device),
+        &device,
+        NULL );
+
+    // Cache the device info if it's not cached already, since we'll print
+    // the device name and other device properties as part of the report.
+    cacheDeviceInfo( device );
+
+    if( kernel )
+    {
+        hostTag += getShortKernelNameWithHash(kernel);
+
+        deviceTag += hostTag;
+
+        if( config().DevicePerformanceTimeKernelInfoTracking && device )
+        {
+            const SDeviceInfo& deviceInfo = m_DeviceInfoMap[device];
+
+            std::ostringstream  ss;
+            {
+                size_t  maxsgs = 0;
+                size_t  pwgsm = 0;
+                size_t  simd = 0;
+
+                // Use the kernel "max subgroup size" and "preferred work
+                // group size multiple" to get a reasonable estimate of
+                // the kernel "SIMD size".  We'll try to query both values,
+                // and if both queries are successful, we'll pick the
+                // smallest one.  Empirically, this is reasonably accurate.
+
+                // First, query the "max subgroup size":
+
+                // The query for the max subgroup size requires passing in
+                // a local work size.  We'll use the local work size provided
+                // by the app if there is one, otherwise we will query the
+                // max local work size for this kernel and use it.
+                const size_t*   queryLWS = lws;
+                cl_uint queryWorkDim = workDim;
+
+                size_t  kwgs = 0;
+                if( queryLWS == NULL )
+                {
+                    dispatch().clGetKernelWorkGroupInfo(
+                        kernel,
+                        device,
+                        CL_KERNEL_WORK_GROUP_SIZE,
+                        sizeof(kwgs),
+                        &kwgs,
+                        NULL );
+                    queryLWS = &kwgs;
+                    queryWorkDim = 1;
+                }
+
+                if( maxsgs == 0 &&
+                    deviceInfo.Supports_cl_khr_subgroups )
+                {
+                    cl_platform_id  platform = getPlatform(device);
+                    if( dispatchX(platform).clGetKernelSubGroupInfoKHR == NULL )
+                    {
+                        getExtensionFunctionAddress(
+                            platform,
+                            "clGetKernelSubGroupInfoKHR" );
+                    }
+
+                    const auto& dispatchX = this->dispatchX(platform);
+                    if( dispatchX.clGetKernelSubGroupInfoKHR )
+                    {
+                        dispatchX.clGetKernelSubGroupInfoKHR(
+                            kernel,
+                            device,
+                            CL_KERNEL_MAX_SUB_GROUP_SIZE_FOR_NDRANGE_KHR,
+                            queryWorkDim * sizeof(queryLWS[0]),
+                            queryLWS,
+                            sizeof(maxsgs),
+                            &maxsgs,
+                            NULL );
+                    }
+                }
+                if( maxsgs == 0 &&
+                    deviceInfo.NumericVersion >= CL_MAKE_VERSION_KHR(2, 1, 0) &&
+                    dispatch().clGetKernelSubGroupInfo )
+                {
+                    dispatch().clGetKernelSubGroupInfo(
+                        kernel,
+                        device,
+                        CL_KERNEL_MAX_SUB_GROUP_SIZE_FOR_NDRANGE,
+                        queryWorkDim * sizeof(queryLWS[0]),
+                        queryLWS,
+                        sizeof(maxsgs),
+                        &maxsgs,
+                        NULL );
+                }
+
+                // Next, query the "preferred work group size multiple":
+
+                dispatch().clGetKernelWorkGroupInfo(
+                    kernel,
+                    device,
+                    CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE,
+                    sizeof(pwgsm),
+                    &pwgsm,
+                    NULL );
+
+                // If either query is zero, use the other query.
+                // Otherwise, use the smallest query.
+
+                maxsgs = ( maxsgs == 0 ) ? pwgsm : maxsgs;
+                pwgsm = ( pwgsm == 0 ) ? maxsgs : pwgsm;
+                simd = ( maxsgs < pwgsm ) ? maxsgs : pwgsm;
+
+                if( simd )
+                {
+                    ss << " SIMD" << simd;
+                }
+            }
+            {
+                cl_uint regCount = 0;
+                dispatch().clGetKernelWorkGroupInfo(
+                    kernel,
+                    device,
+                    CL_KERNEL_REGISTER_COUNT_INTEL,
+                    sizeof(regCount),
+                    &regCount,
+                    NULL );
+                if( regCount )
+                {
+                    ss << " REG" << regCount;
+                }
+            }
+            {
+                cl_ulong slm = 0;
+                dispatch().clGetKernelWorkGroupInfo(
+                    kernel,
+                    device,
+                    CL_KERNEL_LOCAL_MEM_SIZE,
+                    sizeof(slm),
+                    &slm,
+                    NULL );
+                if( slm )
+                {
+                    ss << " SLM=" << slm;
+                }
+            }
+            {
+                cl_ulong tpm = 0;
+                dispatch().clGetKernelWorkGroupInfo(
+                    kernel,
+                    device,
+                    CL_KERNEL_PRIVATE_MEM_SIZE,
+                    sizeof(tpm),
+                    &tpm,
+                    NULL );
+                if( tpm )
+                {
+                    ss << " TPM=" << tpm;
+                }
+            }
+            {
+                cl_ulong spill = 0;
+                dispatch().clGetKernelWorkGroupInfo(
+                    kernel,
+                    device,
+                    CL_KERNEL_SPILL_MEM_SIZE_INTEL,
+                    sizeof(spill),
+                    &spill,
+                    NULL );
+                if( spill )
+                {
+                    ss << " SPILL=" << spill;
+                }
+            }
+            deviceTag += ss.str();
+        }
+
+        if( config().DevicePerformanceTimeGWOTracking )
+        {
+            std::ostringstream  ss;
+            ss << " GWO[ ";
+            if( gwo )
+            {
+                if( workDim >= 1 )
+                {
+                    ss << gwo[0];
+                }
+                if( workDim >= 2 )
+                {
+                    ss << ", " << gwo[1];
+                }
+                if( workDim >= 3 )
+                {
+                    ss << ", " << gwo[2];
+                }
+            }
+            else
+            {
+                ss << "NULL";
+            }
+            ss << " ]";
+            deviceTag += ss.str();
+        }
+
+        if( config().DevicePerformanceTimeGWSTracking )
+        {
+            std::ostringstream  ss;
+            ss << " GWS[ ";
+            if( gws )
+            {
+                if( workDim >= 1 )
+                {
+                    ss << gws[0];
+                }
+                if( workDim >= 2 )
+                {
+                    ss << " x " << gws[1];
+                }
+                if( workDim >= 3 )
+                {
+                    ss << " x " << gws[2];
+                }
+            }
+            else
+            {
+                ss << "NULL";
+            }
+            ss << " ]";
+            deviceTag += ss.str();
+        }
+
+        if( config().DevicePerformanceTimeLWSTracking )
+        {
+            bool    useSuggestedLWS = false;
+            size_t  suggestedLWS[3] = { 0, 0, 0 };
+            size_t  emptyGWO[3] = { 0, 0, 0 };
+
+            if( lws == NULL &&
+                workDim <= 3 &&
+                config().DevicePerformanceTimeSuggestedLWSTracking )
+            {
+                cl_platform_id  platform = getPlatform(device);
+
+                // Try the cl_khr_suggested_local_work_size version first.
+                if( useSuggestedLWS == false )
+                {
+                    if( dispatchX(platform).clGetKernelSuggestedLocalWorkSizeKHR == NULL )
+                    {
+                        getExtensionFunctionAddress(
+                            platform,
+                            "clGetKernelSuggestedLocalWorkSizeKHR" );
+                    }
+
+                    const auto& dispatchX = this->dispatchX(platform);
+                    if( dispatchX.clGetKernelSuggestedLocalWorkSizeKHR )
+                    {
+                        cl_int testErrorCode = dispatchX.clGetKernelSuggestedLocalWorkSizeKHR(
+                            queue,
+                            kernel,
+                            workDim,
+                            gwo,
+                            gws,
+                            suggestedLWS );
+                        useSuggestedLWS = ( testErrorCode == CL_SUCCESS );
+                    }
+                }
+
+                // If this fails, try the unofficial Intel version next.
+                if( useSuggestedLWS == false )
+                {
+                    if( dispatchX(platform).clGetKernelSuggestedLocalWorkSizeINTEL == NULL )
+                    {
+                        getExtensionFunctionAddress(
+                            platform,
+                            "clGetKernelSuggestedLocalWorkSizeINTEL" );
+                    }
+
+                    const auto& dispatchX = this->dispatchX(platform);
+                    if( dispatchX.clGetKernelSuggestedLocalWorkSizeINTEL )
+                    {
+                        cl_int testErrorCode = dispatchX.clGetKernelSuggestedLocalWorkSizeINTEL(
+                            queue,
+                            kernel,
+                            workDim,
+                            gwo == NULL ? emptyGWO : gwo,
+                            gws,
+                            suggestedLWS );
+                        useSuggestedLWS = ( testErrorCode == CL_SUCCESS );
+                    }
+                }
+            }
 
             std::ostringstream  ss;
+            if( useSuggestedLWS )
+            {
+                ss << " SLWS[ ";
+                lws = suggestedLWS;
+            }
+            else
+            {
+                ss << " LWS[ ";
+            }
+
+            if( lws )
+            {
+                if( workDim >= 1 )
+                {
+                    ss << lws[0];
+                }
+                if( workDim >= 2 )
+                {
+                    ss << " x " << lws[1];
+                }
+                if( workDim >= 3 )
+                {
+                    ss << " x " << lws[2];
+                }
+            }
+            else
+            {
+                ss << "NULL";
+            }
+
+            ss << " ]";
+            deviceTag += ss.str();
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::getRecordTagCommandBufferKernel(
+    const cl_command_buffer_khr cmdbuf,
+    const cl_kernel kernel,
+    const cl_uint workDim,
+    const size_t* gwo,
+    const size_t* gws,
+    const size_t* lws,
+    const cl_mutable_command_khr* mutable_handle,
+    std::string& recordTag )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    if( kernel )
+    {
+        std::ostringstream  ss;
+
+        recordTag += getShortKernelNameWithHash(kernel);
+
+        if( gwo )
+        {
+            ss << " GWO[ ";
+            if( workDim >= 1 )
+            {
+                ss << gwo[0];
+            }
+            if( workDim >= 2 )
+            {
+                ss << ", " << gwo[1];
+            }
+            if( workDim >= 3 )
+            {
+                ss << ", " << gwo[2];
+            }
+            ss << " ]";
+        }
+
+        ss << " GWS[ ";
+        if( gws )
+        {
+            if( workDim >= 1 )
+            {
+                ss << gws[0];
+            }
+            if( workDim >= 2 )
+            {
+                ss << " x " << gws[1];
+            }
+            if( workDim >= 3 )
+            {
+                ss << " x " << gws[2];
+            }
+        }
+        else
+        {
+            ss << "NULL";
+        }
+        ss << " ]";
+
+        ss << " LWS[ ";
+        if( lws )
+        {
+            if( workDim >= 1 )
+            {
+                ss << lws[0];
+            }
+            if( workDim >= 2 )
+            {
+                ss << " x " << lws[1];
+            }
+            if( workDim >= 3 )
+            {
+                ss << " x " << lws[2];
+            }
+        }
+        else
+        {
+            ss << "NULL";
+        }
+        ss << " ]";
+
+        if( mutable_handle )
+        {
+            ss << " [MUTABLE]";
+        }
+
+        recordTag += ss.str();
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::updateHostTimingStats(
+    const char* functionName,
+    const std::string& tag,
+    clock::time_point start,
+    clock::time_point end )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    std::string key( functionName );
+    if( !tag.empty() )
+    {
+        key += "( ";
+        key += tag;
+        key += " )";
+    }
+
+    SHostTimingStats& hostTimingStats = m_HostTimingStatsMap[ key ];
+
+    using ns = std::chrono::nanoseconds;
+    uint64_t    nsDelta = std::chrono::duration_cast<ns>(end - start).count();
+
+    hostTimingStats.NumberOfCalls++;
+    hostTimingStats.TotalNS += nsDelta;
+    hostTimingStats.MinNS = std::min<uint64_t>( hostTimingStats.MinNS, nsDelta );
+    hostTimingStats.MaxNS = std::max<uint64_t>( hostTimingStats.MaxNS, nsDelta );
+
+    if( config().HostPerformanceTimeLogging )
+    {
+        uint64_t    numberOfCalls = hostTimingStats.NumberOfCalls;
+        logf( "Host Time for call %" PRIu64 ": %s = %" PRIu64 " ns\n",
+            numberOfCalls,
+            key.c_str(),
+            nsDelta );
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::modifyCommandQueueProperties(
+    cl_command_queue_properties& props ) const
+{
+    if( config().InOrderQueue )
+    {
+        props &= ~(cl_command_queue_properties)CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE;
+    }
+    if( config().NoProfilingQueue )
+    {
+        props &= ~(cl_command_queue_properties)CL_QUEUE_PROFILING_ENABLE;
+    }
+    if( config().DevicePerformanceTiming ||
+        config().ITTPerformanceTiming ||
+        config().ChromePerformanceTiming ||
+        config().DevicePerfCounterEventBasedSampling ||
+        config().LocalWorkSizeAutotuning ||
+        config().CaptureReplayMinDeviceTimeUS )
+    {
+        props |= (cl_command_queue_properties)CL_QUEUE_PROFILING_ENABLE;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::createCommandQueueProperties(
+    cl_device_id device,
+    cl_command_queue_properties props,
+    cl_queue_properties*& pLocalQueueProperties ) const
+{
+    bool    addCommandQueuePropertiesEnum = true;
+    bool    addPriorityHintEnum =
+                config().DefaultQueuePriorityHint != 0 &&
+                checkDeviceForExtension( device, "cl_khr_priority_hints" );
+    bool    addThrottleHintEnum =
+                config().DefaultQueueThrottleHint != 0 &&
+                checkDeviceForExtension( device, "cl_khr_throttle_hints" );
+
+    size_t  numProperties = 0;
+    if( addCommandQueuePropertiesEnum )
+    {
+        numProperties += 2;
+    }
+    if( addThrottleHintEnum )
+    {
+        numProperties += 2;
+    }
+    if( addThrottleHintEnum )
+    {
+        numProperties += 2;
+    }
+
+    // Allocate a new array of properties.  We need to allocate two
+    // properties for each pair, plus one property for the terminating
+    // zero.
+    pLocalQueueProperties = new cl_queue_properties[ numProperties + 1 ];
+    if( pLocalQueueProperties )
+    {
+        numProperties = 0;
+
+        if( addPriorityHintEnum )
+        {
+            CLI_ASSERT( config().DefaultQueuePriorityHint != 0 );
+            pLocalQueueProperties[ numProperties] = CL_QUEUE_PRIORITY_KHR;
+            pLocalQueueProperties[ numProperties + 1 ] = config().DefaultQueuePriorityHint;
+            numProperties += 2;
+        }
+        if( config().DefaultQueueThrottleHint != 0 )
+        {
+            CLI_ASSERT( config().DefaultQueueThrottleHint != 0 );
+            pLocalQueueProperties[ numProperties] = CL_QUEUE_THROTTLE_KHR;
+            pLocalQueueProperties[ numProperties + 1 ] = config().DefaultQueueThrottleHint;
+            numProperties += 2;
+        }
+
+        // This setting is added last in the list, in order to better behave with runtimes
+        // truncating it when a property has a value of 0, which may be the case below.
+        if( addCommandQueuePropertiesEnum )
+        {
+            modifyCommandQueueProperties(props);
+
+            pLocalQueueProperties[numProperties] = CL_QUEUE_PROPERTIES;
+            pLocalQueueProperties[numProperties + 1] = props;
+            numProperties += 2;
+        }
+
+        // Add the terminating zero.
+        pLocalQueueProperties[ numProperties ] = 0;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::createCommandQueuePropertiesOverride(
+    cl_device_id device,
+    const cl_queue_properties* properties,
+    cl_queue_properties*& pLocalQueueProperties ) const
+{
+    // We're always going to add command queue properties, unless command queue
+    // properties already exist (requesting the same property twice is an
+    // error).  We also may add priority hints or throttle hints, in some cases.
+    // So, look through the queue properties for these enums.  We need to do
+    // this anyways to count the number of property pairs.
+    bool    addCommandQueuePropertiesEnum = true;
+    bool    addPriorityHintEnum =
+                config().DefaultQueuePriorityHint != 0 &&
+                checkDeviceForExtension( device, "cl_khr_priority_hints" );
+    bool    addThrottleHintEnum =
+                config().DefaultQueueThrottleHint != 0 &&
+                checkDeviceForExtension( device, "cl_khr_throttle_hints" );
+
+    size_t  numProperties = 0;
+    if( properties )
+    {
+        while( properties[ numProperties ] != 0 )
+        {
+            switch( properties[ numProperties ] )
+            {
+            case CL_QUEUE_PROPERTIES:
+                addCommandQueuePropertiesEnum = false;
+                break;
+            case CL_QUEUE_PRIORITY_KHR:
+                addPriorityHintEnum = false;
+                break;
+            case CL_QUEUE_THROTTLE_KHR:
+                addThrottleHintEnum = false;
+                break;
+            default:
+                break;
+            }
+            numProperties += 2;
+        }
+    }
+
+    if( addCommandQueuePropertiesEnum )
+    {
+        numProperties += 2;
+    }
+    if( addThrottleHintEnum )
+    {
+        numProperties += 2;
+    }
+    if( addThrottleHintEnum )
+    {
+        numProperties += 2;
+    }
+
+    // Allocate a new array of properties.  We need to allocate two
+    // properties for each pair, plus one property for the terminating
+    // zero.
+    pLocalQueueProperties = new cl_queue_properties[ numProperties + 1 ];
+    if( pLocalQueueProperties )
+    {
+        // Copy the old properties array to the new properties array,
+        // if the new properties array exists.
+        numProperties = 0;
+        if( properties )
+        {
+            while( properties[ numProperties ] != 0 )
+            {
+                pLocalQueueProperties[ numProperties ] = properties[ numProperties ];
+                if( properties[ numProperties ] == CL_QUEUE_PROPERTIES )
+                {
+                    CLI_ASSERT( addCommandQueuePropertiesEnum == false );
+
+                    cl_command_queue_properties props = properties[ numProperties + 1 ];
+
+                    modifyCommandQueueProperties( props );
+
+                    pLocalQueueProperties[ numProperties + 1 ] = props;
+                }
+                else
+                {
+                    pLocalQueueProperties[ numProperties + 1 ] =
+                        properties[ numProperties + 1 ];
+                }
+                numProperties += 2;
+            }
+        }
+        if( addPriorityHintEnum )
+        {
+            CLI_ASSERT( config().DefaultQueuePriorityHint != 0 );
+            pLocalQueueProperties[ numProperties] = CL_QUEUE_PRIORITY_KHR;
+            pLocalQueueProperties[ numProperties + 1 ] = config().DefaultQueuePriorityHint;
+            numProperties += 2;
+        }
+        if( addThrottleHintEnum )
+        {
+            CLI_ASSERT( config().DefaultQueueThrottleHint != 0 );
+            pLocalQueueProperties[ numProperties] = CL_QUEUE_THROTTLE_KHR;
+            pLocalQueueProperties[ numProperties + 1 ] = config().DefaultQueueThrottleHint;
+            numProperties += 2;
+        }
+
+        // This setting is added last in the list, in order to better behave with runtimes
+        // truncating it when a property has a value of 0, which may be the case below.
+        if( addCommandQueuePropertiesEnum )
+        {
+            cl_command_queue_properties props = 0;
+
+            modifyCommandQueueProperties(props);
+
+            pLocalQueueProperties[numProperties] = CL_QUEUE_PROPERTIES;
+            pLocalQueueProperties[numProperties + 1] = props;
+            numProperties += 2;
+        }
+
+        // Add the terminating zero.
+        pLocalQueueProperties[ numProperties ] = 0;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::dummyCommandQueue(
+    cl_context context,
+    cl_device_id device )
+{
+    if( config().DummyOutOfOrderQueue )
+    {
+        cl_command_queue_properties props;
+        dispatch().clGetDeviceInfo(
+            device,
+            CL_DEVICE_QUEUE_ON_HOST_PROPERTIES,
+            sizeof(props),
+            &props,
+            NULL );
+        if( props & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE )
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+
+            log( "Creating and destroying a dummy out-of-order queue.\n" );
+
+            cl_int  errorCode = CL_SUCCESS;
+            cl_command_queue dummy = dispatch().clCreateCommandQueue(
+                context,
+                device,
+                CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE,
+                &errorCode );
+            if( errorCode == CL_SUCCESS )
+            {
+                dispatch().clReleaseCommandQueue( dummy );
+            }
+            else
             {
-                size_t  maxsgs = 0;
-                size_t  pwgsm = 0;
-                size_t  simd = 0;
+                logf( "Error creating dummy command queue!  %s (%i)\n",
+                    enumName().name( errorCode ).c_str(),
+                    errorCode );
+            }
+        }
+    }
+}
 
-                // Use the kernel "max subgroup size" and "preferred work
-                // group size multiple" to get a reasonable estimate of
-                // the kernel "SIMD size".  We'll try to query both values,
-                // and if both queries are successful, we'll pick the
-                // smallest one.  Empirically, this is reasonably accurate.
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::addTimingEvent(
+    const char* functionName,
+    const uint64_t enqueueCounter,
+    const clock::time_point queuedTime,
+    const std::string& tag,
+    const cl_command_queue queue,
+    cl_event event )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
 
-                // First, query the "max subgroup size":
+    if( event == NULL )
+    {
+        logf( "Unexpectedly got a NULL timing event for %s, check for OpenCL errors!\n",
+            functionName );
+        return;
+    }
 
-                // The query for the max subgroup size requires passing in
-                // a local work size.  We'll use the local work size provided
-                // by the app if there is one, otherwise we will query the
-                // max local work size for this kernel and use it.
-                const size_t*   queryLWS = lws;
-                cl_uint queryWorkDim = workDim;
+    m_EventList.emplace_back();
 
-                size_t  kwgs = 0;
-                if( queryLWS == NULL )
-                {
-                    dispatch().clGetKernelWorkGroupInfo(
-                        kernel,
-                        device,
-                        CL_KERNEL_WORK_GROUP_SIZE,
-                        sizeof(kwgs),
-                        &kwgs,
-                        NULL );
-                    queryLWS = &kwgs;
-                    queryWorkDim = 1;
-                }
+    SEventListNode& node = m_EventList.back();
 
-                if( maxsgs == 0 &&
-                    deviceInfo.Supports_cl_khr_subgroups )
-                {
-                    cl_platform_id  platform = getPlatform(device);
-                    if( dispatchX(platform).clGetKernelSubGroupInfoKHR == NULL )
-                    {
-                        getExtensionFunctionAddress(
-                            platform,
-                            "clGetKernelSubGroupInfoKHR" );
-                    }
+    cl_device_id device = NULL;
+    dispatch().clGetCommandQueueInfo(
+        queue,
+        CL_QUEUE_DEVICE,
+        sizeof(device),
+        &device,
+        NULL );
 
-                    const auto& dispatchX = this->dispatchX(platform);
-                    if( dispatchX.clGetKernelSubGroupInfoKHR )
-                    {
-                        dispatchX.clGetKernelSubGroupInfoKHR(
-                            kernel,
-                            device,
-                            CL_KERNEL_MAX_SUB_GROUP_SIZE_FOR_NDRANGE_KHR,
-                            queryWorkDim * sizeof(queryLWS[0]),
-                            queryLWS,
-                            sizeof(maxsgs),
-                            &maxsgs,
-                            NULL );
-                    }
-                }
-                if( maxsgs == 0 &&
-                    deviceInfo.NumericVersion >= CL_MAKE_VERSION_KHR(2, 1, 0) &&
-                    dispatch().clGetKernelSubGroupInfo )
-                {
-                    dispatch().clGetKernelSubGroupInfo(
-                        kernel,
-                        device,
-                        CL_KERNEL_MAX_SUB_GROUP_SIZE_FOR_NDRANGE,
-                        queryWorkDim * sizeof(queryLWS[0]),
-                        queryLWS,
-                        sizeof(maxsgs),
-                        &maxsgs,
-                        NULL );
-                }
+    // Cache the device info if it's not cached already, since we'll print
+    // the device name and other device properties as part of the report.
+    cacheDeviceInfo( device );
 
-                // Next, query the "preferred work group size multiple":
+    dispatch().clRetainEvent( event );
 
-                dispatch().clGetKernelWorkGroupInfo(
-                    kernel,
-                    device,
-                    CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE,
-                    sizeof(pwgsm),
-                    &pwgsm,
-                    NULL );
+    node.Device = device;
+    node.QueueNumber = m_QueueNumberMap[ queue ];
+    node.Name = !tag.empty() ? tag : functionName;
+    node.EnqueueCounter = enqueueCounter;
+    node.QueuedTime = queuedTime;
+    node.UseProfilingDelta = false;
+    node.ProfilingDeltaNS = 0;
+    node.Event = event;
 
-                // If either query is zero, use the other query.
-                // Otherwise, use the smallest query.
+    if( device )
+    {
+        const SDeviceInfo& deviceInfo = m_DeviceInfoMap[device];
 
-                maxsgs = ( maxsgs == 0 ) ? pwgsm : maxsgs;
-                pwgsm = ( pwgsm == 0 ) ? maxsgs : pwgsm;
-                simd = ( maxsgs < pwgsm ) ? maxsgs : pwgsm;
+        // Note: Even though ideally the intercept timer and the host timer should advance
+        // at a consistent rate and hence the delta between the two timers should remain
+        // constant, empirically this does not appear to be the case.  Synchronizing the
+        // two timers is relatively inexpensive, and reduces the timer drift, so compute
+        // the current delta for each event.
 
-                if( simd )
-                {
-                    ss << " SIMD" << simd;
-                }
-            }
-            {
-                cl_uint regCount = 0;
-                dispatch().clGetKernelWorkGroupInfo(
-                    kernel,
-                    device,
-                    CL_KERNEL_REGISTER_COUNT_INTEL,
-                    sizeof(regCount),
-                    &regCount,
-                    NULL );
-                if( regCount )
-                {
-                    ss << " REG" << regCount;
-                }
-            }
-            {
-                cl_ulong slm = 0;
-                dispatch().clGetKernelWorkGroupInfo(
-                    kernel,
-                    device,
-                    CL_KERNEL_LOCAL_MEM_SIZE,
-                    sizeof(slm),
-                    &slm,
-                    NULL );
-                if( slm )
-                {
-                    ss << " SLM=" << slm;
-                }
-            }
-            {
-                cl_ulong tpm = 0;
-                dispatch().clGetKernelWorkGroupInfo(
-                    kernel,
-                    device,
-                    CL_KERNEL_PRIVATE_MEM_SIZE,
-                    sizeof(tpm),
-                    &tpm,
-                    NULL );
-                if( tpm )
-                {
-                    ss << " TPM=" << tpm;
-                }
-            }
-            {
-                cl_ulong spill = 0;
-                dispatch().clGetKernelWorkGroupInfo(
-                    kernel,
-                    device,
-                    CL_KERNEL_SPILL_MEM_SIZE_INTEL,
-                    sizeof(spill),
-                    &spill,
-                    NULL );
-                if( spill )
-                {
-                    ss << " SPILL=" << spill;
-                }
-            }
-            deviceTag += ss.str();
+        if( deviceInfo.HasDeviceAndHostTimer )
+        {
+            // These conditions should have been checked for HasDeviceAndHostTimer to be true:
+            CLI_ASSERT( deviceInfo.NumericVersion >= CL_MAKE_VERSION_KHR(2, 1, 0) );
+            CLI_ASSERT( dispatch().clGetHostTimer );
+
+            using ns = std::chrono::nanoseconds;
+            const uint64_t  interceptTimeStartNS =
+                std::chrono::duration_cast<ns>(clock::now().time_since_epoch()).count();
+
+            cl_ulong    hostTimeNS = 0;
+            dispatch().clGetHostTimer(
+                device,
+                &hostTimeNS);
+
+            const uint64_t  interceptTimeEndNS =
+                std::chrono::duration_cast<ns>(clock::now().time_since_epoch()).count();
+
+            const int64_t   interceptHostTimeDeltaNS =
+                ( interceptTimeEndNS - interceptTimeStartNS ) / 2 +
+                ( interceptTimeStartNS - hostTimeNS );
+
+            node.UseProfilingDelta = true;
+            node.ProfilingDeltaNS =
+                interceptHostTimeDeltaNS -
+                deviceInfo.DeviceHostTimeDeltaNS;
+
+            //logf( "Current Profiling Delta is %lld ns (%.2f us, %.2f ms)\n"
+            //    "\tIntercept to Host Timer delta: %lld ns (%.2f us, %.2f ms)\n"
+            //    "\tIntercept Start %llu ns, Intercept End %llu ns (delta %lld ns)\n"
+            //    "\tHost %llu ns\n",
+            //    node.ProfilingDeltaNS, node.ProfilingDeltaNS / 1000.0, node.ProfilingDeltaNS / 1000000.0,
+            //    interceptHostTimeDeltaNS, interceptHostTimeDeltaNS / 1000.0, interceptHostTimeDeltaNS / 1000000.0,
+            //    interceptTimeStartNS, interceptTimeEndNS, interceptTimeEndNS - interceptTimeStartNS,
+            //    hostTimeNS );
         }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::checkTimingEvents()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    CEventList::iterator    current = m_EventList.begin();
+    CEventList::iterator    next;
+
+    while( current != m_EventList.end() )
+    {
+        cl_int  errorCode = CL_SUCCESS;
+        cl_int  eventStatus = 0;
+
+        next = current;
+        ++next;
+
+        const SEventListNode& node = *current;
+
+        errorCode = dispatch().clGetEventInfo(
+            node.Event,
+            CL_EVENT_COMMAND_EXECUTION_STATUS,
+            sizeof( eventStatus ),
+            &eventStatus,
+            NULL );
 
-        if( config().DevicePerformanceTimeGWOTracking )
+        switch( errorCode )
         {
-            std::ostringstream  ss;
-            ss << " GWO[ ";
-            if( gwo )
+        case CL_SUCCESS:
+            if( eventStatus == CL_COMPLETE )
             {
-                if( workDim >= 1 )
-                {
-                    ss << gwo[0];
-                }
-                if( workDim >= 2 )
-                {
-                    ss << ", " << gwo[1];
-                }
-                if( workDim >= 3 )
+                if( config().DevicePerformanceTiming ||
+                    config().ITTPerformanceTiming ||
+                    config().ChromePerformanceTiming )
                 {
-                    ss << ", " << gwo[2];
-                }
-            }
-            else
-            {
-                ss << "NULL";
-            }
-            ss << " ]";
-            deviceTag += ss.str();
-        }
+                    cl_ulong    commandQueued = 0;
+                    cl_ulong    commandSubmit = 0;
+                    cl_ulong    commandStart = 0;
+                    cl_ulong    commandEnd = 0;
 
-        if( config().DevicePerformanceTimeGWSTracking )
-        {
-            std::ostringstream  ss;
-            ss << " GWS[ ";
-            if( gws )
-            {
-                if( workDim >= 1 )
-                {
-                    ss << gws[0];
-                }
-                if( workDim >= 2 )
-                {
-                    ss << " x " << gws[1];
-                }
-                if( workDim >= 3 )
-                {
-                    ss << " x " << gws[2];
-                }
-            }
-            else
-            {
-                ss << "NULL";
-            }
-            ss << " ]";
-            deviceTag += ss.str();
-        }
+                    errorCode |= dispatch().clGetEventProfilingInfo(
+                        node.Event,
+                        CL_PROFILING_COMMAND_QUEUED,
+                        sizeof( commandQueued ),
+                        &commandQueued,
+                        NULL );
+                    errorCode |= dispatch().clGetEventProfilingInfo(
+                        node.Event,
+                        CL_PROFILING_COMMAND_SUBMIT,
+                        sizeof( commandSubmit ),
+                        &commandSubmit,
+                        NULL );
+                    errorCode |= dispatch().clGetEventProfilingInfo(
+                        node.Event,
+                        CL_PROFILING_COMMAND_START,
+                        sizeof( commandStart ),
+                        &commandStart,
+                        NULL );
+                    errorCode |= dispatch().clGetEventProfilingInfo(
+                        node.Event,
+                        CL_PROFILING_COMMAND_END,
+                        sizeof( commandEnd ),
+                        &commandEnd,
+                        NULL );
+                    if( errorCode == CL_SUCCESS )
+                    {
+                        cl_ulong delta = commandEnd - commandStart;
 
-        if( config().DevicePerformanceTimeLWSTracking )
-        {
-            bool    useSuggestedLWS = false;
-            size_t  suggestedLWS[3] = { 0, 0, 0 };
-            size_t  emptyGWO[3] = { 0, 0, 0 };
+                        SDeviceTimingStats& deviceTimingStats = m_DeviceTimingStatsMap[node.Device][node.Name];
 
-            if( lws == NULL &&
-                workDim <= 3 &&
-                config().DevicePerformanceTimeSuggestedLWSTracking )
-            {
-                cl_platform_id  platform = getPlatform(device);
+                        deviceTimingStats.NumberOfCalls++;
+                        deviceTimingStats.TotalNS += delta;
+                        deviceTimingStats.MinNS = std::min< cl_ulong >( deviceTimingStats.MinNS, delta );
+                        deviceTimingStats.MaxNS = std::max< cl_ulong >( deviceTimingStats.MaxNS, delta );
 
-                // Try the cl_khr_suggested_local_work_size version first.
-                if( useSuggestedLWS == false )
-                {
-                    if( dispatchX(platform).clGetKernelSuggestedLocalWorkSizeKHR == NULL )
-                    {
-                        getExtensionFunctionAddress(
-                            platform,
-                            "clGetKernelSuggestedLocalWorkSizeKHR" );
-                    }
+                        //uint64_t    numberOfCalls = deviceTimingStats.NumberOfCalls;
 
-                    const auto& dispatchX = this->dispatchX(platform);
-                    if( dispatchX.clGetKernelSuggestedLocalWorkSizeKHR )
-                    {
-                        cl_int testErrorCode = dispatchX.clGetKernelSuggestedLocalWorkSizeKHR(
-                            queue,
-                            kernel,
-                            workDim,
-                            gwo,
-                            gws,
-                            suggestedLWS );
-                        useSuggestedLWS = ( testErrorCode == CL_SUCCESS );
-                    }
-                }
+                        if( config().DevicePerformanceTimeLogging )
+                        {
+                            cl_ulong    queuedDelta = commandSubmit - commandQueued;
+                            cl_ulong    submitDelta = commandStart - commandSubmit;
 
-                // If this fails, try the unofficial Intel version next.
-                if( useSuggestedLWS == false )
-                {
-                    if( dispatchX(platform).clGetKernelSuggestedLocalWorkSizeINTEL == NULL )
-                    {
-                        getExtensionFunctionAddress(
-                            platform,
-                            "clGetKernelSuggestedLocalWorkSizeINTEL" );
-                    }
+                            std::ostringstream  ss;
 
-                    const auto& dispatchX = this->dispatchX(platform);
-                    if( dispatchX.clGetKernelSuggestedLocalWorkSizeINTEL )
-                    {
-                        cl_int testErrorCode = dispatchX.clGetKernelSuggestedLocalWorkSizeINTEL(
-                            queue,
-                            kernel,
-                            workDim,
-                            gwo == NULL ? emptyGWO : gwo,
-                            gws,
-                            suggestedLWS );
-                        useSuggestedLWS = ( testErrorCode == CL_SUCCESS );
-                    }
-                }
-            }
+                            ss << "Device Time for "
+                                //<< "call " << numberOfCalls << " to "
+                                << node.Name << " (enqueue " << node.EnqueueCounter << ") = "
+                                << queuedDelta << " ns (queued -> submit), "
+                                << submitDelta << " ns (submit -> start), "
+                                << delta << " ns (start -> end)\n";
 
-            std::ostringstream  ss;
-            if( useSuggestedLWS )
-            {
-                ss << " SLWS[ ";
-                lws = suggestedLWS;
-            }
-            else
-            {
-                ss << " LWS[ ";
-            }
+                            log( ss.str() );
+                        }
 
-            if( lws )
-            {
-                if( workDim >= 1 )
-                {
-                    ss << lws[0];
-                }
-                if( workDim >= 2 )
-                {
-                    ss << " x " << lws[1];
+                        if( config().DevicePerformanceTimelineLogging )
+                        {
+                            std::ostringstream  ss;
+
+                            ss << "Device Timeline for "
+                                //<< "call " << numberOfCalls << " to "
+                                << node.Name << " (enqueue " << node.EnqueueCounter << ") = "
+                                << commandQueued << " ns (queued), "
+                                << commandSubmit << " ns (submit), "
+                                << commandStart << " ns (start), "
+                                << commandEnd << " ns (end)\n";
+
+                            log( ss.str() );
+                        }
+
+#if defined(USE_ITT)
+                        if( config().ITTPerformanceTiming )
+                        {
+                            ittTraceEvent(
+                                node.Name,
+                                node.Event,
+                                node.QueuedTime,
+                                commandQueued,
+                                commandSubmit,
+                                commandStart,
+                                commandEnd );
+                        }
+#endif
+
+                        if( config().ChromePerformanceTiming )
+                        {
+                            bool useProfilingDelta =
+                                node.UseProfilingDelta &&
+                                !config().ChromePerformanceTimingEstimateQueuedTime;
+
+                            chromeTraceEvent(
+                                node.Name,
+                                useProfilingDelta,
+                                node.ProfilingDeltaNS,
+                                node.EnqueueCounter,
+                                node.QueueNumber,
+                                node.QueuedTime,
+                                commandQueued,
+                                commandSubmit,
+                                commandStart,
+                                commandEnd );
+                        }
+                    }
                 }
-                if( workDim >= 3 )
+
+#if defined(USE_MDAPI)
+                if( config().DevicePerfCounterEventBasedSampling )
                 {
-                    ss << " x " << lws[2];
+                    getMDAPICountersFromEvent(
+                        node.Name,
+                        node.Event );
                 }
+#endif
+
+                dispatch().clReleaseEvent( node.Event );
+
+                m_EventList.erase( current );
             }
-            else
+            break;
+        case CL_INVALID_EVENT:
             {
-                ss << "NULL";
-            }
+                // This is unexpected.  We retained the event when we
+                // added it to the list.  Remove the event from the
+                // list.
+                logf( "Unexpectedly got CL_INVALID_EVENT for an event from %s!\n",
+                    node.Name.c_str() );
 
-            ss << " ]";
-            deviceTag += ss.str();
+                m_EventList.erase( current );
+            }
+            break;
+        default:
+            // nothing
+            break;
         }
+
+        current = next;
+    }
+
+#if defined(USE_MDAPI)
+    if( config().DevicePerfCounterTimeBasedSampling )
+    {
+        getMDAPICountersFromStream();
     }
+#endif
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::getRecordTagCommandBufferKernel(
-    const cl_command_buffer_khr cmdbuf,
-    const cl_kernel kernel,
-    const cl_uint workDim,
-    const size_t* gwo,
-    const size_t* gws,
-    const size_t* lws,
-    const cl_mutable_command_khr* mutable_handle,
-    std::string& recordTag )
+cl_command_queue CLIntercept::getCommandBufferCommandQueue(
+    cl_uint numQueues,
+    const cl_command_queue* queues,
+    cl_command_buffer_khr cmdbuf )
 {
-    std::lock_guard<std::mutex> lock(m_Mutex);
-
-    if( kernel )
+    if( numQueues != 0 && queues != NULL )
     {
-        std::ostringstream  ss;
+        return queues[0];
+    }
 
-        recordTag += getShortKernelNameWithHash(kernel);
+    std::lock_guard<std::mutex> lock(m_Mutex);
 
-        if( gwo )
-        {
-            ss << " GWO[ ";
-            if( workDim >= 1 )
-            {
-                ss << gwo[0];
-            }
-            if( workDim >= 2 )
-            {
-                ss << ", " << gwo[1];
-            }
-            if( workDim >= 3 )
-            {
-                ss << ", " << gwo[2];
-            }
-            ss << " ]";
-        }
+    cl_command_queue    queue = NULL;
 
-        ss << " GWS[ ";
-        if( gws )
-        {
-            if( workDim >= 1 )
-            {
-                ss << gws[0];
-            }
-            if( workDim >= 2 )
-            {
-                ss << " x " << gws[1];
-            }
-            if( workDim >= 3 )
-            {
-                ss << " x " << gws[2];
-            }
-        }
-        else
+    CCommandBufferInfoMap::iterator iter = m_CommandBufferInfoMap.find( cmdbuf );
+    if( iter != m_CommandBufferInfoMap.end() )
+    {
+        cl_platform_id  platform = iter->second;
+        if( dispatchX(platform).clGetCommandBufferInfoKHR == NULL )
         {
-            ss << "NULL";
+            getExtensionFunctionAddress(
+                platform,
+                "clGetCommandBufferInfoKHR" );
         }
-        ss << " ]";
 
-        ss << " LWS[ ";
-        if( lws )
+        const auto& dispatchX = this->dispatchX(platform);
+        if( dispatchX.clGetCommandBufferInfoKHR )
         {
-            if( workDim >= 1 )
-            {
-                ss << lws[0];
-            }
-            if( workDim >= 2 )
+            dispatchX.clGetCommandBufferInfoKHR(
+                cmdbuf,
+                CL_COMMAND_BUFFER_NUM_QUEUES_KHR,
+                sizeof( numQueues ),
+                &numQueues,
+                NULL );
+            if( numQueues == 1)
             {
-                ss << " x " << lws[1];
+                dispatchX.clGetCommandBufferInfoKHR(
+                    cmdbuf,
+                    CL_COMMAND_BUFFER_QUEUES_KHR,
+                    sizeof( queue ),
+                    &queue,
+                    NULL );
             }
-            if( workDim >= 3 )
+            else if( numQueues > 1 )
             {
-                ss << " x " << lws[2];
+                std::vector<cl_command_queue> queues(numQueues);
+                dispatchX.clGetCommandBufferInfoKHR(
+                    cmdbuf,
+                    CL_COMMAND_BUFFER_QUEUES_KHR,
+                    queues.size() * sizeof(queues[0]),
+                    queues.data(),
+                    NULL );
+                queue = queues[0];
             }
         }
-        else
-        {
-            ss << "NULL";
-        }
-        ss << " ]";
+    }
 
-        if( mutable_handle )
-        {
-            ss << " [MUTABLE]";
-        }
+    return queue;
+}
 
-        recordTag += ss.str();
-    }
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::recordCommandBufferCreate(
+    cl_command_buffer_khr cmdbuf,
+    cl_uint num_queues,
+    const cl_command_queue* queues )
+{
+    cl_command_queue queue = getCommandBufferCommandQueue(
+        num_queues,
+        queues,
+        cmdbuf );
+
+    cl_command_queue_properties props = 0;
+    dispatch().clGetCommandQueueInfo(
+        queue,
+        CL_QUEUE_PROPERTIES,
+        sizeof(props),
+        &props,
+        NULL );
+
+    bool isInOrder = (props & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE) == 0;
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    SCommandBufferRecord& recording = m_CommandBufferRecordMap[ cmdbuf ];
+    recording.recordCreate(cmdbuf, isInOrder);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::updateHostTimingStats(
+void CLIntercept::recordCommandBufferCommand(
+    cl_command_buffer_khr cmdbuf,
     const char* functionName,
     const std::string& tag,
-    clock::time_point start,
-    clock::time_point end )
+    cl_uint num_sync_points_in_wait_list,
+    const cl_sync_point_khr* sync_point_wait_list,
+    cl_sync_point_khr* sync_point )
 {
     std::lock_guard<std::mutex> lock(m_Mutex);
 
-    std::string key( functionName );
-    if( !tag.empty() )
-    {
-        key += "( ";
-        key += tag;
-        key += " )";
-    }
-
-    SHostTimingStats& hostTimingStats = m_HostTimingStatsMap[ key ];
-
-    using ns = std::chrono::nanoseconds;
-    uint64_t    nsDelta = std::chrono::duration_cast<ns>(end - start).count();
+    SCommandBufferRecord& recording = m_CommandBufferRecordMap[ cmdbuf ];
+    recording.recordCommand(
+        nullptr,
+        functionName,
+        tag.c_str(),
+        num_sync_points_in_wait_list,
+        sync_point_wait_list,
+        sync_point );
+}
 
-    hostTimingStats.NumberOfCalls++;
-    hostTimingStats.TotalNS += nsDelta;
-    hostTimingStats.MinNS = std::min<uint64_t>( hostTimingStats.MinNS, nsDelta );
-    hostTimingStats.MaxNS = std::max<uint64_t>( hostTimingStats.MaxNS, nsDelta );
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::recordCommandBufferBarrier(
+    cl_command_buffer_khr cmdbuf,
+    const char* functionName,
+    cl_uint num_sync_points_in_wait_list,
+    const cl_sync_point_khr* sync_point_wait_list,
+    cl_sync_point_khr* sync_point )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
 
-    if( config().HostPerformanceTimeLogging )
-    {
-        uint64_t    numberOfCalls = hostTimingStats.NumberOfCalls;
-        logf( "Host Time for call %" PRIu64 ": %s = %" PRIu64 " ns\n",
-            numberOfCalls,
-            key.c_str(),
-            nsDelta );
-    }
+    SCommandBufferRecord& recording = m_CommandBufferRecordMap[ cmdbuf ];
+    recording.recordBarrier(
+        nullptr,
+        functionName,
+        num_sync_points_in_wait_list,
+        sync_point_wait_list,
+        sync_point );
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::modifyCommandQueueProperties(
-    cl_command_queue_properties& props ) const
+void CLIntercept::recordCommandBufferFinalize(
+    cl_command_buffer_khr cmdbuf )
 {
-    if( config().InOrderQueue )
-    {
-        props &= ~(cl_command_queue_properties)CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE;
-    }
-    if( config().NoProfilingQueue )
-    {
-        props &= ~(cl_command_queue_properties)CL_QUEUE_PROFILING_ENABLE;
-    }
-    if( config().DevicePerformanceTiming ||
-        config().ITTPerformanceTiming ||
-        config().ChromePerformanceTiming ||
-        config().DevicePerfCounterEventBasedSampling )
-    {
-        props |= (cl_command_queue_properties)CL_QUEUE_PROFILING_ENABLE;
-    }
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    SCommandBufferRecord& recording = m_CommandBufferRecordMap[ cmdbuf ];
+    recording.recordFinalize();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::createCommandQueueProperties(
-    cl_device_id device,
-    cl_command_queue_properties props,
-    cl_queue_properties*& pLocalQueueProperties ) const
+void CLIntercept::dumpCommandBufferRecording(
+    cl_command_buffer_khr cmdbuf )
 {
-    bool    addCommandQueuePropertiesEnum = true;
-    bool    addPriorityHintEnum =
-                config().DefaultQueuePriorityHint != 0 &&
-                checkDeviceForExtension( device, "cl_khr_priority_hints" );
-    bool    addThrottleHintEnum =
-                config().DefaultQueueThrottleHint != 0 &&
-                checkDeviceForExtension( device, "cl_khr_throttle_hints" );
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    SCommandBufferRecord& recording = m_CommandBufferRecordMap[ cmdbuf ];
+
+    const auto& str = recording.getRecording();
+    const char* ptr = str.c_str();
+    size_t size = str.size();
+
+    auto hash = computeHash( ptr, size );
 
-    size_t  numProperties = 0;
-    if( addCommandQueuePropertiesEnum )
-    {
-        numProperties += 2;
-    }
-    if( addThrottleHintEnum )
-    {
-        numProperties += 2;
-    }
-    if( addThrottleHintEnum )
-    {
-        numProperties += 2;
-    }
+    std::string fileName;
 
-    // Allocate a new array of properties.  We need to allocate two
-    // properties for each pair, plus one property for the terminating
-    // zero.
-    pLocalQueueProperties = new cl_queue_properties[ numProperties + 1 ];
-    if( pLocalQueueProperties )
+    // Get the dump directory name.
+    OS().GetDumpDirectoryName( sc_DumpDirectoryName, fileName );
+
+    // Make the file name.  It will have the form:
+    //   CLI_<program number>_<hash>_cmdbuf.dot
     {
-        numProperties = 0;
+        char    numberString[256] = "";
 
-        if( addPriorityHintEnum )
+        if( config().OmitCommandBufferNumber )
         {
-            CLI_ASSERT( config().DefaultQueuePriorityHint != 0 );
-            pLocalQueueProperties[ numProperties] = CL_QUEUE_PRIORITY_KHR;
-            pLocalQueueProperties[ numProperties + 1 ] = config().DefaultQueuePriorityHint;
-            numProperties += 2;
+            CLI_SPRINTF( numberString, 256, "%08X",
+                (unsigned int)hash );
         }
-        if( config().DefaultQueueThrottleHint != 0 )
+        else
         {
-            CLI_ASSERT( config().DefaultQueueThrottleHint != 0 );
-            pLocalQueueProperties[ numProperties] = CL_QUEUE_THROTTLE_KHR;
-            pLocalQueueProperties[ numProperties + 1 ] = config().DefaultQueueThrottleHint;
-            numProperties += 2;
+            CLI_SPRINTF( numberString, 256, "%04u_%08X",
+                m_CommandBufferNumber,
+                (unsigned int)hash );
         }
 
-        // This setting is added last in the list, in order to better behave with runtimes
-        // truncating it when a property has a value of 0, which may be the case below.
-        if( addCommandQueuePropertiesEnum )
-        {
-            modifyCommandQueueProperties(props);
+        fileName += "/CLI_";
+        fileName += numberString;
+        fileName += "_cmdbuf.dot";
+    }
 
-            pLocalQueueProperties[numProperties] = CL_QUEUE_PROPERTIES;
-            pLocalQueueProperties[numProperties + 1] = props;
-            numProperties += 2;
-        }
+    // Now make directories as appropriate.
+    OS().MakeDumpDirectories( fileName );
 
-        // Add the terminating zero.
-        pLocalQueueProperties[ numProperties ] = 0;
-    }
+    log( "Dumping command buffer to file: " + fileName + "\n" );
+    dumpMemoryToFile(
+        fileName,
+        false,
+        ptr,
+        size );
+
+    m_CommandBufferNumber++;
+
+    // Now that we are done tracing, we can remove the trace info.
+    m_CommandBufferRecordMap.erase( cmdbuf );
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::createCommandQueuePropertiesOverride(
+cl_command_queue CLIntercept::createCommandQueueWithProperties(
+    cl_context context,
     cl_device_id device,
     const cl_queue_properties* properties,
-    cl_queue_properties*& pLocalQueueProperties ) const
+    cl_int* errcode_ret )
 {
-    // We're always going to add command queue properties, unless command queue
-    // properties already exist (requesting the same property twice is an
-    // error).  We also may add priority hints or throttle hints, in some cases.
-    // So, look through the queue properties for these enums.  We need to do
-    // this anyways to count the number of property pairs.
-    bool    addCommandQueuePropertiesEnum = true;
-    bool    addPriorityHintEnum =
-                config().DefaultQueuePriorityHint != 0 &&
-                checkDeviceForExtension( device, "cl_khr_priority_hints" );
-    bool    addThrottleHintEnum =
-                config().DefaultQueueThrottleHint != 0 &&
-                checkDeviceForExtension( device, "cl_khr_throttle_hints" );
+    cl_command_queue    retVal = NULL;
 
-    size_t  numProperties = 0;
-    if( properties )
-    {
-        while( properties[ numProperties ] != 0 )
-        {
-            switch( properties[ numProperties ] )
-            {
-            case CL_QUEUE_PROPERTIES:
-                addCommandQueuePropertiesEnum = false;
-                break;
-            case CL_QUEUE_PRIORITY_KHR:
-                addPriorityHintEnum = false;
-                break;
-            case CL_QUEUE_THROTTLE_KHR:
-                addThrottleHintEnum = false;
-                break;
-            default:
-                break;
-            }
-            numProperties += 2;
-        }
-    }
+    // Cache the device info if it's not cached already.
+    cacheDeviceInfo( device );
 
-    if( addCommandQueuePropertiesEnum )
-    {
-        numProperties += 2;
-    }
-    if( addThrottleHintEnum )
-    {
-        numProperties += 2;
-    }
-    if( addThrottleHintEnum )
+    const SDeviceInfo& deviceInfo = m_DeviceInfoMap[device];
+
+    // First, check if this is an OpenCL 2.0 or newer device.  If it is, we can
+    // simply call the clCreateCommandQueueWithProperties function.
+    if( retVal == NULL &&
+        deviceInfo.NumericVersion >= CL_MAKE_VERSION_KHR(2, 0, 0) )
     {
-        numProperties += 2;
+        retVal = dispatch().clCreateCommandQueueWithProperties(
+            context,
+            device,
+            properties,
+            errcode_ret );
     }
 
-    // Allocate a new array of properties.  We need to allocate two
-    // properties for each pair, plus one property for the terminating
-    // zero.
-    pLocalQueueProperties = new cl_queue_properties[ numProperties + 1 ];
-    if( pLocalQueueProperties )
+    // If this didn't work, try to use the create command queue with properties
+    // extension.
+    if( retVal == NULL &&
+        deviceInfo.Supports_cl_khr_create_command_queue )
     {
-        // Copy the old properties array to the new properties array,
-        // if the new properties array exists.
-        numProperties = 0;
-        if( properties )
-        {
-            while( properties[ numProperties ] != 0 )
-            {
-                pLocalQueueProperties[ numProperties ] = properties[ numProperties ];
-                if( properties[ numProperties ] == CL_QUEUE_PROPERTIES )
-                {
-                    CLI_ASSERT( addCommandQueuePropertiesEnum == false );
-
-                    cl_command_queue_properties props = properties[ numProperties + 1 ];
-
-                    modifyCommandQueueProperties( props );
-
-                    pLocalQueueProperties[ numProperties + 1 ] = props;
-                }
-                else
-                {
-                    pLocalQueueProperties[ numProperties + 1 ] =
-                        properties[ numProperties + 1 ];
-                }
-                numProperties += 2;
-            }
-        }
-        if( addPriorityHintEnum )
-        {
-            CLI_ASSERT( config().DefaultQueuePriorityHint != 0 );
-            pLocalQueueProperties[ numProperties] = CL_QUEUE_PRIORITY_KHR;
-            pLocalQueueProperties[ numProperties + 1 ] = config().DefaultQueuePriorityHint;
-            numProperties += 2;
-        }
-        if( addThrottleHintEnum )
+        cl_platform_id  platform = getPlatform(device);
+        if( dispatchX(platform).clCreateCommandQueueWithPropertiesKHR == NULL )
         {
-            CLI_ASSERT( config().DefaultQueueThrottleHint != 0 );
-            pLocalQueueProperties[ numProperties] = CL_QUEUE_THROTTLE_KHR;
-            pLocalQueueProperties[ numProperties + 1 ] = config().DefaultQueueThrottleHint;
-            numProperties += 2;
+            getExtensionFunctionAddress(
+                platform,
+                "clCreateCommandQueueWithPropertiesKHR" );
         }
 
-        // This setting is added last in the list, in order to better behave with runtimes
-        // truncating it when a property has a value of 0, which may be the case below.
-        if( addCommandQueuePropertiesEnum )
+        const auto& dispatchX = this->dispatchX(platform);
+        if( dispatchX.clCreateCommandQueueWithPropertiesKHR )
         {
-            cl_command_queue_properties props = 0;
-
-            modifyCommandQueueProperties(props);
-
-            pLocalQueueProperties[numProperties] = CL_QUEUE_PROPERTIES;
-            pLocalQueueProperties[numProperties + 1] = props;
-            numProperties += 2;
+            retVal = dispatchX.clCreateCommandQueueWithPropertiesKHR(
+                context,
+                device,
+                properties,
+                errcode_ret );
         }
-
-        // Add the terminating zero.
-        pLocalQueueProperties[ numProperties ] = 0;
     }
+
+    return retVal;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::dummyCommandQueue(
-    cl_context context,
-    cl_device_id device )
+void CLIntercept::addSubDeviceInfo(
+    const cl_device_id parentDevice,
+    const cl_device_id* devices,
+    cl_uint numSubDevices )
 {
-    if( config().DummyOutOfOrderQueue )
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    while( numSubDevices-- )
     {
-        cl_command_queue_properties props;
-        dispatch().clGetDeviceInfo(
-            device,
-            CL_DEVICE_QUEUE_ON_HOST_PROPERTIES,
-            sizeof(props),
-            &props,
-            NULL );
-        if( props & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE )
+        cl_device_id    device = devices[ numSubDevices ];
+        if( device )
         {
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            SSubDeviceInfo& subDeviceInfo = m_SubDeviceInfoMap[ device ];
 
-            log( "Creating and destroying a dummy out-of-order queue.\n" );
+            subDeviceInfo.ParentDevice = parentDevice;
+            subDeviceInfo.SubDeviceIndex = numSubDevices;
 
-            cl_int  errorCode = CL_SUCCESS;
-            cl_command_queue dummy = dispatch().clCreateCommandQueue(
-                context,
-                device,
-                CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE,
-                &errorCode );
-            if( errorCode == CL_SUCCESS )
-            {
-                dispatch().clReleaseCommandQueue( dummy );
-            }
-            else
-            {
-                logf( "Error creating dummy command queue!  %s (%i)\n",
-                    enumName().name( errorCode ).c_str(),
-                    errorCode );
+            // Currently, information about a device is assumed to be
+            // invariant, though for sub-device handles the information
+            // about a device can change if sub-device handles are recycled.
+            // Since this is expected to occur rarely, for now simply log a
+            // warning if this occurs.
+            if( m_DeviceInfoMap.find(device) != m_DeviceInfoMap.end() )
+            {
+                logf( "Warning: found a recycled sub-device handle %p!\n",
+                    device );
             }
         }
     }
@@ -6392,300 +8471,443 @@ void CLIntercept::dummyCommandQueue(
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::addTimingEvent(
-    const char* functionName,
-    const uint64_t enqueueCounter,
-    const clock::time_point queuedTime,
-    const std::string& tag,
-    const cl_command_queue queue,
-    cl_event event )
+void CLIntercept::checkRemoveDeviceInfo(
+    cl_device_id device )
 {
     std::lock_guard<std::mutex> lock(m_Mutex);
 
-    if( event == NULL )
+    cl_uint refCount = getRefCount( device );
+    if( refCount == 1 )
     {
-        logf( "Unexpectedly got a NULL timing event for %s, check for OpenCL errors!\n",
-            functionName );
-        return;
+        m_SubDeviceInfoMap.erase( device );
     }
+}
 
-    m_EventList.emplace_back();
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::addKernelInfo(
+    const cl_kernel kernel,
+    const cl_program program,
+    const std::string& kernelName )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
 
-    SEventListNode& node = m_EventList.back();
+    const SProgramInfo& programInfo = m_ProgramInfoMap[ program ];
 
-    cl_device_id device = NULL;
-    dispatch().clGetCommandQueueInfo(
-        queue,
-        CL_QUEUE_DEVICE,
-        sizeof(device),
-        &device,
-        NULL );
+    SKernelInfo& kernelInfo = m_KernelInfoMap[ kernel ];
+    std::string demangledName = config().DemangleKernelNames ?
+        demangle(kernelName) :
+        kernelName;
 
-    // Cache the device info if it's not cached already, since we'll print
-    // the device name and other device properties as part of the report.
-    cacheDeviceInfo( device );
+    kernelInfo.KernelName = demangledName;
 
-    dispatch().clRetainEvent( event );
+    kernelInfo.ProgramHash = programInfo.ProgramHash;
+    kernelInfo.OptionsHash = programInfo.OptionsHash;
 
-    node.Device = device;
-    node.QueueNumber = m_QueueNumberMap[ queue ];
-    node.Name = !tag.empty() ? tag : functionName;
-    node.EnqueueCounter = enqueueCounter;
-    node.QueuedTime = queuedTime;
-    node.UseProfilingDelta = false;
-    node.ProfilingDeltaNS = 0;
-    node.Event = event;
+    kernelInfo.ProgramNumber = programInfo.ProgramNumber;
+    kernelInfo.CompileCount = programInfo.CompileCount - 1;
 
-    if( device )
-    {
-        const SDeviceInfo& deviceInfo = m_DeviceInfoMap[device];
+    setShortKernelNames( kernelInfo );
+}
 
-        // Note: Even though ideally the intercept timer and the host timer should advance
-        // at a consistent rate and hence the delta between the two timers should remain
-        // constant, empirically this does not appear to be the case.  Synchronizing the
-        // two timers is relatively inexpensive, and reduces the timer drift, so compute
-        // the current delta for each event.
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::addKernelInfo(
+    const cl_kernel* kernels,
+    const cl_program program,
+    cl_uint numKernels )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
 
-        if( deviceInfo.HasDeviceAndHostTimer )
+    const SProgramInfo& programInfo = m_ProgramInfoMap[ program ];
+
+    while( numKernels-- )
+    {
+        cl_kernel   kernel = kernels[ numKernels ];
+        char*       kernelName = NULL;
+        size_t      kernelNameSize = 0;
+        cl_int      errorCode = CL_SUCCESS;
+
+        errorCode = dispatch().clGetKernelInfo(
+            kernel,
+            CL_KERNEL_FUNCTION_NAME,
+            0,
+            NULL,
+            &kernelNameSize );
+        if( errorCode == CL_SUCCESS )
         {
-            // These conditions should have been checked for HasDeviceAndHostTimer to be true:
-            CLI_ASSERT( deviceInfo.NumericVersion >= CL_MAKE_VERSION_KHR(2, 1, 0) );
-            CLI_ASSERT( dispatch().clGetHostTimer );
+            kernelName = new char[ kernelNameSize + 1 ];
+            if( kernelName )
+            {
+                errorCode = dispatch().clGetKernelInfo(
+                    kernel,
+                    CL_KERNEL_FUNCTION_NAME,
+                    kernelNameSize,
+                    kernelName,
+                    NULL );
+                if( errorCode == CL_SUCCESS )
+                {
+                    kernelName[ kernelNameSize ] = 0;
 
-            using ns = std::chrono::nanoseconds;
-            const uint64_t  interceptTimeStartNS =
-                std::chrono::duration_cast<ns>(clock::now().time_since_epoch()).count();
+                    // Kernels created by clCreateKernelsInProgram are
+                    // recorded as if they were created by name, which
+                    // replays the same way.
+                    if( config().CaptureStream )
+                    {
+                        m_StreamCapture.createKernel(
+                            kernel,
+                            program,
+                            kernelName );
+                    }
 
-            cl_ulong    hostTimeNS = 0;
-            dispatch().clGetHostTimer(
-                device,
-                &hostTimeNS);
+                    SKernelInfo& kernelInfo = m_KernelInfoMap[ kernel ];
+                    std::string demangledName = config().DemangleKernelNames ?
+                        demangle(kernelName) :
+                        kernelName;
 
-            const uint64_t  interceptTimeEndNS =
-                std::chrono::duration_cast<ns>(clock::now().time_since_epoch()).count();
+                    kernelInfo.KernelName = demangledName;
 
-            const int64_t   interceptHostTimeDeltaNS =
-                ( interceptTimeEndNS - interceptTimeStartNS ) / 2 +
-                ( interceptTimeStartNS - hostTimeNS );
+                    kernelInfo.ProgramHash = programInfo.ProgramHash;
+                    kernelInfo.OptionsHash = programInfo.OptionsHash;
 
-            node.UseProfilingDelta = true;
-            node.ProfilingDeltaNS =
-                interceptHostTimeDeltaNS -
-                deviceInfo.DeviceHostTimeDeltaNS;
+                    kernelInfo.ProgramNumber = programInfo.ProgramNumber;
+                    kernelInfo.CompileCount = programInfo.CompileCount - 1;
 
-            //logf( "Current Profiling Delta is %lld ns (%.2f us, %.2f ms)\n"
-            //    "\tIntercept to Host Timer delta: %lld ns (%.2f us, %.2f ms)\n"
-            //    "\tIntercept Start %llu ns, Intercept End %llu ns (delta %lld ns)\n"
-            //    "\tHost %llu ns\n",
-            //    node.ProfilingDeltaNS, node.ProfilingDeltaNS / 1000.0, node.ProfilingDeltaNS / 1000000.0,
-            //    interceptHostTimeDeltaNS, interceptHostTimeDeltaNS / 1000.0, interceptHostTimeDeltaNS / 1000000.0,
-            //    interceptTimeStartNS, interceptTimeEndNS, interceptTimeEndNS - interceptTimeStartNS,
-            //    hostTimeNS );
+                    setShortKernelNames( kernelInfo );
+                }
+
+                delete [] kernelName;
+            }
         }
     }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::checkTimingEvents()
+void CLIntercept::addKernelInfo(
+    const cl_kernel kernel,
+    const cl_kernel source_kernel )
 {
     std::lock_guard<std::mutex> lock(m_Mutex);
 
-    CEventList::iterator    current = m_EventList.begin();
-    CEventList::iterator    next;
+    m_KernelInfoMap[ kernel ] = m_KernelInfoMap[ source_kernel ];
+}
 
-    while( current != m_EventList.end() )
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::checkRemoveKernelInfo( cl_kernel kernel )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    cl_uint refCount = getRefCount( kernel );
+    if( refCount == 1 )
     {
-        cl_int  errorCode = CL_SUCCESS;
-        cl_int  eventStatus = 0;
+#if 0
+        // We shouldn't remove the kernel name from the local kernel name map
+        // here since the mapping may be included in the device performance
+        // time report.
+        m_LongKernelNameMap.erase( m_KernelInfoMap[ kernel ].KernelName );
+#endif
 
-        next = current;
-        ++next;
+        m_KernelInfoMap.erase( kernel );
 
-        const SEventListNode& node = *current;
+        if( config().LocalWorkSizeAutotuning )
+        {
+            std::lock_guard<std::mutex> decisionLock(m_LWSTuningDecisionMutex);
 
-        errorCode = dispatch().clGetEventInfo(
-            node.Event,
-            CL_EVENT_COMMAND_EXECUTION_STATUS,
-            sizeof( eventStatus ),
-            &eventStatus,
-            NULL );
+            SLWSTuningDecisionKey   first = {};
+            first.Kernel = kernel;
 
-        switch( errorCode )
+            CLWSTuningDecisionMap::iterator decisionIter =
+                m_LWSTuningDecisionMap.lower_bound( first );
+            while( decisionIter != m_LWSTuningDecisionMap.end() &&
+                   decisionIter->first.Kernel == kernel )
+            {
+                decisionIter = m_LWSTuningDecisionMap.erase( decisionIter );
+            }
+        }
+
+        CHotReloadKernelInfoMap::iterator iter =
+            m_HotReloadKernelInfoMap.find( kernel );
+        if( iter != m_HotReloadKernelInfoMap.end() )
         {
-        case CL_SUCCESS:
-            if( eventStatus == CL_COMPLETE )
+            if( iter->second.Kernel )
             {
-                if( config().DevicePerformanceTiming ||
-                    config().ITTPerformanceTiming ||
-                    config().ChromePerformanceTiming )
-                {
-                    cl_ulong    commandQueued = 0;
-                    cl_ulong    commandSubmit = 0;
-                    cl_ulong    commandStart = 0;
-                    cl_ulong    commandEnd = 0;
+                dispatch().clReleaseKernel( iter->second.Kernel );
+            }
+            m_HotReloadKernelInfoMap.erase( iter );
+        }
+    }
+}
 
-                    errorCode |= dispatch().clGetEventProfilingInfo(
-                        node.Event,
-                        CL_PROFILING_COMMAND_QUEUED,
-                        sizeof( commandQueued ),
-                        &commandQueued,
-                        NULL );
-                    errorCode |= dispatch().clGetEventProfilingInfo(
-                        node.Event,
-                        CL_PROFILING_COMMAND_SUBMIT,
-                        sizeof( commandSubmit ),
-                        &commandSubmit,
-                        NULL );
-                    errorCode |= dispatch().clGetEventProfilingInfo(
-                        node.Event,
-                        CL_PROFILING_COMMAND_START,
-                        sizeof( commandStart ),
-                        &commandStart,
-                        NULL );
-                    errorCode |= dispatch().clGetEventProfilingInfo(
-                        node.Event,
-                        CL_PROFILING_COMMAND_END,
-                        sizeof( commandEnd ),
-                        &commandEnd,
-                        NULL );
-                    if( errorCode == CL_SUCCESS )
-                    {
-                        cl_ulong delta = commandEnd - commandStart;
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::addRedundantWork(
+    const void* object,
+    const std::string& key,
+    uint64_t ns )
+{
+    // We're already in a critical section when we get here, so we don't need to
+    // grab the critical section again.
 
-                        SDeviceTimingStats& deviceTimingStats = m_DeviceTimingStatsMap[node.Device][node.Name];
+    SRedundantWorkStats&    stats = m_RedundantWorkStatsMap[ key ];
+    stats.Count++;
+    stats.TotalNS += ns;
+
+    // If this object was already counted for this key, for example because
+    // the same program was built again with the same options, then the work
+    // was redundant and the object is not live again.
+    std::vector<std::string>&   keys = m_RedundantWorkObjectMap[ object ];
+    if( std::find( keys.begin(), keys.end(), key ) == keys.end() )
+    {
+        keys.push_back( key );
+        stats.Live++;
+        stats.MaxLive = std::max( stats.MaxLive, stats.Live );
+    }
+
+    if( stats.Count > stats.MaxLive )
+    {
+        logf( "Redundant work detected: %s (%" PRIu64 " times)\n",
+            key.c_str(),
+            stats.Count - stats.MaxLive );
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::checkRedundantProgramCreate(
+    const cl_program program,
+    clock::time_point cpuStart,
+    clock::time_point cpuEnd )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    const SProgramInfo& programInfo = m_ProgramInfoMap[ program ];
+
+    char    key[256] = "";
+    CLI_SPRINTF( key, 256, "Create Program %016" PRIX64,
+        programInfo.ProgramHash );
+
+    uint64_t    ns = config().HostPerformanceTiming ?
+        std::chrono::duration_cast<std::chrono::nanoseconds>(cpuEnd - cpuStart).count() :
+        0;
+
+    addRedundantWork( program, key, ns );
+}
 
-                        deviceTimingStats.NumberOfCalls++;
-                        deviceTimingStats.TotalNS += delta;
-                        deviceTimingStats.MinNS = std::min< cl_ulong >( deviceTimingStats.MinNS, delta );
-                        deviceTimingStats.MaxNS = std::max< cl_ulong >( deviceTimingStats.MaxNS, delta );
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::checkRedundantProgramBuild(
+    const cl_program program,
+    const char* functionName,
+    clock::time_point cpuStart,
+    clock::time_point cpuEnd )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
 
-                        //uint64_t    numberOfCalls = deviceTimingStats.NumberOfCalls;
+    const SProgramInfo& programInfo = m_ProgramInfoMap[ program ];
 
-                        if( config().DevicePerformanceTimeLogging )
-                        {
-                            cl_ulong    queuedDelta = commandSubmit - commandQueued;
-                            cl_ulong    submitDelta = commandStart - commandSubmit;
+    // Linked programs do not have a program hash, so they can't be checked.
+    if( programInfo.ProgramHash == 0 )
+    {
+        return;
+    }
 
-                            std::ostringstream  ss;
+    char    key[256] = "";
+    CLI_SPRINTF( key, 256, "%s %016" PRIX64 " Options %016" PRIX64,
+        functionName,
+        programInfo.ProgramHash,
+        programInfo.OptionsHash );
 
-                            ss << "Device Time for "
-                                //<< "call " << numberOfCalls << " to "
-                                << node.Name << " (enqueue " << node.EnqueueCounter << ") = "
-                                << queuedDelta << " ns (queued -> submit), "
-                                << submitDelta << " ns (submit -> start), "
-                                << delta << " ns (start -> end)\n";
+    uint64_t    ns = config().HostPerformanceTiming ?
+        std::chrono::duration_cast<std::chrono::nanoseconds>(cpuEnd - cpuStart).count() :
+        0;
 
-                            log( ss.str() );
-                        }
+    addRedundantWork( program, key, ns );
+}
 
-                        if( config().DevicePerformanceTimelineLogging )
-                        {
-                            std::ostringstream  ss;
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::checkRedundantKernelCreate(
+    const cl_kernel* kernels,
+    cl_uint numKernels,
+    const char* functionName,
+    clock::time_point cpuStart,
+    clock::time_point cpuEnd )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
 
-                            ss << "Device Timeline for "
-                                //<< "call " << numberOfCalls << " to "
-                                << node.Name << " (enqueue " << node.EnqueueCounter << ") = "
-                                << commandQueued << " ns (queued), "
-                                << commandSubmit << " ns (submit), "
-                                << commandStart << " ns (start), "
-                                << commandEnd << " ns (end)\n";
+    // If multiple kernels were created by one call, split the time evenly
+    // between them.
+    uint64_t    ns = config().HostPerformanceTiming && numKernels ?
+        std::chrono::duration_cast<std::chrono::nanoseconds>(cpuEnd - cpuStart).count() / numKernels :
+        0;
 
-                            log( ss.str() );
-                        }
+    for( cl_uint k = 0; k < numKernels; k++ )
+    {
+        const SKernelInfo&  kernelInfo = m_KernelInfoMap[ kernels[k] ];
 
-#if defined(USE_ITT)
-                        if( config().ITTPerformanceTiming )
-                        {
-                            ittTraceEvent(
-                                node.Name,
-                                node.Event,
-                                node.QueuedTime,
-                                commandQueued,
-                                commandSubmit,
-                                commandStart,
-                                commandEnd );
-                        }
-#endif
+        char    key[256] = "";
+        CLI_SPRINTF( key, 256, "%s %016" PRIX64 " Options %016" PRIX64 " Kernel ",
+            functionName,
+            kernelInfo.ProgramHash,
+            kernelInfo.OptionsHash );
 
-                        if( config().ChromePerformanceTiming )
-                        {
-                            bool useProfilingDelta =
-                                node.UseProfilingDelta &&
-                                !config().ChromePerformanceTimingEstimateQueuedTime;
+        addRedundantWork( kernels[k], key + kernelInfo.KernelName, ns );
+    }
+}
 
-                            chromeTraceEvent(
-                                node.Name,
-                                useProfilingDelta,
-                                node.ProfilingDeltaNS,
-                                node.EnqueueCounter,
-                                node.QueueNumber,
-                                node.QueuedTime,
-                                commandQueued,
-                                commandSubmit,
-                                commandStart,
-                                commandEnd );
-                        }
-                    }
-                }
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::checkRedundantWorkRelease(
+    const void* object,
+    cl_uint refCount )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
 
-#if defined(USE_MDAPI)
-                if( config().DevicePerfCounterEventBasedSampling )
+    if( refCount == 1 )
+    {
+        CRedundantWorkObjectMap::iterator iter =
+            m_RedundantWorkObjectMap.find( object );
+        if( iter != m_RedundantWorkObjectMap.end() )
+        {
+            for( const auto& key : iter->second )
+            {
+                SRedundantWorkStats&    stats = m_RedundantWorkStatsMap[ key ];
+                if( stats.Live )
                 {
-                    getMDAPICountersFromEvent(
-                        node.Name,
-                        node.Event );
+                    stats.Live--;
                 }
-#endif
+            }
+            m_RedundantWorkObjectMap.erase( iter );
+        }
+    }
+}
 
-                dispatch().clReleaseEvent( node.Event );
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::addAcceleratorInfo(
+    cl_accelerator_intel accelerator,
+    cl_context context )
+{
+    if( accelerator )
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
 
-                m_EventList.erase( current );
-            }
-            break;
-        case CL_INVALID_EVENT:
-            {
-                // This is unexpected.  We retained the event when we
-                // added it to the list.  Remove the event from the
-                // list.
-                logf( "Unexpectedly got CL_INVALID_EVENT for an event from %s!\n",
-                    node.Name.c_str() );
+        m_AcceleratorInfoMap[accelerator] = getPlatform(context);
+    }
+}
 
-                m_EventList.erase( current );
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::checkRemoveAcceleratorInfo(
+    cl_accelerator_intel accelerator )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    CAcceleratorInfoMap::iterator iter = m_AcceleratorInfoMap.find( accelerator );
+    if( iter != m_AcceleratorInfoMap.end() )
+    {
+        cl_platform_id  platform = iter->second;
+        if( dispatchX(platform).clGetAcceleratorInfoINTEL == NULL )
+        {
+            getExtensionFunctionAddress(
+                platform,
+                "clGetAcceleratorInfoINTEL" );
+        }
+
+        const auto& dispatchX = this->dispatchX(platform);
+        if( dispatchX.clGetAcceleratorInfoINTEL )
+        {
+            cl_uint refCount = 0;
+            cl_int  errorCode = CL_SUCCESS;
+
+            errorCode = dispatchX.clGetAcceleratorInfoINTEL(
+                accelerator,
+                CL_ACCELERATOR_REFERENCE_COUNT_INTEL,
+                sizeof( refCount ),
+                &refCount,
+                NULL );
+            if( errorCode == CL_SUCCESS && refCount == 1 )
+            {
+                m_AcceleratorInfoMap.erase( iter );
             }
-            break;
-        default:
-            // nothing
-            break;
         }
+    }
+}
 
-        current = next;
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::addSemaphoreInfo(
+    cl_semaphore_khr semaphore,
+    cl_context context )
+{
+    if( semaphore )
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        m_SemaphoreInfoMap[semaphore] = getPlatform(context);
     }
+}
 
-#if defined(USE_MDAPI)
-    if( config().DevicePerfCounterTimeBasedSampling )
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::checkRemoveSemaphoreInfo(
+    cl_semaphore_khr semaphore )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    CSemaphoreInfoMap::iterator iter = m_SemaphoreInfoMap.find( semaphore );
+    if( iter != m_SemaphoreInfoMap.end() )
     {
-        getMDAPICountersFromStream();
+        cl_platform_id  platform = iter->second;
+        if( dispatchX(platform).clGetSemaphoreInfoKHR == NULL )
+        {
+            getExtensionFunctionAddress(
+                platform,
+                "clGetSemaphoreInfoKHR" );
+        }
+
+        const auto& dispatchX = this->dispatchX(platform);
+        if( dispatchX.clGetSemaphoreInfoKHR )
+        {
+            cl_uint refCount = 0;
+            cl_int  errorCode = CL_SUCCESS;
+            errorCode = dispatchX.clGetSemaphoreInfoKHR(
+                semaphore,
+                CL_SEMAPHORE_REFERENCE_COUNT_KHR,
+                sizeof( refCount ),
+                &refCount,
+                NULL );
+            if( errorCode == CL_SUCCESS && refCount == 1 )
+            {
+                m_SemaphoreInfoMap.erase( iter );
+            }
+        }
     }
-#endif
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-cl_command_queue CLIntercept::getCommandBufferCommandQueue(
-    cl_uint numQueues,
-    const cl_command_queue* queues,
-    cl_command_buffer_khr cmdbuf )
+void CLIntercept::addCommandBufferInfo(
+    cl_command_buffer_khr cmdbuf,
+    cl_command_queue queue )
 {
-    if( numQueues != 0 && queues != NULL )
+    if( cmdbuf )
     {
-        return queues[0];
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        m_CommandBufferInfoMap[cmdbuf] = getPlatform(queue);
     }
+}
 
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::checkRemoveCommandBufferInfo(
+    cl_command_buffer_khr cmdbuf)
+{
     std::lock_guard<std::mutex> lock(m_Mutex);
 
-    cl_command_queue    queue = NULL;
-
     CCommandBufferInfoMap::iterator iter = m_CommandBufferInfoMap.find( cmdbuf );
     if( iter != m_CommandBufferInfoMap.end() )
     {
@@ -6700,560 +8922,731 @@ cl_command_queue CLIntercept::getCommandBufferCommandQueue(
         const auto& dispatchX = this->dispatchX(platform);
         if( dispatchX.clGetCommandBufferInfoKHR )
         {
-            dispatchX.clGetCommandBufferInfoKHR(
-                cmdbuf,
-                CL_COMMAND_BUFFER_NUM_QUEUES_KHR,
-                sizeof( numQueues ),
-                &numQueues,
-                NULL );
-            if( numQueues == 1)
-            {
-                dispatchX.clGetCommandBufferInfoKHR(
-                    cmdbuf,
-                    CL_COMMAND_BUFFER_QUEUES_KHR,
-                    sizeof( queue ),
-                    &queue,
-                    NULL );
-            }
-            else if( numQueues > 1 )
+            cl_uint refCount = 0;
+            cl_int  errorCode = CL_SUCCESS;
+            errorCode = dispatchX.clGetCommandBufferInfoKHR(
+                cmdbuf,
+                CL_COMMAND_BUFFER_REFERENCE_COUNT_KHR,
+                sizeof( refCount ),
+                &refCount,
+                NULL );
+            if( errorCode == CL_SUCCESS && refCount == 1 )
             {
-                std::vector<cl_command_queue> queues(numQueues);
-                dispatchX.clGetCommandBufferInfoKHR(
-                    cmdbuf,
-                    CL_COMMAND_BUFFER_QUEUES_KHR,
-                    queues.size() * sizeof(queues[0]),
-                    queues.data(),
-                    NULL );
-                queue = queues[0];
+                m_CommandBufferInfoMap.erase( iter );
+                m_CommandBufferRecordMap.erase( cmdbuf );
+
+                CCommandBufferMutableCommandsMap::iterator cmditer =
+                    m_CommandBufferMutableCommandsMap.find( cmdbuf );
+                if( cmditer != m_CommandBufferMutableCommandsMap.end() )
+                {
+                    CMutableCommandList&    cmdList = cmditer->second;
+                    for( auto cmd : cmdList )
+                    {
+                        m_MutableCommandInfoMap.erase(cmd);
+                    }
+
+                    m_CommandBufferMutableCommandsMap.erase(cmditer);
+                }
             }
         }
     }
-
-    return queue;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::recordCommandBufferCreate(
+void CLIntercept::addMutableCommandInfo(
+    cl_mutable_command_khr cmd,
     cl_command_buffer_khr cmdbuf,
-    cl_uint num_queues,
-    const cl_command_queue* queues )
+    cl_uint dim )
 {
-    cl_command_queue queue = getCommandBufferCommandQueue(
-        num_queues,
-        queues,
-        cmdbuf );
-
-    cl_command_queue_properties props = 0;
-    dispatch().clGetCommandQueueInfo(
-        queue,
-        CL_QUEUE_PROPERTIES,
-        sizeof(props),
-        &props,
-        NULL );
+    if( cmd && cmdbuf )
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
 
-    bool isInOrder = (props & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE) == 0;
+        SMutableCommandInfo& info = m_MutableCommandInfoMap[cmd];
 
-    std::lock_guard<std::mutex> lock(m_Mutex);
+        info.Platform = getPlatform(cmdbuf);
+        info.WorkDim = dim;
 
-    SCommandBufferRecord& recording = m_CommandBufferRecordMap[ cmdbuf ];
-    recording.recordCreate(cmdbuf, isInOrder);
+        m_CommandBufferMutableCommandsMap[cmdbuf].push_back(cmd);
+    }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::recordCommandBufferCommand(
-    cl_command_buffer_khr cmdbuf,
-    const char* functionName,
-    const std::string& tag,
-    cl_uint num_sync_points_in_wait_list,
-    const cl_sync_point_khr* sync_point_wait_list,
-    cl_sync_point_khr* sync_point )
+void CLIntercept::addSamplerString(
+    cl_sampler sampler,
+    const std::string& str )
 {
-    std::lock_guard<std::mutex> lock(m_Mutex);
-
-    SCommandBufferRecord& recording = m_CommandBufferRecordMap[ cmdbuf ];
-    recording.recordCommand(
-        nullptr,
-        functionName,
-        tag.c_str(),
-        num_sync_points_in_wait_list,
-        sync_point_wait_list,
-        sync_point );
+    if( sampler )
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_SamplerDataMap[sampler] = str;
+    }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::recordCommandBufferBarrier(
-    cl_command_buffer_khr cmdbuf,
-    const char* functionName,
-    cl_uint num_sync_points_in_wait_list,
-    const cl_sync_point_khr* sync_point_wait_list,
-    cl_sync_point_khr* sync_point )
+void CLIntercept::checkRemoveSamplerString(
+    cl_sampler sampler )
 {
     std::lock_guard<std::mutex> lock(m_Mutex);
 
-    SCommandBufferRecord& recording = m_CommandBufferRecordMap[ cmdbuf ];
-    recording.recordBarrier(
-        nullptr,
-        functionName,
-        num_sync_points_in_wait_list,
-        sync_point_wait_list,
-        sync_point );
+    cl_uint refCount = getRefCount( sampler );
+    if( refCount == 1 )
+    {
+        m_SamplerDataMap.erase( sampler );
+    }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::recordCommandBufferFinalize(
-    cl_command_buffer_khr cmdbuf )
+bool CLIntercept::checkGetSamplerString(
+    size_t size,
+    const void *arg_value,
+    std::string& str ) const
 {
-    std::lock_guard<std::mutex> lock(m_Mutex);
+    bool found = false;
 
-    SCommandBufferRecord& recording = m_CommandBufferRecordMap[ cmdbuf ];
-    recording.recordFinalize();
+    if( ( arg_value != NULL ) && ( size == sizeof( cl_sampler ) ) )
+    {
+        const cl_sampler sampler = *(const cl_sampler *)arg_value;
+
+        CSamplerDataMap::const_iterator iter = m_SamplerDataMap.find( sampler );
+        if( iter != m_SamplerDataMap.end() )
+        {
+            str = iter->second;
+            found = true;
+        }
+    }
+
+    return found;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::dumpCommandBufferRecording(
-    cl_command_buffer_khr cmdbuf )
+void CLIntercept::addQueue(
+    cl_context context,
+    cl_command_queue queue )
 {
-    std::lock_guard<std::mutex> lock(m_Mutex);
-
-    SCommandBufferRecord& recording = m_CommandBufferRecordMap[ cmdbuf ];
-
-    const auto& str = recording.getRecording();
-    const char* ptr = str.c_str();
-    size_t size = str.size();
+    if( queue )
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
 
-    auto hash = computeHash( ptr, size );
+        m_QueueNumberMap[ queue ] = m_QueueNumber + 1;  // should be nonzero
+        m_QueueNumber++;
 
-    std::string fileName;
+        m_ContextQueuesMap[context].push_back(queue);
+    }
+}
 
-    // Get the dump directory name.
-    OS().GetDumpDirectoryName( sc_DumpDirectoryName, fileName );
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::checkRemoveQueue(
+    cl_command_queue queue )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
 
-    // Make the file name.  It will have the form:
-    //   CLI_<program number>_<hash>_cmdbuf.dot
+    cl_uint refCount = getRefCount( queue );
+    if( refCount == 1 )
     {
-        char    numberString[256] = "";
+        m_QueueNumberMap.erase( queue );
 
-        if( config().OmitCommandBufferNumber )
-        {
-            CLI_SPRINTF( numberString, 256, "%08X",
-                (unsigned int)hash );
-        }
-        else
+        cl_context  context = NULL;
+
+        cl_int errorCode = dispatch().clGetCommandQueueInfo(
+            queue,
+            CL_QUEUE_CONTEXT,
+            sizeof(context),
+            &context,
+            NULL );
+        if( errorCode == CL_SUCCESS && context )
         {
-            CLI_SPRINTF( numberString, 256, "%04u_%08X",
-                m_CommandBufferNumber,
-                (unsigned int)hash );
-        }
+            CQueueList& queues = m_ContextQueuesMap[context];
 
-        fileName += "/CLI_";
-        fileName += numberString;
-        fileName += "_cmdbuf.dot";
+            queues.erase(
+                std::find(
+                    queues.begin(),
+                    queues.end(),
+                    queue ) );
+        }
     }
-
-    // Now make directories as appropriate.
-    OS().MakeDumpDirectories( fileName );
-
-    log( "Dumping command buffer to file: " + fileName + "\n" );
-    dumpMemoryToFile(
-        fileName,
-        false,
-        ptr,
-        size );
-
-    m_CommandBufferNumber++;
-
-    // Now that we are done tracing, we can remove the trace info.
-    m_CommandBufferRecordMap.erase( cmdbuf );
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-cl_command_queue CLIntercept::createCommandQueueWithProperties(
-    cl_context context,
-    cl_device_id device,
-    const cl_queue_properties* properties,
-    cl_int* errcode_ret )
+void CLIntercept::addEvent(
+    cl_event event,
+    uint64_t enqueueCounter )
 {
-    cl_command_queue    retVal = NULL;
+    if( event )
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
 
-    // Cache the device info if it's not cached already.
-    cacheDeviceInfo( device );
+        m_EventIdMap[ event ] = enqueueCounter;
+    }
+}
 
-    const SDeviceInfo& deviceInfo = m_DeviceInfoMap[device];
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::checkRemoveEvent(
+    cl_event event )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
 
-    // First, check if this is an OpenCL 2.0 or newer device.  If it is, we can
-    // simply call the clCreateCommandQueueWithProperties function.
-    if( retVal == NULL &&
-        deviceInfo.NumericVersion >= CL_MAKE_VERSION_KHR(2, 0, 0) )
+    cl_uint refCount = getRefCount( event );
+    if( refCount == 1 )
     {
-        retVal = dispatch().clCreateCommandQueueWithProperties(
-            context,
-            device,
-            properties,
-            errcode_ret );
+        m_EventIdMap.erase( event );
     }
+}
 
-    // If this didn't work, try to use the create command queue with properties
-    // extension.
-    if( retVal == NULL &&
-        deviceInfo.Supports_cl_khr_create_command_queue )
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::addBuffer(
+    cl_mem buffer )
+{
+    if( buffer )
     {
-        cl_platform_id  platform = getPlatform(device);
-        if( dispatchX(platform).clCreateCommandQueueWithPropertiesKHR == NULL )
-        {
-            getExtensionFunctionAddress(
-                platform,
-                "clCreateCommandQueueWithPropertiesKHR" );
-        }
+        std::lock_guard<std::mutex> lock(m_Mutex);
 
-        const auto& dispatchX = this->dispatchX(platform);
-        if( dispatchX.clCreateCommandQueueWithPropertiesKHR )
+        cl_int  errorCode = CL_SUCCESS;
+        size_t  size = 0;
+
+        errorCode |= dispatch().clGetMemObjectInfo(
+            buffer,
+            CL_MEM_SIZE,
+            sizeof( size_t ),
+            &size,
+            NULL );
+
+        if( errorCode == CL_SUCCESS )
         {
-            retVal = dispatchX.clCreateCommandQueueWithPropertiesKHR(
-                context,
-                device,
-                properties,
-                errcode_ret );
+            m_MemAllocNumberMap[ buffer ] = m_MemAllocNumber;
+            m_BufferInfoMap[ buffer ] = size;
+            m_MemAllocNumber++;
         }
     }
-
-    return retVal;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::addSubDeviceInfo(
-    const cl_device_id parentDevice,
-    const cl_device_id* devices,
-    cl_uint numSubDevices )
+void CLIntercept::addImage(
+    cl_mem image )
 {
-    std::lock_guard<std::mutex> lock(m_Mutex);
-
-    while( numSubDevices-- )
+    if( image )
     {
-        cl_device_id    device = devices[ numSubDevices ];
-        if( device )
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        cl_int  errorCode = CL_SUCCESS;
+
+        size_t  width = 0;
+        size_t  height = 0;
+        size_t  depth = 0;
+        size_t  arraySize = 0;
+        size_t  elementSize = 0;
+        size_t  rowPitch = 0;
+        size_t  slicePitch = 0;
+        cl_image_format format;
+
+        errorCode |= dispatch().clGetImageInfo(
+            image,
+            CL_IMAGE_WIDTH,
+            sizeof(width),
+            &width,
+            NULL );
+        errorCode |= dispatch().clGetImageInfo(
+            image,
+            CL_IMAGE_HEIGHT,
+            sizeof(height),
+            &height,
+            NULL );
+        errorCode |= dispatch().clGetImageInfo(
+            image,
+            CL_IMAGE_DEPTH,
+            sizeof(depth),
+            &depth,
+            NULL );
+        errorCode |= dispatch().clGetImageInfo(
+            image,
+            CL_IMAGE_ARRAY_SIZE,
+            sizeof(arraySize),
+            &arraySize,
+            NULL );
+        errorCode |= dispatch().clGetImageInfo(
+            image,
+            CL_IMAGE_ELEMENT_SIZE,
+            sizeof(elementSize),
+            &elementSize,
+            NULL );
+        errorCode |= dispatch().clGetImageInfo(
+            image,
+            CL_IMAGE_ROW_PITCH,
+            sizeof(rowPitch),
+            &rowPitch,
+            nullptr );
+        errorCode |= dispatch().clGetImageInfo(
+            image,
+            CL_IMAGE_SLICE_PITCH,
+            sizeof(slicePitch),
+            &slicePitch,
+            nullptr );
+        errorCode |= dispatch().clGetImageInfo(
+            image,
+            CL_IMAGE_FORMAT,
+            sizeof(cl_image_format),
+            &format,
+            nullptr );
+
+        if( errorCode == CL_SUCCESS )
         {
-            SSubDeviceInfo& subDeviceInfo = m_SubDeviceInfoMap[ device ];
+            SImageInfo& imageInfo = m_ImageInfoMap[ image ];
 
-            subDeviceInfo.ParentDevice = parentDevice;
-            subDeviceInfo.SubDeviceIndex = numSubDevices;
+            imageInfo.Region[0] = width;
+            if( height == 0 )
+            {
+                if( arraySize == 0 )
+                {
+                    imageInfo.Region[1] = 1;            // 1D image
+                    imageInfo.ImageType = CL_MEM_OBJECT_IMAGE1D;
+                }
+                else
+                {
+                    imageInfo.Region[1] = arraySize;    // 1D image array
+                    imageInfo.ImageType = CL_MEM_OBJECT_IMAGE1D_ARRAY;
+                }
+            }
+            else
+            {
+                imageInfo.Region[1] = height;           // 2D image, 3D image, or 3D image array
+            }
 
-            // Currently, information about a device is assumed to be
-            // invariant, though for sub-device handles the information
-            // about a device can change if sub-device handles are recycled.
-            // Since this is expected to occur rarely, for now simply log a
-            // warning if this occurs.
-            if( m_DeviceInfoMap.find(device) != m_DeviceInfoMap.end() )
+            if( depth == 0 )
             {
-                logf( "Warning: found a recycled sub-device handle %p!\n",
-                    device );
+                if( arraySize == 0 )
+                {
+                    imageInfo.Region[2] = 1;            // 2D image
+                    imageInfo.ImageType = CL_MEM_OBJECT_IMAGE2D;
+                }
+                else
+                {
+                    imageInfo.Region[2] = arraySize;    // 2D image array
+                    imageInfo.ImageType = CL_MEM_OBJECT_IMAGE2D_ARRAY;
+                }
+            }
+            else
+            {
+                CLI_ASSERT( arraySize == 0 );
+                imageInfo.Region[2] = depth;            // 3D image
+                imageInfo.ImageType = CL_MEM_OBJECT_IMAGE3D;
             }
+
+            imageInfo.ElementSize = elementSize;
+            imageInfo.Format = format;
+            imageInfo.RowPitch = rowPitch;
+            imageInfo.SlicePitch = slicePitch;
+
+            m_MemAllocNumberMap[ image ] = m_MemAllocNumber;
+            m_MemAllocNumber++;
         }
     }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::checkRemoveDeviceInfo(
-    cl_device_id device )
+void CLIntercept::checkRemoveMemObj(
+    cl_mem memobj )
 {
     std::lock_guard<std::mutex> lock(m_Mutex);
 
-    cl_uint refCount = getRefCount( device );
+    cl_uint refCount = getRefCount( memobj );
     if( refCount == 1 )
     {
-        m_SubDeviceInfoMap.erase( device );
+        m_MemAllocNumberMap.erase( memobj );
+        m_BufferInfoMap.erase( memobj );
+        m_ImageInfoMap.erase( memobj );
     }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::addKernelInfo(
-    const cl_kernel kernel,
-    const cl_program program,
-    const std::string& kernelName )
+static inline uint64_t initializeBufferRandomValue(
+    uint64_t key,
+    uint64_t index )
 {
-    std::lock_guard<std::mutex> lock(m_Mutex);
-
-    const SProgramInfo& programInfo = m_ProgramInfoMap[ program ];
-
-    SKernelInfo& kernelInfo = m_KernelInfoMap[ kernel ];
-    std::string demangledName = config().DemangleKernelNames ?
-        demangle(kernelName) :
-        kernelName;
+    // SplitMix64.  Each value only depends on the key and its index, so any
+    // part of a buffer may be generated independently of the other parts.
+    uint64_t    z = key + ( index + 1 ) * 0x9E3779B97F4A7C15ULL;
+    z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ULL;
+    z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBULL;
+    return z ^ ( z >> 31 );
+}
 
-    kernelInfo.KernelName = demangledName;
+///////////////////////////////////////////////////////////////////////////////
+//
+static void initializeBufferChunk(
+    char* dst,
+    size_t offset,
+    size_t size,
+    cl_uint pattern,
+    uint64_t key )
+{
+    // Note: offset is always a multiple of sizeof(uint64_t), so values are
+    // the same regardless of how the buffer is split into chunks.
+    switch( pattern )
+    {
+    case 1:
+        memset( dst + offset, 0xFF, size );
+        break;
+    case 2:
+    case 3:
+        {
+            auto    valueAt = [=]( uint64_t index ) -> uint64_t {
+                if( pattern == 2 )
+                {
+                    uint32_t    values[2] = {
+                        (uint32_t)( index * 2 ),
+                        (uint32_t)( index * 2 + 1 ) };
+                    uint64_t    value = 0;
+                    memcpy( &value, values, sizeof(value) );
+                    return value;
+                }
+                return initializeBufferRandomValue( key, index );
+            };
 
-    kernelInfo.ProgramHash = programInfo.ProgramHash;
-    kernelInfo.OptionsHash = programInfo.OptionsHash;
+            uint64_t    index = offset / sizeof(uint64_t);
+            size_t      count = size / sizeof(uint64_t);
 
-    kernelInfo.ProgramNumber = programInfo.ProgramNumber;
-    kernelInfo.CompileCount = programInfo.CompileCount - 1;
+            char*   ptr = dst + offset;
+            for( size_t i = 0; i < count; i++, index++ )
+            {
+                uint64_t    value = valueAt( index );
+                memcpy( ptr, &value, sizeof(value) );
+                ptr += sizeof(value);
+            }
 
-    addShortKernelName( demangledName );
+            size_t  remainder = size % sizeof(uint64_t);
+            if( remainder )
+            {
+                uint64_t    value = valueAt( index );
+                memcpy( ptr, &value, remainder );
+            }
+        }
+        break;
+    default:
+        memset( dst + offset, 0, size );
+        break;
+    }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::addKernelInfo(
-    const cl_kernel* kernels,
-    const cl_program program,
-    cl_uint numKernels )
+void* CLIntercept::allocateInitializedBufferContents(
+    size_t size )
 {
-    std::lock_guard<std::mutex> lock(m_Mutex);
+    const cl_uint   pattern = config().InitializeBuffersPattern;
 
-    const SProgramInfo& programInfo = m_ProgramInfoMap[ program ];
+    uint64_t    key = initializeBufferRandomValue(
+        config().InitializeBuffersSeed,
+        m_InitializeBuffersCounter.fetch_add(1, std::memory_order_relaxed) );
 
-    while( numKernels-- )
+    if( pattern == 0 || pattern > 3 )
     {
-        cl_kernel   kernel = kernels[ numKernels ];
-        char*       kernelName = NULL;
-        size_t      kernelNameSize = 0;
-        cl_int      errorCode = CL_SUCCESS;
-
-        errorCode = dispatch().clGetKernelInfo(
-            kernel,
-            CL_KERNEL_FUNCTION_NAME,
-            0,
-            NULL,
-            &kernelNameSize );
-        if( errorCode == CL_SUCCESS )
-        {
-            kernelName = new char[ kernelNameSize + 1 ];
-            if( kernelName )
-            {
-                errorCode = dispatch().clGetKernelInfo(
-                    kernel,
-                    CL_KERNEL_FUNCTION_NAME,
-                    kernelNameSize,
-                    kernelName,
-                    NULL );
-                if( errorCode == CL_SUCCESS )
-                {
-                    kernelName[ kernelNameSize ] = 0;
+        // calloc typically returns zero pages directly from the OS for large
+        // allocations, which avoids touching the memory here entirely.
+        return calloc( size, 1 );
+    }
 
-                    SKernelInfo& kernelInfo = m_KernelInfoMap[ kernel ];
-                    std::string demangledName = config().DemangleKernelNames ?
-                        demangle(kernelName) :
-                        kernelName;
+    char*   dst = (char*)malloc( size );
+    if( dst == NULL )
+    {
+        return NULL;
+    }
 
-                    kernelInfo.KernelName = demangledName;
+    const size_t    threshold =
+        (size_t)config().InitializeBuffersThreadThresholdMB * 1024 * 1024;
+    if( threshold != 0 && size >= threshold )
+    {
+        const size_t    chunkSize = 1024 * 1024;
+        const size_t    numChunks = ( size + chunkSize - 1 ) / chunkSize;
 
-                    kernelInfo.ProgramHash = programInfo.ProgramHash;
-                    kernelInfo.OptionsHash = programInfo.OptionsHash;
+        m_ThreadPool.start();
+        m_ThreadPool.parallelFor(
+            numChunks,
+            [=]( size_t chunk ) {
+                size_t  offset = chunk * chunkSize;
+                initializeBufferChunk(
+                    dst,
+                    offset,
+                    std::min( chunkSize, size - offset ),
+                    pattern,
+                    key );
+            } );
+    }
+    else
+    {
+        initializeBufferChunk( dst, 0, size, pattern, key );
+    }
 
-                    kernelInfo.ProgramNumber = programInfo.ProgramNumber;
-                    kernelInfo.CompileCount = programInfo.CompileCount - 1;
+    return dst;
+}
 
-                    addShortKernelName( demangledName );
-                }
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::addSVMAllocation(
+    void* svmPtr,
+    size_t size )
+{
+    if( svmPtr )
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
 
-                delete [] kernelName;
-            }
-        }
+        m_MemAllocNumberMap[ svmPtr ] = m_MemAllocNumber;
+        m_SVMAllocInfoMap.insert( svmPtr, size );
+        m_MemAllocNumber++;
     }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::addKernelInfo(
-    const cl_kernel kernel,
-    const cl_kernel source_kernel )
+void CLIntercept::removeSVMAllocation(
+    void* svmPtr )
 {
     std::lock_guard<std::mutex> lock(m_Mutex);
 
-    m_KernelInfoMap[ kernel ] = m_KernelInfoMap[ source_kernel ];
+    m_MemAllocNumberMap.erase( svmPtr );
+    m_SVMAllocInfoMap.erase( svmPtr );
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::checkRemoveKernelInfo( cl_kernel kernel )
+void CLIntercept::addUSMAllocation(
+    void* usmPtr,
+    size_t size )
 {
-    std::lock_guard<std::mutex> lock(m_Mutex);
-
-    cl_uint refCount = getRefCount( kernel );
-    if( refCount == 1 )
+    if( usmPtr )
     {
-#if 0
-        // We shouldn't remove the kernel name from the local kernel name map
-        // here since the mapping may be included in the device performance
-        // time report.
-        m_LongKernelNameMap.erase( m_KernelInfoMap[ kernel ].KernelName );
-#endif
+        std::lock_guard<std::mutex> lock(m_Mutex);
 
-        m_KernelInfoMap.erase( kernel );
+        m_MemAllocNumberMap[ usmPtr ] = m_MemAllocNumber;
+        m_USMAllocInfoMap.insert( usmPtr, size );
+        m_MemAllocNumber++;
     }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::addAcceleratorInfo(
-    cl_accelerator_intel accelerator,
-    cl_context context )
+void CLIntercept::removeUSMAllocation(
+    void* usmPtr )
 {
-    if( accelerator )
-    {
-        std::lock_guard<std::mutex> lock(m_Mutex);
+    std::lock_guard<std::mutex> lock(m_Mutex);
 
-        m_AcceleratorInfoMap[accelerator] = getPlatform(context);
-    }
+    m_MemAllocNumberMap.erase( usmPtr );
+    m_USMAllocInfoMap.erase( usmPtr );
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::checkRemoveAcceleratorInfo(
-    cl_accelerator_intel accelerator )
+void CLIntercept::setKernelArg(
+    cl_kernel kernel,
+    cl_uint arg_index,
+    const void* arg_value,
+    size_t arg_size )
 {
     std::lock_guard<std::mutex> lock(m_Mutex);
 
-    CAcceleratorInfoMap::iterator iter = m_AcceleratorInfoMap.find( accelerator );
-    if( iter != m_AcceleratorInfoMap.end() )
-    {
-        cl_platform_id  platform = iter->second;
-        if( dispatchX(platform).clGetAcceleratorInfoINTEL == NULL )
-        {
-            getExtensionFunctionAddress(
-                platform,
-                "clGetAcceleratorInfoINTEL" );
-        }
+    SKernelArgInfo& argInfo = getKernelArgInfo( kernel, arg_index );
+    argInfo.reset();
 
-        const auto& dispatchX = this->dispatchX(platform);
-        if( dispatchX.clGetAcceleratorInfoINTEL )
+    if( arg_value != nullptr )
+    {
+        if( arg_size == sizeof(cl_mem) )
         {
-            cl_uint refCount = 0;
-            cl_int  errorCode = CL_SUCCESS;
-
-            errorCode = dispatchX.clGetAcceleratorInfoINTEL(
-                accelerator,
-                CL_ACCELERATOR_REFERENCE_COUNT_INTEL,
-                sizeof( refCount ),
-                &refCount,
-                NULL );
-            if( errorCode == CL_SUCCESS && refCount == 1 )
+            cl_mem  mem = ((cl_mem*)arg_value)[0];
+            if( m_MemAllocNumberMap.find(mem) != m_MemAllocNumberMap.end() )
             {
-                m_AcceleratorInfoMap.erase( iter );
+                argInfo.Allocation = mem;
             }
         }
+
+        argInfo.HasSampler = checkGetSamplerString(
+            arg_size,
+            arg_value,
+            argInfo.Sampler );
+
+        argInfo.setData( arg_value, arg_size );
+    }
+    else
+    {
+        argInfo.IsLocal = true;
+        argInfo.LocalSize = arg_size;
     }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::addSemaphoreInfo(
-    cl_semaphore_khr semaphore,
-    cl_context context )
+void CLIntercept::setKernelArgSVMPointer(
+    cl_kernel kernel,
+    cl_uint arg_index,
+    const void* arg )
 {
-    if( semaphore )
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    if( m_SVMAllocInfoMap.empty() )
     {
-        std::lock_guard<std::mutex> lock(m_Mutex);
+        return;
+    }
 
-        m_SemaphoreInfoMap[semaphore] = getPlatform(context);
+    // Unlike clSetKernelArg(), which must pass a cl_mem, clSetKernelArgSVMPointer
+    // can pass a pointer to the base of a SVM allocation or anywhere inside of
+    // an SVM allocation.  As a result, we need to search the SVM map to find the
+    // base address and size of the SVM allocation.
+
+    const CSVMAllocInfoMap::SEntry* entry =
+        m_SVMAllocInfoMap.findContaining( arg );
+
+    SKernelArgInfo& argInfo = getKernelArgInfo( kernel, arg_index );
+    argInfo.reset();
+
+    if( entry )
+    {
+        argInfo.Allocation = entry->Base;
+
+        // Currently, only pointers to the start of an SVM allocation are
+        // supported for capture and replay.
+        if( arg == entry->Base )
+        {
+            argInfo.setData( &arg, sizeof(void*) );
+        }
     }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::checkRemoveSemaphoreInfo(
-    cl_semaphore_khr semaphore )
+void CLIntercept::setKernelArgUSMPointer(
+    cl_kernel kernel,
+    cl_uint arg_index,
+    const void* arg )
 {
     std::lock_guard<std::mutex> lock(m_Mutex);
 
-    CSemaphoreInfoMap::iterator iter = m_SemaphoreInfoMap.find( semaphore );
-    if( iter != m_SemaphoreInfoMap.end() )
+    if( m_USMAllocInfoMap.empty() )
     {
-        cl_platform_id  platform = iter->second;
-        if( dispatchX(platform).clGetSemaphoreInfoKHR == NULL )
-        {
-            getExtensionFunctionAddress(
-                platform,
-                "clGetSemaphoreInfoKHR" );
-        }
+        return;
+    }
 
-        const auto& dispatchX = this->dispatchX(platform);
-        if( dispatchX.clGetSemaphoreInfoKHR )
+    const CUSMAllocInfoMap::SEntry* entry =
+        m_USMAllocInfoMap.findContaining( arg );
+
+    SKernelArgInfo& argInfo = getKernelArgInfo( kernel, arg_index );
+    argInfo.reset();
+
+    if( entry )
+    {
+        argInfo.Allocation = entry->Base;
+
+        // Currently, only pointers to the start of an USM allocation are
+        // supported for capture and replay.
+        if( arg == entry->Base )
         {
-            cl_uint refCount = 0;
-            cl_int  errorCode = CL_SUCCESS;
-            errorCode = dispatchX.clGetSemaphoreInfoKHR(
-                semaphore,
-                CL_SEMAPHORE_REFERENCE_COUNT_KHR,
-                sizeof( refCount ),
-                &refCount,
-                NULL );
-            if( errorCode == CL_SUCCESS && refCount == 1 )
-            {
-                m_SemaphoreInfoMap.erase( iter );
-            }
+            argInfo.setData( &arg, sizeof(void*) );
         }
     }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::addCommandBufferInfo(
-    cl_command_buffer_khr cmdbuf,
-    cl_command_queue queue )
+void CLIntercept::setKernelExecInfo(
+    cl_kernel kernel,
+    cl_kernel_exec_info param_name,
+    size_t param_value_size,
+    const void* param_value )
 {
-    if( cmdbuf )
-    {
-        std::lock_guard<std::mutex> lock(m_Mutex);
+    std::lock_guard<std::mutex> lock(m_Mutex);
 
-        m_CommandBufferInfoMap[cmdbuf] = getPlatform(queue);
+    CKernelInfoMap::iterator iter = m_KernelInfoMap.find( kernel );
+    if( iter != m_KernelInfoMap.end() )
+    {
+        const uint8_t*  pValue = (const uint8_t*)param_value;
+        iter->second.ExecInfo[ param_name ].assign(
+            pValue,
+            pValue + ( pValue ? param_value_size : 0 ) );
     }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::checkRemoveCommandBufferInfo(
-    cl_command_buffer_khr cmdbuf)
+void CLIntercept::dumpCaptureReplayKernelSource(
+    const std::string& dumpDirectory,
+    cl_kernel kernel )
 {
-    std::lock_guard<std::mutex> lock(m_Mutex);
+    cl_int errorCode = CL_SUCCESS;
 
-    CCommandBufferInfoMap::iterator iter = m_CommandBufferInfoMap.find( cmdbuf );
-    if( iter != m_CommandBufferInfoMap.end() )
+    cl_program program = nullptr;
+    dispatch().clGetKernelInfo(kernel, CL_KERNEL_PROGRAM, sizeof(cl_program), &program, nullptr);
+
+    // Kernels created from a program built from the program binary cache
+    // get the source and IL from the application's program
+    cl_program sourceProgram = findBinaryCacheKernelProgram(kernel, program);
+
+    // First, try to get and dump the program source
+
+    size_t sourceSize = 0;
+    dispatch().clGetProgramInfo(sourceProgram, CL_PROGRAM_SOURCE, 0, nullptr, &sourceSize);
+    if( sourceSize != 0 )
     {
-        cl_platform_id  platform = iter->second;
-        if( dispatchX(platform).clGetCommandBufferInfoKHR == NULL )
+        std::vector<char> source(sourceSize, ' ');
+        errorCode = dispatch().clGetProgramInfo(sourceProgram, CL_PROGRAM_SOURCE, sourceSize, source.data(), nullptr);
+        if( errorCode == CL_SUCCESS )
         {
-            getExtensionFunctionAddress(
-                platform,
-                "clGetCommandBufferInfoKHR" );
+            std::ofstream output(dumpDirectory + "kernel.cl", std::ios::out | std::ios::binary);
+            output.write(source.data(), sourceSize);
         }
+    }
 
-        const auto& dispatchX = this->dispatchX(platform);
-        if( dispatchX.clGetCommandBufferInfoKHR )
+    // Next, try to get and dump the program IL (SPIR-V)
+
+    size_t ilSize = 0;
+    dispatch().clGetProgramInfo(sourceProgram, CL_PROGRAM_IL, 0, nullptr, &ilSize);
+    if( ilSize != 0 )
+    {
+        std::vector<char> il(ilSize, ' ');
+        errorCode = dispatch().clGetProgramInfo(sourceProgram, CL_PROGRAM_IL, ilSize, il.data(), nullptr);
+        if( errorCode == CL_SUCCESS )
         {
-            cl_uint refCount = 0;
-            cl_int  errorCode = CL_SUCCESS;
-            errorCode = dispatchX.clGetCommandBufferInfoKHR(
-                cmdbuf,
-                CL_COMMAND_BUFFER_REFERENCE_COUNT_KHR,
-                sizeof( refCount ),
-                &refCount,
-                NULL );
-            if( errorCode == CL_SUCCESS && refCount == 1 )
-            {
-                m_CommandBufferInfoMap.erase( iter );
-                m_CommandBufferRecordMap.erase( cmdbuf );
+            std::ofstream output(dumpDirectory + "kernel.spv", std::ios::out | std::ios::binary);
+            output.write(il.data(), ilSize);
+        }
+    }
 
-                CCommandBufferMutableCommandsMap::iterator cmditer =
-                    m_CommandBufferMutableCommandsMap.find( cmdbuf );
-                if( cmditer != m_CommandBufferMutableCommandsMap.end() )
-                {
-                    CMutableCommandList&    cmdList = cmditer->second;
-                    for( auto cmd : cmdList )
-                    {
-                        m_MutableCommandInfoMap.erase(cmd);
-                    }
+    // In all cases,  get and dump program binaries
+    {
+        cl_uint num_devices = 0;
+        dispatch().clGetProgramInfo(program, CL_PROGRAM_NUM_DEVICES, sizeof(cl_uint), &num_devices, nullptr);
+
+        std::vector<cl_device_id> devices(num_devices);
+        dispatch().clGetProgramInfo(program, CL_PROGRAM_DEVICES, num_devices * sizeof(cl_device_id), devices.data(), 0);
+
+        std::vector<size_t> sizes(num_devices);
+        dispatch().clGetProgramInfo(program, CL_PROGRAM_BINARY_SIZES, num_devices * sizeof(size_t), sizes.data(), nullptr);
+
+        std::vector<std::vector<unsigned char>> binaries;
+        std::vector<unsigned char*> binariesData;
+        binaries.reserve(num_devices);
+        binariesData.reserve(num_devices);
+        for( size_t device = 0; device != num_devices; ++device )
+        {
+            binaries.emplace_back(sizes[device]);
+            binariesData.emplace_back(binaries[device].data());
+        }
 
-                    m_CommandBufferMutableCommandsMap.erase(cmditer);
-                }
+        errorCode = dispatch().clGetProgramInfo(program, CL_PROGRAM_BINARIES, num_devices * sizeof(unsigned char*), binariesData.data(), nullptr);
+        if( errorCode == CL_SUCCESS )
+        {
+            for (size_t device = 0; device != num_devices; ++device)
+            {
+                std::ofstream output(dumpDirectory + "DeviceBinary" + std::to_string(device) + ".bin", std::ios::out | std::ios::binary);
+                output.write(reinterpret_cast<char const*>(binaries[device].data()), binaries[device].size());
             }
         }
     }
@@ -7261,786 +9654,1063 @@ void CLIntercept::checkRemoveCommandBufferInfo(
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::addMutableCommandInfo(
-    cl_mutable_command_khr cmd,
-    cl_command_buffer_khr cmdbuf,
-    cl_uint dim )
+void CLIntercept::dumpCaptureReplayKernelInfo(
+    const std::string& dumpDirectory,
+    cl_kernel kernel,
+    size_t work_dim,
+    const size_t* gws_offset,
+    const size_t* gws,
+    const size_t* lws )
 {
-    if( cmd && cmdbuf )
-    {
-        std::lock_guard<std::mutex> lock(m_Mutex);
-
-        SMutableCommandInfo& info = m_MutableCommandInfoMap[cmd];
-
-        info.Platform = getPlatform(cmdbuf);
-        info.WorkDim = dim;
+    std::ofstream output{dumpDirectory + "worksizes.txt"};
 
-        m_CommandBufferMutableCommandsMap[cmdbuf].push_back(cmd);
+    // Print the values of the worksizes and offsets on a line in the order:
+    // gws
+    // lws
+    // gws_offset
+    for (unsigned idx = 0; idx != work_dim; ++idx)
+    {
+        output << (!gws        ? 0 : gws[idx]) << ' ';
     }
-}
+    output << '\n';
 
-///////////////////////////////////////////////////////////////////////////////
-//
-void CLIntercept::addSamplerString(
-    cl_sampler sampler,
-    const std::string& str )
-{
-    if( sampler )
+    for (unsigned idx = 0; idx != work_dim; ++idx)
     {
-        std::lock_guard<std::mutex> lock(m_Mutex);
-        m_SamplerDataMap[sampler] = str;
+        output << (!lws        ? 0 : lws[idx]) << ' ';
     }
-}
-
-///////////////////////////////////////////////////////////////////////////////
-//
-void CLIntercept::checkRemoveSamplerString(
-    cl_sampler sampler )
-{
-    std::lock_guard<std::mutex> lock(m_Mutex);
+    output << '\n';
 
-    cl_uint refCount = getRefCount( sampler );
-    if( refCount == 1 )
+    for (unsigned idx = 0; idx != work_dim; ++idx)
     {
-        m_SamplerDataMap.erase( sampler );
+        output << (!gws_offset ? 0 : gws_offset[idx]) << ' ';
     }
-}
+    output << '\n';
 
-///////////////////////////////////////////////////////////////////////////////
-//
-bool CLIntercept::checkGetSamplerString(
-    size_t size,
-    const void *arg_value,
-    std::string& str ) const
-{
-    bool found = false;
+    cl_program program = nullptr;
+    dispatch().clGetKernelInfo(kernel, CL_KERNEL_PROGRAM, sizeof(cl_program), &program, nullptr);
+
+    cl_context context = nullptr;
+    dispatch().clGetProgramInfo(program, CL_PROGRAM_CONTEXT, sizeof(cl_context), &context, nullptr);
+
+    // Note: this currently does not work for multi-device contexts.
+    cl_device_id device = nullptr;
+    dispatch().clGetContextInfo(context, CL_CONTEXT_DEVICES, sizeof(cl_device_id), &device, nullptr);
 
-    if( ( arg_value != NULL ) && ( size == sizeof( cl_sampler ) ) )
     {
-        const cl_sampler sampler = *(const cl_sampler *)arg_value;
+        std::ofstream outputBuildOptions{dumpDirectory + "buildOptions.txt"};
 
-        CSamplerDataMap::const_iterator iter = m_SamplerDataMap.find( sampler );
-        if( iter != m_SamplerDataMap.end() )
+        size_t buildOptionsSize = 0;
+        dispatch().clGetProgramBuildInfo(program, device, CL_PROGRAM_BUILD_OPTIONS, 0, nullptr, &buildOptionsSize);
+
+        std::string buildOptions(buildOptionsSize, ' ');
+        int error = dispatch().clGetProgramBuildInfo(program, device, CL_PROGRAM_BUILD_OPTIONS, buildOptionsSize, &buildOptions[0], nullptr);
+        if( error == CL_SUCCESS )
         {
-            str = iter->second;
-            found = true;
+            buildOptions.pop_back();
+            outputBuildOptions << buildOptions << '\n';
         }
     }
 
-    return found;
-}
+    std::string kernelName = getShortKernelName(kernel);
+    std::ofstream outputKernelName{dumpDirectory + "kernelName.txt"};
+    outputKernelName << kernelName;
 
-///////////////////////////////////////////////////////////////////////////////
-//
-void CLIntercept::addQueue(
-    cl_context context,
-    cl_command_queue queue )
-{
-    if( queue )
-    {
-        std::lock_guard<std::mutex> lock(m_Mutex);
+    cl_uint numArgs = 0;
+    dispatch().clGetKernelInfo(kernel, CL_KERNEL_NUM_ARGS, sizeof(cl_uint), &numArgs, nullptr);
 
-        m_QueueNumberMap[ queue ] = m_QueueNumber + 1;  // should be nonzero
-        m_QueueNumber++;
+    if( numArgs )
+    {
+        std::ofstream outputArgTypes{dumpDirectory + "ArgumentDataTypes.txt"};
+        for( cl_uint idx = 0; idx != numArgs; ++idx )
+        {
+            size_t argTypeNameSize = 0;
+            dispatch().clGetKernelArgInfo(kernel, idx, CL_KERNEL_ARG_TYPE_NAME, 0, nullptr, &argTypeNameSize);
 
-        m_ContextQueuesMap[context].push_back(queue);
+            std::string argTypeName(argTypeNameSize, ' ');
+            int error = dispatch().clGetKernelArgInfo(kernel, idx, CL_KERNEL_ARG_TYPE_NAME, argTypeNameSize, &argTypeName[0], nullptr);
+            if( error == CL_SUCCESS )
+            {
+                argTypeName.pop_back();
+                outputArgTypes << argTypeName << '\n';
+            }
+        }
     }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::checkRemoveQueue(
-    cl_command_queue queue )
+void CLIntercept::dumpCaptureReplayKernelArguments(
+    const std::string& dumpDirectory,
+    cl_kernel kernel )
 {
-    std::lock_guard<std::mutex> lock(m_Mutex);
-
-    cl_uint refCount = getRefCount( queue );
-    if( refCount == 1 )
+    const CKernelArgInfoVector& args = m_KernelInfoMap[ kernel ].Args;
+    for( cl_uint index = 0; index < args.size(); index++ )
     {
-        m_QueueNumberMap.erase( queue );
-
-        cl_context  context = NULL;
+        const SKernelArgInfo& argInfo = args[ index ];
 
-        cl_int errorCode = dispatch().clGetCommandQueueInfo(
-            queue,
-            CL_QUEUE_CONTEXT,
-            sizeof(context),
-            &context,
-            NULL );
-        if( errorCode == CL_SUCCESS && context )
+        if( argInfo.HasData )
         {
-            CQueueList& queues = m_ContextQueuesMap[context];
+            std::string fileName{dumpDirectory + "Argument" + std::to_string(index) + ".bin"};
+            std::ofstream out{fileName, std::ios::out | std::ios::binary};
+            out.write(reinterpret_cast<char const*>(argInfo.getData()), argInfo.DataSize);
+        }
 
-            queues.erase(
-                std::find(
-                    queues.begin(),
-                    queues.end(),
-                    queue ) );
+        if( argInfo.IsLocal )
+        {
+            std::string fileName{dumpDirectory + "Local" + std::to_string(index) + ".txt"};
+            std::ofstream out{fileName};
+            out << std::to_string(argInfo.LocalSize);
         }
-    }
-}
 
-///////////////////////////////////////////////////////////////////////////////
-//
-void CLIntercept::addEvent(
-    cl_event event,
-    uint64_t enqueueCounter )
-{
-    if( event )
-    {
-        std::lock_guard<std::mutex> lock(m_Mutex);
+        const auto value = (cl_mem)argInfo.Allocation;
+        if( value && m_ImageInfoMap.find( value ) != m_ImageInfoMap.end() )
+        {
+            const SImageInfo&   info = m_ImageInfoMap[ value ];
+            std::string fileName{dumpDirectory + "Image_MetaData_" + std::to_string(index) + ".txt"};
+            std::ofstream out{fileName};
+            out << info.Region[0] << '\n'
+                << info.Region[1] << '\n'
+                << info.Region[2] << '\n'
+                << info.ElementSize << '\n'
+                << info.RowPitch << '\n'
+                << info.SlicePitch << '\n'
+                << info.Format.image_channel_data_type << '\n'
+                << info.Format.image_channel_order << '\n'
+                << static_cast<int>(info.ImageType);
+        }
 
-        m_EventIdMap[ event ] = enqueueCounter;
+        if( argInfo.HasSampler )
+        {
+            std::string fileName{dumpDirectory + "Sampler" + std::to_string(index) + ".txt"};
+            std::ofstream out{fileName};
+            out << argInfo.Sampler;
+        }
     }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::checkRemoveEvent(
-    cl_event event )
+void CLIntercept::dumpBuffersForKernel(
+    const std::string& name,
+    const bool forCaptureReplay,
+    const bool forInspection,
+    const uint64_t enqueueCounter,
+    cl_kernel kernel,
+    cl_command_queue command_queue )
 {
     std::lock_guard<std::mutex> lock(m_Mutex);
 
-    cl_uint refCount = getRefCount( event );
-    if( refCount == 1 )
-    {
-        m_EventIdMap.erase( event );
-    }
-}
+    cl_platform_id  platform = getPlatform(kernel);
 
-///////////////////////////////////////////////////////////////////////////////
-//
-void CLIntercept::addBuffer(
-    cl_mem buffer )
-{
-    if( buffer )
-    {
-        std::lock_guard<std::mutex> lock(m_Mutex);
+    std::vector<char>   transferBuf;
+    std::string captureReplayPrefix;
+    std::string inspectionPrefix;
 
-        cl_int  errorCode = CL_SUCCESS;
-        size_t  size = 0;
+    // When capture and replay buffers are deduplicated, the buffer contents
+    // are written to the blob store, and the capture only records which blob
+    // holds the contents of each dump file.
+    const bool  deduplicate =
+        forCaptureReplay && config().CaptureReplayDeduplicateBuffers;
+    std::string blobManifest;
 
-        errorCode |= dispatch().clGetMemObjectInfo(
-            buffer,
-            CL_MEM_SIZE,
-            sizeof( size_t ),
-            &size,
-            NULL );
+    // Call clFinish on the command queue.
+    // This is needed to ensure that all previous commands have finished
+    // executing, especially for out-of-order queues.
+    dispatch().clFinish( command_queue );
 
-        if( errorCode == CL_SUCCESS )
-        {
-            m_MemAllocNumberMap[ buffer ] = m_MemAllocNumber;
-            m_BufferInfoMap[ buffer ] = size;
-            m_MemAllocNumber++;
-        }
+    // Get the dump directory names and make directories.
+
+    if( forCaptureReplay )
+    {
+        OS().GetDumpDirectoryName( sc_DumpDirectoryName, captureReplayPrefix );
+        captureReplayPrefix += "/Replay/Enqueue_";
+        captureReplayPrefix += std::to_string(enqueueCounter);
+        captureReplayPrefix += "_";
+        captureReplayPrefix += getShortKernelName(kernel);
+        captureReplayPrefix += "/";
+        captureReplayPrefix += name;
+        captureReplayPrefix += "/";
+
+        OS().MakeDumpDirectories( captureReplayPrefix );
+    }
+
+    if( forInspection )
+    {
+        OS().GetDumpDirectoryName( sc_DumpDirectoryName, inspectionPrefix );
+        inspectionPrefix += "/memDump";
+        inspectionPrefix += name;
+        inspectionPrefix += "Enqueue/";
+
+        OS().MakeDumpDirectories( inspectionPrefix );
     }
-}
 
-///////////////////////////////////////////////////////////////////////////////
-//
-void CLIntercept::addImage(
-    cl_mem image )
-{
-    if( image )
+    const CKernelArgInfoVector& args = m_KernelInfoMap[ kernel ].Args;
+    for( cl_uint arg_index = 0; arg_index < args.size(); arg_index++ )
     {
-        std::lock_guard<std::mutex> lock(m_Mutex);
-
-        cl_int  errorCode = CL_SUCCESS;
+        CLI_C_ASSERT( sizeof(void*) == sizeof(cl_mem) );
 
-        size_t  width = 0;
-        size_t  height = 0;
-        size_t  depth = 0;
-        size_t  arraySize = 0;
-        size_t  elementSize = 0;
-        size_t  rowPitch = 0;
-        size_t  slicePitch = 0;
-        cl_image_format format;
+        void*   allocation = (void*)args[ arg_index ].Allocation;
+        cl_mem  memobj = (cl_mem)allocation;
 
-        errorCode |= dispatch().clGetImageInfo(
-            image,
-            CL_IMAGE_WIDTH,
-            sizeof(width),
-            &width,
-            NULL );
-        errorCode |= dispatch().clGetImageInfo(
-            image,
-            CL_IMAGE_HEIGHT,
-            sizeof(height),
-            &height,
-            NULL );
-        errorCode |= dispatch().clGetImageInfo(
-            image,
-            CL_IMAGE_DEPTH,
-            sizeof(depth),
-            &depth,
-            NULL );
-        errorCode |= dispatch().clGetImageInfo(
-            image,
-            CL_IMAGE_ARRAY_SIZE,
-            sizeof(arraySize),
-            &arraySize,
-            NULL );
-        errorCode |= dispatch().clGetImageInfo(
-            image,
-            CL_IMAGE_ELEMENT_SIZE,
-            sizeof(elementSize),
-            &elementSize,
-            NULL );
-        errorCode |= dispatch().clGetImageInfo(
-            image,
-            CL_IMAGE_ROW_PITCH,
-            sizeof(rowPitch),
-            &rowPitch,
-            nullptr );
-        errorCode |= dispatch().clGetImageInfo(
-            image,
-            CL_IMAGE_SLICE_PITCH,
-            sizeof(slicePitch),
-            &slicePitch,
-            nullptr );
-        errorCode |= dispatch().clGetImageInfo(
-            image,
-            CL_IMAGE_FORMAT,
-            sizeof(cl_image_format),
-            &format,
-            nullptr );
+        const CUSMAllocInfoMap::SEntry* usmEntry =
+            m_USMAllocInfoMap.findBase( allocation );
+        const CSVMAllocInfoMap::SEntry* svmEntry =
+            m_SVMAllocInfoMap.findBase( allocation );
 
-        if( errorCode == CL_SUCCESS )
+        if( usmEntry || svmEntry ||
+            ( m_BufferInfoMap.find( memobj ) != m_BufferInfoMap.end() ) )
         {
-            SImageInfo& imageInfo = m_ImageInfoMap[ image ];
+            unsigned int        number = m_MemAllocNumberMap[ memobj ];
 
-            imageInfo.Region[0] = width;
-            if( height == 0 )
+            std::string fileName;
+            char    tmpStr[ MAX_PATH ];
+
+            // Add the enqueue count to file name
             {
-                if( arraySize == 0 )
-                {
-                    imageInfo.Region[1] = 1;            // 1D image
-                    imageInfo.ImageType = CL_MEM_OBJECT_IMAGE1D;
-                }
-                else
-                {
-                    imageInfo.Region[1] = arraySize;    // 1D image array
-                    imageInfo.ImageType = CL_MEM_OBJECT_IMAGE1D_ARRAY;
-                }
+                CLI_SPRINTF( tmpStr, MAX_PATH, "%04u",
+                    (unsigned int)enqueueCounter );
+
+                fileName += "Enqueue_";
+                fileName += tmpStr;
             }
-            else
+
+            // Add the kernel name to the file name
             {
-                imageInfo.Region[1] = height;           // 2D image, 3D image, or 3D image array
+                fileName += "_Kernel_";
+                fileName += getShortKernelName(kernel);
             }
 
-            if( depth == 0 )
+            // Add the arg number to the file name
             {
-                if( arraySize == 0 )
+                CLI_SPRINTF( tmpStr, MAX_PATH, "%u", arg_index );
+
+                fileName += "_Arg_";
+                fileName += tmpStr;
+            }
+
+            // Add the buffer number to the file name
+            {
+                CLI_SPRINTF( tmpStr, MAX_PATH, "%04u", number );
+
+                fileName += "_Buffer_";
+                fileName += tmpStr;
+            }
+
+            // Add extension to file name
+            {
+                fileName += ".bin";
+            }
+
+            // Dump the buffer contents to the file.
+            if( usmEntry )
+            {
+                size_t  size = usmEntry->Size;
+
+                if( dispatchX(platform).clEnqueueMemcpyINTEL == NULL )
                 {
-                    imageInfo.Region[2] = 1;            // 2D image
-                    imageInfo.ImageType = CL_MEM_OBJECT_IMAGE2D;
+                    getExtensionFunctionAddress(
+                        platform,
+                        "clEnqueueMemcpyINTEL" );
                 }
-                else
+
+                const auto& dispatchX = this->dispatchX(platform);
+                if( dispatchX.clEnqueueMemcpyINTEL )
                 {
-                    imageInfo.Region[2] = arraySize;    // 2D image array
-                    imageInfo.ImageType = CL_MEM_OBJECT_IMAGE2D_ARRAY;
+                    const std::string captureReplayFileName =
+                        forCaptureReplay && !deduplicate ?
+                            captureReplayPrefix + fileName : "";
+                    const std::string inspectionFileName =
+                        forInspection ? inspectionPrefix + fileName : "";
+
+                    std::string mappedFileName;
+                    void*   dst = beginDumpMemoryToFiles(
+                        captureReplayFileName,
+                        inspectionFileName,
+                        config().DumpBufferHashes,
+                        size,
+                        transferBuf,
+                        mappedFileName );
+
+                    cl_int  error = dispatchX.clEnqueueMemcpyINTEL(
+                        command_queue,
+                        CL_TRUE,
+                        dst,
+                        allocation,
+                        size,
+                        0,
+                        NULL,
+                        NULL );
+
+                    if( deduplicate && error == CL_SUCCESS )
+                    {
+                        blobManifest += fileName + " " +
+                            dumpMemoryToBlob( dst, size ) + "\n";
+                    }
+
+                    endDumpMemoryToFiles(
+                        captureReplayFileName,
+                        inspectionFileName,
+                        config().DumpBufferHashes,
+                        mappedFileName,
+                        error == CL_SUCCESS,
+                        dst,
+                        size );
                 }
             }
-            else
+            else if( svmEntry )
             {
-                CLI_ASSERT( arraySize == 0 );
-                imageInfo.Region[2] = depth;            // 3D image
-                imageInfo.ImageType = CL_MEM_OBJECT_IMAGE3D;
-            }
+                size_t  size = svmEntry->Size;
 
-            imageInfo.ElementSize = elementSize;
-            imageInfo.Format = format;
-            imageInfo.RowPitch = rowPitch;
-            imageInfo.SlicePitch = slicePitch;
+                cl_int  error = dispatch().clEnqueueSVMMap(
+                    command_queue,
+                    CL_TRUE,
+                    CL_MAP_READ,
+                    allocation,
+                    size,
+                    0,
+                    NULL,
+                    NULL );
+                if( error == CL_SUCCESS )
+                {
+                    if( deduplicate )
+                    {
+                        blobManifest += fileName + " " +
+                            dumpMemoryToBlob( allocation, size ) + "\n";
+                    }
+                    else if( forCaptureReplay )
+                    {
+                        const std::string fullFileName = captureReplayPrefix + fileName;
+                        dumpMemoryToFile(
+                            fullFileName,
+                            false,
+                            allocation,
+                            size );
+                    }
+                    if( forInspection )
+                    {
+                        const std::string fullFileName = inspectionPrefix + fileName;
+                        dumpMemoryToFile(
+                            fullFileName,
+                            config().DumpBufferHashes,
+                            allocation,
+                            size );
+                    }
 
-            m_MemAllocNumberMap[ image ] = m_MemAllocNumber;
-            m_MemAllocNumber++;
-        }
-    }
-}
+                    dispatch().clEnqueueSVMUnmap(
+                        command_queue,
+                        allocation,
+                        0,
+                        NULL,
+                        NULL );
+                }
+            }
+            else if( m_BufferInfoMap.find( memobj ) != m_BufferInfoMap.end() )
+            {
+                size_t  size = m_BufferInfoMap[ memobj ];
 
-///////////////////////////////////////////////////////////////////////////////
-//
-void CLIntercept::checkRemoveMemObj(
-    cl_mem memobj )
-{
-    std::lock_guard<std::mutex> lock(m_Mutex);
+                cl_int  error = CL_SUCCESS;
+                void*   ptr = dispatch().clEnqueueMapBuffer(
+                    command_queue,
+                    memobj,
+                    CL_TRUE,
+                    CL_MAP_READ,
+                    0,
+                    size,
+                    0,
+                    NULL,
+                    NULL,
+                    &error );
+                if( error == CL_SUCCESS )
+                {
+                    if( deduplicate )
+                    {
+                        blobManifest += fileName + " " +
+                            dumpMemoryToBlob( ptr, size ) + "\n";
+                    }
+                    else if( forCaptureReplay )
+                    {
+                        const std::string fullFileName = captureReplayPrefix + fileName;
+                        dumpMemoryToFile(
+                            fullFileName,
+                            false,
+                            ptr,
+                            size );
+                    }
+                    if( forInspection )
+                    {
+                        const std::string fullFileName = inspectionPrefix + fileName;
+                        dumpMemoryToFile(
+                            fullFileName,
+                            config().DumpBufferHashes,
+                            ptr,
+                            size );
+                    }
 
-    cl_uint refCount = getRefCount( memobj );
-    if( refCount == 1 )
-    {
-        m_MemAllocNumberMap.erase( memobj );
-        m_BufferInfoMap.erase( memobj );
-        m_ImageInfoMap.erase( memobj );
+                    dispatch().clEnqueueUnmapMemObject(
+                        command_queue,
+                        memobj,
+                        ptr,
+                        0,
+                        NULL,
+                        NULL );
+                }
+            }
+        }
     }
-}
 
-///////////////////////////////////////////////////////////////////////////////
-//
-void CLIntercept::addSVMAllocation(
-    void* svmPtr,
-    size_t size )
-{
-    if( svmPtr )
+    if( !blobManifest.empty() )
     {
-        std::lock_guard<std::mutex> lock(m_Mutex);
-
-        m_MemAllocNumberMap[ svmPtr ] = m_MemAllocNumber;
-        m_SVMAllocInfoMap[ svmPtr ] = size;
-        m_MemAllocNumber++;
+        const std::string fileName = captureReplayPrefix + "Blobs.txt";
+        std::ofstream os( fileName.c_str(), std::ios::out | std::ios::binary );
+        if( os.good() )
+        {
+            os << blobManifest;
+        }
+        else
+        {
+            logf( "Failed to open dump file for writing: %s\n",
+                fileName.c_str() );
+        }
     }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::removeSVMAllocation(
-    void* svmPtr )
+// Dumps one image for dumpImagesForKernel.  This may be called from a thread
+// pool thread, so it must not access any state protected by the mutex and
+// must not log directly.
+//
+// When possible, the image is read directly into a file mapping of the
+// capture replay or raw inspection dump file.  Otherwise, the image is read
+// in bounded-size chunks of rows or slices into two staging buffers, so the
+// next chunk is being read while the current chunk is written and hashed.
+void CLIntercept::dumpImageToFiles(
+    cl_command_queue command_queue,
+    SImageDumpJob& job )
 {
-    std::lock_guard<std::mutex> lock(m_Mutex);
+    const SImageInfo&   info = job.Info;
+    const bool  hash = config().DumpImageHashes;
 
-    m_MemAllocNumberMap.erase( svmPtr );
-    m_SVMAllocInfoMap.erase( svmPtr );
-}
+    const size_t    rowSize = info.Region[0] * info.ElementSize;
+    const size_t    sliceSize = rowSize * info.Region[1];
+    const size_t    size = sliceSize * info.Region[2];
 
-///////////////////////////////////////////////////////////////////////////////
-//
-void CLIntercept::addUSMAllocation(
-    void* usmPtr,
-    size_t size )
-{
-    if( usmPtr )
+    if( size == 0 )
     {
-        std::lock_guard<std::mutex> lock(m_Mutex);
-
-        m_MemAllocNumberMap[ usmPtr ] = m_MemAllocNumber;
-        m_USMAllocInfoMap[ usmPtr ] = size;
-        m_MemAllocNumber++;
+        return;
     }
-}
 
-///////////////////////////////////////////////////////////////////////////////
-//
-void CLIntercept::removeUSMAllocation(
-    void* usmPtr )
-{
-    std::lock_guard<std::mutex> lock(m_Mutex);
+    std::string mappedFileName;
+    if( !job.CaptureReplayFileName.empty() )
+    {
+        mappedFileName = job.CaptureReplayFileName;
+    }
+    else if( !job.InspectionFileName.empty() && !hash )
+    {
+        mappedFileName = job.InspectionFileName;
+    }
 
-    m_MemAllocNumberMap.erase( usmPtr );
-    m_USMAllocInfoMap.erase( usmPtr );
-}
+    void*   mappedPtr = NULL;
+    if( !mappedFileName.empty() )
+    {
+        mappedPtr = OS().MapFileForWriting( mappedFileName, size );
+    }
+    if( mappedPtr == NULL )
+    {
+        mappedFileName.clear();
+    }
 
-///////////////////////////////////////////////////////////////////////////////
-//
-void CLIntercept::setKernelArg(
-    cl_kernel kernel,
-    cl_uint arg_index,
-    const void* arg_value,
-    size_t arg_size )
-{
-    std::lock_guard<std::mutex> lock(m_Mutex);
+    std::ofstream   captureReplayStream;
+    std::ofstream   inspectionStream;
+    SHashContext    hashContext;
 
-    if( arg_value != nullptr )
+    if( !job.CaptureReplayFileName.empty() &&
+        job.CaptureReplayFileName != mappedFileName )
     {
-        if( arg_size == sizeof(cl_mem) )
+        captureReplayStream.open(
+            job.CaptureReplayFileName.c_str(),
+            std::ios::out | std::ios::binary );
+        if( !captureReplayStream.good() )
         {
-            cl_mem  mem = ((cl_mem*)arg_value)[0];
-            if( m_MemAllocNumberMap.find(mem) != m_MemAllocNumberMap.end() )
+            job.ErrorString += "Failed to open dump file for writing: " +
+                job.CaptureReplayFileName + "\n";
+        }
+    }
+    if( !job.InspectionFileName.empty() &&
+        job.InspectionFileName != mappedFileName )
+    {
+        inspectionStream.open(
+            job.InspectionFileName.c_str(),
+            std::ios::out | std::ios::binary );
+        if( !inspectionStream.good() )
+        {
+            job.ErrorString += "Failed to open dump file for writing: " +
+                job.InspectionFileName + "\n";
+        }
+    }
+
+    auto    processChunk = [&]( const char* ptr, size_t chunkSize ) {
+        if( captureReplayStream.is_open() )
+        {
+            captureReplayStream.write( ptr, chunkSize );
+        }
+        if( inspectionStream.is_open() )
+        {
+            if( hash )
+            {
+                hashContext.update( ptr, chunkSize );
+            }
+            else
             {
-                CArgMemMap& argMemMap = m_KernelArgMemMap[ kernel ];
-                argMemMap[ arg_index ] = mem;
+                inspectionStream.write( ptr, chunkSize );
             }
         }
+    };
 
-        std::string samplerString;
-        if( checkGetSamplerString( arg_size, arg_value, samplerString) )
+    cl_int  error = CL_SUCCESS;
+
+    if( mappedPtr != NULL )
+    {
+        size_t  origin[3] = { 0, 0, 0 };
+        error = dispatch().clEnqueueReadImage(
+            command_queue,
+            job.Image,
+            CL_TRUE,
+            origin,
+            info.Region,
+            0,
+            0,
+            mappedPtr,
+            0,
+            NULL,
+            NULL );
+        if( error == CL_SUCCESS )
         {
-            CArgSamplerMap& argSamplerMap = m_KernelArgSamplerMap[kernel];
-            argSamplerMap[ arg_index ] = samplerString;
+            processChunk( (const char*)mappedPtr, size );
         }
-
-        CArgDataMap& argDataMap = m_KernelArgDataMap[kernel];
-        const uint8_t* pRawArgData = reinterpret_cast<const uint8_t*>(arg_value);
-        argDataMap[ arg_index ] = std::vector<uint8_t>(
-            pRawArgData, pRawArgData + arg_size );
     }
     else
     {
-        CArgLocalSizeMap& argMap = m_KernelArgLocalSizeMap[ kernel ];
-        argMap[ arg_index ] = arg_size;
-    }
-}
+        // Each chunk is either a range of whole slices, or a range of rows
+        // within a single slice if one slice is larger than the chunk size.
+        // Images are read tightly packed, so chunks are contiguous in the
+        // dump file.
+        const size_t    maxChunkSize = 16 * 1024 * 1024;
 
-///////////////////////////////////////////////////////////////////////////////
-//
-void CLIntercept::setKernelArgSVMPointer(
-    cl_kernel kernel,
-    cl_uint arg_index,
-    const void* arg )
-{
-    std::lock_guard<std::mutex> lock(m_Mutex);
+        size_t  rowsPerChunk = info.Region[1];
+        size_t  slicesPerChunk = 1;
+        if( sliceSize > maxChunkSize )
+        {
+            rowsPerChunk = std::max<size_t>( 1, maxChunkSize / rowSize );
+        }
+        else
+        {
+            slicesPerChunk = std::max<size_t>( 1, maxChunkSize / sliceSize );
+        }
 
-    if( m_SVMAllocInfoMap.empty() )
-    {
-        return;
-    }
+        struct SChunk
+        {
+            size_t  Origin[3];
+            size_t  Region[3];
+            size_t  Size;
+        };
 
-    // Unlike clSetKernelArg(), which must pass a cl_mem, clSetKernelArgSVMPointer
-    // can pass a pointer to the base of a SVM allocation or anywhere inside of
-    // an SVM allocation.  As a result, we need to search the SVM map to find the
-    // base address and size of the SVM allocation.
+        std::vector<SChunk> chunks;
+        for( size_t z = 0; z < info.Region[2]; z += slicesPerChunk )
+        {
+            for( size_t y = 0; y < info.Region[1]; y += rowsPerChunk )
+            {
+                SChunk  chunk;
+                chunk.Origin[0] = 0;
+                chunk.Origin[1] = y;
+                chunk.Origin[2] = z;
+                chunk.Region[0] = info.Region[0];
+                chunk.Region[1] = std::min( rowsPerChunk, info.Region[1] - y );
+                chunk.Region[2] = std::min( slicesPerChunk, info.Region[2] - z );
+                chunk.Size = rowSize * chunk.Region[1] * chunk.Region[2];
+                chunks.push_back( chunk );
+            }
+        }
 
-    CSVMAllocInfoMap::iterator iter = m_SVMAllocInfoMap.lower_bound( arg );
-    if( iter == m_SVMAllocInfoMap.end() || (iter->first != arg && iter != m_SVMAllocInfoMap.begin()) )
-    {
-        // Go to the previous iterator.
-        --iter;
-    }
+        const size_t    stagingSize = chunks[0].Size;
+        std::vector<char>   staging[2];
+        staging[0].resize( stagingSize );
+        if( chunks.size() > 1 )
+        {
+            staging[1].resize( stagingSize );
+        }
 
-    const void* startPtr = iter->first;
-    const void* endPtr = (const char*)startPtr + iter->second;
-    if( arg >= startPtr && arg < endPtr )
-    {
-        CArgMemMap& argMemMap = m_KernelArgMemMap[ kernel ];
-        argMemMap[ arg_index ] = startPtr;
-    }
+        cl_event    events[2] = { NULL, NULL };
 
-    // Currently, only pointers to the start of an SVM allocation are supported for
-    // capture and replay.
-    if( arg == startPtr )
-    {
-        CArgDataMap& argDataMap = m_KernelArgDataMap[kernel];
-        const uint8_t* pRawArgData = reinterpret_cast<const uint8_t*>(&arg);
-        argDataMap[ arg_index ] = std::vector<uint8_t>(
-            pRawArgData, pRawArgData + sizeof(void*) );
-    }
-}
+        auto    readChunk = [&]( size_t c ) {
+            return dispatch().clEnqueueReadImage(
+                command_queue,
+                job.Image,
+                CL_FALSE,
+                chunks[c].Origin,
+                chunks[c].Region,
+                0,
+                0,
+                staging[c % 2].data(),
+                0,
+                NULL,
+                &events[c % 2] );
+        };
 
-///////////////////////////////////////////////////////////////////////////////
-//
-void CLIntercept::setKernelArgUSMPointer(
-    cl_kernel kernel,
-    cl_uint arg_index,
-    const void* arg )
-{
-    std::lock_guard<std::mutex> lock(m_Mutex);
+        error = readChunk( 0 );
+        for( size_t c = 0; c < chunks.size() && error == CL_SUCCESS; c++ )
+        {
+            if( c + 1 < chunks.size() )
+            {
+                error = readChunk( c + 1 );
+            }
 
-    if( m_USMAllocInfoMap.empty() )
+            cl_event&   event = events[c % 2];
+            if( error == CL_SUCCESS )
+            {
+                error = dispatch().clWaitForEvents( 1, &event );
+                dispatch().clReleaseEvent( event );
+                event = NULL;
+            }
+            if( error == CL_SUCCESS )
+            {
+                processChunk( staging[c % 2].data(), chunks[c].Size );
+            }
+        }
+
+        // Wait for any outstanding reads before the staging buffers are
+        // freed.
+        for( size_t e = 0; e < 2; e++ )
+        {
+            if( events[e] )
+            {
+                dispatch().clWaitForEvents( 1, &events[e] );
+                dispatch().clReleaseEvent( events[e] );
+            }
+        }
+    }
+
+    if( error != CL_SUCCESS )
     {
-        return;
+        job.ErrorString += "Failed to read image for dumping: " +
+            ( job.CaptureReplayFileName.empty() ?
+                job.InspectionFileName :
+                job.CaptureReplayFileName ) + "\n";
     }
 
-    CUSMAllocInfoMap::iterator iter = m_USMAllocInfoMap.lower_bound( arg );
-    if( iter == m_USMAllocInfoMap.end() || (iter->first != arg && iter != m_USMAllocInfoMap.begin()) )
+    if( inspectionStream.is_open() && hash && error == CL_SUCCESS )
     {
-        // Go to the previous iterator.
-        --iter;
+        inspectionStream << std::hex << hashContext.final() << "\n";
     }
+    captureReplayStream.close();
+    inspectionStream.close();
 
-    const void* startPtr = iter->first;
-    const void* endPtr = (const char*)startPtr + iter->second;
-    if( arg >= startPtr && arg < endPtr )
+    if( mappedPtr != NULL )
     {
-        CArgMemMap& argMemMap = m_KernelArgMemMap[ kernel ];
-        argMemMap[ arg_index ] = startPtr;
+        OS().UnmapFile( mappedPtr, size );
     }
 
-    // Currently, only pointers to the start of an SVM allocation are supported for
-    // capture and replay.
-    if( arg == startPtr )
+    if( error != CL_SUCCESS )
     {
-        CArgDataMap& argDataMap = m_KernelArgDataMap[kernel];
-        const uint8_t* pRawArgData = reinterpret_cast<const uint8_t*>(&arg);
-        argDataMap[ arg_index ] = std::vector<uint8_t>(
-            pRawArgData, pRawArgData + sizeof(void*) );
+        if( !job.CaptureReplayFileName.empty() )
+        {
+            std::remove( job.CaptureReplayFileName.c_str() );
+        }
+        if( !job.InspectionFileName.empty() )
+        {
+            std::remove( job.InspectionFileName.c_str() );
+        }
     }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::dumpCaptureReplayKernelSource(
-    const std::string& dumpDirectory,
-    cl_kernel kernel )
+void CLIntercept::dumpImagesForKernel(
+    const std::string& name,
+    const bool forCaptureReplay,
+    const bool forInspection,
+    const uint64_t enqueueCounter,
+    cl_kernel kernel,
+    cl_command_queue command_queue )
 {
-    cl_int errorCode = CL_SUCCESS;
+    std::vector<SImageDumpJob>  jobs;
 
-    cl_program program = nullptr;
-    dispatch().clGetKernelInfo(kernel, CL_KERNEL_PROGRAM, sizeof(cl_program), &program, nullptr);
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
 
-    // First, try to get and dump the program source
+        std::string captureReplayPrefix;
+        std::string inspectionPrefix;
 
-    size_t sourceSize = 0;
-    dispatch().clGetProgramInfo(program, CL_PROGRAM_SOURCE, 0, nullptr, &sourceSize);
-    if( sourceSize != 0 )
-    {
-        std::vector<char> source(sourceSize, ' ');
-        errorCode = dispatch().clGetProgramInfo(program, CL_PROGRAM_SOURCE, sourceSize, source.data(), nullptr);
-        if( errorCode == CL_SUCCESS )
+        // Call clFinish on the command queue.
+        // This is needed to ensure that all previous commands have finished
+        // executing, especially for out-of-order queues.
+        dispatch().clFinish( command_queue );
+
+        // Get the dump directory names and make directories.
+
+        if( forCaptureReplay )
         {
-            std::ofstream output(dumpDirectory + "kernel.cl", std::ios::out | std::ios::binary);
-            output.write(source.data(), sourceSize);
-        }
-    }
+            OS().GetDumpDirectoryName( sc_DumpDirectoryName, captureReplayPrefix );
+            captureReplayPrefix += "/Replay/Enqueue_";
+            captureReplayPrefix += std::to_string(enqueueCounter);
+            captureReplayPrefix += "_";
+            captureReplayPrefix += getShortKernelName(kernel);
+            captureReplayPrefix += "/";
+            captureReplayPrefix += name;
+            captureReplayPrefix += "/";
 
-    // Next, try to get and dump the program IL (SPIR-V)
+            OS().MakeDumpDirectories( captureReplayPrefix );
+        }
 
-    size_t ilSize = 0;
-    dispatch().clGetProgramInfo(program, CL_PROGRAM_IL, 0, nullptr, &ilSize);
-    if( ilSize != 0 )
-    {
-        std::vector<char> il(ilSize, ' ');
-        errorCode = dispatch().clGetProgramInfo(program, CL_PROGRAM_IL, ilSize, il.data(), nullptr);
-        if( errorCode == CL_SUCCESS )
+        if( forInspection )
         {
-            std::ofstream output(dumpDirectory + "kernel.spv", std::ios::out | std::ios::binary);
-            output.write(il.data(), ilSize);
+            OS().GetDumpDirectoryName( sc_DumpDirectoryName, inspectionPrefix );
+            inspectionPrefix += "/memDump";
+            inspectionPrefix += name;
+            inspectionPrefix += "Enqueue/";
+
+            OS().MakeDumpDirectories( inspectionPrefix );
         }
-    }
 
-    // In all cases,  get and dump program binaries
-    {
-        cl_uint num_devices = 0;
-        dispatch().clGetProgramInfo(program, CL_PROGRAM_NUM_DEVICES, sizeof(cl_uint), &num_devices, nullptr);
+        const CKernelArgInfoVector& args = m_KernelInfoMap[ kernel ].Args;
+        for( cl_uint arg_index = 0; arg_index < args.size(); arg_index++ )
+        {
+            CLI_C_ASSERT( sizeof(void*) == sizeof(cl_mem) );
 
-        std::vector<cl_device_id> devices(num_devices);
-        dispatch().clGetProgramInfo(program, CL_PROGRAM_DEVICES, num_devices * sizeof(cl_device_id), devices.data(), 0);
+            cl_mem  memobj = (cl_mem)args[ arg_index ].Allocation;
 
-        std::vector<size_t> sizes(num_devices);
-        dispatch().clGetProgramInfo(program, CL_PROGRAM_BINARY_SIZES, num_devices * sizeof(size_t), sizes.data(), nullptr);
+            if( m_ImageInfoMap.find( memobj ) != m_ImageInfoMap.end() )
+            {
+                const SImageInfo&   info = m_ImageInfoMap[ memobj ];
+                unsigned int        number = m_MemAllocNumberMap[ memobj ];
 
-        std::vector<std::vector<unsigned char>> binaries;
-        std::vector<unsigned char*> binariesData;
-        binaries.reserve(num_devices);
-        binariesData.reserve(num_devices);
-        for( size_t device = 0; device != num_devices; ++device )
-        {
-            binaries.emplace_back(sizes[device]);
-            binariesData.emplace_back(binaries[device].data());
+                std::string fileName;
+                char    tmpStr[ MAX_PATH ];
+
+                // Add the enqueue count to file name
+                {
+                    CLI_SPRINTF( tmpStr, MAX_PATH, "%04u",
+                        (unsigned int)enqueueCounter );
+
+                    fileName += "Enqueue_";
+                    fileName += tmpStr;
+                }
+
+                // Add the kernel name to the file name
+                {
+                    fileName += "_Kernel_";
+                    fileName += getShortKernelName(kernel);
+                }
+
+                // Add the arg number to the file name
+                {
+                    CLI_SPRINTF( tmpStr, MAX_PATH, "%u", arg_index );
+
+                    fileName += "_Arg_";
+                    fileName += tmpStr;
+                }
+
+                // Add the image number to the file name
+                {
+                    CLI_SPRINTF( tmpStr, MAX_PATH, "%04u", number );
+
+                    fileName += "_Image_";
+                    fileName += tmpStr;
+                }
+
+                // Add the image dimensions to the file name
+                {
+                    CLI_SPRINTF( tmpStr, MAX_PATH, "_%zux%zux%zu_%zubpp",
+                        info.Region[0],
+                        info.Region[1],
+                        info.Region[2],
+                        info.ElementSize * 8 );
+
+                    fileName += tmpStr;
+                }
+
+                // Add extension to file name
+                {
+                    fileName += ".raw";
+                }
+
+                SImageDumpJob   job;
+                job.Image = memobj;
+                job.Info = info;
+                job.CaptureReplayFileName =
+                    forCaptureReplay ? captureReplayPrefix + fileName : "";
+                job.InspectionFileName =
+                    forInspection ? inspectionPrefix + fileName : "";
+                jobs.push_back( job );
+            }
         }
+    }
+
+    // Dump the images in parallel.  The jobs do not access any of the
+    // tracking maps and do not log, so they run without the mutex, and any
+    // errors are logged below by this thread.
+    if( jobs.size() > 1 )
+    {
+        m_ThreadPool.start();
+    }
+    m_ThreadPool.parallelFor(
+        jobs.size(),
+        [&]( size_t j ) {
+            dumpImageToFiles(
+                command_queue,
+                jobs[j] );
+        } );
 
-        errorCode = dispatch().clGetProgramInfo(program, CL_PROGRAM_BINARIES, num_devices * sizeof(unsigned char*), binariesData.data(), nullptr);
-        if( errorCode == CL_SUCCESS )
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    for( size_t j = 0; j < jobs.size(); j++ )
+    {
+        if( !jobs[j].ErrorString.empty() )
         {
-            for (size_t device = 0; device != num_devices; ++device)
-            {
-                std::ofstream output(dumpDirectory + "DeviceBinary" + std::to_string(device) + ".bin", std::ios::out | std::ios::binary);
-                output.write(reinterpret_cast<char const*>(binaries[device].data()), binaries[device].size());
-            }
+            log( jobs[j].ErrorString );
         }
     }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::dumpCaptureReplayKernelInfo(
-    const std::string& dumpDirectory,
+void CLIntercept::injectBuffersForKernel(
+    const uint64_t enqueueCounter,
     cl_kernel kernel,
-    size_t work_dim,
-    const size_t* gws_offset,
-    const size_t* gws,
-    const size_t* lws )
+    cl_command_queue command_queue )
 {
-    std::ofstream output{dumpDirectory + "worksizes.txt"};
+    std::lock_guard<std::mutex> lock(m_Mutex);
 
-    // Print the values of the worksizes and offsets on a line in the order:
-    // gws
-    // lws
-    // gws_offset
-    for (unsigned idx = 0; idx != work_dim; ++idx)
-    {
-        output << (!gws        ? 0 : gws[idx]) << ' ';
-    }
-    output << '\n';
+    cl_platform_id  platform = getPlatform(kernel);
 
-    for (unsigned idx = 0; idx != work_dim; ++idx)
-    {
-        output << (!lws        ? 0 : lws[idx]) << ' ';
-    }
-    output << '\n';
+    std::vector<char>   transferBuf;
+    std::string prefix;
 
-    for (unsigned idx = 0; idx != work_dim; ++idx)
+    OS().GetDumpDirectoryNameWithoutPid( sc_DumpDirectoryName, prefix );
+    prefix += "/Inject/";
+
+    const CKernelArgInfoVector& args = m_KernelInfoMap[ kernel ].Args;
+    for( cl_uint arg_index = 0; arg_index < args.size(); arg_index++ )
     {
-        output << (!gws_offset ? 0 : gws_offset[idx]) << ' ';
-    }
-    output << '\n';
+        CLI_C_ASSERT( sizeof(void*) == sizeof(cl_mem) );
 
-    cl_program program = nullptr;
-    dispatch().clGetKernelInfo(kernel, CL_KERNEL_PROGRAM, sizeof(cl_program), &program, nullptr);
+        void*   allocation = (void*)args[ arg_index ].Allocation;
+        cl_mem  memobj = (cl_mem)allocation;
 
-    cl_context context = nullptr;
-    dispatch().clGetProgramInfo(program, CL_PROGRAM_CONTEXT, sizeof(cl_context), &context, nullptr);
+        const CUSMAllocInfoMap::SEntry* usmEntry =
+            m_USMAllocInfoMap.findBase( allocation );
+        const CSVMAllocInfoMap::SEntry* svmEntry =
+            m_SVMAllocInfoMap.findBase( allocation );
 
-    // Note: this currently does not work for multi-device contexts.
-    cl_device_id device = nullptr;
-    dispatch().clGetContextInfo(context, CL_CONTEXT_DEVICES, sizeof(cl_device_id), &device, nullptr);
+        if( usmEntry || svmEntry ||
+            ( m_BufferInfoMap.find( memobj ) != m_BufferInfoMap.end() ) )
+        {
+            unsigned int        number = m_MemAllocNumberMap[ memobj ];
 
-    {
-        std::ofstream outputBuildOptions{dumpDirectory + "buildOptions.txt"};
+            std::string fileName( prefix );
+            char    tmpStr[ MAX_PATH ];
 
-        size_t buildOptionsSize = 0;
-        dispatch().clGetProgramBuildInfo(program, device, CL_PROGRAM_BUILD_OPTIONS, 0, nullptr, &buildOptionsSize);
+            // Add the enqueue count to file name
+            {
+                CLI_SPRINTF( tmpStr, MAX_PATH, "%04u",
+                    (unsigned int)enqueueCounter );
 
-        std::string buildOptions(buildOptionsSize, ' ');
-        int error = dispatch().clGetProgramBuildInfo(program, device, CL_PROGRAM_BUILD_OPTIONS, buildOptionsSize, &buildOptions[0], nullptr);
-        if( error == CL_SUCCESS )
-        {
-            buildOptions.pop_back();
-            outputBuildOptions << buildOptions << '\n';
-        }
-    }
+                fileName += "Enqueue_";
+                fileName += tmpStr;
+            }
 
-    std::string kernelName = getShortKernelName(kernel);
-    std::ofstream outputKernelName{dumpDirectory + "kernelName.txt"};
-    outputKernelName << kernelName;
+            // Add the kernel name to the file name
+            {
+                fileName += "_Kernel_";
+                fileName += getShortKernelName(kernel);
+            }
 
-    cl_uint numArgs = 0;
-    dispatch().clGetKernelInfo(kernel, CL_KERNEL_NUM_ARGS, sizeof(cl_uint), &numArgs, nullptr);
+            // Add the arg number to the file name
+            {
+                CLI_SPRINTF( tmpStr, MAX_PATH, "%u", arg_index );
 
-    if( numArgs )
-    {
-        std::ofstream outputArgTypes{dumpDirectory + "ArgumentDataTypes.txt"};
-        for( cl_uint idx = 0; idx != numArgs; ++idx )
-        {
-            size_t argTypeNameSize = 0;
-            dispatch().clGetKernelArgInfo(kernel, idx, CL_KERNEL_ARG_TYPE_NAME, 0, nullptr, &argTypeNameSize);
+                fileName += "_Arg_";
+                fileName += tmpStr;
+            }
 
-            std::string argTypeName(argTypeNameSize, ' ');
-            int error = dispatch().clGetKernelArgInfo(kernel, idx, CL_KERNEL_ARG_TYPE_NAME, argTypeNameSize, &argTypeName[0], nullptr);
-            if( error == CL_SUCCESS )
+            // Add the buffer number to the file name
             {
-                argTypeName.pop_back();
-                outputArgTypes << argTypeName << '\n';
+                CLI_SPRINTF( tmpStr, MAX_PATH, "%04u", number );
+
+                fileName += "_Buffer_";
+                fileName += tmpStr;
             }
-        }
-    }
-}
 
-///////////////////////////////////////////////////////////////////////////////
-//
-void CLIntercept::dumpCaptureReplayKernelArguments(
-    const std::string& dumpDirectory,
-    cl_kernel kernel )
-{
-    const auto& argDataMap = m_KernelArgDataMap[kernel];
-    for( const auto& arg: argDataMap )
-    {
-        const auto index = arg.first;
-        const auto& value = arg.second;
-        std::string fileName{dumpDirectory + "Argument" + std::to_string(index) + ".bin"};
-        std::ofstream out{fileName, std::ios::out | std::ios::binary};
-        out.write(reinterpret_cast<char const*>(value.data()), value.size());
-    }
+            // Add extension to file name
+            {
+                fileName += ".bin";
+            }
 
-    const auto& localMemSizes = m_KernelArgLocalSizeMap[kernel];
-    for( const auto& arg: localMemSizes )
-    {
-        const auto index = arg.first;
-        const auto value = arg.second;
-        std::string fileName{dumpDirectory + "Local" + std::to_string(index) + ".txt"};
-        std::ofstream out{fileName};
-        out << std::to_string(value);
-    }
+            std::ifstream is;
+            is.open( fileName.c_str(), std::ios::in | std::ios::binary );
+            if( is.good() )
+            {
+                log("Injecting buffer file: " + fileName + "\n");
 
-    const auto& argMemMap = m_KernelArgMemMap[kernel];
-    for( const auto& arg : argMemMap )
-    {
-        const auto index = arg.first;
-        const auto value = (cl_mem)arg.second;
-        if( m_ImageInfoMap.find( value ) != m_ImageInfoMap.end() )
-        {
-            const SImageInfo&   info = m_ImageInfoMap[ value ];
-            std::string fileName{dumpDirectory + "Image_MetaData_" + std::to_string(index) + ".txt"};
-            std::ofstream out{fileName};
-            out << info.Region[0] << '\n'
-                << info.Region[1] << '\n'
-                << info.Region[2] << '\n'
-                << info.ElementSize << '\n'
-                << info.RowPitch << '\n'
-                << info.SlicePitch << '\n'
-                << info.Format.image_channel_data_type << '\n'
-                << info.Format.image_channel_order << '\n'
-                << static_cast<int>(info.ImageType);
-        }
-    }
+                size_t  fileSize = 0;
+                is.seekg( 0, std::ios::end );
+                fileSize = (size_t)is.tellg();
+                is.seekg( 0, std::ios::beg );
 
-    const auto& samplerValues = m_KernelArgSamplerMap[kernel];
-    for( const auto& arg: samplerValues )
-    {
-        const auto index = arg.first;
-        const auto& value = arg.second;
-        std::string fileName{dumpDirectory + "Sampler" + std::to_string(index) + ".txt"};
-        std::ofstream out{fileName};
-        out << value;
+                if( usmEntry )
+                {
+                    size_t size = usmEntry->Size;
+                    if( size < fileSize )
+                    {
+                        logf("Skipping injection: USM alloc size (%zu bytes) is less than file size (%zu bytes)!\n",
+                            size, fileSize );
+                    }
+                    else
+                    {
+                        if( dispatchX(platform).clEnqueueMemcpyINTEL == NULL )
+                        {
+                            getExtensionFunctionAddress(
+                                platform,
+                                "clEnqueueMemcpyINTEL" );
+                        }
+
+                        const auto& dispatchX = this->dispatchX(platform);
+                        if( dispatchX.clEnqueueMemcpyINTEL )
+                        {
+                            // Copy directly from a mapping of the file if
+                            // possible, otherwise read the file into memory.
+                            size_t  mappedSize = 0;
+                            const void* src = OS().MapFileForReading(
+                                fileName,
+                                mappedSize );
+                            if( src == NULL )
+                            {
+                                if( transferBuf.size() < fileSize )
+                                {
+                                    transferBuf.resize(fileSize);
+                                }
+                                is.read( transferBuf.data(), fileSize );
+                                src = transferBuf.data();
+                            }
+
+                            dispatchX.clEnqueueMemcpyINTEL(
+                                command_queue,
+                                CL_TRUE,
+                                allocation,
+                                src,
+                                fileSize,
+                                0,
+                                NULL,
+                                NULL );
+
+                            if( mappedSize != 0 )
+                            {
+                                OS().UnmapFile( src, mappedSize );
+                            }
+                        }
+                    }
+                }
+                else if( svmEntry )
+                {
+                    size_t size = svmEntry->Size;
+                    if( size < fileSize )
+                    {
+                        logf("Skipping injection: SVM alloc size (%zu bytes) is less than file size (%zu bytes)!\n",
+                            size, fileSize );
+                    }
+                    else
+                    {
+                        cl_int  error = dispatch().clEnqueueSVMMap(
+                            command_queue,
+                            CL_TRUE,
+                            CL_MAP_WRITE_INVALIDATE_REGION,
+                            allocation,
+                            size,
+                            0,
+                            NULL,
+                            NULL );
+                        if( error == CL_SUCCESS )
+                        {
+                            is.read( (char*)allocation, size );
+
+                            dispatch().clEnqueueSVMUnmap(
+                                command_queue,
+                                allocation,
+                                0,
+                                NULL,
+                                NULL );
+                        }
+                    }
+                }
+                else if( m_BufferInfoMap.find( memobj ) != m_BufferInfoMap.end() )
+                {
+                    size_t size = m_BufferInfoMap[ memobj ];
+                    if( size < fileSize )
+                    {
+                        logf("Skipping injection: buffer size (%zu bytes) is less than file size (%zu bytes)!\n",
+                            size, fileSize );
+                    }
+                    else
+                    {
+                        cl_int  error = CL_SUCCESS;
+                        void*   ptr = dispatch().clEnqueueMapBuffer(
+                            command_queue,
+                            memobj,
+                            CL_TRUE,
+                            CL_MAP_WRITE_INVALIDATE_REGION,
+                            0,
+                            size,
+                            0,
+                            NULL,
+                            NULL,
+                            &error );
+                        if( error == CL_SUCCESS )
+                        {
+                            is.read( (char*)ptr, size );
+
+                            dispatch().clEnqueueUnmapMemObject(
+                                command_queue,
+                                memobj,
+                                ptr,
+                                0,
+                                NULL,
+                                NULL );
+                        }
+                    }
+                }
+            }
+        }
     }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::dumpBuffersForKernel(
-    const std::string& name,
-    const bool forCaptureReplay,
-    const bool forInspection,
+void CLIntercept::injectImagesForKernel(
     const uint64_t enqueueCounter,
     cl_kernel kernel,
     cl_command_queue command_queue )
 {
     std::lock_guard<std::mutex> lock(m_Mutex);
 
-    cl_platform_id  platform = getPlatform(kernel);
-
     std::vector<char>   transferBuf;
-    std::string captureReplayPrefix;
-    std::string inspectionPrefix;
-
-    // Call clFinish on the command queue.
-    // This is needed to ensure that all previous commands have finished
-    // executing, especially for out-of-order queues.
-    dispatch().clFinish( command_queue );
-
-    // Get the dump directory names and make directories.
-
-    if( forCaptureReplay )
-    {
-        OS().GetDumpDirectoryName( sc_DumpDirectoryName, captureReplayPrefix );
-        captureReplayPrefix += "/Replay/Enqueue_";
-        captureReplayPrefix += std::to_string(enqueueCounter);
-        captureReplayPrefix += "_";
-        captureReplayPrefix += getShortKernelName(kernel);
-        captureReplayPrefix += "/";
-        captureReplayPrefix += name;
-        captureReplayPrefix += "/";
-
-        OS().MakeDumpDirectories( captureReplayPrefix );
-    }
-
-    if( forInspection )
-    {
-        OS().GetDumpDirectoryName( sc_DumpDirectoryName, inspectionPrefix );
-        inspectionPrefix += "/memDump";
-        inspectionPrefix += name;
-        inspectionPrefix += "Enqueue/";
+    std::string prefix;
 
-        OS().MakeDumpDirectories( inspectionPrefix );
-    }
+    OS().GetDumpDirectoryNameWithoutPid( sc_DumpDirectoryName, prefix );
+    prefix += "/Inject/";
 
-    CArgMemMap& kernelArgMemMap = m_KernelArgMemMap[ kernel ];
-    CArgMemMap::iterator  i = kernelArgMemMap.begin();
-    while( i != kernelArgMemMap.end() )
+    const CKernelArgInfoVector& args = m_KernelInfoMap[ kernel ].Args;
+    for( cl_uint arg_index = 0; arg_index < args.size(); arg_index++ )
     {
         CLI_C_ASSERT( sizeof(void*) == sizeof(cl_mem) );
 
-        cl_uint arg_index = (*i).first;
-        void*   allocation = (void*)(*i).second;
-        cl_mem  memobj = (cl_mem)allocation;
-
-        ++i;
+        cl_mem  memobj = (cl_mem)args[ arg_index ].Allocation;
 
-        if( ( m_USMAllocInfoMap.find( allocation ) != m_USMAllocInfoMap.end() ) ||
-            ( m_SVMAllocInfoMap.find( allocation ) != m_SVMAllocInfoMap.end() ) ||
-            ( m_BufferInfoMap.find( memobj ) != m_BufferInfoMap.end() ) )
+        if( m_ImageInfoMap.find( memobj ) != m_ImageInfoMap.end() )
         {
+            const SImageInfo&   info = m_ImageInfoMap[ memobj ];
             unsigned int        number = m_MemAllocNumberMap[ memobj ];
 
-            std::string fileName;
+            std::string fileName( prefix );
             char    tmpStr[ MAX_PATH ];
 
             // Add the enqueue count to file name
@@ -8066,157 +10736,88 @@ void CLIntercept::dumpBuffersForKernel(
                 fileName += tmpStr;
             }
 
-            // Add the buffer number to the file name
+            // Add the image number to the file name
             {
                 CLI_SPRINTF( tmpStr, MAX_PATH, "%04u", number );
 
-                fileName += "_Buffer_";
+                fileName += "_Image_";
+                fileName += tmpStr;
+            }
+
+            // Add the image dimensions to the file name
+            {
+                CLI_SPRINTF( tmpStr, MAX_PATH, "_%zux%zux%zu_%zubpp",
+                    info.Region[0],
+                    info.Region[1],
+                    info.Region[2],
+                    info.ElementSize * 8 );
+
                 fileName += tmpStr;
             }
 
             // Add extension to file name
             {
-                fileName += ".bin";
+                fileName += ".raw";
             }
 
-            // Dump the buffer contents to the file.
-            if( m_USMAllocInfoMap.find( allocation ) != m_USMAllocInfoMap.end() )
+            std::ifstream is;
+            is.open( fileName.c_str(), std::ios::in | std::ios::binary );
+            if( is.good() )
             {
-                size_t  size = m_USMAllocInfoMap[ allocation ];
+                log("Injecting image file: " + fileName + "\n");
 
-                if( dispatchX(platform).clEnqueueMemcpyINTEL == NULL )
-                {
-                    getExtensionFunctionAddress(
-                        platform,
-                        "clEnqueueMemcpyINTEL" );
-                }
-                if( transferBuf.size() < size )
+                size_t  fileSize = 0;
+                is.seekg( 0, std::ios::end );
+                fileSize = (size_t)is.tellg();
+                is.seekg( 0, std::ios::beg );
+
+                size_t  size =
+                    info.Region[0] *
+                    info.Region[1] *
+                    info.Region[2] *
+                    info.ElementSize;
+
+                if( size != fileSize )
                 {
-                    transferBuf.resize(size);
+                    logf("Skipping injection: image size (%zu bytes) is not equal to file size (%zu bytes)!\n",
+                        size, fileSize );
                 }
-
-                const auto& dispatchX = this->dispatchX(platform);
-                if( dispatchX.clEnqueueMemcpyINTEL &&
-                    transferBuf.size() >= size )
+                else
                 {
-                    cl_int  error = dispatchX.clEnqueueMemcpyINTEL(
-                        command_queue,
-                        CL_TRUE,
-                        transferBuf.data(),
-                        allocation,
-                        size,
-                        0,
-                        NULL,
-                        NULL );
-                    if( error == CL_SUCCESS )
+                    // Write directly from a mapping of the file if
+                    // possible, otherwise read the file into memory.
+                    size_t  mappedSize = 0;
+                    const void* src = OS().MapFileForReading(
+                        fileName,
+                        mappedSize );
+                    if( src == NULL )
                     {
-                        if( forCaptureReplay )
-                        {
-                            const std::string fullFileName = captureReplayPrefix + fileName;
-                            dumpMemoryToFile(
-                                fullFileName,
-                                false,
-                                transferBuf.data(),
-                                size );
-                        }
-                        if( forInspection )
+                        if( transferBuf.size() < size )
                         {
-                            const std::string fullFileName = inspectionPrefix + fileName;
-                            dumpMemoryToFile(
-                                fullFileName,
-                                config().DumpBufferHashes,
-                                transferBuf.data(),
-                                size );
+                            transferBuf.resize(size);
                         }
-                    }
-                }
-            }
-            else if( m_SVMAllocInfoMap.find( allocation ) != m_SVMAllocInfoMap.end() )
-            {
-                size_t  size = m_SVMAllocInfoMap[ allocation ];
-
-                cl_int  error = dispatch().clEnqueueSVMMap(
-                    command_queue,
-                    CL_TRUE,
-                    CL_MAP_READ,
-                    allocation,
-                    size,
-                    0,
-                    NULL,
-                    NULL );
-                if( error == CL_SUCCESS )
-                {
-                    if( forCaptureReplay )
-                    {
-                        const std::string fullFileName = captureReplayPrefix + fileName;
-                        dumpMemoryToFile(
-                            fullFileName,
-                            false,
-                            allocation,
-                            size );
-                    }
-                    if( forInspection )
-                    {
-                        const std::string fullFileName = inspectionPrefix + fileName;
-                        dumpMemoryToFile(
-                            fullFileName,
-                            config().DumpBufferHashes,
-                            allocation,
-                            size );
+                        is.read( transferBuf.data(), size );
+                        src = transferBuf.data();
                     }
 
-                    dispatch().clEnqueueSVMUnmap(
+                    size_t  origin[3] = { 0, 0, 0 };
+                    dispatch().clEnqueueWriteImage(
                         command_queue,
-                        allocation,
+                        memobj,
+                        CL_TRUE,
+                        origin,
+                        info.Region,
+                        0,
+                        0,
+                        src,
                         0,
                         NULL,
                         NULL );
-                }
-            }
-            else if( m_BufferInfoMap.find( memobj ) != m_BufferInfoMap.end() )
-            {
-                size_t  size = m_BufferInfoMap[ memobj ];
 
-                cl_int  error = CL_SUCCESS;
-                void*   ptr = dispatch().clEnqueueMapBuffer(
-                    command_queue,
-                    memobj,
-                    CL_TRUE,
-                    CL_MAP_READ,
-                    0,
-                    size,
-                    0,
-                    NULL,
-                    NULL,
-                    &error );
-                if( error == CL_SUCCESS )
-                {
-                    if( forCaptureReplay )
-                    {
-                        const std::string fullFileName = captureReplayPrefix + fileName;
-                        dumpMemoryToFile(
-                            fullFileName,
-                            false,
-                            ptr,
-                            size );
-                    }
-                    if( forInspection )
+                    if( mappedSize != 0 )
                     {
-                        const std::string fullFileName = inspectionPrefix + fileName;
-                        dumpMemoryToFile(
-                            fullFileName,
-                            config().DumpBufferHashes,
-                            ptr,
-                            size );
+                        OS().UnmapFile( src, mappedSize );
                     }
-
-                    dispatch().clEnqueueUnmapMemObject(
-                        command_queue,
-                        memobj,
-                        ptr,
-                        0,
-                        NULL,
-                        NULL );
                 }
             }
         }
@@ -8225,165 +10826,285 @@ void CLIntercept::dumpBuffersForKernel(
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::dumpImagesForKernel(
-    const std::string& name,
-    const bool forCaptureReplay,
-    const bool forInspection,
+void CLIntercept::dumpArgument(
     const uint64_t enqueueCounter,
     cl_kernel kernel,
-    cl_command_queue command_queue )
+    cl_int arg_index,
+    size_t size,
+    const void *pBuffer )
 {
-    std::lock_guard<std::mutex> lock(m_Mutex);
+    if( kernel )
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
 
-    std::vector<char>   transferBuf;
-    std::string captureReplayPrefix;
-    std::string inspectionPrefix;
+        std::string fileName = "";
 
-    // Call clFinish on the command queue.
-    // This is needed to ensure that all previous commands have finished
-    // executing, especially for out-of-order queues.
-    dispatch().clFinish( command_queue );
+        // Get the dump directory name.
+        {
+            OS().GetDumpDirectoryName( sc_DumpDirectoryName, fileName );
+            fileName += "/SetKernelArg/";
+        }
 
-    // Get the dump directory names and make directories.
+        // Now make directories as appropriate.
+        {
+            OS().MakeDumpDirectories( fileName );
+        }
 
-    if( forCaptureReplay )
-    {
-        OS().GetDumpDirectoryName( sc_DumpDirectoryName, captureReplayPrefix );
-        captureReplayPrefix += "/Replay/Enqueue_";
-        captureReplayPrefix += std::to_string(enqueueCounter);
-        captureReplayPrefix += "_";
-        captureReplayPrefix += getShortKernelName(kernel);
-        captureReplayPrefix += "/";
-        captureReplayPrefix += name;
-        captureReplayPrefix += "/";
+        // Add the enqueue count to file name
+        {
+            char    enqueueCount[ MAX_PATH ];
 
-        OS().MakeDumpDirectories( captureReplayPrefix );
-    }
+            CLI_SPRINTF( enqueueCount, MAX_PATH, "%04u",
+                (unsigned int)enqueueCounter );
+            fileName += "SetKernelArg_";
+            fileName += enqueueCount;
+        }
+
+        // Add the kernel name to the file name
+        {
+            fileName += "_Kernel_";
+            fileName += getShortKernelName(kernel);
+        }
+
+        // Add the arg number to the file name
+        {
+            char    argName[ MAX_PATH ];
+
+            CLI_SPRINTF( argName, MAX_PATH, "%d", arg_index );
 
-    if( forInspection )
-    {
-        OS().GetDumpDirectoryName( sc_DumpDirectoryName, inspectionPrefix );
-        inspectionPrefix += "/memDump";
-        inspectionPrefix += name;
-        inspectionPrefix += "Enqueue/";
+            fileName += "_Arg_";
+            fileName += argName;
+        }
 
-        OS().MakeDumpDirectories( inspectionPrefix );
+        // Add extension to file name
+        {
+            fileName += ".bin";
+        }
+
+        // Dump the buffer contents to the file.
+        if( pBuffer != NULL)
+        {
+            dumpMemoryToFile(
+                fileName,
+                false,
+                pBuffer,
+                size );
+        }
     }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::dumpBuffer(
+    const std::string& name,
+    const uint64_t enqueueCounter,
+    cl_mem memobj,
+    cl_command_queue command_queue,
+    void* ptr,
+    size_t offset,
+    size_t size )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
 
-    CArgMemMap& kernelArgMemMap = m_KernelArgMemMap[ kernel ];
-    CArgMemMap::iterator  i = kernelArgMemMap.begin();
-    while( i != kernelArgMemMap.end() )
+    if( m_BufferInfoMap.find( memobj ) != m_BufferInfoMap.end() )
     {
-        CLI_C_ASSERT( sizeof(void*) == sizeof(cl_mem) );
+        std::string fileName = "";
+
+        // Get the dump directory name.
+        {
+            OS().GetDumpDirectoryName( sc_DumpDirectoryName, fileName );
+            fileName += "/memDumpCreateMapUnmap/";
+        }
 
-        cl_uint arg_index = (*i).first;
-        cl_mem  memobj = (cl_mem)(*i).second;
+        // Now make directories as appropriate.
+        {
+            OS().MakeDumpDirectories( fileName );
+        }
 
-        ++i;
+        fileName += name;
 
-        if( m_ImageInfoMap.find( memobj ) != m_ImageInfoMap.end() )
+        // Add the buffer number to the file name
         {
-            const SImageInfo&   info = m_ImageInfoMap[ memobj ];
             unsigned int        number = m_MemAllocNumberMap[ memobj ];
 
-            std::string fileName;
-            char    tmpStr[ MAX_PATH ];
+            char    bufferName[ MAX_PATH ];
 
-            // Add the enqueue count to file name
-            {
-                CLI_SPRINTF( tmpStr, MAX_PATH, "%04u",
-                    (unsigned int)enqueueCounter );
+            CLI_SPRINTF( bufferName, MAX_PATH, "%04u", number );
 
-                fileName += "Enqueue_";
-                fileName += tmpStr;
-            }
+            fileName += "_Buffer_";
+            fileName += bufferName;
+        }
 
-            // Add the kernel name to the file name
-            {
-                fileName += "_Kernel_";
-                fileName += getShortKernelName(kernel);
-            }
+        // Add the offset to the file name
+        {
+            char    offsetName[ MAX_PATH ];
 
-            // Add the arg number to the file name
-            {
-                CLI_SPRINTF( tmpStr, MAX_PATH, "%u", arg_index );
+            CLI_SPRINTF( offsetName, MAX_PATH, "%04zu",
+                offset );
 
-                fileName += "_Arg_";
-                fileName += tmpStr;
-            }
+            fileName += "_Offset_";
+            fileName += offsetName;
+        }
 
-            // Add the image number to the file name
-            {
-                CLI_SPRINTF( tmpStr, MAX_PATH, "%04u", number );
+        // Add the enqueue count to file name
+        {
+            char    enqueueCount[ MAX_PATH ];
 
-                fileName += "_Image_";
-                fileName += tmpStr;
-            }
+            CLI_SPRINTF( enqueueCount, MAX_PATH, "%04u",
+                (unsigned int)enqueueCounter );
 
-            // Add the image dimensions to the file name
-            {
-                CLI_SPRINTF( tmpStr, MAX_PATH, "_%zux%zux%zu_%zubpp",
-                    info.Region[0],
-                    info.Region[1],
-                    info.Region[2],
-                    info.ElementSize * 8 );
+            fileName += "_Enqueue_";
+            fileName += enqueueCount;
+        }
 
-                fileName += tmpStr;
-            }
+        // Add extension to file name
+        {
+            fileName += ".bin";
+        }
 
-            // Add extension to file name
-            {
-                fileName += ".raw";
-            }
+        // Dump the buffer contents to the file.
+        // There are two possibilities:
+        // 1) We have a pointer and size already.  This might happen
+        //    when the buffer is being created or was just mapped.
+        //    In this case, we can just write this to the file.
+        // 2) We have no pointer or size.  This usually happens when
+        //    the buffer is being unmapped.  In this case, we'll
+        //    map and dump the entire buffer.
+        if( ptr != NULL && size != 0 )
+        {
+            dumpMemoryToFile(
+                fileName,
+                config().DumpBufferHashes,
+                ptr,
+                size );
+        }
+        else
+        {
+            // We should have checked this already...
+            CLI_ASSERT( m_BufferInfoMap.find( memobj ) != m_BufferInfoMap.end() );
 
-            // Dump the image contents to the file.
-            size_t  size =
-                info.Region[0] *
-                info.Region[1] *
-                info.Region[2] *
-                info.ElementSize;
-            if( transferBuf.size() < size )
-            {
-                transferBuf.resize(size);
-            }
+            size_t  size = m_BufferInfoMap[ memobj ];
 
-            if( transferBuf.size() >= size )
+            cl_int  error = CL_SUCCESS;
+            ptr = dispatch().clEnqueueMapBuffer(
+                command_queue,
+                memobj,
+                CL_TRUE,
+                CL_MAP_READ,
+                0,
+                size,
+                0,
+                NULL,
+                NULL,
+                &error );
+            if( error == CL_SUCCESS )
             {
-                size_t  origin[3] = { 0, 0, 0 };
-                cl_int  error = dispatch().clEnqueueReadImage(
+                dumpMemoryToFile(
+                    fileName,
+                    config().DumpBufferHashes,
+                    ptr,
+                    size );
+
+                dispatch().clEnqueueUnmapMemObject(
                     command_queue,
                     memobj,
-                    CL_TRUE,
-                    origin,
-                    info.Region,
-                    0,
-                    0,
-                    transferBuf.data(),
+                    ptr,
                     0,
                     NULL,
                     NULL );
+            }
+        }
+    }
+}
 
-                if( error == CL_SUCCESS )
-                {
-                    if( forCaptureReplay )
-                    {
-                        const std::string fullFileName = captureReplayPrefix + fileName;
-                        dumpMemoryToFile(
-                            fullFileName,
-                            false,
-                            transferBuf.data(),
-                            size );
-                    }
-                    if( forInspection )
-                    {
-                        const std::string fullFileName = inspectionPrefix + fileName;
-                        dumpMemoryToFile(
-                            fullFileName,
-                            config().DumpImageHashes,
-                            transferBuf.data(),
-                            size );
-                    }
-                }
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::addMapPointer(
+    const void* ptr,
+    const cl_map_flags flags,
+    const size_t size )
+{
+    if( ptr )
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        if( m_MapPointerInfoMap.find(ptr) != m_MapPointerInfoMap.end() )
+        {
+            log( "Ignoring duplicate mapped pointer.\n" );
+        }
+        else
+        {
+            SMapPointerInfo&    mapPointerInfo = m_MapPointerInfoMap[ptr];
+
+            mapPointerInfo.Flags = flags;
+            mapPointerInfo.Size = size;
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::removeMapPointer(
+    const void* ptr )
+{
+    if( ptr )
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_MapPointerInfoMap.erase(ptr);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::checkEventList(
+    const char* functionName,
+    cl_uint numEvents,
+    const cl_event* eventList,
+    cl_event* event )
+{
+    if( numEvents != 0 && eventList == NULL )
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        logf( "Check Events for %s: Num Events is %u, but Event List is NULL!\n",
+            functionName,
+            numEvents );
+    }
+    else
+    {
+        for( cl_uint i = 0; i < numEvents; i++ )
+        {
+            if( event != NULL && *event == eventList[i] )
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                logf( "Check Events for %s: outgoing event %p is also in the event wait list!\n",
+                    functionName,
+                    eventList[i] );
+                continue;
+            }
+
+            cl_int  eventCommandExecutionStatus = 0;
+            cl_int  errorCode = dispatch().clGetEventInfo(
+                eventList[i],
+                CL_EVENT_COMMAND_EXECUTION_STATUS,
+                sizeof(eventCommandExecutionStatus),
+                &eventCommandExecutionStatus,
+                NULL );
+            if( errorCode != CL_SUCCESS )
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                logf( "Check Events for %s: clGetEventInfo for wait event %p returned %s (%d)!\n",
+                    functionName,
+                    eventList[i],
+                    enumName().name(errorCode).c_str(),
+                    errorCode );
+            }
+            else if( eventCommandExecutionStatus < 0 )
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                logf( "Check Events for %s: wait event %p is in an error state (%d)!\n",
+                    functionName,
+                    eventList[i],
+                    eventCommandExecutionStatus );
             }
         }
     }
@@ -8391,1853 +11112,2432 @@ void CLIntercept::dumpImagesForKernel(
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::injectBuffersForKernel(
-    const uint64_t enqueueCounter,
+void CLIntercept::checkKernelArgUSMPointer(
     cl_kernel kernel,
-    cl_command_queue command_queue )
+    const void* arg )
 {
     std::lock_guard<std::mutex> lock(m_Mutex);
 
-    cl_platform_id  platform = getPlatform(kernel);
-
-    std::vector<char>   transferBuf;
-    std::string prefix;
+    cl_int errorCode = CL_SUCCESS;
 
-    OS().GetDumpDirectoryNameWithoutPid( sc_DumpDirectoryName, prefix );
-    prefix += "/Inject/";
+    cl_platform_id  platform = getPlatform(kernel);
 
-    CArgMemMap& kernelArgMemMap = m_KernelArgMemMap[ kernel ];
-    CArgMemMap::iterator  i = kernelArgMemMap.begin();
-    while( i != kernelArgMemMap.end() )
+    // If we don't have a function pointer for clGetMemAllocINFO, try to
+    // get one.  It's possible that the function pointer exists but
+    // the application hasn't queried for it yet, in which case it won't
+    // be installed into the dispatch table.
+    if( dispatchX(platform).clGetMemAllocInfoINTEL == NULL )
     {
-        CLI_C_ASSERT( sizeof(void*) == sizeof(cl_mem) );
-
-        cl_uint arg_index = (*i).first;
-        void*   allocation = (void*)(*i).second;
-        cl_mem  memobj = (cl_mem)allocation;
-
-        ++i;
+        getExtensionFunctionAddress(
+            platform,
+            "clGetMemAllocInfoINTEL" );
+    }
 
-        if( ( m_USMAllocInfoMap.find( allocation ) != m_USMAllocInfoMap.end() ) ||
-            ( m_SVMAllocInfoMap.find( allocation ) != m_SVMAllocInfoMap.end() ) ||
-            ( m_BufferInfoMap.find( memobj ) != m_BufferInfoMap.end() ) )
+    const auto& dispatchX = this->dispatchX(platform);
+    if( dispatchX.clGetMemAllocInfoINTEL == NULL )
+    {
+        logf( "function pointer for clGetMemAllocInfoINTEL is NULL\n" );
+    }
+    else if( arg == NULL )
+    {
+        logf( "mem pointer %p is NULL\n", arg );
+    }
+    else
+    {
+        cl_context  context = NULL;
+        if( errorCode == CL_SUCCESS )
         {
-            unsigned int        number = m_MemAllocNumberMap[ memobj ];
-
-            std::string fileName( prefix );
-            char    tmpStr[ MAX_PATH ];
+            errorCode = dispatch().clGetKernelInfo(
+                kernel,
+                CL_KERNEL_CONTEXT,
+                sizeof(context),
+                &context,
+                NULL );
+        }
 
-            // Add the enqueue count to file name
-            {
-                CLI_SPRINTF( tmpStr, MAX_PATH, "%04u",
-                    (unsigned int)enqueueCounter );
+        if( errorCode == CL_SUCCESS )
+        {
+            cl_unified_shared_memory_type_intel memType = CL_MEM_TYPE_UNKNOWN_INTEL;
+            cl_device_id associatedDevice = NULL;
 
-                fileName += "Enqueue_";
-                fileName += tmpStr;
-            }
+            dispatchX.clGetMemAllocInfoINTEL(
+                context,
+                arg,
+                CL_MEM_ALLOC_TYPE_INTEL,
+                sizeof(memType),
+                &memType,
+                NULL );
+            dispatchX.clGetMemAllocInfoINTEL(
+                context,
+                arg,
+                CL_MEM_ALLOC_DEVICE_INTEL,
+                sizeof(associatedDevice),
+                &associatedDevice,
+                NULL );
 
-            // Add the kernel name to the file name
+            char* deviceName = NULL;
+            if( associatedDevice )
             {
-                fileName += "_Kernel_";
-                fileName += getShortKernelName(kernel);
+                allocateAndGetDeviceInfoString(
+                    associatedDevice,
+                    CL_DEVICE_NAME,
+                    deviceName );
             }
 
-            // Add the arg number to the file name
+            if( memType == CL_MEM_TYPE_DEVICE_INTEL )
             {
-                CLI_SPRINTF( tmpStr, MAX_PATH, "%u", arg_index );
-
-                fileName += "_Arg_";
-                fileName += tmpStr;
+                if( deviceName )
+                {
+                    logf( "mem pointer %p is a DEVICE pointer associated with device %s\n",
+                        arg,
+                        deviceName );
+                }
+                else if( associatedDevice )
+                {
+                    logf( "mem pointer %p is a DEVICE pointer associated with device %p\n",
+                        arg,
+                        associatedDevice );
+                }
+                else
+                {
+                    CLI_ASSERT( 0 );
+                    logf( "mem pointer %p is a DEVICE pointer without an associated device???\n",
+                        arg );
+                }
             }
-
-            // Add the buffer number to the file name
+            else if( memType == CL_MEM_TYPE_HOST_INTEL )
             {
-                CLI_SPRINTF( tmpStr, MAX_PATH, "%04u", number );
-
-                fileName += "_Buffer_";
-                fileName += tmpStr;
+                logf( "mem pointer %p is a HOST pointer\n",
+                    arg );
             }
-
-            // Add extension to file name
+            else if( memType == CL_MEM_TYPE_SHARED_INTEL )
             {
-                fileName += ".bin";
+                if( deviceName )
+                {
+                    logf( "mem pointer %p is a SHARED pointer associated with device %s\n",
+                        arg,
+                        deviceName );
+                }
+                else if( associatedDevice )
+                {
+                    logf( "mem pointer %p is a SHARED pointer associated with device %p\n",
+                        arg,
+                        associatedDevice );
+                }
+                else
+                {
+                    logf( "mem pointer %p is a SHARED pointer without an associated device\n",
+                        arg );
+                }
             }
-
-            std::ifstream is;
-            is.open( fileName.c_str(), std::ios::in | std::ios::binary );
-            if( is.good() )
+            else if( memType == CL_MEM_TYPE_UNKNOWN_INTEL )
             {
-                log("Injecting buffer file: " + fileName + "\n");
-
-                size_t  fileSize = 0;
-                is.seekg( 0, std::ios::end );
-                fileSize = (size_t)is.tellg();
-                is.seekg( 0, std::ios::beg );
-
-                if( m_USMAllocInfoMap.find( allocation ) != m_USMAllocInfoMap.end() )
+                // This could be a system shared USM pointer, or this could be an error.
+                // Check the devices associated with this kernel to see if any support
+                // system shared USM allocations.
+                cl_program  program = NULL;
+                if( errorCode == CL_SUCCESS )
                 {
-                    size_t size = m_USMAllocInfoMap[ allocation ];
-                    if( size < fileSize )
-                    {
-                        logf("Skipping injection: USM alloc size (%zu bytes) is less than file size (%zu bytes)!\n",
-                            size, fileSize );
-                    }
-                    else
-                    {
-                        if( dispatchX(platform).clEnqueueMemcpyINTEL == NULL )
-                        {
-                            getExtensionFunctionAddress(
-                                platform,
-                                "clEnqueueMemcpyINTEL" );
-                        }
-                        if( transferBuf.size() < size )
-                        {
-                            transferBuf.resize(size);
-                        }
-
-                        const auto& dispatchX = this->dispatchX(platform);
-                        if( dispatchX.clEnqueueMemcpyINTEL &&
-                            transferBuf.size() >= size )
-                        {
-                            is.read( transferBuf.data(), size );
+                    errorCode = dispatch().clGetKernelInfo(
+                        kernel,
+                        CL_KERNEL_PROGRAM,
+                        sizeof(program),
+                        &program,
+                        NULL );
+                }
 
-                            dispatchX.clEnqueueMemcpyINTEL(
-                                command_queue,
-                                CL_TRUE,
-                                allocation,
-                                transferBuf.data(),
-                                size,
-                                0,
-                                NULL,
-                                NULL );
-                        }
-                    }
+                cl_uint         numDevices = 0;
+                cl_device_id*   deviceList = NULL;
+                if( errorCode == CL_SUCCESS )
+                {
+                    errorCode = allocateAndGetProgramDeviceList(
+                        program,
+                        numDevices,
+                        deviceList );
                 }
-                else if( m_SVMAllocInfoMap.find( allocation ) != m_SVMAllocInfoMap.end() )
+
+                if( errorCode == CL_SUCCESS )
                 {
-                    size_t size = m_SVMAllocInfoMap[ allocation ];
-                    if( size < fileSize )
-                    {
-                        logf("Skipping injection: SVM alloc size (%zu bytes) is less than file size (%zu bytes)!\n",
-                            size, fileSize );
-                    }
-                    else
+                    bool supportsSystemSharedUSM = false;
+                    for( cl_uint d = 0; d < numDevices; d++ )
                     {
-                        cl_int  error = dispatch().clEnqueueSVMMap(
-                            command_queue,
-                            CL_TRUE,
-                            CL_MAP_WRITE_INVALIDATE_REGION,
-                            allocation,
-                            size,
-                            0,
-                            NULL,
-                            NULL );
-                        if( error == CL_SUCCESS )
-                        {
-                            is.read( (char*)allocation, size );
-
-                            dispatch().clEnqueueSVMUnmap(
-                                command_queue,
-                                allocation,
-                                0,
-                                NULL,
-                                NULL );
+                        cl_device_unified_shared_memory_capabilities_intel usmCaps = 0;
+                        dispatch().clGetDeviceInfo(
+                            deviceList[d],
+                            CL_DEVICE_SHARED_SYSTEM_MEM_CAPABILITIES_INTEL,
+                            sizeof(usmCaps),
+                            &usmCaps,
+                            NULL);
+                        if( usmCaps != 0 )
+                        {
+                            supportsSystemSharedUSM = true;
+                            break;
                         }
                     }
-                }
-                else if( m_BufferInfoMap.find( memobj ) != m_BufferInfoMap.end() )
-                {
-                    size_t size = m_BufferInfoMap[ memobj ];
-                    if( size < fileSize )
+
+                    if( supportsSystemSharedUSM )
                     {
-                        logf("Skipping injection: buffer size (%zu bytes) is less than file size (%zu bytes)!\n",
-                            size, fileSize );
+                        logf( "mem pointer %p is an UNKNOWN pointer and could be a shared system pointer\n",
+                            arg );
                     }
                     else
                     {
-                        cl_int  error = CL_SUCCESS;
-                        void*   ptr = dispatch().clEnqueueMapBuffer(
-                            command_queue,
-                            memobj,
-                            CL_TRUE,
-                            CL_MAP_WRITE_INVALIDATE_REGION,
-                            0,
-                            size,
-                            0,
-                            NULL,
-                            NULL,
-                            &error );
-                        if( error == CL_SUCCESS )
-                        {
-                            is.read( (char*)ptr, size );
-
-                            dispatch().clEnqueueUnmapMemObject(
-                                command_queue,
-                                memobj,
-                                ptr,
-                                0,
-                                NULL,
-                                NULL );
-                        }
+                        logf( "mem pointer %p is an UNKNOWN pointer and no device support shared system pointers!\n",
+                            arg );
                     }
                 }
+                else
+                {
+                    logf( "mem pointer %p is an UNKNOWN pointer and additional queries returned an error!\n",
+                        arg );
+                }
+
+                delete [] deviceList;
+            }
+            else
+            {
+                CLI_ASSERT( 0 );
+                logf( "query for mem pointer %p returned an unknown memory type %08X!\n",
+                    arg,
+                    memType );
             }
+
+            delete [] deviceName;
+        }
+        else
+        {
+            logf( "couldn't query context for kernel %p for mem pointer %p!\n",
+                kernel,
+                arg );
         }
     }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::injectImagesForKernel(
-    const uint64_t enqueueCounter,
-    cl_kernel kernel,
-    cl_command_queue command_queue )
+bool CLIntercept::checkRelaxAllocationLimitsSupport(
+    cl_program program ) const
 {
-    std::lock_guard<std::mutex> lock(m_Mutex);
-
-    std::vector<char>   transferBuf;
-    std::string prefix;
-
-    OS().GetDumpDirectoryNameWithoutPid( sc_DumpDirectoryName, prefix );
-    prefix += "/Inject/";
+    cl_int  errorCode = CL_SUCCESS;
+    bool    supported = true;
 
-    CArgMemMap& kernelArgMemMap = m_KernelArgMemMap[ kernel ];
-    CArgMemMap::iterator  i = kernelArgMemMap.begin();
-    while( i != kernelArgMemMap.end() )
+    cl_uint         numDevices = 0;
+    cl_device_id*   deviceList = NULL;
+    if( errorCode == CL_SUCCESS )
     {
-        CLI_C_ASSERT( sizeof(void*) == sizeof(cl_mem) );
-
-        cl_uint arg_index = (*i).first;
-        cl_mem  memobj = (cl_mem)(*i).second;
+        errorCode = allocateAndGetProgramDeviceList(
+            program,
+            numDevices,
+            deviceList );
+    }
 
-        ++i;
+    if( errorCode == CL_SUCCESS )
+    {
+        supported = checkRelaxAllocationLimitsSupport(
+            numDevices,
+            deviceList );
+    }
 
-        if( m_ImageInfoMap.find( memobj ) != m_ImageInfoMap.end() )
-        {
-            const SImageInfo&   info = m_ImageInfoMap[ memobj ];
-            unsigned int        number = m_MemAllocNumberMap[ memobj ];
+    delete [] deviceList;
 
-            std::string fileName( prefix );
-            char    tmpStr[ MAX_PATH ];
+    return ( errorCode == CL_SUCCESS ) && supported;
+}
 
-            // Add the enqueue count to file name
-            {
-                CLI_SPRINTF( tmpStr, MAX_PATH, "%04u",
-                    (unsigned int)enqueueCounter );
+///////////////////////////////////////////////////////////////////////////////
+//
+bool CLIntercept::checkRelaxAllocationLimitsSupport(
+    cl_uint numDevices,
+    const cl_device_id* deviceList ) const
+{
+    cl_int  errorCode = CL_SUCCESS;
+    bool    supported = true;
 
-                fileName += "Enqueue_";
-                fileName += tmpStr;
-            }
+    // For now, check for Intel GPU devices to determine whether relaxed
+    // allocations are supported.  Eventually this can be checked using
+    // formal mechanisms.
 
-            // Add the kernel name to the file name
-            {
-                fileName += "_Kernel_";
-                fileName += getShortKernelName(kernel);
-            }
+    for( cl_uint i = 0; i < numDevices; i++ )
+    {
+        cl_device_type  deviceType = 0;
+        cl_uint deviceVendorId;
 
-            // Add the arg number to the file name
-            {
-                CLI_SPRINTF( tmpStr, MAX_PATH, "%u", arg_index );
+        errorCode |= dispatch().clGetDeviceInfo(
+            deviceList[ i ],
+            CL_DEVICE_TYPE,
+            sizeof( deviceType ),
+            &deviceType,
+            NULL );
+        errorCode |= dispatch().clGetDeviceInfo(
+            deviceList[ i ],
+            CL_DEVICE_VENDOR_ID,
+            sizeof( deviceVendorId ),
+            &deviceVendorId,
+            NULL );
+        if( ( deviceType & CL_DEVICE_TYPE_GPU ) == 0 ||
+            deviceVendorId != 0x8086 )
+        {
+            supported = false;
+            break;
+        }
+    }
 
-                fileName += "_Arg_";
-                fileName += tmpStr;
-            }
+    return ( errorCode == CL_SUCCESS ) && supported;
+}
 
-            // Add the image number to the file name
-            {
-                CLI_SPRINTF( tmpStr, MAX_PATH, "%04u", number );
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::usmAllocPropertiesOverride(
+    const cl_mem_properties_intel* properties,
+    cl_mem_properties_intel*& pLocalAllocProperties ) const
+{
+    const cl_mem_flags CL_MEM_ALLOW_UNRESTRICTED_SIZE_INTEL = (1 << 23);
 
-                fileName += "_Image_";
-                fileName += tmpStr;
-            }
+    bool    addMemFlagsEnum = config().RelaxAllocationLimits != 0;
 
-            // Add the image dimensions to the file name
+    size_t  numProperties = 0;
+    if( properties )
+    {
+        while( properties[ numProperties ] != 0 )
+        {
+            switch( properties[ numProperties ] )
             {
-                CLI_SPRINTF( tmpStr, MAX_PATH, "_%zux%zux%zu_%zubpp",
-                    info.Region[0],
-                    info.Region[1],
-                    info.Region[2],
-                    info.ElementSize * 8 );
-
-                fileName += tmpStr;
+            case CL_MEM_FLAGS:
+                addMemFlagsEnum = false;
+                break;
+            default:
+                break;
             }
+            numProperties += 2;
+        }
+    }
 
-            // Add extension to file name
-            {
-                fileName += ".raw";
-            }
+    if( addMemFlagsEnum )
+    {
+        numProperties += 2;
+    }
 
-            std::ifstream is;
-            is.open( fileName.c_str(), std::ios::in | std::ios::binary );
-            if( is.good() )
+    // Allocate a new array of properties.  We need to allocate two
+    // properties for each pair, plus one property for the terminating
+    // zero.
+    pLocalAllocProperties = new cl_queue_properties[ numProperties + 1 ];
+    if( pLocalAllocProperties )
+    {
+        // Copy the old properties array to the new properties array,
+        // if the new properties array exists.
+        numProperties = 0;
+        if( properties )
+        {
+            while( properties[ numProperties ] != 0 )
             {
-                log("Injecting image file: " + fileName + "\n");
-
-                size_t  fileSize = 0;
-                is.seekg( 0, std::ios::end );
-                fileSize = (size_t)is.tellg();
-                is.seekg( 0, std::ios::beg );
-
-                size_t  size =
-                    info.Region[0] *
-                    info.Region[1] *
-                    info.Region[2] *
-                    info.ElementSize;
-
-                if( size != fileSize )
-                {
-                    logf("Skipping injection: image size (%zu bytes) is not equal to file size (%zu bytes)!\n",
-                        size, fileSize );
-                }
-                else if( transferBuf.size() < size )
-                {
-                    transferBuf.resize(size);
-                }
-
-                if( transferBuf.size() >= size )
+                pLocalAllocProperties[ numProperties ] = properties[ numProperties ];
+                if( properties[ numProperties ] == CL_MEM_FLAGS )
                 {
-                    is.read( (char*)transferBuf.data(), size );
+                    CLI_ASSERT( addMemFlagsEnum == false );
 
-                    size_t  origin[3] = { 0, 0, 0 };
-                    dispatch().clEnqueueWriteImage(
-                        command_queue,
-                        memobj,
-                        CL_TRUE,
-                        origin,
-                        info.Region,
-                        0,
-                        0,
-                        transferBuf.data(),
-                        0,
-                        NULL,
-                        NULL );
+                    cl_mem_properties_intel flags = properties[ numProperties + 1 ];
+                    if( config().RelaxAllocationLimits )
+                    {
+                        flags |= CL_MEM_ALLOW_UNRESTRICTED_SIZE_INTEL;
+                    }
+
+                    pLocalAllocProperties[ numProperties + 1 ] = flags;
+                }
+                else
+                {
+                    pLocalAllocProperties[ numProperties + 1 ] =
+                        properties[ numProperties + 1 ];
                 }
+                numProperties += 2;
+            }
+        }
+        if( addMemFlagsEnum )
+        {
+            pLocalAllocProperties[ numProperties] = CL_MEM_FLAGS;
+
+            cl_mem_properties_intel flags = 0;
+            if( config().RelaxAllocationLimits )
+            {
+                flags |= CL_MEM_ALLOW_UNRESTRICTED_SIZE_INTEL;
             }
+
+            pLocalAllocProperties[ numProperties + 1 ] = flags;
+            numProperties += 2;
         }
+
+        // Add the terminating zero.
+        pLocalAllocProperties[ numProperties ] = 0;
     }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::dumpArgument(
+void CLIntercept::startCaptureReplay(
     const uint64_t enqueueCounter,
-    cl_kernel kernel,
-    cl_int arg_index,
-    size_t size,
-    const void *pBuffer )
+    const cl_kernel kernel,
+    const cl_uint workDim,
+    const size_t* gwo,
+    const size_t* gws,
+    const size_t* lws )
 {
-    if( kernel )
-    {
-        std::lock_guard<std::mutex> lock(m_Mutex);
-
-        std::string fileName = "";
-
-        // Get the dump directory name.
-        {
-            OS().GetDumpDirectoryName( sc_DumpDirectoryName, fileName );
-            fileName += "/SetKernelArg/";
-        }
-
-        // Now make directories as appropriate.
-        {
-            OS().MakeDumpDirectories( fileName );
-        }
-
-        // Add the enqueue count to file name
-        {
-            char    enqueueCount[ MAX_PATH ];
-
-            CLI_SPRINTF( enqueueCount, MAX_PATH, "%04u",
-                (unsigned int)enqueueCounter );
-            fileName += "SetKernelArg_";
-            fileName += enqueueCount;
-        }
+    std::lock_guard<std::mutex> lock(m_Mutex);
 
-        // Add the kernel name to the file name
-        {
-            fileName += "_Kernel_";
-            fileName += getShortKernelName(kernel);
-        }
+    std::string fileNamePrefix = "";
 
-        // Add the arg number to the file name
-        {
-            char    argName[ MAX_PATH ];
+    OS().GetDumpDirectoryName( sc_DumpDirectoryName, fileNamePrefix );
+    fileNamePrefix += "/Replay/Enqueue_";
+    fileNamePrefix += std::to_string(enqueueCounter);
+    fileNamePrefix += "_";
+    fileNamePrefix += getShortKernelName(kernel);
+    fileNamePrefix += "/";
 
-            CLI_SPRINTF( argName, MAX_PATH, "%d", arg_index );
+    OS().MakeDumpDirectories( fileNamePrefix );
 
-            fileName += "_Arg_";
-            fileName += argName;
-        }
+    log( "Dumping kernel capture replay to directory: " + fileNamePrefix + "\n" );
 
-        // Add extension to file name
-        {
-            fileName += ".bin";
-        }
+    const char* pPythonScript = NULL;
+    size_t pythonScriptLength = 0;
+    if( m_OS.GetReplayScriptString(
+            pPythonScript,
+            pythonScriptLength ) )
+    {
+        std::ofstream outputPythonScript{fileNamePrefix + "run.py", std::ios::out | std::ios::binary};
+        outputPythonScript.write(pPythonScript, pythonScriptLength);
+    }
 
-        // Dump the buffer contents to the file.
-        if( pBuffer != NULL)
-        {
-            dumpMemoryToFile(
-                fileName,
-                false,
-                pBuffer,
-                size );
-        }
+    {
+        std::ofstream outputKernelNumber{fileNamePrefix + "enqueueNumber.txt"};
+        outputKernelNumber << std::to_string(enqueueCounter) << '\n';
     }
+
+    dumpCaptureReplayKernelSource( fileNamePrefix, kernel );
+    dumpCaptureReplayKernelInfo( fileNamePrefix, kernel, workDim, gwo, gws, lws );
+    dumpCaptureReplayKernelArguments( fileNamePrefix, kernel );
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::dumpBuffer(
-    const std::string& name,
+void CLIntercept::startAubCapture(
+    const char* functionName,
     const uint64_t enqueueCounter,
-    cl_mem memobj,
-    cl_command_queue command_queue,
-    void* ptr,
-    size_t offset,
-    size_t size )
+    const cl_kernel kernel,
+    const cl_uint workDim,
+    const size_t* gws,
+    const size_t* lws,
+    cl_command_queue command_queue )
 {
-    std::lock_guard<std::mutex> lock(m_Mutex);
-
-    if( m_BufferInfoMap.find( memobj ) != m_BufferInfoMap.end() )
+    if( m_AubCaptureStarted == false )
     {
-        std::string fileName = "";
+        std::lock_guard<std::mutex> lock(m_Mutex);
 
-        // Get the dump directory name.
-        {
-            OS().GetDumpDirectoryName( sc_DumpDirectoryName, fileName );
-            fileName += "/memDumpCreateMapUnmap/";
-        }
+        // For kernels, perform aub capture skip checks.  We'll skip aubcapture if:
+        // - the current skip counter is less than the specified skip counter, or
+        // - the current capture counter is greater than or equal to the specified capture counter.
 
-        // Now make directories as appropriate.
+        bool    skip = false;
+        if( kernel != NULL )
         {
-            OS().MakeDumpDirectories( fileName );
-        }
+            if( m_AubCaptureKernelEnqueueSkipCounter < m_Config.AubCaptureNumKernelEnqueuesSkip )
+            {
+                //logf( "Skipping kernel aub capture: current skip counter is %u, requested skip counter is %u.\n",
+                //    m_AubCaptureKernelEnqueueSkipCounter,
+                //    m_Config.AubCaptureNumKernelEnqueuesSkip );
 
-        fileName += name;
+                skip = true;
+                ++m_AubCaptureKernelEnqueueSkipCounter;
+            }
+            else
+            {
+                if( m_AubCaptureKernelEnqueueCaptureCounter >= m_Config.AubCaptureNumKernelEnqueuesCapture )
+                {
+                    //logf( "Skipping kernel aub capture: current capture counter is %u, requested capture counter is %u.\n",
+                    //    m_AubCaptureKernelEnqueueCaptureCounter,
+                    //    m_Config.AubCaptureNumKernelEnqueuesCapture );
+                    skip = true;
+                }
 
-        // Add the buffer number to the file name
+                ++m_AubCaptureKernelEnqueueCaptureCounter;
+            }
+        }
+
+        if( skip == false &&
+            m_AubCaptureStarted == false )
         {
-            unsigned int        number = m_MemAllocNumberMap[ memobj ];
+            // Try to call clFinish() on the passed-in command queue.
+            // This isn't perfect, since we'd really rather call
+            // clFinish on all command queues to start with a fresh
+            // capture, but it's better than nothing.
+            // TODO: Is Flush() sufficient?
+            dispatch().clFinish( command_queue );
 
-            char    bufferName[ MAX_PATH ];
+            char    charBuf[ MAX_PATH ];
 
-            CLI_SPRINTF( bufferName, MAX_PATH, "%04u", number );
+            std::string fileName = "";
 
-            fileName += "_Buffer_";
-            fileName += bufferName;
-        }
+            // Get the dump directory name.
+            {
+                OS().GetDumpDirectoryName( sc_DumpDirectoryName, fileName );
+                fileName += "/";
+                fileName += "AubCapture";
 
-        // Add the offset to the file name
-        {
-            char    offsetName[ MAX_PATH ];
+                if( m_Config.AubCaptureIndividualEnqueues )
+                {
+                    fileName += "_Enqueue_";
 
-            CLI_SPRINTF( offsetName, MAX_PATH, "%04zu",
-                offset );
+                    CLI_SPRINTF( charBuf, MAX_PATH, "%08u", (cl_uint)enqueueCounter );
 
-            fileName += "_Offset_";
-            fileName += offsetName;
-        }
+                    fileName += charBuf;
+                    fileName += "_";
 
-        // Add the enqueue count to file name
-        {
-            char    enqueueCount[ MAX_PATH ];
+                    if( kernel )
+                    {
+                        const std::string& kernelName = getShortKernelName(kernel);
+                        fileName += "kernel_";
+                        fileName += kernelName;
+
+                        std::ostringstream  ss;
+                        ss << "_G_";
+                        if( gws )
+                        {
+                            if( workDim >= 1 )
+                            {
+                                ss << gws[0];
+                            }
+                            if( workDim >= 2 )
+                            {
+                                ss << "x" << gws[1];
+                            }
+                            if( workDim >= 3 )
+                            {
+                                ss << "x" << gws[2];
+                            }
+                        }
+                        else
+                        {
+                            ss << "NULL";
+                        }
+                        ss << "_L_";
+                        if( lws )
+                        {
+                            if( workDim >= 1 )
+                            {
+                                ss << lws[0];
+                            }
+                            if( workDim >= 2 )
+                            {
+                                ss << "x" << lws[1];
+                            }
+                            if( workDim >= 3 )
+                            {
+                                ss << "x" << lws[2];
+                            }
+                        }
+                        else
+                        {
+                            ss << "NULL";
+                        }
+                        fileName += ss.str();
+                    }
+                    else
+                    {
+                        fileName += functionName;
+                    }
+                }
+                else if( m_Config.AubCaptureMinEnqueue != 0 ||
+                         m_Config.AubCaptureMaxEnqueue != UINT_MAX )
+                {
+                    fileName += "_Enqueue_";
 
-            CLI_SPRINTF( enqueueCount, MAX_PATH, "%04u",
-                (unsigned int)enqueueCounter );
+                    CLI_SPRINTF( charBuf, MAX_PATH, "%08u", m_Config.AubCaptureMinEnqueue );
 
-            fileName += "_Enqueue_";
-            fileName += enqueueCount;
-        }
+                    fileName += charBuf;
+                    fileName += "_to_";
 
-        // Add extension to file name
-        {
-            fileName += ".bin";
-        }
+                    CLI_SPRINTF( charBuf, MAX_PATH, "%08u", m_Config.AubCaptureMaxEnqueue );
 
-        // Dump the buffer contents to the file.
-        // There are two possibilities:
-        // 1) We have a pointer and size already.  This might happen
-        //    when the buffer is being created or was just mapped.
-        //    In this case, we can just write this to the file.
-        // 2) We have no pointer or size.  This usually happens when
-        //    the buffer is being unmapped.  In this case, we'll
-        //    map and dump the entire buffer.
-        if( ptr != NULL && size != 0 )
-        {
-            dumpMemoryToFile(
-                fileName,
-                config().DumpBufferHashes,
-                ptr,
-                size );
-        }
-        else
-        {
-            // We should have checked this already...
-            CLI_ASSERT( m_BufferInfoMap.find( memobj ) != m_BufferInfoMap.end() );
+                    fileName += charBuf;
+                }
+            }
 
-            size_t  size = m_BufferInfoMap[ memobj ];
+            // Now make directories as appropriate.
+            {
+                OS().MakeDumpDirectories( fileName );
+            }
 
-            cl_int  error = CL_SUCCESS;
-            ptr = dispatch().clEnqueueMapBuffer(
-                command_queue,
-                memobj,
-                CL_TRUE,
-                CL_MAP_READ,
-                0,
-                size,
-                0,
-                NULL,
-                NULL,
-                &error );
-            if( error == CL_SUCCESS )
+#if defined(_WIN32)
+            if( m_Config.AubCaptureKDC )
             {
-                dumpMemoryToFile(
+                fileName += ".daf";
+                OS().StartAubCaptureKDC(
                     fileName,
-                    config().DumpBufferHashes,
-                    ptr,
-                    size );
-
-                dispatch().clEnqueueUnmapMemObject(
-                    command_queue,
-                    memobj,
-                    ptr,
-                    0,
-                    NULL,
-                    NULL );
+                    config().AubCaptureStartWait );
+            }
+            else
+#endif
+            {
+                fileName += ".aub";
+                OS().StartAubCapture(
+                    fileName,
+                    config().AubCaptureStartWait );
             }
+            log( "AubCapture started... maybe.  File name is: " + fileName + "\n" );
+
+            // No matter what, set the flag that aubcapture is started, so we
+            // don't try again.
+            m_AubCaptureStarted = true;
         }
     }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::addMapPointer(
-    const void* ptr,
-    const cl_map_flags flags,
-    const size_t size )
+void CLIntercept::stopAubCapture(
+    cl_command_queue command_queue )
 {
-    if( ptr )
+    if( m_AubCaptureStarted == true )
     {
         std::lock_guard<std::mutex> lock(m_Mutex);
 
-        if( m_MapPointerInfoMap.find(ptr) != m_MapPointerInfoMap.end() )
-        {
-            log( "Ignoring duplicate mapped pointer.\n" );
-        }
-        else
+        if( m_AubCaptureStarted == true )
         {
-            SMapPointerInfo&    mapPointerInfo = m_MapPointerInfoMap[ptr];
+            if( command_queue )
+            {
+                dispatch().clFinish( command_queue );
+            }
 
-            mapPointerInfo.Flags = flags;
-            mapPointerInfo.Size = size;
+#if defined(_WIN32)
+            if( m_Config.AubCaptureKDC )
+            {
+                OS().StopAubCaptureKDC(
+                    config().AubCaptureEndWait );
+            }
+            else
+#endif
+            {
+                OS().StopAubCapture(
+                    config().AubCaptureEndWait );
+            }
+            log( "AubCapture stopped.\n" );
+
+            // No matter what, clar the flag that aubcapture is started, so we
+            // don't try again.
+            m_AubCaptureStarted = false;
         }
     }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::removeMapPointer(
-    const void* ptr )
+// Creates and builds a kernel override program for one device, or for all of
+// the devices in the context if the device is NULL.  If enabled, program
+// binaries are cached, so subsequent runs can skip compiling the program.
+cl_program CLIntercept::createKernelOverrideProgram(
+    const cl_context context,
+    const cl_device_id device,
+    const char* programString,
+    size_t programStringLength,
+    const char* options,
+    cl_int& errorCode )
 {
-    if( ptr )
+    // We're already in a critical section when we get here, so we don't need to
+    // grab the critical section again.
+
+    cl_program  program = NULL;
+
+    errorCode = CL_SUCCESS;
+
+    std::vector<cl_device_id>   devices;
+    if( device )
     {
-        std::lock_guard<std::mutex> lock(m_Mutex);
-        m_MapPointerInfoMap.erase(ptr);
+        devices.push_back( device );
+    }
+    else
+    {
+        cl_uint numDevices = 0;
+        errorCode = dispatch().clGetContextInfo(
+            context,
+            CL_CONTEXT_NUM_DEVICES,
+            sizeof( numDevices ),
+            &numDevices,
+            NULL );
+        if( errorCode == CL_SUCCESS && numDevices != 0 )
+        {
+            devices.resize( numDevices );
+            errorCode = dispatch().clGetContextInfo(
+                context,
+                CL_CONTEXT_DEVICES,
+                numDevices * sizeof( cl_device_id ),
+                devices.data(),
+                NULL );
+        }
+        if( errorCode == CL_SUCCESS && numDevices == 0 )
+        {
+            errorCode = CL_INVALID_CONTEXT;
+        }
     }
-}
 
-///////////////////////////////////////////////////////////////////////////////
-//
-void CLIntercept::checkEventList(
-    const char* functionName,
-    cl_uint numEvents,
-    const cl_event* eventList,
-    cl_event* event )
-{
-    if( numEvents != 0 && eventList == NULL )
+    const uint64_t  optionsHash = options ?
+        computeHash( options, strlen(options) ) :
+        0;
+
+    std::string fileName;
+    if( errorCode == CL_SUCCESS &&
+        config().CacheKernelOverrideBinaries )
+    {
+        getProgramBinaryCacheFileName(
+            computeHash( programString, programStringLength ),
+            optionsHash,
+            (cl_uint)devices.size(),
+            devices.data(),
+            fileName );
+
+        bool    removed = false;
+        program = readProgramBinaryCacheFile(
+            fileName,
+            context,
+            (cl_uint)devices.size(),
+            devices.data(),
+            optionsHash,
+            removed );
+
+        // Programs created from binaries still need to be built.  If this
+        // fails, build the program from source instead.
+        if( program &&
+            dispatch().clBuildProgram(
+                program,
+                (cl_uint)devices.size(),
+                devices.data(),
+                options,
+                NULL,
+                NULL ) != CL_SUCCESS )
+        {
+            dispatch().clReleaseProgram( program );
+            program = NULL;
+            removed = true;
+            std::remove( fileName.c_str() );
+        }
+        if( program )
+        {
+            log( "Program binary cache hit: " + fileName + "\n" );
+            return program;
+        }
+        if( removed )
+        {
+            log( "Removing invalid program binary cache file: " + fileName + "\n" );
+        }
+    }
+
+    // Create the program:
+    if( errorCode == CL_SUCCESS )
     {
-        std::lock_guard<std::mutex> lock(m_Mutex);
-        logf( "Check Events for %s: Num Events is %u, but Event List is NULL!\n",
-            functionName,
-            numEvents );
+        program = dispatch().clCreateProgramWithSource(
+            context,
+            1,
+            &programString,
+            &programStringLength,
+            &errorCode );
     }
-    else
+
+    // Build the program:
+    if( errorCode == CL_SUCCESS )
     {
-        for( cl_uint i = 0; i < numEvents; i++ )
+        errorCode = dispatch().clBuildProgram(
+            program,
+            (cl_uint)devices.size(),
+            devices.data(),
+            options,
+            NULL,
+            NULL );
+
+        if( errorCode != CL_SUCCESS )
         {
-            if( event != NULL && *event == eventList[i] )
+            for( size_t i = 0; i < devices.size(); i++ )
             {
-                std::lock_guard<std::mutex> lock(m_Mutex);
-                logf( "Check Events for %s: outgoing event %p is also in the event wait list!\n",
-                    functionName,
-                    eventList[i] );
-                continue;
-            }
+                size_t  buildLogSize = 0;
+                dispatch().clGetProgramBuildInfo(
+                    program,
+                    devices[ i ],
+                    CL_PROGRAM_BUILD_LOG,
+                    0,
+                    NULL,
+                    &buildLogSize );
 
-            cl_int  eventCommandExecutionStatus = 0;
-            cl_int  errorCode = dispatch().clGetEventInfo(
-                eventList[i],
-                CL_EVENT_COMMAND_EXECUTION_STATUS,
-                sizeof(eventCommandExecutionStatus),
-                &eventCommandExecutionStatus,
-                NULL );
-            if( errorCode != CL_SUCCESS )
-            {
-                std::lock_guard<std::mutex> lock(m_Mutex);
-                logf( "Check Events for %s: clGetEventInfo for wait event %p returned %s (%d)!\n",
-                    functionName,
-                    eventList[i],
-                    enumName().name(errorCode).c_str(),
-                    errorCode );
+                char*   buildLog = new char[ buildLogSize + 1 ];
+                if( buildLog )
+                {
+                    dispatch().clGetProgramBuildInfo(
+                        program,
+                        devices[ i ],
+                        CL_PROGRAM_BUILD_LOG,
+                        buildLogSize * sizeof( char ),
+                        buildLog,
+                        NULL );
+
+                    buildLog[ buildLogSize ] = '\0';
+
+                    log( "-------> Start of Build Log:\n" );
+                    log( buildLog );
+                    log( "<------- End of Build Log!\n" );
+
+                    delete [] buildLog;
+                }
             }
-            else if( eventCommandExecutionStatus < 0 )
-            {
-                std::lock_guard<std::mutex> lock(m_Mutex);
-                logf( "Check Events for %s: wait event %p is in an error state (%d)!\n",
-                    functionName,
-                    eventList[i],
-                    eventCommandExecutionStatus );
+        }
+        else if( fileName.empty() == false &&
+                 writeProgramBinaryCacheFile(
+                    fileName,
+                    program,
+                    optionsHash ) )
+        {
+            log( "Stored program binary cache file: " + fileName + "\n" );
+
+            size_t  evicted = trimProgramBinaryCache(
+                fileName.substr( 0, fileName.find_last_of( '/' ) ) );
+            if( evicted )
+            {
+                logf( "Evicted %zu program binary cache file(s).\n", evicted );
             }
         }
     }
+
+    return program;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::checkKernelArgUSMPointer(
-    cl_kernel kernel,
-    const void* arg )
+// Builds the precompiled kernel overrides for this command queue, if they
+// have not been built yet, so the build and the buffer override benchmark
+// are not included in the timing for the first overridden enqueue.
+void CLIntercept::prepareKernelOverrides(
+    const cl_command_queue queue )
 {
     std::lock_guard<std::mutex> lock(m_Mutex);
 
-    cl_int errorCode = CL_SUCCESS;
+    cl_context  context = NULL;
+    if( dispatch().clGetCommandQueueInfo(
+            queue,
+            CL_QUEUE_CONTEXT,
+            sizeof( context ),
+            &context,
+            NULL ) == CL_SUCCESS )
+    {
+        getPrecompiledKernelOverrides( context, queue );
+    }
+}
 
-    cl_platform_id  platform = getPlatform(kernel);
+///////////////////////////////////////////////////////////////////////////////
+//
+// Gets the precompiled kernel overrides for the device associated with this
+// command queue, building them if this is the first time they are needed.
+CLIntercept::SPrecompiledKernelOverrides* CLIntercept::getPrecompiledKernelOverrides(
+    const cl_context context,
+    const cl_command_queue queue )
+{
+    // We're already in a critical section when we get here, so we don't need to
+    // grab the critical section again.
 
-    // If we don't have a function pointer for clGetMemAllocINFO, try to
-    // get one.  It's possible that the function pointer exists but
-    // the application hasn't queried for it yet, in which case it won't
-    // be installed into the dispatch table.
-    if( dispatchX(platform).clGetMemAllocInfoINTEL == NULL )
+    cl_device_id    device = NULL;
+    if( dispatch().clGetCommandQueueInfo(
+            queue,
+            CL_QUEUE_DEVICE,
+            sizeof( device ),
+            &device,
+            NULL ) != CL_SUCCESS )
     {
-        getExtensionFunctionAddress(
-            platform,
-            "clGetMemAllocInfoINTEL" );
+        return NULL;
     }
 
-    const auto& dispatchX = this->dispatchX(platform);
-    if( dispatchX.clGetMemAllocInfoINTEL == NULL )
+    const CKernelOverridesKey   key( context, device );
+
+    CPrecompiledKernelOverridesMap::iterator iter =
+        m_PrecompiledKernelOverridesMap.find( key );
+    if( iter != m_PrecompiledKernelOverridesMap.end() )
     {
-        logf( "function pointer for clGetMemAllocInfoINTEL is NULL\n" );
+        return iter->second;
     }
-    else if( arg == NULL )
+
+    SPrecompiledKernelOverrides*    pOverrides =
+        initPrecompiledKernelOverrides( context, device );
+    m_PrecompiledKernelOverridesMap[ key ] = pOverrides;
+
+    // The benchmark uses the override kernels, so it must run after the
+    // overrides have been added to the map.
+    if( pOverrides &&
+        config().OverrideBufferBenchmark &&
+        pOverrides->Kernel_CopyBufferAlignedUInt4s != NULL )
     {
-        logf( "mem pointer %p is NULL\n", arg );
+        benchmarkCopyBufferOverrides(
+            context,
+            device,
+            pOverrides );
     }
-    else
+
+    return pOverrides;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+CLIntercept::SPrecompiledKernelOverrides* CLIntercept::initPrecompiledKernelOverrides(
+    const cl_context context,
+    const cl_device_id device )
+{
+    // We're already in a critical section when we get here, so we don't need to
+    // grab the critical section again.
+
+    log( "Initializing precompiled kernel overrides...\n" );
+
+    cl_int  errorCode = CL_SUCCESS;
+
+    // Allocate new overrides.
+    SPrecompiledKernelOverrides*    pOverrides = new SPrecompiledKernelOverrides;
+    if( pOverrides )
     {
-        cl_context  context = NULL;
+        pOverrides->Program = NULL;
+
+        pOverrides->Kernel_CopyBufferBytes = NULL;
+        pOverrides->Kernel_CopyBufferAlignedUInts = NULL;
+        pOverrides->Kernel_CopyBufferAlignedUInt4s = NULL;
+        pOverrides->Kernel_CopyBufferUnalignedUChar16s = NULL;
+        pOverrides->Kernel_CopyBufferRect = NULL;
+
+        pOverrides->Kernel_CopyImage2Dto2DFloat = NULL;
+        pOverrides->Kernel_CopyImage2Dto2DInt = NULL;
+        pOverrides->Kernel_CopyImage2Dto2DUInt = NULL;
+        pOverrides->Kernel_CopyImage2Dto3DFloat = NULL;
+        pOverrides->Kernel_CopyImage2Dto3DInt = NULL;
+        pOverrides->Kernel_CopyImage2Dto3DUInt = NULL;
+        pOverrides->Kernel_CopyImage3Dto2DFloat = NULL;
+        pOverrides->Kernel_CopyImage3Dto2DInt = NULL;
+        pOverrides->Kernel_CopyImage3Dto2DUInt = NULL;
+        pOverrides->Kernel_CopyImage3Dto3DFloat = NULL;
+        pOverrides->Kernel_CopyImage3Dto3DInt = NULL;
+        pOverrides->Kernel_CopyImage3Dto3DUInt = NULL;
+
+        const char* pProgramString = NULL;
+        size_t  programStringLength = 0;
+
+        // Get the precompiled kernel string.
         if( errorCode == CL_SUCCESS )
         {
-            errorCode = dispatch().clGetKernelInfo(
-                kernel,
-                CL_KERNEL_CONTEXT,
-                sizeof(context),
-                &context,
-                NULL );
+            if( m_OS.GetPrecompiledKernelString(
+                    pProgramString,
+                    programStringLength ) == false )
+            {
+                errorCode = CL_INVALID_VALUE;
+            }
         }
 
+        // Create and build the program:
         if( errorCode == CL_SUCCESS )
         {
-            cl_unified_shared_memory_type_intel memType = CL_MEM_TYPE_UNKNOWN_INTEL;
-            cl_device_id associatedDevice = NULL;
-
-            dispatchX.clGetMemAllocInfoINTEL(
-                context,
-                arg,
-                CL_MEM_ALLOC_TYPE_INTEL,
-                sizeof(memType),
-                &memType,
-                NULL );
-            dispatchX.clGetMemAllocInfoINTEL(
+            pOverrides->Program = createKernelOverrideProgram(
                 context,
-                arg,
-                CL_MEM_ALLOC_DEVICE_INTEL,
-                sizeof(associatedDevice),
-                &associatedDevice,
-                NULL );
+                device,
+                pProgramString,
+                programStringLength,
+                NULL,
+                errorCode );
+        }
 
-            char* deviceName = NULL;
-            if( associatedDevice )
-            {
-                allocateAndGetDeviceInfoString(
-                    associatedDevice,
-                    CL_DEVICE_NAME,
-                    deviceName );
-            }
+        // Create all of the kernels in the program:
 
-            if( memType == CL_MEM_TYPE_DEVICE_INTEL )
+        if( config().OverrideReadBuffer ||
+            config().OverrideWriteBuffer ||
+            config().OverrideCopyBuffer )
+        {
+            if( errorCode == CL_SUCCESS )
             {
-                if( deviceName )
-                {
-                    logf( "mem pointer %p is a DEVICE pointer associated with device %s\n",
-                        arg,
-                        deviceName );
-                }
-                else if( associatedDevice )
-                {
-                    logf( "mem pointer %p is a DEVICE pointer associated with device %p\n",
-                        arg,
-                        associatedDevice );
-                }
-                else
-                {
-                    CLI_ASSERT( 0 );
-                    logf( "mem pointer %p is a DEVICE pointer without an associated device???\n",
-                        arg );
-                }
+                pOverrides->Kernel_CopyBufferBytes = dispatch().clCreateKernel(
+                    pOverrides->Program,
+                    "CopyBufferBytes",
+                    &errorCode );
             }
-            else if( memType == CL_MEM_TYPE_HOST_INTEL )
+            if( errorCode == CL_SUCCESS )
             {
-                logf( "mem pointer %p is a HOST pointer\n",
-                    arg );
+                pOverrides->Kernel_CopyBufferAlignedUInts = dispatch().clCreateKernel(
+                    pOverrides->Program,
+                    "CopyBufferAlignedUInts",
+                    &errorCode );
             }
-            else if( memType == CL_MEM_TYPE_SHARED_INTEL )
+            if( errorCode == CL_SUCCESS )
             {
-                if( deviceName )
-                {
-                    logf( "mem pointer %p is a SHARED pointer associated with device %s\n",
-                        arg,
-                        deviceName );
-                }
-                else if( associatedDevice )
-                {
-                    logf( "mem pointer %p is a SHARED pointer associated with device %p\n",
-                        arg,
-                        associatedDevice );
-                }
-                else
-                {
-                    logf( "mem pointer %p is a SHARED pointer without an associated device\n",
-                        arg );
-                }
+                pOverrides->Kernel_CopyBufferAlignedUInt4s = dispatch().clCreateKernel(
+                    pOverrides->Program,
+                    "CopyBufferAlignedUInt4s",
+                    &errorCode );
             }
-            else if( memType == CL_MEM_TYPE_UNKNOWN_INTEL )
+            if( errorCode == CL_SUCCESS )
             {
-                // This could be a system shared USM pointer, or this could be an error.
-                // Check the devices associated with this kernel to see if any support
-                // system shared USM allocations.
-                cl_program  program = NULL;
-                if( errorCode == CL_SUCCESS )
-                {
-                    errorCode = dispatch().clGetKernelInfo(
-                        kernel,
-                        CL_KERNEL_PROGRAM,
-                        sizeof(program),
-                        &program,
-                        NULL );
-                }
-
-                cl_uint         numDevices = 0;
-                cl_device_id*   deviceList = NULL;
-                if( errorCode == CL_SUCCESS )
-                {
-                    errorCode = allocateAndGetProgramDeviceList(
-                        program,
-                        numDevices,
-                        deviceList );
-                }
+                pOverrides->Kernel_CopyBufferUnalignedUChar16s = dispatch().clCreateKernel(
+                    pOverrides->Program,
+                    "CopyBufferUnalignedUChar16s",
+                    &errorCode );
+            }
+        }
 
-                if( errorCode == CL_SUCCESS )
-                {
-                    bool supportsSystemSharedUSM = false;
-                    for( cl_uint d = 0; d < numDevices; d++ )
-                    {
-                        cl_device_unified_shared_memory_capabilities_intel usmCaps = 0;
-                        dispatch().clGetDeviceInfo(
-                            deviceList[d],
-                            CL_DEVICE_SHARED_SYSTEM_MEM_CAPABILITIES_INTEL,
-                            sizeof(usmCaps),
-                            &usmCaps,
-                            NULL);
-                        if( usmCaps != 0 )
-                        {
-                            supportsSystemSharedUSM = true;
-                            break;
-                        }
-                    }
+        if( config().OverrideCopyBufferRect )
+        {
+            if( errorCode == CL_SUCCESS )
+            {
+                pOverrides->Kernel_CopyBufferRect = dispatch().clCreateKernel(
+                    pOverrides->Program,
+                    "CopyBufferRect",
+                    &errorCode );
+            }
+        }
 
-                    if( supportsSystemSharedUSM )
-                    {
-                        logf( "mem pointer %p is an UNKNOWN pointer and could be a shared system pointer\n",
-                            arg );
-                    }
-                    else
-                    {
-                        logf( "mem pointer %p is an UNKNOWN pointer and no device support shared system pointers!\n",
-                            arg );
-                    }
-                }
-                else
-                {
-                    logf( "mem pointer %p is an UNKNOWN pointer and additional queries returned an error!\n",
-                        arg );
-                }
+        if( config().OverrideReadImage ||
+            config().OverrideWriteImage ||
+            config().OverrideCopyImage )
+        {
+            // TODO: Check to see if images are supported?
+            //       What should happen if this is a multiple-device context,
+            //       and one device supports images, but another doesn't?
 
-                delete [] deviceList;
+            if( errorCode == CL_SUCCESS )
+            {
+                pOverrides->Kernel_CopyImage2Dto2DFloat = dispatch().clCreateKernel(
+                    pOverrides->Program,
+                    "CopyImage2Dto2DFloat",
+                    &errorCode );
             }
-            else
+            if( errorCode == CL_SUCCESS )
             {
-                CLI_ASSERT( 0 );
-                logf( "query for mem pointer %p returned an unknown memory type %08X!\n",
-                    arg,
-                    memType );
+                pOverrides->Kernel_CopyImage2Dto2DInt = dispatch().clCreateKernel(
+                    pOverrides->Program,
+                    "CopyImage2Dto2DInt",
+                    &errorCode );
+            }
+            if( errorCode == CL_SUCCESS )
+            {
+                pOverrides->Kernel_CopyImage2Dto2DUInt = dispatch().clCreateKernel(
+                    pOverrides->Program,
+                    "CopyImage2Dto2DUInt",
+                    &errorCode );
             }
 
-            delete [] deviceName;
+            // The 3D image kernels are optional.  The 3D to 2D kernels
+            // should always exist, but the kernels that write to 3D images
+            // are only compiled if the 3D image writes extension is
+            // supported.  If these kernels do not exist, then copies
+            // involving 3D images will fail.
+            if( errorCode == CL_SUCCESS )
+            {
+                cl_int  tempErrorCode = CL_SUCCESS;
+
+                pOverrides->Kernel_CopyImage3Dto2DFloat = dispatch().clCreateKernel(
+                    pOverrides->Program,
+                    "CopyImage3Dto2DFloat",
+                    &tempErrorCode );
+                pOverrides->Kernel_CopyImage3Dto2DInt = dispatch().clCreateKernel(
+                    pOverrides->Program,
+                    "CopyImage3Dto2DInt",
+                    &tempErrorCode );
+                pOverrides->Kernel_CopyImage3Dto2DUInt = dispatch().clCreateKernel(
+                    pOverrides->Program,
+                    "CopyImage3Dto2DUInt",
+                    &tempErrorCode );
+
+                pOverrides->Kernel_CopyImage2Dto3DFloat = dispatch().clCreateKernel(
+                    pOverrides->Program,
+                    "CopyImage2Dto3DFloat",
+                    &tempErrorCode );
+                pOverrides->Kernel_CopyImage2Dto3DInt = dispatch().clCreateKernel(
+                    pOverrides->Program,
+                    "CopyImage2Dto3DInt",
+                    &tempErrorCode );
+                pOverrides->Kernel_CopyImage2Dto3DUInt = dispatch().clCreateKernel(
+                    pOverrides->Program,
+                    "CopyImage2Dto3DUInt",
+                    &tempErrorCode );
+
+                pOverrides->Kernel_CopyImage3Dto3DFloat = dispatch().clCreateKernel(
+                    pOverrides->Program,
+                    "CopyImage3Dto3DFloat",
+                    &tempErrorCode );
+                pOverrides->Kernel_CopyImage3Dto3DInt = dispatch().clCreateKernel(
+                    pOverrides->Program,
+                    "CopyImage3Dto3DInt",
+                    &tempErrorCode );
+                pOverrides->Kernel_CopyImage3Dto3DUInt = dispatch().clCreateKernel(
+                    pOverrides->Program,
+                    "CopyImage3Dto3DUInt",
+                    &tempErrorCode );
+
+                if( pOverrides->Kernel_CopyImage3Dto3DUInt == NULL )
+                {
+                    log( "Kernels that write to 3D images are not supported.\n" );
+                }
+            }
         }
-        else
+
+        if( errorCode != CL_SUCCESS )
         {
-            logf( "couldn't query context for kernel %p for mem pointer %p!\n",
-                kernel,
-                arg );
+            delete pOverrides;
+            pOverrides = NULL;
         }
     }
+
+    log( "... precompiled kernel override initialization complete.\n" );
+
+    return pOverrides;
 }
 
+// The copy sizes timed by the copy buffer benchmark.  Copies are assigned
+// to the smallest benchmarked size that is at least as big as the copy, or
+// to the largest benchmarked size.
+static const size_t cCopyBufferBenchmarkSizes[] =
+{
+    4 * 1024,
+    64 * 1024,
+    1024 * 1024,
+    16 * 1024 * 1024,
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 //
-bool CLIntercept::checkRelaxAllocationLimitsSupport(
-    cl_program program ) const
+void CLIntercept::benchmarkCopyBufferOverrides(
+    const cl_context context,
+    const cl_device_id device,
+    SPrecompiledKernelOverrides* pOverrides )
 {
+    // We're already in a critical section when we get here, so we don't need to
+    // grab the critical section again.
+
+    const size_t    numSizes =
+        sizeof(cCopyBufferBenchmarkSizes) / sizeof(cCopyBufferBenchmarkSizes[0]);
+    const size_t    maxSize = cCopyBufferBenchmarkSizes[ numSizes - 1 ];
+    const cl_uint   numIterations = 5;
+
     cl_int  errorCode = CL_SUCCESS;
-    bool    supported = true;
 
-    cl_uint         numDevices = 0;
-    cl_device_id*   deviceList = NULL;
+    cl_command_queue    queue = dispatch().clCreateCommandQueue(
+        context,
+        device,
+        CL_QUEUE_PROFILING_ENABLE,
+        &errorCode );
+
+    cl_mem  srcBuffer = NULL;
+    cl_mem  dstBuffer = NULL;
     if( errorCode == CL_SUCCESS )
     {
-        errorCode = allocateAndGetProgramDeviceList(
-            program,
-            numDevices,
-            deviceList );
+        srcBuffer = dispatch().clCreateBuffer(
+            context,
+            CL_MEM_READ_WRITE,
+            maxSize,
+            NULL,
+            &errorCode );
     }
-
     if( errorCode == CL_SUCCESS )
     {
-        supported = checkRelaxAllocationLimitsSupport(
-            numDevices,
-            deviceList );
+        dstBuffer = dispatch().clCreateBuffer(
+            context,
+            CL_MEM_READ_WRITE,
+            maxSize,
+            NULL,
+            &errorCode );
     }
 
-    delete [] deviceList;
-
-    return ( errorCode == CL_SUCCESS ) && supported;
-}
+    // Returns the minimum device time for a copy of the given size, in
+    // nanoseconds, after one untimed warmup copy.
+    auto timeCopy = [&]( bool native, size_t size ) -> cl_ulong {
+        cl_ulong    minNS = CL_ULONG_MAX;
+        for( cl_uint i = 0; i <= numIterations && errorCode == CL_SUCCESS; i++ )
+        {
+            cl_event    event = NULL;
+            if( native )
+            {
+                errorCode = dispatch().clEnqueueCopyBuffer(
+                    queue,
+                    srcBuffer,
+                    dstBuffer,
+                    0,
+                    0,
+                    size,
+                    0,
+                    NULL,
+                    &event );
+            }
+            else
+            {
+                errorCode = CopyBufferHelper(
+                    context,
+                    queue,
+                    srcBuffer,
+                    dstBuffer,
+                    0,
+                    0,
+                    size,
+                    0,
+                    NULL,
+                    &event );
+            }
+            if( errorCode == CL_SUCCESS )
+            {
+                errorCode = dispatch().clWaitForEvents( 1, &event );
+            }
 
-///////////////////////////////////////////////////////////////////////////////
-//
-bool CLIntercept::checkRelaxAllocationLimitsSupport(
-    cl_uint numDevices,
-    const cl_device_id* deviceList ) const
-{
-    cl_int  errorCode = CL_SUCCESS;
-    bool    supported = true;
+            cl_ulong    start = 0;
+            cl_ulong    end = 0;
+            if( errorCode == CL_SUCCESS )
+            {
+                errorCode |= dispatch().clGetEventProfilingInfo(
+                    event,
+                    CL_PROFILING_COMMAND_START,
+                    sizeof( start ),
+                    &start,
+                    NULL );
+                errorCode |= dispatch().clGetEventProfilingInfo(
+                    event,
+                    CL_PROFILING_COMMAND_END,
+                    sizeof( end ),
+                    &end,
+                    NULL );
+            }
+            if( errorCode == CL_SUCCESS && i != 0 )
+            {
+                minNS = std::min( minNS, end - start );
+            }
 
-    // For now, check for Intel GPU devices to determine whether relaxed
-    // allocations are supported.  Eventually this can be checked using
-    // formal mechanisms.
+            if( event )
+            {
+                dispatch().clReleaseEvent( event );
+            }
+        }
+        return minNS;
+    };
 
-    for( cl_uint i = 0; i < numDevices; i++ )
+    std::vector<bool>   useNative( numSizes, false );
+    if( errorCode == CL_SUCCESS )
     {
-        cl_device_type  deviceType = 0;
-        cl_uint deviceVendorId;
-
-        errorCode |= dispatch().clGetDeviceInfo(
-            deviceList[ i ],
-            CL_DEVICE_TYPE,
-            sizeof( deviceType ),
-            &deviceType,
-            NULL );
-        errorCode |= dispatch().clGetDeviceInfo(
-            deviceList[ i ],
-            CL_DEVICE_VENDOR_ID,
-            sizeof( deviceVendorId ),
-            &deviceVendorId,
-            NULL );
-        if( ( deviceType & CL_DEVICE_TYPE_GPU ) == 0 ||
-            deviceVendorId != 0x8086 )
+        log( "Copy Buffer Override Benchmark:\n" );
+        log( "        Size,  Native (ns),  Kernel (ns),  Using\n" );
+        for( size_t i = 0; i < numSizes && errorCode == CL_SUCCESS; i++ )
         {
-            supported = false;
-            break;
+            const size_t    size = cCopyBufferBenchmarkSizes[ i ];
+            cl_ulong    nativeNS = timeCopy( true, size );
+            cl_ulong    kernelNS = timeCopy( false, size );
+            if( errorCode == CL_SUCCESS )
+            {
+                useNative[ i ] = nativeNS < kernelNS;
+                logf( "%12zu, %12llu, %12llu,  %s\n",
+                    size,
+                    (unsigned long long)nativeNS,
+                    (unsigned long long)kernelNS,
+                    useNative[ i ] ? "Native" : "Kernel" );
+            }
         }
     }
 
-    return ( errorCode == CL_SUCCESS ) && supported;
+    if( errorCode == CL_SUCCESS )
+    {
+        pOverrides->UseNativeCopyBuffer = useNative;
+    }
+    else
+    {
+        logf( "Copy buffer override benchmark failed: %s (%i)\n",
+            enumName().name( errorCode ).c_str(),
+            errorCode );
+    }
+
+    if( srcBuffer )
+    {
+        dispatch().clReleaseMemObject( srcBuffer );
+    }
+    if( dstBuffer )
+    {
+        dispatch().clReleaseMemObject( dstBuffer );
+    }
+    if( queue )
+    {
+        dispatch().clReleaseCommandQueue( queue );
+    }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::usmAllocPropertiesOverride(
-    const cl_mem_properties_intel* properties,
-    cl_mem_properties_intel*& pLocalAllocProperties ) const
+CLIntercept::SBuiltinKernelOverrides* CLIntercept::initBuiltinKernelOverrides(
+    const cl_context context,
+    const cl_device_id device )
 {
-    const cl_mem_flags CL_MEM_ALLOW_UNRESTRICTED_SIZE_INTEL = (1 << 23);
+    // We're already in a critical section when we get here, so we don't need to
+    // grab the critical section again.
 
-    bool    addMemFlagsEnum = config().RelaxAllocationLimits != 0;
+    log( "Initializing builtin kernel overrides...\n" );
 
-    size_t  numProperties = 0;
-    if( properties )
-    {
-        while( properties[ numProperties ] != 0 )
-        {
-            switch( properties[ numProperties ] )
-            {
-            case CL_MEM_FLAGS:
-                addMemFlagsEnum = false;
-                break;
-            default:
-                break;
-            }
-            numProperties += 2;
-        }
-    }
+    cl_int  errorCode = CL_SUCCESS;
 
-    if( addMemFlagsEnum )
+    // Allocate new overrides.
+    SBuiltinKernelOverrides*    pOverrides = new SBuiltinKernelOverrides;
+    if( pOverrides )
     {
-        numProperties += 2;
-    }
+        pOverrides->Program = NULL;
 
-    // Allocate a new array of properties.  We need to allocate two
-    // properties for each pair, plus one property for the terminating
-    // zero.
-    pLocalAllocProperties = new cl_queue_properties[ numProperties + 1 ];
-    if( pLocalAllocProperties )
-    {
-        // Copy the old properties array to the new properties array,
-        // if the new properties array exists.
-        numProperties = 0;
-        if( properties )
-        {
-            while( properties[ numProperties ] != 0 )
-            {
-                pLocalAllocProperties[ numProperties ] = properties[ numProperties ];
-                if( properties[ numProperties ] == CL_MEM_FLAGS )
-                {
-                    CLI_ASSERT( addMemFlagsEnum == false );
+        pOverrides->Kernel_block_motion_estimate_intel = NULL;
 
-                    cl_mem_properties_intel flags = properties[ numProperties + 1 ];
-                    if( config().RelaxAllocationLimits )
-                    {
-                        flags |= CL_MEM_ALLOW_UNRESTRICTED_SIZE_INTEL;
-                    }
+        const char* pProgramString = NULL;
+        size_t  programStringLength = 0;
 
-                    pLocalAllocProperties[ numProperties + 1 ] = flags;
-                }
-                else
-                {
-                    pLocalAllocProperties[ numProperties + 1 ] =
-                        properties[ numProperties + 1 ];
-                }
-                numProperties += 2;
-            }
-        }
-        if( addMemFlagsEnum )
+        // Get the builtin kernel program string.
+        if( errorCode == CL_SUCCESS )
         {
-            pLocalAllocProperties[ numProperties] = CL_MEM_FLAGS;
-
-            cl_mem_properties_intel flags = 0;
-            if( config().RelaxAllocationLimits )
+            if( m_OS.GetBuiltinKernelString(
+                    pProgramString,
+                    programStringLength ) == false )
             {
-                flags |= CL_MEM_ALLOW_UNRESTRICTED_SIZE_INTEL;
+                errorCode = CL_INVALID_VALUE;
             }
+        }
+
+        // Create and build the program:
+        if( errorCode == CL_SUCCESS )
+        {
+            pOverrides->Program = createKernelOverrideProgram(
+                context,
+                device,
+                pProgramString,
+                programStringLength,
+                "-Dcl_intel_device_side_vme_enable -DHW_NULL_CHECK",
+                errorCode );
+        }
 
-            pLocalAllocProperties[ numProperties + 1 ] = flags;
-            numProperties += 2;
+        // Create all of the kernels in the program:
+
+        if( errorCode == CL_SUCCESS )
+        {
+            pOverrides->Kernel_block_motion_estimate_intel = dispatch().clCreateKernel(
+                pOverrides->Program,
+                "block_motion_estimate_intel",
+                &errorCode );
         }
 
-        // Add the terminating zero.
-        pLocalAllocProperties[ numProperties ] = 0;
+        if( errorCode != CL_SUCCESS )
+        {
+            delete pOverrides;
+            pOverrides = NULL;
+        }
     }
+
+    log( "... builtin kernel override initialization complete.\n" );
+
+    return pOverrides;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::startCaptureReplay(
-    const uint64_t enqueueCounter,
-    const cl_kernel kernel,
-    const cl_uint workDim,
-    const size_t* gwo,
-    const size_t* gws,
-    const size_t* lws )
+cl_program CLIntercept::createProgramWithInjectionBinaries(
+    uint64_t hash,
+    cl_context context,
+    cl_int* errcode_ret )
 {
     std::lock_guard<std::mutex> lock(m_Mutex);
 
-    std::string fileNamePrefix = "";
+    cl_int      errorCode = CL_SUCCESS;
+    cl_program  program = NULL;
 
-    OS().GetDumpDirectoryName( sc_DumpDirectoryName, fileNamePrefix );
-    fileNamePrefix += "/Replay/Enqueue_";
-    fileNamePrefix += std::to_string(enqueueCounter);
-    fileNamePrefix += "_";
-    fileNamePrefix += getShortKernelName(kernel);
-    fileNamePrefix += "/";
+    std::string fileName1;
+    std::string fileName2;
+    size_t      numDevices = 0;
 
-    OS().MakeDumpDirectories( fileNamePrefix );
+    if( errorCode == CL_SUCCESS )
+    {
+        std::string fileName;
 
-    log( "Dumping kernel capture replay to directory: " + fileNamePrefix + "\n" );
+        // Get the dump directory name.
+        {
+            OS().GetDumpDirectoryNameWithoutPid( sc_DumpDirectoryName, fileName );
+            fileName += "/Inject";
+        }
+        // Make two candidate file names.  They will have the form:
+        //   CLI_<program number>_<hash>_0000, or
+        //   CLI_<hash>_0000
+        // Leave off the extension for now.
+        {
+            char    numberString1[256] = "";
+            CLI_SPRINTF( numberString1, 256, "%04u_%08X_0000",
+                m_ProgramNumber,
+                (unsigned int)hash );
 
-    const char* pPythonScript = NULL;
-    size_t pythonScriptLength = 0;
-    if( m_OS.GetReplayScriptString(
-            pPythonScript,
-            pythonScriptLength ) )
-    {
-        std::ofstream outputPythonScript{fileNamePrefix + "run.py", std::ios::out | std::ios::binary};
-        outputPythonScript.write(pPythonScript, pythonScriptLength);
-    }
+            char    numberString2[256] = "";
+            CLI_SPRINTF( numberString2, 256, "%08X_0000",
+                (unsigned int)hash );
 
-    {
-        std::ofstream outputKernelNumber{fileNamePrefix + "enqueueNumber.txt"};
-        outputKernelNumber << std::to_string(enqueueCounter) << '\n';
+            fileName1 = fileName;
+            fileName1 += "/CLI_";
+            fileName1 += numberString1;
+
+            fileName2 = fileName;
+            fileName2 += "/CLI_";
+            fileName2 += numberString2;
+        }
+
+        errorCode = dispatch().clGetContextInfo(
+            context,
+            CL_CONTEXT_DEVICES,
+            0,
+            NULL,
+            &numDevices );
     }
 
-    dumpCaptureReplayKernelSource( fileNamePrefix, kernel );
-    dumpCaptureReplayKernelInfo( fileNamePrefix, kernel, workDim, gwo, gws, lws );
-    dumpCaptureReplayKernelArguments( fileNamePrefix, kernel );
-}
+    cl_device_id*   devices = NULL;
 
-///////////////////////////////////////////////////////////////////////////////
-//
-void CLIntercept::startAubCapture(
-    const char* functionName,
-    const uint64_t enqueueCounter,
-    const cl_kernel kernel,
-    const cl_uint workDim,
-    const size_t* gws,
-    const size_t* lws,
-    cl_command_queue command_queue )
-{
-    if( m_AubCaptureStarted == false )
-    {
-        std::lock_guard<std::mutex> lock(m_Mutex);
+    char**          programBinaries = NULL;
+    size_t*         programBinarySizes = NULL;
 
-        // For kernels, perform aub capture skip checks.  We'll skip aubcapture if:
-        // - the current skip counter is less than the specified skip counter, or
-        // - the current capture counter is greater than or equal to the specified capture counter.
+    if( errorCode == CL_SUCCESS )
+    {
+        numDevices = numDevices / sizeof( cl_device_id );
 
-        bool    skip = false;
-        if( kernel != NULL )
-        {
-            if( m_AubCaptureKernelEnqueueSkipCounter < m_Config.AubCaptureNumKernelEnqueuesSkip )
-            {
-                //logf( "Skipping kernel aub capture: current skip counter is %u, requested skip counter is %u.\n",
-                //    m_AubCaptureKernelEnqueueSkipCounter,
-                //    m_Config.AubCaptureNumKernelEnqueuesSkip );
+        devices = new cl_device_id [ numDevices ];
 
-                skip = true;
-                ++m_AubCaptureKernelEnqueueSkipCounter;
-            }
-            else
-            {
-                if( m_AubCaptureKernelEnqueueCaptureCounter >= m_Config.AubCaptureNumKernelEnqueuesCapture )
-                {
-                    //logf( "Skipping kernel aub capture: current capture counter is %u, requested capture counter is %u.\n",
-                    //    m_AubCaptureKernelEnqueueCaptureCounter,
-                    //    m_Config.AubCaptureNumKernelEnqueuesCapture );
-                    skip = true;
-                }
+        programBinaries = new char*[ numDevices ];
+        programBinarySizes = new size_t[ numDevices ];
 
-                ++m_AubCaptureKernelEnqueueCaptureCounter;
-            }
+        if( ( devices == NULL ) ||
+            ( programBinaries == NULL ) ||
+            ( programBinarySizes == NULL ) )
+        {
+            CLI_ASSERT( 0 );
+            errorCode = CL_OUT_OF_HOST_MEMORY;
         }
+    }
 
-        if( skip == false &&
-            m_AubCaptureStarted == false )
+    if( errorCode == CL_SUCCESS )
+    {
+        for( size_t i = 0; i < numDevices; i++ )
         {
-            // Try to call clFinish() on the passed-in command queue.
-            // This isn't perfect, since we'd really rather call
-            // clFinish on all command queues to start with a fresh
-            // capture, but it's better than nothing.
-            // TODO: Is Flush() sufficient?
-            dispatch().clFinish( command_queue );
+            programBinaries[i] = NULL;
+        }
 
-            char    charBuf[ MAX_PATH ];
+        errorCode = dispatch().clGetContextInfo(
+            context,
+            CL_CONTEXT_DEVICES,
+            numDevices * sizeof( cl_device_id ),
+            devices,
+            NULL );
 
-            std::string fileName = "";
+        if( errorCode == CL_SUCCESS )
+        {
+            // Assume all binaries exist, until this is proven otherwise.
+            bool    allBinariesExist = true;
 
-            // Get the dump directory name.
+            for( size_t i = 0; i < numDevices; i++ )
             {
-                OS().GetDumpDirectoryName( sc_DumpDirectoryName, fileName );
-                fileName += "/";
-                fileName += "AubCapture";
-
-                if( m_Config.AubCaptureIndividualEnqueues )
-                {
-                    fileName += "_Enqueue_";
-
-                    CLI_SPRINTF( charBuf, MAX_PATH, "%08u", (cl_uint)enqueueCounter );
+                cl_device_type  deviceType = CL_DEVICE_TYPE_DEFAULT;
 
-                    fileName += charBuf;
-                    fileName += "_";
+                // It's OK if this fails.  If it does, it just
+                // means that our output file won't have a device
+                // type.
+                dispatch().clGetDeviceInfo(
+                    devices[ i ],
+                    CL_DEVICE_TYPE,
+                    sizeof( deviceType ),
+                    &deviceType,
+                    NULL );
 
-                    if( kernel )
-                    {
-                        const std::string& kernelName = getShortKernelName(kernel);
-                        fileName += "kernel_";
-                        fileName += kernelName;
+                std::string suffix;
 
-                        std::ostringstream  ss;
-                        ss << "_G_";
-                        if( gws )
-                        {
-                            if( workDim >= 1 )
-                            {
-                                ss << gws[0];
-                            }
-                            if( workDim >= 2 )
-                            {
-                                ss << "x" << gws[1];
-                            }
-                            if( workDim >= 3 )
-                            {
-                                ss << "x" << gws[2];
-                            }
-                        }
-                        else
-                        {
-                            ss << "NULL";
-                        }
-                        ss << "_L_";
-                        if( lws )
-                        {
-                            if( workDim >= 1 )
-                            {
-                                ss << lws[0];
-                            }
-                            if( workDim >= 2 )
-                            {
-                                ss << "x" << lws[1];
-                            }
-                            if( workDim >= 3 )
-                            {
-                                ss << "x" << lws[2];
-                            }
-                        }
-                        else
-                        {
-                            ss << "NULL";
-                        }
-                        fileName += ss.str();
+                if( deviceType & CL_DEVICE_TYPE_CPU )
+                {
+                    suffix += "_CPU";
+                }
+                if( deviceType & CL_DEVICE_TYPE_GPU )
+                {
+                    suffix += "_GPU";
+                }
+                if( deviceType & CL_DEVICE_TYPE_ACCELERATOR )
+                {
+                    suffix += "_ACC";
+                }
+                if( deviceType & CL_DEVICE_TYPE_CUSTOM )
+                {
+                    suffix += "_CUSTOM";
+                }
+
+                suffix += ".bin";
+
+                std::string inputFileName = fileName1 + suffix;
+
+                std::ifstream is;
+                openInjectionFile(
+                    inputFileName,
+                    is );
+                if( is.good() )
+                {
+                    log( "Injection binary file exists: " + inputFileName + "\n" );
+                }
+                else
+                {
+                    log( "Injection binary file doesn't exist: " + inputFileName + "\n" );
+
+                    inputFileName = fileName2 + suffix;
+                    is.clear();
+                    openInjectionFile(
+                        inputFileName,
+                        is );
+                    if( is.good() )
+                    {
+                        log( "Injection binary file exists: " + inputFileName + "\n" );
                     }
                     else
                     {
-                        fileName += functionName;
+                        log( "Injection binary file doesn't exist: " + inputFileName + "\n" );
                     }
                 }
-                else if( m_Config.AubCaptureMinEnqueue != 0 ||
-                         m_Config.AubCaptureMaxEnqueue != UINT_MAX )
-                {
-                    fileName += "_Enqueue_";
-
-                    CLI_SPRINTF( charBuf, MAX_PATH, "%08u", m_Config.AubCaptureMinEnqueue );
 
-                    fileName += charBuf;
-                    fileName += "_to_";
+                if( is.good() )
+                {
+                    // The file exists.  Figure out how big it is.
+                    is.seekg( 0, std::ios::end );
+                    programBinarySizes[i] = (size_t)is.tellg();
+                    is.seekg( 0, std::ios::beg );
 
-                    CLI_SPRINTF( charBuf, MAX_PATH, "%08u", m_Config.AubCaptureMaxEnqueue );
+                    programBinaries[i] = new char[ programBinarySizes[i] ];
+                    if( programBinaries[i] == NULL )
+                    {
+                        CLI_ASSERT( 0 );
+                        errorCode = CL_OUT_OF_HOST_MEMORY;
+                    }
+                    else
+                    {
+                        is.read( programBinaries[i],  programBinarySizes[i] );
+                    }
 
-                    fileName += charBuf;
+                    is.close();
+                }
+                else
+                {
+                    log( "Injection binary is missing!\n" );
+                    allBinariesExist = false;
                 }
             }
 
-            // Now make directories as appropriate.
+            if( allBinariesExist &&
+                ( errorCode == CL_SUCCESS ) )
             {
-                OS().MakeDumpDirectories( fileName );
-            }
+                log( "All injection binaries exist.\n" );
 
-#if defined(_WIN32)
-            if( m_Config.AubCaptureKDC )
-            {
-                fileName += ".daf";
-                OS().StartAubCaptureKDC(
-                    fileName,
-                    config().AubCaptureStartWait );
+                program = dispatch().clCreateProgramWithBinary(
+                    context,
+                    (cl_uint)numDevices,
+                    devices,
+                    programBinarySizes,
+                    (const unsigned char**)programBinaries,
+                    NULL,   // binary_status
+                    &errorCode );
+                if( program )
+                {
+                    logf("Injection successful: clCreateProgramWithBinary() returned %p\n",
+                        program );
+                }
+                if( errorCode != CL_SUCCESS )
+                {
+                    logf("Injecting binaries failed: clCreateProgramWithBinary() returned %s\n",
+                        enumName().name( errorCode ).c_str() );
+                }
             }
-            else
-#endif
+
+            for( size_t i = 0; i < numDevices; i++ )
             {
-                fileName += ".aub";
-                OS().StartAubCapture(
-                    fileName,
-                    config().AubCaptureStartWait );
-            }
-            log( "AubCapture started... maybe.  File name is: " + fileName + "\n" );
+                programBinarySizes[i] = 0;
 
-            // No matter what, set the flag that aubcapture is started, so we
-            // don't try again.
-            m_AubCaptureStarted = true;
+                delete [] programBinaries[i];
+                programBinaries[i] = NULL;
+            }
         }
     }
+
+    delete [] devices;
+
+    delete [] programBinaries;
+    delete [] programBinarySizes;
+
+    if( errcode_ret )
+    {
+        errcode_ret[0] = errorCode;
+    }
+
+    return program;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::stopAubCapture(
-    cl_command_queue command_queue )
+// Program binary cache files have the form:
+//   CLI_<program hash>_<options hash>_<device hash>.bin
+// where the device hash identifies the name, device version, and driver
+// version of each device.  The file contents are a small header followed by
+// the device binaries:
+//   char[8]    magic, "CLIPBC02"
+//   uint64_t   options hash
+//   uint64_t   number of devices
+//   uint64_t   binary size, for each device
+//   binary data, for each device
+static const char   sc_ProgramBinaryCacheMagic[8] =
+    { 'C', 'L', 'I', 'P', 'B', 'C', '0', '2' };
+
+void CLIntercept::getProgramBinaryCacheFileName(
+    uint64_t hash,
+    uint64_t optionsHash,
+    cl_uint numDevices,
+    const cl_device_id* devices,
+    std::string& fileName )
 {
-    if( m_AubCaptureStarted == true )
+    std::string deviceString;
+    for( cl_uint i = 0; i < numDevices; i++ )
     {
-        std::lock_guard<std::mutex> lock(m_Mutex);
-
-        if( m_AubCaptureStarted == true )
+        const cl_device_info    params[] = {
+            CL_DEVICE_NAME,
+            CL_DEVICE_VERSION,
+            CL_DRIVER_VERSION,
+        };
+        for( size_t p = 0; p < sizeof(params) / sizeof(params[0]); p++ )
         {
-            if( command_queue )
+            char*   str = NULL;
+            allocateAndGetDeviceInfoString(
+                devices[i],
+                params[p],
+                str );
+            if( str )
             {
-                dispatch().clFinish( command_queue );
+                deviceString += str;
             }
+            deviceString += '\n';
+            delete [] str;
+        }
+    }
 
-#if defined(_WIN32)
-            if( m_Config.AubCaptureKDC )
-            {
-                OS().StopAubCaptureKDC(
-                    config().AubCaptureEndWait );
-            }
-            else
-#endif
-            {
-                OS().StopAubCapture(
-                    config().AubCaptureEndWait );
-            }
-            log( "AubCapture stopped.\n" );
+    uint64_t    deviceHash = computeHash(
+        deviceString.c_str(),
+        deviceString.length() );
 
-            // No matter what, clar the flag that aubcapture is started, so we
-            // don't try again.
-            m_AubCaptureStarted = false;
-        }
+    if( config().ProgramBinaryCacheDir.empty() )
+    {
+        OS().GetDumpDirectoryNameWithoutPid( sc_DumpDirectoryName, fileName );
+        fileName += "/ProgramBinaryCache";
+    }
+    else
+    {
+        fileName = config().ProgramBinaryCacheDir;
     }
+
+    char    numberString[256] = "";
+    CLI_SPRINTF( numberString, 256, "%016" PRIX64 "_%016" PRIX64 "_%016" PRIX64,
+        hash,
+        optionsHash,
+        deviceHash );
+
+    fileName += "/CLI_";
+    fileName += numberString;
+    fileName += ".bin";
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::initPrecompiledKernelOverrides(
-    const cl_context context )
+// Creates a program from a program binary cache file, or returns NULL if the
+// cache file does not exist or cannot be used.  Unusable cache files are
+// removed, and removed is set to true.  This function does not log and does
+// not require the intercept mutex, so the file IO and program creation may be
+// done outside of the critical section.
+cl_program CLIntercept::readProgramBinaryCacheFile(
+    const std::string& fileName,
+    cl_context context,
+    cl_uint numDevices,
+    const cl_device_id* devices,
+    uint64_t optionsHash,
+    bool& removed ) const
 {
-    std::lock_guard<std::mutex> lock(m_Mutex);
-    log( "Initializing precompiled kernel overrides...\n" );
+    cl_int      errorCode = CL_SUCCESS;
+    cl_program  program = NULL;
 
-    cl_int  errorCode = CL_SUCCESS;
+    removed = false;
 
-    // Check to see if overrides already exist.  If they do, release them.
-    SPrecompiledKernelOverrides*    pOverrides =
-        m_PrecompiledKernelOverridesMap[ context ];
-    if( pOverrides )
+    size_t      fileSize = 0;
+    const char* fileData = (const char*)OS().MapFileForReading(
+        fileName,
+        fileSize );
+    if( fileData == NULL )
     {
-        errorCode = dispatch().clReleaseKernel( pOverrides->Kernel_CopyBufferBytes );
-        errorCode = dispatch().clReleaseKernel( pOverrides->Kernel_CopyBufferUInts );
-        errorCode = dispatch().clReleaseKernel( pOverrides->Kernel_CopyBufferUInt4s );
-        errorCode = dispatch().clReleaseKernel( pOverrides->Kernel_CopyBufferUInt16s );
-
-        errorCode = dispatch().clReleaseKernel( pOverrides->Kernel_CopyImage2Dto2DFloat );
-        errorCode = dispatch().clReleaseKernel( pOverrides->Kernel_CopyImage2Dto2DInt );
-        errorCode = dispatch().clReleaseKernel( pOverrides->Kernel_CopyImage2Dto2DUInt );
-
-        errorCode = dispatch().clReleaseProgram( pOverrides->Program );
-
-        delete pOverrides;
-        pOverrides = NULL;
-
-        m_PrecompiledKernelOverridesMap[ context ] = NULL;
+        return NULL;
     }
 
-    // Allocate new overrides.
-    pOverrides = new SPrecompiledKernelOverrides;
-    if( pOverrides )
-    {
-        pOverrides->Program = NULL;
-
-        pOverrides->Kernel_CopyBufferBytes = NULL;
-        pOverrides->Kernel_CopyBufferUInts = NULL;
-        pOverrides->Kernel_CopyBufferUInt4s = NULL;
-        pOverrides->Kernel_CopyBufferUInt16s = NULL;
+    // Parse and validate the header.
+    std::vector<size_t>         binarySizes( numDevices );
+    std::vector<const unsigned char*>   binaries( numDevices );
 
-        pOverrides->Kernel_CopyImage2Dto2DFloat = NULL;
-        pOverrides->Kernel_CopyImage2Dto2DInt = NULL;
-        pOverrides->Kernel_CopyImage2Dto2DUInt = NULL;
+    bool    valid = false;
+    size_t  offset = sizeof(sc_ProgramBinaryCacheMagic);
+    size_t  headerSize = offset + ( 2 + numDevices ) * sizeof(uint64_t);
+    if( fileSize >= headerSize &&
+        memcmp( fileData, sc_ProgramBinaryCacheMagic, offset ) == 0 )
+    {
+        uint64_t    fileOptionsHash = 0;
+        uint64_t    fileNumDevices = 0;
+        memcpy( &fileOptionsHash, fileData + offset, sizeof(uint64_t) );
+        offset += sizeof(uint64_t);
+        memcpy( &fileNumDevices, fileData + offset, sizeof(uint64_t) );
+        offset += sizeof(uint64_t);
 
-        const char* pProgramString = NULL;
-        size_t  programStringLength = 0;
+        valid =
+            ( fileOptionsHash == optionsHash ) &&
+            ( fileNumDevices == numDevices );
 
-        // Get the precompiled kernel string.
-        if( errorCode == CL_SUCCESS )
+        size_t  dataOffset = headerSize;
+        for( size_t i = 0; valid && i < numDevices; i++ )
         {
-            if( m_OS.GetPrecompiledKernelString(
-                    pProgramString,
-                    programStringLength ) == false )
+            uint64_t    size = 0;
+            memcpy( &size, fileData + offset, sizeof(uint64_t) );
+            offset += sizeof(uint64_t);
+
+            valid = ( size != 0 ) && ( size <= fileSize - dataOffset );
+            if( valid )
             {
-                errorCode = CL_INVALID_VALUE;
+                binarySizes[i] = (size_t)size;
+                binaries[i] = (const unsigned char*)fileData + dataOffset;
+                dataOffset += (size_t)size;
             }
         }
+    }
 
-        // Create the program:
-        if( errorCode == CL_SUCCESS )
+    if( valid )
+    {
+        std::vector<cl_int> binaryStatus( numDevices, CL_SUCCESS );
+        program = dispatch().clCreateProgramWithBinary(
+            context,
+            (cl_uint)numDevices,
+            devices,
+            binarySizes.data(),
+            binaries.data(),
+            binaryStatus.data(),
+            &errorCode );
+        if( errorCode != CL_SUCCESS )
         {
-            pOverrides->Program = dispatch().clCreateProgramWithSource(
-                context,
-                1,
-                &pProgramString,
-                &programStringLength,
-                &errorCode );
+            program = NULL;
         }
+    }
 
-        // Build the program:
-        if( errorCode == CL_SUCCESS )
-        {
-            errorCode = dispatch().clBuildProgram(
-                pOverrides->Program,
-                0,
-                NULL,
-                NULL,
-                NULL,
-                NULL );
-
-            if( errorCode != CL_SUCCESS )
-            {
-                cl_int  tempErrorCode = CL_SUCCESS;
-
-                // Get the number of devices for this context.
-                cl_uint numDevices = 0;
-                tempErrorCode = dispatch().clGetContextInfo(
-                    context,
-                    CL_CONTEXT_NUM_DEVICES,
-                    sizeof( numDevices ),
-                    &numDevices,
-                    NULL );
+    OS().UnmapFile( fileData, fileSize );
 
-                if( numDevices != 0 )
-                {
-                    cl_device_id*   devices = new cl_device_id[ numDevices ];
-                    if( devices )
-                    {
-                        tempErrorCode = dispatch().clGetContextInfo(
-                            context,
-                            CL_CONTEXT_DEVICES,
-                            numDevices * sizeof( cl_device_id ),
-                            devices,
-                            NULL );
+    if( program == NULL )
+    {
+        // The cache entry is corrupt or no longer usable.  Remove it, so it
+        // is replaced after the program is built from source.
+        std::remove( fileName.c_str() );
+        removed = true;
+        return NULL;
+    }
 
-                        if( tempErrorCode == CL_SUCCESS )
-                        {
-                            for( cl_uint i = 0; i < numDevices; i++ )
-                            {
-                                size_t  buildLogSize = 0;
-                                dispatch().clGetProgramBuildInfo(
-                                    pOverrides->Program,
-                                    devices[ i ],
-                                    CL_PROGRAM_BUILD_LOG,
-                                    0,
-                                    NULL,
-                                    &buildLogSize );
-
-                                char*   buildLog = new char[ buildLogSize + 1 ];
-                                if( buildLog )
-                                {
-                                    dispatch().clGetProgramBuildInfo(
-                                        pOverrides->Program,
-                                        devices[ i ],
-                                        CL_PROGRAM_BUILD_LOG,
-                                        buildLogSize * sizeof( char ),
-                                        buildLog,
-                                        NULL );
+    // Update the modification time of the cache file, which is used to
+    // find the least recently used cache files.
+    OS().TouchFile( fileName );
 
-                                    buildLog[ buildLogSize ] = '\0';
+    return program;
+}
 
-                                    log( "-------> Start of Build Log:\n" );
-                                    log( buildLog );
-                                    log( "<------- End of Build Log!\n" );
+///////////////////////////////////////////////////////////////////////////////
+//
+// Builds a program created with clCreateProgramWithSource() from the program
+// binary cache, if the cache has binaries for the program source, build
+// options, and devices.  The application's program is not modified, so it
+// may still be compiled, linked, or queried for its source.  Instead, the
+// program created from the cached binaries is built, and kernels and build
+// queries for the application's program are redirected to it.  Returns
+// CL_INVALID_OPERATION if the program should be built normally.
+cl_int CLIntercept::buildProgramWithCachedBinaries(
+    const cl_program program,
+    cl_uint numDevices,
+    const cl_device_id* deviceList,
+    const char* options,
+    void (CL_CALLBACK *pfn_notify)(cl_program program, void* user_data),
+    void* user_data )
+{
+    uint64_t    hash = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
 
-                                    delete [] buildLog;
-                                }
-                            }
-                        }
-                    }
-                }
-            }
+        CProgramInfoMap::const_iterator iter = m_ProgramInfoMap.find( program );
+        if( iter == m_ProgramInfoMap.end() ||
+            iter->second.BinaryCacheEnabled == false )
+        {
+            return CL_INVALID_OPERATION;
         }
+        hash = iter->second.BinaryCacheHash;
+    }
+
+    cl_int      errorCode = CL_SUCCESS;
+    cl_context  context = NULL;
 
-        // Create all of the kernels in the program:
+    errorCode = dispatch().clGetProgramInfo(
+        program,
+        CL_PROGRAM_CONTEXT,
+        sizeof(context),
+        &context,
+        NULL );
 
-        if( config().OverrideReadBuffer ||
-            config().OverrideWriteBuffer ||
-            config().OverrideCopyBuffer )
+    std::vector<cl_device_id>   devices;
+    if( errorCode == CL_SUCCESS && deviceList != NULL )
+    {
+        devices.assign( deviceList, deviceList + numDevices );
+    }
+    else if( errorCode == CL_SUCCESS )
+    {
+        cl_device_id*   programDevices = NULL;
+        errorCode = allocateAndGetProgramDeviceList(
+            program,
+            numDevices,
+            programDevices );
+        if( errorCode == CL_SUCCESS )
         {
-            if( errorCode == CL_SUCCESS )
-            {
-                pOverrides->Kernel_CopyBufferBytes = dispatch().clCreateKernel(
-                    pOverrides->Program,
-                    "CopyBufferBytes",
-                    &errorCode );
-            }
-            if( errorCode == CL_SUCCESS )
-            {
-                pOverrides->Kernel_CopyBufferUInts = dispatch().clCreateKernel(
-                    pOverrides->Program,
-                    "CopyBufferUInts",
-                    &errorCode );
-            }
-            if( errorCode == CL_SUCCESS )
-            {
-                pOverrides->Kernel_CopyBufferUInt4s = dispatch().clCreateKernel(
-                    pOverrides->Program,
-                    "CopyBufferUInt4s",
-                    &errorCode );
-            }
-            if( errorCode == CL_SUCCESS )
-            {
-                pOverrides->Kernel_CopyBufferUInt16s = dispatch().clCreateKernel(
-                    pOverrides->Program,
-                    "CopyBufferUInt16s",
-                    &errorCode );
-            }
+            devices.assign( programDevices, programDevices + numDevices );
         }
+        delete [] programDevices;
+    }
+    if( errorCode != CL_SUCCESS || devices.empty() )
+    {
+        return CL_INVALID_OPERATION;
+    }
 
-        if( config().OverrideReadImage ||
-            config().OverrideWriteImage ||
-            config().OverrideCopyImage )
-        {
-            // TODO: Check to see if images are supported?
-            //       What should happen if this is a multiple-device context,
-            //       and one device supports images, but another doesn't?
+    const uint64_t  optionsHash = options ?
+        computeHash( options, strlen(options) ) :
+        0;
 
-            if( errorCode == CL_SUCCESS )
-            {
-                pOverrides->Kernel_CopyImage2Dto2DFloat = dispatch().clCreateKernel(
-                    pOverrides->Program,
-                    "CopyImage2Dto2DFloat",
-                    &errorCode );
-            }
-            if( errorCode == CL_SUCCESS )
-            {
-                pOverrides->Kernel_CopyImage2Dto2DInt = dispatch().clCreateKernel(
-                    pOverrides->Program,
-                    "CopyImage2Dto2DInt",
-                    &errorCode );
-            }
-            if( errorCode == CL_SUCCESS )
-            {
-                pOverrides->Kernel_CopyImage2Dto2DUInt = dispatch().clCreateKernel(
-                    pOverrides->Program,
-                    "CopyImage2Dto2DUInt",
-                    &errorCode );
-            }
-        }
+    std::string fileName;
+    getProgramBinaryCacheFileName(
+        hash,
+        optionsHash,
+        (cl_uint)devices.size(),
+        devices.data(),
+        fileName );
+
+    bool    removed = false;
+    cl_program  cacheProgram = readProgramBinaryCacheFile(
+        fileName,
+        context,
+        (cl_uint)devices.size(),
+        devices.data(),
+        optionsHash,
+        removed );
+
+    // Programs created from binaries still need to be built.  If this fails,
+    // build the application's program from source instead.
+    if( cacheProgram &&
+        dispatch().clBuildProgram(
+            cacheProgram,
+            (cl_uint)devices.size(),
+            devices.data(),
+            options,
+            NULL,
+            NULL ) != CL_SUCCESS )
+    {
+        dispatch().clReleaseProgram( cacheProgram );
+        cacheProgram = NULL;
+        removed = true;
+        std::remove( fileName.c_str() );
+    }
 
-        if( errorCode == CL_SUCCESS )
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        if( cacheProgram )
+        {
+            log( "Program binary cache hit: " + fileName + "\n" );
+        }
+        else if( removed )
         {
-            m_PrecompiledKernelOverridesMap[ context ] = pOverrides;
+            log( "Removing invalid program binary cache file: " + fileName + "\n" );
         }
         else
         {
-            delete pOverrides;
-            pOverrides = NULL;
+            log( "Program binary cache miss: " + fileName + "\n" );
+        }
+
+        // If the application's program was previously built from the cache,
+        // release the old program.  Any kernels created from the old program
+        // keep it alive.
+        SProgramInfo&   programInfo = m_ProgramInfoMap[ program ];
+        if( programInfo.BinaryCacheProgram )
+        {
+            dispatch().clReleaseProgram( programInfo.BinaryCacheProgram );
         }
+        programInfo.BinaryCacheProgram = cacheProgram;
     }
 
-    log( "... precompiled kernel override initialization complete.\n" );
+    if( cacheProgram == NULL )
+    {
+        return CL_INVALID_OPERATION;
+    }
+
+    // The program was built synchronously, so call the notification function
+    // immediately.
+    if( pfn_notify )
+    {
+        pfn_notify( program, user_data );
+    }
+
+    return CL_SUCCESS;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::initProgramBinaryCache(
+    const cl_program program,
+    uint64_t hash )
+{
+    if( program == NULL )
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    SProgramInfo&   programInfo = m_ProgramInfoMap[ program ];
+    programInfo.BinaryCacheEnabled = true;
+    programInfo.BinaryCacheHash = hash;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-void CLIntercept::initBuiltinKernelOverrides(
-    const cl_context context )
+// Returns the program built from the program binary cache for this program,
+// if there is one, or the program itself otherwise.
+cl_program CLIntercept::getBinaryCacheProgram(
+    const cl_program program )
 {
     std::lock_guard<std::mutex> lock(m_Mutex);
-    log( "Initializing builtin kernel overrides...\n" );
+    return findBinaryCacheProgram( program );
+}
 
-    cl_int  errorCode = CL_SUCCESS;
+///////////////////////////////////////////////////////////////////////////////
+//
+cl_program CLIntercept::findBinaryCacheProgram(
+    const cl_program program ) const
+{
+    // We're already in a critical section when we get here, so we don't need to
+    // grab the critical section again.
 
-    // Check to see if overrides already exist.  If they do, release them.
-    SBuiltinKernelOverrides*    pOverrides =
-        m_BuiltinKernelOverridesMap[ context ];
-    if( pOverrides )
+    CProgramInfoMap::const_iterator iter = m_ProgramInfoMap.find( program );
+    if( iter != m_ProgramInfoMap.end() &&
+        iter->second.BinaryCacheProgram != NULL )
     {
-        errorCode = dispatch().clReleaseKernel( pOverrides->Kernel_block_motion_estimate_intel );
+        return iter->second.BinaryCacheProgram;
+    }
 
-        errorCode = dispatch().clReleaseProgram( pOverrides->Program );
+    return program;
+}
 
-        delete pOverrides;
-        pOverrides = NULL;
+///////////////////////////////////////////////////////////////////////////////
+//
+// Called when the application's program is compiled.  The program created
+// from the cached binaries no longer matches the application's program, so
+// queries and kernels use the application's program from now on.  Kernels
+// created from the cached program keep it alive.
+void CLIntercept::removeBinaryCacheProgram(
+    const cl_program program )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
 
-        m_BuiltinKernelOverridesMap[ context ] = NULL;
+    CProgramInfoMap::iterator iter = m_ProgramInfoMap.find( program );
+    if( iter != m_ProgramInfoMap.end() &&
+        iter->second.BinaryCacheProgram != NULL )
+    {
+        dispatch().clReleaseProgram( iter->second.BinaryCacheProgram );
+        iter->second.BinaryCacheProgram = NULL;
     }
+}
 
-    // Allocate new overrides.
-    pOverrides = new SBuiltinKernelOverrides;
-    if( pOverrides )
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::checkRemoveBinaryCacheProgram(
+    const cl_program program )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    CProgramInfoMap::iterator iter = m_ProgramInfoMap.find( program );
+    if( iter != m_ProgramInfoMap.end() &&
+        iter->second.BinaryCacheProgram != NULL &&
+        getRefCount( program ) == 1 )
     {
-        pOverrides->Program = NULL;
+        // Any kernels created from the cached program keep it alive.
+        dispatch().clReleaseProgram( iter->second.BinaryCacheProgram );
+        iter->second.BinaryCacheProgram = NULL;
+    }
+}
 
-        pOverrides->Kernel_block_motion_estimate_intel = NULL;
+///////////////////////////////////////////////////////////////////////////////
+//
+// Records kernels created from the program built from the program binary
+// cache for the application's program, so CL_KERNEL_PROGRAM returns the
+// application's program.  Each kernel retains the application's program.
+void CLIntercept::addBinaryCacheKernels(
+    const cl_program program,
+    const cl_kernel* kernels,
+    cl_uint numKernels )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
 
-        const char* pProgramString = NULL;
-        size_t  programStringLength = 0;
+    if( findBinaryCacheProgram( program ) == program )
+    {
+        return;
+    }
 
-        // Get the builtin kernel program string.
-        if( errorCode == CL_SUCCESS )
+    for( cl_uint k = 0; k < numKernels; k++ )
+    {
+        if( kernels[k] != NULL )
         {
-            if( m_OS.GetBuiltinKernelString(
-                    pProgramString,
-                    programStringLength ) == false )
-            {
-                errorCode = CL_INVALID_VALUE;
-            }
+            dispatch().clRetainProgram( program );
+            m_BinaryCacheKernelMap[ kernels[k] ] = program;
         }
+    }
+}
 
-        // Create the program:
-        if( errorCode == CL_SUCCESS )
-        {
-            pOverrides->Program = dispatch().clCreateProgramWithSource(
-                context,
-                1,
-                &pProgramString,
-                &programStringLength,
-                &errorCode );
-        }
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::addBinaryCacheKernelClone(
+    const cl_kernel kernel,
+    const cl_kernel sourceKernel )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
 
-        // Build the program:
-        if( errorCode == CL_SUCCESS )
-        {
-            errorCode = dispatch().clBuildProgram(
-                pOverrides->Program,
-                0,
-                NULL,
-                "-Dcl_intel_device_side_vme_enable -DHW_NULL_CHECK",
-                NULL,
-                NULL );
+    CBinaryCacheKernelMap::const_iterator iter =
+        m_BinaryCacheKernelMap.find( sourceKernel );
+    if( iter != m_BinaryCacheKernelMap.end() )
+    {
+        dispatch().clRetainProgram( iter->second );
+        m_BinaryCacheKernelMap[ kernel ] = iter->second;
+    }
+}
 
-            if( errorCode != CL_SUCCESS )
-            {
-                cl_int  tempErrorCode = CL_SUCCESS;
+///////////////////////////////////////////////////////////////////////////////
+//
+// Returns the application's program for a kernel created from a program
+// built from the program binary cache, or the kernel's program otherwise.
+cl_program CLIntercept::getBinaryCacheKernelProgram(
+    const cl_kernel kernel,
+    const cl_program program )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return findBinaryCacheKernelProgram( kernel, program );
+}
 
-                // Get the number of devices for this context.
-                cl_uint numDevices = 0;
-                tempErrorCode = dispatch().clGetContextInfo(
-                    context,
-                    CL_CONTEXT_NUM_DEVICES,
-                    sizeof( numDevices ),
-                    &numDevices,
-                    NULL );
+///////////////////////////////////////////////////////////////////////////////
+//
+cl_program CLIntercept::findBinaryCacheKernelProgram(
+    const cl_kernel kernel,
+    const cl_program program ) const
+{
+    // We're already in a critical section when we get here, so we don't need to
+    // grab the critical section again.
 
-                if( numDevices != 0 )
-                {
-                    cl_device_id*   devices = new cl_device_id[ numDevices ];
-                    if( devices )
-                    {
-                        tempErrorCode = dispatch().clGetContextInfo(
-                            context,
-                            CL_CONTEXT_DEVICES,
-                            numDevices * sizeof( cl_device_id ),
-                            devices,
-                            NULL );
+    CBinaryCacheKernelMap::const_iterator iter =
+        m_BinaryCacheKernelMap.find( kernel );
+    if( iter != m_BinaryCacheKernelMap.end() )
+    {
+        return iter->second;
+    }
 
-                        if( tempErrorCode == CL_SUCCESS )
-                        {
-                            for( cl_uint i = 0; i < numDevices; i++ )
-                            {
-                                size_t  buildLogSize = 0;
-                                dispatch().clGetProgramBuildInfo(
-                                    pOverrides->Program,
-                                    devices[ i ],
-                                    CL_PROGRAM_BUILD_LOG,
-                                    0,
-                                    NULL,
-                                    &buildLogSize );
-
-                                char*   buildLog = new char[ buildLogSize + 1 ];
-                                if( buildLog )
-                                {
-                                    dispatch().clGetProgramBuildInfo(
-                                        pOverrides->Program,
-                                        devices[ i ],
-                                        CL_PROGRAM_BUILD_LOG,
-                                        buildLogSize * sizeof( char ),
-                                        buildLog,
-                                        NULL );
+    return program;
+}
 
-                                    buildLog[ buildLogSize ] = '\0';
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::checkRemoveBinaryCacheKernel(
+    const cl_kernel kernel )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
 
-                                    log( "-------> Start of Build Log:\n" );
-                                    log( buildLog );
-                                    log( "<------- End of Build Log!\n" );
+    CBinaryCacheKernelMap::iterator iter =
+        m_BinaryCacheKernelMap.find( kernel );
+    if( iter != m_BinaryCacheKernelMap.end() &&
+        getRefCount( kernel ) == 1 )
+    {
+        const cl_program    program = iter->second;
+        m_BinaryCacheKernelMap.erase( iter );
 
-                                    delete [] buildLog;
-                                }
-                            }
-                        }
-                    }
-                }
-            }
+        // If this is the last reference to the application's program, the
+        // program created from the cached binaries is released also.  The
+        // kernel that is being released keeps it alive until then.
+        CProgramInfoMap::iterator programIter = m_ProgramInfoMap.find( program );
+        if( programIter != m_ProgramInfoMap.end() &&
+            programIter->second.BinaryCacheProgram != NULL &&
+            getRefCount( program ) == 1 )
+        {
+            dispatch().clReleaseProgram( programIter->second.BinaryCacheProgram );
+            programIter->second.BinaryCacheProgram = NULL;
         }
 
-        // Create all of the kernels in the program:
+        dispatch().clReleaseProgram( program );
+    }
+}
 
-        if( errorCode == CL_SUCCESS )
-        {
-            pOverrides->Kernel_block_motion_estimate_intel = dispatch().clCreateKernel(
-                pOverrides->Program,
-                "block_motion_estimate_intel",
-                &errorCode );
-        }
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::updateProgramBinaryCache(
+    const cl_program program,
+    cl_uint numDevices,
+    const cl_device_id* deviceList,
+    const char* options )
+{
+    uint64_t    hash = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
 
-        if( errorCode == CL_SUCCESS )
+        CProgramInfoMap::const_iterator iter = m_ProgramInfoMap.find( program );
+        if( iter == m_ProgramInfoMap.end() ||
+            iter->second.BinaryCacheEnabled == false ||
+            iter->second.BinaryCacheProgram != NULL )
         {
-            m_BuiltinKernelOverridesMap[ context ] = pOverrides;
+            return;
         }
-        else
+        hash = iter->second.BinaryCacheHash;
+    }
+
+    std::vector<cl_device_id>   devices;
+    if( deviceList != NULL )
+    {
+        devices.assign( deviceList, deviceList + numDevices );
+    }
+    else
+    {
+        cl_device_id*   programDevices = NULL;
+        if( allocateAndGetProgramDeviceList(
+                program,
+                numDevices,
+                programDevices ) == CL_SUCCESS )
         {
-            delete pOverrides;
-            pOverrides = NULL;
+            devices.assign( programDevices, programDevices + numDevices );
         }
+        delete [] programDevices;
+    }
+
+    // Only cache binaries that were built for every device in the program,
+    // since the binaries are queried for every device.
+    cl_uint programNumDevices = 0;
+    dispatch().clGetProgramInfo(
+        program,
+        CL_PROGRAM_NUM_DEVICES,
+        sizeof(programNumDevices),
+        &programNumDevices,
+        NULL );
+    if( devices.empty() || devices.size() != programNumDevices )
+    {
+        return;
     }
 
-    log( "... builtin kernel override initialization complete.\n" );
+    const uint64_t  optionsHash = options ?
+        computeHash( options, strlen(options) ) :
+        0;
+
+    std::string fileName;
+    getProgramBinaryCacheFileName(
+        hash,
+        optionsHash,
+        (cl_uint)devices.size(),
+        devices.data(),
+        fileName );
+
+    bool    stored = writeProgramBinaryCacheFile(
+        fileName,
+        program,
+        optionsHash );
+    size_t  evicted = 0;
+    if( stored )
+    {
+        evicted = trimProgramBinaryCache(
+            fileName.substr( 0, fileName.find_last_of( '/' ) ) );
+    }
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    if( stored )
+    {
+        log( "Stored program binary cache file: " + fileName + "\n" );
+    }
+    if( evicted )
+    {
+        logf( "Evicted %zu program binary cache file(s).\n", evicted );
+    }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-cl_program CLIntercept::createProgramWithInjectionBinaries(
-    uint64_t hash,
-    cl_context context,
-    cl_int* errcode_ret )
+// Writes the device binaries for a built program to a program binary cache
+// file.  Returns true if the cache file was written.  This function does not
+// log and does not require the intercept mutex.
+bool CLIntercept::writeProgramBinaryCacheFile(
+    const std::string& fileName,
+    const cl_program program,
+    uint64_t optionsHash ) const
 {
-    std::lock_guard<std::mutex> lock(m_Mutex);
-
-    cl_int      errorCode = CL_SUCCESS;
-    cl_program  program = NULL;
+    cl_int  errorCode = CL_SUCCESS;
 
-    std::string fileName1;
-    std::string fileName2;
-    size_t      numDevices = 0;
+    cl_uint numDevices = 0;
+    if( errorCode == CL_SUCCESS )
+    {
+        errorCode = dispatch().clGetProgramInfo(
+            program,
+            CL_PROGRAM_NUM_DEVICES,
+            sizeof(numDevices),
+            &numDevices,
+            NULL );
+    }
 
+    std::vector<size_t> binarySizes( numDevices );
     if( errorCode == CL_SUCCESS )
     {
-        std::string fileName;
+        errorCode = dispatch().clGetProgramInfo(
+            program,
+            CL_PROGRAM_BINARY_SIZES,
+            numDevices * sizeof(size_t),
+            binarySizes.data(),
+            NULL );
+    }
 
-        // Get the dump directory name.
-        {
-            OS().GetDumpDirectoryNameWithoutPid( sc_DumpDirectoryName, fileName );
-            fileName += "/Inject";
-        }
-        // Make two candidate file names.  They will have the form:
-        //   CLI_<program number>_<hash>_0000, or
-        //   CLI_<hash>_0000
-        // Leave off the extension for now.
+    // Compute the layout of the cache file.
+    size_t  headerSize =
+        sizeof(sc_ProgramBinaryCacheMagic) +
+        ( 2 + numDevices ) * sizeof(uint64_t);
+    size_t  fileSize = headerSize;
+    for( size_t i = 0; errorCode == CL_SUCCESS && i < numDevices; i++ )
+    {
+        if( binarySizes[i] == 0 )
         {
-            char    numberString1[256] = "";
-            CLI_SPRINTF( numberString1, 256, "%04u_%08X_0000",
-                m_ProgramNumber,
-                (unsigned int)hash );
-
-            char    numberString2[256] = "";
-            CLI_SPRINTF( numberString2, 256, "%08X_0000",
-                (unsigned int)hash );
-
-            fileName1 = fileName;
-            fileName1 += "/CLI_";
-            fileName1 += numberString1;
-
-            fileName2 = fileName;
-            fileName2 += "/CLI_";
-            fileName2 += numberString2;
+            // Nothing to cache for this device.
+            errorCode = CL_INVALID_PROGRAM_EXECUTABLE;
         }
+        fileSize += binarySizes[i];
+    }
 
-        errorCode = dispatch().clGetContextInfo(
-            context,
-            CL_CONTEXT_DEVICES,
-            0,
-            NULL,
-            &numDevices );
+    if( errorCode != CL_SUCCESS || numDevices == 0 )
+    {
+        return false;
     }
 
-    cl_device_id*   devices = NULL;
+    // Write the binaries to a temporary file then rename it to publish it,
+    // so other processes never see a partially written cache file.
+    std::string tempFileName =
+        fileName + "." + std::to_string( OS().GetProcessID() ) + ".tmp";
 
-    char**          programBinaries = NULL;
-    size_t*         programBinarySizes = NULL;
+    OS().MakeDumpDirectories( tempFileName );
 
-    if( errorCode == CL_SUCCESS )
+    char*   fileData = (char*)OS().MapFileForWriting( tempFileName, fileSize );
+    std::vector<char>   transferBuf;
+    if( fileData == NULL )
     {
-        numDevices = numDevices / sizeof( cl_device_id );
-
-        devices = new cl_device_id [ numDevices ];
+        transferBuf.resize( fileSize );
+        fileData = transferBuf.data();
+    }
 
-        programBinaries = new char*[ numDevices ];
-        programBinarySizes = new size_t[ numDevices ];
+    {
+        size_t      offset = 0;
+        uint64_t    value = 0;
 
-        if( ( devices == NULL ) ||
-            ( programBinaries == NULL ) ||
-            ( programBinarySizes == NULL ) )
+        memcpy( fileData, sc_ProgramBinaryCacheMagic, sizeof(sc_ProgramBinaryCacheMagic) );
+        offset += sizeof(sc_ProgramBinaryCacheMagic);
+        value = optionsHash;
+        memcpy( fileData + offset, &value, sizeof(value) );
+        offset += sizeof(value);
+        value = numDevices;
+        memcpy( fileData + offset, &value, sizeof(value) );
+        offset += sizeof(value);
+        for( size_t i = 0; i < numDevices; i++ )
         {
-            CLI_ASSERT( 0 );
-            errorCode = CL_OUT_OF_HOST_MEMORY;
+            value = binarySizes[i];
+            memcpy( fileData + offset, &value, sizeof(value) );
+            offset += sizeof(value);
         }
     }
 
-    if( errorCode == CL_SUCCESS )
+    std::vector<unsigned char*> binaries( numDevices );
     {
+        size_t  offset = headerSize;
         for( size_t i = 0; i < numDevices; i++ )
         {
-            programBinaries[i] = NULL;
+            binaries[i] = (unsigned char*)fileData + offset;
+            offset += binarySizes[i];
         }
+    }
 
-        errorCode = dispatch().clGetContextInfo(
-            context,
-            CL_CONTEXT_DEVICES,
-            numDevices * sizeof( cl_device_id ),
-            devices,
-            NULL );
+    errorCode = dispatch().clGetProgramInfo(
+        program,
+        CL_PROGRAM_BINARIES,
+        numDevices * sizeof(unsigned char*),
+        binaries.data(),
+        NULL );
 
-        if( errorCode == CL_SUCCESS )
+    if( transferBuf.empty() )
+    {
+        OS().UnmapFile( fileData, fileSize );
+    }
+    else if( errorCode == CL_SUCCESS )
+    {
+        std::ofstream os;
+        os.open(
+            tempFileName.c_str(),
+            std::ios::out | std::ios::binary );
+        os.write( fileData, fileSize );
+        os.close();
+        if( os.fail() )
         {
-            // Assume all binaries exist, until this is proven otherwise.
-            bool    allBinariesExist = true;
-
-            for( size_t i = 0; i < numDevices; i++ )
-            {
-                cl_device_type  deviceType = CL_DEVICE_TYPE_DEFAULT;
+            errorCode = CL_OUT_OF_RESOURCES;
+        }
+    }
 
-                // It's OK if this fails.  If it does, it just
-                // means that our output file won't have a device
-                // type.
-                dispatch().clGetDeviceInfo(
-                    devices[ i ],
-                    CL_DEVICE_TYPE,
-                    sizeof( deviceType ),
-                    &deviceType,
-                    NULL );
+    if( errorCode == CL_SUCCESS &&
+        OS().RenameFile( tempFileName, fileName ) )
+    {
+        return true;
+    }
 
-                std::string suffix;
+    std::remove( tempFileName.c_str() );
+    return false;
+}
 
-                if( deviceType & CL_DEVICE_TYPE_CPU )
-                {
-                    suffix += "_CPU";
-                }
-                if( deviceType & CL_DEVICE_TYPE_GPU )
-                {
-                    suffix += "_GPU";
-                }
-                if( deviceType & CL_DEVICE_TYPE_ACCELERATOR )
-                {
-                    suffix += "_ACC";
-                }
-                if( deviceType & CL_DEVICE_TYPE_CUSTOM )
-                {
-                    suffix += "_CUSTOM";
-                }
+///////////////////////////////////////////////////////////////////////////////
+//
+// Removes the least recently used program binary cache files until the cache
+// is smaller than the maximum cache size, and returns the number of files
+// that were removed.  Other processes may be using the cache at the same
+// time, so files may disappear while the cache is being trimmed, and errors
+// removing files are ignored.  This function does not log and does not
+// require the intercept mutex.
+size_t CLIntercept::trimProgramBinaryCache(
+    const std::string& directoryName ) const
+{
+    const uint64_t  maxSize =
+        (uint64_t)config().ProgramBinaryCacheMaxSizeMB * 1024 * 1024;
+    if( maxSize == 0 )
+    {
+        return 0;
+    }
 
-                suffix += ".bin";
+    std::vector<std::string>    fileNames;
+    OS().GetDirectoryFiles( directoryName, fileNames );
 
-                std::string inputFileName = fileName1 + suffix;
+    struct SCacheFile
+    {
+        uint64_t    ModifiedTime;
+        uint64_t    Size;
+        std::string FileName;
 
-                std::ifstream is;
-                is.open(
-                    inputFileName.c_str(),
-                    std::ios::in | std::ios::binary );
-                if( is.good() )
-                {
-                    log( "Injection binary file exists: " + inputFileName + "\n" );
-                }
-                else
-                {
-                    log( "Injection binary file doesn't exist: " + inputFileName + "\n" );
+        bool operator<( const SCacheFile& other ) const
+        {
+            return ModifiedTime < other.ModifiedTime;
+        }
+    };
 
-                    inputFileName = fileName2 + suffix;
-                    is.clear();
-                    is.open(
-                        inputFileName.c_str(),
-                        std::ios::in | std::ios::binary );
-                    if( is.good() )
-                    {
-                        log( "Injection binary file exists: " + inputFileName + "\n" );
-                    }
-                    else
-                    {
-                        log( "Injection binary file doesn't exist: " + inputFileName + "\n" );
-                    }
-                }
+    std::vector<SCacheFile> cacheFiles;
+    uint64_t    totalSize = 0;
+    for( size_t i = 0; i < fileNames.size(); i++ )
+    {
+        const std::string&  name = fileNames[i];
+        if( name.length() < 8 ||
+            name.compare( 0, 4, "CLI_" ) != 0 ||
+            name.compare( name.length() - 4, 4, ".bin" ) != 0 )
+        {
+            continue;
+        }
 
-                if( is.good() )
-                {
-                    // The file exists.  Figure out how big it is.
-                    is.seekg( 0, std::ios::end );
-                    programBinarySizes[i] = (size_t)is.tellg();
-                    is.seekg( 0, std::ios::beg );
+        SCacheFile  cacheFile;
+        cacheFile.FileName = directoryName + "/" + name;
+        if( OS().GetFileInfo(
+                cacheFile.FileName,
+                cacheFile.Size,
+                cacheFile.ModifiedTime ) )
+        {
+            totalSize += cacheFile.Size;
+            cacheFiles.push_back( cacheFile );
+        }
+    }
 
-                    programBinaries[i] = new char[ programBinarySizes[i] ];
-                    if( programBinaries[i] == NULL )
-                    {
-                        CLI_ASSERT( 0 );
-                        errorCode = CL_OUT_OF_HOST_MEMORY;
-                    }
-                    else
-                    {
-                        is.read( programBinaries[i],  programBinarySizes[i] );
-                    }
+    if( totalSize <= maxSize )
+    {
+        return 0;
+    }
 
-                    is.close();
-                }
-                else
-                {
-                    log( "Injection binary is missing!\n" );
-                    allBinariesExist = false;
-                }
-            }
+    std::sort( cacheFiles.begin(), cacheFiles.end() );
+    size_t  evicted = 0;
+    for( ; evicted < cacheFiles.size() && totalSize > maxSize; evicted++ )
+    {
+        std::remove( cacheFiles[evicted].FileName.c_str() );
+        totalSize -= cacheFiles[evicted].Size;
+    }
 
-            if( allBinariesExist &&
-                ( errorCode == CL_SUCCESS ) )
-            {
-                log( "All injection binaries exist.\n" );
+    return evicted;
+}
 
-                program = dispatch().clCreateProgramWithBinary(
-                    context,
-                    (cl_uint)numDevices,
-                    devices,
-                    programBinarySizes,
-                    (const unsigned char**)programBinaries,
-                    NULL,   // binary_status
-                    &errorCode );
-                if( program )
-                {
-                    logf("Injection successful: clCreateProgramWithBinary() returned %p\n",
-                        program );
-                }
-                if( errorCode != CL_SUCCESS )
-                {
-                    logf("Injecting binaries failed: clCreateProgramWithBinary() returned %s\n",
-                        enumName().name( errorCode ).c_str() );
-                }
-            }
+///////////////////////////////////////////////////////////////////////////////
+//
+// Queues program dump files to be written by the thread pool.  The file
+// contents have already been retrieved from the program, so the thread pool
+// never calls into OpenCL, and it only needs the intercept mutex to log
+// errors.
+void CLIntercept::queueProgramDump(
+    CProgramDumpFiles& files )
+{
+    // We're already in a critical section when we get here, so we don't need to
+    // grab the critical section again.
 
-            for( size_t i = 0; i < numDevices; i++ )
-            {
-                programBinarySizes[i] = 0;
+    if( files.empty() )
+    {
+        return;
+    }
 
-                delete [] programBinaries[i];
-                programBinaries[i] = NULL;
-            }
-        }
+    if( m_ThreadPoolShutdown )
+    {
+        m_ProgramDumpsDropped++;
+        return;
     }
 
-    delete [] devices;
+    std::shared_ptr<CProgramDumpFiles>  pFiles =
+        std::make_shared<CProgramDumpFiles>();
+    pFiles->swap( files );
+
+    m_ThreadPool.start();
+    m_ThreadPool.enqueue(
+        [this, pFiles]() {
+            for( const SProgramDumpFile& file : *pFiles )
+            {
+                std::ofstream os;
+                os.open(
+                    file.FileName.c_str(),
+                    std::ios::out | std::ios::binary );
+                os.write( file.Data.data(), file.Data.size() );
+                os.close();
+                if( os.fail() )
+                {
+                    std::lock_guard<std::mutex> lock(m_Mutex);
+                    logf( "Failed to write dump file: %s\n",
+                        file.FileName.c_str() );
+                }
+            }
+        } );
+}
 
-    delete [] programBinaries;
-    delete [] programBinarySizes;
+///////////////////////////////////////////////////////////////////////////////
+//
+// Dumps a program file immediately, or if pFiles is not NULL, adds a copy of
+// the file contents to pFiles to be written by the thread pool.
+void CLIntercept::dumpProgramFile(
+    CProgramDumpFiles* pFiles,
+    const std::string& fileName,
+    const void* ptr,
+    size_t size )
+{
+    // We're already in a critical section when we get here, so we don't need to
+    // grab the critical section again.
 
-    if( errcode_ret )
+    if( pFiles )
     {
-        errcode_ret[0] = errorCode;
+        const char* data = (const char*)ptr;
+        pFiles->push_back( SProgramDumpFile() );
+        pFiles->back().FileName = fileName;
+        pFiles->back().Data.assign( data, data + size );
+    }
+    else
+    {
+        dumpMemoryToFile(
+            fileName,
+            false,
+            ptr,
+            size );
     }
-
-    return program;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -10249,6 +13549,24 @@ void CLIntercept::dumpProgramBinary(
 
     const SProgramInfo& programInfo = m_ProgramInfoMap[ program ];
 
+    CProgramDumpFiles   files;
+    writeProgramBinary(
+        findBinaryCacheProgram( program ),
+        programInfo,
+        config().AsyncProgramDumping ? &files : NULL );
+    queueProgramDump( files );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::writeProgramBinary(
+    const cl_program program,
+    const SProgramInfo& programInfo,
+    CProgramDumpFiles* pFiles )
+{
+    // We're already in a critical section when we get here, so we don't need to
+    // grab the critical section again.
+
     std::string     fileName;
 
     // Get the dump directory name.
@@ -10406,9 +13724,9 @@ void CLIntercept::dumpProgramBinary(
                 outputFileName += ".bin";
 
                 log( "Dumping program binary to file: " + outputFileName + "\n" );
-                dumpMemoryToFile(
+                dumpProgramFile(
+                    pFiles,
                     outputFileName,
-                    false,
                     programBinaries[ i ],
                     programBinarySizes[ i ] );
             }
@@ -10438,13 +13756,152 @@ void CLIntercept::dumpKernelISABinaries(
 {
     std::lock_guard<std::mutex> lock(m_Mutex);
 
+    const SProgramInfo& programInfo = m_ProgramInfoMap[ program ];
+
+    CProgramDumpFiles   files;
+    writeKernelISABinaries(
+        findBinaryCacheProgram( program ),
+        programInfo,
+        config().AsyncProgramDumping ? &files : NULL );
+    queueProgramDump( files );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::writeKernelISABinaries(
+    const cl_program program,
+    const SProgramInfo& programInfo,
+    CProgramDumpFiles* pFiles )
+{
+    // We're already in a critical section when we get here, so we don't need to
+    // grab the critical section again.
+
     cl_int  errorCode = CL_SUCCESS;
 
-    // Since the kernel ISA binaries are retrieved via kernel queries, the first
-    // thing we need to do is to create the kernels for this program.
+    // Get the list of devices for the program.
+    cl_uint         numDevices = 0;
+    cl_device_id*   deviceList = NULL;
+    if( errorCode == CL_SUCCESS && program != NULL )
+    {
+        errorCode = allocateAndGetProgramDeviceList(
+            program,
+            numDevices,
+            deviceList );
+    }
+    if( errorCode != CL_SUCCESS )
+    {
+        delete [] deviceList;
+        return;
+    }
+
+    std::string dumpDirectoryName;
+    std::string buildName;
+
+    // Get the dump directory name.
+    {
+        OS().GetDumpDirectoryName( sc_DumpDirectoryName, dumpDirectoryName );
+    }
+    // Make the build name.  It will have the form:
+    //   CLI_<program number>_<program hash>_<compile count>_<options hash>
+    // The ISA file names will have the form:
+    //   CLI_<program number>_<program hash>_<compile count>_<options hash>_<device type>_<kernel name>.isabin
+    // We'll fill in the device type and kernel name later.
+    {
+        char    numberString[256] = "";
+
+        if( config().OmitProgramNumber )
+        {
+            CLI_SPRINTF( numberString, 256, "%08X_%04u_%08X",
+                (unsigned int)programInfo.ProgramHash,
+                programInfo.CompileCount,
+                (unsigned int)programInfo.OptionsHash );
+        }
+        else
+        {
+            CLI_SPRINTF( numberString, 256, "%04u_%08X_%04u_%08X",
+                programInfo.ProgramNumber,
+                (unsigned int)programInfo.ProgramHash,
+                programInfo.CompileCount,
+                (unsigned int)programInfo.OptionsHash );
+        }
+
+        buildName = "CLI_";
+        buildName += numberString;
+    }
+    // Now make directories as appropriate.
+    {
+        OS().MakeDumpDirectories( dumpDirectoryName + "/" + buildName );
+    }
+
+    std::vector<std::string>    deviceTypeNames( numDevices );
+    std::vector<cl_device_id>   dumpDevices;
+
+    std::ostringstream  manifest;
+
+    for( cl_uint d = 0; d < numDevices; d++ )
+    {
+        cl_device_type  deviceType = CL_DEVICE_TYPE_DEFAULT;
+
+        // It's OK if this fails.  If it does, it just
+        // means that our output file won't have a device
+        // type.
+        dispatch().clGetDeviceInfo(
+            deviceList[d],
+            CL_DEVICE_TYPE,
+            sizeof( deviceType ),
+            &deviceType,
+            NULL );
+
+        if( deviceType & CL_DEVICE_TYPE_CPU )
+        {
+            deviceTypeNames[d] += "CPU_";
+        }
+        if( deviceType & CL_DEVICE_TYPE_GPU )
+        {
+            deviceTypeNames[d] += "GPU_";
+        }
+        if( deviceType & CL_DEVICE_TYPE_ACCELERATOR )
+        {
+            deviceTypeNames[d] += "ACC_";
+        }
+        if( deviceType & CL_DEVICE_TYPE_CUSTOM )
+        {
+            deviceTypeNames[d] += "CUSTOM_";
+        }
+
+        // If the same program was already built with the same options for
+        // this device, the kernel ISA will be the same, so skip the queries
+        // and refer to the files from the earlier build.  Linked programs do
+        // not have a program hash, so they are always queried.
+        SKernelISADumpKey   key;
+        key.ProgramHash = programInfo.ProgramHash;
+        key.OptionsHash = programInfo.OptionsHash;
+        key.Device = deviceList[d];
+
+        CKernelISADumpMap::const_iterator iter = m_KernelISADumpMap.find( key );
+        if( key.ProgramHash != 0 && iter != m_KernelISADumpMap.end() )
+        {
+            logf( "Kernel ISA binaries for %s were already dumped.\n",
+                buildName.c_str() );
+            for( const auto& kernelFile : iter->second )
+            {
+                manifest << buildName << ", "
+                    << deviceTypeNames[d] << ", "
+                    << kernelFile.first << ", "
+                    << kernelFile.second << "\n";
+            }
+        }
+        else
+        {
+            dumpDevices.push_back( deviceList[d] );
+        }
+    }
+
+    // Since the kernel ISA binaries are retrieved via kernel queries, we need
+    // to create the kernels for this program.
 
     cl_uint numKernels = 0;
-    if( errorCode == CL_SUCCESS )
+    if( errorCode == CL_SUCCESS && !dumpDevices.empty() )
     {
         errorCode = dispatch().clCreateKernelsInProgram(
             program,
@@ -10474,57 +13931,8 @@ void CLIntercept::dumpKernelISABinaries(
         }
     }
 
-    // Also, get the list of devices for the program.
-    cl_uint         numDevices = 0;
-    cl_device_id*   deviceList = NULL;
-    if( errorCode == CL_SUCCESS )
-    {
-        errorCode = allocateAndGetProgramDeviceList(
-            program,
-            numDevices,
-            deviceList );
-    }
-
-    if( errorCode == CL_SUCCESS && program != NULL && kernels != NULL )
+    if( errorCode == CL_SUCCESS && kernels != NULL )
     {
-        const SProgramInfo& programInfo = m_ProgramInfoMap[ program ];
-
-        std::string fileNamePrefix;
-
-        // Get the dump directory name.
-        {
-            OS().GetDumpDirectoryName( sc_DumpDirectoryName, fileNamePrefix );
-        }
-        // Make the file name prefix.  It will have the form:
-        //   CLI_<program number>_<program hash>_<compile count>_<options hash>_<device type>_<kernel name>.isabin
-        // We'll fill in the device type and kernel name later.
-        {
-            char    numberString[256] = "";
-
-            if( config().OmitProgramNumber )
-            {
-                CLI_SPRINTF( numberString, 256, "%08X_%04u_%08X_",
-                    (unsigned int)programInfo.ProgramHash,
-                    programInfo.CompileCount,
-                    (unsigned int)programInfo.OptionsHash );
-            }
-            else
-            {
-                CLI_SPRINTF( numberString, 256, "%04u_%08X_%04u_%08X_",
-                    programInfo.ProgramNumber,
-                    (unsigned int)programInfo.ProgramHash,
-                    programInfo.CompileCount,
-                    (unsigned int)programInfo.OptionsHash );
-            }
-
-            fileNamePrefix += "/CLI_";
-            fileNamePrefix += numberString;
-        }
-        // Now make directories as appropriate.
-        {
-            OS().MakeDumpDirectories( fileNamePrefix );
-        }
-
         for( cl_uint k = 0; k < numKernels; k++ )
         {
             cl_kernel   kernel = kernels[ k ];
@@ -10542,6 +13950,12 @@ void CLIntercept::dumpKernelISABinaries(
 
             for( cl_uint d = 0; d < numDevices; d++ )
             {
+                if( std::find( dumpDevices.begin(), dumpDevices.end(), deviceList[d] ) ==
+                    dumpDevices.end() )
+                {
+                    continue;
+                }
+
                 size_t      kernelISABinarySize = 0;
                 char*       kernelISABinary = NULL;
 
@@ -10556,46 +13970,66 @@ void CLIntercept::dumpKernelISABinaries(
 
                 if( errorCode == CL_SUCCESS )
                 {
-                    std::string fileName( fileNamePrefix );
-
-                    cl_device_type  deviceType = CL_DEVICE_TYPE_DEFAULT;
+                    std::string fileName( buildName );
+                    fileName += "_";
+                    fileName += deviceTypeNames[d];
+                    fileName += kernelName;
+                    fileName += ".isabin";
 
-                    // It's OK if this fails.  If it does, it just
-                    // means that our output file won't have a device
-                    // type.
-                    dispatch().clGetDeviceInfo(
-                        deviceList[d],
-                        CL_DEVICE_TYPE,
-                        sizeof( deviceType ),
-                        &deviceType,
-                        NULL );
+                    // Only write one file for each unique kernel ISA binary.
+                    uint64_t    contentHash = computeHash(
+                        kernelISABinary,
+                        kernelISABinarySize );
 
-                    if( deviceType & CL_DEVICE_TYPE_CPU )
-                    {
-                        fileName += "CPU_";
-                    }
-                    if( deviceType & CL_DEVICE_TYPE_GPU )
+                    const SKernelISAFile*   pMatch = NULL;
+                    auto    range = m_KernelISAFileMap.equal_range( contentHash );
+                    for( auto iter = range.first; iter != range.second; ++iter )
                     {
-                        fileName += "GPU_";
+                        const std::vector<char>&    data = iter->second.Data;
+                        if( data.size() == kernelISABinarySize &&
+                            memcmp( data.data(), kernelISABinary, kernelISABinarySize ) == 0 )
+                        {
+                            pMatch = &iter->second;
+                            break;
+                        }
                     }
-                    if( deviceType & CL_DEVICE_TYPE_ACCELERATOR )
+
+                    if( pMatch )
                     {
-                        fileName += "ACC_";
+                        log( "Kernel ISA binary for " + fileName +
+                            " matches file: " + pMatch->FileName + "\n" );
+                        fileName = pMatch->FileName;
                     }
-                    if( deviceType & CL_DEVICE_TYPE_CUSTOM )
+                    else
                     {
-                        fileName+= "CUSTOM_";
+                        SKernelISAFile  file;
+                        file.Data.assign(
+                            kernelISABinary,
+                            kernelISABinary + kernelISABinarySize );
+                        file.FileName = fileName;
+                        m_KernelISAFileMap.emplace( contentHash, std::move( file ) );
+
+                        log( "Dumping kernel ISA binary to file: " +
+                            dumpDirectoryName + "/" + fileName + "\n" );
+                        dumpProgramFile(
+                            pFiles,
+                            dumpDirectoryName + "/" + fileName,
+                            kernelISABinary,
+                            kernelISABinarySize );
                     }
 
-                    fileName += kernelName;
-                    fileName += ".isabin";
+                    SKernelISADumpKey   key;
+                    key.ProgramHash = programInfo.ProgramHash;
+                    key.OptionsHash = programInfo.OptionsHash;
+                    key.Device = deviceList[d];
 
-                    log( "Dumping kernel ISA binary to file: " + fileName + "\n" );
-                    dumpMemoryToFile(
-                        fileName,
-                        false,
-                        kernelISABinary,
-                        kernelISABinarySize );
+                    m_KernelISADumpMap[ key ].push_back(
+                        std::make_pair( std::string( kernelName ), fileName ) );
+
+                    manifest << buildName << ", "
+                        << deviceTypeNames[d] << ", "
+                        << kernelName << ", "
+                        << fileName << "\n";
                 }
 
                 delete [] kernelISABinary;
@@ -10625,6 +14059,32 @@ void CLIntercept::dumpKernelISABinaries(
 
     delete [] deviceList;
     deviceList = NULL;
+
+    // Append this build to the manifest, which maps each build and kernel to
+    // its shared kernel ISA file.
+    if( !manifest.str().empty() )
+    {
+        std::string manifestFileName( dumpDirectoryName );
+        manifestFileName += "/";
+        manifestFileName += sc_KernelISAManifestFileName;
+
+        std::ofstream   os;
+        if( m_KernelISAManifestStarted )
+        {
+            os.open(
+                manifestFileName.c_str(),
+                std::ios::out | std::ios::binary | std::ios::app );
+        }
+        else
+        {
+            os.open(
+                manifestFileName.c_str(),
+                std::ios::out | std::ios::binary );
+            os << "Build, Device, Kernel, ISA File\n";
+            m_KernelISAManifestStarted = true;
+        }
+        os << manifest.str();
+    }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -10681,9 +14141,9 @@ cl_program CLIntercept::createProgramWithInjectionSPIRV(
 
             std::ifstream is;
 
-            is.open(
-                fileName1.c_str(),
-                std::ios::in | std::ios::binary);
+            openInjectionFile(
+                fileName1,
+                is );
             if( is.good() )
             {
                 log("Injecting SPIR-V file: " + fileName1 + "\n");
@@ -10693,9 +14153,9 @@ cl_program CLIntercept::createProgramWithInjectionSPIRV(
                 log("Injection SPIR-V file doesn't exist: " + fileName1 + "\n");
 
                 is.clear();
-                is.open(
-                    fileName2.c_str(),
-                    std::ios::in | std::ios::binary);
+                openInjectionFile(
+                    fileName2,
+                    is );
                 if( is.good() )
                 {
                     log("Injecting SPIR-V file: " + fileName2 + "\n");
@@ -10756,7 +14216,7 @@ void CLIntercept::autoCreateSPIRV(
     const cl_program program,
     const char* raw_options )
 {
-    std::lock_guard<std::mutex> lock(m_Mutex);
+    std::unique_lock<std::mutex> lock(m_Mutex);
 
     const SProgramInfo& programInfo = m_ProgramInfoMap[ program ];
 
@@ -10826,50 +14286,282 @@ void CLIntercept::autoCreateSPIRV(
         OS().MakeDumpDirectories( inputFileName );
     }
 
-    std::string options(raw_options ? raw_options : "");
-    std::string command;
+    std::string options(raw_options ? raw_options : "");
+    std::string clangOptions;
+
+    // Create the options we will use to invoke CLANG.  How we do this will
+    // depend on whether this is an OpenCL 1.x or 2.0 compilation.  We don't
+    // distinguish between different versions of OpenCL 1.x right now, but we
+    // can add this in the future, if desired.
+    if( options.find( "-cl-std=CL2.0" ) != std::string::npos )
+    {
+        // This is an OpenCL 2.0 compilation.
+        clangOptions =
+            config().OpenCL2Options +
+            " -include " + config().SPIRVCLHeader +
+            " " + options;
+    }
+    else
+    {
+        // This is an OpenCL 1.x compilation.
+        clangOptions =
+            config().DefaultOptions +
+            " -include " + config().SPIRVCLHeader +
+            " " + options;
+    }
+
+    std::string name = outputFileName.substr( dumpDirectoryName.length() + 1 );
+
+    // The module only depends on the program source and the CLANG command
+    // line, so key it by the program hash and a hash of the command line.
+    std::string keyString = config().SPIRVClang + " " + clangOptions;
+    CSPIRVJobKey    key(
+        programInfo.ProgramHash,
+        computeHash( keyString.c_str(), keyString.length() ) );
+
+    SSPIRVJobResult&    result = m_SPIRVJobResultMap[ key ];
+    if( !result.FileName.empty() )
+    {
+        if( result.Done && result.Failed )
+        {
+            logf( "Skipping SPIR-V module %s, since %s could not be created.\n",
+                outputFileName.c_str(),
+                result.FileName.c_str() );
+
+            SSPIRVJobTiming timing;
+            timing.Name = name;
+            timing.Result = "Failed";
+            timing.NS = 0;
+            m_SPIRVJobTimings.push_back( timing );
+        }
+        else if( result.Done )
+        {
+            clock::time_point   start = clock::now();
+
+            logf( "Copying SPIR-V module %s to %s\n",
+                result.FileName.c_str(),
+                outputFileName.c_str() );
+            copySPIRVModule( result.FileName, outputFileName );
+
+            SSPIRVJobTiming timing;
+            timing.Name = name;
+            timing.Result = "Reused";
+            timing.NS = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                clock::now() - start ).count();
+            m_SPIRVJobTimings.push_back( timing );
+        }
+        else
+        {
+            result.PendingFileNames.push_back(
+                std::make_pair( name, outputFileName ) );
+        }
+        return;
+    }
+    result.FileName = outputFileName;
+
+    std::string cacheFileName;
+    if( config().AutoCreateSPIRVCache )
+    {
+        if( config().AutoCreateSPIRVCacheDir.empty() )
+        {
+            OS().GetDumpDirectoryNameWithoutPid( sc_DumpDirectoryName, cacheFileName );
+            cacheFileName += "/SPIRVCache";
+        }
+        else
+        {
+            cacheFileName = config().AutoCreateSPIRVCacheDir;
+        }
+
+        char    numberString[256] = "";
+        CLI_SPRINTF( numberString, 256, "%016" PRIX64 "_%016" PRIX64,
+            key.first,
+            key.second );
+
+        cacheFileName += "/CLI_";
+        cacheFileName += numberString;
+        cacheFileName += ".spv";
+
+        OS().MakeDumpDirectories( cacheFileName );
+    }
+
+    if( config().AutoCreateSPIRVJobs )
+    {
+        m_SPIRVJobPool.start( config().AutoCreateSPIRVJobs );
+        m_SPIRVJobPool.enqueue(
+            [this, key, name, inputFileName, outputFileName, cacheFileName, clangOptions]() {
+                runSPIRVJob(
+                    key,
+                    name,
+                    inputFileName,
+                    outputFileName,
+                    cacheFileName,
+                    clangOptions );
+            } );
+    }
+    else
+    {
+        lock.unlock();
+        runSPIRVJob(
+            key,
+            name,
+            inputFileName,
+            outputFileName,
+            cacheFileName,
+            clangOptions );
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Creates a SPIR-V module, either by copying it from the cache or by invoking
+// CLANG.  This is called without holding the intercept mutex, so it can run
+// on the SPIR-V job pool in parallel with other jobs.
+void CLIntercept::runSPIRVJob(
+    const CSPIRVJobKey& key,
+    const std::string& name,
+    const std::string& inputFileName,
+    const std::string& outputFileName,
+    const std::string& cacheFileName,
+    const std::string& clangOptions )
+{
+    clock::time_point   start = clock::now();
 
-    // Create the command we will use to invoke CLANG with the right options.
-    // How we do this will depend on whether this is an OpenCL 1.x or 2.0
-    // compilation.  We don't distinguish between different versions of
-    // OpenCL 1.x right now, but we can add this in the future, if desired.
-    if( options.find( "-cl-std=CL2.0" ) != std::string::npos )
+    const char* jobResult = "Compiled";
+    bool        failed = false;
+
+    if( !cacheFileName.empty() &&
+        Utils::CopyFileContents( cacheFileName, outputFileName ) )
     {
-        // This is an OpenCL 2.0 compilation.
-        command =
-            config().SPIRVClang +
-            " " + config().OpenCL2Options +
-            " -include " + config().SPIRVCLHeader +
-            " " + options +
-            " -o " + outputFileName +
-            " " + inputFileName;
+        jobResult = "Cached";
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        logf( "Copied SPIR-V module from cache: %s\n",
+            cacheFileName.c_str() );
     }
     else
     {
-        // This is an OpenCL 1.x compilation.
-        command =
+        std::string command =
             config().SPIRVClang +
-            " " + config().DefaultOptions +
-            " -include " + config().SPIRVCLHeader +
-            " " + options +
+            " " + clangOptions +
             " -o " + outputFileName +
             " " + inputFileName;
-    }
 
-    logf( "Running: %s\n", command.c_str() );
-    OS().ExecuteCommand( command );
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            logf( "Running: %s\n", command.c_str() );
+        }
+
+        // ExecuteCommand only reports whether the command could be run, not
+        // whether CLANG succeeded, so remove any existing output file first,
+        // and consider the job failed if CLANG did not create a new,
+        // non-empty file.
+        std::remove( outputFileName.c_str() );
+
+        uint64_t    fileSize = 0;
+        uint64_t    modifiedTime = 0;
+        failed =
+            OS().ExecuteCommand( command ) == false ||
+            OS().GetFileInfo( outputFileName, fileSize, modifiedTime ) == false ||
+            fileSize == 0;
+        if( failed )
+        {
+            jobResult = "Failed";
+            std::remove( outputFileName.c_str() );
+
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            logf( "Failed to create SPIR-V module: %s\n",
+                outputFileName.c_str() );
+        }
+
+        // Add the module to the cache.  Write it to a temporary file first
+        // and rename it, so other processes never see a partial module.
+        if( !failed && !cacheFileName.empty() )
+        {
+            std::string tempFileName = cacheFileName + ".tmp";
+            tempFileName += std::to_string( OS().GetProcessID() );
+            tempFileName += "_";
+            tempFileName += std::to_string( OS().GetThreadID() );
+
+            if( Utils::CopyFileContents( outputFileName, tempFileName ) == false ||
+                OS().RenameFile( tempFileName, cacheFileName ) == false )
+            {
+                std::remove( tempFileName.c_str() );
+            }
+        }
+    }
 
     // Optionally, run spirv-dis to disassemble the generated module.
-    if( !config().SPIRVDis.empty() )
+    if( !failed && !config().SPIRVDis.empty() )
     {
-        command =
+        std::string command =
             config().SPIRVDis +
             " -o " + outputFileName + "asm" +
             " " + outputFileName;
 
-        logf( "Running: %s\n", command.c_str() );
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            logf( "Running: %s\n", command.c_str() );
+        }
         OS().ExecuteCommand( command );
     }
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    SSPIRVJobTiming timing;
+    timing.Name = name;
+    timing.Result = jobResult;
+    timing.NS = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        clock::now() - start ).count();
+    m_SPIRVJobTimings.push_back( timing );
+
+    // Copy the module for any programs with the same key that were built
+    // while this module was being created.
+    SSPIRVJobResult&    result = m_SPIRVJobResultMap[ key ];
+    result.Done = true;
+    result.Failed = failed;
+
+    for( const auto& pending : result.PendingFileNames )
+    {
+        if( failed )
+        {
+            logf( "Skipping SPIR-V module %s, since %s could not be created.\n",
+                pending.second.c_str(),
+                outputFileName.c_str() );
+
+            timing.Name = pending.first;
+            timing.Result = "Failed";
+            timing.NS = 0;
+            m_SPIRVJobTimings.push_back( timing );
+            continue;
+        }
+
+        start = clock::now();
+
+        logf( "Copying SPIR-V module %s to %s\n",
+            outputFileName.c_str(),
+            pending.second.c_str() );
+        copySPIRVModule( outputFileName, pending.second );
+
+        timing.Name = pending.first;
+        timing.Result = "Reused";
+        timing.NS = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            clock::now() - start ).count();
+        m_SPIRVJobTimings.push_back( timing );
+    }
+    result.PendingFileNames.clear();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::copySPIRVModule(
+    const std::string& srcFileName,
+    const std::string& dstFileName )
+{
+    Utils::CopyFileContents( srcFileName, dstFileName );
+    if( !config().SPIRVDis.empty() )
+    {
+        Utils::CopyFileContents( srcFileName + "asm", dstFileName + "asm" );
+    }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -12137,330 +15829,452 @@ cl_int CLIntercept::CopyBuffer(
             NULL );
     }
 
-    if( errorCode == CL_SUCCESS )
-    {
-        errorCode = CopyBufferHelper(
-            context,
-            commandQueue,
-            srcBuffer,
-            dstBuffer,
-            srcOffset,
-            dstOffset,
-            bytesToCopy,
-            numEventsInWaitList,
-            eventWaitList,
-            event );
-    }
-
-    return errorCode;
-}
-
-///////////////////////////////////////////////////////////////////////////////
-//
-cl_int CLIntercept::CopyBufferHelper(
-    cl_context context,
-    cl_command_queue commandQueue,
-    cl_mem srcBuffer,
-    cl_mem dstBuffer,
-    size_t srcOffset,
-    size_t dstOffset,
-    size_t bytesToCopy,
-    cl_uint numEventsInWaitList,
-    const cl_event* eventWaitList,
-    cl_event* event )
-{
-    // This function assumes that it is being called from within a critical
-    // section, so it does not enter the critical section again.
-
-    cl_int  errorCode = CL_SUCCESS;
-
+    if( errorCode == CL_SUCCESS )
+    {
+        errorCode = CopyBufferHelper(
+            context,
+            commandQueue,
+            srcBuffer,
+            dstBuffer,
+            srcOffset,
+            dstOffset,
+            bytesToCopy,
+            numEventsInWaitList,
+            eventWaitList,
+            event );
+    }
+
+    return errorCode;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+cl_int CLIntercept::CopyBufferHelper(
+    cl_context context,
+    cl_command_queue commandQueue,
+    cl_mem srcBuffer,
+    cl_mem dstBuffer,
+    size_t srcOffset,
+    size_t dstOffset,
+    size_t bytesToCopy,
+    cl_uint numEventsInWaitList,
+    const cl_event* eventWaitList,
+    cl_event* event )
+{
+    // This function assumes that it is being called from within a critical
+    // section, so it does not enter the critical section again.
+
+    cl_int  errorCode = CL_SUCCESS;
+
+    SPrecompiledKernelOverrides*    pOverrides = NULL;
+
+    // Get the overrides for this context and device.
+    if( errorCode == CL_SUCCESS )
+    {
+        pOverrides = getPrecompiledKernelOverrides( context, commandQueue );
+        if( pOverrides == NULL )
+        {
+            errorCode = CL_INVALID_VALUE;
+        }
+    }
+
+    // If the benchmark found that the implementation's copy is faster for
+    // copies of this size, use it instead.
+    bool    useNative = false;
+    if( errorCode == CL_SUCCESS &&
+        pOverrides->UseNativeCopyBuffer.empty() == false )
+    {
+        size_t  index = 0;
+        while( index < pOverrides->UseNativeCopyBuffer.size() - 1 &&
+               bytesToCopy > cCopyBufferBenchmarkSizes[ index ] )
+        {
+            index++;
+        }
+
+        useNative = pOverrides->UseNativeCopyBuffer[ index ];
+    }
+
+    if( errorCode == CL_SUCCESS &&
+        useNative )
+    {
+        errorCode = dispatch().clEnqueueCopyBuffer(
+            commandQueue,
+            srcBuffer,
+            dstBuffer,
+            srcOffset,
+            dstOffset,
+            bytesToCopy,
+            numEventsInWaitList,
+            eventWaitList,
+            event );
+    }
+    else if( errorCode == CL_SUCCESS &&
+             m_Config.ForceByteBufferOverrides )
+    {
+        errorCode |= dispatch().clSetKernelArg(
+            pOverrides->Kernel_CopyBufferBytes,
+            0,
+            sizeof( srcBuffer ),
+            &srcBuffer );
+        errorCode |= dispatch().clSetKernelArg(
+            pOverrides->Kernel_CopyBufferBytes,
+            1,
+            sizeof( dstBuffer ),
+            &dstBuffer );
+
+        cl_uint uiSrcOffset = (cl_uint)( srcOffset );
+        errorCode |= dispatch().clSetKernelArg(
+            pOverrides->Kernel_CopyBufferBytes,
+            2,
+            sizeof( uiSrcOffset ),
+            &uiSrcOffset );
+
+        cl_uint uiDstOffset = (cl_uint)( dstOffset );
+        errorCode |= dispatch().clSetKernelArg(
+            pOverrides->Kernel_CopyBufferBytes,
+            3,
+            sizeof( uiDstOffset ),
+            &uiDstOffset );
+
+        cl_uint uiBytesToCopy = (cl_uint)( bytesToCopy );
+        errorCode |= dispatch().clSetKernelArg(
+            pOverrides->Kernel_CopyBufferBytes,
+            4,
+            sizeof( uiBytesToCopy ),
+            &uiBytesToCopy );
+
+        if( errorCode == CL_SUCCESS )
+        {
+            size_t  global_work_size = bytesToCopy;
+            size_t  local_work_size = 32;
+
+            // Make sure global_work_size is an even multiple of local_work_size
+            if( ( global_work_size % local_work_size ) != 0 )
+            {
+                global_work_size +=
+                    local_work_size -
+                    ( global_work_size % local_work_size );
+            }
+
+            // Execute kernel
+            errorCode = dispatch().clEnqueueNDRangeKernel(
+                commandQueue,
+                pOverrides->Kernel_CopyBufferBytes,
+                1,
+                NULL,
+                &global_work_size,
+                &local_work_size,
+                numEventsInWaitList,
+                eventWaitList,
+                event );
+        }
+    }
+    else if( errorCode == CL_SUCCESS )
+    {
+        // Pick the widest element that the source and destination can both
+        // be aligned to.  If the source and destination have different
+        // alignments, use the unaligned kernel, which copies sixteen bytes
+        // at a time with vector loads and stores.
+        cl_kernel   kernel = NULL;
+        size_t      elementSize = 16;
+        size_t      headBytes = 0;
+
+        if( ( srcOffset % 16 ) == ( dstOffset % 16 ) )
+        {
+            kernel = pOverrides->Kernel_CopyBufferAlignedUInt4s;
+            elementSize = 16;
+            headBytes = ( 16 - srcOffset % 16 ) % 16;
+        }
+        else if( ( srcOffset % 4 ) == ( dstOffset % 4 ) )
+        {
+            kernel = pOverrides->Kernel_CopyBufferAlignedUInts;
+            elementSize = 4;
+            headBytes = ( 4 - srcOffset % 4 ) % 4;
+        }
+        else
+        {
+            kernel = pOverrides->Kernel_CopyBufferUnalignedUChar16s;
+            elementSize = 16;
+            headBytes = 0;
+        }
+
+        headBytes = std::min( headBytes, bytesToCopy );
+
+        size_t  numElements = ( bytesToCopy - headBytes ) / elementSize;
+        size_t  tailBytes = bytesToCopy - headBytes - numElements * elementSize;
+
+        errorCode |= dispatch().clSetKernelArg(
+            kernel,
+            0,
+            sizeof( srcBuffer ),
+            &srcBuffer );
+        errorCode |= dispatch().clSetKernelArg(
+            kernel,
+            1,
+            sizeof( dstBuffer ),
+            &dstBuffer );
+
+        cl_uint uiArg = (cl_uint)( srcOffset );
+        errorCode |= dispatch().clSetKernelArg(
+            kernel,
+            2,
+            sizeof( uiArg ),
+            &uiArg );
+        uiArg = (cl_uint)( dstOffset );
+        errorCode |= dispatch().clSetKernelArg(
+            kernel,
+            3,
+            sizeof( uiArg ),
+            &uiArg );
+        uiArg = (cl_uint)( headBytes );
+        errorCode |= dispatch().clSetKernelArg(
+            kernel,
+            4,
+            sizeof( uiArg ),
+            &uiArg );
+        uiArg = (cl_uint)( numElements );
+        errorCode |= dispatch().clSetKernelArg(
+            kernel,
+            5,
+            sizeof( uiArg ),
+            &uiArg );
+        uiArg = (cl_uint)( tailBytes );
+        errorCode |= dispatch().clSetKernelArg(
+            kernel,
+            6,
+            sizeof( uiArg ),
+            &uiArg );
+
+        if( errorCode == CL_SUCCESS )
+        {
+            // Each work-item copies several elements, so small copies use
+            // fewer work-items and large copies amortize the per-work-item
+            // index computations.  There is always at least one work-group,
+            // to copy the head and tail bytes.
+            const size_t    elementsPerWorkItem = 4;
+
+            size_t  global_work_size =
+                ( numElements + elementsPerWorkItem - 1 ) / elementsPerWorkItem;
+            size_t  local_work_size = 32;
+
+            // Make sure global_work_size is a nonzero even multiple of
+            // local_work_size
+            if( ( global_work_size % local_work_size ) != 0 ||
+                global_work_size == 0 )
+            {
+                global_work_size +=
+                    local_work_size -
+                    ( global_work_size % local_work_size );
+            }
+
+            // Execute kernel
+            errorCode = dispatch().clEnqueueNDRangeKernel(
+                commandQueue,
+                kernel,
+                1,
+                NULL,
+                &global_work_size,
+                &local_work_size,
+                numEventsInWaitList,
+                eventWaitList,
+                event );
+        }
+    }
+
+    return errorCode;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+cl_int CLIntercept::CopyBufferRect(
+    cl_command_queue commandQueue,
+    cl_mem srcBuffer,
+    cl_mem dstBuffer,
+    const size_t* srcOrigin,
+    const size_t* dstOrigin,
+    const size_t* region,
+    size_t srcRowPitch,
+    size_t srcSlicePitch,
+    size_t dstRowPitch,
+    size_t dstSlicePitch,
+    cl_uint numEventsInWaitList,
+    const cl_event* eventWaitList,
+    cl_event* event )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    cl_int  errorCode = CL_SUCCESS;
+
+    // Basic error checking, to avoid possible null pointer dereferences.
+    if( errorCode == CL_SUCCESS )
+    {
+        if( srcOrigin == NULL || dstOrigin == NULL || region == NULL )
+        {
+            errorCode = CL_INVALID_VALUE;
+        }
+    }
+
+    cl_context  context = NULL;
+
+    // Get the context for this command queue.
+    if( errorCode == CL_SUCCESS )
+    {
+        errorCode = dispatch().clGetCommandQueueInfo(
+            commandQueue,
+            CL_QUEUE_CONTEXT,
+            sizeof( context ),
+            &context,
+            NULL );
+    }
+
     SPrecompiledKernelOverrides*    pOverrides = NULL;
 
-    // Get the overrides for this context.
+    // Get the overrides for this context and device.
     if( errorCode == CL_SUCCESS )
     {
-        pOverrides = m_PrecompiledKernelOverridesMap[ context ];
-        if( pOverrides == NULL )
+        pOverrides = getPrecompiledKernelOverrides( context, commandQueue );
+        if( pOverrides == NULL ||
+            pOverrides->Kernel_CopyBufferRect == NULL )
         {
             errorCode = CL_INVALID_VALUE;
         }
     }
 
-    if( false &&    // disabled - this kernel is slower than the UInt4 kernel
-        ( m_Config.ForceByteBufferOverrides == false ) &&
-        ( ( srcOffset % 64 ) == 0 ) &&
-        ( ( dstOffset % 64 ) == 0 ) )
+    if( errorCode == CL_SUCCESS )
     {
-        if( errorCode == CL_SUCCESS )
+        // Compute the default pitches the same way as
+        // clEnqueueCopyBufferRect().
+        if( srcRowPitch == 0 )
         {
-            errorCode |= dispatch().clSetKernelArg(
-                pOverrides->Kernel_CopyBufferUInt16s,
-                0,
-                sizeof( srcBuffer ),
-                &srcBuffer );
-            errorCode |= dispatch().clSetKernelArg(
-                pOverrides->Kernel_CopyBufferUInt16s,
-                1,
-                sizeof( dstBuffer ),
-                &dstBuffer );
-
-            cl_uint uiSrcOffsetInUint16s = (cl_uint)( srcOffset / 64 );
-            errorCode |= dispatch().clSetKernelArg(
-                pOverrides->Kernel_CopyBufferUInt16s,
-                2,
-                sizeof( uiSrcOffsetInUint16s ),
-                &uiSrcOffsetInUint16s );
-
-            cl_uint uiDstOffsetInUint16s = (cl_uint)( dstOffset / 64 );
-            errorCode |= dispatch().clSetKernelArg(
-                pOverrides->Kernel_CopyBufferUInt16s,
-                3,
-                sizeof( uiDstOffsetInUint16s ),
-                &uiDstOffsetInUint16s );
-
-            cl_uint uiBytesToCopy = (cl_uint)( bytesToCopy );
-            errorCode |= dispatch().clSetKernelArg(
-                pOverrides->Kernel_CopyBufferUInt16s,
-                4,
-                sizeof( uiBytesToCopy ),
-                &uiBytesToCopy );
-
-            if( errorCode == CL_SUCCESS )
-            {
-                size_t  global_work_size = bytesToCopy / 64;
-                size_t  local_work_size = 32;
-
-                // Round up if we don't have an even multiple of UInt16s
-                if( ( bytesToCopy % 64 ) != 0 )
-                {
-                    global_work_size++;
-                }
-
-                // Make sure global_work_size is an even multiple of local_work_size
-                if( ( global_work_size % local_work_size ) != 0 )
-                {
-                    global_work_size +=
-                        local_work_size -
-                        ( global_work_size % local_work_size );
-                }
-
-                // Execute kernel
-                errorCode = dispatch().clEnqueueNDRangeKernel(
-                    commandQueue,
-                    pOverrides->Kernel_CopyBufferUInt16s,
-                    1,
-                    NULL,
-                    &global_work_size,
-                    &local_work_size,
-                    numEventsInWaitList,
-                    eventWaitList,
-                    event );
-            }
+            srcRowPitch = region[0];
         }
-    }
-    else if( ( m_Config.ForceByteBufferOverrides == false ) &&
-             ( ( srcOffset % 16 ) == 0 ) &&
-             ( ( dstOffset % 16 ) == 0 ) )
-    {
-        if( errorCode == CL_SUCCESS )
+        if( srcSlicePitch == 0 )
         {
-            errorCode |= dispatch().clSetKernelArg(
-                pOverrides->Kernel_CopyBufferUInt4s,
-                0,
-                sizeof( srcBuffer ),
-                &srcBuffer );
-            errorCode |= dispatch().clSetKernelArg(
-                pOverrides->Kernel_CopyBufferUInt4s,
-                1,
-                sizeof( dstBuffer ),
-                &dstBuffer );
-
-            cl_uint uiSrcOffsetInUint4s = (cl_uint)( srcOffset / 16 );
-            errorCode |= dispatch().clSetKernelArg(
-                pOverrides->Kernel_CopyBufferUInt4s,
-                2,
-                sizeof( uiSrcOffsetInUint4s ),
-                &uiSrcOffsetInUint4s );
-
-            cl_uint uiDstOffsetInUint4s = (cl_uint)( dstOffset / 16 );
-            errorCode |= dispatch().clSetKernelArg(
-                pOverrides->Kernel_CopyBufferUInt4s,
-                3,
-                sizeof( uiDstOffsetInUint4s ),
-                &uiDstOffsetInUint4s );
-
-            cl_uint uiBytesToCopy = (cl_uint)( bytesToCopy );
-            errorCode |= dispatch().clSetKernelArg(
-                pOverrides->Kernel_CopyBufferUInt4s,
-                4,
-                sizeof( uiBytesToCopy ),
-                &uiBytesToCopy );
-
-            if( errorCode == CL_SUCCESS )
-            {
-                size_t  global_work_size = bytesToCopy / 16;
-                size_t  local_work_size = 32;
-
-                // Round up if we don't have an even multiple of UInt4s
-                if( ( bytesToCopy % 16 ) != 0 )
-                {
-                    global_work_size++;
-                }
-
-                // Make sure global_work_size is an even multiple of local_work_size
-                if( ( global_work_size % local_work_size ) != 0 )
-                {
-                    global_work_size +=
-                        local_work_size -
-                        ( global_work_size % local_work_size );
-                }
-
-                // Execute kernel
-                errorCode = dispatch().clEnqueueNDRangeKernel(
-                    commandQueue,
-                    pOverrides->Kernel_CopyBufferUInt4s,
-                    1,
-                    NULL,
-                    &global_work_size,
-                    &local_work_size,
-                    numEventsInWaitList,
-                    eventWaitList,
-                    event );
-            }
+            srcSlicePitch = region[1] * srcRowPitch;
         }
-    }
-    else if( ( m_Config.ForceByteBufferOverrides == false ) &&
-             ( ( srcOffset % 4 ) == 0 ) &&
-             ( ( dstOffset % 4 ) == 0 ) )
-    {
-        if( errorCode == CL_SUCCESS )
+        if( dstRowPitch == 0 )
         {
-            errorCode |= dispatch().clSetKernelArg(
-                pOverrides->Kernel_CopyBufferUInts,
-                0,
-                sizeof( srcBuffer ),
-                &srcBuffer );
-            errorCode |= dispatch().clSetKernelArg(
-                pOverrides->Kernel_CopyBufferUInts,
-                1,
-                sizeof( dstBuffer ),
-                &dstBuffer );
-
-            cl_uint uiSrcOffsetInUints = (cl_uint)( srcOffset / 4 );
-            errorCode |= dispatch().clSetKernelArg(
-                pOverrides->Kernel_CopyBufferUInts,
-                2,
-                sizeof( uiSrcOffsetInUints ),
-                &uiSrcOffsetInUints );
-
-            cl_uint uiDstOffsetInUints = (cl_uint)( dstOffset / 4 );
-            errorCode |= dispatch().clSetKernelArg(
-                pOverrides->Kernel_CopyBufferUInts,
-                3,
-                sizeof( uiDstOffsetInUints ),
-                &uiDstOffsetInUints );
+            dstRowPitch = region[0];
+        }
+        if( dstSlicePitch == 0 )
+        {
+            dstSlicePitch = region[1] * dstRowPitch;
+        }
 
-            cl_uint uiBytesToCopy = (cl_uint)( bytesToCopy );
-            errorCode |= dispatch().clSetKernelArg(
-                pOverrides->Kernel_CopyBufferUInts,
-                4,
-                sizeof( uiBytesToCopy ),
-                &uiBytesToCopy );
+        size_t  srcOffset =
+            srcOrigin[2] * srcSlicePitch +
+            srcOrigin[1] * srcRowPitch +
+            srcOrigin[0];
+        size_t  dstOffset =
+            dstOrigin[2] * dstSlicePitch +
+            dstOrigin[1] * dstRowPitch +
+            dstOrigin[0];
 
-            if( errorCode == CL_SUCCESS )
-            {
-                size_t  global_work_size = bytesToCopy / 4;
-                size_t  local_work_size = 32;
+        cl_kernel   kernel = pOverrides->Kernel_CopyBufferRect;
 
-                // Round up if we don't have an even multiple of UInts
-                if( ( bytesToCopy % 4 ) != 0 )
-                {
-                    global_work_size++;
-                }
+        errorCode |= dispatch().clSetKernelArg(
+            kernel,
+            0,
+            sizeof( srcBuffer ),
+            &srcBuffer );
+        errorCode |= dispatch().clSetKernelArg(
+            kernel,
+            1,
+            sizeof( dstBuffer ),
+            &dstBuffer );
 
-                // Make sure global_work_size is an even multiple of local_work_size
-                if( ( global_work_size % local_work_size ) != 0 )
-                {
-                    global_work_size +=
-                        local_work_size -
-                        ( global_work_size % local_work_size );
-                }
+        cl_uint uiArg = (cl_uint)( srcOffset );
+        errorCode |= dispatch().clSetKernelArg(
+            kernel,
+            2,
+            sizeof( uiArg ),
+            &uiArg );
+        uiArg = (cl_uint)( srcRowPitch );
+        errorCode |= dispatch().clSetKernelArg(
+            kernel,
+            3,
+            sizeof( uiArg ),
+            &uiArg );
+        uiArg = (cl_uint)( srcSlicePitch );
+        errorCode |= dispatch().clSetKernelArg(
+            kernel,
+            4,
+            sizeof( uiArg ),
+            &uiArg );
+
+        uiArg = (cl_uint)( dstOffset );
+        errorCode |= dispatch().clSetKernelArg(
+            kernel,
+            5,
+            sizeof( uiArg ),
+            &uiArg );
+        uiArg = (cl_uint)( dstRowPitch );
+        errorCode |= dispatch().clSetKernelArg(
+            kernel,
+            6,
+            sizeof( uiArg ),
+            &uiArg );
+        uiArg = (cl_uint)( dstSlicePitch );
+        errorCode |= dispatch().clSetKernelArg(
+            kernel,
+            7,
+            sizeof( uiArg ),
+            &uiArg );
+
+        uiArg = (cl_uint)( region[0] );
+        errorCode |= dispatch().clSetKernelArg(
+            kernel,
+            8,
+            sizeof( uiArg ),
+            &uiArg );
+        uiArg = (cl_uint)( region[1] );
+        errorCode |= dispatch().clSetKernelArg(
+            kernel,
+            9,
+            sizeof( uiArg ),
+            &uiArg );
+        uiArg = (cl_uint)( region[2] );
+        errorCode |= dispatch().clSetKernelArg(
+            kernel,
+            10,
+            sizeof( uiArg ),
+            &uiArg );
 
-                // Execute kernel
-                errorCode = dispatch().clEnqueueNDRangeKernel(
-                    commandQueue,
-                    pOverrides->Kernel_CopyBufferUInts,
-                    1,
-                    NULL,
-                    &global_work_size,
-                    &local_work_size,
-                    numEventsInWaitList,
-                    eventWaitList,
-                    event );
-            }
-        }
-    }
-    else
-    {
         if( errorCode == CL_SUCCESS )
         {
-            errorCode |= dispatch().clSetKernelArg(
-                pOverrides->Kernel_CopyBufferBytes,
-                0,
-                sizeof( srcBuffer ),
-                &srcBuffer );
-            errorCode |= dispatch().clSetKernelArg(
-                pOverrides->Kernel_CopyBufferBytes,
+            // Each work-item copies sixteen bytes of a row.
+            size_t  global_work_size[3] =
+            {
+                ( region[0] + 15 ) / 16,
+                region[1],
+                region[2]
+            };
+            size_t  local_work_size[3] =
+            {
+                32,
                 1,
-                sizeof( dstBuffer ),
-                &dstBuffer );
-
-            cl_uint uiSrcOffset = (cl_uint)( srcOffset );
-            errorCode |= dispatch().clSetKernelArg(
-                pOverrides->Kernel_CopyBufferBytes,
-                2,
-                sizeof( uiSrcOffset ),
-                &uiSrcOffset );
-
-            cl_uint uiDstOffset = (cl_uint)( dstOffset );
-            errorCode |= dispatch().clSetKernelArg(
-                pOverrides->Kernel_CopyBufferBytes,
-                3,
-                sizeof( uiDstOffset ),
-                &uiDstOffset );
-
-            cl_uint uiBytesToCopy = (cl_uint)( bytesToCopy );
-            errorCode |= dispatch().clSetKernelArg(
-                pOverrides->Kernel_CopyBufferBytes,
-                4,
-                sizeof( uiBytesToCopy ),
-                &uiBytesToCopy );
+                1
+            };
 
-            if( errorCode == CL_SUCCESS )
+            // Make sure global_work_size is an even multiple of local_work_size
+            if( ( global_work_size[0] % local_work_size[0] ) != 0 )
             {
-                size_t  global_work_size = bytesToCopy;
-                size_t  local_work_size = 32;
-
-                // Make sure global_work_size is an even multiple of local_work_size
-                if( ( global_work_size % local_work_size ) != 0 )
-                {
-                    global_work_size +=
-                        local_work_size -
-                        ( global_work_size % local_work_size );
-                }
-
-                // Execute kernel
-                errorCode = dispatch().clEnqueueNDRangeKernel(
-                    commandQueue,
-                    pOverrides->Kernel_CopyBufferBytes,
-                    1,
-                    NULL,
-                    &global_work_size,
-                    &local_work_size,
-                    numEventsInWaitList,
-                    eventWaitList,
-                    event );
+                global_work_size[0] +=
+                    local_work_size[0] -
+                    ( global_work_size[0] % local_work_size[0] );
             }
+
+            // Execute kernel
+            errorCode = dispatch().clEnqueueNDRangeKernel(
+                commandQueue,
+                kernel,
+                3,
+                NULL,
+                global_work_size,
+                local_work_size,
+                numEventsInWaitList,
+                eventWaitList,
+                event );
         }
     }
 
@@ -12812,10 +16626,10 @@ cl_int CLIntercept::CopyImageHelper(
 
     SPrecompiledKernelOverrides*    pOverrides = NULL;
 
-    // Get the overrides for this context.
+    // Get the overrides for this context and device.
     if( errorCode == CL_SUCCESS )
     {
-        pOverrides = m_PrecompiledKernelOverridesMap[ context ];
+        pOverrides = getPrecompiledKernelOverrides( context, commandQueue );
         if( pOverrides == NULL )
         {
             errorCode = CL_INVALID_VALUE;
@@ -12839,7 +16653,7 @@ cl_int CLIntercept::CopyImageHelper(
     if( errorCode == CL_SUCCESS )
     {
         errorCode = dispatch().clGetMemObjectInfo(
-            srcImage,
+            dstImage,
             CL_MEM_TYPE,
             sizeof( dstType ),
             &dstType,
@@ -12910,7 +16724,10 @@ cl_int CLIntercept::CopyImageHelper(
         }
     }
 
-    cl_kernel   kernel = NULL;
+    cl_kernel   kernel2Dto2D = NULL;
+    cl_kernel   kernel2Dto3D = NULL;
+    cl_kernel   kernel3Dto2D = NULL;
+    cl_kernel   kernel3Dto3D = NULL;
     if( errorCode == CL_SUCCESS )
     {
         switch( srcFormat.image_channel_data_type )
@@ -12922,78 +16739,30 @@ cl_int CLIntercept::CopyImageHelper(
         case CL_HALF_FLOAT:
         case CL_FLOAT:
             // "Float" Images
-            switch( srcType )
-            {
-            case CL_MEM_OBJECT_IMAGE2D:
-                switch( dstType )
-                {
-                case CL_MEM_OBJECT_IMAGE2D:
-                    // 2D to 2D
-                    kernel = pOverrides->Kernel_CopyImage2Dto2DFloat;
-                    break;
-                default:
-                    CLI_ASSERT( 0 );
-                    errorCode = CL_INVALID_OPERATION;
-                    break;
-                }
-                break;
-            default:
-                CLI_ASSERT( 0 );
-                errorCode = CL_INVALID_OPERATION;
-                break;
-            }
+            kernel2Dto2D = pOverrides->Kernel_CopyImage2Dto2DFloat;
+            kernel2Dto3D = pOverrides->Kernel_CopyImage2Dto3DFloat;
+            kernel3Dto2D = pOverrides->Kernel_CopyImage3Dto2DFloat;
+            kernel3Dto3D = pOverrides->Kernel_CopyImage3Dto3DFloat;
             break;
 
         case CL_SIGNED_INT8:
         case CL_SIGNED_INT16:
         case CL_SIGNED_INT32:
             // "Int" Images
-            switch( srcType )
-            {
-            case CL_MEM_OBJECT_IMAGE2D:
-                switch( dstType )
-                {
-                case CL_MEM_OBJECT_IMAGE2D:
-                    // 2D to 2D
-                    kernel = pOverrides->Kernel_CopyImage2Dto2DInt;
-                    break;
-                default:
-                    CLI_ASSERT( 0 );
-                    errorCode = CL_INVALID_OPERATION;
-                    break;
-                }
-                break;
-            default:
-                CLI_ASSERT( 0 );
-                errorCode = CL_INVALID_OPERATION;
-                break;
-            }
+            kernel2Dto2D = pOverrides->Kernel_CopyImage2Dto2DInt;
+            kernel2Dto3D = pOverrides->Kernel_CopyImage2Dto3DInt;
+            kernel3Dto2D = pOverrides->Kernel_CopyImage3Dto2DInt;
+            kernel3Dto3D = pOverrides->Kernel_CopyImage3Dto3DInt;
             break;
 
         case CL_UNSIGNED_INT8:
         case CL_UNSIGNED_INT16:
         case CL_UNSIGNED_INT32:
             // "UInt" Images
-            switch( srcType )
-            {
-            case CL_MEM_OBJECT_IMAGE2D:
-                switch( dstType )
-                {
-                case CL_MEM_OBJECT_IMAGE2D:
-                    // 2D to 2D
-                    kernel = pOverrides->Kernel_CopyImage2Dto2DUInt;
-                    break;
-                default:
-                    CLI_ASSERT( 0 );
-                    errorCode = CL_INVALID_OPERATION;
-                    break;
-                }
-                break;
-            default:
-                CLI_ASSERT( 0 );
-                errorCode = CL_INVALID_OPERATION;
-                break;
-            }
+            kernel2Dto2D = pOverrides->Kernel_CopyImage2Dto2DUInt;
+            kernel2Dto3D = pOverrides->Kernel_CopyImage2Dto3DUInt;
+            kernel3Dto2D = pOverrides->Kernel_CopyImage3Dto2DUInt;
+            kernel3Dto3D = pOverrides->Kernel_CopyImage3Dto3DUInt;
             break;
 
         default:
@@ -13003,6 +16772,32 @@ cl_int CLIntercept::CopyImageHelper(
         }
     }
 
+    // The source and destination types were validated above, so each must
+    // be either a 2D image or a 3D image.  The kernels that write to 3D
+    // images may not exist, if the device does not support writing to 3D
+    // images.
+    cl_kernel   kernel = NULL;
+    if( errorCode == CL_SUCCESS )
+    {
+        if( srcType == CL_MEM_OBJECT_IMAGE2D )
+        {
+            kernel = ( dstType == CL_MEM_OBJECT_IMAGE2D ) ?
+                kernel2Dto2D :
+                kernel2Dto3D;
+        }
+        else
+        {
+            kernel = ( dstType == CL_MEM_OBJECT_IMAGE2D ) ?
+                kernel3Dto2D :
+                kernel3Dto3D;
+        }
+
+        if( kernel == NULL )
+        {
+            errorCode = CL_INVALID_OPERATION;
+        }
+    }
+
     if( errorCode == CL_SUCCESS )
     {
         errorCode |= dispatch().clSetKernelArg(
@@ -13118,13 +16913,34 @@ cl_int CLIntercept::CopyImageHelper(
 ///////////////////////////////////////////////////////////////////////////////
 //
 cl_program CLIntercept::createProgramWithBuiltinKernels(
-    cl_context context )
+    cl_context context,
+    cl_uint numDevices,
+    const cl_device_id* devices )
 {
     std::lock_guard<std::mutex> lock(m_Mutex);
 
     cl_program  program = NULL;
 
-    SBuiltinKernelOverrides*    pOverrides = m_BuiltinKernelOverridesMap[ context ];
+    // Build the overrides for the one requested device, if possible, or for
+    // all of the devices in the context otherwise.
+    const CKernelOverridesKey   key(
+        context,
+        ( numDevices == 1 && devices != NULL ) ? devices[0] : NULL );
+
+    SBuiltinKernelOverrides*    pOverrides = NULL;
+
+    CBuiltinKernelOverridesMap::iterator iter =
+        m_BuiltinKernelOverridesMap.find( key );
+    if( iter != m_BuiltinKernelOverridesMap.end() )
+    {
+        pOverrides = iter->second;
+    }
+    else
+    {
+        pOverrides = initBuiltinKernelOverrides( key.first, key.second );
+        m_BuiltinKernelOverridesMap[ key ] = pOverrides;
+    }
+
     if( pOverrides )
     {
         program = pOverrides->Program;
@@ -13161,10 +16977,23 @@ cl_kernel CLIntercept::createBuiltinKernel(
 
     SBuiltinKernelOverrides*    pOverrides = NULL;
 
-    // Get the overrides for this context.
+    // Get the overrides for this program.
     if( errorCode == CL_SUCCESS )
     {
-        pOverrides = m_BuiltinKernelOverridesMap[ context ];
+        CBuiltinKernelOverridesMap::iterator iter =
+            m_BuiltinKernelOverridesMap.lower_bound(
+                CKernelOverridesKey( context, NULL ) );
+        while( iter != m_BuiltinKernelOverridesMap.end() &&
+               iter->first.first == context )
+        {
+            if( iter->second && iter->second->Program == program )
+            {
+                pOverrides = iter->second;
+                break;
+            }
+            ++iter;
+        }
+
         if( pOverrides != NULL )
         {
             if( kernel_name == "block_motion_estimate_intel" )
@@ -13213,10 +17042,24 @@ cl_int CLIntercept::NDRangeBuiltinKernel(
 
     SBuiltinKernelOverrides*    pOverrides = NULL;
 
-    // Get the overrides for this context.
+    // Get the overrides for this kernel.
     if( errorCode == CL_SUCCESS )
     {
-        pOverrides = m_BuiltinKernelOverridesMap[ context ];
+        CBuiltinKernelOverridesMap::iterator iter =
+            m_BuiltinKernelOverridesMap.lower_bound(
+                CKernelOverridesKey( context, NULL ) );
+        while( iter != m_BuiltinKernelOverridesMap.end() &&
+               iter->first.first == context )
+        {
+            if( iter->second &&
+                iter->second->Kernel_block_motion_estimate_intel == kernel )
+            {
+                pOverrides = iter->second;
+                break;
+            }
+            ++iter;
+        }
+
         if( pOverrides == NULL )
         {
             errorCode = CL_INVALID_VALUE;
@@ -13267,13 +17110,497 @@ cl_int CLIntercept::NDRangeBuiltinKernel(
                 }
             }
         }
-        else
+        else
+        {
+            errorCode = CL_INVALID_VALUE;
+        }
+    }
+
+    return errorCode;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+cl_int CLIntercept::NDRangeHotReloadKernel(
+    cl_command_queue commandQueue,
+    cl_kernel kernel,
+    cl_uint work_dim,
+    const size_t* global_work_offset,
+    const size_t* global_work_size,
+    const size_t* local_work_size,
+    cl_uint num_events_in_wait_list,
+    const cl_event* event_wait_list,
+    cl_event* event )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    if( m_HotReloadProgramInfoMap.empty() )
+    {
+        return CL_INVALID_OPERATION;
+    }
+
+    // Check for modified source files on a worker thread, so the application
+    // thread never waits for a program to be rebuilt.
+    const cl_uint   intervalMS = config().InjectProgramHotReloadIntervalMS;
+    clock::time_point   now = clock::now();
+    if( !m_HotReloadCheckPending &&
+        !m_ThreadPoolShutdown &&
+        now - m_HotReloadCheckTime >= std::chrono::milliseconds(intervalMS) )
+    {
+        m_HotReloadCheckPending = true;
+        m_ThreadPool.start();
+        m_ThreadPool.enqueue(
+            [this]() {
+                checkHotReloadPrograms();
+            } );
+    }
+
+    cl_program  program = NULL;
+    cl_int  errorCode = dispatch().clGetKernelInfo(
+        kernel,
+        CL_KERNEL_PROGRAM,
+        sizeof( program ),
+        &program,
+        NULL );
+    if( errorCode != CL_SUCCESS )
+    {
+        return errorCode;
+    }
+    program = findBinaryCacheKernelProgram( kernel, program );
+
+    CHotReloadProgramInfoMap::const_iterator iter =
+        m_HotReloadProgramInfoMap.find( program );
+    if( iter == m_HotReloadProgramInfoMap.end() ||
+        iter->second.Program == NULL )
+    {
+        return CL_INVALID_OPERATION;
+    }
+
+    const SHotReloadProgramInfo&    programInfo = iter->second;
+    SHotReloadKernelInfo&   reloadInfo = m_HotReloadKernelInfoMap[ kernel ];
+
+    // The rebuilt program has changed since the last enqueue of this kernel,
+    // so swap in the kernel from the new program.
+    if( reloadInfo.Generation != programInfo.Generation )
+    {
+        if( reloadInfo.Kernel )
+        {
+            dispatch().clReleaseKernel( reloadInfo.Kernel );
+            reloadInfo.Kernel = NULL;
+        }
+        reloadInfo.Generation = programInfo.Generation;
+
+        size_t  nameSize = 0;
+        dispatch().clGetKernelInfo(
+            kernel,
+            CL_KERNEL_FUNCTION_NAME,
+            0,
+            NULL,
+            &nameSize );
+
+        std::vector<char>   name( nameSize + 1 );
+        errorCode = dispatch().clGetKernelInfo(
+            kernel,
+            CL_KERNEL_FUNCTION_NAME,
+            nameSize,
+            name.data(),
+            NULL );
+        if( errorCode == CL_SUCCESS )
+        {
+            reloadInfo.Kernel = dispatch().clCreateKernel(
+                programInfo.Program,
+                name.data(),
+                &errorCode );
+        }
+        if( errorCode == CL_SUCCESS )
+        {
+            logf( "Using hot reloaded kernel %s from %s.\n",
+                name.data(),
+                programInfo.FileName.c_str() );
+        }
+        else
+        {
+            logf( "Kernel %s could not be created from hot reloaded program %s: %s (%d)!  Using the original kernel.\n",
+                name.data(),
+                programInfo.FileName.c_str(),
+                enumName().name( errorCode ).c_str(),
+                errorCode );
+            reloadInfo.Kernel = NULL;
+        }
+    }
+
+    if( reloadInfo.Kernel == NULL )
+    {
+        return CL_INVALID_OPERATION;
+    }
+
+    // The kernel arguments are set every time since the application may have
+    // set new arguments for its kernel since the last enqueue.
+    errorCode = setHotReloadKernelArgs(
+        kernel,
+        reloadInfo.Kernel );
+    if( errorCode == CL_SUCCESS )
+    {
+        errorCode = dispatch().clEnqueueNDRangeKernel(
+            commandQueue,
+            reloadInfo.Kernel,
+            work_dim,
+            global_work_offset,
+            global_work_size,
+            local_work_size,
+            num_events_in_wait_list,
+            event_wait_list,
+            event );
+    }
+
+    return errorCode;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+cl_int CLIntercept::setHotReloadKernelArgs(
+    const cl_kernel kernel,
+    const cl_kernel reloadKernel )
+{
+    // We're already in a critical section when we get here, so we don't need to
+    // grab the critical section again.
+
+    cl_uint numArgs = 0;
+    cl_int  errorCode = dispatch().clGetKernelInfo(
+        kernel,
+        CL_KERNEL_NUM_ARGS,
+        sizeof( numArgs ),
+        &numArgs,
+        NULL );
+    if( errorCode != CL_SUCCESS )
+    {
+        return errorCode;
+    }
+
+    CKernelInfoMap::const_iterator iter = m_KernelInfoMap.find( kernel );
+    if( iter == m_KernelInfoMap.end() ||
+        iter->second.Args.size() < numArgs )
+    {
+        return CL_INVALID_KERNEL_ARGS;
+    }
+
+    const CKernelArgInfoVector& args = iter->second.Args;
+    for( cl_uint i = 0; i < numArgs && errorCode == CL_SUCCESS; i++ )
+    {
+        const SKernelArgInfo&   argInfo = args[ i ];
+        if( argInfo.IsLocal )
+        {
+            errorCode = dispatch().clSetKernelArg(
+                reloadKernel,
+                i,
+                argInfo.LocalSize,
+                NULL );
+        }
+        else if( !argInfo.HasData )
+        {
+            // This argument was never set, or is a pointer into the middle
+            // of an SVM or USM allocation, which is not tracked.
+            errorCode = CL_INVALID_KERNEL_ARGS;
+        }
+        else if( argInfo.Allocation &&
+                 m_SVMAllocInfoMap.findBase( argInfo.Allocation ) )
+        {
+            errorCode = dispatch().clSetKernelArgSVMPointer(
+                reloadKernel,
+                i,
+                argInfo.Allocation );
+        }
+        else if( argInfo.Allocation &&
+                 m_USMAllocInfoMap.findBase( argInfo.Allocation ) )
+        {
+            const auto& dispatchX = this->dispatchX( reloadKernel );
+            if( dispatchX.clSetKernelArgMemPointerINTEL == NULL )
+            {
+                errorCode = CL_INVALID_OPERATION;
+            }
+            else
+            {
+                errorCode = dispatchX.clSetKernelArgMemPointerINTEL(
+                    reloadKernel,
+                    i,
+                    argInfo.Allocation );
+            }
+        }
+        else
+        {
+            errorCode = dispatch().clSetKernelArg(
+                reloadKernel,
+                i,
+                argInfo.DataSize,
+                argInfo.getData() );
+        }
+    }
+
+    if( errorCode != CL_SUCCESS )
+    {
+        logf( "Couldn't set kernel arguments for hot reloaded kernel: %s (%d)!  Using the original kernel.\n",
+            enumName().name( errorCode ).c_str(),
+            errorCode );
+        return errorCode;
+    }
+
+    // Exec info that is emulated by the intercept layer is applied to the
+    // application's kernel when it is enqueued, so it can't be copied to
+    // the hot reloaded kernel.
+    CUSMKernelInfoMap::const_iterator usmIter = m_USMKernelInfoMap.find( kernel );
+    if( usmIter != m_USMKernelInfoMap.end() )
+    {
+        const SUSMKernelInfo&   usmKernelInfo = usmIter->second;
+        if( usmKernelInfo.IndirectHostAccess ||
+            usmKernelInfo.IndirectDeviceAccess ||
+            usmKernelInfo.IndirectSharedAccess ||
+            !usmKernelInfo.SVMPtrs.empty() ||
+            !usmKernelInfo.USMPtrs.empty() )
+        {
+            log( "Couldn't set emulated kernel exec info for hot reloaded kernel!  Using the original kernel.\n" );
+            return CL_INVALID_OPERATION;
+        }
+    }
+
+    for( const auto& execInfo : iter->second.ExecInfo )
+    {
+        if( config().Emulate_cl_intel_unified_shared_memory &&
+            ( execInfo.first == CL_KERNEL_EXEC_INFO_INDIRECT_HOST_ACCESS_INTEL ||
+              execInfo.first == CL_KERNEL_EXEC_INFO_INDIRECT_DEVICE_ACCESS_INTEL ||
+              execInfo.first == CL_KERNEL_EXEC_INFO_INDIRECT_SHARED_ACCESS_INTEL ) )
+        {
+            continue;
+        }
+
+        errorCode = dispatch().clSetKernelExecInfo(
+            reloadKernel,
+            execInfo.first,
+            execInfo.second.size(),
+            execInfo.second.empty() ? NULL : execInfo.second.data() );
+        if( errorCode != CL_SUCCESS )
+        {
+            logf( "Couldn't set kernel exec info %s for hot reloaded kernel: %s (%d)!  Using the original kernel.\n",
+                enumName().name( execInfo.first ).c_str(),
+                enumName().name( errorCode ).c_str(),
+                errorCode );
+            break;
+        }
+    }
+
+    return errorCode;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::checkHotReloadPrograms()
+{
+    struct SCandidate
+    {
+        cl_program      Program;
+        std::string     FileName1;
+        std::string     FileName2;
+    };
+
+    std::vector<SCandidate> candidates;
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        if( m_ThreadPoolShutdown )
+        {
+            return;
+        }
+
+        for( const auto& iter : m_HotReloadProgramInfoMap )
+        {
+            SCandidate  candidate;
+            candidate.Program = iter.first;
+            candidate.FileName1 = iter.second.FileName1;
+            candidate.FileName2 = iter.second.FileName2;
+            candidates.push_back( candidate );
+        }
+    }
+
+    // The Inject directory is checked and programs are rebuilt without
+    // holding the lock, so the application's threads can continue to enqueue
+    // kernels from the original or previously rebuilt programs.
+    for( const auto& candidate : candidates )
+    {
+        std::string fileName = candidate.FileName1;
+        uint64_t    fileSize = 0;
+        uint64_t    modifiedTime = 0;
+        if( !OS().GetFileInfo( fileName, fileSize, modifiedTime ) )
+        {
+            fileName = candidate.FileName2;
+            if( !OS().GetFileInfo( fileName, fileSize, modifiedTime ) )
+            {
+                continue;
+            }
+        }
+
+        cl_context  context = NULL;
+        std::vector<cl_device_id>   devices;
+        std::string options;
+
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+
+            CHotReloadProgramInfoMap::iterator iter =
+                m_HotReloadProgramInfoMap.find( candidate.Program );
+            if( m_ThreadPoolShutdown ||
+                iter == m_HotReloadProgramInfoMap.end() )
+            {
+                continue;
+            }
+
+            SHotReloadProgramInfo&  reloadInfo = iter->second;
+            if( reloadInfo.FileName == fileName &&
+                reloadInfo.ModifiedTime == modifiedTime )
+            {
+                continue;
+            }
+
+            // Record the file even if the build fails, so a broken file is
+            // not rebuilt again until it is modified.
+            reloadInfo.FileName = fileName;
+            reloadInfo.ModifiedTime = modifiedTime;
+
+            context = reloadInfo.Context;
+            devices = reloadInfo.Devices;
+            options = reloadInfo.Options;
+
+            // Keep the context alive while the program is rebuilt, in case
+            // the application releases its program in the meantime.
+            dispatch().clRetainContext( context );
+
+            log( "Hot reloading program source file: " + fileName + "\n" );
+        }
+
+        std::string source;
+        {
+            std::ifstream is;
+            is.open(
+                fileName.c_str(),
+                std::ios::in | std::ios::binary );
+            if( is.good() )
+            {
+                is.seekg(0, std::ios::end);
+                source.resize( (size_t)is.tellg() );
+                is.seekg(0, std::ios::beg);
+                is.read( &source[0], source.size() );
+                is.close();
+            }
+        }
+
+        const char* sourceString = source.c_str();
+        size_t      sourceLength = source.length();
+
+        cl_int  errorCode = CL_SUCCESS;
+        cl_program  newProgram = dispatch().clCreateProgramWithSource(
+            context,
+            1,
+            &sourceString,
+            &sourceLength,
+            &errorCode );
+        if( errorCode == CL_SUCCESS )
+        {
+            errorCode = dispatch().clBuildProgram(
+                newProgram,
+                (cl_uint)devices.size(),
+                devices.empty() ? NULL : devices.data(),
+                options.c_str(),
+                NULL,
+                NULL );
+        }
+
+        std::string buildLog;
+        if( errorCode == CL_BUILD_PROGRAM_FAILURE )
+        {
+            cl_uint numDevices = 0;
+            dispatch().clGetProgramInfo(
+                newProgram,
+                CL_PROGRAM_NUM_DEVICES,
+                sizeof( numDevices ),
+                &numDevices,
+                NULL );
+
+            std::vector<cl_device_id>   programDevices( numDevices );
+            dispatch().clGetProgramInfo(
+                newProgram,
+                CL_PROGRAM_DEVICES,
+                numDevices * sizeof( cl_device_id ),
+                programDevices.data(),
+                NULL );
+
+            for( const auto& device : programDevices )
+            {
+                size_t  logSize = 0;
+                dispatch().clGetProgramBuildInfo(
+                    newProgram,
+                    device,
+                    CL_PROGRAM_BUILD_LOG,
+                    0,
+                    NULL,
+                    &logSize );
+
+                std::vector<char>   deviceLog( logSize + 1 );
+                dispatch().clGetProgramBuildInfo(
+                    newProgram,
+                    device,
+                    CL_PROGRAM_BUILD_LOG,
+                    logSize,
+                    deviceLog.data(),
+                    NULL );
+                buildLog += deviceLog.data();
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+
+            CHotReloadProgramInfoMap::iterator iter =
+                m_HotReloadProgramInfoMap.find( candidate.Program );
+            if( errorCode != CL_SUCCESS )
+            {
+                logf( "Hot reload of program source file %s failed: %s (%d)!  Using the previous program.\n",
+                    fileName.c_str(),
+                    enumName().name( errorCode ).c_str(),
+                    errorCode );
+                if( !buildLog.empty() )
+                {
+                    log( "-------> Build Log:\n" + buildLog + "\n<-------- End Build Log\n" );
+                }
+            }
+            else if( !m_ThreadPoolShutdown &&
+                     iter != m_HotReloadProgramInfoMap.end() )
+            {
+                // Kernels from the previous rebuilt program keep it alive
+                // until they are swapped out on their next enqueue.
+                SHotReloadProgramInfo&  reloadInfo = iter->second;
+                if( reloadInfo.Program )
+                {
+                    dispatch().clReleaseProgram( reloadInfo.Program );
+                }
+                reloadInfo.Program = newProgram;
+                reloadInfo.Generation++;
+                newProgram = NULL;
+
+                logf( "Hot reloaded program source file %s (generation %u).\n",
+                    fileName.c_str(),
+                    reloadInfo.Generation );
+            }
+        }
+
+        if( newProgram )
         {
-            errorCode = CL_INVALID_VALUE;
+            dispatch().clReleaseProgram( newProgram );
         }
+        dispatch().clReleaseContext( context );
     }
 
-    return errorCode;
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_HotReloadCheckPending = false;
+    m_HotReloadCheckTime = clock::now();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -14081,6 +18408,160 @@ void CLIntercept::dumpMemoryToFile(
     }
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//
+// Returns a host pointer that device memory can be read into for dumping.
+// When possible this is a file mapping of the capture replay or inspection
+// dump file, so the data is written to the file without an intermediate copy.
+// Hashed dump files cannot be mapped because they do not store the data
+// itself, so a transfer buffer is used in this case or if mapping fails.
+void* CLIntercept::beginDumpMemoryToFiles(
+    const std::string& captureReplayFileName,
+    const std::string& inspectionFileName,
+    bool hash,
+    size_t size,
+    std::vector<char>& transferBuf,
+    std::string& mappedFileName )
+{
+    mappedFileName.clear();
+    if( !captureReplayFileName.empty() )
+    {
+        mappedFileName = captureReplayFileName;
+    }
+    else if( !inspectionFileName.empty() && !hash )
+    {
+        mappedFileName = inspectionFileName;
+    }
+
+    if( !mappedFileName.empty() )
+    {
+        void*   ptr = OS().MapFileForWriting( mappedFileName, size );
+        if( ptr != NULL )
+        {
+            return ptr;
+        }
+        mappedFileName.clear();
+    }
+
+    if( transferBuf.size() < size )
+    {
+        transferBuf.resize(size);
+    }
+    return transferBuf.data();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Writes any dump files that were not mapped from the pointer returned by
+// beginDumpMemoryToFiles, then releases the file mapping, if any.
+void CLIntercept::endDumpMemoryToFiles(
+    const std::string& captureReplayFileName,
+    const std::string& inspectionFileName,
+    bool hash,
+    const std::string& mappedFileName,
+    bool success,
+    void* ptr,
+    size_t size )
+{
+    if( success )
+    {
+        if( !captureReplayFileName.empty() &&
+            captureReplayFileName != mappedFileName )
+        {
+            dumpMemoryToFile(
+                captureReplayFileName,
+                false,
+                ptr,
+                size );
+        }
+        if( !inspectionFileName.empty() &&
+            inspectionFileName != mappedFileName )
+        {
+            dumpMemoryToFile(
+                inspectionFileName,
+                hash,
+                ptr,
+                size );
+        }
+    }
+
+    if( !mappedFileName.empty() )
+    {
+        OS().UnmapFile( ptr, size );
+        if( !success )
+        {
+            std::remove( mappedFileName.c_str() );
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Writes memory contents to the content-addressed capture and replay blob
+// store, unless a blob with the same contents has already been written, and
+// returns the name of the blob file.  Blobs are named by their hash and size.
+// Since different contents may have the same hash, an existing blob is only
+// reused if its contents match, otherwise a numbered suffix is added.
+std::string CLIntercept::dumpMemoryToBlob(
+    const void* ptr,
+    size_t size )
+{
+    // We're already in a critical section when we get here, so we don't need to
+    // grab the critical section again.
+
+    std::string dirName;
+    OS().GetDumpDirectoryName( sc_DumpDirectoryName, dirName );
+    dirName += "/Replay/Blobs/";
+
+    const unsigned long long    hash =
+        (unsigned long long)computeHash( ptr, size );
+
+    for( unsigned int index = 0; ; index++ )
+    {
+        char    tmpStr[ MAX_PATH ];
+        if( index == 0 )
+        {
+            CLI_SPRINTF( tmpStr, MAX_PATH, "%016llx_%zu.bin",
+                hash,
+                size );
+        }
+        else
+        {
+            CLI_SPRINTF( tmpStr, MAX_PATH, "%016llx_%zu_%u.bin",
+                hash,
+                size,
+                index );
+        }
+
+        const std::string   blobName( tmpStr );
+        if( m_CaptureReplayBlobSet.find( blobName ) == m_CaptureReplayBlobSet.end() )
+        {
+            OS().MakeDumpDirectories( dirName );
+
+            dumpMemoryToFile(
+                dirName + blobName,
+                false,
+                ptr,
+                size );
+
+            m_CaptureReplayBlobSet.insert( blobName );
+            return blobName;
+        }
+
+        std::ifstream   is( ( dirName + blobName ).c_str(), std::ios::in | std::ios::binary );
+        if( is.good() )
+        {
+            std::vector<char>   contents( size );
+            if( size == 0 ||
+                ( is.read( contents.data(), size ) &&
+                  memcmp( contents.data(), ptr, size ) == 0 ) )
+            {
+                return blobName;
+            }
+        }
+    }
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 #if defined(USE_ITT)
@@ -14635,6 +19116,157 @@ void CLIntercept::chromeTraceEvent(
     }
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//
+// Checks whether a work size matches a work size string of the form "XxYxZ",
+// for kernel capture and replay triggers.  An empty string or the wildcard
+// ("*") match all work sizes, and "NULL" matches a NULL work size.
+static bool matchWorkSizeString(
+    const std::string& match,
+    cl_uint workDim,
+    const size_t* sizes )
+{
+    if( match.empty() || match == "*" )
+    {
+        return true;
+    }
+
+    std::ostringstream  ss;
+    if( sizes )
+    {
+        for( cl_uint i = 0; i < workDim; i++ )
+        {
+            ss << ( i ? "x" : "" ) << sizes[i];
+        }
+    }
+    else
+    {
+        ss << "NULL";
+    }
+    return match == ss.str();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+bool CLIntercept::checkCaptureReplayKernelSignature(
+    const cl_kernel kernel,
+    cl_uint workDim,
+    const size_t* gws,
+    const size_t* lws )
+{
+    if( m_Config.CaptureReplayStartTime != 0 ||
+        m_Config.CaptureReplayEndTime != UINT_MAX )
+    {
+        using s = std::chrono::seconds;
+        const uint64_t  elapsed =
+            std::chrono::duration_cast<s>(clock::now() - m_StartTime).count();
+        if( elapsed < m_Config.CaptureReplayStartTime ||
+            elapsed > m_Config.CaptureReplayEndTime )
+        {
+            return false;
+        }
+    }
+
+    if( !matchWorkSizeString( m_Config.CaptureReplayKernelGWS, workDim, gws ) ||
+        !matchWorkSizeString( m_Config.CaptureReplayKernelLWS, workDim, lws ) )
+    {
+        return false;
+    }
+
+    if( !m_Config.CaptureReplayProgramHash.empty() )
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        const unsigned int  programHash =
+            (unsigned int)m_KernelInfoMap[ kernel ].ProgramHash;
+        if( programHash !=
+            strtoul( m_Config.CaptureReplayProgramHash.c_str(), NULL, 16 ) )
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Checks the device execution times of previously enqueued matching kernels,
+// without waiting for them to complete.  Returns true and disarms the trigger
+// if any of them took at least CaptureReplayMinDeviceTimeUS.
+bool CLIntercept::checkCaptureReplayDeviceTimeTrigger()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    const cl_ulong  thresholdNS =
+        (cl_ulong)m_Config.CaptureReplayMinDeviceTimeUS * 1000;
+
+    CCaptureReplayTriggerEventList::iterator    current =
+        m_CaptureReplayTriggerEventList.begin();
+    while( current != m_CaptureReplayTriggerEventList.end() )
+    {
+        cl_event    event = *current;
+
+        cl_int  eventStatus = 0;
+        cl_int  errorCode = dispatch().clGetEventInfo(
+            event,
+            CL_EVENT_COMMAND_EXECUTION_STATUS,
+            sizeof( eventStatus ),
+            &eventStatus,
+            NULL );
+        if( errorCode == CL_SUCCESS && eventStatus > CL_COMPLETE )
+        {
+            ++current;
+            continue;
+        }
+
+        if( errorCode == CL_SUCCESS && eventStatus == CL_COMPLETE )
+        {
+            cl_ulong    commandStart = 0;
+            cl_ulong    commandEnd = 0;
+
+            errorCode |= dispatch().clGetEventProfilingInfo(
+                event,
+                CL_PROFILING_COMMAND_START,
+                sizeof( commandStart ),
+                &commandStart,
+                NULL );
+            errorCode |= dispatch().clGetEventProfilingInfo(
+                event,
+                CL_PROFILING_COMMAND_END,
+                sizeof( commandEnd ),
+                &commandEnd,
+                NULL );
+            if( errorCode == CL_SUCCESS &&
+                commandEnd - commandStart >= thresholdNS &&
+                !m_CaptureReplayTriggerArmed )
+            {
+                logf( "Kernel capture and replay triggered by a kernel that took %.2f us.\n",
+                    ( commandEnd - commandStart ) / 1000.0 );
+                m_CaptureReplayTriggerArmed = true;
+            }
+        }
+
+        dispatch().clReleaseEvent( event );
+        current = m_CaptureReplayTriggerEventList.erase( current );
+    }
+
+    const bool  armed = m_CaptureReplayTriggerArmed;
+    m_CaptureReplayTriggerArmed = false;
+    return armed;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::addCaptureReplayTriggerEvent(
+    cl_event event )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    dispatch().clRetainEvent( event );
+    m_CaptureReplayTriggerEventList.push_back( event );
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 bool CLIntercept::checkCaptureReplayKernelSkips( const cl_kernel kernel )
@@ -14901,45 +19533,191 @@ bool CLIntercept::checkAubCaptureKernelSignature(
         }
     }
 
-    return match;
-}
+    return match;
+}
+
+#define USE_DRIVER_SVM
+
+///////////////////////////////////////////////////////////////////////////////
+//
+static bool validateUSMMemProperties(
+    const cl_mem_properties_intel* properties )
+{
+    if( properties )
+    {
+        while( properties[0] != 0 )
+        {
+            cl_int  property = (cl_int)properties[0];
+            switch( property )
+            {
+            case CL_MEM_ALLOC_FLAGS_INTEL:
+                {
+                    const cl_mem_alloc_flags_intel* pf =
+                        (const cl_mem_alloc_flags_intel*)( properties + 1 );
+                    cl_mem_alloc_flags_intel    flags = pf[0];
+                    cl_mem_alloc_flags_intel    valid =
+                        CL_MEM_ALLOC_WRITE_COMBINED_INTEL;
+                    if( flags & ~valid )
+                    {
+                        return false;
+                    }
+                }
+                break;
+            default:
+                return false;
+            }
+
+            properties += 2;
+        }
+    }
+
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Slabs are allocated with this alignment, so chunks are aligned to the
+// smaller of their size and this alignment.
+static const size_t cUSMPoolSlabAlignment = 4096;
+
+// The smallest chunk size.  This is the size of the largest OpenCL type,
+// which is the default alignment for SVM allocations.
+static const size_t cUSMPoolMinChunkSize = 128;
+
+///////////////////////////////////////////////////////////////////////////////
+//
+static void removeUSMAlloc(
+    std::vector<const void*>& allocVector,
+    const void* ptr )
+{
+    // The order of the allocations in the vector does not matter, so move
+    // the last allocation into the hole rather than shifting the vector.
+    std::vector<const void*>::iterator iter = std::find(
+        allocVector.begin(),
+        allocVector.end(),
+        ptr );
+    if( iter != allocVector.end() )
+    {
+        *iter = allocVector.back();
+        allocVector.pop_back();
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+bool CLIntercept::shouldPoolUSMAlloc(
+    size_t size,
+    cl_uint alignment ) const
+{
+    return
+        config().EmulatedUSMPool &&
+        size != 0 &&
+        size <= (size_t)config().EmulatedUSMPoolMaxAllocSizeKB * 1024 &&
+        size <= (size_t)config().EmulatedUSMPoolSlabSizeMB * 1024 * 1024 &&
+        alignment <= cUSMPoolSlabAlignment &&
+        ( alignment & ( alignment - 1 ) ) == 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void* CLIntercept::allocateUSMFromPool(
+    cl_context context,
+    SUSMPool& pool,
+    SUSMPoolStats& stats,
+    cl_svm_mem_flags flags,
+    size_t size,
+    cl_uint alignment,
+    size_t& chunkSize )
+{
+    // We're already in a critical section when we get here, so we don't need to
+    // grab the critical section again.
+
+    size_t  sizeClass = 0;
+    chunkSize = 1;
+    while( chunkSize < size ||
+           chunkSize < alignment ||
+           chunkSize < cUSMPoolMinChunkSize )
+    {
+        chunkSize <<= 1;
+        sizeClass++;
+    }
+
+    void*   ptr = NULL;
+
+    std::vector<void*>& freeList = pool.FreeLists[sizeClass];
+    if( !freeList.empty() )
+    {
+        ptr = freeList.back();
+        freeList.pop_back();
+        stats.NumReusedAllocs++;
+    }
+    else
+    {
+        size_t  chunkAlignment = std::min( chunkSize, cUSMPoolSlabAlignment );
+        size_t  offset =
+            ( pool.SlabOffset + chunkAlignment - 1 ) & ~( chunkAlignment - 1 );
+
+        if( pool.Slabs.empty() ||
+            offset + chunkSize > pool.Slabs.back().Size )
+        {
+            // Any space remaining in the current slab is abandoned.
+            size_t  slabSize = std::max(
+                (size_t)config().EmulatedUSMPoolSlabSizeMB * 1024 * 1024,
+                chunkSize );
+            void*   slab = dispatch().clSVMAlloc ?
+                dispatch().clSVMAlloc(
+                    context,
+                    flags,
+                    slabSize,
+                    (cl_uint)cUSMPoolSlabAlignment ) : NULL;
+            if( slab == NULL )
+            {
+                return NULL;
+            }
+
+            SUSMPool::SSlab newSlab = { slab, slabSize };
+            pool.Slabs.push_back( newSlab );
+            offset = 0;
+
+            stats.NumSlabs++;
+            stats.SlabBytes += slabSize;
+        }
+
+        ptr = (char*)pool.Slabs.back().Base + offset;
+        pool.SlabOffset = offset + chunkSize;
+    }
+
+    pool.BytesInUse += chunkSize;
 
-#define USE_DRIVER_SVM
+    stats.NumPooledAllocs++;
+    stats.BytesInUse += chunkSize;
+    stats.PeakBytesInUse = std::max( stats.PeakBytesInUse, stats.BytesInUse );
+
+    return ptr;
+}
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-static bool validateUSMMemProperties(
-    const cl_mem_properties_intel* properties )
+void CLIntercept::freeUSMToPool(
+    SUSMPool& pool,
+    SUSMPoolStats& stats,
+    const void* ptr,
+    size_t chunkSize )
 {
-    if( properties )
-    {
-        while( properties[0] != 0 )
-        {
-            cl_int  property = (cl_int)properties[0];
-            switch( property )
-            {
-            case CL_MEM_ALLOC_FLAGS_INTEL:
-                {
-                    const cl_mem_alloc_flags_intel* pf =
-                        (const cl_mem_alloc_flags_intel*)( properties + 1 );
-                    cl_mem_alloc_flags_intel    flags = pf[0];
-                    cl_mem_alloc_flags_intel    valid =
-                        CL_MEM_ALLOC_WRITE_COMBINED_INTEL;
-                    if( flags & ~valid )
-                    {
-                        return false;
-                    }
-                }
-                break;
-            default:
-                return false;
-            }
+    // We're already in a critical section when we get here, so we don't need to
+    // grab the critical section again.
 
-            properties += 2;
-        }
+    size_t  sizeClass = 0;
+    while( ( (size_t)1 << sizeClass ) < chunkSize )
+    {
+        sizeClass++;
     }
 
-    return true;
+    pool.FreeLists[sizeClass].push_back( (void*)ptr );
+    pool.BytesInUse -= chunkSize;
+
+    stats.NumPooledFrees++;
+    stats.BytesInUse -= chunkSize;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -14962,13 +19740,36 @@ void* CLIntercept::emulatedHostMemAlloc(
         return NULL;
     }
 
+    SUSMContextInfo&    usmContextInfo = m_USMContextInfoMap[context];
+
+    void*   ptr = NULL;
+    size_t  poolChunkSize = 0;
+
 #ifdef USE_DRIVER_SVM
-    void*   ptr = dispatch().clSVMAlloc ?
-        dispatch().clSVMAlloc(
+    if( shouldPoolUSMAlloc( size, alignment ) )
+    {
+        ptr = allocateUSMFromPool(
             context,
+            usmContextInfo.HostPool,
+            m_USMPoolStatsMap[CL_MEM_TYPE_HOST_INTEL],
             CL_MEM_READ_WRITE | CL_MEM_SVM_FINE_GRAIN_BUFFER,
             size,
-            alignment ) : NULL;
+            alignment,
+            poolChunkSize );
+    }
+    else
+    {
+        if( config().EmulatedUSMPool )
+        {
+            m_USMPoolStatsMap[CL_MEM_TYPE_HOST_INTEL].NumUnpooledAllocs++;
+        }
+        ptr = dispatch().clSVMAlloc ?
+            dispatch().clSVMAlloc(
+                context,
+                CL_MEM_READ_WRITE | CL_MEM_SVM_FINE_GRAIN_BUFFER,
+                size,
+                alignment ) : NULL;
+    }
 #else
     // For now, the only valid alignments are "0":
     if( alignment != 0 )
@@ -14980,7 +19781,7 @@ void* CLIntercept::emulatedHostMemAlloc(
         return NULL;
     }
 
-    void*   ptr = new char[size];
+    ptr = new char[size];
 #endif
     if( ptr == NULL )
     {
@@ -14992,12 +19793,12 @@ void* CLIntercept::emulatedHostMemAlloc(
     }
 
     // Record this allocation in the alloc map:
-    SUSMContextInfo&    usmContextInfo = m_USMContextInfoMap[context];
-    SUSMAllocInfo&      allocInfo = usmContextInfo.AllocMap[ptr];
+    SUSMAllocInfo&      allocInfo = usmContextInfo.AllocMap.insert( ptr, size );
     allocInfo.Type = CL_MEM_TYPE_HOST_INTEL;
     allocInfo.BaseAddress = ptr;
     allocInfo.Size = size;
     allocInfo.Alignment = alignment;
+    allocInfo.PoolChunkSize = poolChunkSize;
 
     usmContextInfo.HostAllocVector.push_back( ptr );
 
@@ -15029,14 +19830,37 @@ void* CLIntercept::emulatedDeviceMemAlloc(
         return NULL;
     }
 
+    SUSMContextInfo&    usmContextInfo = m_USMContextInfoMap[context];
+
+    void*   ptr = NULL;
+    size_t  poolChunkSize = 0;
+
     // Unconditionally use coarse grain SVM for device allocations:
 
-    void*   ptr = dispatch().clSVMAlloc ?
-        dispatch().clSVMAlloc(
+    if( shouldPoolUSMAlloc( size, alignment ) )
+    {
+        ptr = allocateUSMFromPool(
             context,
+            usmContextInfo.DevicePool,
+            m_USMPoolStatsMap[CL_MEM_TYPE_DEVICE_INTEL],
             CL_MEM_READ_WRITE,
             size,
-            alignment ) : NULL;
+            alignment,
+            poolChunkSize );
+    }
+    else
+    {
+        if( config().EmulatedUSMPool )
+        {
+            m_USMPoolStatsMap[CL_MEM_TYPE_DEVICE_INTEL].NumUnpooledAllocs++;
+        }
+        ptr = dispatch().clSVMAlloc ?
+            dispatch().clSVMAlloc(
+                context,
+                CL_MEM_READ_WRITE,
+                size,
+                alignment ) : NULL;
+    }
     if( ptr == NULL )
     {
         if( errcode_ret )
@@ -15047,13 +19871,13 @@ void* CLIntercept::emulatedDeviceMemAlloc(
     }
 
     // Record this allocation in the alloc map:
-    SUSMContextInfo&    usmContextInfo = m_USMContextInfoMap[context];
-    SUSMAllocInfo&      allocInfo = usmContextInfo.AllocMap[ptr];
+    SUSMAllocInfo&      allocInfo = usmContextInfo.AllocMap.insert( ptr, size );
     allocInfo.Type = CL_MEM_TYPE_DEVICE_INTEL;
     allocInfo.Device = device;
     allocInfo.BaseAddress = ptr;
     allocInfo.Size = size;
     allocInfo.Alignment = alignment;
+    allocInfo.PoolChunkSize = poolChunkSize;
 
     usmContextInfo.DeviceAllocVector.push_back( ptr );
 
@@ -15085,13 +19909,36 @@ void* CLIntercept::emulatedSharedMemAlloc(
         return NULL;
     }
 
+    SUSMContextInfo&    usmContextInfo = m_USMContextInfoMap[context];
+
+    void*   ptr = NULL;
+    size_t  poolChunkSize = 0;
+
 #ifdef USE_DRIVER_SVM
-    void*   ptr = dispatch().clSVMAlloc ?
-        dispatch().clSVMAlloc(
+    if( shouldPoolUSMAlloc( size, alignment ) )
+    {
+        ptr = allocateUSMFromPool(
             context,
+            usmContextInfo.SharedPool,
+            m_USMPoolStatsMap[CL_MEM_TYPE_SHARED_INTEL],
             CL_MEM_READ_WRITE | CL_MEM_SVM_FINE_GRAIN_BUFFER,
             size,
-            alignment ) : NULL;
+            alignment,
+            poolChunkSize );
+    }
+    else
+    {
+        if( config().EmulatedUSMPool )
+        {
+            m_USMPoolStatsMap[CL_MEM_TYPE_SHARED_INTEL].NumUnpooledAllocs++;
+        }
+        ptr = dispatch().clSVMAlloc ?
+            dispatch().clSVMAlloc(
+                context,
+                CL_MEM_READ_WRITE | CL_MEM_SVM_FINE_GRAIN_BUFFER,
+                size,
+                alignment ) : NULL;
+    }
 #else
     // For now, the only valid alignments are "0":
     if( alignment != 0 )
@@ -15103,7 +19950,7 @@ void* CLIntercept::emulatedSharedMemAlloc(
         return NULL;
     }
 
-    void*   ptr = new char[size];
+    ptr = new char[size];
 #endif
     if( ptr == NULL )
     {
@@ -15115,13 +19962,13 @@ void* CLIntercept::emulatedSharedMemAlloc(
     }
 
     // Record this allocation in the alloc map:
-    SUSMContextInfo&    usmContextInfo = m_USMContextInfoMap[context];
-    SUSMAllocInfo&      allocInfo = usmContextInfo.AllocMap[ptr];
+    SUSMAllocInfo&      allocInfo = usmContextInfo.AllocMap.insert( ptr, size );
     allocInfo.Type = CL_MEM_TYPE_SHARED_INTEL;
     allocInfo.Device = device;
     allocInfo.BaseAddress = ptr;
     allocInfo.Size = size;
     allocInfo.Alignment = alignment;
+    allocInfo.PoolChunkSize = poolChunkSize;
 
     usmContextInfo.SharedAllocVector.push_back( ptr );
 
@@ -15142,33 +19989,27 @@ cl_int CLIntercept::emulatedMemFree(
 
     SUSMContextInfo&    usmContextInfo = m_USMContextInfoMap[context];
 
-    CUSMAllocMap::iterator iter = usmContextInfo.AllocMap.find( ptr );
-    if( iter != usmContextInfo.AllocMap.end() )
+    const CUSMAllocMap::SEntry* entry = usmContextInfo.AllocMap.findBase( ptr );
+    if( entry )
     {
-        const SUSMAllocInfo &allocInfo = iter->second;
+        const cl_unified_shared_memory_type_intel type = entry->Value.Type;
+        const size_t    poolChunkSize = entry->Value.PoolChunkSize;
 
-        switch( allocInfo.Type )
+        SUSMPool*   pool = NULL;
+        switch( type )
         {
         case CL_MEM_TYPE_HOST_INTEL:
-            usmContextInfo.HostAllocVector.erase(
-                std::find(
-                    usmContextInfo.HostAllocVector.begin(),
-                    usmContextInfo.HostAllocVector.end(),
-                    ptr ) );
+            removeUSMAlloc( usmContextInfo.HostAllocVector, ptr );
+            pool = &usmContextInfo.HostPool;
             break;
         case CL_MEM_TYPE_DEVICE_INTEL:
-            usmContextInfo.DeviceAllocVector.erase(
-                std::find(
-                    usmContextInfo.DeviceAllocVector.begin(),
-                    usmContextInfo.DeviceAllocVector.end(),
-                    ptr ) );
+            removeUSMAlloc( usmContextInfo.DeviceAllocVector, ptr );
+            pool = &usmContextInfo.DevicePool;
             break;
         case CL_MEM_TYPE_SHARED_INTEL:
-            usmContextInfo.SharedAllocVector.erase(
-                std::find(
-                    usmContextInfo.SharedAllocVector.begin(),
-                    usmContextInfo.SharedAllocVector.end(),
-                    ptr ) );
+            removeUSMAlloc( usmContextInfo.SharedAllocVector, ptr );
+            pool = &usmContextInfo.SharedPool;
+            break;
         default:
             CLI_ASSERT( 0 );
             break;
@@ -15176,15 +20017,27 @@ cl_int CLIntercept::emulatedMemFree(
 
         usmContextInfo.AllocMap.erase( ptr );
 
+        if( poolChunkSize != 0 && pool != NULL )
+        {
+            freeUSMToPool(
+                *pool,
+                m_USMPoolStatsMap[type],
+                ptr,
+                poolChunkSize );
+            ptr = NULL;
+        }
+        else
+        {
 #ifdef USE_DRIVER_SVM
-        dispatch().clSVMFree(
-            context,
-            (void*)ptr );
-        ptr = NULL;
+            dispatch().clSVMFree(
+                context,
+                (void*)ptr );
+            ptr = NULL;
 #else
-        delete [] ptr;
-        ptr = NULL;
+            delete [] ptr;
+            ptr = NULL;
 #endif
+        }
 
         return CL_SUCCESS;
     }
@@ -15192,6 +20045,132 @@ cl_int CLIntercept::emulatedMemFree(
     return CL_INVALID_MEM_OBJECT;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//
+// Registers a callback to remove the emulated USM tracking for a context
+// once the context is destroyed.  The tracking cannot be removed when the
+// application releases the context, because the context may still be kept
+// alive by other objects that use its emulated USM allocations.
+void CLIntercept::emulatedInitUSMContext(
+    cl_context context )
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        // A destroyed context may have had the same handle as the new
+        // context, so remove any destroyed contexts first.
+        removeDestroyedUSMContexts();
+    }
+
+    if( config().EmulatedUSMPool &&
+        dispatch().clSetContextDestructorCallback )
+    {
+        dispatch().clSetContextDestructorCallback(
+            context,
+            emulatedUSMContextDestructorCallback,
+            this );
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CL_CALLBACK CLIntercept::emulatedUSMContextDestructorCallback(
+    cl_context context,
+    void* user_data )
+{
+    CLIntercept*    pIntercept = (CLIntercept*)user_data;
+    pIntercept->emulatedDestroyUSMContext( context );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Called when the application releases its last reference to the context,
+// before the context is released, so the context is still valid.  The pool
+// slabs are freed if none of the pooled allocations are in use.  Otherwise,
+// the application leaked some pooled allocations, or they are still in use
+// by other objects, and the slabs are left for the OpenCL implementation to
+// free along with the context.
+void CLIntercept::emulatedReleaseUSMContext(
+    cl_context context )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    removeDestroyedUSMContexts();
+
+    CUSMContextInfoMap::iterator iter = m_USMContextInfoMap.find( context );
+    if( iter == m_USMContextInfoMap.end() )
+    {
+        return;
+    }
+
+    SUSMContextInfo&    usmContextInfo = iter->second;
+
+    SUSMPool*   pools[] = {
+        &usmContextInfo.HostPool,
+        &usmContextInfo.DevicePool,
+        &usmContextInfo.SharedPool,
+    };
+    for( SUSMPool* pool : pools )
+    {
+        if( pool->BytesInUse != 0 )
+        {
+            logf( "Emulated USM pool for context %p has %zu bytes in use, not freeing %zu slab(s).\n",
+                context,
+                pool->BytesInUse,
+                pool->Slabs.size() );
+            continue;
+        }
+
+        for( const SUSMPool::SSlab& slab : pool->Slabs )
+        {
+            dispatch().clSVMFree(
+                context,
+                slab.Base );
+        }
+        *pool = SUSMPool();
+    }
+
+    // Without a context destructor callback there is no later point to
+    // remove the tracking for this context, so remove it now.
+    if( dispatch().clSetContextDestructorCallback == NULL )
+    {
+        m_USMContextInfoMap.erase( iter );
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Called from the context destructor callback.  The context is no longer
+// valid, so this does not call into OpenCL, and it may be called while the
+// intercept mutex is held, for example when the layer releases the last
+// object that keeps the context alive, so it does not take the intercept
+// mutex either.
+void CLIntercept::emulatedDestroyUSMContext(
+    cl_context context )
+{
+    std::lock_guard<std::mutex> lock(m_USMDestroyedContextsMutex);
+    m_USMDestroyedContexts.push_back( context );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CLIntercept::removeDestroyedUSMContexts()
+{
+    // We're already in a critical section when we get here, so we don't need to
+    // grab the critical section again.
+
+    std::vector<cl_context> destroyedContexts;
+    {
+        std::lock_guard<std::mutex> lock(m_USMDestroyedContextsMutex);
+        destroyedContexts.swap( m_USMDestroyedContexts );
+    }
+
+    for( cl_context context : destroyedContexts )
+    {
+        m_USMContextInfoMap.erase( context );
+    }
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 cl_int CLIntercept::emulatedGetMemAllocInfoINTEL(
@@ -15207,6 +20186,8 @@ cl_int CLIntercept::emulatedGetMemAllocInfoINTEL(
         return CL_INVALID_VALUE;
     }
 
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
     SUSMContextInfo&    usmContextInfo = m_USMContextInfoMap[context];
 
     if( usmContextInfo.AllocMap.empty() )
@@ -15215,34 +20196,15 @@ cl_int CLIntercept::emulatedGetMemAllocInfoINTEL(
         return CL_INVALID_MEM_OBJECT;   // TODO: new error code?
     }
 
-    CUSMAllocMap::iterator iter = usmContextInfo.AllocMap.lower_bound( ptr );
-
-    if( iter == usmContextInfo.AllocMap.end() || iter->first != ptr )
-    {
-        if( iter == usmContextInfo.AllocMap.begin() )
-        {
-            // This pointer is not in the map.
-            return CL_INVALID_MEM_OBJECT;
-        }
-
-        // Go to the previous iterator.
-        --iter;
-    }
-
-    const SUSMAllocInfo &allocInfo = iter->second;
-
-    const void* startPtr = allocInfo.BaseAddress;
-    const void* endPtr = (const char*)allocInfo.BaseAddress + allocInfo.Size;
-    //logf("start = %p, ptr = %p, end = %p\n",
-    //    startPtr,
-    //    ptr,
-    //    endPtr );
-
-    if( ptr < startPtr || ptr >= endPtr )
+    const CUSMAllocMap::SEntry* entry = usmContextInfo.AllocMap.findContaining( ptr );
+    if( entry == NULL )
     {
+        // This pointer is not in the map.
         return CL_INVALID_MEM_OBJECT;
     }
 
+    const SUSMAllocInfo &allocInfo = entry->Value;
+
     //logf("For ptr = %p: base = %p, size = %p\n",
     //    ptr,
     //    allocInfo.BaseAddress,
@@ -15297,6 +20259,149 @@ cl_int CLIntercept::emulatedGetMemAllocInfoINTEL(
     return CL_INVALID_VALUE;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//
+cl_unified_shared_memory_type_intel CLIntercept::getEmulatedUSMAllocType(
+    cl_command_queue queue,
+    const void* ptr )
+{
+    // We're already in a critical section when we get here, so we don't need to
+    // grab the critical section again.
+
+    cl_context  context = NULL;
+    dispatch().clGetCommandQueueInfo(
+        queue,
+        CL_QUEUE_CONTEXT,
+        sizeof( context ),
+        &context,
+        NULL );
+
+    CUSMContextInfoMap::iterator iter = m_USMContextInfoMap.find( context );
+    if( iter != m_USMContextInfoMap.end() )
+    {
+        const CUSMAllocMap::SEntry* entry =
+            iter->second.AllocMap.findContaining( ptr );
+        if( entry )
+        {
+            return entry->Value.Type;
+        }
+    }
+
+    return CL_MEM_TYPE_UNKNOWN_INTEL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+cl_int CLIntercept::emulatedEnqueueMigrateMem(
+    cl_command_queue queue,
+    const void* ptr,
+    size_t size,
+    cl_mem_migration_flags flags,
+    cl_uint num_events_in_wait_list,
+    const cl_event* event_wait_list,
+    cl_event* event)
+{
+    cl_device_id    device = NULL;
+    dispatch().clGetCommandQueueInfo(
+        queue,
+        CL_QUEUE_DEVICE,
+        sizeof( device ),
+        &device,
+        NULL );
+
+    cl_unified_shared_memory_type_intel type = CL_MEM_TYPE_UNKNOWN_INTEL;
+
+    // The USM migration flags have the same values and meaning as the SVM
+    // migration flags, so the migration can be passed through directly to
+    // clEnqueueSVMMigrateMem on OpenCL 2.1 devices and newer.  The device
+    // version is cached with the rest of the device info.
+    bool    canMigrate = false;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        type = getEmulatedUSMAllocType( queue, ptr );
+
+        SUSMHintStats&  stats = m_USMHintStatsMap[ type ];
+        stats.NumMigrations++;
+        if( flags & CL_MIGRATE_MEM_OBJECT_HOST )
+        {
+            stats.NumMigrationsToHost++;
+        }
+
+        if( dispatch().clEnqueueSVMMigrateMem && device )
+        {
+            cacheDeviceInfo( device );
+            canMigrate =
+                m_DeviceInfoMap[ device ].NumericVersion >=
+                CL_MAKE_VERSION_KHR( 2, 1, 0 );
+        }
+    }
+
+    if( canMigrate )
+    {
+        cl_int  retVal = dispatch().clEnqueueSVMMigrateMem(
+            queue,
+            1,
+            &ptr,
+            &size,
+            flags,
+            num_events_in_wait_list,
+            event_wait_list,
+            event );
+        if( retVal == CL_SUCCESS )
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_USMHintStatsMap[ type ].MigratedBytes += size;
+            return retVal;
+        }
+
+        // Only fall back to a marker if SVM migration isn't supported for
+        // this device.  Other errors, for example for an invalid wait list,
+        // are returned to the application.
+        if( retVal != CL_INVALID_OPERATION )
+        {
+            return retVal;
+        }
+    }
+
+    // Otherwise, enqueue a marker so the dependencies for the migration are
+    // still respected.
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_USMHintStatsMap[ type ].NumMigrationMarkers++;
+    }
+    return dispatch().clEnqueueMarkerWithWaitList(
+        queue,
+        num_events_in_wait_list,
+        event_wait_list,
+        event );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+cl_int CLIntercept::emulatedEnqueueMemAdvise(
+    cl_command_queue queue,
+    const void* ptr,
+    size_t size,
+    cl_mem_advice_intel advice,
+    cl_uint num_events_in_wait_list,
+    const cl_event* event_wait_list,
+    cl_event* event)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    // There is no SVM equivalent for memory advice, so the advice is only
+    // recorded for the report.
+    SUSMHintStats&  stats = m_USMHintStatsMap[ getEmulatedUSMAllocType( queue, ptr ) ];
+    stats.AdviceCounts[advice]++;
+
+    return dispatch().clEnqueueMarkerWithWaitList(
+        queue,
+        num_events_in_wait_list,
+        event_wait_list,
+        event );
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 cl_int CLIntercept::trackUSMKernelExecInfo(
@@ -9,6 +9,7 @@
 #include <chrono>
 #include <cinttypes>
 #include <fstream>
+#include <functional>
 #include <list>
 #include <vector>
 #include <map>
@@ -17,16 +18,20 @@
 #include <set>
 #include <sstream>
 #include <unordered_map>
+#include <unordered_set>
 
 #include <stdint.h>
 
 #include "common.h"
 
+#include "addrrangemap.h"
 #include "chrometracer.h"
 #include "cmdbufrecorder.h"
 #include "enummap.h"
 #include "dispatch.h"
 #include "objtracker.h"
+#include "streamcapture.h"
+#include "threadpool.h"
 
 #include "instrumentation.h"
 
@@ -206,6 +211,14 @@ public:
                 const cl_program program,
                 cl_uint num_devices,
                 const cl_device_id* device_list );
+    void    addProgramBuildTiming(
+                clock::time_point buildTimeStart,
+                clock::time_point buildTimeEnd,
+                const cl_program program,
+                cl_uint num_devices,
+                const cl_device_id* device_list,
+                const char* options,
+                const char* operation );
     void    logError(
                 const char* functionName,
                 cl_int errorCode );
@@ -276,6 +289,23 @@ public:
                 const cl_uint work_dim,
                 const size_t* global_work_size,
                 const size_t*& local_work_size );
+    bool    autotuneLocalWorkSize(
+                const cl_command_queue queue,
+                const cl_kernel kernel,
+                const cl_uint work_dim,
+                const size_t* global_work_size,
+                const size_t*& local_work_size,
+                size_t* tunedLocalWorkSize,
+                std::string& key,
+                size_t& candidate );
+    void    addLWSTuningEvent(
+                const cl_command_queue queue,
+                const std::string& key,
+                size_t candidate,
+                cl_event event );
+    void    checkLWSTuningEvents();
+    void    checkRemoveLWSTuningQueue(
+                const cl_command_queue queue );
 
     void    combineProgramStrings(
                 cl_uint& count,
@@ -321,6 +351,13 @@ public:
                 const char* append,
                 const char* options,
                 char*& newOptions ) const;
+    void    addHotReloadProgram(
+                const cl_program program,
+                cl_uint numDevices,
+                const cl_device_id* deviceList,
+                const char* options );
+    void    checkRemoveHotReloadProgram(
+                const cl_program program );
     void    dumpProgramSourceScript(
                 const cl_program program,
                 const char* singleString );
@@ -362,6 +399,40 @@ public:
                 uint64_t hash,
                 cl_context context,
                 cl_int* errcode_ret );
+    cl_int  buildProgramWithCachedBinaries(
+                const cl_program program,
+                cl_uint numDevices,
+                const cl_device_id* deviceList,
+                const char* options,
+                void (CL_CALLBACK *pfn_notify)(cl_program program, void* user_data),
+                void* user_data );
+    void    initProgramBinaryCache(
+                const cl_program program,
+                uint64_t hash );
+    cl_program getBinaryCacheProgram(
+                const cl_program program );
+    void    removeBinaryCacheProgram(
+                const cl_program program );
+    void    checkRemoveBinaryCacheProgram(
+                const cl_program program );
+    void    addBinaryCacheKernels(
+                const cl_program program,
+                const cl_kernel* kernels,
+                cl_uint numKernels );
+    void    addBinaryCacheKernelClone(
+                const cl_kernel kernel,
+                const cl_kernel sourceKernel );
+    cl_program getBinaryCacheKernelProgram(
+                const cl_kernel kernel,
+                const cl_program program );
+    void    checkRemoveBinaryCacheKernel(
+                const cl_kernel kernel );
+    void    updateProgramBinaryCache(
+                const cl_program program,
+                cl_uint numDevices,
+                const cl_device_id* deviceList,
+                const char* options );
+
     void    dumpProgramBinary(
                 const cl_program program );
 
@@ -515,6 +586,25 @@ public:
     void    checkRemoveKernelInfo(
                 const cl_kernel kernel );
 
+    void    checkRedundantProgramCreate(
+                const cl_program program,
+                clock::time_point cpuStart,
+                clock::time_point cpuEnd );
+    void    checkRedundantProgramBuild(
+                const cl_program program,
+                const char* functionName,
+                clock::time_point cpuStart,
+                clock::time_point cpuEnd );
+    void    checkRedundantKernelCreate(
+                const cl_kernel* kernels,
+                cl_uint numKernels,
+                const char* functionName,
+                clock::time_point cpuStart,
+                clock::time_point cpuEnd );
+    void    checkRedundantWorkRelease(
+                const void* object,
+                cl_uint refCount );
+
     void    addAcceleratorInfo(
                 cl_accelerator_intel accelerator,
                 cl_context context );
@@ -587,6 +677,11 @@ public:
                 cl_kernel kernel,
                 cl_uint arg_index,
                 const void* arg );
+    void    setKernelExecInfo(
+                cl_kernel kernel,
+                cl_kernel_exec_info param_name,
+                size_t param_value_size,
+                const void* param_value );
     void    dumpBuffersForKernel(
                 const std::string& name,
                 const bool forCaptureReplay,
@@ -669,11 +764,6 @@ public:
     void    stopAubCapture(
                 cl_command_queue commandQueue );
 
-    void    initPrecompiledKernelOverrides(
-                const cl_context context );
-    void    initBuiltinKernelOverrides(
-                const cl_context context );
-
     cl_int  writeStringToMemory(
                 size_t param_value_size,
                 const std::string& param,
@@ -707,6 +797,9 @@ public:
                 size_t* param_value_size_ret,
                 cl_int& errorCode ) const;
 
+    void    prepareKernelOverrides(
+                const cl_command_queue queue );
+
     cl_int  ReadBuffer(
                 cl_command_queue commandQueue,
                 cl_mem srcBuffer,
@@ -749,6 +842,21 @@ public:
                 const cl_event* eventWaitList,
                 cl_event* event );
 
+    cl_int  CopyBufferRect(
+                cl_command_queue commandQueue,
+                cl_mem srcBuffer,
+                cl_mem dstBuffer,
+                const size_t* srcOrigin,
+                const size_t* dstOrigin,
+                const size_t* region,
+                size_t srcRowPitch,
+                size_t srcSlicePitch,
+                size_t dstRowPitch,
+                size_t dstSlicePitch,
+                cl_uint numEventsInWaitList,
+                const cl_event* eventWaitList,
+                cl_event* event );
+
     cl_int  ReadImage(
                 cl_command_queue commandQueue,
                 cl_mem srcImage,
@@ -796,7 +904,9 @@ public:
                 cl_event* event );
 
     cl_program createProgramWithBuiltinKernels(
-                cl_context context );
+                cl_context context,
+                cl_uint numDevices,
+                const cl_device_id* devices );
     cl_kernel createBuiltinKernel(
                 cl_program program,
                 const std::string& kernel_name,
@@ -811,6 +921,16 @@ public:
                 cl_uint num_events_in_wait_list,
                 const cl_event* event_wait_list,
                 cl_event* event );
+    cl_int  NDRangeHotReloadKernel(
+                cl_command_queue commandQueue,
+                cl_kernel kernel,
+                cl_uint work_dim,
+                const size_t* global_work_offset,
+                const size_t* global_work_size,
+                const size_t* local_work_size,
+                cl_uint num_events_in_wait_list,
+                const cl_event* event_wait_list,
+                cl_event* event );
 
     void*   getExtensionFunctionAddress(
                 cl_platform_id platform,
@@ -876,6 +996,7 @@ public:
     uint64_t    incrementEnqueueCounter();
 
     CObjectTracker& objectTracker();
+    CStreamCapture& streamCapture();
 
     bool    checkDumpBuffersForKernel( const cl_kernel kernel );
     bool    checkDumpImagesForKernel( const cl_kernel kernel );
@@ -884,6 +1005,14 @@ public:
 
     bool    checkCaptureReplayForKernel( const cl_kernel kernel );
     bool    checkCaptureReplayEnqueueLimits( uint64_t enqueueCounter ) const;
+    bool    checkCaptureReplayKernelSignature(
+                const cl_kernel kernel,
+                cl_uint workDim,
+                const size_t* gws,
+                const size_t* lws );
+    bool    checkCaptureReplayDeviceTimeTrigger();
+    void    addCaptureReplayTriggerEvent(
+                cl_event event );
     bool    checkCaptureReplayKernelSkips( const cl_kernel kernel );
 
     bool    checkAubCaptureEnqueueLimits( uint64_t enqueueCounter ) const;
@@ -900,11 +1029,32 @@ public:
 
     cl_device_type filterDeviceType( cl_device_type device_type ) const;
 
+    void*   allocateInitializedBufferContents(
+                size_t size );
+
     void    dumpMemoryToFile(
                 const std::string& fileName,
                 bool hash,
                 const void* ptr,
                 size_t size );
+    void*   beginDumpMemoryToFiles(
+                const std::string& captureReplayFileName,
+                const std::string& inspectionFileName,
+                bool hash,
+                size_t size,
+                std::vector<char>& transferBuf,
+                std::string& mappedFileName );
+    void    endDumpMemoryToFiles(
+                const std::string& captureReplayFileName,
+                const std::string& inspectionFileName,
+                bool hash,
+                const std::string& mappedFileName,
+                bool success,
+                void* ptr,
+                size_t size );
+    std::string dumpMemoryToBlob(
+                    const void* ptr,
+                    size_t size );
 
 #if defined(USE_ITT)
     __itt_domain*   ittDomain() const;
@@ -977,6 +1127,15 @@ public:
     cl_int  emulatedMemFree(
                 cl_context context,
                 const void* ptr );
+    void    emulatedInitUSMContext(
+                cl_context context );
+    static void CL_CALLBACK emulatedUSMContextDestructorCallback(
+                                cl_context,
+                                void* );
+    void    emulatedReleaseUSMContext(
+                cl_context context );
+    void    emulatedDestroyUSMContext(
+                cl_context context );
     cl_int  emulatedGetMemAllocInfoINTEL(
                 cl_context context,
                 const void* ptr,
@@ -984,6 +1143,22 @@ public:
                 size_t param_value_size,
                 void* param_value,
                 size_t* param_value_size_ret);
+    cl_int  emulatedEnqueueMigrateMem(
+                cl_command_queue queue,
+                const void* ptr,
+                size_t size,
+                cl_mem_migration_flags flags,
+                cl_uint num_events_in_wait_list,
+                const cl_event* event_wait_list,
+                cl_event* event);
+    cl_int  emulatedEnqueueMemAdvise(
+                cl_command_queue queue,
+                const void* ptr,
+                size_t size,
+                cl_mem_advice_intel advice,
+                cl_uint num_events_in_wait_list,
+                const cl_event* event_wait_list,
+                cl_event* event);
 
     cl_int  trackUSMKernelExecInfo(
                 cl_kernel kernel,
@@ -1001,8 +1176,11 @@ private:
     static const char* sc_URL;
     static const char* sc_DumpDirectoryName;
     static const char* sc_ReportFileName;
+    static const char* sc_KernelISAManifestFileName;
+    static const char* sc_LWSTuningFileName;
     static const char* sc_LogFileName;
     static const char* sc_TraceFileName;
+    static const char* sc_StreamCaptureFileName;
     static const char* sc_PerfCountersFileNamePrefix;
 
 #if defined(CLINTERCEPT_CMAKE)
@@ -1033,10 +1211,10 @@ private:
 
     void    addShortKernelName(
                 const std::string& kernelName );
-    std::string getShortKernelName(
-                    const cl_kernel kernel );
-    std::string getShortKernelNameWithHash(
-                    const cl_kernel kernel );
+    const std::string&  getShortKernelName(
+                            const cl_kernel kernel );
+    const std::string&  getShortKernelNameWithHash(
+                            const cl_kernel kernel );
 
     void    getCallLoggingPrefix(
                 std::string& str );
@@ -1073,12 +1251,23 @@ private:
 
     std::ofstream   m_InterceptLog;
     CChromeTracer   m_ChromeTrace;
+    CStreamCapture  m_StreamCapture;
 
     mutable char    m_StringBuffer[CLI_STRING_BUFFER_SIZE];
 
     bool        m_LoggedCLInfo;
 
     std::atomic<uint64_t>   m_EnqueueCounter;
+    std::atomic<uint64_t>   m_InitializeBuffersCounter;
+
+    CThreadPool m_ThreadPool;
+    CThreadPool m_SPIRVJobPool;
+
+    // Set when the intercept is shutting down, so tasks that are still
+    // queued to the thread pool, such as program dumps, don't call into
+    // OpenCL.  These are protected by the intercept mutex.
+    bool            m_ThreadPoolShutdown;
+    unsigned int    m_ProgramDumpsDropped;
 
     clock::time_point   m_StartTime;
 
@@ -1114,11 +1303,213 @@ private:
 
         uint64_t        ProgramHash = 0;
         uint64_t        OptionsHash = 0;
+
+        // Set for programs created from source that may be built from the
+        // program binary cache, the hash of the source that was passed to
+        // the driver, and the program that was built from the cache, if any.
+        bool            BinaryCacheEnabled = false;
+        uint64_t        BinaryCacheHash = 0;
+        cl_program      BinaryCacheProgram = NULL;
     };
 
     typedef std::map< cl_program, SProgramInfo >    CProgramInfoMap;
     CProgramInfoMap m_ProgramInfoMap;
 
+    // This defines a mapping between kernels created from a program built
+    // from the program binary cache and the application's program.  Each
+    // kernel holds a reference to the application's program, like kernels
+    // hold a reference to the program they were created from.
+    typedef std::map< cl_kernel, cl_program >   CBinaryCacheKernelMap;
+    CBinaryCacheKernelMap   m_BinaryCacheKernelMap;
+
+    // SPIR-V modules created by AutoCreateSPIRV, keyed by the program hash
+    // and a hash of the CLANG command line options.  Additional programs with
+    // the same key that are built while the module is being created are
+    // queued in PendingFileNames and receive a copy when it is done.
+    typedef std::pair< uint64_t, uint64_t > CSPIRVJobKey;
+    struct SSPIRVJobResult
+    {
+        bool            Done = false;
+        bool            Failed = false;
+        std::string     FileName;
+
+        std::vector< std::pair< std::string, std::string > >  PendingFileNames;
+    };
+
+    typedef std::map< CSPIRVJobKey, SSPIRVJobResult >   CSPIRVJobResultMap;
+    CSPIRVJobResultMap  m_SPIRVJobResultMap;
+
+    struct SSPIRVJobTiming
+    {
+        std::string     Name;
+        const char*     Result;
+        uint64_t        NS;
+    };
+
+    std::vector< SSPIRVJobTiming >  m_SPIRVJobTimings;
+
+    void    runSPIRVJob(
+                const CSPIRVJobKey& key,
+                const std::string& name,
+                const std::string& inputFileName,
+                const std::string& outputFileName,
+                const std::string& cacheFileName,
+                const std::string& clangOptions );
+    void    copySPIRVModule(
+                const std::string& srcFileName,
+                const std::string& dstFileName );
+
+    // Kernel ISA binaries that have been dumped, keyed by the program hash,
+    // options hash, and device, so rebuilds of the same program do not need
+    // to query the kernel ISA binaries again.  Each entry lists the kernel
+    // names and ISA files for the build.  Kernel ISA files are also shared
+    // by content hash, so each unique kernel ISA binary is written once.
+    struct SKernelISADumpKey
+    {
+        uint64_t        ProgramHash;
+        uint64_t        OptionsHash;
+        cl_device_id    Device;
+
+        bool operator<( const SKernelISADumpKey& other ) const
+        {
+            if( ProgramHash != other.ProgramHash )
+            {
+                return ProgramHash < other.ProgramHash;
+            }
+            if( OptionsHash != other.OptionsHash )
+            {
+                return OptionsHash < other.OptionsHash;
+            }
+            return Device < other.Device;
+        }
+    };
+
+    typedef std::vector< std::pair< std::string, std::string > >   CKernelISAFileList;
+    typedef std::map< SKernelISADumpKey, CKernelISAFileList >   CKernelISADumpMap;
+    CKernelISADumpMap   m_KernelISADumpMap;
+
+    // Unique kernel ISA binaries that have been dumped, keyed by a hash of
+    // the kernel ISA binary.  The contents are kept so a hash collision is
+    // never mistaken for a match.
+    struct SKernelISAFile
+    {
+        std::vector<char>   Data;
+        std::string         FileName;
+    };
+
+    typedef std::unordered_multimap< uint64_t, SKernelISAFile > CKernelISAFileMap;
+    CKernelISAFileMap   m_KernelISAFileMap;
+
+    bool    m_KernelISAManifestStarted;
+
+    // Program dump files that have been retrieved from the program and are
+    // waiting to be written by the thread pool.
+    struct SProgramDumpFile
+    {
+        std::string         FileName;
+        std::vector<char>   Data;
+    };
+
+    typedef std::vector< SProgramDumpFile > CProgramDumpFiles;
+
+    void    queueProgramDump(
+                CProgramDumpFiles& files );
+    void    dumpProgramFile(
+                CProgramDumpFiles* pFiles,
+                const std::string& fileName,
+                const void* ptr,
+                size_t size );
+    void    writeProgramBuildLog(
+                const std::string& fileNamePrefix,
+                const cl_device_id device,
+                const char* buildLog,
+                const size_t buildLogSize,
+                CProgramDumpFiles* pFiles );
+    void    writeProgramBinary(
+                const cl_program program,
+                const SProgramInfo& programInfo,
+                CProgramDumpFiles* pFiles );
+    void    writeKernelISABinaries(
+                const cl_program program,
+                const SProgramInfo& programInfo,
+                CProgramDumpFiles* pFiles );
+
+    // Index of the files in the Inject directory, used to avoid probing
+    // the filesystem for injection files that do not exist.
+    typedef std::unordered_set< std::string >   CInjectionFileSet;
+    CInjectionFileSet   m_InjectionFileSet;
+    std::string         m_InjectionDirectoryName;
+    bool                m_InjectionFileSetValid;
+    clock::time_point   m_InjectionFileSetTime;
+
+    bool    openInjectionFile(
+                const std::string& fileName,
+                std::ifstream& is );
+
+    // Programs that are watched for hot reload, keyed by the application's
+    // program, and the kernels from the most recently rebuilt program that
+    // are enqueued in place of the application's kernels.
+    struct SHotReloadProgramInfo
+    {
+        std::string     FileName1;
+        std::string     FileName2;
+
+        std::string     FileName;
+        uint64_t        ModifiedTime = 0;
+
+        cl_context      Context = NULL;
+        std::vector<cl_device_id>   Devices;
+        std::string     Options;
+
+        cl_program      Program = NULL;
+        unsigned int    Generation = 0;
+    };
+
+    typedef std::map< cl_program, SHotReloadProgramInfo >   CHotReloadProgramInfoMap;
+    CHotReloadProgramInfoMap    m_HotReloadProgramInfoMap;
+
+    struct SHotReloadKernelInfo
+    {
+        cl_kernel       Kernel = NULL;
+        unsigned int    Generation = 0;
+    };
+
+    typedef std::map< cl_kernel, SHotReloadKernelInfo > CHotReloadKernelInfoMap;
+    CHotReloadKernelInfoMap m_HotReloadKernelInfoMap;
+
+    bool                m_HotReloadCheckPending;
+    clock::time_point   m_HotReloadCheckTime;
+
+    void    checkHotReloadPrograms();
+    cl_int  setHotReloadKernelArgs(
+                const cl_kernel kernel,
+                const cl_kernel reloadKernel );
+
+    cl_program findBinaryCacheProgram(
+                const cl_program program ) const;
+    cl_program findBinaryCacheKernelProgram(
+                const cl_kernel kernel,
+                const cl_program program ) const;
+    void    getProgramBinaryCacheFileName(
+                uint64_t hash,
+                uint64_t optionsHash,
+                cl_uint numDevices,
+                const cl_device_id* devices,
+                std::string& fileName );
+    cl_program readProgramBinaryCacheFile(
+                const std::string& fileName,
+                cl_context context,
+                cl_uint numDevices,
+                const cl_device_id* devices,
+                uint64_t optionsHash,
+                bool& removed ) const;
+    bool    writeProgramBinaryCacheFile(
+                const std::string& fileName,
+                const cl_program program,
+                uint64_t optionsHash ) const;
+    size_t  trimProgramBinaryCache(
+                const std::string& directoryName ) const;
+
     struct SHostTimingStats
     {
         uint64_t    NumberOfCalls = 0;
@@ -1130,6 +1521,77 @@ private:
     typedef std::unordered_map< std::string, SHostTimingStats > CHostTimingStatsMap;
     CHostTimingStatsMap  m_HostTimingStatsMap;
 
+    // Program build timing is tracked per program hash, options hash,
+    // operation (build, compile, or link), and device.  Calls after the first
+    // for the same key are rebuilds.
+    struct SProgramBuildTimingStats
+    {
+        std::string Options;
+        size_t      SourceSize = 0;
+        size_t      NumKernels = 0;
+
+        uint64_t    NumberOfCalls = 0;
+        uint64_t    FirstNS = 0;
+        uint64_t    MinNS = ULLONG_MAX;
+        uint64_t    MaxNS = 0;
+        uint64_t    TotalNS = 0;
+    };
+
+    struct SProgramBuildTimingKey
+    {
+        uint64_t        ProgramHash;
+        uint64_t        OptionsHash;
+        std::string     Operation;
+
+        // All of the devices the program was built for.  Each build is
+        // counted once, even if it is for multiple devices.
+        std::vector< cl_device_id > Devices;
+
+        bool operator<( const SProgramBuildTimingKey& other ) const
+        {
+            if( ProgramHash != other.ProgramHash )
+            {
+                return ProgramHash < other.ProgramHash;
+            }
+            if( OptionsHash != other.OptionsHash )
+            {
+                return OptionsHash < other.OptionsHash;
+            }
+            if( Operation != other.Operation )
+            {
+                return Operation < other.Operation;
+            }
+            return Devices < other.Devices;
+        }
+    };
+
+    typedef std::map< SProgramBuildTimingKey, SProgramBuildTimingStats >  CProgramBuildTimingStatsMap;
+    CProgramBuildTimingStatsMap m_ProgramBuildTimingStatsMap;
+
+    // Redundant work is tracked for each unique program creation, program
+    // build, and kernel creation.  The number of objects that are alive at
+    // the same time is also tracked, so objects that are created again after
+    // being released are counted as redundant, but objects that are created
+    // multiple times because they are used concurrently are not.
+    struct SRedundantWorkStats
+    {
+        uint64_t    Count = 0;
+        uint64_t    Live = 0;
+        uint64_t    MaxLive = 0;
+        uint64_t    TotalNS = 0;
+    };
+
+    typedef std::map< std::string, SRedundantWorkStats >    CRedundantWorkStatsMap;
+    CRedundantWorkStatsMap  m_RedundantWorkStatsMap;
+
+    typedef std::unordered_map< const void*, std::vector<std::string> > CRedundantWorkObjectMap;
+    CRedundantWorkObjectMap m_RedundantWorkObjectMap;
+
+    void    addRedundantWork(
+                const void* object,
+                const std::string& key,
+                uint64_t ns );
+
     // These structures define a mapping between a device ID handle and
     // properties of a device, for easier querying.
 
@@ -1179,6 +1641,63 @@ private:
     typedef std::map< cl_device_id, CDeviceTimingStatsMap > CDeviceDeviceTimingStatsMap;
     CDeviceDeviceTimingStatsMap m_DeviceTimingStatsMap;
 
+    // This defines the shadow state for a kernel argument, which is used
+    // to dump, inject, and capture and replay kernel arguments.  Small
+    // argument values are stored inline and larger argument values reuse
+    // their storage, so setting a kernel argument does not allocate memory
+    // in the steady state.
+
+    struct SKernelArgInfo
+    {
+        const void*     Allocation = NULL;  // buffer, image, SVM, or USM base
+        size_t          LocalSize = 0;
+        size_t          DataSize = 0;
+
+        bool            IsLocal = false;
+        bool            HasData = false;
+        bool            HasSampler = false;
+
+        uint8_t         InlineData[ 16 ];
+        std::vector<uint8_t>    HeapData;
+
+        std::string     Sampler;
+
+        void    reset()
+        {
+            Allocation = NULL;
+            LocalSize = 0;
+            DataSize = 0;
+            IsLocal = false;
+            HasData = false;
+            HasSampler = false;
+        }
+
+        void    setData( const void* value, size_t size )
+        {
+            uint8_t*    dst = InlineData;
+            if( size > sizeof(InlineData) )
+            {
+                HeapData.resize( size );
+                dst = HeapData.data();
+            }
+            CLI_MEMCPY( dst, size, value, size );
+            DataSize = size;
+            HasData = true;
+        }
+
+        const uint8_t*  getData() const
+        {
+            return DataSize > sizeof(InlineData) ?
+                HeapData.data() :
+                InlineData;
+        }
+    };
+
+    typedef std::vector< SKernelArgInfo >   CKernelArgInfoVector;
+
+    // The most recent value set for each kernel exec info parameter.
+    typedef std::map< cl_kernel_exec_info, std::vector<uint8_t> >   CKernelExecInfoMap;
+
     // This defines a mapping between the kernel handle and information
     // about the kernel.
 
@@ -1186,16 +1705,30 @@ private:
     {
         std::string     KernelName;
 
+        // The short kernel name, and the short kernel name with the program
+        // hash, if KernelNameHashTracking is enabled.  These are computed
+        // once when the kernel is created and point into the interned kernel
+        // name set, so they are never modified or freed.
+        const std::string*  ShortKernelName = NULL;
+        const std::string*  ShortKernelNameWithHash = NULL;
+
         uint64_t        ProgramHash;
         uint64_t        OptionsHash;
 
         unsigned int    ProgramNumber;
         unsigned int    CompileCount;
+
+        CKernelArgInfoVector    Args;
+        CKernelExecInfoMap      ExecInfo;
     };
 
-    typedef std::map< cl_kernel, SKernelInfo >  CKernelInfoMap;
+    typedef std::unordered_map< cl_kernel, SKernelInfo >    CKernelInfoMap;
     CKernelInfoMap  m_KernelInfoMap;
 
+    SKernelArgInfo& getKernelArgInfo(
+                        const cl_kernel kernel,
+                        cl_uint arg_index );
+
     // This defines a mapping between the "real" kernel name and a kernel
     // name ID.  Only kernels with names larger than a control variable
     // will be added to this map.
@@ -1205,6 +1738,14 @@ private:
     typedef std::unordered_map< std::string, std::string >  CLongKernelNameMap;
     CLongKernelNameMap  m_LongKernelNameMap;
 
+    // Interned kernel names.  Elements of an unordered_set are never moved,
+    // so pointers to the strings in this set remain valid.
+    typedef std::unordered_set< std::string >   CKernelNameSet;
+    CKernelNameSet  m_KernelNameSet;
+
+    void    setShortKernelNames(
+                SKernelInfo& kernelInfo );
+
     // This is a list of pending events that haven't been added to the
     // device timing stats map yet.
 
@@ -1223,6 +1764,111 @@ private:
     typedef std::list< SEventListNode > CEventList;
     CEventList  m_EventList;
 
+    // Local work size autotuning state, keyed by a string identifying the
+    // device, the kernel, and the global work size.  Candidate zero is the
+    // local work size that would have been used without tuning.  A local
+    // work size of all zeros means a NULL local work size.
+    struct SLWSTuningCandidate
+    {
+        size_t      LWS[3];
+        cl_uint     Samples;
+        cl_ulong    MinNS;
+    };
+
+    struct SLWSTuningInfo
+    {
+        bool        Done = false;
+        cl_uint     WorkDim = 0;
+        size_t      Best[3] = { 0, 0, 0 };
+
+        std::vector< SLWSTuningCandidate >  Candidates;
+        size_t      NumEnqueued = 0;
+        size_t      NumPending = 0;
+
+        cl_ulong    BaselineNS = 0;
+        cl_ulong    BestNS = 0;
+    };
+
+    typedef std::map< std::string, SLWSTuningInfo > CLWSTuningInfoMap;
+    CLWSTuningInfoMap   m_LWSTuningInfoMap;
+    bool                m_LWSTuningDatabaseLoaded;
+
+    struct SLWSTuningEvent
+    {
+        cl_command_queue    Queue;
+        std::string     Key;
+        size_t          Candidate;
+        cl_event        Event;
+    };
+
+    typedef std::list< SLWSTuningEvent >    CLWSTuningEventList;
+    CLWSTuningEventList m_LWSTuningEventList;
+
+    // Local work sizes chosen for dispatches that are done tuning, keyed by
+    // the kernel and queue handles and the global work size, so enqueues
+    // after tuning has finished don't need the intercept mutex, device
+    // queries, or a string key.  This is protected by its own mutex, which
+    // may be acquired while holding the intercept mutex, but not vice versa.
+    struct SLWSTuningDecisionKey
+    {
+        cl_kernel           Kernel;
+        cl_command_queue    Queue;
+        cl_uint             WorkDim;
+        size_t              GWS[3];
+
+        bool operator<( const SLWSTuningDecisionKey& other ) const
+        {
+            if( Kernel != other.Kernel )
+            {
+                return Kernel < other.Kernel;
+            }
+            if( Queue != other.Queue )
+            {
+                return Queue < other.Queue;
+            }
+            if( WorkDim != other.WorkDim )
+            {
+                return WorkDim < other.WorkDim;
+            }
+            return std::lexicographical_compare(
+                GWS, GWS + WorkDim,
+                other.GWS, other.GWS + WorkDim );
+        }
+    };
+
+    // If UseOriginal is set, the local work size the application passed is
+    // used, because the tuned local work size is not valid for this kernel.
+    struct SLWSTuningDecision
+    {
+        bool        UseOriginal;
+        size_t      LWS[3];
+    };
+
+    typedef std::map< SLWSTuningDecisionKey, SLWSTuningDecision >   CLWSTuningDecisionMap;
+    CLWSTuningDecisionMap   m_LWSTuningDecisionMap;
+    std::mutex              m_LWSTuningDecisionMutex;
+
+    void    getLWSTuningFileName(
+                std::string& fileName ) const;
+    void    loadLWSTuningDatabase();
+    void    updateLWSTuningEvents();
+    void    getLWSTuningCandidates(
+                const cl_device_id device,
+                const cl_kernel kernel,
+                const cl_uint work_dim,
+                const size_t* global_work_size,
+                const size_t* local_work_size,
+                std::vector< SLWSTuningCandidate >& candidates );
+    void    finishLWSTuning(
+                const std::string& key,
+                SLWSTuningInfo& info );
+    bool    checkLWSTuningResult(
+                const cl_device_id device,
+                const cl_kernel kernel,
+                const cl_uint work_dim,
+                const size_t* global_work_size,
+                const size_t* local_work_size );
+
 #if defined(USE_MDAPI)
     MetricsDiscovery::MDHelper* m_pMDHelper;
     MetricsDiscovery::CMetricAggregations m_MetricAggregations;
@@ -1260,10 +1906,10 @@ private:
     typedef std::map< cl_mem, size_t >  CBufferInfoMap;
     CBufferInfoMap      m_BufferInfoMap;
 
-    typedef std::map< const void*, size_t > CSVMAllocInfoMap;
+    typedef CAddressRangeMap<>  CSVMAllocInfoMap;
     CSVMAllocInfoMap    m_SVMAllocInfoMap;
 
-    typedef std::map< const void*, size_t > CUSMAllocInfoMap;
+    typedef CAddressRangeMap<>  CUSMAllocInfoMap;
     CUSMAllocInfoMap    m_USMAllocInfoMap;
 
     struct SImageInfo
@@ -1279,21 +1925,18 @@ private:
     typedef std::map< cl_mem, SImageInfo >  CImageInfoMap;
     CImageInfoMap   m_ImageInfoMap;
 
-    typedef std::map< cl_uint, const void* >    CArgMemMap;
-    typedef std::map< cl_kernel, CArgMemMap >   CKernelArgMemMap;
-    CKernelArgMemMap    m_KernelArgMemMap;
-
-    typedef std::map< cl_uint, std::string >    CArgSamplerMap;
-    typedef std::map< cl_kernel, CArgSamplerMap >   CKernelArgSamplerMap;
-    CKernelArgSamplerMap    m_KernelArgSamplerMap;
-
-    typedef std::map< cl_uint, std::vector<uint8_t> >   CArgDataMap;
-    typedef std::map< cl_kernel, CArgDataMap >  CKernelArgDataMap;
-    CKernelArgDataMap   m_KernelArgDataMap;
+    struct SImageDumpJob
+    {
+        cl_mem      Image;
+        SImageInfo  Info;
+        std::string CaptureReplayFileName;
+        std::string InspectionFileName;
+        std::string ErrorString;
+    };
 
-    typedef std::map< cl_uint, size_t > CArgLocalSizeMap;
-    typedef std::map< cl_kernel, CArgLocalSizeMap > CKernelArgLocalSizeMap;
-    CKernelArgLocalSizeMap  m_KernelArgLocalSizeMap;
+    void    dumpImageToFiles(
+                cl_command_queue command_queue,
+                SImageDumpJob& job );
 
     typedef std::map<cl_program, std::string> CSourceStringMap;
     CSourceStringMap m_SourceStringMap;
@@ -1313,6 +1956,16 @@ private:
     typedef std::set<std::string>   CCaptureReplaySet;
     CCaptureReplaySet   m_CaptureReplaySet;
 
+    // Kernel capture and replay device time trigger state.  Events for
+    // matching kernel enqueues are checked when the next matching kernel is
+    // enqueued, and the trigger is armed if any of them took long enough.
+    typedef std::list< cl_event >   CCaptureReplayTriggerEventList;
+    CCaptureReplayTriggerEventList  m_CaptureReplayTriggerEventList;
+    bool    m_CaptureReplayTriggerArmed;
+
+    typedef std::set<std::string>   CCaptureReplayBlobSet;
+    CCaptureReplayBlobSet   m_CaptureReplayBlobSet;
+
     bool    m_AubCaptureStarted;
     cl_uint m_AubCaptureKernelEnqueueSkipCounter;
     cl_uint m_AubCaptureKernelEnqueueCaptureCounter;
@@ -1323,23 +1976,65 @@ private:
     typedef std::map< cl_context, SContextCallbackInfo* >   CContextCallbackInfoMap;
     CContextCallbackInfoMap m_ContextCallbackInfoMap;
 
+    // Kernel overrides are built lazily, the first time they are needed, for
+    // a specific context and device.  For builtin kernel overrides the device
+    // may be NULL, meaning all of the devices in the context.  Overrides that
+    // could not be built are recorded as NULL so they are not rebuilt.
+    typedef std::pair< cl_context, cl_device_id >   CKernelOverridesKey;
+
+    cl_program createKernelOverrideProgram(
+                const cl_context context,
+                const cl_device_id device,
+                const char* programString,
+                size_t programStringLength,
+                const char* options,
+                cl_int& errorCode );
+
     struct SPrecompiledKernelOverrides
     {
         cl_program  Program;
 
         cl_kernel   Kernel_CopyBufferBytes;
-        cl_kernel   Kernel_CopyBufferUInts;
-        cl_kernel   Kernel_CopyBufferUInt4s;
-        cl_kernel   Kernel_CopyBufferUInt16s;
+        cl_kernel   Kernel_CopyBufferAlignedUInts;
+        cl_kernel   Kernel_CopyBufferAlignedUInt4s;
+        cl_kernel   Kernel_CopyBufferUnalignedUChar16s;
+        cl_kernel   Kernel_CopyBufferRect;
 
         cl_kernel   Kernel_CopyImage2Dto2DFloat;
         cl_kernel   Kernel_CopyImage2Dto2DInt;
         cl_kernel   Kernel_CopyImage2Dto2DUInt;
+
+        // These kernels are optional and may be NULL.
+        cl_kernel   Kernel_CopyImage2Dto3DFloat;
+        cl_kernel   Kernel_CopyImage2Dto3DInt;
+        cl_kernel   Kernel_CopyImage2Dto3DUInt;
+        cl_kernel   Kernel_CopyImage3Dto2DFloat;
+        cl_kernel   Kernel_CopyImage3Dto2DInt;
+        cl_kernel   Kernel_CopyImage3Dto2DUInt;
+        cl_kernel   Kernel_CopyImage3Dto3DFloat;
+        cl_kernel   Kernel_CopyImage3Dto3DInt;
+        cl_kernel   Kernel_CopyImage3Dto3DUInt;
+
+        // Set by the copy buffer benchmark, one per benchmarked copy size.
+        // If set, the implementation's clEnqueueCopyBuffer() was faster
+        // than the override kernels for copies of this size.
+        std::vector<bool>   UseNativeCopyBuffer;
     };
 
-    typedef std::map< cl_context, SPrecompiledKernelOverrides* >    CPrecompiledKernelOverridesMap;
+    typedef std::map< CKernelOverridesKey, SPrecompiledKernelOverrides* >   CPrecompiledKernelOverridesMap;
     CPrecompiledKernelOverridesMap  m_PrecompiledKernelOverridesMap;
 
+    SPrecompiledKernelOverrides* getPrecompiledKernelOverrides(
+                const cl_context context,
+                const cl_command_queue queue );
+    SPrecompiledKernelOverrides* initPrecompiledKernelOverrides(
+                const cl_context context,
+                const cl_device_id device );
+    void    benchmarkCopyBufferOverrides(
+                const cl_context context,
+                const cl_device_id device,
+                SPrecompiledKernelOverrides* pOverrides );
+
     struct SBuiltinKernelOverrides
     {
         cl_program  Program;
@@ -1347,9 +2042,13 @@ private:
         cl_kernel   Kernel_block_motion_estimate_intel;
     };
 
-    typedef std::map< cl_context, SBuiltinKernelOverrides* >    CBuiltinKernelOverridesMap;
+    typedef std::map< CKernelOverridesKey, SBuiltinKernelOverrides* >   CBuiltinKernelOverridesMap;
     CBuiltinKernelOverridesMap  m_BuiltinKernelOverridesMap;
 
+    SBuiltinKernelOverrides* initBuiltinKernelOverrides(
+                const cl_context context,
+                const cl_device_id device );
+
     typedef std::map< cl_accelerator_intel, cl_platform_id >    CAcceleratorInfoMap;
     CAcceleratorInfoMap     m_AcceleratorInfoMap;
 
@@ -1423,11 +2122,34 @@ private:
         const void*     BaseAddress = NULL;
         size_t          Size = 0;
         size_t          Alignment = 0;
+
+        // Nonzero if this allocation is a chunk of a pool slab.
+        size_t          PoolChunkSize = 0;
     };
 
-    typedef std::map< const void*, SUSMAllocInfo >  CUSMAllocMap;
+    typedef CAddressRangeMap< SUSMAllocInfo >   CUSMAllocMap;
     typedef std::vector<const void*>    CUSMAllocVector;
 
+    // Small allocations are carved from large SVM slabs.  Chunk sizes are
+    // powers of two at least as large as the requested alignment, and chunks
+    // are aligned to their size (up to the slab alignment), so any chunk on
+    // a free list satisfies any allocation of the same size class.
+    struct SUSMPool
+    {
+        struct SSlab
+        {
+            void*   Base;
+            size_t  Size;
+        };
+
+        std::vector<SSlab>  Slabs;
+        size_t              SlabOffset = 0;
+        size_t              BytesInUse = 0;
+
+        // Indexed by log2 of the chunk size.
+        std::vector<void*>  FreeLists[ sizeof(size_t) * 8 ];
+    };
+
     struct SUSMContextInfo
     {
         CUSMAllocMap    AllocMap;
@@ -1437,11 +2159,73 @@ private:
         CUSMAllocVector SharedAllocVector;
         // Note: We could differentiate between device allocs for
         // specific devices, but we do not do this currently.
+
+        SUSMPool        HostPool;
+        SUSMPool        DevicePool;
+        SUSMPool        SharedPool;
     };
 
     typedef std::map< cl_context, SUSMContextInfo > CUSMContextInfoMap;
     CUSMContextInfoMap  m_USMContextInfoMap;
 
+    // Contexts that have been destroyed, recorded by the context destructor
+    // callback.  The callback may be called while the intercept mutex is
+    // held, so it only takes this mutex, and the contexts are removed from
+    // the map the next time a context is created or released.
+    std::mutex              m_USMDestroyedContextsMutex;
+    std::vector<cl_context> m_USMDestroyedContexts;
+
+    void    removeDestroyedUSMContexts();
+
+    struct SUSMPoolStats
+    {
+        uint64_t    NumSlabs = 0;
+        uint64_t    SlabBytes = 0;
+        uint64_t    NumPooledAllocs = 0;
+        uint64_t    NumReusedAllocs = 0;
+        uint64_t    NumUnpooledAllocs = 0;
+        uint64_t    NumPooledFrees = 0;
+        uint64_t    BytesInUse = 0;
+        uint64_t    PeakBytesInUse = 0;
+    };
+
+    typedef std::map< cl_unified_shared_memory_type_intel, SUSMPoolStats > CUSMPoolStatsMap;
+    CUSMPoolStatsMap    m_USMPoolStatsMap;
+
+    struct SUSMHintStats
+    {
+        uint64_t    NumMigrations = 0;
+        uint64_t    NumMigrationsToHost = 0;
+        uint64_t    NumMigrationMarkers = 0;
+        uint64_t    MigratedBytes = 0;
+
+        std::map< cl_mem_advice_intel, uint64_t >   AdviceCounts;
+    };
+
+    typedef std::map< cl_unified_shared_memory_type_intel, SUSMHintStats > CUSMHintStatsMap;
+    CUSMHintStatsMap    m_USMHintStatsMap;
+
+    cl_unified_shared_memory_type_intel getEmulatedUSMAllocType(
+                cl_command_queue queue,
+                const void* ptr );
+
+    bool    shouldPoolUSMAlloc(
+                size_t size,
+                cl_uint alignment ) const;
+    void*   allocateUSMFromPool(
+                cl_context context,
+                SUSMPool& pool,
+                SUSMPoolStats& stats,
+                cl_svm_mem_flags flags,
+                size_t size,
+                cl_uint alignment,
+                size_t& chunkSize );
+    void    freeUSMToPool(
+                SUSMPool& pool,
+                SUSMPoolStats& stats,
+                const void* ptr,
+                size_t chunkSize );
+
     struct SUSMKernelInfo
     {
         bool    IndirectHostAccess = false;
@@ -2032,6 +2816,189 @@ inline CObjectTracker& CLIntercept::objectTracker()
         pIntercept->objectTracker().AddPointerFree(_ptr);                   \
     }
 
+///////////////////////////////////////////////////////////////////////////////
+//
+inline CStreamCapture& CLIntercept::streamCapture()
+{
+    return m_StreamCapture;
+}
+
+#define STREAM_CAPTURE_CREATE_CONTEXT( _context )                           \
+    if( pIntercept->config().CaptureStream && _context )                    \
+    {                                                                       \
+        pIntercept->streamCapture().createContext( _context );              \
+    }
+
+#define STREAM_CAPTURE_CREATE_COMMAND_QUEUE( _queue, _context, _properties )\
+    if( pIntercept->config().CaptureStream && _queue )                      \
+    {                                                                       \
+        pIntercept->streamCapture().createCommandQueue(                     \
+            _queue, _context, _properties );                                \
+    }
+
+#define STREAM_CAPTURE_CREATE_COMMAND_QUEUE_WITH_PROPERTIES( _queue, _context, _properties )\
+    if( pIntercept->config().CaptureStream && _queue )                      \
+    {                                                                       \
+        pIntercept->streamCapture().createCommandQueueWithProperties(       \
+            _queue, _context, _properties );                                \
+    }
+
+#define STREAM_CAPTURE_CREATE_BUFFER( _mem, _context, _flags, _size, _ptr ) \
+    if( pIntercept->config().CaptureStream && _mem )                        \
+    {                                                                       \
+        pIntercept->streamCapture().createBuffer(                           \
+            _mem, _context, _flags, _size, _ptr );                          \
+    }
+
+#define STREAM_CAPTURE_CREATE_PROGRAM_WITH_SOURCE( _program, _context, _count, _strings, _lengths )\
+    if( pIntercept->config().CaptureStream && _program )                    \
+    {                                                                       \
+        pIntercept->streamCapture().createProgramWithSource(                \
+            _program, _context, _count, _strings, _lengths );               \
+    }
+
+#define STREAM_CAPTURE_CREATE_PROGRAM_WITH_IL( _program, _context, _il, _length )\
+    if( pIntercept->config().CaptureStream && _program )                    \
+    {                                                                       \
+        pIntercept->streamCapture().createProgram(                          \
+            STREAM_RECORD_CREATE_PROGRAM_WITH_IL,                           \
+            _program, _context, _il, _length );                             \
+    }
+
+/* Only the binary for the first device is recorded. */
+#define STREAM_CAPTURE_CREATE_PROGRAM_WITH_BINARY( _program, _context, _num, _lengths, _binaries )\
+    if( pIntercept->config().CaptureStream && _program && _num )            \
+    {                                                                       \
+        pIntercept->streamCapture().createProgram(                          \
+            STREAM_RECORD_CREATE_PROGRAM_WITH_BINARY,                       \
+            _program, _context, _binaries[0], _lengths[0] );                \
+    }
+
+#define STREAM_CAPTURE_BUILD_PROGRAM( _program, _options, _retVal )         \
+    if( pIntercept->config().CaptureStream && _retVal == CL_SUCCESS )       \
+    {                                                                       \
+        pIntercept->streamCapture().buildProgram( _program, _options );     \
+    }
+
+// Builds the precompiled kernel overrides, and runs the buffer override
+// benchmark, before the first overridden enqueue is timed.
+#define PREPARE_PRECOMPILED_KERNEL_OVERRIDES( _control, _queue )            \
+    if( pIntercept->config()._control )                                     \
+    {                                                                       \
+        pIntercept->prepareKernelOverrides( _queue );                       \
+    }
+
+#define STREAM_CAPTURE_CREATE_KERNEL( _kernel, _program, _name )            \
+    if( pIntercept->config().CaptureStream && _kernel )                     \
+    {                                                                       \
+        pIntercept->streamCapture().createKernel(                           \
+            _kernel, _program, _name );                                     \
+    }
+
+#define STREAM_CAPTURE_SET_KERNEL_ARG( _kernel, _index, _size, _value, _retVal )\
+    if( pIntercept->config().CaptureStream && _retVal == CL_SUCCESS )       \
+    {                                                                       \
+        pIntercept->streamCapture().setKernelArg(                           \
+            _kernel, _index, _size, _value );                               \
+    }
+
+#define STREAM_CAPTURE_ENQUEUE_NDRANGE_KERNEL( _queue, _kernel, _workDim, _gwo, _gws, _lws, _numEvents, _waitList, _event, _retVal )\
+    if( pIntercept->config().CaptureStream && _retVal == CL_SUCCESS )       \
+    {                                                                       \
+        pIntercept->streamCapture().enqueueNDRangeKernel(                   \
+            _queue, _kernel, _workDim, _gwo, _gws, _lws,                    \
+            _numEvents, _waitList, _event );                                \
+    }
+
+#define STREAM_CAPTURE_ENQUEUE_WRITE_BUFFER( _queue, _mem, _blocking, _offset, _size, _ptr, _numEvents, _waitList, _event, _retVal )\
+    if( pIntercept->config().CaptureStream && _retVal == CL_SUCCESS )       \
+    {                                                                       \
+        pIntercept->streamCapture().enqueueWriteBuffer(                     \
+            _queue, _mem, _blocking, _offset, _size, _ptr,                  \
+            _numEvents, _waitList, _event );                                \
+    }
+
+#define STREAM_CAPTURE_ENQUEUE_READ_BUFFER( _queue, _mem, _blocking, _offset, _size, _numEvents, _waitList, _event, _retVal )\
+    if( pIntercept->config().CaptureStream && _retVal == CL_SUCCESS )       \
+    {                                                                       \
+        pIntercept->streamCapture().enqueueReadBuffer(                      \
+            _queue, _mem, _blocking, _offset, _size,                        \
+            _numEvents, _waitList, _event );                                \
+    }
+
+#define STREAM_CAPTURE_ENQUEUE_COPY_BUFFER( _queue, _src, _dst, _srcOffset, _dstOffset, _size, _numEvents, _waitList, _event, _retVal )\
+    if( pIntercept->config().CaptureStream && _retVal == CL_SUCCESS )       \
+    {                                                                       \
+        pIntercept->streamCapture().enqueueCopyBuffer(                      \
+            _queue, _src, _dst, _srcOffset, _dstOffset, _size,              \
+            _numEvents, _waitList, _event );                                \
+    }
+
+#define STREAM_CAPTURE_ENQUEUE_FILL_BUFFER( _queue, _mem, _pattern, _patternSize, _offset, _size, _numEvents, _waitList, _event, _retVal )\
+    if( pIntercept->config().CaptureStream && _retVal == CL_SUCCESS )       \
+    {                                                                       \
+        pIntercept->streamCapture().enqueueFillBuffer(                      \
+            _queue, _mem, _pattern, _patternSize, _offset, _size,           \
+            _numEvents, _waitList, _event );                                \
+    }
+
+#define STREAM_CAPTURE_ENQUEUE_MAP_BUFFER( _queue, _mem, _blocking, _flags, _offset, _size, _ptr, _numEvents, _waitList, _event )\
+    if( pIntercept->config().CaptureStream && _ptr )                        \
+    {                                                                       \
+        pIntercept->streamCapture().enqueueMapBuffer(                       \
+            _queue, _mem, _blocking, _flags, _offset, _size, _ptr,          \
+            _numEvents, _waitList, _event );                                \
+    }
+
+#define STREAM_CAPTURE_ENQUEUE_UNMAP_INIT( _mem, _ptr )                     \
+    std::vector<char>   streamCaptureUnmapData;                             \
+    if( pIntercept->config().CaptureStream )                                \
+    {                                                                       \
+        pIntercept->streamCapture().getUnmapData(                           \
+            _mem, _ptr, streamCaptureUnmapData );                           \
+    }
+
+#define STREAM_CAPTURE_ENQUEUE_UNMAP_MEM_OBJECT( _queue, _mem, _ptr, _numEvents, _waitList, _event, _retVal )\
+    if( pIntercept->config().CaptureStream && _retVal == CL_SUCCESS )       \
+    {                                                                       \
+        pIntercept->streamCapture().enqueueUnmapMemObject(                  \
+            _queue, _mem, _ptr, streamCaptureUnmapData,                     \
+            _numEvents, _waitList, _event );                                \
+    }
+
+#define STREAM_CAPTURE_ENQUEUE_MARKER_OR_BARRIER( _type, _queue, _numEvents, _waitList, _event, _retVal )\
+    if( pIntercept->config().CaptureStream && _retVal == CL_SUCCESS )       \
+    {                                                                       \
+        pIntercept->streamCapture().enqueueMarkerOrBarrier(                 \
+            _type, _queue, _numEvents, _waitList, _event );                 \
+    }
+
+#define STREAM_CAPTURE_QUEUE_OPERATION( _type, _queue, _retVal )            \
+    if( pIntercept->config().CaptureStream && _retVal == CL_SUCCESS )       \
+    {                                                                       \
+        pIntercept->streamCapture().queueOperation( _type, _queue );        \
+    }
+
+#define STREAM_CAPTURE_WAIT_FOR_EVENTS( _numEvents, _eventList, _retVal )   \
+    if( pIntercept->config().CaptureStream && _retVal == CL_SUCCESS )       \
+    {                                                                       \
+        pIntercept->streamCapture().waitForEvents( _numEvents, _eventList );\
+    }
+
+#define STREAM_CAPTURE_RETAIN( _obj, _retVal )                              \
+    if( pIntercept->config().CaptureStream && _retVal == CL_SUCCESS )       \
+    {                                                                       \
+        pIntercept->streamCapture().retainOrRelease(                        \
+            STREAM_RECORD_RETAIN, _obj );                                   \
+    }
+
+#define STREAM_CAPTURE_RELEASE( _obj, _retVal )                             \
+    if( pIntercept->config().CaptureStream && _retVal == CL_SUCCESS )       \
+    {                                                                       \
+        pIntercept->streamCapture().retainOrRelease(                        \
+            STREAM_RECORD_RELEASE, _obj );                                  \
+    }
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 #define LOG_CLINFO()                                                        \
@@ -2043,12 +3010,19 @@ inline CObjectTracker& CLIntercept::objectTracker()
 ///////////////////////////////////////////////////////////////////////////////
 //
 #define BUILD_LOGGING_INIT()                                                \
-    CLIntercept::clock::time_point  buildTimeStart;                         \
-    if( pIntercept->config().BuildLogging )                                 \
+    CLIntercept::clock::time_point  buildTimeStart, buildTimeEnd;           \
+    if( pIntercept->config().BuildLogging ||                                \
+        pIntercept->config().ProgramBuildTiming )                           \
     {                                                                       \
         buildTimeStart = CLIntercept::clock::now();                         \
     }
 
+#define BUILD_LOGGING_END()                                                 \
+    if( pIntercept->config().ProgramBuildTiming )                           \
+    {                                                                       \
+        buildTimeEnd = CLIntercept::clock::now();                           \
+    }
+
 #define BUILD_LOGGING( program, num_devices, device_list )                  \
     if( pIntercept->config().BuildLogging )                                 \
     {                                                                       \
@@ -2059,6 +3033,19 @@ inline CObjectTracker& CLIntercept::objectTracker()
             device_list );                                                  \
     }
 
+#define PROGRAM_BUILD_TIMING( program, num_devices, device_list, options, operation ) \
+    if( program && pIntercept->config().ProgramBuildTiming )                \
+    {                                                                       \
+        pIntercept->addProgramBuildTiming(                                  \
+            buildTimeStart,                                                 \
+            buildTimeEnd,                                                   \
+            program,                                                        \
+            num_devices,                                                    \
+            device_list,                                                    \
+            options,                                                        \
+            operation );                                                    \
+    }
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 #define CALL_LOGGING_ENTER(...)                                             \
@@ -2325,17 +3312,56 @@ inline bool CLIntercept::checkCaptureReplayEnqueueLimits(
 }
 
 #define CHECK_CAPTURE_REPLAY_START_KERNEL( kernel, wd, gwo, gws, lws )      \
-    bool captureReplay =                                                    \
-        pIntercept->config().CaptureReplay &&                               \
+    bool captureReplay = false;                                             \
+    bool isCaptureReplayTriggerEnqueue = false;                             \
+    if( pIntercept->config().CaptureReplay &&                               \
         pIntercept->checkCaptureReplayEnqueueLimits( enqueueCounter ) &&    \
         pIntercept->checkCaptureReplayForKernel( kernel ) &&                \
-        pIntercept->checkCaptureReplayKernelSkips( kernel );                \
+        pIntercept->checkCaptureReplayKernelSignature( kernel, wd, gws, lws ) )\
+    {                                                                       \
+        if( pIntercept->config().CaptureReplayMinDeviceTimeUS == 0 ||       \
+            pIntercept->checkCaptureReplayDeviceTimeTrigger() )             \
+        {                                                                   \
+            captureReplay =                                                 \
+                pIntercept->checkCaptureReplayKernelSkips( kernel );        \
+        }                                                                   \
+        else                                                                \
+        {                                                                   \
+            isCaptureReplayTriggerEnqueue = true;                           \
+        }                                                                   \
+    }                                                                       \
     if( captureReplay )                                                     \
     {                                                                       \
         pIntercept->startCaptureReplay(                                     \
             enqueueCounter, kernel, wd, gwo, gws, lws );                    \
     }
 
+#define CAPTURE_REPLAY_TRIGGER_INIT( pEvent )                               \
+    cl_event    captureReplayTriggerLocalEvent = NULL;                      \
+    bool        isCaptureReplayTriggerLocalEvent = false;                   \
+    if( isCaptureReplayTriggerEnqueue && pEvent == NULL )                   \
+    {                                                                       \
+        pEvent = &captureReplayTriggerLocalEvent;                           \
+        isCaptureReplayTriggerLocalEvent = true;                            \
+    }
+
+#define CAPTURE_REPLAY_TRIGGER_END( _retVal, pEvent )                       \
+    if( isCaptureReplayTriggerEnqueue )                                     \
+    {                                                                       \
+        if( _retVal == CL_SUCCESS && pEvent )                               \
+        {                                                                   \
+            pIntercept->addCaptureReplayTriggerEvent( pEvent[0] );          \
+        }                                                                   \
+        if( isCaptureReplayTriggerLocalEvent )                              \
+        {                                                                   \
+            if( _retVal == CL_SUCCESS )                                     \
+            {                                                               \
+                pIntercept->dispatch().clReleaseEvent( pEvent[0] );         \
+            }                                                               \
+            pEvent = NULL;                                                  \
+        }                                                                   \
+    }
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 inline bool CLIntercept::checkDumpBuffersForKernel( const cl_kernel kernel )
@@ -2531,6 +3557,7 @@ inline bool CLIntercept::checkDumpImageEnqueueLimits(
         pIntercept->config().DumpImagesAfterEnqueue ||                      \
         pIntercept->config().InjectBuffers ||                               \
         pIntercept->config().InjectImages ||                                \
+        pIntercept->config().InjectProgramHotReload ||                      \
         pIntercept->config().CaptureReplay )                                \
     {                                                                       \
         pIntercept->setKernelArg( kernel, arg_index, arg_value, arg_size ); \
@@ -2541,6 +3568,7 @@ inline bool CLIntercept::checkDumpImageEnqueueLimits(
         pIntercept->config().DumpBuffersAfterEnqueue ||                     \
         pIntercept->config().InjectBuffers ||                               \
         pIntercept->config().InjectImages ||                                \
+        pIntercept->config().InjectProgramHotReload ||                      \
         pIntercept->config().CaptureReplay )                                \
     {                                                                       \
         pIntercept->setKernelArgSVMPointer( kernel, arg_index, arg_value ); \
@@ -2551,22 +3579,33 @@ inline bool CLIntercept::checkDumpImageEnqueueLimits(
         pIntercept->config().DumpBuffersAfterEnqueue ||                     \
         pIntercept->config().InjectBuffers ||                               \
         pIntercept->config().InjectImages ||                                \
+        pIntercept->config().InjectProgramHotReload ||                      \
         pIntercept->config().CaptureReplay )                                \
     {                                                                       \
         pIntercept->setKernelArgUSMPointer( kernel, arg_index, arg_value ); \
     }
 
+#define SET_KERNEL_EXEC_INFO( kernel, param_name, param_value_size, param_value, retVal ) \
+    if( ( retVal == CL_SUCCESS ) &&                                         \
+        pIntercept->config().InjectProgramHotReload )                       \
+    {                                                                       \
+        pIntercept->setKernelExecInfo(                                      \
+            kernel,                                                         \
+            param_name,                                                     \
+            param_value_size,                                               \
+            param_value );                                                  \
+    }
+
 #define INITIALIZE_BUFFER_CONTENTS_INIT( _flags, _size, _ptr )              \
-    char*   zeroData = NULL;                                                \
+    void*   initData = NULL;                                                \
     if( pIntercept->config().InitializeBuffers &&                           \
         _ptr == NULL &&                                                     \
         !( _flags & ( CL_MEM_USE_HOST_PTR | CL_MEM_COPY_HOST_PTR ) ) )      \
     {                                                                       \
-        zeroData = new char[ _size ];                                       \
-        if( zeroData != NULL )                                              \
+        initData = pIntercept->allocateInitializedBufferContents( _size );  \
+        if( initData != NULL )                                              \
         {                                                                   \
-            memset( zeroData, 0, _size );                                   \
-            _ptr = zeroData;                                                \
+            _ptr = initData;                                                \
             _flags |= (cl_mem_flags)CL_MEM_COPY_HOST_PTR;                   \
         }                                                                   \
     }
@@ -2576,10 +3615,10 @@ inline bool CLIntercept::checkDumpImageEnqueueLimits(
 // whereas if the flags were reset then the dump buffer after create step
 // would not be triggered.
 #define INITIALIZE_BUFFER_CONTENTS_CLEANUP( _flags, _ptr )                  \
-    if( zeroData != NULL )                                                  \
+    if( initData != NULL )                                                  \
     {                                                                       \
-        delete [] zeroData;                                                 \
-        zeroData = NULL;                                                    \
+        free( initData );                                                   \
+        initData = NULL;                                                    \
     }
 
 #define DUMP_BUFFER_AFTER_CREATE( memobj, flags, ptr, size )                \
@@ -2750,6 +3789,10 @@ inline bool CLIntercept::checkAubCaptureEnqueueLimits(
 #define SAVE_PROGRAM_HASH( program, hash )                                  \
     if( pIntercept->config().BuildLogging ||                                \
         pIntercept->config().KernelNameHashTracking ||                      \
+        pIntercept->config().ProgramBuildTiming ||                          \
+        pIntercept->config().RedundantWorkChecking ||                       \
+        pIntercept->config().InjectProgramHotReload ||                      \
+        pIntercept->config().LocalWorkSizeAutotuning ||                     \
         pIntercept->config().DumpProgramSource ||                           \
         pIntercept->config().DumpInputProgramBinaries ||                    \
         pIntercept->config().DumpProgramBinaries ||                         \
@@ -2766,6 +3809,10 @@ inline bool CLIntercept::checkAubCaptureEnqueueLimits(
 #define SAVE_PROGRAM_OPTIONS_HASH( program, options )                       \
     if( pIntercept->config().BuildLogging ||                                \
         pIntercept->config().KernelNameHashTracking ||                      \
+        pIntercept->config().ProgramBuildTiming ||                          \
+        pIntercept->config().RedundantWorkChecking ||                       \
+        pIntercept->config().InjectProgramHotReload ||                      \
+        pIntercept->config().LocalWorkSizeAutotuning ||                     \
         pIntercept->config().DumpProgramSource ||                           \
         pIntercept->config().DumpInputProgramBinaries ||                    \
         pIntercept->config().DumpProgramBinaries ||                         \
@@ -2803,6 +3850,10 @@ inline bool CLIntercept::checkAubCaptureEnqueueLimits(
     if( _program &&                                                         \
         ( pIntercept->config().BuildLogging ||                              \
           pIntercept->config().KernelNameHashTracking ||                    \
+          pIntercept->config().ProgramBuildTiming ||                        \
+          pIntercept->config().RedundantWorkChecking ||                     \
+          pIntercept->config().InjectProgramHotReload ||                    \
+          pIntercept->config().LocalWorkSizeAutotuning ||                   \
           pIntercept->config().InjectProgramSource ||                       \
           pIntercept->config().DumpProgramSourceScript ||                   \
           pIntercept->config().DumpProgramSource ||                         \
@@ -2825,6 +3876,10 @@ inline bool CLIntercept::checkAubCaptureEnqueueLimits(
 #define CREATE_COMBINED_PROGRAM_STRING( count, strings, lengths, singleString, hash ) \
     if( pIntercept->config().BuildLogging ||                                \
         pIntercept->config().KernelNameHashTracking ||                      \
+        pIntercept->config().ProgramBuildTiming ||                          \
+        pIntercept->config().RedundantWorkChecking ||                       \
+        pIntercept->config().InjectProgramHotReload ||                      \
+        pIntercept->config().LocalWorkSizeAutotuning ||                     \
         pIntercept->config().SimpleDumpProgramSource ||                     \
         pIntercept->config().DumpProgramSourceScript ||                     \
         pIntercept->config().DumpProgramSource ||                           \
@@ -2834,6 +3889,7 @@ inline bool CLIntercept::checkAubCaptureEnqueueLimits(
         pIntercept->config().DumpKernelISABinaries ||                       \
         pIntercept->config().InjectProgramSource ||                         \
         pIntercept->config().InjectProgramBinaries ||                       \
+        pIntercept->config().ProgramBinaryCache ||                          \
         pIntercept->config().PrependProgramSource ||                        \
         pIntercept->config().AutoCreateSPIRV ||                             \
         pIntercept->config().AubCaptureUniqueKernels ||                     \
@@ -2872,6 +3928,66 @@ inline bool CLIntercept::checkAubCaptureEnqueueLimits(
             singleString );                                                 \
     }
 
+#define INIT_PROGRAM_BINARY_CACHE( program, createdFromSource, singleString, hash ) \
+    if( program && createdFromSource &&                                     \
+        pIntercept->config().ProgramBinaryCache )                           \
+    {                                                                       \
+        pIntercept->initProgramBinaryCache(                                 \
+            program,                                                        \
+            injected ?                                                      \
+                pIntercept->computeHash(                                    \
+                    singleString,                                           \
+                    strlen( singleString ) ) :                              \
+                hash );                                                     \
+    }
+
+#define GET_BINARY_CACHE_PROGRAM( program )                                 \
+    ( pIntercept->config().ProgramBinaryCache ?                             \
+        pIntercept->getBinaryCacheProgram( program ) :                      \
+        program )
+
+#define GET_BINARY_CACHE_PROGRAMS( numPrograms, programs, cacheProgramVector ) \
+    if( programs && pIntercept->config().ProgramBinaryCache )               \
+    {                                                                       \
+        cacheProgramVector.resize( numPrograms );                           \
+        for( cl_uint p = 0; p < numPrograms; p++ )                          \
+        {                                                                   \
+            cacheProgramVector[p] =                                         \
+                pIntercept->getBinaryCacheProgram( programs[p] );           \
+        }                                                                   \
+        programs = cacheProgramVector.data();                               \
+    }
+
+#define REMOVE_BINARY_CACHE_PROGRAM( program )                              \
+    if( pIntercept->config().ProgramBinaryCache )                           \
+    {                                                                       \
+        pIntercept->removeBinaryCacheProgram( program );                    \
+    }
+
+#define CHECK_REMOVE_BINARY_CACHE_PROGRAM( program )                        \
+    if( pIntercept->config().ProgramBinaryCache )                           \
+    {                                                                       \
+        pIntercept->checkRemoveBinaryCacheProgram( program );               \
+    }
+
+#define ADD_BINARY_CACHE_KERNELS( program, kernels, numKernels )            \
+    if( kernels && pIntercept->config().ProgramBinaryCache )                \
+    {                                                                       \
+        pIntercept->addBinaryCacheKernels( program, kernels, numKernels );  \
+    }
+
+#define ADD_BINARY_CACHE_KERNEL_CLONE( kernel, sourceKernel )               \
+    if( kernel && pIntercept->config().ProgramBinaryCache )                 \
+    {                                                                       \
+        pIntercept->addBinaryCacheKernelClone( kernel, sourceKernel );      \
+    }
+
+#define CHECK_REMOVE_BINARY_CACHE_KERNEL( kernel )                          \
+    if( pIntercept->config().ProgramBinaryCache )                           \
+    {                                                                       \
+        pIntercept->checkRemoveBinaryCacheKernel( kernel );                 \
+    }
+
 #define DUMP_PROGRAM_SOURCE( program, singleString, hash )                  \
     if( pIntercept->config().DumpProgramSource ||                           \
         pIntercept->config().AutoCreateSPIRV )                              \
@@ -2906,7 +4022,12 @@ inline bool CLIntercept::checkAubCaptureEnqueueLimits(
 // program binaries so we have a hash when we dump program options, also.
 #define COMPUTE_BINARY_HASH( _num, _lengths, _binaries, _hash )             \
     if( _lengths && _binaries &&                                            \
-        ( pIntercept->config().DumpProgramSource ||                         \
+        ( pIntercept->config().ProgramBuildTiming ||                        \
+          pIntercept->config().RedundantWorkChecking ||                     \
+          pIntercept->config().InjectProgramHotReload ||                    \
+          pIntercept->config().LocalWorkSizeAutotuning ||                   \
+          !pIntercept->config().CaptureReplayProgramHash.empty() ||         \
+          pIntercept->config().DumpProgramSource ||                         \
           pIntercept->config().DumpInputProgramBinaries ||                  \
           pIntercept->config().DumpProgramBinaries ||                       \
           pIntercept->config().DumpProgramSPIRV ) )                         \
@@ -2932,7 +4053,13 @@ inline bool CLIntercept::checkAubCaptureEnqueueLimits(
 // Called from clCreateProgramWithIL:
 
 #define COMPUTE_SPIRV_HASH( _length, _il, _hash )                           \
-    if( _length && _il && pIntercept->config().DumpProgramSPIRV )           \
+    if( _length && _il &&                                                   \
+        ( pIntercept->config().ProgramBuildTiming ||                        \
+          pIntercept->config().RedundantWorkChecking ||                     \
+          pIntercept->config().InjectProgramHotReload ||                    \
+          pIntercept->config().LocalWorkSizeAutotuning ||                   \
+          !pIntercept->config().CaptureReplayProgramHash.empty() ||         \
+          pIntercept->config().DumpProgramSPIRV ) )                         \
     {                                                                       \
         _hash = pIntercept->computeHash(                                    \
             _il,                                                            \
@@ -3015,6 +4142,17 @@ inline bool CLIntercept::checkAubCaptureEnqueueLimits(
             _newOptions );                                                  \
     }
 
+#define UPDATE_PROGRAM_BINARY_CACHE( program, numDevices, deviceList, options, retVal ) \
+    if( ( retVal == CL_SUCCESS ) &&                                         \
+        pIntercept->config().ProgramBinaryCache )                           \
+    {                                                                       \
+        pIntercept->updateProgramBinaryCache(                               \
+            program,                                                        \
+            numDevices,                                                     \
+            deviceList,                                                     \
+            options );                                                      \
+    }
+
 #define DUMP_OUTPUT_PROGRAM_BINARIES( program )                             \
     if( pIntercept->config().DumpProgramBinaries )                          \
     {                                                                       \
@@ -3033,29 +4171,6 @@ inline bool CLIntercept::checkAubCaptureEnqueueLimits(
         pIntercept->autoCreateSPIRV( _program, _options );                  \
     }
 
-///////////////////////////////////////////////////////////////////////////////
-//
-#define INIT_PRECOMPILED_KERNEL_OVERRIDES( context )                        \
-    if( ( context != NULL ) &&                                              \
-        ( pIntercept->config().OverrideReadBuffer ||                        \
-          pIntercept->config().OverrideWriteBuffer ||                       \
-          pIntercept->config().OverrideCopyBuffer ||                        \
-          pIntercept->config().OverrideReadImage ||                         \
-          pIntercept->config().OverrideWriteImage ||                        \
-          pIntercept->config().OverrideCopyImage ) )                        \
-    {                                                                       \
-        pIntercept->initPrecompiledKernelOverrides( context );              \
-    }
-
-///////////////////////////////////////////////////////////////////////////////
-//
-#define INIT_BUILTIN_KERNEL_OVERRIDES( context )                            \
-    if( ( context != NULL ) &&                                              \
-        pIntercept->config().OverrideBuiltinKernels )                       \
-    {                                                                       \
-        pIntercept->initBuiltinKernelOverrides( context );                  \
-    }
-
 ///////////////////////////////////////////////////////////////////////////////
 //
 #define GET_TIMING_TAGS_BLOCKING( _blocking, _sz )                          \
@@ -3243,6 +4358,119 @@ inline bool CLIntercept::checkHostPerformanceTimingEnqueueLimits(
         }                                                                   \
     }
 
+#define CHECK_REDUNDANT_PROGRAM_CREATE( _program )                          \
+    if( _program && pIntercept->config().RedundantWorkChecking )            \
+    {                                                                       \
+        pIntercept->checkRedundantProgramCreate(                            \
+            _program,                                                       \
+            cpuStart,                                                       \
+            cpuEnd );                                                       \
+    }
+
+#define CHECK_REDUNDANT_PROGRAM_BUILD( _program, _retVal )                  \
+    if( _program && ( _retVal == CL_SUCCESS ) &&                            \
+        pIntercept->config().RedundantWorkChecking )                        \
+    {                                                                       \
+        pIntercept->checkRedundantProgramBuild(                             \
+            _program,                                                       \
+            __FUNCTION__,                                                   \
+            cpuStart,                                                       \
+            cpuEnd );                                                       \
+    }
+
+#define CHECK_REDUNDANT_KERNEL_CREATE( _kernels, _numKernels )              \
+    if( _kernels && pIntercept->config().RedundantWorkChecking )            \
+    {                                                                       \
+        pIntercept->checkRedundantKernelCreate(                             \
+            _kernels,                                                       \
+            _numKernels,                                                    \
+            __FUNCTION__,                                                   \
+            cpuStart,                                                       \
+            cpuEnd );                                                       \
+    }
+
+#define CHECK_REDUNDANT_WORK_RELEASE( _obj )                                \
+    if( pIntercept->config().RedundantWorkChecking )                        \
+    {                                                                       \
+        pIntercept->checkRedundantWorkRelease(                              \
+            _obj,                                                           \
+            pIntercept->getRefCount( _obj ) );                              \
+    }
+
+#define ADD_HOT_RELOAD_PROGRAM( _program, _numDevices, _deviceList, _options, _retVal ) \
+    if( _program && ( _retVal == CL_SUCCESS ) &&                            \
+        pIntercept->config().InjectProgramHotReload )                       \
+    {                                                                       \
+        pIntercept->addHotReloadProgram(                                    \
+            _program,                                                       \
+            _numDevices,                                                    \
+            _deviceList,                                                    \
+            _options );                                                     \
+    }
+
+#define CHECK_REMOVE_HOT_RELOAD_PROGRAM( _program )                         \
+    if( pIntercept->config().InjectProgramHotReload )                       \
+    {                                                                       \
+        pIntercept->checkRemoveHotReloadProgram( _program );                \
+    }
+
+#define LWS_AUTOTUNING_INIT( _queue, _kernel, _workDim, _gws, _lws, pEvent )\
+    size_t      lwsTuningLocalWorkSize[3] = { 0, 0, 0 };                    \
+    std::string lwsTuningKey;                                               \
+    size_t      lwsTuningCandidate = 0;                                     \
+    cl_event    lwsTuningLocalEvent = NULL;                                 \
+    bool        isLWSTuningEnqueue = false;                                 \
+    bool        isLWSTuningLocalEvent = false;                              \
+    if( pIntercept->config().LocalWorkSizeAutotuning &&                     \
+        _gws != NULL &&                                                     \
+        _workDim >= 1 && _workDim <= 3 )                                    \
+    {                                                                       \
+        isLWSTuningEnqueue = pIntercept->autotuneLocalWorkSize(             \
+            _queue,                                                         \
+            _kernel,                                                        \
+            _workDim,                                                       \
+            _gws,                                                           \
+            _lws,                                                           \
+            lwsTuningLocalWorkSize,                                         \
+            lwsTuningKey,                                                   \
+            lwsTuningCandidate );                                           \
+        if( isLWSTuningEnqueue && pEvent == NULL )                          \
+        {                                                                   \
+            pEvent = &lwsTuningLocalEvent;                                  \
+            isLWSTuningLocalEvent = true;                                   \
+        }                                                                   \
+    }
+
+#define LWS_AUTOTUNING_END( _queue, _retVal, pEvent )                       \
+    if( isLWSTuningEnqueue )                                                \
+    {                                                                       \
+        pIntercept->addLWSTuningEvent(                                      \
+            _queue,                                                         \
+            lwsTuningKey,                                                   \
+            lwsTuningCandidate,                                             \
+            ( _retVal == CL_SUCCESS && pEvent ) ? pEvent[0] : NULL );       \
+        if( isLWSTuningLocalEvent )                                         \
+        {                                                                   \
+            if( _retVal == CL_SUCCESS )                                     \
+            {                                                               \
+                pIntercept->dispatch().clReleaseEvent( pEvent[0] );         \
+            }                                                               \
+            pEvent = NULL;                                                  \
+        }                                                                   \
+    }
+
+#define LWS_AUTOTUNING_REMOVE_QUEUE( _queue )                               \
+    if( pIntercept->config().LocalWorkSizeAutotuning )                      \
+    {                                                                       \
+        pIntercept->checkRemoveLWSTuningQueue( _queue );                    \
+    }
+
+#define LWS_AUTOTUNING_CHECK()                                              \
+    if( pIntercept->config().LocalWorkSizeAutotuning )                      \
+    {                                                                       \
+        pIntercept->checkLWSTuningEvents();                                 \
+    }
+
 #define TOOL_OVERHEAD_TIMING_START()                                        \
     CLIntercept::clock::time_point   toolStart, toolEnd;                    \
     if( pIntercept->config().ToolOverheadTiming &&                          \
@@ -3300,6 +4528,8 @@ inline bool CLIntercept::checkDevicePerformanceTimingEnqueueLimits(
 
 #define CREATE_COMMAND_QUEUE_OVERRIDE_INIT( _device, _props, _newprops )    \
     if( pIntercept->config().DevicePerformanceTiming ||                     \
+        pIntercept->config().LocalWorkSizeAutotuning ||                     \
+        pIntercept->config().CaptureReplayMinDeviceTimeUS ||                \
         pIntercept->config().ITTPerformanceTiming ||                        \
         pIntercept->config().ChromePerformanceTiming ||                     \
         pIntercept->config().DevicePerfCounterEventBasedSampling ||         \
@@ -3591,55 +4821,42 @@ inline void CLIntercept::flushChromeTraceBuffering()
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-inline std::string CLIntercept::getShortKernelName(
-    const cl_kernel kernel )
+inline CLIntercept::SKernelArgInfo& CLIntercept::getKernelArgInfo(
+    const cl_kernel kernel,
+    cl_uint arg_index )
 {
-    const std::string& realKernelName = m_KernelInfoMap[ kernel ].KernelName;
-
-    CLongKernelNameMap::const_iterator i = m_LongKernelNameMap.find( realKernelName );
-
-    const std::string& shortKernelName =
-        ( i != m_LongKernelNameMap.end() ) ?
-        i->second :
-        realKernelName;
-
-    CLI_ASSERT( shortKernelName.length() <= m_Config.LongKernelNameCutoff );
-
-    return shortKernelName;
+    CKernelArgInfoVector& args = m_KernelInfoMap[ kernel ].Args;
+    if( arg_index >= args.size() )
+    {
+        args.resize( arg_index + 1 );
+    }
+    return args[ arg_index ];
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-inline std::string CLIntercept::getShortKernelNameWithHash(
+inline const std::string& CLIntercept::getShortKernelName(
     const cl_kernel kernel )
 {
-    std::string name = getShortKernelName( kernel );
-
-    if( config().KernelNameHashTracking )
-    {
-        const SKernelInfo& kernelInfo = m_KernelInfoMap[ kernel ];
+    static const std::string    empty;
 
-        char    hashString[256] = "";
-        if( config().OmitProgramNumber )
-        {
-            CLI_SPRINTF( hashString, 256, "$%08X_%04u_%08X",
-                (unsigned int)kernelInfo.ProgramHash,
-                kernelInfo.CompileCount,
-                (unsigned int)kernelInfo.OptionsHash );
-        }
-        else
-        {
-            CLI_SPRINTF( hashString, 256, "$%04u_%08X_%04u_%08X",
-                kernelInfo.ProgramNumber,
-                (unsigned int)kernelInfo.ProgramHash,
-                kernelInfo.CompileCount,
-                (unsigned int)kernelInfo.OptionsHash );
-        }
+    const SKernelInfo& kernelInfo = m_KernelInfoMap[ kernel ];
+    return kernelInfo.ShortKernelName ?
+        *kernelInfo.ShortKernelName :
+        empty;
+}
 
-        name += hashString;
-    }
+///////////////////////////////////////////////////////////////////////////////
+//
+inline const std::string& CLIntercept::getShortKernelNameWithHash(
+    const cl_kernel kernel )
+{
+    static const std::string    empty;
 
-    return name;
+    const SKernelInfo& kernelInfo = m_KernelInfoMap[ kernel ];
+    return kernelInfo.ShortKernelNameWithHash ?
+        *kernelInfo.ShortKernelNameWithHash :
+        empty;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
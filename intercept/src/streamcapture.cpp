@@ -0,0 +1,607 @@
+/*
+// Copyright (c) 2025 Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+*/
+
+#include "streamcapture.h"
+
+void CStreamCapture::init(
+    const std::string& fileName )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    m_File.open(
+        fileName.c_str(),
+        std::ios::out | std::ios::binary );
+    if( m_File.good() )
+    {
+        SStreamCaptureFileHeader    header;
+        memcpy( header.Magic, sc_StreamCaptureMagic, sizeof(header.Magic) );
+        header.Version = sc_StreamCaptureVersion;
+        header.PointerSize = sizeof(void*);
+        m_File.write( (const char*)&header, sizeof(header) );
+
+        m_StartTime = std::chrono::steady_clock::now();
+        m_Enabled = true;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CStreamCapture::createContext(
+    cl_context context )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    CStreamCaptureWriter    writer;
+    writer.put32( addObject( context ) );
+    writeRecord( STREAM_RECORD_CREATE_CONTEXT, writer );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CStreamCapture::createCommandQueue(
+    cl_command_queue queue,
+    cl_context context,
+    cl_command_queue_properties properties )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    CStreamCaptureWriter    writer;
+    writer.put32( addObject( queue ) );
+    writer.put32( getID( context ) );
+    writer.put64( properties );
+    writeRecord( STREAM_RECORD_CREATE_COMMAND_QUEUE, writer );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CStreamCapture::createCommandQueueWithProperties(
+    cl_command_queue queue,
+    cl_context context,
+    const cl_queue_properties* properties )
+{
+    // Only the command queue properties bitfield is recorded.  Other
+    // properties, such as queue priority hints, are ignored.
+    cl_command_queue_properties queueProperties = 0;
+    if( properties )
+    {
+        for( size_t i = 0; properties[ i ] != 0; i += 2 )
+        {
+            if( properties[ i ] == CL_QUEUE_PROPERTIES )
+            {
+                queueProperties = (cl_command_queue_properties)properties[ i + 1 ];
+            }
+        }
+    }
+    createCommandQueue( queue, context, queueProperties );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CStreamCapture::createBuffer(
+    cl_mem mem,
+    cl_context context,
+    cl_mem_flags flags,
+    size_t size,
+    const void* host_ptr )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    const bool  hasData =
+        host_ptr != NULL &&
+        ( flags & ( CL_MEM_COPY_HOST_PTR | CL_MEM_USE_HOST_PTR ) );
+
+    CStreamCaptureWriter    writer;
+    writer.put32( addObject( mem, OBJECT_MEM ) );
+    writer.put32( getID( context ) );
+    writer.put64( flags & ~(cl_mem_flags)( CL_MEM_COPY_HOST_PTR | CL_MEM_USE_HOST_PTR ) );
+    writer.put64( size );
+    writer.putBlob( hasData ? host_ptr : NULL, size );
+    writeRecord( STREAM_RECORD_CREATE_BUFFER, writer );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CStreamCapture::createProgram(
+    EStreamCaptureRecord type,
+    cl_program program,
+    cl_context context,
+    const void* data,
+    size_t size )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    CStreamCaptureWriter    writer;
+    writer.put32( addObject( program ) );
+    writer.put32( getID( context ) );
+    writer.putBlob( data, size );
+    writeRecord( type, writer );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CStreamCapture::createProgramWithSource(
+    cl_program program,
+    cl_context context,
+    cl_uint count,
+    const char** strings,
+    const size_t* lengths )
+{
+    std::string source;
+    for( cl_uint i = 0; i < count; i++ )
+    {
+        if( lengths && lengths[ i ] )
+        {
+            source.append( strings[ i ], lengths[ i ] );
+        }
+        else
+        {
+            source.append( strings[ i ] );
+        }
+    }
+    createProgram(
+        STREAM_RECORD_CREATE_PROGRAM_WITH_SOURCE,
+        program,
+        context,
+        source.c_str(),
+        source.size() );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CStreamCapture::buildProgram(
+    cl_program program,
+    const char* options )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    CStreamCaptureWriter    writer;
+    writer.put32( getID( program ) );
+    writer.putBlob( options ? options : "", options ? strlen( options ) : 0 );
+    writeRecord( STREAM_RECORD_BUILD_PROGRAM, writer );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CStreamCapture::createKernel(
+    cl_kernel kernel,
+    cl_program program,
+    const char* kernel_name )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    CStreamCaptureWriter    writer;
+    writer.put32( addObject( kernel ) );
+    writer.put32( getID( program ) );
+    writer.putBlob( kernel_name, strlen( kernel_name ) );
+    writeRecord( STREAM_RECORD_CREATE_KERNEL, writer );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CStreamCapture::setKernelArg(
+    cl_kernel kernel,
+    cl_uint arg_index,
+    size_t arg_size,
+    const void* arg_value )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    CStreamCaptureWriter    writer;
+    writer.put32( getID( kernel ) );
+    writer.put32( arg_index );
+
+    // A pointer-sized argument is a memory object if it matches a buffer
+    // that was created during the capture.
+    const SObjectInfo*  memInfo = NULL;
+    if( arg_value && arg_size == sizeof(cl_mem) )
+    {
+        CObjectInfoMap::const_iterator iter =
+            m_ObjectInfoMap.find( ((const cl_mem*)arg_value)[0] );
+        if( iter != m_ObjectInfoMap.end() &&
+            iter->second.Type == OBJECT_MEM )
+        {
+            memInfo = &iter->second;
+        }
+    }
+
+    if( arg_value == NULL )
+    {
+        writer.put32( STREAM_ARG_LOCAL );
+        writer.put64( arg_size );
+    }
+    else if( memInfo )
+    {
+        writer.put32( STREAM_ARG_MEM_OBJECT );
+        writer.put64( arg_size );
+        writer.put32( memInfo->ID );
+    }
+    else
+    {
+        writer.put32( STREAM_ARG_VALUE );
+        writer.put64( arg_size );
+        writer.putBlob( arg_value, arg_size );
+    }
+    writeRecord( STREAM_RECORD_SET_KERNEL_ARG, writer );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CStreamCapture::enqueueNDRangeKernel(
+    cl_command_queue queue,
+    cl_kernel kernel,
+    cl_uint work_dim,
+    const size_t* global_work_offset,
+    const size_t* global_work_size,
+    const size_t* local_work_size,
+    cl_uint num_events_in_wait_list,
+    const cl_event* event_wait_list,
+    const cl_event* event )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    CStreamCaptureWriter    writer;
+    writer.put32( getID( queue ) );
+    writer.put32( getID( kernel ) );
+    writer.put32( work_dim );
+    writer.put32( local_work_size != NULL );
+    for( cl_uint i = 0; i < work_dim; i++ )
+    {
+        writer.put64( global_work_offset ? global_work_offset[ i ] : 0 );
+    }
+    for( cl_uint i = 0; i < work_dim; i++ )
+    {
+        writer.put64( global_work_size ? global_work_size[ i ] : 0 );
+    }
+    for( cl_uint i = 0; i < work_dim; i++ )
+    {
+        writer.put64( local_work_size ? local_work_size[ i ] : 0 );
+    }
+    putWaitList( writer, num_events_in_wait_list, event_wait_list );
+    putEvent( writer, event );
+    writeRecord( STREAM_RECORD_ENQUEUE_NDRANGE_KERNEL, writer );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CStreamCapture::enqueueWriteBuffer(
+    cl_command_queue queue,
+    cl_mem mem,
+    cl_bool blocking,
+    size_t offset,
+    size_t size,
+    const void* ptr,
+    cl_uint num_events_in_wait_list,
+    const cl_event* event_wait_list,
+    const cl_event* event )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    CStreamCaptureWriter    writer;
+    writer.put32( getID( queue ) );
+    writer.put32( getID( mem ) );
+    writer.put32( blocking );
+    writer.put64( offset );
+    writer.putBlob( ptr, size );
+    putWaitList( writer, num_events_in_wait_list, event_wait_list );
+    putEvent( writer, event );
+    writeRecord( STREAM_RECORD_ENQUEUE_WRITE_BUFFER, writer );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CStreamCapture::enqueueReadBuffer(
+    cl_command_queue queue,
+    cl_mem mem,
+    cl_bool blocking,
+    size_t offset,
+    size_t size,
+    cl_uint num_events_in_wait_list,
+    const cl_event* event_wait_list,
+    const cl_event* event )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    CStreamCaptureWriter    writer;
+    writer.put32( getID( queue ) );
+    writer.put32( getID( mem ) );
+    writer.put32( blocking );
+    writer.put64( offset );
+    writer.put64( size );
+    putWaitList( writer, num_events_in_wait_list, event_wait_list );
+    putEvent( writer, event );
+    writeRecord( STREAM_RECORD_ENQUEUE_READ_BUFFER, writer );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CStreamCapture::enqueueCopyBuffer(
+    cl_command_queue queue,
+    cl_mem src,
+    cl_mem dst,
+    size_t src_offset,
+    size_t dst_offset,
+    size_t size,
+    cl_uint num_events_in_wait_list,
+    const cl_event* event_wait_list,
+    const cl_event* event )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    CStreamCaptureWriter    writer;
+    writer.put32( getID( queue ) );
+    writer.put32( getID( src ) );
+    writer.put32( getID( dst ) );
+    writer.put64( src_offset );
+    writer.put64( dst_offset );
+    writer.put64( size );
+    putWaitList( writer, num_events_in_wait_list, event_wait_list );
+    putEvent( writer, event );
+    writeRecord( STREAM_RECORD_ENQUEUE_COPY_BUFFER, writer );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CStreamCapture::enqueueFillBuffer(
+    cl_command_queue queue,
+    cl_mem mem,
+    const void* pattern,
+    size_t pattern_size,
+    size_t offset,
+    size_t size,
+    cl_uint num_events_in_wait_list,
+    const cl_event* event_wait_list,
+    const cl_event* event )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    CStreamCaptureWriter    writer;
+    writer.put32( getID( queue ) );
+    writer.put32( getID( mem ) );
+    writer.putBlob( pattern, pattern_size );
+    writer.put64( offset );
+    writer.put64( size );
+    putWaitList( writer, num_events_in_wait_list, event_wait_list );
+    putEvent( writer, event );
+    writeRecord( STREAM_RECORD_ENQUEUE_FILL_BUFFER, writer );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CStreamCapture::enqueueMapBuffer(
+    cl_command_queue queue,
+    cl_mem mem,
+    cl_bool blocking,
+    cl_map_flags map_flags,
+    size_t offset,
+    size_t size,
+    const void* ptr,
+    cl_uint num_events_in_wait_list,
+    const cl_event* event_wait_list,
+    const cl_event* event )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    SMapInfo&   mapInfo = m_MapInfoMap[ std::make_pair( (const void*)mem, ptr ) ];
+    mapInfo.ID = m_NextID++;
+    mapInfo.Size = size;
+    mapInfo.Flags = map_flags;
+
+    CStreamCaptureWriter    writer;
+    writer.put32( getID( queue ) );
+    writer.put32( getID( mem ) );
+    writer.put32( blocking );
+    writer.put64( map_flags );
+    writer.put64( offset );
+    writer.put64( size );
+    writer.put32( mapInfo.ID );
+    putWaitList( writer, num_events_in_wait_list, event_wait_list );
+    putEvent( writer, event );
+    writeRecord( STREAM_RECORD_ENQUEUE_MAP_BUFFER, writer );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CStreamCapture::getUnmapData(
+    cl_mem mem,
+    const void* ptr,
+    std::vector<char>& data )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    CMapInfoMap::const_iterator iter =
+        m_MapInfoMap.find( std::make_pair( (const void*)mem, ptr ) );
+    if( iter != m_MapInfoMap.end() &&
+        ( iter->second.Flags & ( CL_MAP_WRITE | CL_MAP_WRITE_INVALIDATE_REGION ) ) )
+    {
+        const char* p = (const char*)ptr;
+        data.assign( p, p + iter->second.Size );
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CStreamCapture::enqueueUnmapMemObject(
+    cl_command_queue queue,
+    cl_mem mem,
+    const void* ptr,
+    const std::vector<char>& data,
+    cl_uint num_events_in_wait_list,
+    const cl_event* event_wait_list,
+    const cl_event* event )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    CMapInfoMap::iterator iter =
+        m_MapInfoMap.find( std::make_pair( (const void*)mem, ptr ) );
+    if( iter == m_MapInfoMap.end() )
+    {
+        // This is an image mapping, or a buffer that was mapped before the
+        // capture started.  There's nothing to replay.
+        return;
+    }
+
+    CStreamCaptureWriter    writer;
+    writer.put32( getID( queue ) );
+    writer.put32( getID( mem ) );
+    writer.put32( iter->second.ID );
+    writer.putBlob( data.data(), data.size() );
+    putWaitList( writer, num_events_in_wait_list, event_wait_list );
+    putEvent( writer, event );
+    writeRecord( STREAM_RECORD_ENQUEUE_UNMAP_MEM_OBJECT, writer );
+
+    m_MapInfoMap.erase( iter );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CStreamCapture::enqueueMarkerOrBarrier(
+    EStreamCaptureRecord type,
+    cl_command_queue queue,
+    cl_uint num_events_in_wait_list,
+    const cl_event* event_wait_list,
+    const cl_event* event )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    CStreamCaptureWriter    writer;
+    writer.put32( getID( queue ) );
+    putWaitList( writer, num_events_in_wait_list, event_wait_list );
+    putEvent( writer, event );
+    writeRecord( type, writer );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CStreamCapture::queueOperation(
+    EStreamCaptureRecord type,
+    cl_command_queue queue )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    CStreamCaptureWriter    writer;
+    writer.put32( getID( queue ) );
+    writeRecord( type, writer );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CStreamCapture::waitForEvents(
+    cl_uint num_events,
+    const cl_event* event_list )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    CStreamCaptureWriter    writer;
+    putWaitList( writer, num_events, event_list );
+    writeRecord( STREAM_RECORD_WAIT_FOR_EVENTS, writer );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CStreamCapture::retainOrRelease(
+    EStreamCaptureRecord type,
+    const void* object )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    uint32_t    id = getID( object );
+    if( id != 0 )
+    {
+        CStreamCaptureWriter    writer;
+        writer.put32( id );
+        writeRecord( type, writer );
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+uint32_t CStreamCapture::addObject(
+    const void* object,
+    EObjectType type )
+{
+    // We're already in a critical section when we get here, so we don't need
+    // to grab the critical section again.
+
+    // If the object handle was used before, it was for an object that has
+    // since been destroyed, so it is safe to replace its ID.
+    SObjectInfo&    info = m_ObjectInfoMap[ object ];
+    info.ID = m_NextID++;
+    info.Type = type;
+    return info.ID;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+uint32_t CStreamCapture::getID(
+    const void* object ) const
+{
+    // We're already in a critical section when we get here, so we don't need
+    // to grab the critical section again.
+
+    CObjectInfoMap::const_iterator iter = m_ObjectInfoMap.find( object );
+    return iter != m_ObjectInfoMap.end() ? iter->second.ID : 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CStreamCapture::putWaitList(
+    CStreamCaptureWriter& writer,
+    cl_uint num_events_in_wait_list,
+    const cl_event* event_wait_list ) const
+{
+    // We're already in a critical section when we get here, so we don't need
+    // to grab the critical section again.
+
+    // Events that were not created during the capture, such as user events,
+    // cannot be replayed and are dropped from the wait list.
+    std::vector<uint32_t>   ids;
+    for( cl_uint i = 0; event_wait_list && i < num_events_in_wait_list; i++ )
+    {
+        uint32_t    id = getID( event_wait_list[ i ] );
+        if( id != 0 )
+        {
+            ids.push_back( id );
+        }
+    }
+
+    writer.put32( (uint32_t)ids.size() );
+    for( size_t i = 0; i < ids.size(); i++ )
+    {
+        writer.put32( ids[ i ] );
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CStreamCapture::putEvent(
+    CStreamCaptureWriter& writer,
+    const cl_event* event )
+{
+    // We're already in a critical section when we get here, so we don't need
+    // to grab the critical section again.
+
+    writer.put32( ( event && event[0] ) ? addObject( event[0] ) : 0 );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+void CStreamCapture::writeRecord(
+    EStreamCaptureRecord type,
+    const CStreamCaptureWriter& writer )
+{
+    // We're already in a critical section when we get here, so we don't need
+    // to grab the critical section again.
+
+    SStreamCaptureRecordHeader  header;
+    header.Type = type;
+    header.Reserved = 0;
+    header.Size = writer.data().size();
+    header.TimeNS = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - m_StartTime ).count();
+
+    m_File.write( (const char*)&header, sizeof(header) );
+    m_File.write( writer.data().data(), writer.data().size() );
+}
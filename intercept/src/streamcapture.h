@@ -0,0 +1,237 @@
+/*
+// Copyright (c) 2025 Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+*/
+#pragma once
+
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <stdint.h>
+
+#include "common.h"
+#include "streamformat.h"
+
+// CStreamCapture records the OpenCL call stream into a compact binary file
+// that can be replayed by clireplay.  Object handles are remapped to IDs,
+// and buffer contents are recorded when buffers are created from host memory
+// and whenever the host writes to a buffer, either explicitly or via a map.
+//
+// Only calls that succeeded are recorded, and they are recorded after they
+// return, so the record timestamps are the times the calls completed.  This
+// class has its own lock and may be called with or without the intercept
+// mutex held.
+
+class CStreamCapture
+{
+public:
+    CStreamCapture() :
+        m_Enabled(false),
+        m_NextID(1) {}
+    CStreamCapture( const CStreamCapture& ) = delete;
+    CStreamCapture& operator=( const CStreamCapture& ) = delete;
+
+    void    init(
+                const std::string& fileName );
+
+    bool    enabled() const
+    {
+        return m_Enabled;
+    }
+
+    void    flush()
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_File.flush();
+    }
+
+    void    createContext(
+                cl_context context );
+    void    createCommandQueue(
+                cl_command_queue queue,
+                cl_context context,
+                cl_command_queue_properties properties );
+    void    createCommandQueueWithProperties(
+                cl_command_queue queue,
+                cl_context context,
+                const cl_queue_properties* properties );
+    void    createBuffer(
+                cl_mem mem,
+                cl_context context,
+                cl_mem_flags flags,
+                size_t size,
+                const void* host_ptr );
+    void    createProgram(
+                EStreamCaptureRecord type,
+                cl_program program,
+                cl_context context,
+                const void* data,
+                size_t size );
+    void    createProgramWithSource(
+                cl_program program,
+                cl_context context,
+                cl_uint count,
+                const char** strings,
+                const size_t* lengths );
+    void    buildProgram(
+                cl_program program,
+                const char* options );
+    void    createKernel(
+                cl_kernel kernel,
+                cl_program program,
+                const char* kernel_name );
+    void    setKernelArg(
+                cl_kernel kernel,
+                cl_uint arg_index,
+                size_t arg_size,
+                const void* arg_value );
+
+    void    enqueueNDRangeKernel(
+                cl_command_queue queue,
+                cl_kernel kernel,
+                cl_uint work_dim,
+                const size_t* global_work_offset,
+                const size_t* global_work_size,
+                const size_t* local_work_size,
+                cl_uint num_events_in_wait_list,
+                const cl_event* event_wait_list,
+                const cl_event* event );
+    void    enqueueWriteBuffer(
+                cl_command_queue queue,
+                cl_mem mem,
+                cl_bool blocking,
+                size_t offset,
+                size_t size,
+                const void* ptr,
+                cl_uint num_events_in_wait_list,
+                const cl_event* event_wait_list,
+                const cl_event* event );
+    void    enqueueReadBuffer(
+                cl_command_queue queue,
+                cl_mem mem,
+                cl_bool blocking,
+                size_t offset,
+                size_t size,
+                cl_uint num_events_in_wait_list,
+                const cl_event* event_wait_list,
+                const cl_event* event );
+    void    enqueueCopyBuffer(
+                cl_command_queue queue,
+                cl_mem src,
+                cl_mem dst,
+                size_t src_offset,
+                size_t dst_offset,
+                size_t size,
+                cl_uint num_events_in_wait_list,
+                const cl_event* event_wait_list,
+                const cl_event* event );
+    void    enqueueFillBuffer(
+                cl_command_queue queue,
+                cl_mem mem,
+                const void* pattern,
+                size_t pattern_size,
+                size_t offset,
+                size_t size,
+                cl_uint num_events_in_wait_list,
+                const cl_event* event_wait_list,
+                const cl_event* event );
+    void    enqueueMapBuffer(
+                cl_command_queue queue,
+                cl_mem mem,
+                cl_bool blocking,
+                cl_map_flags map_flags,
+                size_t offset,
+                size_t size,
+                const void* ptr,
+                cl_uint num_events_in_wait_list,
+                const cl_event* event_wait_list,
+                const cl_event* event );
+
+    // Copies the data the host may have written to a mapping.  This must be
+    // called before the mapping is unmapped.
+    void    getUnmapData(
+                cl_mem mem,
+                const void* ptr,
+                std::vector<char>& data );
+    void    enqueueUnmapMemObject(
+                cl_command_queue queue,
+                cl_mem mem,
+                const void* ptr,
+                const std::vector<char>& data,
+                cl_uint num_events_in_wait_list,
+                const cl_event* event_wait_list,
+                const cl_event* event );
+
+    void    enqueueMarkerOrBarrier(
+                EStreamCaptureRecord type,
+                cl_command_queue queue,
+                cl_uint num_events_in_wait_list,
+                const cl_event* event_wait_list,
+                const cl_event* event );
+    void    queueOperation(
+                EStreamCaptureRecord type,
+                cl_command_queue queue );
+    void    waitForEvents(
+                cl_uint num_events,
+                const cl_event* event_list );
+    void    retainOrRelease(
+                EStreamCaptureRecord type,
+                const void* object );
+
+private:
+    enum EObjectType
+    {
+        OBJECT_OTHER,
+        OBJECT_MEM,
+    };
+
+    struct SObjectInfo
+    {
+        uint32_t    ID;
+        EObjectType Type;
+    };
+
+    struct SMapInfo
+    {
+        uint32_t        ID;
+        size_t          Size;
+        cl_map_flags    Flags;
+    };
+
+    typedef std::map<const void*, SObjectInfo>  CObjectInfoMap;
+    typedef std::map<std::pair<const void*, const void*>, SMapInfo> CMapInfoMap;
+
+    std::mutex      m_Mutex;
+    std::ofstream   m_File;
+    bool            m_Enabled;
+
+    std::chrono::steady_clock::time_point   m_StartTime;
+
+    uint32_t        m_NextID;
+    CObjectInfoMap  m_ObjectInfoMap;
+    CMapInfoMap     m_MapInfoMap;
+
+    uint32_t    addObject(
+                    const void* object,
+                    EObjectType type = OBJECT_OTHER );
+    uint32_t    getID(
+                    const void* object ) const;
+
+    void        putWaitList(
+                    CStreamCaptureWriter& writer,
+                    cl_uint num_events_in_wait_list,
+                    const cl_event* event_wait_list ) const;
+    void        putEvent(
+                    CStreamCaptureWriter& writer,
+                    const cl_event* event );
+
+    void        writeRecord(
+                    EStreamCaptureRecord type,
+                    const CStreamCaptureWriter& writer );
+};
@@ -0,0 +1,179 @@
+/*
+// Copyright (c) 2025 Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+*/
+#pragma once
+
+#include <vector>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// This file describes the stream capture file format.  It is shared by the
+// stream capture recorder in the Intercept Layer for OpenCL Applications and
+// by the stream replayer in clireplay, so it must not depend on anything
+// else in the intercept layer.
+//
+// A stream capture file starts with an SStreamCaptureFileHeader and is
+// followed by a sequence of records.  Each record starts with an
+// SStreamCaptureRecordHeader and is followed by Size bytes of payload.
+// Payloads are a sequence of 32-bit and 64-bit values and blobs, written in
+// host byte order, so a stream capture must be replayed on a host with the
+// same byte order.  A blob is a 64-bit size followed by that many bytes.
+//
+// OpenCL objects are referenced by 32-bit IDs that are assigned by the
+// recorder when the objects are created.  An ID of zero means NULL, or an
+// object that was not created while the stream was being captured.  An
+// event wait list is a 32-bit count followed by that many event IDs.
+
+static const char       sc_StreamCaptureMagic[8] = { 'C', 'L', 'I', 'S', 'T', 'R', 'M', '\0' };
+static const uint32_t   sc_StreamCaptureVersion = 1;
+
+enum EStreamCaptureRecord
+{
+    STREAM_RECORD_CREATE_CONTEXT = 1,       // context
+    STREAM_RECORD_CREATE_COMMAND_QUEUE,     // queue, context, u64 properties
+    STREAM_RECORD_CREATE_BUFFER,            // mem, context, u64 flags, u64 size, blob initial contents
+    STREAM_RECORD_CREATE_PROGRAM_WITH_SOURCE,   // program, context, blob source
+    STREAM_RECORD_CREATE_PROGRAM_WITH_IL,   // program, context, blob IL
+    STREAM_RECORD_CREATE_PROGRAM_WITH_BINARY,   // program, context, blob binary
+    STREAM_RECORD_BUILD_PROGRAM,            // program, blob options
+    STREAM_RECORD_CREATE_KERNEL,            // kernel, program, blob kernel name
+    STREAM_RECORD_SET_KERNEL_ARG,           // kernel, u32 index, u32 EStreamCaptureArgKind, u64 size, blob value or mem
+    STREAM_RECORD_ENQUEUE_NDRANGE_KERNEL,   // queue, kernel, u32 work dim, u32 has lws, u64 gwo[dim], u64 gws[dim], u64 lws[dim], wait list, event
+    STREAM_RECORD_ENQUEUE_WRITE_BUFFER,     // queue, mem, u32 blocking, u64 offset, blob data, wait list, event
+    STREAM_RECORD_ENQUEUE_READ_BUFFER,      // queue, mem, u32 blocking, u64 offset, u64 size, wait list, event
+    STREAM_RECORD_ENQUEUE_COPY_BUFFER,      // queue, src mem, dst mem, u64 src offset, u64 dst offset, u64 size, wait list, event
+    STREAM_RECORD_ENQUEUE_FILL_BUFFER,      // queue, mem, blob pattern, u64 offset, u64 size, wait list, event
+    STREAM_RECORD_ENQUEUE_MAP_BUFFER,       // queue, mem, u32 blocking, u64 map flags, u64 offset, u64 size, u32 map, wait list, event
+    STREAM_RECORD_ENQUEUE_UNMAP_MEM_OBJECT, // queue, mem, u32 map, blob data written by the host, wait list, event
+    STREAM_RECORD_ENQUEUE_MARKER,           // queue, wait list, event
+    STREAM_RECORD_ENQUEUE_BARRIER,          // queue, wait list, event
+    STREAM_RECORD_FLUSH,                    // queue
+    STREAM_RECORD_FINISH,                   // queue
+    STREAM_RECORD_WAIT_FOR_EVENTS,          // wait list
+    STREAM_RECORD_RETAIN,                   // object
+    STREAM_RECORD_RELEASE,                  // object
+
+    STREAM_RECORD_MAX,
+};
+
+enum EStreamCaptureArgKind
+{
+    STREAM_ARG_VALUE,
+    STREAM_ARG_LOCAL,
+    STREAM_ARG_MEM_OBJECT,
+};
+
+struct SStreamCaptureFileHeader
+{
+    char        Magic[8];
+    uint32_t    Version;
+    uint32_t    PointerSize;
+};
+
+struct SStreamCaptureRecordHeader
+{
+    uint32_t    Type;
+    uint32_t    Reserved;
+    uint64_t    Size;
+    uint64_t    TimeNS;     // Time since the start of the capture.
+};
+
+class CStreamCaptureWriter
+{
+public:
+    void    put32( uint32_t value )
+    {
+        put( &value, sizeof(value) );
+    }
+    void    put64( uint64_t value )
+    {
+        put( &value, sizeof(value) );
+    }
+    void    putBlob( const void* data, size_t size )
+    {
+        put64( data ? size : 0 );
+        if( data )
+        {
+            put( data, size );
+        }
+    }
+
+    const std::vector<char>&    data() const
+    {
+        return m_Data;
+    }
+
+private:
+    std::vector<char>   m_Data;
+
+    void    put( const void* data, size_t size )
+    {
+        if( size == 0 )
+        {
+            return;
+        }
+        size_t  offset = m_Data.size();
+        m_Data.resize( offset + size );
+        memcpy( m_Data.data() + offset, data, size );
+    }
+};
+
+class CStreamCaptureReader
+{
+public:
+    CStreamCaptureReader( const char* data, size_t size ) :
+        m_Ptr(data),
+        m_End(data + size),
+        m_Error(false) {}
+
+    uint32_t    get32()
+    {
+        uint32_t    value = 0;
+        get( &value, sizeof(value) );
+        return value;
+    }
+    uint64_t    get64()
+    {
+        uint64_t    value = 0;
+        get( &value, sizeof(value) );
+        return value;
+    }
+    const char* getBlob( size_t& size )
+    {
+        size = (size_t)get64();
+        if( m_Error || size > (size_t)( m_End - m_Ptr ) )
+        {
+            m_Error = true;
+            size = 0;
+            return NULL;
+        }
+        const char* data = m_Ptr;
+        m_Ptr += size;
+        return data;
+    }
+
+    bool    ok() const
+    {
+        return !m_Error;
+    }
+
+private:
+    const char* m_Ptr;
+    const char* m_End;
+    bool        m_Error;
+
+    void    get( void* data, size_t size )
+    {
+        if( m_Error || size > (size_t)( m_End - m_Ptr ) )
+        {
+            m_Error = true;
+            return;
+        }
+        memcpy( data, m_Ptr, size );
+        m_Ptr += size;
+    }
+};
@@ -0,0 +1,265 @@
+/*
+// Copyright (c) 2025 Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+*/
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include <stddef.h>
+
+// CThreadPool is a small fixed-size pool of worker threads used to move
+// expensive host-side work, such as filling or hashing large allocations,
+// off of the application thread that made the OpenCL call.
+//
+// The worker threads are created lazily the first time the pool is started,
+// so there is no cost unless a feature that uses the pool is enabled.
+
+class CThreadPool
+{
+public:
+    CThreadPool() :
+        m_State(std::make_shared<SState>()) {}
+
+    ~CThreadPool()
+    {
+        stop();
+    }
+
+    // Starts the worker threads, if they have not been started already.  If
+    // numThreads is zero, one worker is created per hardware thread.
+    void    start(
+                unsigned int numThreads = 0 )
+    {
+        std::lock_guard<std::mutex> lock(m_State->Mutex);
+
+        if( !m_Threads.empty() )
+        {
+            return;
+        }
+
+        if( numThreads == 0 )
+        {
+            numThreads = std::thread::hardware_concurrency();
+        }
+        if( numThreads == 0 )
+        {
+            numThreads = 1;
+        }
+
+        m_State->Stop = false;
+        for( unsigned int i = 0; i < numThreads; i++ )
+        {
+            m_Threads.push_back( std::thread( &CThreadPool::worker, m_State ) );
+        }
+    }
+
+    // Finishes any queued tasks and joins the worker threads.
+    void    stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_State->Mutex);
+            m_State->Stop = true;
+        }
+        m_State->Condition.notify_all();
+
+        for( size_t i = 0; i < m_Threads.size(); i++ )
+        {
+            m_Threads[i].join();
+        }
+        m_Threads.clear();
+    }
+
+    // Drops any queued tasks that have not started yet and returns the number
+    // of tasks that were dropped.  Tasks that are already running are not
+    // affected.
+    size_t  cancel()
+    {
+        std::lock_guard<std::mutex> lock(m_State->Mutex);
+        size_t  dropped = m_State->Tasks.size();
+        m_State->Tasks = std::queue<std::function<void()>>();
+        return dropped;
+    }
+
+    // Drops any queued tasks, waits for any tasks that are already running
+    // to finish, asks the worker threads to exit, and detaches them without
+    // waiting for them to exit.  This is used when the process is
+    // terminating and joining threads is not safe, such as from DllMain.
+    // Tasks may use objects that are about to be destroyed, so they must
+    // finish before this returns, but the worker threads only use the pool
+    // state after that, which they share, so they may safely outlive the
+    // pool.  Returns the number of queued tasks that were dropped.
+    size_t  detach()
+    {
+        size_t  dropped = 0;
+        {
+            std::unique_lock<std::mutex> lock(m_State->Mutex);
+            dropped = m_State->Tasks.size();
+            m_State->Tasks = std::queue<std::function<void()>>();
+            m_State->Stop = true;
+            m_State->Condition.notify_all();
+            m_State->IdleCondition.wait( lock, [this]() {
+                return m_State->NumRunning == 0; } );
+        }
+
+        for( size_t i = 0; i < m_Threads.size(); i++ )
+        {
+            m_Threads[i].detach();
+        }
+        m_Threads.clear();
+
+        return dropped;
+    }
+
+    size_t  size() const
+    {
+        std::lock_guard<std::mutex> lock(m_State->Mutex);
+        return m_Threads.size();
+    }
+
+    // Queues a task to run asynchronously on a worker thread.  If the pool
+    // has not been started the task runs immediately on the calling thread.
+    void    enqueue(
+                const std::function<void()>& task )
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_State->Mutex);
+            if( !m_Threads.empty() && !m_State->Stop )
+            {
+                m_State->Tasks.push( task );
+                m_State->Condition.notify_one();
+                return;
+            }
+        }
+        task();
+    }
+
+    // Calls func for each index in [0, count) and waits for all calls to
+    // complete.  The calling thread participates, so this makes progress
+    // even if all of the worker threads are busy.
+    void    parallelFor(
+                size_t count,
+                const std::function<void(size_t)>& func )
+    {
+        if( count == 0 )
+        {
+            return;
+        }
+
+        std::shared_ptr<SParallelForState> state =
+            std::make_shared<SParallelForState>( count, func );
+
+        size_t  numHelpers = std::min( size(), count - 1 );
+        for( size_t i = 0; i < numHelpers; i++ )
+        {
+            enqueue( [state]() { state->run(); } );
+        }
+
+        state->run();
+
+        std::unique_lock<std::mutex> lock(state->Mutex);
+        state->Condition.wait( lock, [&state]() {
+            return state->Completed == state->Count; } );
+    }
+
+private:
+    struct SParallelForState
+    {
+        SParallelForState(
+            size_t count,
+            const std::function<void(size_t)>& func ) :
+            Count(count),
+            Func(func),
+            Next(0),
+            Completed(0) {}
+
+        void    run()
+        {
+            size_t  completed = 0;
+            size_t  index = Next++;
+            while( index < Count )
+            {
+                Func( index );
+                completed++;
+                index = Next++;
+            }
+
+            if( completed )
+            {
+                std::lock_guard<std::mutex> lock(Mutex);
+                Completed += completed;
+                if( Completed == Count )
+                {
+                    Condition.notify_all();
+                }
+            }
+        }
+
+        const size_t    Count;
+        const std::function<void(size_t)>   Func;
+
+        std::atomic<size_t> Next;
+
+        std::mutex  Mutex;
+        std::condition_variable Condition;
+        size_t      Completed;
+    };
+
+    // The state shared with the worker threads.
+    struct SState
+    {
+        SState() :
+            Stop(false),
+            NumRunning(0) {}
+
+        std::mutex  Mutex;
+        std::condition_variable Condition;
+        std::condition_variable IdleCondition;
+
+        std::queue<std::function<void()>>   Tasks;
+        bool    Stop;
+        size_t  NumRunning;
+    };
+
+    std::shared_ptr<SState>     m_State;
+    std::vector<std::thread>    m_Threads;
+
+    static void worker(
+                    std::shared_ptr<SState> state )
+    {
+        while( true )
+        {
+            std::function<void()>   task;
+            {
+                std::unique_lock<std::mutex> lock(state->Mutex);
+                state->Condition.wait( lock, [&state]() {
+                    return state->Stop || !state->Tasks.empty(); } );
+                if( state->Tasks.empty() )
+                {
+                    return;
+                }
+                task = std::move( state->Tasks.front() );
+                state->Tasks.pop();
+                state->NumRunning++;
+            }
+            task();
+            {
+                std::lock_guard<std::mutex> lock(state->Mutex);
+                state->NumRunning--;
+                if( state->NumRunning == 0 )
+                {
+                    state->IdleCondition.notify_all();
+                }
+            }
+        }
+    }
+};
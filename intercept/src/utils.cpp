@@ -55,4 +55,22 @@ std::string GetUniqueFileName(const std::string& fileName)
     return newFileName;
 }
 
+bool CopyFileContents(const std::string& srcFileName, const std::string& dstFileName)
+{
+    std::ifstream is(srcFileName.c_str(), std::ios::in | std::ios::binary);
+    if (!is.good())
+    {
+        return false;
+    }
+
+    std::ofstream os(dstFileName.c_str(), std::ios::out | std::ios::binary);
+    if (!os.good())
+    {
+        return false;
+    }
+
+    os << is.rdbuf();
+    return os.good();
+}
+
 }
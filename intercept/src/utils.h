@@ -12,5 +12,6 @@ namespace Utils
 {
 
 std::string GetUniqueFileName(const std::string& fileName);
+bool CopyFileContents(const std::string& srcFileName, const std::string& dstFileName);
 
 }
@@ -0,0 +1,213 @@
+#
+# Copyright (c) 2025 Intel Corporation
+#
+# SPDX-License-Identifier: MIT
+#
+
+# Turns kernels captured with the CaptureReplay controls into a performance
+# regression suite.  The "create" command replays every Replay/Enqueue_*
+# capture with clireplay and writes a suite manifest with each kernel's name,
+# work sizes, and baseline median execution time.  The "run" command replays
+# the suite again, for example with a different driver, and flags kernels
+# whose median execution time regressed by more than a threshold.
+
+import os
+import sys
+import json
+import argparse
+import subprocess
+import tempfile
+
+def find_captures(paths):
+    captures = []
+    for path in paths:
+        path = os.path.abspath(path)
+        if os.path.isfile(os.path.join(path, 'kernelName.txt')):
+            captures.append(path)
+        else:
+            for root, dirs, files in os.walk(path):
+                dirs.sort()
+                if 'kernelName.txt' in files and os.path.basename(root).startswith('Enqueue_'):
+                    captures.append(root)
+    return captures
+
+def run_clireplay(args, directory):
+    fd, json_file = tempfile.mkstemp(suffix='.json')
+    os.close(fd)
+    command = [args.clireplay,
+               '-p', str(args.platform),
+               '-d', str(args.device),
+               '-r', str(args.repetitions),
+               '-w', str(args.warmup),
+               '--json', json_file]
+    if args.opencl:
+        command += ['--opencl', args.opencl]
+    command.append(directory)
+    try:
+        proc = subprocess.run(command, stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+                              universal_newlines=True)
+        if args.verbose:
+            print(proc.stdout)
+        with open(json_file) as file:
+            result = json.load(file)
+    except (OSError, ValueError) as e:
+        print(f"Failed to replay {directory}: {e}")
+        result = None
+    finally:
+        os.remove(json_file)
+    if result is not None and result.get('result', 1) != 0:
+        print(f"Failed to replay {directory}: clireplay returned {result.get('result')}.")
+        result = None
+    elif result is not None and 'median_us' not in result:
+        print(f"Failed to replay {directory}.")
+        result = None
+    return result
+
+def create(args):
+    suite_dir = os.path.dirname(os.path.abspath(args.suite))
+    captures = find_captures(args.captures)
+    if not captures:
+        print('No captured kernels found!')
+        return 1
+
+    kernels = []
+    baseline = None
+    for directory in captures:
+        result = run_clireplay(args, directory)
+        if result is None:
+            continue
+        baseline = result
+        print(f"{result['kernel']}: median {result['median_us']:.3f} us ({os.path.basename(directory)})")
+        kernels.append({
+            'name': os.path.basename(directory),
+            'directory': os.path.relpath(directory, suite_dir),
+            'kernel': result['kernel'],
+            'gws': result['gws'],
+            'lws': result['lws'],
+            'gwo': result['gwo'],
+            'baseline_median_us': result['median_us'],
+        })
+
+    if not kernels:
+        print('No captured kernels could be replayed!')
+        return 1
+
+    suite = {
+        'version': 1,
+        'baseline': {
+            'platform': baseline['platform'],
+            'device': baseline['device'],
+            'driver_version': baseline['driver_version'],
+            'repetitions': args.repetitions,
+            'warmup': args.warmup,
+        },
+        'kernels': kernels,
+    }
+    with open(args.suite, 'w') as file:
+        json.dump(suite, file, indent=2)
+    print(f"Wrote {len(kernels)} kernels to suite: {args.suite}")
+    return 0
+
+def run(args):
+    suite_dir = os.path.dirname(os.path.abspath(args.suite))
+    with open(args.suite) as file:
+        suite = json.load(file)
+
+    # Use the baseline settings unless they were explicitly overridden.
+    if args.repetitions is None:
+        args.repetitions = suite['baseline']['repetitions']
+    if args.warmup is None:
+        args.warmup = suite['baseline']['warmup']
+
+    results = []
+    device = None
+    regressions = 0
+    failures = 0
+    print(f"{'Kernel':>40} {'Baseline (us)':>14} {'Median (us)':>14} {'Change':>9}")
+    for kernel in suite['kernels']:
+        directory = os.path.join(suite_dir, kernel['directory'])
+        result = run_clireplay(args, directory)
+        entry = {
+            'name': kernel['name'],
+            'kernel': kernel['kernel'],
+            'baseline_median_us': kernel['baseline_median_us'],
+        }
+        if result is None:
+            failures += 1
+            entry['status'] = 'failed'
+            print(f"{kernel['name']:>40} {kernel['baseline_median_us']:>14.3f} {'failed':>14}")
+        else:
+            baseline = kernel['baseline_median_us']
+            change = ( result['median_us'] - baseline ) / baseline * 100.0 if baseline > 0 else 0.0
+            regressed = change > args.threshold
+            regressions += regressed
+            entry['median_us'] = result['median_us']
+            entry['change_percent'] = round(change, 2)
+            entry['status'] = 'regressed' if regressed else 'ok'
+            print(f"{kernel['name']:>40} {baseline:>14.3f} {result['median_us']:>14.3f} {change:>+8.1f}%"
+                  f"{'  REGRESSED' if regressed else ''}")
+            device = result
+        results.append(entry)
+
+    print()
+    print(f"{len(results)} kernels, {regressions} regressed by more than {args.threshold}%, {failures} failed.")
+
+    if args.json:
+        report = {
+            'suite': os.path.abspath(args.suite),
+            'threshold_percent': args.threshold,
+            'baseline': suite['baseline'],
+            'regressions': regressions,
+            'failures': failures,
+            'kernels': results,
+        }
+        if device is not None:
+            report['platform'] = device['platform']
+            report['device'] = device['device']
+            report['driver_version'] = device['driver_version']
+        with open(args.json, 'w') as file:
+            json.dump(report, file, indent=2)
+
+    return 1 if regressions or failures else 0
+
+parser = argparse.ArgumentParser(description='Create and run a performance regression suite from captured kernels.')
+parser.add_argument('-c', '--clireplay', dest='clireplay', default='clireplay',
+                    help='Location of clireplay, default: clireplay from the system path')
+parser.add_argument('-p', '--platform', type=int, dest='platform', default=0,
+                    help='The index of the platform to replay on')
+parser.add_argument('-d', '--device', type=int, dest='device', default=0,
+                    help='The index of the device to replay on')
+parser.add_argument('--opencl', dest='opencl', default=None,
+                    help='The OpenCL library for clireplay to load')
+parser.add_argument('-v', '--verbose', action='store_true', dest='verbose', default=False,
+                    help='Print the clireplay output')
+subparsers = parser.add_subparsers(dest='command')
+
+create_parser = subparsers.add_parser('create', help='Replay captured kernels and write a suite with baseline timings')
+create_parser.add_argument('suite', help='The suite manifest to write')
+create_parser.add_argument('captures', nargs='+',
+                           help='Replay/Enqueue_* capture directories, or directories containing them')
+create_parser.add_argument('-r', '--repetitions', type=int, dest='repetitions', default=100,
+                           help='Number of timed kernel executions')
+create_parser.add_argument('-w', '--warmup', type=int, dest='warmup', default=5,
+                           help='Number of untimed warmup executions')
+
+run_parser = subparsers.add_parser('run', help='Replay a suite and compare against the baseline timings')
+run_parser.add_argument('suite', help='The suite manifest to run')
+run_parser.add_argument('-t', '--threshold', type=float, dest='threshold', default=5.0,
+                        help='Flag kernels whose median time increased by more than this percentage')
+run_parser.add_argument('-j', '--json', dest='json', default=None,
+                        help='Write the results to this JSON file')
+run_parser.add_argument('-r', '--repetitions', type=int, dest='repetitions', default=None,
+                        help='Number of timed kernel executions, default: from the suite')
+run_parser.add_argument('-w', '--warmup', type=int, dest='warmup', default=None,
+                        help='Number of untimed warmup executions, default: from the suite')
+
+args = parser.parse_args()
+if args.command == 'create':
+    sys.exit(create(args))
+elif args.command == 'run':
+    sys.exit(run(args))
+else:
+    parser.print_help(sys.stderr)
+    sys.exit(1)